@@ -10,16 +10,28 @@
 //
 //-----------------------------------------------------------------------------
 
+#include <IlmThread.h>
+#include <IlmThreadPool.h>
+#include <IlmThreadSemaphore.h>
 #include <ImfAcesFile.h>
 #include <ImfArray.h>
 #include <ImfRgbaFile.h>
 #include <ImfMisc.h>
+#include <ImfThreading.h>
 #include <OpenEXRConfig.h>
+#include <algorithm>
+#include <atomic>
 #include <exception>
+#include <filesystem>
 #include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
 #include <stdlib.h>
 #include <string.h>
 #include <string>
+#include <vector>
 
 #include <OpenEXRConfig.h>
 using namespace OPENEXR_IMF_NAMESPACE;
@@ -32,7 +44,9 @@ namespace
 void
 usageMessage (ostream& stream, const char* program_name, bool verbose = false)
 {
-    stream << "Usage: " << program_name << " [options] infile outfile" << endl;
+    stream << "Usage: " << program_name << " [options] infile outfile" << endl
+           << "       " << program_name << " [options] -d dir infile ..."
+           << endl;
 
     if (verbose)
         stream
@@ -40,6 +54,10 @@ usageMessage (ostream& stream, const char* program_name, bool verbose = false)
                "Read an OpenEXR file from infile and save the contents\n"
                "in ACES image file outfile.\n"
                "\n"
+               "With option -d, convert any number of infiles, and save\n"
+               "the results in directory dir, under the names of the\n"
+               "infiles.  Several files are converted in parallel.\n"
+               "\n"
                "The ACES image file format is a subset of the OpenEXR file\n"
                "format.  ACES image files are restricted as follows:\n"
                "\n"
@@ -57,6 +75,10 @@ usageMessage (ostream& stream, const char* program_name, bool verbose = false)
                "    the ACES RGB primaries and white point.\n"
                "\n"
                "Options:\n"
+               "  -d dir            batch mode: saves the output files in\n"
+               "                    directory dir\n"
+               "  -j n              uses n threads (default depends on the\n"
+               "                    number of processors)\n"
                "  -v, --verbose     verbose mode\n"
                "  -h, --help        print this message\n"
                "      --version     print version information\n"
@@ -65,33 +87,207 @@ usageMessage (ostream& stream, const char* program_name, bool verbose = false)
                "";
 }
 
+//
+// The image is converted in bands of scan lines, so that memory use
+// depends on the width of the image, not on its height.  Each band
+// covers a whole number of the input file's and the output file's
+// line buffers, and enough of them to keep all threads busy.
+//
+
+struct Band
+{
+    int y1;
+    int y2;
+};
+
+vector<Band>
+computeBands (const Box2i& dw, LineOrder lineOrder, int linesPerBand)
+{
+    vector<Band> bands;
+
+    for (int64_t y = dw.min.y; y <= dw.max.y; y += linesPerBand)
+    {
+        Band band;
+        band.y1 = int (y);
+        band.y2 = int (min<int64_t> (y + linesPerBand - 1, dw.max.y));
+        bands.push_back (band);
+    }
+
+    //
+    // The bands are written in the order of the scan lines
+    // in the output file.
+    //
+
+    if (lineOrder == DECREASING_Y) reverse (bands.begin (), bands.end ());
+
+    return bands;
+}
+
 void
-exr2aces (const char inFileName[], const char outFileName[], bool verbose)
+readBand (AcesInputFile& in, Rgba* buffer, const Box2i& dw, const Band& band)
 {
-    Array2D<Rgba> p;
-    Header        h;
-    RgbaChannels  ch;
-    Box2i         dw;
-    int           width;
-    int           height;
+    int64_t width = int64_t (dw.max.x) - int64_t (dw.min.x) + 1;
+
+    in.setFrameBuffer (
+        ComputeBasePointer (buffer, V2i (dw.min.x, band.y1), width), 1, width);
 
+    in.readPixels (band.y1, band.y2);
+}
+
+void
+writeBand (AcesOutputFile& out, Rgba* buffer, const Box2i& dw, const Band& band)
+{
+    int64_t width = int64_t (dw.max.x) - int64_t (dw.min.x) + 1;
+
+    out.setFrameBuffer (
+        ComputeBasePointer (buffer, V2i (dw.min.x, band.y1), width), 1, width);
+
+    out.writePixels (band.y2 - band.y1 + 1);
+}
+
+#if ILMTHREAD_THREADING_ENABLED
+
+//
+// A BandReader reads and converts bands ahead of the writer, into
+// a ring of buffers, so that decoding the input file overlaps with
+// encoding the output file.  It runs in a thread of its own rather
+// than in the thread pool, because reading a band waits for tasks
+// that run in the pool.
+//
+// For luminance/chroma input files, RgbaInputFile reconstructs RGB
+// one scan line at a time; that step runs serially in the reader
+// thread.  It overlaps with writing, but is not itself split among
+// the pool's threads.
+//
+
+class BandReader : public ILMTHREAD_NAMESPACE::Thread
+{
+public:
+    BandReader (
+        AcesInputFile&       in,
+        const Box2i&         dw,
+        const vector<Band>&  bands,
+        vector<Array<Rgba>>& buffers)
+        : _in (in)
+        , _dw (dw)
+        , _bands (bands)
+        , _buffers (buffers)
+        , _free (buffers.size ())
+        , _full (0)
+        , _stop (false)
+    {
+        start ();
+    }
+
+    ~BandReader ()
+    {
+        _stop = true;
+        _free.post ();
+        join ();
+    }
+
+    void run () override
     {
-        if (verbose) cout << "Reading file " << inFileName << endl;
+        for (size_t i = 0; i < _bands.size (); ++i)
+        {
+            _free.wait ();
+
+            if (_stop) return;
+
+            try
+            {
+                readBand (_in, buffer (i), _dw, _bands[i]);
+            }
+            catch (...)
+            {
+                _error = current_exception ();
+                _full.post ();
+                return;
+            }
+
+            _full.post ();
+        }
+    }
 
-        AcesInputFile in (inFileName);
+    //
+    // Wait until band i has been read, and return its buffer.  The
+    // buffer must be handed back with release() once it has been
+    // written.
+    //
 
-        h  = in.header ();
-        ch = in.channels ();
-        dw = h.dataWindow ();
+    Rgba* wait (size_t i)
+    {
+        _full.wait ();
 
-        width  = dw.max.x - dw.min.x + 1;
-        height = dw.max.y - dw.min.y + 1;
-        p.resizeErase (height, width);
+        if (_error) rethrow_exception (_error);
 
-        in.setFrameBuffer (ComputeBasePointer (&p[0][0], dw), 1, width);
-        in.readPixels (dw.min.y, dw.max.y);
+        return buffer (i);
     }
 
+    void release () { _free.post (); }
+
+private:
+    Rgba* buffer (size_t i) { return _buffers[i % _buffers.size ()]; }
+
+    AcesInputFile&                  _in;
+    const Box2i&                    _dw;
+    const vector<Band>&             _bands;
+    vector<Array<Rgba>>&            _buffers;
+    ILMTHREAD_NAMESPACE::Semaphore  _free;
+    ILMTHREAD_NAMESPACE::Semaphore  _full;
+    std::atomic<bool>               _stop;
+    exception_ptr                   _error;
+};
+
+#endif
+
+//
+// Check whether two names refer to the same existing file, even if
+// the names differ, for example "x.exr" and "./x.exr", or a link.
+//
+
+bool
+sameFile (const char fileName1[], const char fileName2[])
+{
+    std::error_code ec;
+
+    return std::filesystem::equivalent (
+        std::filesystem::path (fileName1),
+        std::filesystem::path (fileName2),
+        ec);
+}
+
+void
+exr2aces (
+    const char inFileName[],
+    const char outFileName[],
+    int        numThreads,
+    bool       verbose)
+{
+    //
+    // The output file is created while the input file is still being
+    // read, so writing over the input file would destroy it.
+    //
+
+    if (!strcmp (inFileName, outFileName) || sameFile (inFileName, outFileName))
+        throw invalid_argument ("Input and output cannot be the same file");
+
+    if (verbose)
+        cout << "Converting file " << inFileName << " to " << outFileName
+             << endl;
+
+    AcesInputFile in (inFileName, numThreads);
+
+    Header       h  = in.header ();
+    RgbaChannels ch = in.channels ();
+    Box2i        dw = h.dataWindow ();
+
+    //
+    // ACES image files are always scan line files.
+    //
+
+    h.erase ("tiles");
+
     switch (h.compression ())
     {
         case NO_COMPRESSION: break;
@@ -102,14 +298,179 @@ exr2aces (const char inFileName[], const char outFileName[], bool verbose)
         default: h.compression () = PIZ_COMPRESSION;
     }
 
+    int linesPerBuffer = max (
+        getCompressionNumScanlines (in.header ().compression ()),
+        getCompressionNumScanlines (h.compression ()));
+
+    int linesPerBand = linesPerBuffer * max (2 * numThreads, 4);
+
+    vector<Band> bands = computeBands (dw, h.lineOrder (), linesPerBand);
+
+    int64_t width = int64_t (dw.max.x) - int64_t (dw.min.x) + 1;
+    int64_t lines = min<int64_t> (
+        linesPerBand, int64_t (dw.max.y) - int64_t (dw.min.y) + 1);
+
+    AcesOutputFile out (outFileName, h, ch, numThreads);
+
+#if ILMTHREAD_THREADING_ENABLED
+    if (numThreads > 0)
+    {
+        //
+        // Double buffering: one band is read while the other is written.
+        //
+
+        vector<Array<Rgba>> buffers (2);
+        for (auto& buffer: buffers)
+            buffer.resizeErase (width * lines);
+
+        BandReader reader (in, dw, bands, buffers);
+
+        for (size_t i = 0; i < bands.size (); ++i)
+        {
+            writeBand (out, reader.wait (i), dw, bands[i]);
+            reader.release ();
+        }
+
+        return;
+    }
+#endif
+
+    Array<Rgba> buffer (width * lines);
+
+    for (const Band& band: bands)
+    {
+        readBand (in, buffer, dw, band);
+        writeBand (out, buffer, dw, band);
+    }
+}
+
+string
+outputFileName (const string& inFileName, const string& outDir)
+{
+    size_t slash = inFileName.find_last_of ("/\\");
+
+    string base = (slash == string::npos) ? inFileName
+                                          : inFileName.substr (slash + 1);
+
+    return outDir + "/" + base;
+}
+
+//
+// The files of a batch, and the progress made converting them.
+//
+
+struct Batch
+{
+    const vector<string>& inFileNames;
+    const string&         outDir;
+    bool                  verbose;
+    std::atomic<size_t>   nextFile;
+    std::atomic<int>      numFailed;
+    std::mutex            outputMutex;
+};
+
+//
+// Convert files, taken from the batch's list, until the list is
+// exhausted.  The files are read and written without threads of
+// their own; the parallelism comes from converting several files
+// at once.
+//
+
+void
+convertFiles (Batch& batch)
+{
+    for (size_t i = batch.nextFile++; i < batch.inFileNames.size ();
+         i        = batch.nextFile++)
+    {
+        const string& inFileName  = batch.inFileNames[i];
+        string        outFileName = outputFileName (inFileName, batch.outDir);
+
+        try
+        {
+            exr2aces (inFileName.c_str (), outFileName.c_str (), 0, false);
+
+            if (batch.verbose)
+            {
+                std::lock_guard<std::mutex> lock (batch.outputMutex);
+                cout << inFileName << " -> " << outFileName << endl;
+            }
+        }
+        catch (const exception& e)
+        {
+            ++batch.numFailed;
+
+            std::lock_guard<std::mutex> lock (batch.outputMutex);
+            cerr << inFileName << ": " << e.what () << endl;
+        }
+    }
+}
+
+#if ILMTHREAD_THREADING_ENABLED
+
+//
+// The files are converted in threads of their own rather than in
+// tasks in the thread pool: writing a file waits for line buffer
+// tasks in the pool, which could never run if the converters took
+// up all of the pool's threads.
+//
+
+class ConvertThread : public ILMTHREAD_NAMESPACE::Thread
+{
+public:
+    ConvertThread (Batch& batch) : _batch (batch) { start (); }
+    ~ConvertThread () { join (); }
+
+    void run () override { convertFiles (_batch); }
+
+private:
+    Batch& _batch;
+};
+
+#endif
+
+int
+exr2acesBatch (
+    const vector<string>& inFileNames, const string& outDir, bool verbose)
+{
+    //
+    // Files with the same name in different directories would be
+    // saved under the same name in outDir, by concurrent threads.
+    //
+
+    map<string, string> outFileNames;
+
+    for (const string& inFileName: inFileNames)
+    {
+        string outFileName = outputFileName (inFileName, outDir);
+        auto   i           = outFileNames.insert (
+            make_pair (outFileName, inFileName));
+
+        if (!i.second)
+            throw invalid_argument (
+                "Input files " + i.first->second + " and " + inFileName +
+                " would both be saved as " + outFileName);
+    }
+
+    Batch batch{inFileNames, outDir, verbose, {0}, {0}, {}};
+
+#if ILMTHREAD_THREADING_ENABLED
+    size_t numThreads =
+        min (inFileNames.size (), size_t (globalThreadCount ()));
+
+    if (numThreads > 1)
     {
-        if (verbose) cout << "Writing file " << outFileName << endl;
+        vector<unique_ptr<ConvertThread>> threads;
 
-        AcesOutputFile out (outFileName, h, ch);
+        for (size_t t = 0; t < numThreads; ++t)
+            threads.emplace_back (new ConvertThread (batch));
 
-        out.setFrameBuffer (ComputeBasePointer (&p[0][0], dw), 1, width);
-        out.writePixels (height);
+        threads.clear ();
+        return batch.numFailed;
     }
+#endif
+
+    convertFiles (batch);
+    return batch.numFailed;
 }
 
 } // namespace
@@ -119,8 +480,14 @@ main (int argc, char** argv)
 {
     const char* inFile  = 0;
     const char* outFile = 0;
+    const char* outDir  = 0;
     bool        verbose = false;
 
+    vector<string> inFiles;
+
+    int threads =
+        ILMTHREAD_NAMESPACE::ThreadPool::estimateThreadCountForFileIO ();
+
     //
     // Parse the command line.
     //
@@ -131,69 +498,120 @@ main (int argc, char** argv)
         return -1;
     }
 
-    int i = 1;
-
-    while (i < argc)
+    try
     {
-        if (!strcmp (argv[i], "-v"))
-        {
-            //
-            // Verbose mode
-            //
+        int i = 1;
 
-            verbose = true;
-            i += 1;
-        }
-        else if (!strcmp (argv[i], "-h") || !strcmp (argv[i], "--help"))
+        while (i < argc)
         {
-            //
-            // Print help message
-            //
-
-            usageMessage (cout, "exr2aces", true);
-            return 0;
+            if (!strcmp (argv[i], "-v") || !strcmp (argv[i], "--verbose"))
+            {
+                //
+                // Verbose mode
+                //
+
+                verbose = true;
+                i += 1;
+            }
+            else if (!strcmp (argv[i], "-d"))
+            {
+                //
+                // Batch mode
+                //
+
+                if (i > argc - 2)
+                    throw invalid_argument (
+                        "Missing directory for -d argument");
+
+                outDir = argv[i + 1];
+                i += 2;
+            }
+            else if (!strcmp (argv[i], "-j"))
+            {
+                //
+                // Set number of threads
+                //
+
+                if (i > argc - 2)
+                    throw invalid_argument (
+                        "Missing thread count for -j argument");
+
+                threads = strtol (argv[i + 1], 0, 0);
+
+                if (threads < 0)
+                    throw invalid_argument (
+                        "Thread count must not be negative");
+
+                i += 2;
+            }
+            else if (!strcmp (argv[i], "-h") || !strcmp (argv[i], "--help"))
+            {
+                //
+                // Print help message
+                //
+
+                usageMessage (cout, "exr2aces", true);
+                return 0;
+            }
+            else if (!strcmp (argv[i], "--version"))
+            {
+                const char* libraryVersion = getLibraryVersion ();
+
+                cout << "exr2aces (OpenEXR) " << OPENEXR_VERSION_STRING;
+                if (strcmp (libraryVersion, OPENEXR_VERSION_STRING))
+                    cout << "(OpenEXR version " << libraryVersion << ")";
+                cout << " https://openexr.com" << endl;
+                cout << "Copyright (c) Contributors to the OpenEXR Project"
+                     << endl;
+                cout << "License BSD-3-Clause" << endl;
+
+                return 0;
+            }
+            else
+            {
+                //
+                // Image file name
+                //
+
+                inFiles.push_back (argv[i]);
+                i += 1;
+            }
         }
-        else if (!strcmp (argv[i], "--version"))
-        {
-            const char* libraryVersion = getLibraryVersion ();
 
-            cout << "exr2aces (OpenEXR) " << OPENEXR_VERSION_STRING;
-            if (strcmp (libraryVersion, OPENEXR_VERSION_STRING))
-                cout << "(OpenEXR version " << libraryVersion << ")";
-            cout << " https://openexr.com" << endl;
-            cout << "Copyright (c) Contributors to the OpenEXR Project" << endl;
-            cout << "License BSD-3-Clause" << endl;
+        setGlobalThreadCount (threads);
 
-            return 0;
-        }
-        else
+        if (outDir)
         {
             //
-            // Image file name
+            // Convert all infiles, and save the results in outDir.
             //
 
-            if (inFile == 0)
-                inFile = argv[i];
-            else
-                outFile = argv[i];
+            if (inFiles.empty ())
+            {
+                usageMessage (cerr, argv[0], false);
+                return -1;
+            }
 
-            i += 1;
+            return exr2acesBatch (inFiles, outDir, verbose) ? 1 : 0;
         }
-    }
 
-    if (inFile == 0 || outFile == 0)
-    {
-        usageMessage (cerr, argv[0], false);
-        return -1;
-    }
+        if (inFiles.size () == 2)
+        {
+            inFile  = inFiles[0].c_str ();
+            outFile = inFiles[1].c_str ();
+        }
 
-    //
-    // Load inFile, and save a tiled version in outFile.
-    //
+        if (inFile == 0 || outFile == 0)
+        {
+            usageMessage (cerr, argv[0], false);
+            return -1;
+        }
 
-    try
-    {
-        exr2aces (inFile, outFile, verbose);
+        //
+        // Convert inFile, and save the result in outFile.
+        //
+
+        exr2aces (inFile, outFile, globalThreadCount (), verbose);
     }
     catch (const exception& e)
     {
@@ -2,14 +2,18 @@
 // Copyright (c) Contributors to the OpenEXR Project.
 
 #include <ImathConfig.h>
+#include <IlmThreadPool.h>
 #include <ImfCheckFile.h>
 #include <ImfMisc.h>
+#include <ImfThreading.h>
 #include <OpenEXRConfig.h>
 
 #include <cstdint>
 #include <fstream>
 #include <iostream>
+#include <mutex>
 #include <ostream>
+#include <stdlib.h>
 #include <string.h>
 #if defined _WIN32 || defined _WIN64
 #    include <io.h>
@@ -37,6 +41,14 @@ usageMessage (ostream& stream, const char* program_name, bool verbose = false)
                "  -t            avoid spending excessive time (some files will not be fully checked)\n"
                "  -s            use stream API instead of file API\n"
                "  -c            add core library checks\n"
+               "  -p            check the chunks of each file in parallel with\n"
+               "                the core library, and report the first bad chunk;\n"
+               "                multiple files are checked concurrently\n"
+               "  -q            like -p, but only check the structure of the\n"
+               "                files: the headers, the chunk offset tables and\n"
+               "                the chunk headers, without decompressing the\n"
+               "                pixels\n"
+               "  -j n          use n threads (default: number of cores)\n"
                "  -h, --help    print this message\n"
                "      --version print version information\n"
                "\n"
@@ -98,6 +110,154 @@ exrCheck (
     }
 }
 
+//
+// the outcome of checking one file with checkOpenEXRFileChunks()
+//
+
+struct ChunkCheckResult
+{
+    bool              done = false;
+    bool              bad  = false;
+    ChunkCheckFailure failure;
+};
+
+void
+printResult (ostream& out, const string& fileName, const ChunkCheckResult& r)
+{
+    out << " file " << fileName << ' ';
+
+    if (!r.bad)
+    {
+        out << "OK\n";
+        return;
+    }
+
+    out << "bad\n";
+    out << "    ";
+
+    if (r.failure.part >= 0) out << "part " << r.failure.part << ", ";
+
+    if (r.failure.chunk >= 0)
+        out << "chunk " << r.failure.chunk << " at offset "
+            << r.failure.offset << ": ";
+
+    out << r.failure.message << "\n";
+}
+
+//
+// Results are printed in the order in which the files were given on
+// the command line, as soon as the results of all preceding files
+// are known.
+//
+
+class ResultPrinter
+{
+public:
+    ResultPrinter (const vector<string>& fileNames)
+        : _fileNames (fileNames), _results (fileNames.size ()), _next (0)
+    {}
+
+    void set (size_t i, const ChunkCheckResult& r)
+    {
+        lock_guard<mutex> lock (_mutex);
+
+        _results[i]      = r;
+        _results[i].done = true;
+
+        for (; _next < _results.size () && _results[_next].done; ++_next)
+            printResult (cout, _fileNames[_next], _results[_next]);
+
+        cout.flush ();
+    }
+
+    bool anyBad () const
+    {
+        for (const ChunkCheckResult& r: _results)
+            if (r.bad) return true;
+
+        return false;
+    }
+
+private:
+    const vector<string>&    _fileNames;
+    vector<ChunkCheckResult> _results;
+    size_t                   _next;
+    mutex                    _mutex;
+};
+
+class ChunkCheckTask : public ILMTHREAD_NAMESPACE::Task
+{
+public:
+    ChunkCheckTask (
+        ILMTHREAD_NAMESPACE::TaskGroup* group,
+        const string&         fileName,
+        size_t                index,
+        bool                  structureOnly,
+        ResultPrinter&        printer)
+        : Task (group)
+        , _fileName (fileName)
+        , _index (index)
+        , _structureOnly (structureOnly)
+        , _printer (printer)
+    {}
+
+    void execute () override
+    {
+        ChunkCheckResult r;
+
+        r.bad = checkOpenEXRFileChunks (
+            _fileName.c_str (),
+            _structureOnly,
+            globalThreadCount (),
+            &r.failure);
+
+        _printer.set (_index, r);
+    }
+
+private:
+    const string&  _fileName;
+    size_t         _index;
+    bool           _structureOnly;
+    ResultPrinter& _printer;
+};
+
+//
+// Check the chunks of a list of files.  A single file is checked
+// with its chunks spread over the thread pool; several files are
+// checked concurrently, each one by a single thread.
+//
+
+bool
+exrCheckChunks (const vector<string>& fileNames, bool structureOnly)
+{
+    ResultPrinter printer (fileNames);
+
+    if (fileNames.size () == 1)
+    {
+        ChunkCheckResult r;
+
+        r.bad = checkOpenEXRFileChunks (
+            fileNames[0].c_str (),
+            structureOnly,
+            globalThreadCount (),
+            &r.failure);
+
+        printer.set (0, r);
+    }
+    else
+    {
+        ILMTHREAD_NAMESPACE::TaskGroup group;
+
+        for (size_t i = 0; i < fileNames.size (); ++i)
+        {
+            ILMTHREAD_NAMESPACE::ThreadPool::addGlobalTask (new ChunkCheckTask (
+                &group, fileNames[i], i, structureOnly, printer));
+        }
+    }
+
+    return printer.anyBad ();
+}
+
 int
 main (int argc, char** argv)
 {
@@ -112,6 +272,12 @@ main (int argc, char** argv)
     bool enableCoreCheck = false;
     bool badFileFound    = false;
     bool useStream       = false;
+    bool checkChunks     = false;
+    bool structureOnly   = false;
+    int  threads         = -1;
+
+    vector<string> chunkCheckFiles;
+
     for (int i = 1; i < argc; ++i)
     {
         if (!strcmp (argv[i], "-h") || !strcmp (argv[i], "--help"))
@@ -132,6 +298,30 @@ main (int argc, char** argv)
         else if (!strcmp (argv[i], "-t")) { reduceTime = true; }
         else if (!strcmp (argv[i], "-s")) { useStream = true; }
         else if (!strcmp (argv[i], "-c")) { enableCoreCheck = true; }
+        else if (!strcmp (argv[i], "-p")) { checkChunks = true; }
+        else if (!strcmp (argv[i], "-q"))
+        {
+            checkChunks   = true;
+            structureOnly = true;
+        }
+        else if (!strcmp (argv[i], "-j"))
+        {
+            if (i > argc - 2)
+            {
+                usageMessage (cerr, argv[0], false);
+                return 1;
+            }
+
+            threads = strtol (argv[i + 1], 0, 0);
+
+            if (threads < 0)
+            {
+                cerr << "Number of threads cannot be negative." << endl;
+                return 1;
+            }
+
+            i += 1;
+        }
         else if (!strcmp (argv[i], "--version"))
         {
             const char* libraryVersion = getLibraryVersion ();
@@ -158,6 +348,18 @@ main (int argc, char** argv)
                 return -1;
             }
 
+            if (checkChunks)
+            {
+                //
+                // checked together, after all arguments are parsed
+                //
+
+                chunkCheckFiles.push_back (argv[i]);
+                continue;
+            }
+
+            if (threads >= 0) setGlobalThreadCount (threads);
+
             cout << " file " << argv[i] << ' ';
             cout.flush ();
 
@@ -172,5 +374,17 @@ main (int argc, char** argv)
         }
     }
 
+    if (!chunkCheckFiles.empty ())
+    {
+        if (threads < 0)
+            threads =
+                ILMTHREAD_NAMESPACE::ThreadPool::estimateThreadCountForFileIO ();
+
+        setGlobalThreadCount (threads);
+
+        if (exrCheckChunks (chunkCheckFiles, structureOnly))
+            badFileFound = true;
+    }
+
     return badFileFound;
 }
@@ -17,8 +17,10 @@
 #include <algorithm>
 #include <cstring>
 #include <iostream>
+#include <parallelRows.h>
 #include <resizeImage.h>
 #include <string.h>
+#include <vector>
 
 using namespace IMF;
 using namespace std;
@@ -296,14 +298,59 @@ blurImage (EnvmapImage& image1, bool verbose)
         Array2D<Rgba>& pixels1 = iptr1->pixels ();
         Array2D<Rgba>& pixels2 = iptr2->pixels ();
 
-        for (int f2 = CUBEFACE_POS_X; f2 <= CUBEFACE_NEG_Z; ++f2)
+        //
+        // Tabulate the directions and the colors of the input pixels
+        // once, so that the innermost loop below only has to compute
+        // a dot product for each input pixel.
+        //
+
+        size_t        n1 = size_t (6) * sof1 * sof1;
+        vector<V3f>   dirs1;
+        vector<float> r1, g1, b1, a1;
+
+        dirs1.reserve (n1);
+        r1.reserve (n1);
+        g1.reserve (n1);
+        b1.reserve (n1);
+        a1.reserve (n1);
+
+        for (int f1 = CUBEFACE_POS_X; f1 <= CUBEFACE_NEG_Z; ++f1)
         {
-            if (verbose) cout << "        face " << f2 << endl;
+            CubeMapFace face1 = CubeMapFace (f1);
+
+            for (int y1 = 0; y1 < sof1; ++y1)
+            {
+                for (int x1 = 0; x1 < sof1; ++x1)
+                {
+                    V2f posInFace1 (x1, y1);
+
+                    V2f pos1 = CubeMap::pixelPosition (face1, dw1, posInFace1);
 
-            CubeMapFace face2 = CubeMapFace (f2);
+                    const Rgba& pixel1 =
+                        pixels1[toInt (pos1.y)][toInt (pos1.x)];
 
-            for (int y2 = 0; y2 < sof2; ++y2)
+                    dirs1.push_back (
+                        CubeMap::direction (face1, dw1, posInFace1));
+                    r1.push_back (pixel1.r);
+                    g1.push_back (pixel1.g);
+                    b1.push_back (pixel1.b);
+                    a1.push_back (pixel1.a);
+                }
+            }
+        }
+
+        //
+        // The output pixels are independent of each other; the rows
+        // of all six faces are computed in parallel.  Row r of the
+        // output is row r % sof2 of face r / sof2.
+        //
+
+        parallelRows (6 * sof2, [&] (int row0, int row1) {
+            for (int row = row0; row < row1; ++row)
             {
+                CubeMapFace face2 = CubeMapFace (CUBEFACE_POS_X + row / sof2);
+                int         y2    = row % sof2;
+
                 for (int x2 = 0; x2 < sof2; ++x2)
                 {
                     V2f posInFace2 (x2, y2);
@@ -320,36 +367,17 @@ blurImage (EnvmapImage& image1, bool verbose)
 
                     Rgba& pixel2 = pixels2[toInt (pos2.y)][toInt (pos2.x)];
 
-                    for (int f1 = CUBEFACE_POS_X; f1 <= CUBEFACE_NEG_Z; ++f1)
+                    for (size_t i = 0; i < n1; ++i)
                     {
-                        CubeMapFace face1 = CubeMapFace (f1);
-
-                        for (int y1 = 0; y1 < sof1; ++y1)
-                        {
-                            for (int x1 = 0; x1 < sof1; ++x1)
-                            {
-                                V2f posInFace1 (x1, y1);
+                        double weight = dirs1[i] ^ dir2;
 
-                                V3f dir1 =
-                                    CubeMap::direction (face1, dw1, posInFace1);
+                        if (weight <= 0) continue;
 
-                                V2f pos1 = CubeMap::pixelPosition (
-                                    face1, dw1, posInFace1);
-
-                                double weight = dir1 ^ dir2;
-
-                                if (weight <= 0) continue;
-
-                                Rgba& pixel1 =
-                                    pixels1[toInt (pos1.y)][toInt (pos1.x)];
-
-                                weightTotal += weight;
-                                rTotal += pixel1.r * weight;
-                                gTotal += pixel1.g * weight;
-                                bTotal += pixel1.b * weight;
-                                aTotal += pixel1.a * weight;
-                            }
-                        }
+                        weightTotal += weight;
+                        rTotal += r1[i] * weight;
+                        gTotal += g1[i] * weight;
+                        bTotal += b1[i] * weight;
+                        aTotal += a1[i] * weight;
                     }
 
                     pixel2.r = rTotal / weightTotal;
@@ -358,7 +386,7 @@ blurImage (EnvmapImage& image1, bool verbose)
                     pixel2.a = aTotal / weightTotal;
                 }
             }
-        }
+        });
 
         swap (iptr1, iptr2);
     }
@@ -10,9 +10,11 @@
 //-----------------------------------------------------------------------------
 
 #include <EnvmapImage.h>
+#include <IlmThreadPool.h>
 #include <ImfEnvmap.h>
 #include <ImfHeader.h>
 #include <ImfMisc.h>
+#include <ImfThreading.h>
 #include <OpenEXRConfig.h>
 
 #include <blurImage.h>
@@ -128,6 +130,10 @@ usageMessage (ostream& stream, const char* program_name, bool verbose = false)
             << ",\n"
                "                default is zip)\n"
                "\n"
+               "  -j n          uses n threads to resample and blur the\n"
+               "                image, and to compress the output file\n"
+               "                (default depends on the number of processors)\n"
+               "\n"
                "  -v            verbose mode\n"
                "\n"
                "  -h, --help    print this message\n"
@@ -176,6 +182,9 @@ main (int argc, char** argv)
     bool              diffuseBlur       = false;
     bool              verbose           = false;
 
+    int threads =
+        ILMTHREAD_NAMESPACE::ThreadPool::estimateThreadCountForFileIO ();
+
     //
     // Parse the command line.
     //
@@ -363,6 +372,24 @@ main (int argc, char** argv)
                 compression = getCompression (argv[i + 1]);
                 i += 2;
             }
+            else if (!strcmp (argv[i], "-j"))
+            {
+                //
+                // Set number of threads
+                //
+
+                if (i > argc - 2)
+                    throw invalid_argument (
+                        "Missing thread count with -j option");
+
+                threads = strtol (argv[i + 1], 0, 0);
+
+                if (threads < 0)
+                    throw invalid_argument (
+                        "Thread count must not be negative");
+
+                i += 2;
+            }
             else if (!strcmp (argv[i], "-v"))
             {
                 //
@@ -419,6 +446,8 @@ main (int argc, char** argv)
         // Load inFile, convert it, and save the result in outFile.
         //
 
+        setGlobalThreadCount (threads);
+
         EnvmapImage  image;
         Header       header;
         RgbaChannels channels;
@@ -0,0 +1,105 @@
+//
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) Contributors to the OpenEXR Project.
+//
+
+//-----------------------------------------------------------------------------
+//
+//	function parallelRows() -- processes the rows of an image
+//	in parallel
+//
+//-----------------------------------------------------------------------------
+
+#include <parallelRows.h>
+
+#include <IlmThreadPool.h>
+#include <ImfThreading.h>
+#include <algorithm>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+
+#include "namespaceAlias.h"
+using namespace IMF;
+using namespace ILMTHREAD_NAMESPACE;
+using namespace std;
+
+namespace
+{
+
+class RowsTask : public Task
+{
+public:
+    RowsTask (
+        TaskGroup*                       group,
+        const function<void (int, int)>& rows,
+        int                              y0,
+        int                              y1,
+        mutex&                           errorMutex,
+        exception_ptr&                   error)
+        : Task (group)
+        , _rows (rows)
+        , _y0 (y0)
+        , _y1 (y1)
+        , _errorMutex (errorMutex)
+        , _error (error)
+    {}
+
+    void execute () override
+    {
+        try
+        {
+            _rows (_y0, _y1);
+        }
+        catch (...)
+        {
+            lock_guard<mutex> lock (_errorMutex);
+            if (!_error) _error = current_exception ();
+        }
+    }
+
+private:
+    const function<void (int, int)>& _rows;
+    int                              _y0;
+    int                              _y1;
+    mutex&                           _errorMutex;
+    exception_ptr&                   _error;
+};
+
+} // namespace
+
+void
+parallelRows (int numRows, const function<void (int, int)>& rows)
+{
+    //
+    // Use a few more bands than there are threads, so that
+    // bands that take longer than others do not leave threads idle.
+    //
+
+    int numThreads = globalThreadCount ();
+    int numBands   = min (numRows, numThreads * 4);
+
+    if (numThreads < 1 || numBands < 2)
+    {
+        rows (0, numRows);
+        return;
+    }
+
+    mutex         errorMutex;
+    exception_ptr error;
+
+    {
+        TaskGroup group;
+
+        for (int b = 0; b < numBands; ++b)
+        {
+            int y0 = int (int64_t (numRows) * b / numBands);
+            int y1 = int (int64_t (numRows) * (b + 1) / numBands);
+
+            ThreadPool::addGlobalTask (
+                new RowsTask (&group, rows, y0, y1, errorMutex, error));
+        }
+    }
+
+    if (error) rethrow_exception (error);
+}
@@ -0,0 +1,26 @@
+//
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) Contributors to the OpenEXR Project.
+//
+
+#ifndef INCLUDED_PARALLEL_ROWS_H
+#define INCLUDED_PARALLEL_ROWS_H
+
+//-----------------------------------------------------------------------------
+//
+//	function parallelRows() -- splits the rows of an image into
+//	bands and processes the bands in parallel, using the global
+//	thread pool.
+//
+//	parallelRows (n, rows) calls rows (y0, y1) for disjoint ranges
+//	of rows, [y0, y1), that together cover rows 0 through n-1.
+//	If rows() throws an exception, parallelRows() re-throws it
+//	after all bands have been processed.
+//
+//-----------------------------------------------------------------------------
+
+#include <functional>
+
+void parallelRows (int numRows, const std::function<void (int, int)>& rows);
+
+#endif
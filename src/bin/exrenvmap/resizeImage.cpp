@@ -14,6 +14,7 @@
 #include <resizeImage.h>
 
 #include "Iex.h"
+#include <parallelRows.h>
 #include <string.h>
 
 #include "namespaceAlias.h"
@@ -38,14 +39,16 @@ resizeLatLong (
 
     Array2D<Rgba>& pixels = image2.pixels ();
 
-    for (int y = 0; y < h; ++y)
-    {
-        for (int x = 0; x < w; ++x)
+    parallelRows (h, [&] (int y0, int y1) {
+        for (int y = y0; y < y1; ++y)
         {
-            V3f dir      = LatLongMap::direction (image2DataWindow, V2f (x, y));
-            pixels[y][x] = image1.filteredLookup (dir, radius, numSamples);
+            for (int x = 0; x < w; ++x)
+            {
+                V3f dir = LatLongMap::direction (image2DataWindow, V2f (x, y));
+                pixels[y][x] = image1.filteredLookup (dir, radius, numSamples);
+            }
         }
-    }
+    });
 }
 
 void
@@ -90,12 +93,17 @@ resizeCube (
 
     Array2D<Rgba>& pixels = image2.pixels ();
 
-    for (int f = CUBEFACE_POS_X; f <= CUBEFACE_NEG_Z; ++f)
-    {
-        CubeMapFace face = CubeMapFace (f);
+    //
+    // The rows of all six faces are resampled in parallel;
+    // row r is row r % sof of face r / sof.
+    //
 
-        for (int y = 0; y < sof; ++y)
+    parallelRows (6 * sof, [&] (int r0, int r1) {
+        for (int r = r0; r < r1; ++r)
         {
+            CubeMapFace face = CubeMapFace (CUBEFACE_POS_X + r / sof);
+            int         y    = r % sof;
+
             for (int x = 0; x < sof; ++x)
             {
                 V2f posInFace (x, y);
@@ -110,5 +118,5 @@ resizeCube (
                     image1.filteredLookup (dir, radius, numSamples);
             }
         }
-    }
+    });
 }
@@ -4,6 +4,7 @@
 */
 
 #include <openexr.h>
+#include <math.h>
 #include <stdio.h>
 #include <string.h>
 
@@ -13,6 +14,9 @@
 #    include <windows.h>
 #else
 #    include <unistd.h>
+#    if ILMTHREAD_THREADING_ENABLED
+#        include <pthread.h>
+#    endif
 #endif
 
 #include <stdlib.h>
@@ -22,7 +26,7 @@ usage (FILE* stream, const char* argv0, int verbose)
 {
     fprintf (
         stream,
-        "Usage: %s [-v|--verbose] [-a|--all-metadata] [-s|--strict] <filename> [<filename> ...]\n\n",
+        "Usage: %s [-v|--verbose] [-a|--all-metadata] [-s|--strict] [-c|--chunk-table] [-j n] [--json] [--files-from <list>] <filename> [<filename> ...]\n\n",
         argv0);
 
     if (verbose)
@@ -35,9 +39,19 @@ usage (FILE* stream, const char* argv0, int verbose)
             "  -s, --strict        strict mode\n"
             "  -a, --all-metadata  print all metadata\n"
             "  -v, --verbose       verbose mode\n"
+            "  -c, --chunk-table   also read the chunk offset table of every\n"
+            "                      part, and report how many chunks it lists\n"
+            "  -j, --threads n     open up to n files at once (default 1); the\n"
+            "                      output stays in the order of the files\n"
+            "      --json          print one JSON object per file and line\n"
+            "      --files-from f  read file names from f, one per line\n"
+            "                      ('-' reads them from stdin)\n"
             "  -h, --help          print this message\n"
             "      --version       print version information\n"
             "\n"
+            "The -s, -a, -v and -c options apply to the files that follow\n"
+            "them. Only the headers are read, unless -c is given.\n"
+            "\n"
             "Report bugs via https://github.com/AcademySoftwareFoundation/openexr/issues or email security@openexr.com\n"
             "");
 }
@@ -89,63 +103,745 @@ stdin_reader (
     return nread;
 }
 
-static int
-process_stdin (int verbose, int allmeta, int strict)
+/**************************************/
+
+/* A file to report on, with the options in effect for it, and the
+ * result of opening it */
+typedef struct
 {
-    int                       failcount = 0;
-    exr_result_t              rv;
-    exr_context_t             e     = NULL;
-    exr_context_initializer_t cinit = EXR_DEFAULT_CONTEXT_INITIALIZER;
-    cinit.error_handler_fn          = &error_handler_cb;
-    cinit.read_fn                   = &stdin_reader;
+    const char* filename; /* "-" is stdin */
+    int         verbose;
+    int         allmeta;
+    int         strict;
+    int         chunks;
 
-    if (!verbose) cinit.flags |= EXR_CONTEXT_FLAG_SILENT_HEADER_PARSE;
+    int           done;
+    exr_result_t  rv;
+    exr_context_t ctxt;
+    int           nparts;
+    int32_t*      chunk_count;
+    int32_t*      chunk_avail;
+} job_t;
 
-    if (strict) cinit.flags |= EXR_CONTEXT_FLAG_STRICT_HEADER;
+static void
+open_job (job_t* job)
+{
+    exr_context_initializer_t cinit = EXR_DEFAULT_CONTEXT_INITIALIZER;
+    cinit.error_handler_fn          = &error_handler_cb;
 
+    if (!strcmp (job->filename, "-"))
+    {
+        cinit.read_fn = &stdin_reader;
 #ifdef _WIN32
-    _setmode (_fileno (stdin), _O_BINARY);
+        _setmode (_fileno (stdin), _O_BINARY);
 #endif
-    rv = exr_start_read (&e, "<stdin>", &cinit);
-    if (rv == EXR_ERR_SUCCESS)
+    }
+
+    if (!job->verbose) cinit.flags |= EXR_CONTEXT_FLAG_SILENT_HEADER_PARSE;
+
+    if (job->strict) cinit.flags |= EXR_CONTEXT_FLAG_STRICT_HEADER;
+
+    job->rv = exr_start_read (
+        &(job->ctxt),
+        strcmp (job->filename, "-") ? job->filename : "<stdin>",
+        &cinit);
+    if (job->rv != EXR_ERR_SUCCESS || !job->chunks) return;
+
+    /* the chunk table is only read on demand, reading it is what
+     * makes -c more expensive */
+    exr_get_count (job->ctxt, &(job->nparts));
+    job->chunk_count = calloc ((size_t) job->nparts, sizeof (int32_t));
+    job->chunk_avail = calloc ((size_t) job->nparts, sizeof (int32_t));
+    if (!job->chunk_count || !job->chunk_avail)
+    {
+        job->rv = EXR_ERR_OUT_OF_MEMORY;
+        return;
+    }
+
+    for (int p = 0; p < job->nparts; ++p)
+    {
+        exr_get_chunk_count (job->ctxt, p, job->chunk_count + p);
+        if (EXR_ERR_SUCCESS != exr_refresh_chunk_table (
+                                   job->ctxt, p, job->chunk_avail + p, NULL))
+            job->chunk_avail[p] = -1;
+    }
+}
+
+static void
+close_job (job_t* job)
+{
+    if (job->ctxt) exr_finish (&(job->ctxt));
+    free (job->chunk_count);
+    free (job->chunk_avail);
+    job->chunk_count = NULL;
+    job->chunk_avail = NULL;
+}
+
+/**************************************/
+
+static void
+print_json_string (const char* s)
+{
+    putchar ('"');
+    for (; s && *s; ++s)
     {
-        exr_print_context_info (e, verbose || allmeta);
-        exr_finish (&e);
+        unsigned char c = (unsigned char) *s;
+        if (c == '"' || c == '\\')
+        {
+            putchar ('\\');
+            putchar (c);
+        }
+        else if (c < 0x20)
+            printf ("\\u%04x", c);
+        else
+            putchar (c);
     }
+    putchar ('"');
+}
+
+static void
+print_json_number (double v, int digits)
+{
+    if (isfinite (v))
+        printf ("%.*g", digits, v);
     else
-        ++failcount;
-    return failcount;
+        printf ("null");
+}
+
+static void
+print_json_floats (const float* v, int n)
+{
+    putchar ('[');
+    for (int i = 0; i < n; ++i)
+    {
+        if (i > 0) putchar (',');
+        print_json_number ((double) v[i], 9);
+    }
+    putchar (']');
 }
 
+static void
+print_json_doubles (const double* v, int n)
+{
+    putchar ('[');
+    for (int i = 0; i < n; ++i)
+    {
+        if (i > 0) putchar (',');
+        print_json_number (v[i], 17);
+    }
+    putchar (']');
+}
+
+static void
+print_json_attr (const exr_attribute_t* a)
+{
+    switch (a->type)
+    {
+        case EXR_ATTR_BOX2I:
+            printf (
+                "{\"min\":[%d,%d],\"max\":[%d,%d]}",
+                a->box2i->min.x,
+                a->box2i->min.y,
+                a->box2i->max.x,
+                a->box2i->max.y);
+            break;
+        case EXR_ATTR_BOX2F:
+            printf ("{\"min\":");
+            print_json_floats (&(a->box2f->min.x), 2);
+            printf (",\"max\":");
+            print_json_floats (&(a->box2f->max.x), 2);
+            putchar ('}');
+            break;
+        case EXR_ATTR_CHLIST:
+            putchar ('[');
+            for (int c = 0; c < a->chlist->num_channels; ++c)
+            {
+                const exr_attr_chlist_entry_t* e = a->chlist->entries + c;
+                if (c > 0) putchar (',');
+                printf ("{\"name\":");
+                print_json_string (e->name.str);
+                printf (
+                    ",\"type\":\"%s\",\"xSampling\":%d,\"ySampling\":%d,\"pLinear\":%s}",
+                    e->pixel_type == EXR_PIXEL_UINT    ? "uint"
+                    : e->pixel_type == EXR_PIXEL_HALF  ? "half"
+                    : e->pixel_type == EXR_PIXEL_FLOAT ? "float"
+                                                       : "unknown",
+                    e->x_sampling,
+                    e->y_sampling,
+                    e->p_linear ? "true" : "false");
+            }
+            putchar (']');
+            break;
+        case EXR_ATTR_CHROMATICITIES:
+            printf ("{\"red\":");
+            print_json_floats (&(a->chromaticities->red_x), 2);
+            printf (",\"green\":");
+            print_json_floats (&(a->chromaticities->green_x), 2);
+            printf (",\"blue\":");
+            print_json_floats (&(a->chromaticities->blue_x), 2);
+            printf (",\"white\":");
+            print_json_floats (&(a->chromaticities->white_x), 2);
+            putchar ('}');
+            break;
+        case EXR_ATTR_COMPRESSION: {
+            static const char* compressionnames[] = {
+                "none",
+                "rle",
+                "zips",
+                "zip",
+                "piz",
+                "pxr24",
+                "b44",
+                "b44a",
+                "dwaa",
+                "dwab"};
+            if (a->uc < 10)
+                printf ("\"%s\"", compressionnames[a->uc]);
+            else
+                printf ("%d", (int) a->uc);
+            break;
+        }
+        case EXR_ATTR_DOUBLE: print_json_number (a->d, 17); break;
+        case EXR_ATTR_ENVMAP:
+            printf ("\"%s\"", a->uc == 0 ? "latlong" : "cube");
+            break;
+        case EXR_ATTR_FLOAT: print_json_number ((double) a->f, 9); break;
+        case EXR_ATTR_FLOAT_VECTOR:
+            print_json_floats (a->floatvector->arr, a->floatvector->length);
+            break;
+        case EXR_ATTR_INT: printf ("%d", a->i); break;
+        case EXR_ATTR_KEYCODE:
+            printf (
+                "{\"filmMfcCode\":%d,\"filmType\":%d,\"prefix\":%d,\"count\":%d,\"perfOffset\":%d,\"perfsPerFrame\":%d,\"perfsPerCount\":%d}",
+                a->keycode->film_mfc_code,
+                a->keycode->film_type,
+                a->keycode->prefix,
+                a->keycode->count,
+                a->keycode->perf_offset,
+                a->keycode->perfs_per_frame,
+                a->keycode->perfs_per_count);
+            break;
+        case EXR_ATTR_LINEORDER:
+            if (a->uc == EXR_LINEORDER_INCREASING_Y)
+                printf ("\"increasing\"");
+            else if (a->uc == EXR_LINEORDER_DECREASING_Y)
+                printf ("\"decreasing\"");
+            else if (a->uc == EXR_LINEORDER_RANDOM_Y)
+                printf ("\"random\"");
+            else
+                printf ("%d", (int) a->uc);
+            break;
+        case EXR_ATTR_M33F: print_json_floats (a->m33f->m, 9); break;
+        case EXR_ATTR_M33D: print_json_doubles (a->m33d->m, 9); break;
+        case EXR_ATTR_M44F: print_json_floats (a->m44f->m, 16); break;
+        case EXR_ATTR_M44D: print_json_doubles (a->m44d->m, 16); break;
+        case EXR_ATTR_PREVIEW:
+            printf (
+                "{\"width\":%u,\"height\":%u}",
+                a->preview->width,
+                a->preview->height);
+            break;
+        case EXR_ATTR_RATIONAL:
+            printf ("[%d,%u]", a->rational->num, a->rational->denom);
+            break;
+        case EXR_ATTR_STRING: print_json_string (a->string->str); break;
+        case EXR_ATTR_STRING_VECTOR:
+            putchar ('[');
+            for (int i = 0; i < a->stringvector->n_strings; ++i)
+            {
+                if (i > 0) putchar (',');
+                print_json_string (a->stringvector->strings[i].str);
+            }
+            putchar (']');
+            break;
+        case EXR_ATTR_TILEDESC: {
+            static const char* lvlModes[] = {"single", "mipmap", "ripmap"};
+            uint8_t            lvlMode =
+                (uint8_t) EXR_GET_TILE_LEVEL_MODE (*(a->tiledesc));
+            uint8_t rndMode =
+                (uint8_t) EXR_GET_TILE_ROUND_MODE (*(a->tiledesc));
+            printf (
+                "{\"xSize\":%u,\"ySize\":%u,\"levelMode\":\"%s\",\"roundingMode\":\"%s\"}",
+                a->tiledesc->x_size,
+                a->tiledesc->y_size,
+                lvlMode < 3 ? lvlModes[lvlMode] : "unknown",
+                rndMode == 0 ? "down" : "up");
+            break;
+        }
+        case EXR_ATTR_TIMECODE:
+            printf (
+                "{\"timeAndFlags\":%u,\"userData\":%u}",
+                a->timecode->time_and_flags,
+                a->timecode->user_data);
+            break;
+        case EXR_ATTR_V2I: printf ("[%d,%d]", a->v2i->x, a->v2i->y); break;
+        case EXR_ATTR_V2F: print_json_floats (&(a->v2f->x), 2); break;
+        case EXR_ATTR_V2D: print_json_doubles (&(a->v2d->x), 2); break;
+        case EXR_ATTR_V3I:
+            printf ("[%d,%d,%d]", a->v3i->x, a->v3i->y, a->v3i->z);
+            break;
+        case EXR_ATTR_V3F: print_json_floats (&(a->v3f->x), 3); break;
+        case EXR_ATTR_V3D: print_json_doubles (&(a->v3d->x), 3); break;
+        case EXR_ATTR_DEEP_IMAGE_STATE: printf ("%d", (int) a->uc); break;
+        case EXR_ATTR_OPAQUE:
+            printf ("{\"type\":");
+            print_json_string (a->type_name);
+            printf (",\"size\":%d}", a->opaque->size);
+            break;
+        case EXR_ATTR_UNKNOWN:
+        case EXR_ATTR_LAST_KNOWN_TYPE:
+        default: printf ("null"); break;
+    }
+}
+
+/* the attributes printed without -a or -v, as in the text output */
 static int
-process_file (const char* filename, int verbose, int allmeta, int strict)
+is_summary_attr (const char* name)
 {
-    int                       failcount = 0;
-    exr_result_t              rv;
-    exr_context_t             e     = NULL;
-    exr_context_initializer_t cinit = EXR_DEFAULT_CONTEXT_INITIALIZER;
-    cinit.error_handler_fn          = &error_handler_cb;
+    static const char* names[] = {
+        "name",
+        "type",
+        "compression",
+        "tiles",
+        "displayWindow",
+        "dataWindow",
+        "channels"};
+    for (size_t i = 0; i < sizeof (names) / sizeof (names[0]); ++i)
+        if (!strcmp (name, names[i])) return 1;
+    return 0;
+}
+
+static void
+print_json (const job_t* job)
+{
+    uint32_t ver = 0;
+    int      nparts;
 
-    if (!verbose) cinit.flags |= EXR_CONTEXT_FLAG_SILENT_HEADER_PARSE;
+    printf ("{\"file\":");
+    print_json_string (job->filename);
 
-    if (strict) cinit.flags |= EXR_CONTEXT_FLAG_STRICT_HEADER;
+    if (job->rv != EXR_ERR_SUCCESS)
+    {
+        printf (",\"error\":");
+        print_json_string (exr_get_error_code_as_string (job->rv));
+        printf ("}\n");
+        return;
+    }
 
-    rv = exr_start_read (&e, filename, &cinit);
+    exr_get_file_version_and_flags (job->ctxt, &ver);
+    exr_get_count (job->ctxt, &nparts);
+    printf (
+        ",\"version\":%u,\"multipart\":%s,\"deep\":%s,\"parts\":[",
+        ver & 0xFF,
+        (ver & 0x1000) ? "true" : "false",
+        (ver & 0x800) ? "true" : "false");
 
-    if (rv == EXR_ERR_SUCCESS)
+    for (int p = 0; p < nparts; ++p)
     {
-        exr_print_context_info (e, verbose || allmeta);
-        exr_finish (&e);
+        int32_t nattrs = 0;
+        int     first  = 1;
+
+        if (p > 0) putchar (',');
+        printf ("{\"attributes\":{");
+
+        exr_get_attribute_count (job->ctxt, p, &nattrs);
+        for (int32_t i = 0; i < nattrs; ++i)
+        {
+            const exr_attribute_t* a = NULL;
+            if (EXR_ERR_SUCCESS != exr_get_attribute_by_index (
+                                       job->ctxt,
+                                       p,
+                                       EXR_ATTR_LIST_FILE_ORDER,
+                                       i,
+                                       &a))
+                continue;
+            if (!job->allmeta && !job->verbose && !is_summary_attr (a->name))
+                continue;
+
+            if (!first) putchar (',');
+            first = 0;
+            print_json_string (a->name);
+            putchar (':');
+            print_json_attr (a);
+        }
+        putchar ('}');
+
+        if (job->chunks)
+        {
+            printf (",\"chunkCount\":%d", job->chunk_count[p]);
+            if (job->chunk_avail[p] >= 0)
+                printf (",\"chunksPresent\":%d", job->chunk_avail[p]);
+            else
+                printf (",\"chunksPresent\":null");
+        }
+        putchar ('}');
     }
-    else
-        ++failcount;
-    return failcount;
+    printf ("]}\n");
+}
+
+static int
+print_job (const job_t* job, int json)
+{
+    if (json)
+        print_json (job);
+    else if (job->rv == EXR_ERR_SUCCESS)
+    {
+        exr_print_context_info (job->ctxt, job->verbose || job->allmeta);
+        for (int p = 0; job->chunks && p < job->nparts; ++p)
+        {
+            if (job->chunk_avail[p] >= 0)
+                printf (
+                    " part %d chunk table: %d of %d chunks present\n",
+                    p + 1,
+                    job->chunk_avail[p],
+                    job->chunk_count[p]);
+            else
+                printf (
+                    " part %d chunk table: unreadable (%d chunks)\n",
+                    p + 1,
+                    job->chunk_count[p]);
+        }
+    }
+    return job->rv == EXR_ERR_SUCCESS ? 0 : 1;
+}
+
+/**************************************/
+
+/* Worker threads open files ahead of the main thread, which prints
+ * them in order. Workers stay at most a window of files ahead, so
+ * memory use does not grow with the number of files. */
+
+#if ILMTHREAD_THREADING_ENABLED
+#    ifdef _WIN32
+typedef CRITICAL_SECTION   info_mutex_t;
+typedef CONDITION_VARIABLE info_cond_t;
+typedef HANDLE             info_thread_t;
+#    else
+typedef pthread_mutex_t info_mutex_t;
+typedef pthread_cond_t  info_cond_t;
+typedef pthread_t       info_thread_t;
+#    endif
+
+typedef struct
+{
+    job_t*       jobs;
+    int          njobs;
+    int          next;
+    int          printed;
+    int          window;
+    info_mutex_t mutex;
+    info_cond_t  cond;
+} pool_t;
+
+static void
+pool_lock (pool_t* pool)
+{
+#    ifdef _WIN32
+    EnterCriticalSection (&(pool->mutex));
+#    else
+    pthread_mutex_lock (&(pool->mutex));
+#    endif
+}
+
+static void
+pool_unlock (pool_t* pool)
+{
+#    ifdef _WIN32
+    LeaveCriticalSection (&(pool->mutex));
+#    else
+    pthread_mutex_unlock (&(pool->mutex));
+#    endif
+}
+
+static void
+pool_wait (pool_t* pool)
+{
+#    ifdef _WIN32
+    SleepConditionVariableCS (&(pool->cond), &(pool->mutex), INFINITE);
+#    else
+    pthread_cond_wait (&(pool->cond), &(pool->mutex));
+#    endif
+}
+
+static void
+pool_wake (pool_t* pool)
+{
+#    ifdef _WIN32
+    WakeAllConditionVariable (&(pool->cond));
+#    else
+    pthread_cond_broadcast (&(pool->cond));
+#    endif
+}
+
+static void
+pool_work (pool_t* pool)
+{
+    pool_lock (pool);
+    for (;;)
+    {
+        int j;
+
+        while (pool->next < pool->njobs &&
+               pool->next >= pool->printed + pool->window)
+            pool_wait (pool);
+        if (pool->next >= pool->njobs) break;
+
+        j = pool->next++;
+        pool_unlock (pool);
+        open_job (pool->jobs + j);
+        pool_lock (pool);
+
+        pool->jobs[j].done = 1;
+        pool_wake (pool);
+    }
+    pool_unlock (pool);
+}
+
+#    ifdef _WIN32
+static DWORD WINAPI
+pool_thread (LPVOID arg)
+{
+    pool_work ((pool_t*) arg);
+    return 0;
+}
+#    else
+static void*
+pool_thread (void* arg)
+{
+    pool_work ((pool_t*) arg);
+    return NULL;
+}
+#    endif
+
+static int
+process_parallel (job_t* jobs, int njobs, int nthreads, int json)
+{
+    pool_t         pool;
+    info_thread_t* threads;
+    int            started = 0, rv = 0;
+
+    threads = calloc ((size_t) nthreads, sizeof (info_thread_t));
+    if (!threads) return -1;
+
+    pool.jobs    = jobs;
+    pool.njobs   = njobs;
+    pool.next    = 0;
+    pool.printed = 0;
+    pool.window  = nthreads * 4;
+#    ifdef _WIN32
+    InitializeCriticalSection (&(pool.mutex));
+    InitializeConditionVariable (&(pool.cond));
+#    else
+    pthread_mutex_init (&(pool.mutex), NULL);
+    pthread_cond_init (&(pool.cond), NULL);
+#    endif
+
+    for (int t = 0; t < nthreads; ++t)
+    {
+#    ifdef _WIN32
+        threads[t] = CreateThread (NULL, 0, &pool_thread, &pool, 0, NULL);
+        if (!threads[t]) break;
+#    else
+        if (pthread_create (threads + t, NULL, &pool_thread, &pool)) break;
+#    endif
+        ++started;
+    }
+
+    /* if no thread could be started, the files are read one by one */
+    if (started == 0) rv = -1;
+
+    for (int j = 0; started > 0 && j < njobs; ++j)
+    {
+        pool_lock (&pool);
+        while (!jobs[j].done)
+            pool_wait (&pool);
+        pool_unlock (&pool);
+
+        rv += print_job (jobs + j, json);
+        close_job (jobs + j);
+
+        pool_lock (&pool);
+        pool.printed = j + 1;
+        pool_wake (&pool);
+        pool_unlock (&pool);
+    }
+
+    for (int t = 0; t < started; ++t)
+    {
+#    ifdef _WIN32
+        WaitForSingleObject (threads[t], INFINITE);
+        CloseHandle (threads[t]);
+#    else
+        pthread_join (threads[t], NULL);
+#    endif
+    }
+
+#    ifdef _WIN32
+    DeleteCriticalSection (&(pool.mutex));
+#    else
+    pthread_cond_destroy (&(pool.cond));
+    pthread_mutex_destroy (&(pool.mutex));
+#    endif
+    free (threads);
+    return rv;
+}
+#endif /* ILMTHREAD_THREADING_ENABLED */
+
+static int
+process_jobs (job_t* jobs, int njobs, int nthreads, int json)
+{
+    int rv = 0;
+
+#if ILMTHREAD_THREADING_ENABLED
+    if (nthreads > 1 && njobs > 1)
+    {
+        rv = process_parallel (jobs, njobs, nthreads, json);
+        if (rv >= 0) return rv;
+        rv = 0;
+    }
+#else
+    (void) nthreads;
+#endif
+
+    for (int j = 0; j < njobs; ++j)
+    {
+        open_job (jobs + j);
+        rv += print_job (jobs + j, json);
+        close_job (jobs + j);
+    }
+    return rv;
+}
+
+/**************************************/
+
+typedef struct
+{
+    job_t* jobs;
+    int    njobs;
+    int    capacity;
+    char** names; /* file names read with --files-from */
+    int    nnames;
+    int    namecap;
+} job_list_t;
+
+static int
+add_job (job_list_t* list, const job_t* job)
+{
+    if (list->njobs == list->capacity)
+    {
+        int    newcap = list->capacity ? list->capacity * 2 : 64;
+        job_t* newjobs =
+            realloc (list->jobs, (size_t) newcap * sizeof (job_t));
+        if (!newjobs) return 0;
+        list->jobs     = newjobs;
+        list->capacity = newcap;
+    }
+    list->jobs[list->njobs++] = *job;
+    return 1;
+}
+
+static int
+add_jobs_from (job_list_t* list, const char* listname, const job_t* opts)
+{
+    FILE* f = strcmp (listname, "-") ? fopen (listname, "r") : stdin;
+    char  line[4096];
+    int   lineno = 0, rv = 1, nomem = 0;
+
+    if (!f)
+    {
+        fprintf (stderr, "Unable to open file list '%s'\n", listname);
+        return 0;
+    }
+
+    while (rv && fgets (line, sizeof (line), f))
+    {
+        size_t len = strlen (line);
+        job_t  job = *opts;
+        char*  name;
+
+        ++lineno;
+        if (len == sizeof (line) - 1 && line[len - 1] != '\n')
+        {
+            int c = getc (f);
+            if (c != EOF)
+            {
+                fprintf (
+                    stderr,
+                    "%s:%d: file name longer than %d bytes\n",
+                    listname,
+                    lineno,
+                    (int) sizeof (line) - 1);
+                rv = 0;
+                break;
+            }
+        }
+
+        while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r'))
+            line[--len] = '\0';
+        if (len == 0) continue;
+
+        if (list->nnames == list->namecap)
+        {
+            int    newcap = list->namecap ? list->namecap * 2 : 64;
+            char** newnames =
+                realloc (list->names, (size_t) newcap * sizeof (char*));
+            if (!newnames)
+            {
+                rv    = 0;
+                nomem = 1;
+                break;
+            }
+            list->names   = newnames;
+            list->namecap = newcap;
+        }
+
+        name = malloc (len + 1);
+        if (!name)
+        {
+            rv    = 0;
+            nomem = 1;
+            break;
+        }
+        memcpy (name, line, len + 1);
+        list->names[list->nnames++] = name;
+
+        job.filename = name;
+        rv           = add_job (list, &job);
+        nomem        = !rv;
+    }
+
+    if (rv && ferror (f))
+    {
+        fprintf (stderr, "Unable to read file list '%s'\n", listname);
+        rv = 0;
+    }
+    else if (nomem)
+    {
+        fprintf (stderr, "%s:%d: out of memory\n", listname, lineno);
+    }
+
+    if (f != stdin) fclose (f);
+    return rv;
+}
+
+static void
+free_job_list (job_list_t* list)
+{
+    for (int n = 0; n < list->nnames; ++n)
+        free (list->names[n]);
+    free (list->names);
+    free (list->jobs);
 }
 
 int
 main (int argc, const char* argv[])
 {
-    int rv = 0, verbose = 0, allmeta = 0, strict = 0;
+    int        rv = 0, json = 0, nthreads = 1;
+    job_t      opts;
+    job_list_t list;
+
+    memset (&opts, 0, sizeof (opts));
+    memset (&list, 0, sizeof (list));
 
     for (int a = 1; a < argc; ++a)
     {
@@ -153,6 +849,7 @@ main (int argc, const char* argv[])
             !strcmp (argv[a], "--help"))
         {
             usage (stdout, "exrinfo", 1);
+            free_job_list (&list);
             return 0;
         }
         else if (!strcmp (argv[a], "--version"))
@@ -162,31 +859,75 @@ main (int argc, const char* argv[])
                 OPENEXR_VERSION_STRING);
             printf ("Copyright (c) Contributors to the OpenEXR Project\n");
             printf ("License BSD-3-Clause\n");
+            free_job_list (&list);
             return 0;
         }
         else if (!strcmp (argv[a], "-v") || !strcmp (argv[a], "--verbose"))
         {
-            verbose = 1;
+            opts.verbose = 1;
         }
         else if (!strcmp (argv[a], "-a") || !strcmp (argv[a], "--all-metadata"))
         {
-            allmeta = 1;
+            opts.allmeta = 1;
         }
         else if (!strcmp (argv[a], "-s") || !strcmp (argv[a], "--strict"))
         {
-            strict = 1;
+            opts.strict = 1;
+        }
+        else if (!strcmp (argv[a], "-c") || !strcmp (argv[a], "--chunk-table"))
+        {
+            opts.chunks = 1;
+        }
+        else if (!strcmp (argv[a], "--json")) { json = 1; }
+        else if (!strcmp (argv[a], "-j") || !strcmp (argv[a], "--threads"))
+        {
+            if (a + 1 >= argc || atoi (argv[a + 1]) < 1)
+            {
+                usage (stderr, argv[0], 0);
+                free_job_list (&list);
+                return 1;
+            }
+            nthreads = atoi (argv[++a]);
+        }
+        else if (!strcmp (argv[a], "--files-from"))
+        {
+            if (a + 1 >= argc)
+            {
+                usage (stderr, argv[0], 0);
+                free_job_list (&list);
+                return 1;
+            }
+            if (!add_jobs_from (&list, argv[++a], &opts))
+            {
+                free_job_list (&list);
+                return 1;
+            }
         }
         else if (!strcmp (argv[a], "-"))
         {
-            rv += process_stdin (verbose, allmeta, strict);
+            opts.filename = argv[a];
+            if (!add_job (&list, &opts)) goto nomem;
         }
         else if (argv[a][0] == '-')
         {
             usage (stderr, argv[0], 0);
+            free_job_list (&list);
             return 1;
         }
-        else { rv += process_file (argv[a], verbose, allmeta, strict); }
+        else
+        {
+            opts.filename = argv[a];
+            if (!add_job (&list, &opts)) goto nomem;
+        }
     }
 
+    rv = process_jobs (list.jobs, list.njobs, nthreads, json);
+
+    free_job_list (&list);
     return rv;
+
+nomem:
+    fprintf (stderr, "%s: out of memory\n", argv[0]);
+    free_job_list (&list);
+    return 1;
 }
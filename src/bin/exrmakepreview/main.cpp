@@ -12,13 +12,17 @@
 
 #include "makePreview.h"
 
+#include <IlmThreadPool.h>
 #include <ImfMisc.h>
+#include <ImfThreading.h>
 #include <OpenEXRConfig.h>
 
 #include <exception>
 #include <iostream>
 #include <stdlib.h>
 #include <string.h>
+#include <string>
+#include <vector>
 
 using namespace OPENEXR_IMF_NAMESPACE;
 using namespace std;
@@ -26,7 +30,9 @@ using namespace std;
 void
 usageMessage (ostream& stream, const char* program_name, bool verbose = false)
 {
-    stream << "Usage: " << program_name << " [options] infile outfile" << endl;
+    stream << "Usage: " << program_name << " [options] infile outfile" << endl
+           << "       " << program_name << " [options] -d dir infile ..."
+           << endl;
 
     if (verbose)
         stream
@@ -36,6 +42,11 @@ usageMessage (ostream& stream, const char* program_name, bool verbose = false)
                "in outfile.  Infile and outfile must not refer to the same\n"
                "file (the program cannot edit an image file \"in place\").\n"
                "\n"
+               "With option -d, add preview images to any number of\n"
+               "infiles, and save the results in directory dir, under\n"
+               "the names of the infiles.  Several files are processed\n"
+               "in parallel.\n"
+               "\n"
                "Options:\n"
                "\n"
                "  -w x          sets the width of the preview image to x pixels\n"
@@ -45,6 +56,12 @@ usageMessage (ostream& stream, const char* program_name, bool verbose = false)
                "                (default is 0).  Positive values make the image\n"
                "                brighter, negative values make it darker.\n"
                "\n"
+               "  -d dir        batch mode: saves the output files in\n"
+               "                directory dir\n"
+               "\n"
+               "  -j n          uses n threads (default depends on the\n"
+               "                number of processors)\n"
+               "\n"
                "  -v            verbose mode\n"
                "\n"
                "  -h, --help    print this message\n"
@@ -62,8 +79,14 @@ main (int argc, char** argv)
     const char* outFile      = 0;
     int         previewWidth = 100;
     float       exposure     = 0;
+    const char* outDir       = 0;
     bool        verbose      = false;
 
+    vector<string> inFiles;
+
+    int threads =
+        ILMTHREAD_NAMESPACE::ThreadPool::estimateThreadCountForFileIO ();
+
     //
     // Parse the command line.
     //
@@ -109,6 +132,37 @@ main (int argc, char** argv)
 
                 i += 2;
             }
+            else if (!strcmp (argv[i], "-d"))
+            {
+                //
+                // Batch mode
+                //
+
+                if (i > argc - 2)
+                    throw invalid_argument (
+                        "Missing directory for -d argument");
+
+                outDir = argv[i + 1];
+                i += 2;
+            }
+            else if (!strcmp (argv[i], "-j"))
+            {
+                //
+                // Set number of threads
+                //
+
+                if (i > argc - 2)
+                    throw invalid_argument (
+                        "Missing thread count for -j argument");
+
+                threads = strtol (argv[i + 1], 0, 0);
+
+                if (threads < 0)
+                    throw invalid_argument (
+                        "Thread count must not be negative");
+
+                i += 2;
+            }
             else if (!strcmp (argv[i], "-v"))
             {
                 //
@@ -146,33 +200,59 @@ main (int argc, char** argv)
                 // Image file name
                 //
 
-                if (inFile == 0)
-                    inFile = argv[i];
-                else
-                    outFile = argv[i];
-
+                inFiles.push_back (argv[i]);
                 i += 1;
             }
         }
 
+        if (previewWidth <= 0)
+            throw invalid_argument (
+                "Preview image width must be greater than zero");
+
+        setGlobalThreadCount (threads);
+
+        if (outDir)
+        {
+            //
+            // Add preview images to all infiles, and save
+            // the results in outDir.
+            //
+
+            if (inFiles.empty ())
+            {
+                usageMessage (cerr, argv[0], false);
+                return -1;
+            }
+
+            int numFailed =
+                makePreviews (inFiles, outDir, previewWidth, exposure, verbose);
+
+            return numFailed ? 1 : 0;
+        }
+
+        if (inFiles.size () == 2)
+        {
+            inFile  = inFiles[0].c_str ();
+            outFile = inFiles[1].c_str ();
+        }
+
         if (inFile == 0 || outFile == 0)
         {
             usageMessage (cerr, argv[0], false);
             return -1;
         }
 
-        if (!strcmp (inFile, outFile))
-            throw invalid_argument ("Input and output cannot be the same file");
-
-        if (previewWidth <= 0)
-            throw invalid_argument (
-                "Preview image width must be greater than zero");
-
         //
         // Load inFile, add a preview image, and save the result in outFile.
         //
 
-        makePreview (inFile, outFile, previewWidth, exposure, verbose);
+        makePreview (
+            inFile,
+            outFile,
+            previewWidth,
+            exposure,
+            globalThreadCount (),
+            verbose);
     }
     catch (const exception& e)
     {
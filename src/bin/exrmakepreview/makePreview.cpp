@@ -11,17 +11,28 @@
 
 #include "makePreview.h"
 
+#include <IlmThreadPool.h>
 #include <ImathFun.h>
 #include <ImathMath.h>
 #include <ImfArray.h>
+#include <ImfCompression.h>
 #include <ImfInputFile.h>
 #include <ImfOutputFile.h>
 #include <ImfPreviewImage.h>
 #include <ImfRgbaFile.h>
 #include <ImfTiledOutputFile.h>
+#include <ImfThreading.h>
+#include <ImfTiledRgbaFile.h>
 #include <algorithm>
+#include <atomic>
+#include <filesystem>
 #include <iostream>
+#include <map>
 #include <math.h>
+#include <mutex>
+#include <stdexcept>
+#include <string.h>
+#include <vector>
 
 #include <OpenEXRConfig.h>
 using namespace OPENEXR_IMF_NAMESPACE;
@@ -56,58 +67,185 @@ gamma (half h, float m)
         std::pow (x, 0.4545f) * 84.66f, 0.f, 255.f));
 }
 
+void
+previewPixel (const Rgba& pixel, float m, PreviewRgba& preview)
+{
+    preview.r = gamma (pixel.r, m);
+    preview.g = gamma (pixel.g, m);
+    preview.b = gamma (pixel.b, m);
+    preview.a =
+        int (IMATH_NAMESPACE::clamp (pixel.a * 255.f, 0.f, 255.f) + .5f);
+}
+
+//
+// The smallest of the n levels of a multi-resolution image
+// for which largeEnough() returns true, or level 0.
+//
+
+template <class F>
+int
+closestLevel (int n, F largeEnough)
+{
+    for (int l = n - 1; l > 0; --l)
+        if (largeEnough (l)) return l;
+
+    return 0;
+}
+
 void
 generatePreview (
     const char            inFileName[],
     float                 exposure,
     int                   previewWidth,
+    int                   numThreads,
     int&                  previewHeight,
     Array2D<PreviewRgba>& previewPixels)
 {
     //
-    // Read the input file
+    // The preview image point-samples the input image, so only the
+    // sampled scan lines are read.  The sampled lines that fall into
+    // the same chunk (line buffer or row of tiles) are read with one
+    // readPixels() call, into a buffer that holds one chunk, so that
+    // no chunk is decoded more than once.  If the input image has
+    // mipmap or ripmap levels, the preview samples the smallest level
+    // that is at least as large as the preview image.
     //
 
-    RgbaInputFile in (inFileName);
+    RgbaInputFile in (inFileName, numThreads);
 
     Box2i dw = in.dataWindow ();
     float a  = in.pixelAspectRatio ();
     int   w  = dw.max.x - dw.min.x + 1;
     int   h  = dw.max.y - dw.min.y + 1;
 
-    Array2D<Rgba> pixels (h, w);
-    in.setFrameBuffer (ComputeBasePointer (&pixels[0][0], dw), 1, w);
-    in.readPixels (dw.min.y, dw.max.y);
-
-    //
-    // Make a preview image
-    //
-
     previewHeight = max (int (h / (w * a) * previewWidth + .5f), 1);
     previewPixels.resizeErase (previewHeight, previewWidth);
 
+    float m = std::pow (
+        2.f, IMATH_NAMESPACE::clamp (exposure + 2.47393f, -20.f, 20.f));
+
+    const Header& header = in.header ();
+
+    if (header.hasTileDescription () &&
+        header.tileDescription ().mode != ONE_LEVEL)
+    {
+        TiledRgbaInputFile tin (inFileName, numThreads);
+
+        int lx, ly;
+
+        if (tin.levelMode () == MIPMAP_LEVELS)
+        {
+            lx = ly = closestLevel (tin.numLevels (), [&] (int l) {
+                return tin.levelWidth (l) >= previewWidth &&
+                       tin.levelHeight (l) >= previewHeight;
+            });
+        }
+        else
+        {
+            lx = closestLevel (tin.numXLevels (), [&] (int l) {
+                return tin.levelWidth (l) >= previewWidth;
+            });
+
+            ly = closestLevel (tin.numYLevels (), [&] (int l) {
+                return tin.levelHeight (l) >= previewHeight;
+            });
+        }
+
+        Box2i ldw = tin.dataWindowForLevel (lx, ly);
+        int   lw  = ldw.max.x - ldw.min.x + 1;
+        int   lh  = ldw.max.y - ldw.min.y + 1;
+
+        Array2D<Rgba> pixels (lh, lw);
+        tin.setFrameBuffer (ComputeBasePointer (&pixels[0][0], ldw), 1, lw);
+        tin.readTiles (
+            0, tin.numXTiles (lx) - 1, 0, tin.numYTiles (ly) - 1, lx, ly);
+
+        double fx = (previewWidth > 1) ? (double (lw - 1) / (previewWidth - 1))
+                                       : 1;
+        double fy = (previewHeight > 1)
+                        ? (double (lh - 1) / (previewHeight - 1))
+                        : 1;
+
+        for (int y = 0; y < previewHeight; ++y)
+        {
+            for (int x = 0; x < previewWidth; ++x)
+            {
+                previewPixel (
+                    pixels[int (y * fy + .5f)][int (x * fx + .5f)],
+                    m,
+                    previewPixels[y][x]);
+            }
+        }
+
+        return;
+    }
+
     double fx = (previewWidth > 1) ? (double (w - 1) / (previewWidth - 1)) : 1;
     double fy = (previewHeight > 1) ? (double (h - 1) / (previewHeight - 1))
                                     : 1;
-    float  m  = std::pow (
-        2.f, IMATH_NAMESPACE::clamp (exposure + 2.47393f, -20.f, 20.f));
 
-    for (int y = 0; y < previewHeight; ++y)
+    const Compression comp = header.compression ();
+
+    int linesPerChunk = header.hasTileDescription ()
+                            ? int (header.tileDescription ().ySize)
+                            : getCompressionNumScanlines (comp);
+
+    linesPerChunk = IMATH_NAMESPACE::clamp (linesPerChunk, 1, h);
+
+    vector<Rgba> band (size_t (linesPerChunk) * size_t (w));
+
+    for (int y1 = 0; y1 < previewHeight;)
     {
-        for (int x = 0; x < previewWidth; ++x)
+        //
+        // Preview lines y1 through y2 - 1 sample input lines
+        // in the same chunk, relative to the data window.
+        //
+
+        int sy1   = int (y1 * fy + .5f);
+        int chunk = sy1 / linesPerChunk;
+        int y2    = y1 + 1;
+
+        while (y2 < previewHeight &&
+               int (y2 * fy + .5f) / linesPerChunk == chunk)
+            ++y2;
+
+        int sy2 = int ((y2 - 1) * fy + .5f);
+
+        Box2i bandWindow (
+            V2i (dw.min.x, dw.min.y + sy1), V2i (dw.max.x, dw.min.y + sy2));
+
+        in.setFrameBuffer (ComputeBasePointer (&band[0], bandWindow), 1, w);
+        in.readPixels (bandWindow.min.y, bandWindow.max.y);
+
+        for (int y = y1; y < y2; ++y)
         {
-            PreviewRgba& preview = previewPixels[y][x];
-            const Rgba&  pixel = pixels[int (y * fy + .5f)][int (x * fx + .5f)];
-
-            preview.r = gamma (pixel.r, m);
-            preview.g = gamma (pixel.g, m);
-            preview.b = gamma (pixel.b, m);
-            preview.a = int (
-                IMATH_NAMESPACE::clamp (pixel.a * 255.f, 0.f, 255.f) + .5f);
+            const Rgba* line =
+                &band[size_t (int (y * fy + .5f) - sy1) * size_t (w)];
+
+            for (int x = 0; x < previewWidth; ++x)
+                previewPixel (line[int (x * fx + .5f)], m, previewPixels[y][x]);
         }
+
+        y1 = y2;
     }
 }
 
+//
+// Check whether two names refer to the same existing file, even if
+// the names differ, for example "x.exr" and "./x.exr", or a link.
+//
+
+bool
+sameFile (const char fileName1[], const char fileName2[])
+{
+    std::error_code ec;
+
+    return std::filesystem::equivalent (
+        std::filesystem::path (fileName1),
+        std::filesystem::path (fileName2),
+        ec);
+}
+
 } // namespace
 
 void
@@ -116,17 +254,31 @@ makePreview (
     const char outFileName[],
     int        previewWidth,
     float      exposure,
+    int        numThreads,
     bool       verbose)
 {
+    //
+    // The output file is created while the input file is still being
+    // read, so writing over the input file would destroy it.
+    //
+
+    if (!strcmp (inFileName, outFileName) || sameFile (inFileName, outFileName))
+        throw invalid_argument ("Input and output cannot be the same file");
+
     if (verbose) cout << "generating preview image" << endl;
 
     Array2D<PreviewRgba> previewPixels;
     int                  previewHeight;
 
     generatePreview (
-        inFileName, exposure, previewWidth, previewHeight, previewPixels);
+        inFileName,
+        exposure,
+        previewWidth,
+        numThreads,
+        previewHeight,
+        previewPixels);
 
-    InputFile in (inFileName);
+    InputFile in (inFileName, numThreads);
     Header    header = in.header ();
 
     header.setPreviewImage (
@@ -137,14 +289,165 @@ makePreview (
 
     if (header.hasTileDescription ())
     {
-        TiledOutputFile out (outFileName, header);
+        TiledOutputFile out (outFileName, header, numThreads);
         out.copyPixels (in);
     }
     else
     {
-        OutputFile out (outFileName, header);
+        OutputFile out (outFileName, header, numThreads);
         out.copyPixels (in);
     }
 
     if (verbose) cout << "done." << endl;
 }
+
+namespace
+{
+
+string
+outputFileName (const string& inFileName, const string& outDir)
+{
+    size_t slash = inFileName.find_last_of ("/\\");
+
+    string base = (slash == string::npos) ? inFileName
+                                          : inFileName.substr (slash + 1);
+
+    return outDir + "/" + base;
+}
+
+//
+// A MakePreviewTask processes files, taken from a list shared with
+// the other tasks, until the list is exhausted.  The files are read
+// and written without threads of their own; the parallelism comes
+// from processing several files at once.
+//
+
+class MakePreviewTask : public ILMTHREAD_NAMESPACE::Task
+{
+public:
+    MakePreviewTask (
+        ILMTHREAD_NAMESPACE::TaskGroup* group,
+        const vector<string>&           inFileNames,
+        const string&                   outDir,
+        int                             previewWidth,
+        float                           exposure,
+        bool                            verbose,
+        std::atomic<size_t>&            nextFile,
+        std::atomic<int>&               numFailed,
+        std::mutex&                     outputMutex)
+        : Task (group)
+        , _inFileNames (inFileNames)
+        , _outDir (outDir)
+        , _previewWidth (previewWidth)
+        , _exposure (exposure)
+        , _verbose (verbose)
+        , _nextFile (nextFile)
+        , _numFailed (numFailed)
+        , _outputMutex (outputMutex)
+    {}
+
+    void execute () override
+    {
+        for (size_t i = _nextFile++; i < _inFileNames.size (); i = _nextFile++)
+        {
+            const string& inFileName  = _inFileNames[i];
+            string        outFileName = outputFileName (inFileName, _outDir);
+
+            try
+            {
+                makePreview (
+                    inFileName.c_str (),
+                    outFileName.c_str (),
+                    _previewWidth,
+                    _exposure,
+                    0,
+                    false);
+
+                if (_verbose)
+                {
+                    std::lock_guard<std::mutex> lock (_outputMutex);
+                    cout << inFileName << " -> " << outFileName << endl;
+                }
+            }
+            catch (const exception& e)
+            {
+                ++_numFailed;
+
+                std::lock_guard<std::mutex> lock (_outputMutex);
+                cerr << inFileName << ": " << e.what () << endl;
+            }
+        }
+    }
+
+private:
+    const vector<string>& _inFileNames;
+    const string&         _outDir;
+    int                   _previewWidth;
+    float                 _exposure;
+    bool                  _verbose;
+    std::atomic<size_t>&  _nextFile;
+    std::atomic<int>&     _numFailed;
+    std::mutex&           _outputMutex;
+};
+
+} // namespace
+
+int
+makePreviews (
+    const vector<string>& inFileNames,
+    const string&         outDir,
+    int                   previewWidth,
+    float                 exposure,
+    bool                  verbose)
+{
+    //
+    // Files with the same name in different directories would be
+    // saved under the same name in outDir, by concurrent threads.
+    //
+
+    map<string, string> outFileNames;
+
+    for (const string& inFileName: inFileNames)
+    {
+        string outFileName = outputFileName (inFileName, outDir);
+        auto   i           = outFileNames.insert (
+            make_pair (outFileName, inFileName));
+
+        if (!i.second)
+            throw invalid_argument (
+                "Input files " + i.first->second + " and " + inFileName +
+                " would both be saved as " + outFileName);
+    }
+
+    std::atomic<size_t> nextFile (0);
+    std::atomic<int>    numFailed (0);
+    std::mutex          outputMutex;
+
+    //
+    // Without a thread pool, the single task runs in this thread.
+    //
+
+    size_t numTasks =
+        std::min (inFileNames.size (), size_t (max (globalThreadCount (), 1)));
+
+    {
+        ILMTHREAD_NAMESPACE::TaskGroup group;
+
+        for (size_t t = 0; t < numTasks; ++t)
+        {
+            ILMTHREAD_NAMESPACE::ThreadPool::addGlobalTask (
+                new MakePreviewTask (
+                    &group,
+                    inFileNames,
+                    outDir,
+                    previewWidth,
+                    exposure,
+                    verbose,
+                    nextFile,
+                    numFailed,
+                    outputMutex));
+        }
+    }
+
+    return numFailed;
+}
@@ -12,11 +12,29 @@
 //
 //----------------------------------------------------------------------------
 
+#include <string>
+#include <vector>
+
 void makePreview (
     const char inFileName[],
     const char outFileName[],
     int        previewWidth,
     float      exposure,
+    int        numThreads,
     bool       verbose);
 
+//
+// Add preview images to many files, processing several files in
+// parallel.  Each output file is stored in directory outDir, under
+// the name of the input file.  Errors are reported on cerr; the
+// return value is the number of files that could not be processed.
+//
+
+int makePreviews (
+    const std::vector<std::string>& inFileNames,
+    const std::string&              outDir,
+    int                             previewWidth,
+    float                           exposure,
+    bool                            verbose);
+
 #endif
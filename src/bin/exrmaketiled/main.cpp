@@ -12,8 +12,10 @@
 
 #include "makeTiled.h"
 
+#include <IlmThreadPool.h>
 #include <ImfHeader.h>
 #include <ImfMisc.h>
+#include <ImfThreading.h>
 #include <OpenEXRConfig.h>
 
 #include <exception>
@@ -80,6 +82,22 @@ usageMessage (ostream& stream, const char* program_name, bool verbose = false)
             << ",\n"
                "                default is zip)\n"
                "\n"
+               "  -s            streaming mode: reads the input image a few\n"
+               "                rows at a time, and writes the tiles of all\n"
+               "                levels as soon as they are complete, so that\n"
+               "                images larger than the available memory can\n"
+               "                be converted.  The output file's line order\n"
+               "                is RANDOM_Y.  Periodic vertical extrapolation\n"
+               "                is not supported in this mode.  Without -s,\n"
+               "                the whole input image is held in memory, and\n"
+               "                the levels are computed and written one at a\n"
+               "                time, using at most about 1.75 times the size\n"
+               "                of the input image.\n"
+               "\n"
+               "  -j n          uses n threads to compress and decompress\n"
+               "                pixels (default depends on the number of\n"
+               "                processors)\n"
+               "\n"
                "  -v            verbose mode\n"
                "\n"
                "  -h, --help    print this message\n"
@@ -110,15 +128,15 @@ getCompression (const string& str)
     return c;
 }
 
-Extrapolation
+LevelWrapMode
 getExtrapolation (const string& str)
 {
-    Extrapolation e;
+    LevelWrapMode e;
 
-    if (str == "black" || str == "BLACK") { e = BLACK; }
-    else if (str == "clamp" || str == "CLAMP") { e = CLAMP; }
-    else if (str == "periodic" || str == "PERIODIC") { e = PERIODIC; }
-    else if (str == "mirror" || str == "MIRROR") { e = MIRROR; }
+    if (str == "black" || str == "BLACK") { e = WRAP_BLACK; }
+    else if (str == "clamp" || str == "CLAMP") { e = WRAP_CLAMP; }
+    else if (str == "periodic" || str == "PERIODIC") { e = WRAP_PERIODIC; }
+    else if (str == "mirror" || str == "MIRROR") { e = WRAP_MIRROR; }
     else
     {
         std::stringstream e;
@@ -153,10 +171,14 @@ main (int argc, char** argv)
     int               tileSizeX    = 64;
     int               tileSizeY    = 64;
     set<string>       doNotFilter;
-    Extrapolation     extX    = CLAMP;
-    Extrapolation     extY    = CLAMP;
+    LevelWrapMode     extX    = WRAP_CLAMP;
+    LevelWrapMode     extY    = WRAP_CLAMP;
+    bool              stream  = false;
     bool              verbose = false;
 
+    int threads =
+        ILMTHREAD_NAMESPACE::ThreadPool::estimateThreadCountForFileIO ();
+
     //
     // Parse the command line.
     //
@@ -277,6 +299,33 @@ main (int argc, char** argv)
                 compression = getCompression (argv[i + 1]);
                 i += 2;
             }
+            else if (!strcmp (argv[i], "-s"))
+            {
+                //
+                // Streaming mode
+                //
+
+                stream = true;
+                i += 1;
+            }
+            else if (!strcmp (argv[i], "-j"))
+            {
+                //
+                // Set number of threads
+                //
+
+                if (i > argc - 2)
+                    throw invalid_argument (
+                        "Missing thread count with -j option");
+
+                threads = strtol (argv[i + 1], 0, 0);
+
+                if (threads < 0)
+                    throw invalid_argument (
+                        "Thread count must not be negative");
+
+                i += 2;
+            }
             else if (!strcmp (argv[i], "-v"))
             {
                 //
@@ -360,6 +409,8 @@ main (int argc, char** argv)
                 throw invalid_argument ("Cannot make tile for deep data");
         }
 
+        setGlobalThreadCount (threads);
+
         makeTiled (
             inFile,
             outFile,
@@ -372,6 +423,7 @@ main (int argc, char** argv)
             doNotFilter,
             extX,
             extY,
+            stream,
             verbose);
     }
     catch (const exception& e)
@@ -10,15 +10,14 @@
 //----------------------------------------------------------------------------
 
 #include "makeTiled.h"
-#include "Image.h"
 
 #include "Iex.h"
-#include "ImathFun.h"
 #include "ImfChannelList.h"
 #include "ImfDeepScanLineInputPart.h"
 #include "ImfDeepScanLineOutputPart.h"
 #include "ImfDeepTiledInputPart.h"
 #include "ImfDeepTiledOutputPart.h"
+#include "ImfFlatImage.h"
 #include "ImfFrameBuffer.h"
 #include "ImfInputPart.h"
 #include "ImfMisc.h"
@@ -28,8 +27,10 @@
 #include "ImfTiledOutputPart.h"
 
 #include <algorithm>
+#include <cstring>
 #include <iostream>
 #include <map>
+#include <memory>
 #include <vector>
 
 #include "namespaceAlias.h"
@@ -41,430 +42,662 @@ namespace
 {
 
 string
-extToString (Extrapolation ext)
+extToString (LevelWrapMode ext)
 {
     string str;
 
     switch (ext)
     {
-        case BLACK: str = "black"; break;
+        case WRAP_BLACK: str = "black"; break;
 
-        case CLAMP: str = "clamp"; break;
+        case WRAP_CLAMP: str = "clamp"; break;
 
-        case PERIODIC: str = "periodic"; break;
+        case WRAP_PERIODIC: str = "periodic"; break;
 
-        case MIRROR: str = "mirror"; break;
+        case WRAP_MIRROR: str = "mirror"; break;
+
+        default: break;
     }
 
     return str;
 }
 
-int
-mirror (int x, int w)
+FrameBuffer
+levelFrameBuffer (const FlatImageLevel& level)
 {
-    int d = divp (x, w);
-    int m = modp (x, w);
-    return (d & 1) ? w - 1 - m : m;
+    FrameBuffer fb;
+
+    for (FlatImageLevel::ConstIterator i = level.begin (); i != level.end ();
+         ++i)
+        fb.insert (i.name (), i.channel ().slice ());
+
+    return fb;
 }
 
-template <class T>
-double
-sampleX (
-    const TypedImageChannel<T>& channel,
-    int                         w,
-    double                      x,
-    int                         y,
-    Extrapolation               ext)
+//
+// Levels mode: the input image is held in memory, and the other
+// levels are computed from it one at a time.  Each level is written
+// as soon as it is complete, in the order in which the levels are
+// stored in the file, and it is freed once no other level needs to
+// be computed from it.  At most about 1.75 times the input image is
+// held in memory, for any level mode.
+//
+
+std::unique_ptr<FlatImage>
+newLevelImage (
+    const FlatImage& image, const TiledOutputPart& out, int lx, int ly)
 {
-    //
-    // Sample an image channel at location (x, y), where
-    // x is a floating point number, and y is an integer.
-    //
+    const Box2i& dw = image.dataWindow ();
 
-    int    xs = IMATH_NAMESPACE::floor (x);
-    int    xt = xs + 1;
-    double s  = xt - x;
-    double t  = 1 - s;
-    double vs = 0.0;
-    double vt = 0.0;
+    std::unique_ptr<FlatImage> level (new FlatImage (
+        Box2i (
+            dw.min,
+            dw.min + V2i (out.levelWidth (lx) - 1, out.levelHeight (ly) - 1)),
+        ONE_LEVEL,
+        ROUND_DOWN));
 
-    switch (ext)
+    for (FlatImageLevel::ConstIterator i = image.level ().begin ();
+         i != image.level ().end ();
+         ++i)
+        level->insertChannel (i.name (), i.channel ().channel ());
+
+    return level;
+}
+
+void
+writeLevel (TiledOutputPart& out, const FlatImage& image, int lx, int ly)
+{
+    out.setFrameBuffer (levelFrameBuffer (image.level ()));
+    out.writeTiles (
+        0, out.numXTiles (lx) - 1, 0, out.numYTiles (ly) - 1, lx, ly);
+}
+
+void
+writeLevels (
+    std::unique_ptr<FlatImage> image,
+    TiledOutputPart&           out,
+    const LevelFilter&         filter)
+{
+    switch (out.header ().tileDescription ().mode)
     {
-        case BLACK:
+        case MIPMAP_LEVELS:
 
-            vs = (xs >= 0 && xs < w) ? double (channel (xs, y)) : 0.0;
-            vt = (xt >= 0 && xt < w) ? double (channel (xt, y)) : 0.0;
-            break;
+            //
+            // Shrink each level horizontally into a temporary
+            // image, and from there vertically into the next level.
+            //
 
-        case CLAMP:
+            writeLevel (out, *image, 0, 0);
 
-            xs = IMATH_NAMESPACE::clamp (xs, 0, w - 1);
-            xt = IMATH_NAMESPACE::clamp (xt, 0, w - 1);
-            vs = channel (xs, y);
-            vt = channel (xt, y);
-            break;
+            for (int l = 1; l < out.numLevels (); ++l)
+            {
+                std::unique_ptr<FlatImage> tmp =
+                    newLevelImage (*image, out, l, l - 1);
 
-        case PERIODIC:
+                reduceLevel (
+                    image->level (), tmp->level (), filter, true, l & 1);
+                image = newLevelImage (*tmp, out, l, l);
+                reduceLevel (
+                    tmp->level (), image->level (), filter, false, l & 1);
+
+                writeLevel (out, *image, l, l);
+            }
 
-            xs = modp (xs, w);
-            xt = modp (xt, w);
-            vs = channel (xs, y);
-            vt = channel (xt, y);
             break;
 
-        case MIRROR:
+        case RIPMAP_LEVELS:
+
+            //
+            // Shrink level (0, ly - 1) vertically into level (0, ly),
+            // and level (lx - 1, ly) horizontally into level (lx, ly).
+            //
+
+            for (int ly = 0; ly < out.numYLevels (); ++ly)
+            {
+                if (ly > 0)
+                {
+                    std::unique_ptr<FlatImage> next =
+                        newLevelImage (*image, out, 0, ly);
+
+                    reduceLevel (
+                        image->level (),
+                        next->level (),
+                        filter,
+                        false,
+                        (ly - 1) & 1);
+
+                    image = std::move (next);
+                }
+
+                writeLevel (out, *image, 0, ly);
+
+                std::unique_ptr<FlatImage> prev;
+
+                for (int lx = 1; lx < out.numXLevels (); ++lx)
+                {
+                    const FlatImage& from = prev ? *prev : *image;
+
+                    std::unique_ptr<FlatImage> next =
+                        newLevelImage (from, out, lx, ly);
+
+                    reduceLevel (
+                        from.level (),
+                        next->level (),
+                        filter,
+                        true,
+                        (lx - 1) & 1);
+
+                    writeLevel (out, *next, lx, ly);
+                    prev = std::move (next);
+                }
+            }
 
-            xs = mirror (xs, w);
-            xt = mirror (xt, w);
-            vs = channel (xs, y);
-            vt = channel (xt, y);
             break;
-    }
 
-    return s * vs + t * vt;
+        default: writeLevel (out, *image, 0, 0); break;
+    }
 }
 
-template <class T>
-double
-sampleY (
-    const TypedImageChannel<T>& channel,
-    int                         h,
-    int                         x,
-    double                      y,
-    Extrapolation               ext)
+//
+// Streaming mode: the tiles of all levels are generated from a few
+// rows of each level at a time, so that images that are too large
+// to be held in memory can be converted.
+//
+
+struct StreamChannel
 {
-    //
-    // Sample an image channel at location (x, y), where
-    // x is an integer, and y is a floating point number.
-    //
+    string    name;
+    PixelType type;
+    size_t    pixelSize;
+    bool      filter;
+};
 
-    int    ys = IMATH_NAMESPACE::floor (y);
-    int    yt = ys + 1;
-    double s  = yt - y;
-    double t  = 1 - s;
-    double vs = 0.0;
-    double vt = 0.0;
+//
+// A RowWindow holds a band of consecutive rows of one image level,
+// for all channels.  Rows are appended at the bottom, and discarded
+// at the top once they are no longer needed.  Rows are numbered
+// relative to the top of the level's data window.
+//
 
-    switch (ext)
+class RowWindow
+{
+public:
+    RowWindow (const vector<StreamChannel>& channels, int width)
+        : _channels (channels)
+        , _width (width)
+        , _data (channels.size ())
+        , _origin (0)
+        , _first (0)
+        , _end (0)
+        , _capacity (0)
+    {}
+
+    void append (int n);
+    void discard (int y) { _first = std::max (_first, std::min (y, _end)); }
+
+    char* row (size_t c, int y)
     {
-        case BLACK:
+        return &_data[c][rowBytes (c) * size_t (y - _origin)];
+    }
 
-            vs = (ys >= 0 && ys < h) ? double (channel (x, ys)) : 0.0;
-            vt = (yt >= 0 && yt < h) ? double (channel (x, yt)) : 0.0;
-            break;
+    FrameBuffer frameBuffer (const Box2i& dw, int y0, int y1);
 
-        case CLAMP:
+private:
+    size_t rowBytes (size_t c) const
+    {
+        return _channels[c].pixelSize * size_t (_width);
+    }
 
-            ys = IMATH_NAMESPACE::clamp (ys, 0, h - 1);
-            yt = IMATH_NAMESPACE::clamp (yt, 0, h - 1);
-            vs = channel (x, ys);
-            vt = channel (x, yt);
-            break;
+    const vector<StreamChannel>& _channels;
+    int                          _width;
+    vector<vector<char>>         _data;
+    int                          _origin; // row stored at the start of _data
+    int                          _first;  // first row still needed
+    int                          _end;    // one past the last row
+    int                          _capacity;
+};
 
-        case PERIODIC:
+void
+RowWindow::append (int n)
+{
+    if (_end + n - _origin > _capacity && _first > _origin)
+    {
+        //
+        // Move the rows that are still needed to the start of the window.
+        //
 
-            ys = modp (ys, h);
-            yt = modp (yt, h);
-            vs = channel (x, ys);
-            vt = channel (x, yt);
-            break;
+        for (size_t c = 0; c < _data.size (); ++c)
+        {
+            memmove (
+                &_data[c][0],
+                row (c, _first),
+                rowBytes (c) * size_t (_end - _first));
+        }
 
-        case MIRROR:
+        _origin = _first;
+    }
 
-            ys = mirror (ys, h);
-            yt = mirror (yt, h);
-            vs = channel (x, ys);
-            vt = channel (x, yt);
-            break;
+    if (_end + n - _origin > _capacity)
+    {
+        _capacity = std::max (2 * _capacity, _end + n - _origin);
+
+        for (size_t c = 0; c < _data.size (); ++c)
+            _data[c].resize (rowBytes (c) * size_t (_capacity));
     }
 
-    return s * vs + t * vt;
+    _end += n;
 }
 
-template <class T>
-T
-filterX (
-    const TypedImageChannel<T>& channel,
-    int                         w,
-    double                      x,
-    int                         y,
-    Extrapolation               ext)
+FrameBuffer
+RowWindow::frameBuffer (const Box2i& dw, int y0, int y1)
 {
-    //
-    // Horizontal four-tap filter, centered on pixel (x + 0.5, y)
-    //
+    FrameBuffer fb;
 
-    return T (
-        0.125 * sampleX (channel, w, x - 1, y, ext) +
-        0.375 * sampleX (channel, w, x, y, ext) +
-        0.375 * sampleX (channel, w, x + 1, y, ext) +
-        0.125 * sampleX (channel, w, x + 2, y, ext));
+    for (size_t c = 0; c < _channels.size (); ++c)
+    {
+        fb.insert (
+            _channels[c].name,
+            Slice::Make (
+                _channels[c].type,
+                row (c, y0),
+                V2i (dw.min.x, dw.min.y + y0),
+                _width,
+                y1 - y0,
+                _channels[c].pixelSize,
+                rowBytes (c)));
+    }
+
+    return fb;
 }
 
 template <class T>
-T
-filterY (
-    const TypedImageChannel<T>& channel,
-    int                         h,
-    int                         x,
-    double                      y,
-    Extrapolation               ext)
+void
+reduceRow (
+    const LevelReducer&    reducer,
+    const char*            src,
+    char*                  dst,
+    LevelReducer::Scratch& scratch)
 {
-    //
-    // Vertical four-tap filter, centered on pixel (x, y + 0.5)
-    //
-
-    return T (
-        0.125 * sampleY (channel, h, x, y - 1, ext) +
-        0.375 * sampleY (channel, h, x, y, ext) +
-        0.375 * sampleY (channel, h, x, y + 1, ext) +
-        0.125 * sampleY (channel, h, x, y + 2, ext));
+    reducer.reduceRow ((const T*) src, (T*) dst, scratch);
 }
 
 template <class T>
 void
-reduceX (
-    const TypedImageChannel<T>& channel0,
-    TypedImageChannel<T>&       channel1,
-    bool                        filter,
-    Extrapolation&              ext,
-    bool                        odd)
+reduceRows (
+    const LevelReducer&    reducer,
+    int                    i,
+    const char* const      rows[],
+    char*                  dst,
+    int                    width,
+    LevelReducer::Scratch& scratch)
+{
+    const T* typedRows[LevelReducer::NUM_TAPS];
+
+    for (int k = 0; k < LevelReducer::NUM_TAPS; ++k)
+        typedRows[k] = (const T*) rows[k];
+
+    reducer.reduceRows (i, typedRows, (T*) dst, width, scratch);
+}
+
+//
+// A StreamLevel generates the rows of one level of the output image
+// as the rows of the level that it is computed from become available,
+// and writes each row of tiles as soon as it is complete.  A level is
+// computed from its parent level the same way as in
+// FlatImage::generateLevels(): by shrinking the parent horizontally,
+// vertically, or first horizontally and then vertically.
+//
+
+class StreamLevel
 {
+public:
+    StreamLevel (
+        TiledOutputPart&             out,
+        const vector<StreamChannel>& channels,
+        int                          lx,
+        int                          ly,
+        StreamLevel*                 parent,
+        bool                         shrinkX,
+        bool                         shrinkY,
+        const LevelFilter&           filter,
+        bool                         odd);
+
     //
-    // Shrink an image channel, channel0, horizontally
-    // by a factor of 2, and store the result in channel1.
+    // Read all rows of the level from an input part; only for
+    // level (0, 0).
     //
 
-    int w0 = channel0.image ().width ();
-    int w1 = channel1.image ().width ();
-    int h1 = channel1.image ().height ();
+    void readRows (InputPart& in);
+
+private:
+    void parentRowAdded (int y);
+    void computeRow (int i);
+    void rowsAdded (int y0, int y1);
+
+    TiledOutputPart&             _out;
+    const vector<StreamChannel>& _channels;
+    int                          _lx;
+    int                          _ly;
+    Box2i                        _dw;
+    int                          _width;
+    int                          _height;
+    StreamLevel*                 _parent;
+    vector<StreamLevel*>         _children;
+    bool                         _shrinkX;
+    bool                         _shrinkY;
+    RowWindow                    _rows;
+    RowWindow                    _src; // horizontally shrunk parent rows
+    int                          _nextTileRow;
+    int                          _nextRow;
+
+    std::unique_ptr<LevelReducer> _filteredX;
+    std::unique_ptr<LevelReducer> _skippedX;
+    std::unique_ptr<LevelReducer> _filteredY;
+    std::unique_ptr<LevelReducer> _skippedY;
+    LevelReducer::Scratch         _scratch;
+
+    vector<int> _lastNeeded;  // last parent row needed for row i
+    vector<int> _firstNeeded; // first parent row needed for rows >= i
+};
+
+StreamLevel::StreamLevel (
+    TiledOutputPart&             out,
+    const vector<StreamChannel>& channels,
+    int                          lx,
+    int                          ly,
+    StreamLevel*                 parent,
+    bool                         shrinkX,
+    bool                         shrinkY,
+    const LevelFilter&           filter,
+    bool                         odd)
+    : _out (out)
+    , _channels (channels)
+    , _lx (lx)
+    , _ly (ly)
+    , _dw (out.dataWindowForLevel (lx, ly))
+    , _width (out.levelWidth (lx))
+    , _height (out.levelHeight (ly))
+    , _parent (parent)
+    , _shrinkX (shrinkX)
+    , _shrinkY (shrinkY)
+    , _rows (channels, _width)
+    , _src (channels, _width)
+    , _nextTileRow (0)
+    , _nextRow (0)
+{
+    if (!parent) return;
 
-    if (filter)
+    parent->_children.push_back (this);
+
+    if (shrinkX)
     {
-        //
-        // Low-pass filter and resample.
-        // For pixels (0, y) and (w1 - 1, y) in channel 1,
-        // the low-pass filter in channel0 is centered on
-        // pixels (0.5, y) and (w0 - 1.5, y) respectively.
-        //
+        int n0 = parent->_width;
+
+        _filteredX.reset (
+            new LevelReducer (n0, _width, true, filter.wrapX, odd));
+        _skippedX.reset (
+            new LevelReducer (n0, _width, false, filter.wrapX, odd));
+    }
+
+    if (shrinkY)
+    {
+        int n0 = parent->_height;
+
+        _filteredY.reset (
+            new LevelReducer (n0, _height, true, filter.wrapY, odd));
+        _skippedY.reset (
+            new LevelReducer (n0, _height, false, filter.wrapY, odd));
+
+        _lastNeeded.resize (_height);
+        _firstNeeded.resize (_height);
 
-        double f = (w1 > 1) ? double (w0 - 2) / (w1 - 1) : 1;
+        for (int i = 0; i < _height; ++i)
+        {
+            _lastNeeded[i] = std::max (
+                _filteredY->lastIndex (i), _skippedY->lastIndex (i));
+            _firstNeeded[i] = std::min (
+                _filteredY->firstIndex (i), _skippedY->firstIndex (i));
+        }
 
-        for (int y = 0; y < h1; ++y)
-            for (int x = 0; x < w1; ++x)
-                channel1 (x, y) = filterX (channel0, w0, x * f, y, ext);
+        for (int i = _height - 2; i >= 0; --i)
+            _firstNeeded[i] = std::min (_firstNeeded[i], _firstNeeded[i + 1]);
     }
-    else
+}
+
+void
+StreamLevel::readRows (InputPart& in)
+{
+    int tileHeight = _out.tileYSize ();
+
+    for (int y0 = 0; y0 < _height; y0 += tileHeight)
     {
-        //
-        // Resample, skipping every other pixel, without
-        // low-pass filtering.  In order to keep the image
-        // from sliding to the right if the channel is
-        // resampled repeatedly, we skip the rightmost
-        // pixel of every row on even passes, and the
-        // leftmost pixel on odd passes.
-        //
+        int y1 = std::min (y0 + tileHeight, _height);
 
-        int offset = odd ? ((w0 - 1) - 2 * (w1 - 1)) : 0;
+        _rows.append (y1 - y0);
+        in.setFrameBuffer (_rows.frameBuffer (_dw, y0, y1));
+        in.readPixels (_dw.min.y + y0, _dw.min.y + y1 - 1);
 
-        for (int y = 0; y < h1; ++y)
-            for (int x = 0; x < w1; ++x)
-                channel1 (x, y) = channel0 (2 * x + offset, y);
+        rowsAdded (y0, y1);
     }
 }
 
-template <class T>
 void
-reduceY (
-    const TypedImageChannel<T>& channel0,
-    TypedImageChannel<T>&       channel1,
-    bool                        filter,
-    Extrapolation               ext,
-    bool                        odd)
+StreamLevel::parentRowAdded (int y)
 {
     //
-    // Shrink an image channel, channel0, vertically
-    // by a factor of 2, and store the result in channel1.
+    // Shrink the new parent row horizontally, or copy it, either
+    // directly into this level or into the window of rows that are
+    // shrunk vertically next.
     //
 
-    int w1 = channel1.image ().width ();
-    int h0 = channel0.image ().height ();
-    int h1 = channel1.image ().height ();
+    RowWindow& dst = _shrinkY ? _src : _rows;
+
+    dst.append (1);
 
-    if (filter)
+    for (size_t c = 0; c < _channels.size (); ++c)
     {
-        //
-        // Low-pass filter and resample.
-        // For pixels (x, 0) and (x, h1 - 1) in channel 1,
-        // the low-pass filter in channel0 is centered on
-        // pixels (x, 0.5) and (x, h0 - 1.5) respectively.
-        //
+        const char* s = _parent->_rows.row (c, y);
+        char*       d = dst.row (c, y);
 
-        double f = (h1 > 1) ? double (h0 - 2) / (h1 - 1) : 1;
+        if (!_shrinkX)
+        {
+            memcpy (d, s, _channels[c].pixelSize * size_t (_width));
+            continue;
+        }
+
+        const LevelReducer& reducer =
+            _channels[c].filter ? *_filteredX : *_skippedX;
 
-        for (int y = 0; y < h1; ++y)
-            for (int x = 0; x < w1; ++x)
-                channel1 (x, y) = filterY (channel0, h0, x, y * f, ext);
+        switch (_channels[c].type)
+        {
+            case HALF: reduceRow<half> (reducer, s, d, _scratch); break;
+            case FLOAT: reduceRow<float> (reducer, s, d, _scratch); break;
+            case UINT:
+                reduceRow<unsigned int> (reducer, s, d, _scratch);
+                break;
+            default: throw IEX_NAMESPACE::ArgExc ("Unknown pixel type.");
+        }
     }
-    else
+
+    if (!_shrinkY)
     {
-        //
-        // Resample, skipping every other pixel, without
-        // low-pass filtering.  In order to keep the image
-        // from sliding towards the top if the channel is
-        // resampled repeatedly, we skip the top pixel of
-        // every column on even passes, and the bottom pixel
-        // on odd passes.
-        //
+        rowsAdded (y, y + 1);
+        return;
+    }
+
+    //
+    // Compute all rows whose source rows are now available, and
+    // discard the source rows that no later row needs.
+    //
 
-        int offset = odd ? ((h0 - 1) - 2 * (h1 - 1)) : 0;
+    int y0 = _nextRow;
 
-        for (int y = 0; y < h1; ++y)
-            for (int x = 0; x < w1; ++x)
-                channel1 (x, y) = channel0 (x, 2 * y + offset);
-    }
+    while (_nextRow < _height && _lastNeeded[_nextRow] <= y)
+        computeRow (_nextRow++);
+
+    if (_nextRow < _height) _src.discard (_firstNeeded[_nextRow]);
+
+    if (_nextRow > y0) rowsAdded (y0, _nextRow);
 }
 
 void
-reduceX (
-    const ChannelList& channels,
-    const set<string>& doNotFilter,
-    Extrapolation      ext,
-    bool               odd,
-    const Image&       image0,
-    Image&             image1)
+StreamLevel::computeRow (int i)
 {
-    //
-    // Shrink image image0 horizontally by a factor of 2,
-    // and store the result in image image1.
-    //
+    _rows.append (1);
 
-    for (ChannelList::ConstIterator i = channels.begin (); i != channels.end ();
-         ++i)
+    for (size_t c = 0; c < _channels.size (); ++c)
     {
-        const char*    name    = i.name ();
-        const Channel& channel = i.channel ();
-        bool           filter = (doNotFilter.find (name) == doNotFilter.end ());
+        const LevelReducer& reducer =
+            _channels[c].filter ? *_filteredY : *_skippedY;
+
+        const char* rows[LevelReducer::NUM_TAPS];
 
-        switch (channel.type)
+        for (int k = 0; k < LevelReducer::NUM_TAPS; ++k)
         {
-            case IMF::HALF:
-
-                reduceX (
-                    image0.typedChannel<half> (name),
-                    image1.typedChannel<half> (name),
-                    filter,
-                    ext,
-                    odd);
-                break;
+            rows[k] = (reducer.weight (i, k) != 0)
+                          ? _src.row (c, reducer.index (i, k))
+                          : 0;
+        }
 
-            case IMF::FLOAT:
+        char* d = _rows.row (c, i);
 
-                reduceX (
-                    image0.typedChannel<float> (name),
-                    image1.typedChannel<float> (name),
-                    filter,
-                    ext,
-                    odd);
+        switch (_channels[c].type)
+        {
+            case HALF:
+                reduceRows<half> (reducer, i, rows, d, _width, _scratch);
                 break;
-
-            case IMF::UINT:
-
-                reduceX (
-                    image0.typedChannel<unsigned int> (name),
-                    image1.typedChannel<unsigned int> (name),
-                    filter,
-                    ext,
-                    odd);
+            case FLOAT:
+                reduceRows<float> (reducer, i, rows, d, _width, _scratch);
+                break;
+            case UINT:
+                reduceRows<unsigned int> (
+                    reducer, i, rows, d, _width, _scratch);
                 break;
-            default: break;
+            default: throw IEX_NAMESPACE::ArgExc ("Unknown pixel type.");
         }
     }
 }
 
 void
-reduceY (
-    const ChannelList& channels,
-    const set<string>& doNotFilter,
-    Extrapolation      ext,
-    bool               odd,
-    const Image&       image0,
-    Image&             image1)
+StreamLevel::rowsAdded (int y0, int y1)
 {
+    for (int y = y0; y < y1; ++y)
+        for (size_t i = 0; i < _children.size (); ++i)
+            _children[i]->parentRowAdded (y);
+
     //
-    // Shrink image image0 vertically by a factor of 2,
-    // and store the result in image image1.
+    // Write the rows of tiles that are now complete; the tiles
+    // of each row are compressed in parallel.
     //
 
-    for (ChannelList::ConstIterator i = channels.begin (); i != channels.end ();
-         ++i)
-    {
-        const char*    name    = i.name ();
-        const Channel& channel = i.channel ();
-        bool           filter = (doNotFilter.find (name) == doNotFilter.end ());
-
-        switch (channel.type)
-        {
-            case IMF::HALF:
-
-                reduceY (
-                    image0.typedChannel<half> (name),
-                    image1.typedChannel<half> (name),
-                    filter,
-                    ext,
-                    odd);
-                break;
+    int tileHeight = _out.tileYSize ();
 
-            case IMF::FLOAT:
+    while (_nextTileRow < _out.numYTiles (_ly) &&
+           std::min ((_nextTileRow + 1) * tileHeight, _height) <= y1)
+    {
+        int begin = _nextTileRow * tileHeight;
+        int end   = std::min (begin + tileHeight, _height);
 
-                reduceY (
-                    image0.typedChannel<float> (name),
-                    image1.typedChannel<float> (name),
-                    filter,
-                    ext,
-                    odd);
-                break;
+        _out.setFrameBuffer (_rows.frameBuffer (_dw, begin, end));
 
-            case IMF::UINT:
+        _out.writeTiles (
+            0,
+            _out.numXTiles (_lx) - 1,
+            _nextTileRow,
+            _nextTileRow,
+            _lx,
+            _ly);
 
-                reduceY (
-                    image0.typedChannel<unsigned int> (name),
-                    image1.typedChannel<unsigned int> (name),
-                    filter,
-                    ext,
-                    odd);
-                break;
-            default: break;
-        }
+        _rows.discard (end);
+        ++_nextTileRow;
     }
 }
 
 void
-storeLevel (
-    TiledOutputPart&   out,
-    const ChannelList& channels,
-    int                lx,
-    int                ly,
-    const Image&       image)
+streamLevels (InputPart& in, TiledOutputPart& out, const LevelFilter& filter)
 {
+    vector<StreamChannel> channels;
+    const ChannelList&    cl = out.header ().channels ();
+
+    for (ChannelList::ConstIterator i = cl.begin (); i != cl.end (); ++i)
+    {
+        StreamChannel c;
+        c.name      = i.name ();
+        c.type      = i.channel ().type;
+        c.pixelSize = pixelTypeSize (c.type);
+        c.filter =
+            filter.doNotFilter.find (c.name) == filter.doNotFilter.end ();
+        channels.push_back (c);
+    }
+
     //
-    // Store the pixels for level (lx, ly) in output file out.
+    // Set up the levels, each one connected to the level
+    // that it is computed from.
     //
 
-    FrameBuffer fb;
+    vector<std::unique_ptr<StreamLevel>> levels;
 
-    for (ChannelList::ConstIterator i = channels.begin (); i != channels.end ();
-         ++i)
+    switch (out.header ().tileDescription ().mode)
     {
-        const char* name = i.name ();
-        fb.insert (name, image.channel (name).slice ());
-    }
+        case MIPMAP_LEVELS:
+
+            for (int l = 0; l < out.numLevels (); ++l)
+            {
+                StreamLevel* parent = l ? levels[l - 1].get () : 0;
+
+                levels.emplace_back (new StreamLevel (
+                    out, channels, l, l, parent, true, true, filter, l & 1));
+            }
+
+            break;
+
+        case RIPMAP_LEVELS:
+        {
+            int nx = out.numXLevels ();
+
+            for (int ly = 0; ly < out.numYLevels (); ++ly)
+            {
+                for (int lx = 0; lx < nx; ++lx)
+                {
+                    StreamLevel* parent = 0;
+                    bool         odd    = false;
+
+                    if (lx > 0)
+                    {
+                        parent = levels[ly * nx + lx - 1].get ();
+                        odd    = (lx - 1) & 1;
+                    }
+                    else if (ly > 0)
+                    {
+                        parent = levels[(ly - 1) * nx].get ();
+                        odd    = (ly - 1) & 1;
+                    }
+
+                    levels.emplace_back (new StreamLevel (
+                        out,
+                        channels,
+                        lx,
+                        ly,
+                        parent,
+                        lx > 0,
+                        lx == 0 && ly > 0,
+                        filter,
+                        odd));
+                }
+            }
+
+            break;
+        }
 
-    out.setFrameBuffer (fb);
+        default:
 
-    for (int y = 0; y < out.numYTiles (ly); ++y)
-        for (int x = 0; x < out.numXTiles (lx); ++x)
-            out.writeTile (x, y, lx, ly);
+            levels.emplace_back (new StreamLevel (
+                out, channels, 0, 0, 0, false, false, filter, false));
+
+            break;
+    }
+
+    levels[0]->readRows (in);
 }
 
 } // namespace
@@ -480,16 +713,14 @@ makeTiled (
     int                tileSizeX,
     int                tileSizeY,
     const set<string>& doNotFilter,
-    Extrapolation      extX,
-    Extrapolation      extY,
+    LevelWrapMode      extX,
+    LevelWrapMode      extY,
+    bool               stream,
     bool               verbose)
 {
-    Image          image0;
-    Image          image1;
-    Image          image2;
-    Header         header;
-    FrameBuffer    fb;
-    vector<Header> headers;
+    std::unique_ptr<FlatImage> image (new FlatImage);
+    Header                     header;
+    vector<Header>             headers;
 
     //
     // Load the input image
@@ -520,7 +751,20 @@ makeTiled (
                     "Use exrenvmap instead.");
             }
 
-            image0.resize (header.dataWindow ());
+            if (stream && mode != ONE_LEVEL && extY == WRAP_PERIODIC)
+            {
+                //
+                // Periodic extrapolation would make the top rows
+                // of every level depend on the bottom rows.
+                //
+
+                throw IEX_NAMESPACE::ArgExc (
+                    "Streaming mode cannot extrapolate images "
+                    "periodically in the vertical direction.");
+            }
+
+            if (!stream)
+                image->resize (header.dataWindow (), ONE_LEVEL, ROUND_DOWN);
 
             for (ChannelList::ConstIterator i = header.channels ().begin ();
                  i != header.channels ().end ();
@@ -536,15 +780,15 @@ makeTiled (
                         "not supported in tiled files.");
                 }
 
-                image0.addChannel (name, channel.type);
-                image1.addChannel (name, channel.type);
-                image2.addChannel (name, channel.type);
-                fb.insert (name, image0.channel (name).slice ());
+                if (!stream) image->insertChannel (name, channel);
             }
 
-            in.setFrameBuffer (fb);
-            in.readPixels (
-                header.dataWindow ().min.y, header.dataWindow ().max.y);
+            if (!stream)
+            {
+                in.setFrameBuffer (levelFrameBuffer (image->level ()));
+                in.readPixels (
+                    header.dataWindow ().min.y, header.dataWindow ().max.y);
+            }
 
             //
             // Generate the header for the output file by modifying
@@ -554,8 +798,15 @@ makeTiled (
             header.setTileDescription (
                 TileDescription (tileSizeX, tileSizeY, mode, roundingMode));
 
+            //
+            // In streaming mode, the tiles of all levels are written
+            // interleaved, as soon as they are complete; with any
+            // other line order, the library would have to hold them
+            // in memory until they can be written in order.
+            //
+
             header.compression () = compression;
-            header.lineOrder ()   = INCREASING_Y;
+            header.lineOrder ()   = stream ? RANDOM_Y : INCREASING_Y;
 
             if (mode != ONE_LEVEL)
                 addWrapmodes (
@@ -578,7 +829,8 @@ makeTiled (
     }
 
     //
-    // Store the highest-resolution level of the image in the output file
+    // Generate the lower-resolution mipmap or ripmap levels, if
+    // necessary, and store all levels of the image in the output file
     //
 
     MultiPartOutputFile output (outFileName, &headers[0], headers.size ());
@@ -590,108 +842,24 @@ makeTiled (
             try
             {
                 TiledOutputPart out (output, partnum);
-                //    TiledOutputFile out (outFileName, header);
-
-                out.setFrameBuffer (fb);
-
-                if (verbose)
-                    cout << "writing file " << outFileName
-                         << "\n"
-                            "level (0, 0)"
-                         << endl;
+                LevelFilter     filter (extX, extY);
 
-                for (int y = 0; y < out.numYTiles (0); ++y)
-                    for (int x = 0; x < out.numXTiles (0); ++x)
-                        out.writeTile (x, y, 0);
-
-                //
-                // If necessary, generate the lower-resolution mipmap
-                // or ripmap levels, and store them in the output file.
-                //
+                filter.doNotFilter = doNotFilter;
 
-                if (mode == MIPMAP_LEVELS)
+                if (stream)
                 {
-                    for (int l = 1; l < out.numLevels (); ++l)
-                    {
-                        image1.resize (out.dataWindowForLevel (l, l - 1));
-
-                        reduceX (
-                            header.channels (),
-                            doNotFilter,
-                            extX,
-                            l & 1,
-                            image0,
-                            image1);
-
-                        image0.resize (out.dataWindowForLevel (l, l));
-
-                        reduceY (
-                            header.channels (),
-                            doNotFilter,
-                            extY,
-                            l & 1,
-                            image1,
-                            image0);
-
-                        if (verbose)
-                            cout << "level (" << l << ", " << l << ")" << endl;
-
-                        storeLevel (out, header.channels (), l, l, image0);
-                    }
-                }
+                    if (verbose)
+                        cout << "streaming to file " << outFileName << endl;
 
-                if (mode == RIPMAP_LEVELS)
+                    InputPart in (input, partnum);
+                    streamLevels (in, out, filter);
+                }
+                else
                 {
-                    Image* iptr0 = &image0;
-                    Image* iptr1 = &image1;
-                    Image* iptr2 = &image2;
+                    if (verbose)
+                        cout << "writing file " << outFileName << endl;
 
-                    for (int ly = 0; ly < out.numYLevels (); ++ly)
-                    {
-                        if (ly < out.numYLevels () - 1)
-                        {
-                            iptr2->resize (out.dataWindowForLevel (0, ly + 1));
-
-                            reduceY (
-                                header.channels (),
-                                doNotFilter,
-                                extY,
-                                ly & 1,
-                                *iptr0,
-                                *iptr2);
-                        }
-
-                        for (int lx = 0; lx < out.numXLevels (); ++lx)
-                        {
-                            if (lx != 0 || ly != 0)
-                            {
-                                if (verbose)
-                                    cout << "level (" << lx << ", " << ly << ")"
-                                         << endl;
-
-                                storeLevel (
-                                    out, header.channels (), lx, ly, *iptr0);
-                            }
-
-                            if (lx < out.numXLevels () - 1)
-                            {
-                                iptr1->resize (
-                                    out.dataWindowForLevel (lx + 1, ly));
-
-                                reduceX (
-                                    header.channels (),
-                                    doNotFilter,
-                                    extX,
-                                    lx & 1,
-                                    *iptr0,
-                                    *iptr1);
-
-                                swap (iptr0, iptr1);
-                            }
-                        }
-
-                        swap (iptr2, iptr0);
-                    }
+                    writeLevels (std::move (image), out, filter);
                 }
             }
             catch (const exception& e)
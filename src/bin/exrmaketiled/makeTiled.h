@@ -13,6 +13,7 @@
 //----------------------------------------------------------------------------
 
 #include <ImfCompression.h>
+#include <ImfLevelFilter.h>
 #include <ImfMultiPartInputFile.h>
 #include <ImfMultiPartOutputFile.h>
 #include <ImfPartType.h>
@@ -24,14 +25,6 @@
 
 #include "namespaceAlias.h"
 
-enum Extrapolation
-{
-    BLACK,
-    CLAMP,
-    PERIODIC,
-    MIRROR
-};
-
 void makeTiled (
     const char                   inFileName[],
     const char                   outFileName[],
@@ -42,8 +35,9 @@ void makeTiled (
     int                          tileSizeX,
     int                          tileSizeY,
     const std::set<std::string>& doNotFilter,
-    Extrapolation                extX,
-    Extrapolation                extY,
+    IMF::LevelWrapMode           extX,
+    IMF::LevelWrapMode           extY,
+    bool                         stream,
     bool                         verbose);
 
 #endif
@@ -6,6 +6,7 @@
 
 #include "exrmetrics.h"
 
+#include "IlmThreadPool.h"
 #include "ImfChannelList.h"
 #include "ImfDeepFrameBuffer.h"
 #include "ImfDeepScanLineInputPart.h"
@@ -13,24 +14,31 @@
 #include "ImfDeepTiledInputPart.h"
 #include "ImfDeepTiledOutputPart.h"
 #include "ImfHeader.h"
-#include "ImfInputPart.h"
 #include "ImfMisc.h"
 #include "ImfMultiPartInputFile.h"
 #include "ImfMultiPartOutputFile.h"
-#include "ImfOutputPart.h"
 #include "ImfPartType.h"
-#include "ImfTiledInputPart.h"
-#include "ImfTiledMisc.h"
-#include "ImfTiledOutputPart.h"
+#include "ImfThreading.h"
 
+#include <openexr.h>
+
+#include <algorithm>
 #include <chrono>
 #include <ctime>
-#include <list>
+#include <exception>
+#include <iostream>
+#include <math.h>
+#include <memory>
+#include <mutex>
+#include <sstream>
 #include <stdexcept>
+#include <stdio.h>
+#include <string.h>
 #include <vector>
 #include <sys/stat.h>
 
 using namespace Imf;
+using namespace IlmThread;
 using Imath::Box2i;
 
 using std::cerr;
@@ -38,12 +46,19 @@ using namespace std::chrono;
 using std::chrono::steady_clock;
 using std::cout;
 using std::endl;
-using std::list;
+using std::exception_ptr;
+using std::lock_guard;
+using std::mutex;
+using std::ostream;
+using std::ostringstream;
 using std::runtime_error;
 using std::string;
 using std::to_string;
 using std::vector;
 
+namespace
+{
+
 double
 timing (steady_clock::time_point start, steady_clock::time_point end)
 {
@@ -63,197 +78,797 @@ channelCount (const Header& h)
     return channels;
 }
 
+//
+// The stages of copying a part.  The times of the stages from READ_IO
+// to WRITE_IO are added up over all threads; READ, WRITE and TOTAL are
+// the elapsed times of reading and writing the whole part.  Deep parts
+// are copied with the C++ library, which only reports READ, WRITE and
+// TOTAL.
+//
+
+enum Stage
+{
+    READ_IO,
+    DECOMPRESS,
+    UNPACK,
+    PACK,
+    COMPRESS,
+    WRITE_IO,
+    READ,
+    WRITE,
+    TOTAL,
+    NUM_STAGES
+};
+
+const char* const stageNames[NUM_STAGES] = {
+    "read I/O time",
+    "decompress time",
+    "unpack time",
+    "pack time",
+    "compress time",
+    "write I/O time",
+    "read time",
+    "write time",
+    "total time"};
+
+struct Times
+{
+    double t[NUM_STAGES];
+
+    Times () { std::fill (t, t + NUM_STAGES, 0.0); }
+
+    void add (const Times& other)
+    {
+        for (int s = 0; s < NUM_STAGES; ++s)
+            t[s] += other.t[s];
+    }
+};
+
+//
+// Adds the time between its construction and its destruction
+// to one stage.
+//
+
+class StageTimer
+{
+public:
+    StageTimer (Times& times, Stage stage)
+        : _times (times), _stage (stage), _start (steady_clock::now ())
+    {}
+
+    ~StageTimer ()
+    {
+        _times.t[_stage] += timing (_start, steady_clock::now ());
+    }
+
+private:
+    Times&                   _times;
+    Stage                    _stage;
+    steady_clock::time_point _start;
+};
+
+//
+// Size of a part's pixels, for the report.
+//
+
+struct PartSize
+{
+    uint64_t pixelCount = 0;
+    uint64_t rawSize    = 0;
+    int      tileCount  = 0;
+};
+
 void
-copyScanLine (InputPart& in, OutputPart& out)
+check (exr_result_t rv, const char what[])
 {
-    Box2i    dw        = in.header ().dataWindow ();
-    uint64_t width     = dw.max.x + 1 - dw.min.x;
-    uint64_t height    = dw.max.y + 1 - dw.min.y;
-    uint64_t numPixels = width * height;
-    int      numChans  = channelCount (in.header ());
+    if (rv != EXR_ERR_SUCCESS)
+        throw runtime_error (
+            string (what) + ": " + exr_get_default_error_message (rv));
+}
 
-    vector<vector<char>> pixelData (numChans);
-    uint64_t offsetToOrigin = width * static_cast<uint64_t> (dw.min.y) +
-                              static_cast<uint64_t> (dw.min.x);
+//
+// The pixels of all levels of a flat part, one plane per channel,
+// in the pixel types of the output file.  The chunks are listed in
+// the order in which the Core library expects them to be written;
+// in scan line parts, the chunks of the input and of the output
+// file differ if the number of scan lines per chunk changes.
+//
 
-    int         channelNumber = 0;
-    int         pixelSize     = 0;
-    FrameBuffer buf;
+struct Chunk
+{
+    int y;     // first scan line of a scan line chunk
+    int tx;    // tile coordinates of a tile
+    int ty;
+    int level; // index in FlatImage::levels
+};
 
-    for (ChannelList::ConstIterator i = out.header ().channels ().begin ();
-         i != out.header ().channels ().end ();
+struct Level
+{
+    int                  lx;
+    int                  ly;
+    int                  width;
+    int                  height;
+    vector<vector<char>> planes;
+};
+
+struct FlatImage
+{
+    bool                     tiled = false;
+    Box2i                    dataWindow;
+    uint32_t                 tileXSize = 0;
+    uint32_t                 tileYSize = 0;
+    vector<string>           names;
+    vector<exr_pixel_type_t> types;
+    vector<int>              sizes;
+    vector<Level>            levels;
+    vector<Chunk>            tiles;
+
+    uint8_t* pointer (const Chunk& c, int channel, int startY)
+    {
+        Level&  l = levels[c.level];
+        int64_t x = tiled ? int64_t (c.tx) * tileXSize : 0;
+        int64_t y =
+            tiled ? int64_t (c.ty) * tileYSize : int64_t (startY) -
+                                                     dataWindow.min.y;
+
+        return reinterpret_cast<uint8_t*> (l.planes[channel].data ()) +
+               (y * l.width + x) * sizes[channel];
+    }
+};
+
+void
+setupImage (
+    exr_const_context_t f, int part, const Header& outHeader, FlatImage& img)
+{
+    img.tiled      = outHeader.hasTileDescription ();
+    img.dataWindow = outHeader.dataWindow ();
+
+    for (ChannelList::ConstIterator i = outHeader.channels ().begin ();
+         i != outHeader.channels ().end ();
          ++i)
     {
-        int samplesize = pixelTypeSize (i.channel ().type);
-        pixelData[channelNumber].resize (numPixels * samplesize);
+        if (i.channel ().xSampling != 1 || i.channel ().ySampling != 1)
+            throw runtime_error (
+                "exrmetrics does not support subsampled channels");
 
-        buf.insert (
-            i.name (),
-            Slice (
-                i.channel ().type,
-                pixelData[channelNumber].data () - offsetToOrigin * samplesize,
-                samplesize,
-                samplesize * width));
-        ++channelNumber;
-        pixelSize += samplesize;
+        img.names.push_back (i.name ());
+        img.types.push_back (exr_pixel_type_t (i.channel ().type));
+        img.sizes.push_back (pixelTypeSize (i.channel ().type));
+    }
+
+    if (!img.tiled)
+    {
+        Level l;
+        l.lx     = 0;
+        l.ly     = 0;
+        l.width  = img.dataWindow.max.x - img.dataWindow.min.x + 1;
+        l.height = img.dataWindow.max.y - img.dataWindow.min.y + 1;
+        img.levels.push_back (l);
     }
+    else
+    {
+        exr_tile_level_mode_t mode;
+        exr_tile_round_mode_t round;
+        int32_t               numXLevels, numYLevels;
+
+        check (
+            exr_get_tile_descriptor (
+                f, part, &img.tileXSize, &img.tileYSize, &mode, &round),
+            "Cannot read tile description");
+        check (
+            exr_get_tile_levels (f, part, &numXLevels, &numYLevels),
+            "Cannot read tile levels");
+
+        //
+        // Levels and tiles in the order of the chunks in a file.
+        //
+
+        for (int ly = 0; ly < numYLevels; ++ly)
+        {
+            for (int lx = 0; lx < numXLevels; ++lx)
+            {
+                if (mode != EXR_TILE_RIPMAP_LEVELS && lx != ly) continue;
 
-    in.setFrameBuffer (buf);
-    out.setFrameBuffer (buf);
+                Level   l;
+                int32_t countX, countY;
 
-    steady_clock::time_point startRead = steady_clock::now();
-    in.readPixels (dw.min.y, dw.max.y);
-    steady_clock::time_point endRead = steady_clock::now();
+                l.lx = lx;
+                l.ly = ly;
 
-    steady_clock::time_point startWrite = steady_clock::now();
-    out.writePixels (height);
-    steady_clock::time_point endWrite = steady_clock::now();
+                check (
+                    exr_get_level_sizes (f, part, lx, ly, &l.width, &l.height),
+                    "Cannot read level size");
+                check (
+                    exr_get_tile_counts (f, part, lx, ly, &countX, &countY),
+                    "Cannot read tile count");
+
+                for (int ty = 0; ty < countY; ++ty)
+                    for (int tx = 0; tx < countX; ++tx)
+                        img.tiles.push_back (
+                            {0, tx, ty, int (img.levels.size ())});
 
-    cout << "   \"read time\": " << timing (startRead, endRead) << ",\n";
-    cout << "   \"write time\": " << timing (startWrite, endWrite) << ",\n";
-    cout << "   \"pixel count\": " << numPixels << ",\n";
-    cout << "   \"raw size\": " << numPixels * pixelSize << ",\n";
+                img.levels.push_back (l);
+            }
+        }
+    }
+
+    for (Level& l: img.levels)
+    {
+        l.planes.resize (img.names.size ());
+
+        for (size_t c = 0; c < img.names.size (); ++c)
+            l.planes[c].resize (
+                size_t (l.width) * size_t (l.height) * img.sizes[c]);
+    }
 }
 
-void
-copyTiled (TiledInputPart& in, TiledOutputPart& out)
+vector<Chunk>
+scanLineChunks (const FlatImage& img, int linesPerChunk)
+{
+    vector<Chunk> chunks;
+
+    for (int y = img.dataWindow.min.y; y <= img.dataWindow.max.y;
+         y += linesPerChunk)
+        chunks.push_back ({y, 0, 0, 0});
+
+    return chunks;
+}
+
+//
+// A Decoder reads and decodes chunks with the Core library.  It
+// wraps the functions of the library's decode pipeline, in order
+// to time them.
+//
+
+class Decoder
 {
-    int             numChans = channelCount (in.header ());
-    TileDescription tiling   = in.header ().tileDescription ();
+public:
+    Decoder (exr_const_context_t f, int part, FlatImage& img)
+        : _f (f), _part (part), _img (img)
+    {}
 
-    Box2i imageDw = in.header ().dataWindow ();
-    int   totalLevels;
-    switch (tiling.mode)
+    ~Decoder ()
     {
-        case ONE_LEVEL: totalLevels = 1; //break;
-        case MIPMAP_LEVELS: totalLevels = in.numLevels (); break;
-        case RIPMAP_LEVELS:
-            totalLevels = in.numXLevels () * in.numYLevels ();
-            break;
-        case NUM_LEVELMODES:
-        default:
-            throw runtime_error ("unknown tile mode");
+        if (_initialized) exr_decoding_destroy (_f, &_pipe);
     }
 
-    vector<vector<vector<char>>> pixelData (totalLevels);
-    vector<FrameBuffer>          frameBuffer (totalLevels);
+    void decode (const Chunk& c)
+    {
+        exr_chunk_info_t cinfo;
+        exr_result_t     rv;
+
+        {
+            StageTimer t (times, READ_IO);
+            const Level& l = _img.levels[c.level];
 
-    int    levelIndex  = 0;
-    int    pixelSize   = 0;
-    size_t totalPixels = 0;
+            rv = _img.tiled ? exr_read_tile_chunk_info (
+                                  _f, _part, c.tx, c.ty, l.lx, l.ly, &cinfo)
+                            : exr_read_scanline_chunk_info (
+                                  _f, _part, c.y, &cinfo);
+        }
 
-    //
-    // allocate memory and initialize frameBuffer for each level
-    //
-    for (int xLevel = 0; xLevel < in.numXLevels (); ++xLevel)
+        check (rv, "Cannot read chunk");
+
+        bool first = !_initialized;
+
+        if (first)
+        {
+            check (
+                exr_decoding_initialize (_f, _part, &cinfo, &_pipe),
+                "Cannot initialize decoding");
+            _initialized = true;
+        }
+        else
+        {
+            check (
+                exr_decoding_update (_f, _part, &cinfo, &_pipe),
+                "Cannot update decoding");
+        }
+
+        for (int c2 = 0; c2 < _pipe.channel_count; ++c2)
+        {
+            exr_coding_channel_info_t& ch = _pipe.channels[c2];
+
+            if (_img.names[c2] != ch.channel_name)
+                throw runtime_error ("Unexpected channel list");
+
+            ch.decode_to_ptr          = _img.pointer (c, c2, cinfo.start_y);
+            ch.user_data_type         = _img.types[c2];
+            ch.user_bytes_per_element = _img.sizes[c2];
+            ch.user_pixel_stride      = _img.sizes[c2];
+            ch.user_line_stride =
+                int32_t (_img.sizes[c2]) * _img.levels[c.level].width;
+        }
+
+        if (first)
+        {
+            check (
+                exr_decoding_choose_default_routines (_f, _part, &_pipe),
+                "Cannot choose decoding routines");
+
+            _read       = _pipe.read_fn;
+            _decompress = _pipe.decompress_fn;
+            _unpack     = _pipe.unpack_and_convert_fn;
+
+            if (_read) _pipe.read_fn = &read;
+            if (_decompress) _pipe.decompress_fn = &decompress;
+            if (_unpack) _pipe.unpack_and_convert_fn = &unpack;
+        }
+
+        _pipe.decoding_user_data = this;
+
+        check (exr_decoding_run (_f, _part, &_pipe), "Cannot decode chunk");
+    }
+
+    Times times;
+
+private:
+    typedef exr_result_t (*Fn) (exr_decode_pipeline_t*);
+
+    static exr_result_t read (exr_decode_pipeline_t* p)
+    {
+        Decoder*   d = static_cast<Decoder*> (p->decoding_user_data);
+        StageTimer t (d->times, READ_IO);
+        return d->_read (p);
+    }
+
+    static exr_result_t decompress (exr_decode_pipeline_t* p)
+    {
+        Decoder*   d = static_cast<Decoder*> (p->decoding_user_data);
+        StageTimer t (d->times, DECOMPRESS);
+        return d->_decompress (p);
+    }
+
+    static exr_result_t unpack (exr_decode_pipeline_t* p)
+    {
+        Decoder*   d = static_cast<Decoder*> (p->decoding_user_data);
+        StageTimer t (d->times, UNPACK);
+        return d->_unpack (p);
+    }
+
+    exr_const_context_t   _f;
+    int                   _part;
+    FlatImage&            _img;
+    exr_decode_pipeline_t _pipe        = EXR_DECODE_PIPELINE_INITIALIZER;
+    bool                  _initialized = false;
+    Fn                    _read        = nullptr;
+    Fn                    _decompress  = nullptr;
+    Fn                    _unpack      = nullptr;
+};
+
+//
+// An Encoder packs and compresses chunks with the Core library, like
+// a Decoder.  The chunks must be written in order, so encode() leaves
+// the compressed chunk in the encoder, and write() checks that it is
+// the next chunk of the file and writes it.
+//
+
+class Encoder
+{
+public:
+    Encoder (exr_context_t f, FlatImage& img) : _f (f), _img (img) {}
+
+    ~Encoder ()
     {
-        for (int yLevel = 0; yLevel < in.numYLevels (); ++yLevel)
+        if (_initialized) exr_encoding_destroy (_f, &_pipe);
+    }
+
+    void encode (const Chunk& c)
+    {
+        exr_chunk_info_t cinfo;
+        const Level&     l = _img.levels[c.level];
+
+        check (
+            _img.tiled ? exr_write_tile_chunk_info (
+                             _f, 0, c.tx, c.ty, l.lx, l.ly, &cinfo)
+                       : exr_write_scanline_chunk_info (_f, 0, c.y, &cinfo),
+            "Cannot prepare chunk");
+
+        bool first = !_initialized;
+
+        if (first)
         {
-            if (tiling.mode == RIPMAP_LEVELS || xLevel == yLevel)
-            {
-                Box2i dw = dataWindowForLevel (
-                    tiling,
-                    imageDw.min.x,
-                    imageDw.max.x,
-                    imageDw.min.y,
-                    imageDw.max.y,
-                    xLevel,
-                    yLevel);
-                uint64_t width     = dw.max.x + 1 - dw.min.x;
-                uint64_t height    = dw.max.y + 1 - dw.min.y;
-                uint64_t numPixels = width * height;
-                uint64_t offsetToOrigin =
-                    width * static_cast<uint64_t> (dw.min.y) +
-                    static_cast<uint64_t> (dw.min.x);
-                int channelNumber = 0;
-                pixelSize         = 0;
-
-                pixelData[levelIndex].resize (numChans);
-
-                for (ChannelList::ConstIterator i =
-                         out.header ().channels ().begin ();
-                     i != out.header ().channels ().end ();
-                     ++i)
-                {
-                    int samplesize = pixelTypeSize (i.channel ().type);
-                    pixelData[levelIndex][channelNumber].resize (
-                        numPixels * samplesize);
+            check (
+                exr_encoding_initialize (_f, 0, &cinfo, &_pipe),
+                "Cannot initialize encoding");
+            _initialized = true;
+        }
+        else
+        {
+            check (
+                exr_encoding_update (_f, 0, &cinfo, &_pipe),
+                "Cannot update encoding");
+        }
 
-                    frameBuffer[levelIndex].insert (
-                        i.name (),
-                        Slice (
-                            i.channel ().type,
-                            pixelData[levelIndex][channelNumber].data () -
-                                offsetToOrigin * samplesize,
-                            samplesize,
-                            samplesize * width));
-                    ++channelNumber;
-                    pixelSize += samplesize;
-                }
-                totalPixels += numPixels;
-                ++levelIndex;
-            }
+        for (int c2 = 0; c2 < _pipe.channel_count; ++c2)
+        {
+            exr_coding_channel_info_t& ch = _pipe.channels[c2];
+
+            ch.encode_from_ptr        = _img.pointer (c, c2, cinfo.start_y);
+            ch.user_data_type         = _img.types[c2];
+            ch.user_bytes_per_element = _img.sizes[c2];
+            ch.user_pixel_stride      = _img.sizes[c2];
+            ch.user_line_stride       = int32_t (_img.sizes[c2]) * l.width;
         }
+
+        if (first)
+        {
+            check (
+                exr_encoding_choose_default_routines (_f, 0, &_pipe),
+                "Cannot choose encoding routines");
+
+            _pack     = _pipe.convert_and_pack_fn;
+            _compress = _pipe.compress_fn;
+            _yield    = _pipe.yield_until_ready_fn;
+            _write    = _pipe.write_fn;
+
+            if (_pack) _pipe.convert_and_pack_fn = &pack;
+            if (_compress) _pipe.compress_fn = &compress;
+            _pipe.yield_until_ready_fn = nullptr;
+            _pipe.write_fn             = nullptr;
+        }
+
+        _pipe.encoding_user_data = this;
+
+        check (exr_encoding_run (_f, 0, &_pipe), "Cannot encode chunk");
+    }
+
+    void write ()
+    {
+        StageTimer t (times, WRITE_IO);
+        if (_yield) check (_yield (&_pipe), "Cannot write chunk");
+        check (_write (&_pipe), "Cannot write chunk");
+    }
+
+    Times times;
+
+private:
+    typedef exr_result_t (*Fn) (exr_encode_pipeline_t*);
+
+    static exr_result_t pack (exr_encode_pipeline_t* p)
+    {
+        Encoder*   e = static_cast<Encoder*> (p->encoding_user_data);
+        StageTimer t (e->times, PACK);
+        return e->_pack (p);
+    }
+
+    static exr_result_t compress (exr_encode_pipeline_t* p)
+    {
+        Encoder*   e = static_cast<Encoder*> (p->encoding_user_data);
+        StageTimer t (e->times, COMPRESS);
+        return e->_compress (p);
     }
 
-    steady_clock::time_point startRead = steady_clock::now();
-    levelIndex        = 0;
+    exr_context_t         _f;
+    FlatImage&            _img;
+    exr_encode_pipeline_t _pipe        = EXR_ENCODE_PIPELINE_INITIALIZER;
+    bool                  _initialized = false;
+    Fn                    _pack        = nullptr;
+    Fn                    _compress    = nullptr;
+    Fn                    _yield       = nullptr;
+    Fn                    _write       = nullptr;
+};
+
+//
+// Tasks that decode a range of chunks, or encode one chunk.
+//
 
-    for (int xLevel = 0; xLevel < in.numXLevels (); ++xLevel)
+class DecodeTask : public Task
+{
+public:
+    DecodeTask (
+        TaskGroup*          group,
+        exr_const_context_t f,
+        int                 part,
+        FlatImage&          img,
+        const Chunk*        begin,
+        const Chunk*        end,
+        Times&              times,
+        mutex&              m,
+        exception_ptr&      error)
+        : Task (group)
+        , _f (f)
+        , _part (part)
+        , _img (img)
+        , _begin (begin)
+        , _end (end)
+        , _times (times)
+        , _mutex (m)
+        , _error (error)
+    {}
+
+    void execute () override
     {
-        for (int yLevel = 0; yLevel < in.numYLevels (); ++yLevel)
+        Decoder d (_f, _part, _img);
+
+        try
         {
-            if (tiling.mode == RIPMAP_LEVELS || xLevel == yLevel)
-            {
-                in.setFrameBuffer (frameBuffer[levelIndex]);
-                in.readTiles (
-                    0,
-                    in.numXTiles (xLevel) - 1,
-                    0,
-                    in.numYTiles (yLevel) - 1,
-                    xLevel,
-                    yLevel);
-                ++levelIndex;
-            }
+            for (const Chunk* c = _begin; c != _end; ++c)
+                d.decode (*c);
+        }
+        catch (...)
+        {
+            lock_guard<mutex> lock (_mutex);
+            if (!_error) _error = std::current_exception ();
+        }
+
+        lock_guard<mutex> lock (_mutex);
+        _times.add (d.times);
+    }
+
+private:
+    exr_const_context_t _f;
+    int                 _part;
+    FlatImage&          _img;
+    const Chunk*        _begin;
+    const Chunk*        _end;
+    Times&              _times;
+    mutex&              _mutex;
+    exception_ptr&      _error;
+};
+
+class EncodeTask : public Task
+{
+public:
+    EncodeTask (
+        TaskGroup*     group,
+        Encoder&       encoder,
+        const Chunk&   chunk,
+        mutex&         m,
+        exception_ptr& error)
+        : Task (group)
+        , _encoder (encoder)
+        , _chunk (chunk)
+        , _mutex (m)
+        , _error (error)
+    {}
+
+    void execute () override
+    {
+        try
+        {
+            _encoder.encode (_chunk);
+        }
+        catch (...)
+        {
+            lock_guard<mutex> lock (_mutex);
+            if (!_error) _error = std::current_exception ();
         }
     }
 
-    steady_clock::time_point endRead = steady_clock::now();
+private:
+    Encoder&       _encoder;
+    const Chunk&   _chunk;
+    mutex&         _mutex;
+    exception_ptr& _error;
+};
 
-    steady_clock::time_point startWrite = steady_clock::now();
-    levelIndex         = 0;
-    int tileCount      = 0;
+//
+// Copy a flat part with the Core library, timing every stage.
+//
+
+void
+copyFlat (
+    const char    inFileName[],
+    const char    outFileName[],
+    int           part,
+    const Header& outHeader,
+    Times&        times,
+    PartSize&     size)
+{
+    int numThreads = globalThreadCount ();
+    int numTasks   = std::max (1, numThreads * 4);
+
+    exr_context_t             in;
+    exr_context_initializer_t init = EXR_DEFAULT_CONTEXT_INITIALIZER;
+
+    check (exr_start_read (&in, inFileName, &init), "Cannot read input file");
 
-    for (int xLevel = 0; xLevel < in.numXLevels (); ++xLevel)
+    try
     {
-        for (int yLevel = 0; yLevel < in.numYLevels (); ++yLevel)
+        FlatImage img;
+        setupImage (in, part, outHeader, img);
+
+        for (const Level& l: img.levels)
+        {
+            size.pixelCount += uint64_t (l.width) * uint64_t (l.height);
+
+            for (size_t c = 0; c < img.sizes.size (); ++c)
+                size.rawSize += uint64_t (l.width) * uint64_t (l.height) *
+                                img.sizes[c];
+        }
+
+        size.tileCount = int (img.tiles.size ());
+
+        //
+        // Read the input file, in contiguous ranges of chunks.
+        //
+
+        vector<Chunk> inChunks;
+
+        if (img.tiled)
+        {
+            inChunks = img.tiles;
+        }
+        else
         {
-            if (tiling.mode == RIPMAP_LEVELS || xLevel == yLevel)
+            int32_t lines;
+            check (
+                exr_get_scanlines_per_chunk (in, part, &lines),
+                "Cannot read scan lines per chunk");
+            inChunks = scanLineChunks (img, lines);
+        }
+
+        steady_clock::time_point startRead = steady_clock::now ();
+
+        {
+            mutex         m;
+            exception_ptr error;
+
+            {
+                TaskGroup group;
+                size_t    n = inChunks.size ();
+                size_t    k = std::min (n, size_t (numTasks));
+
+                for (size_t t = 0; t < k; ++t)
+                {
+                    ThreadPool::addGlobalTask (new DecodeTask (
+                        &group,
+                        in,
+                        part,
+                        img,
+                        inChunks.data () + n * t / k,
+                        inChunks.data () + n * (t + 1) / k,
+                        times,
+                        m,
+                        error));
+                }
+            }
+
+            if (error) std::rethrow_exception (error);
+        }
+
+        times.t[READ] += timing (startRead, steady_clock::now ());
+
+        //
+        // Write the output file.  The chunks are encoded in batches,
+        // one chunk per task, and then written in order.
+        //
+
+        steady_clock::time_point startWrite = steady_clock::now ();
+
+        exr_context_t out;
+        check (
+            exr_start_write (&out, outFileName, EXR_WRITE_FILE_DIRECTLY, &init),
+            "Cannot write output file");
+
+        try
+        {
+            int p;
+
+            check (
+                exr_add_part (
+                    out,
+                    outHeader.hasName () ? outHeader.name ().c_str ()
+                                         : nullptr,
+                    img.tiled ? EXR_STORAGE_TILED : EXR_STORAGE_SCANLINE,
+                    &p),
+                "Cannot add output part");
+            check (
+                exr_set_compression (
+                    out, p, exr_compression_t (outHeader.compression ())),
+                "Cannot set compression");
+
+            for (ChannelList::ConstIterator i =
+                     outHeader.channels ().begin ();
+                 i != outHeader.channels ().end ();
+                 ++i)
+            {
+                check (
+                    exr_add_channel (
+                        out,
+                        p,
+                        i.name (),
+                        exr_pixel_type_t (i.channel ().type),
+                        i.channel ().pLinear ? EXR_PERCEPTUALLY_LINEAR
+                                             : EXR_PERCEPTUALLY_LOGARITHMIC,
+                        1,
+                        1),
+                    "Cannot add channel");
+            }
+
+            if (outHeader.hasChunkCount ())
+            {
+                check (
+                    exr_set_chunk_count (
+                        out, p, getChunkOffsetTableSize (outHeader)),
+                    "Cannot set chunk count");
+            }
+
+            check (
+                exr_copy_unset_attributes (out, p, in, part),
+                "Cannot copy attributes");
+            check (
+                exr_set_zip_compression_level (
+                    out, p, outHeader.zipCompressionLevel ()),
+                "Cannot set zip compression level");
+            check (
+                exr_set_dwa_compression_level (
+                    out, p, outHeader.dwaCompressionLevel ()),
+                "Cannot set dwa compression level");
+            check (exr_write_header (out), "Cannot write header");
+
+            vector<Chunk> outChunks;
+
+            if (img.tiled)
             {
-                out.setFrameBuffer (frameBuffer[levelIndex]);
-                out.writeTiles (
-                    0,
-                    in.numXTiles (xLevel) - 1,
-                    0,
-                    in.numYTiles (yLevel) - 1,
-                    xLevel,
-                    yLevel);
-                tileCount += in.numXTiles (xLevel) * in.numYTiles (yLevel);
-                ++levelIndex;
+                outChunks = img.tiles;
             }
+            else
+            {
+                int32_t lines;
+                check (
+                    exr_get_scanlines_per_chunk (out, p, &lines),
+                    "Cannot read scan lines per chunk");
+                outChunks = scanLineChunks (img, lines);
+            }
+
+            vector<std::unique_ptr<Encoder>> encoders;
+
+            for (int e = 0; e < numTasks; ++e)
+                encoders.emplace_back (new Encoder (out, img));
+
+            for (size_t b = 0; b < outChunks.size (); b += numTasks)
+            {
+                size_t n = std::min (outChunks.size () - b, size_t (numTasks));
+
+                mutex         m;
+                exception_ptr error;
+
+                {
+                    TaskGroup group;
+
+                    for (size_t e = 0; e < n; ++e)
+                    {
+                        ThreadPool::addGlobalTask (new EncodeTask (
+                            &group, *encoders[e], outChunks[b + e], m, error));
+                    }
+                }
+
+                if (error) std::rethrow_exception (error);
+
+                for (size_t e = 0; e < n; ++e)
+                    encoders[e]->write ();
+            }
+
+            for (const auto& e: encoders)
+                times.add (e->times);
         }
+        catch (...)
+        {
+            exr_finish (&out);
+            throw;
+        }
+
+        check (exr_finish (&out), "Cannot finish output file");
+
+        times.t[WRITE] += timing (startWrite, steady_clock::now ());
+    }
+    catch (...)
+    {
+        exr_finish (&in);
+        throw;
     }
-    steady_clock::time_point endWrite = steady_clock::now();
 
-    cout << "   \"read time\": " << timing (startRead, endRead) << ",\n";
-    cout << "   \"write time\": " << timing (startWrite, endWrite) << ",\n";
-    cout << "   \"total tiles\": " << tileCount << ",\n";
-    cout << "   \"pixel count\": " << totalPixels << ",\n";
-    cout << "   \"raw size\": " << totalPixels * pixelSize << ",\n";
+    exr_finish (&in);
 }
 
 void
-copyDeepScanLine (DeepScanLineInputPart& in, DeepScanLineOutputPart& out)
+copyDeepScanLine (
+    DeepScanLineInputPart&  in,
+    DeepScanLineOutputPart& out,
+    Times&                  times,
+    PartSize&               size)
 {
     Box2i       dw        = in.header ().dataWindow ();
     uint64_t    width     = dw.max.x + 1 - dw.min.x;
@@ -335,19 +950,20 @@ copyDeepScanLine (DeepScanLineInputPart& in, DeepScanLineOutputPart& out)
     out.writePixels (height);
     steady_clock::time_point endWrite = steady_clock::now();
 
+    times.t[READ] += timing (startCountRead, endCountRead) +
+                     timing (startSampleRead, endSampleRead);
+    times.t[WRITE] += timing (startWrite, endWrite);
 
-    cout << "   \"count read time\": " << timing (startCountRead, endCountRead)
-         << ",\n";
-    cout << "   \"sample read time\": "
-         << timing (startSampleRead, endSampleRead) << ",\n";
-    cout << "   \"write time\": " << timing (startWrite, endWrite) << ",\n";
-    cout << "   \"pixel count\": " << numPixels << ",\n";
-    cout << "   \"raw size\": "
-         << totalSamples * bytesPerSample + numPixels * sizeof (int) << ",\n";
+    size.pixelCount = numPixels;
+    size.rawSize    = totalSamples * bytesPerSample + numPixels * sizeof (int);
 }
 
 void
-copyDeepTiled (DeepTiledInputPart& in, DeepTiledOutputPart& out)
+copyDeepTiled (
+    DeepTiledInputPart&  in,
+    DeepTiledOutputPart& out,
+    Times&               times,
+    PartSize&            size)
 {
 
     TileDescription tiling = in.header ().tileDescription ();
@@ -366,8 +982,7 @@ copyDeepTiled (DeepTiledInputPart& in, DeepTiledOutputPart& out)
 
     Box2i       dw        = in.header ().dataWindow ();
     uint64_t    width     = dw.max.x + 1 - dw.min.x;
-    uint64_t    height    = dw.max.y + 1 - dw.min.y;
-    uint64_t    numPixels = width * height;
+    uint64_t    numPixels = width * (dw.max.y + 1 - dw.min.y);
     int         numChans  = channelCount (in.header ());
     vector<int> sampleCount (numPixels);
 
@@ -446,143 +1061,475 @@ copyDeepTiled (DeepTiledInputPart& in, DeepTiledOutputPart& out)
     out.writeTiles (0, in.numXTiles (0) - 1, 0, in.numYTiles (0) - 1, 0, 0);
     steady_clock::time_point endWrite = steady_clock::now();
 
+    times.t[READ] += timing (startCountRead, endCountRead) +
+                     timing (startSampleRead, endSampleRead);
+    times.t[WRITE] += timing (startWrite, endWrite);
 
-    cout << "   \"count read time\": " << timing (startCountRead, endCountRead)
-         << ",\n";
-    cout << "   \"sample read time\": "
-         << timing (startSampleRead, endSampleRead) << ",\n";
-    cout << "   \"write time\": " << timing (startWrite, endWrite) << ",\n";
-    cout << "   \"pixel count\": " << numPixels << ",\n";
-    cout << "   \"raw size\": "
-         << totalSamples * bytesPerSample + numPixels * sizeof (int) << ",\n";
+    size.pixelCount = numPixels;
+    size.tileCount  = in.numXTiles (0) * in.numYTiles (0);
+    size.rawSize    = totalSamples * bytesPerSample + numPixels * sizeof (int);
 }
 
+//
+// The results of all passes of one combination of compression method,
+// compression level and thread count.
+//
+
+struct Result
+{
+    Header        header;
+    int           threads = 0;
+    PartSize      size;
+    uint64_t      outputFileSize = 0;
+    vector<Times> passes;
+    double        median[NUM_STAGES];
+    double        p95[NUM_STAGES];
+    double        speedup    = 1;
+    double        efficiency = 1;
+};
+
 void
-exrmetrics (
-    const char       inFileName[],
-    const char       outFileName[],
-    int              part,
-    Imf::Compression compression,
-    float            level,
-    int              halfMode)
+computeStatistics (Result& r)
 {
-    MultiPartInputFile in (inFileName);
-    if (part >= in.parts ())
+    size_t n = r.passes.size ();
+
+    for (int s = 0; s < NUM_STAGES; ++s)
     {
-        throw runtime_error ((string (inFileName) + " only contains " +
-                              to_string (in.parts ()) +
-                              " parts. Cannot copy part " + to_string (part))
-                                 .c_str ());
+        vector<double> v;
+
+        for (const Times& t: r.passes)
+            v.push_back (t.t[s]);
+
+        std::sort (v.begin (), v.end ());
+
+        r.median[s] = (n % 2) ? v[n / 2] : (v[n / 2 - 1] + v[n / 2]) / 2;
+        r.p95[s]    = v[size_t (ceil (0.95 * n)) - 1];
     }
-    Header outHeader = in.header (part);
+}
+
+//
+// The speedup of every result over the result with the fewest threads
+// that has the same compression method and level, and the scaling
+// efficiency, the speedup divided by the increase in threads.  The
+// calling thread does the work when the thread count is zero, so it
+// counts as one thread.
+//
+
+bool
+sameCompression (const Header& a, const Header& b)
+{
+    return a.compression () == b.compression () &&
+           a.zipCompressionLevel () == b.zipCompressionLevel () &&
+           a.dwaCompressionLevel () == b.dwaCompressionLevel ();
+}
 
-    if (compression < NUM_COMPRESSION_METHODS)
+void
+computeScaling (vector<Result>& results)
+{
+    for (Result& r: results)
     {
-        outHeader.compression () = compression;
+        const Result* base = &r;
+
+        for (const Result& b: results)
+        {
+            if (sameCompression (b.header, r.header) &&
+                b.threads < base->threads)
+                base = &b;
+        }
+
+        if (r.median[TOTAL] > 0)
+        {
+            r.speedup = base->median[TOTAL] / r.median[TOTAL];
+            r.efficiency =
+                r.speedup * std::max (base->threads, 1) /
+                std::max (r.threads, 1);
+        }
     }
-    else { compression = outHeader.compression (); }
+}
+
+bool
+isDeep (const Header& h)
+{
+    return h.type () == DEEPSCANLINE || h.type () == DEEPTILE;
+}
+
+string
+jsonString (const string& s)
+{
+    string r = "\"";
 
-    if (!isinf (level) && level >= -1)
+    for (char c: s)
     {
-        switch (outHeader.compression ())
+        if (c == '"' || c == '\\')
+        {
+            r += '\\';
+            r += c;
+        }
+        else if (static_cast<unsigned char> (c) < 0x20)
         {
-            case DWAA_COMPRESSION:
-            case DWAB_COMPRESSION:
-                outHeader.dwaCompressionLevel () = level;
-                break;
-            case ZIP_COMPRESSION:
-            case ZIPS_COMPRESSION:
-                outHeader.zipCompressionLevel () = level;
-                break;
-                //            case ZSTD_COMPRESSION :
-                //                outHeader.zstdCompressionLevel()=level;
-                //                break;
-            default:
-                throw runtime_error (
-                    "-l option only works for DWAA/DWAB,ZIP/ZIPS or ZSTD compression");
+            char buf[8];
+            snprintf (buf, sizeof (buf), "\\u%04x", c);
+            r += buf;
         }
+        else
+            r += c;
     }
 
-    if (halfMode > 0)
+    return r + "\"";
+}
+
+string
+csvString (const string& s)
+{
+    if (s.find_first_of (",\"\n") == string::npos) return s;
+
+    string r = "\"";
+
+    for (char c: s)
     {
-        for (ChannelList::Iterator i = outHeader.channels ().begin ();
-             i != outHeader.channels ().end ();
-             ++i)
+        if (c == '"') r += '"';
+        r += c;
+    }
+
+    return r + "\"";
+}
+
+//
+// The fields of a result, in the order in which they are printed.
+// Numbers are printed as they are, strings are quoted as needed,
+// and empty values are printed as null in JSON.
+//
+
+struct Field
+{
+    string name;
+    string value;
+    bool   isString;
+};
+
+vector<Field>
+resultFields (
+    const char    inFileName[],
+    int           part,
+    const Header& inHeader,
+    uint64_t      inputFileSize,
+    const Result& r)
+{
+    vector<Field> f;
+
+    auto number = [&f] (const string& name, double value) {
+        ostringstream s;
+        s << value;
+        f.push_back ({name, s.str (), false});
+    };
+
+    auto count = [&f] (const string& name, uint64_t value) {
+        f.push_back ({name, to_string (value), false});
+    };
+
+    const Header& h = r.header;
+    Compression   c = h.compression ();
+    string        inCompress, outCompress;
+
+    getCompressionNameFromId (inHeader.compression (), inCompress);
+    getCompressionNameFromId (c, outCompress);
+
+    f.push_back ({"input file", inFileName, true});
+    count ("part", part);
+    f.push_back ({"part type", h.type (), true});
+    f.push_back ({"input compression", inCompress, true});
+    f.push_back ({"output compression", outCompress, true});
+
+    if (c == ZIP_COMPRESSION || c == ZIPS_COMPRESSION)
+        count ("zipCompressionLevel", h.zipCompressionLevel ());
+    else
+        f.push_back ({"zipCompressionLevel", "", false});
+
+    if (c == DWAA_COMPRESSION || c == DWAB_COMPRESSION)
+        number ("dwaCompressionLevel", h.dwaCompressionLevel ());
+    else
+        f.push_back ({"dwaCompressionLevel", "", false});
+
+    if (h.type () == SCANLINEIMAGE || h.type () == DEEPSCANLINE)
+        count ("scanlines per chunk", getCompressionNumScanlines (c));
+    else
+        f.push_back ({"scanlines per chunk", "", false});
+
+    if (h.type () == TILEDIMAGE || h.type () == DEEPTILE)
+        count ("total tiles", r.size.tileCount);
+    else
+        f.push_back ({"total tiles", "", false});
+
+    count ("threads", r.threads);
+    count ("passes", r.passes.size ());
+    count ("pixel count", r.size.pixelCount);
+    count ("raw size", r.size.rawSize);
+
+    for (int s = 0; s < NUM_STAGES; ++s)
+    {
+        if (s < READ && isDeep (h))
         {
-            if (halfMode == 2 || !strcmp (i.name (), "R") ||
-                !strcmp (i.name (), "G") || !strcmp (i.name (), "B") ||
-                !strcmp (i.name (), "A"))
-            {
-                i.channel ().type = HALF;
-            }
+            f.push_back ({stageNames[s], "", false});
+            f.push_back ({string (stageNames[s]) + " p95", "", false});
+        }
+        else
+        {
+            number (stageNames[s], r.median[s]);
+            number (string (stageNames[s]) + " p95", r.p95[s]);
         }
     }
 
-    string inCompress, outCompress;
-    getCompressionNameFromId (in.header (part).compression (), inCompress);
-    getCompressionNameFromId (outHeader.compression (), outCompress);
-    cout << "{\n";
-    cout << "   \"input compression\": \"" << inCompress << "\",\n";
-    cout << "   \"output compression\": \"" << outCompress << "\",\n";
-    if (compression == ZIP_COMPRESSION || compression == ZIPS_COMPRESSION)
+    number ("speedup", r.speedup);
+    number ("scaling efficiency", r.efficiency);
+    count ("input file size", inputFileSize);
+    count ("output file size", r.outputFileSize);
+
+    return f;
+}
+
+void
+printJson (ostream& os, const vector<Field>& fields)
+{
+    os << "{\n";
+
+    for (size_t i = 0; i < fields.size (); ++i)
+    {
+        const Field& f = fields[i];
+
+        os << "   " << jsonString (f.name) << ": ";
+
+        if (f.value.empty ())
+            os << "null";
+        else if (f.isString)
+            os << jsonString (f.value);
+        else
+            os << f.value;
+
+        os << (i + 1 < fields.size () ? ",\n" : "\n");
+    }
+
+    os << "}";
+}
+
+} // namespace
+
+void
+exrmetrics (
+    const char               inFileName[],
+    const char               outFileName[],
+    int                      part,
+    const vector<Compression>& compressions,
+    const vector<float>&     levels,
+    const vector<int>&       threadCounts,
+    int                      passes,
+    int                      halfMode,
+    MetricsFormat            format)
+{
+    Header inHeader;
+
     {
-        cout << "   \"zipCompressionLevel\": "
-             << outHeader.zipCompressionLevel () << ",\n";
+        MultiPartInputFile in (inFileName);
+        if (part >= in.parts ())
+        {
+            throw runtime_error (
+                (string (inFileName) + " only contains " +
+                 to_string (in.parts ()) + " parts. Cannot copy part " +
+                 to_string (part))
+                    .c_str ());
+        }
+        inHeader = in.header (part);
     }
 
-    if (compression == DWAA_COMPRESSION || compression == DWAB_COMPRESSION)
+    std::string type = inHeader.type ();
+
+    if (type != SCANLINEIMAGE && type != TILEDIMAGE && !isDeep (inHeader))
     {
-        cout << "   \"dwaCompressionLevel\": "
-             << outHeader.dwaCompressionLevel () << ",\n";
+        throw runtime_error (
+            (inFileName + string (" contains unknown part type ") + type)
+                .c_str ());
     }
 
-    std::string type = outHeader.type ();
-    cout << "   \"part type\": \"" << type << "\",\n";
+    //
+    // Build the output headers, one for each combination
+    // of compression method and level.
+    //
+
+    vector<Compression> methods;
 
-    if (type == SCANLINEIMAGE)
+    for (Compression c: compressions)
     {
-        cout << "   \"scanlines per chunk:\" : "
-             << getCompressionNumScanlines (compression) << ",\n";
+        if (!isDeep (inHeader) || isValidDeepCompression (c))
+            methods.push_back (c);
     }
 
+    if (compressions.empty ()) methods.push_back (inHeader.compression ());
+
+    if (methods.empty ())
     {
-        MultiPartOutputFile out (outFileName, &outHeader, 1);
+        throw runtime_error (
+            "none of the compression methods support deep parts");
+    }
 
-        if (type == TILEDIMAGE)
-        {
-            TiledInputPart  inpart (in, part);
-            TiledOutputPart outpart (out, 0);
-            copyTiled (inpart, outpart);
-        }
-        else if (type == SCANLINEIMAGE)
+    vector<Header> outHeaders;
+    bool           levelUsed = false;
+
+    for (Compression compression: methods)
+    {
+        for (float level: levels)
         {
-            InputPart  inpart (in, part);
-            OutputPart outpart (out, 0);
-            copyScanLine (inpart, outpart);
+            Header outHeader = inHeader;
+            outHeader.compression () = compression;
+
+            if (!isinf (level) && level >= -1)
+            {
+                switch (compression)
+                {
+                    case DWAA_COMPRESSION:
+                    case DWAB_COMPRESSION:
+                        outHeader.dwaCompressionLevel () = level;
+                        levelUsed = true;
+                        break;
+                    case ZIP_COMPRESSION:
+                    case ZIPS_COMPRESSION:
+                        outHeader.zipCompressionLevel () = level;
+                        levelUsed = true;
+                        break;
+                        //            case ZSTD_COMPRESSION :
+                        //                outHeader.zstdCompressionLevel()=level;
+                        //                break;
+                    default:
+                        //
+                        // Levels do not apply to this method;
+                        // measure it once, with no level.
+                        //
+                        if (level != levels[0]) continue;
+                        break;
+                }
+            }
+
+            if (halfMode > 0)
+            {
+                for (ChannelList::Iterator i = outHeader.channels ().begin ();
+                     i != outHeader.channels ().end ();
+                     ++i)
+                {
+                    if (halfMode == 2 || !strcmp (i.name (), "R") ||
+                        !strcmp (i.name (), "G") || !strcmp (i.name (), "B") ||
+                        !strcmp (i.name (), "A"))
+                    {
+                        i.channel ().type = HALF;
+                    }
+                }
+            }
+
+            outHeaders.push_back (outHeader);
         }
-        else if (type == DEEPSCANLINE)
+    }
+
+    if (!levelUsed && !isinf (levels[0]))
+    {
+        throw runtime_error (
+            "-l option only works for DWAA/DWAB,ZIP/ZIPS or ZSTD compression");
+    }
+
+    //
+    // Copy the part for every combination of output header
+    // and thread count, passes times each.
+    //
+
+    vector<Result> results;
+
+    for (const Header& outHeader: outHeaders)
+    {
+        for (int threads: threadCounts)
         {
-            DeepScanLineInputPart  inpart (in, part);
-            DeepScanLineOutputPart outpart (out, 0);
-            copyDeepScanLine (inpart, outpart);
+            setGlobalThreadCount (threads);
+
+            Result r;
+            r.header  = outHeader;
+            r.threads = threads;
+
+            for (int pass = 0; pass < passes; ++pass)
+            {
+                Times    times;
+                PartSize size;
+
+                steady_clock::time_point start = steady_clock::now ();
+
+                if (type == SCANLINEIMAGE || type == TILEDIMAGE)
+                {
+                    copyFlat (
+                        inFileName, outFileName, part, outHeader, times, size);
+                }
+                else
+                {
+                    MultiPartInputFile  in (inFileName);
+                    MultiPartOutputFile out (outFileName, &outHeader, 1);
+
+                    if (type == DEEPSCANLINE)
+                    {
+                        DeepScanLineInputPart  inpart (in, part);
+                        DeepScanLineOutputPart outpart (out, 0);
+                        copyDeepScanLine (inpart, outpart, times, size);
+                    }
+                    else
+                    {
+                        DeepTiledInputPart  inpart (in, part);
+                        DeepTiledOutputPart outpart (out, 0);
+                        copyDeepTiled (inpart, outpart, times, size);
+                    }
+                }
+
+                times.t[TOTAL] = timing (start, steady_clock::now ());
+
+                r.size = size;
+                r.passes.push_back (times);
+            }
+
+            struct stat outstats;
+            stat (outFileName, &outstats);
+            r.outputFileSize = outstats.st_size;
+
+            computeStatistics (r);
+            results.push_back (r);
         }
-        else if (type == DEEPTILE)
+    }
+
+    computeScaling (results);
+
+    //
+    // Print the results: a JSON object for a single result, or a
+    // JSON array of objects, or a CSV table with one row per result.
+    //
+
+    struct stat instats;
+    stat (inFileName, &instats);
+
+    for (size_t i = 0; i < results.size (); ++i)
+    {
+        vector<Field> fields = resultFields (
+            inFileName, part, inHeader, instats.st_size, results[i]);
+
+        if (format == CSV_FORMAT)
         {
-            DeepTiledInputPart  inpart (in, part);
-            DeepTiledOutputPart outpart (out, 0);
-            copyDeepTiled (inpart, outpart);
+            if (i == 0)
+            {
+                for (size_t j = 0; j < fields.size (); ++j)
+                    cout << (j ? "," : "") << csvString (fields[j].name);
+                cout << "\n";
+            }
+
+            for (size_t j = 0; j < fields.size (); ++j)
+                cout << (j ? "," : "") << csvString (fields[j].value);
+            cout << "\n";
         }
         else
         {
-            throw runtime_error (
-                (inFileName + string (" contains unknown part type ") + type)
-                    .c_str ());
+            if (results.size () > 1) cout << (i == 0 ? "[\n" : ",\n");
+            printJson (cout, fields);
+            if (results.size () > 1 && i + 1 == results.size ())
+                cout << "\n]";
+            cout << "\n";
         }
     }
-    struct stat instats, outstats;
-    stat (inFileName, &instats);
-    stat (outFileName, &outstats);
-    cout << "   \"input file size\": " << instats.st_size << ",\n";
-    cout << "   \"output file size\": " << outstats.st_size << "\n";
-    cout << "}\n";
 }
@@ -10,11 +10,33 @@
 
 #include "ImfCompression.h"
 
+#include <vector>
+
+enum MetricsFormat
+{
+    JSON_FORMAT,
+    CSV_FORMAT
+};
+
+//
+// Copy one part of inFileName to outFileName once for every combination
+// of the given compression methods, compression levels and thread counts,
+// repeating each copy passes times, and print the sizes of the files and
+// the median and 95th percentile of the time taken by each stage of
+// reading and writing.  An empty list of compression methods keeps the
+// input's method; a level of INFINITY keeps the default level.  Levels
+// only apply to methods that have them.
+//
+
 void exrmetrics (
-    const char       inFileName[],
-    const char       outFileName[],
-    int              part,
-    Imf::Compression compression,
-    float            level,
-    int              halfMode);
+    const char                           inFileName[],
+    const char                           outFileName[],
+    int                                  part,
+    const std::vector<Imf::Compression>& compressions,
+    const std::vector<float>&            levels,
+    const std::vector<int>&              threadCounts,
+    int                                  passes,
+    int                                  halfMode,
+    MetricsFormat                        format);
+
 #endif
@@ -6,10 +6,13 @@
 
 #include "exrmetrics.h"
 
+#include "IlmThreadPool.h"
 #include "ImfCompression.h"
 #include "ImfMisc.h"
 
+#include <algorithm>
 #include <iostream>
+#include <string>
 #include <vector>
 
 #include <math.h>
@@ -20,6 +23,7 @@ using std::cerr;
 using std::cout;
 using std::endl;
 using std::ostream;
+using std::string;
 using std::vector;
 using namespace Imf;
 
@@ -34,20 +38,36 @@ usageMessage (ostream& stream, const char* program_name, bool verbose = false)
         getCompressionNamesString ("/", compressionNames);
         stream
             << "Read an OpenEXR image from infile, write an identical copy to outfile"
-               " reporting time taken to read/write and file sizes.\n"
+               " reporting time taken by each stage of reading and writing, and file sizes.\n"
                "\n"
                "Options:\n"
                "\n"
                "  -p n          part number to copy (only one part will be written to output file)\n"
                "                default is part 0\n"
                "\n"
-               "  -l level      set DWA or ZIP compression level\n"
+               "  -l level[,level...]\n"
+               "                set DWA or ZIP compression level. With a list of\n"
+               "                levels, the copy is made once for each level\n"
                "\n"
-               "  -z x          sets the data compression method to x\n"
+               "  -z x[,x...]   sets the data compression method to x\n"
                "                ("
             << compressionNames.c_str ()
             << ",\n"
-               "                default retains original method)\n"
+               "                default retains original method). With a list of\n"
+               "                methods, or 'all', the copy is made once for each\n"
+               "\n"
+               "  -j n[,n...]   use n threads. With a list of thread counts, the\n"
+               "                copy is made once for each. 'sweep' uses 1, 2, 4...\n"
+               "                up to the number of threads suited to file I/O.\n"
+               "                Default is 0: the calling thread does all the work\n"
+               "\n"
+               "  --passes n    repeat each copy n times, reporting the median and\n"
+               "                95th percentile of the times. Default is 1\n"
+               "\n"
+               "  --json        print results as JSON (default): an object for a\n"
+               "                single copy, an array of objects for several\n"
+               "\n"
+               "  --csv         print results as CSV, one row per copy\n"
                "\n"
                "  -16 rgba|all  force 16 bit half float: either just RGBA, or all channels\n"
                "                default retains original type for all channels\n"
@@ -59,6 +79,27 @@ usageMessage (ostream& stream, const char* program_name, bool verbose = false)
     }
 }
 
+vector<string>
+splitList (const char* list)
+{
+    vector<string> items;
+    string         item;
+
+    for (const char* c = list; *c; ++c)
+    {
+        if (*c == ',')
+        {
+            items.push_back (item);
+            item.clear ();
+        }
+        else
+            item += *c;
+    }
+
+    items.push_back (item);
+    return items;
+}
+
 int
 main (int argc, char** argv)
 {
@@ -66,9 +107,12 @@ main (int argc, char** argv)
     const char* outFile  = nullptr;
     const char* inFile   = nullptr;
     int         part     = 0;
-    float       level    = INFINITY;
     int         halfMode = 0; // 0 - leave alone, 1 - just RGBA, 2 - everything
-    Compression compression = Compression::NUM_COMPRESSION_METHODS;
+    int         passes   = 1;
+    MetricsFormat       format = JSON_FORMAT;
+    vector<float>       levels;
+    vector<int>         threadCounts;
+    vector<Compression> compressions;
 
     int i = 1;
 
@@ -106,11 +150,24 @@ main (int argc, char** argv)
                 return 1;
             }
 
-            getCompressionIdFromName (argv[i + 1], compression);
-            if (compression == Compression::NUM_COMPRESSION_METHODS)
+            if (!strcmp (argv[i + 1], "all"))
             {
-                cerr << "unknown compression type " << argv[i + 1] << endl;
-                return 1;
+                for (int c = 0; c < NUM_COMPRESSION_METHODS; ++c)
+                    compressions.push_back (Compression (c));
+            }
+            else
+            {
+                for (const string& name: splitList (argv[i + 1]))
+                {
+                    Compression compression;
+                    getCompressionIdFromName (name, compression);
+                    if (compression == Compression::NUM_COMPRESSION_METHODS)
+                    {
+                        cerr << "unknown compression type " << name << endl;
+                        return 1;
+                    }
+                    compressions.push_back (compression);
+                }
             }
             i += 2;
         }
@@ -137,15 +194,80 @@ main (int argc, char** argv)
                 cerr << "Missing compression level number with -l option\n";
                 return 1;
             }
-            level = atof (argv[i + 1]);
-            if (level < 0)
+            for (const string& value: splitList (argv[i + 1]))
+            {
+                float level = atof (value.c_str ());
+                if (level < 0)
+                {
+                    cerr << "bad level " << level
+                         << " specified to -l option\n";
+                    return 1;
+                }
+                levels.push_back (level);
+            }
+
+            i += 2;
+        }
+        else if (!strcmp (argv[i], "-j"))
+        {
+            if (i > argc - 2)
+            {
+                cerr << "Missing thread count with -j option\n";
+                return 1;
+            }
+            if (!strcmp (argv[i + 1], "sweep"))
+            {
+                int maxThreads = std::max (
+                    1,
+                    int (IlmThread::ThreadPool::estimateThreadCountForFileIO ()));
+                for (int n = 1; n < maxThreads; n *= 2)
+                    threadCounts.push_back (n);
+                threadCounts.push_back (maxThreads);
+            }
+            else
+            {
+                for (const string& value: splitList (argv[i + 1]))
+                {
+                    int threads = atoi (value.c_str ());
+                    if (threads < 0)
+                    {
+                        cerr << "bad thread count " << threads
+                             << " specified to -j option\n";
+                        return 1;
+                    }
+                    threadCounts.push_back (threads);
+                }
+            }
+
+            i += 2;
+        }
+        else if (!strcmp (argv[i], "--passes"))
+        {
+            if (i > argc - 2)
+            {
+                cerr << "Missing pass count with --passes option\n";
+                return 1;
+            }
+            passes = atoi (argv[i + 1]);
+            if (passes < 1)
             {
-                cerr << "bad level " << level << " specified to -l option\n";
+                cerr << "bad pass count " << passes
+                     << " specified to --passes option\n";
                 return 1;
             }
 
             i += 2;
         }
+        else if (!strcmp (argv[i], "--json"))
+        {
+            format = JSON_FORMAT;
+            i += 1;
+        }
+        else if (!strcmp (argv[i], "--csv"))
+        {
+            format = CSV_FORMAT;
+            i += 1;
+        }
         else if (!strcmp (argv[i], "-16"))
         {
             if (i > argc - 2)
@@ -188,7 +310,19 @@ main (int argc, char** argv)
 
     try
     {
-        exrmetrics (inFile, outFile, part, compression, level, halfMode);
+        if (levels.empty ()) levels.push_back (INFINITY);
+        if (threadCounts.empty ()) threadCounts.push_back (0);
+
+        exrmetrics (
+            inFile,
+            outFile,
+            part,
+            compressions,
+            levels,
+            threadCounts,
+            passes,
+            halfMode,
+            format);
     }
     catch (std::exception& what)
     {
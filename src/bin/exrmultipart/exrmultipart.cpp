@@ -20,6 +20,7 @@
 #include <ImfOutputPart.h>
 #include <ImfPartHelper.h>
 #include <ImfPartType.h>
+#include <ImfRawPartCopy.h>
 #include <ImfStringAttribute.h>
 #include <ImfTiledInputPart.h>
 #include <ImfTiledOutputPart.h>
@@ -51,58 +52,6 @@ using namespace OPENEXR_IMF_NAMESPACE;
 #    define IMF_PATH_SEPARATOR "/"
 #endif
 
-void
-copy_tile (
-    MultiPartInputFile&  input,
-    MultiPartOutputFile& output,
-    int                  inPart,
-    int                  outPart)
-{
-    TiledInputPart  in (input, inPart);
-    TiledOutputPart out (output, outPart);
-
-    out.copyPixels (in);
-}
-
-void
-copy_tiledeep (
-    MultiPartInputFile&  input,
-    MultiPartOutputFile& output,
-    int                  inPart,
-    int                  outPart)
-{
-    DeepTiledInputPart  in (input, inPart);
-    DeepTiledOutputPart out (output, outPart);
-
-    out.copyPixels (in);
-}
-
-void
-copy_scanline (
-    MultiPartInputFile&  input,
-    MultiPartOutputFile& output,
-    int                  inPart,
-    int                  outPart)
-{
-    InputPart  in (input, inPart);
-    OutputPart out (output, outPart);
-
-    out.copyPixels (in);
-}
-
-void
-copy_scanlinedeep (
-    MultiPartInputFile&  input,
-    MultiPartOutputFile& output,
-    int                  inPart,
-    int                  outPart)
-{
-    DeepScanLineInputPart  in (input, inPart);
-    DeepScanLineOutputPart out (output, outPart);
-
-    out.copyPixels (in);
-}
-
 bool
 is_number (const std::string& s)
 {
@@ -383,6 +332,7 @@ combine (
     MultiPartInputFile*         infile;
     vector<Header>              headers;
     vector<string>              fornamecheck;
+    vector<string>              filenames;
 
     //
     // parse all inputs
@@ -412,6 +362,7 @@ combine (
             for (int j = 0; j < numparts; j++)
             {
                 inputs.push_back (infile);
+                filenames.push_back (filename);
 
                 Header h = infile->header (j);
                 if (!h.hasName () || forcepartname) h.setName (partname);
@@ -440,6 +391,7 @@ combine (
             }
             //copy header from required part of input to our header array
             inputs.push_back (infile);
+            filenames.push_back (filename);
 
             Header h = infile->header (partnum);
             if (!h.hasName () || forcepartname) h.setName (partname);
@@ -460,13 +412,12 @@ combine (
     if (numInputs > 1) { make_unique_names (headers); }
 
     //
-    // do combine
+    // do combine: the chunks of all parts are copied without
+    // decompressing and recompressing them
     //
 
-    // early bail if need be
-    MultiPartOutputFile temp (outname, &headers[0], headers.size (), override);
-
-    MultiPartOutputFile out (outname, &headers[0], headers.size (), override);
+    RawCopyOutput out;
+    out.fileName = outname;
 
     for (size_t p = 0; p < partnums.size (); p++)
     {
@@ -475,28 +426,34 @@ combine (
         {
             cout << "part " << p << ": "
                  << "scanlineimage" << endl;
-            copy_scanline (*inputs[p], out, partnums[p], p);
         }
         else if (type == TILEDIMAGE)
         {
             cout << "part " << p << ": "
                  << "tiledimage" << endl;
-            copy_tile (*inputs[p], out, partnums[p], p);
         }
         else if (type == DEEPSCANLINE)
         {
             cout << "part " << p << ": "
                  << "deepscanlineimage" << endl;
-            copy_scanlinedeep (*inputs[p], out, partnums[p], p);
         }
         else if (type == DEEPTILE)
         {
             cout << "part " << p << ": "
                  << "deeptile" << endl;
-            copy_tiledeep (*inputs[p], out, partnums[p], p);
         }
+
+        RawPartSource src;
+        src.fileName = filenames[p];
+        src.part     = partnums[p];
+        src.name     = headers[p].name ();
+        if (headers[p].hasView ()) src.view = headers[p].view ();
+
+        out.parts.push_back (src);
     }
 
+    copyRawParts (vector<RawCopyOutput> (1, out), override);
+
     for (size_t k = 0; k < fordelete.size (); k++)
     {
         delete fordelete[k];
@@ -548,39 +505,31 @@ separate (vector<const char*> in, const char* out, bool override)
     filename_check (fornamecheck, in[0]);
 
     //
-    // separate outputs
+    // separate outputs: all output files are written together, so
+    // that the input file is read once, from start to end, even if
+    // the chunks of its parts are interleaved
     //
+    vector<RawCopyOutput> outputs (numOutputs);
+
     for (int p = 0; p < numOutputs; p++)
     {
-        Header header = inputimage->header (p);
-
-        MultiPartOutputFile out (
-            fornamecheck[p].c_str (), &header, 1, override);
-
-        std::string type = header.type ();
-        if (type == "scanlineimage")
-        {
-            cout << "scanlineimage" << endl;
-            copy_scanline (*inputimage, out, p, 0);
-        }
-        else if (type == "tiledimage")
-        {
-            cout << "tiledimage" << endl;
-            copy_tile (*inputimage, out, p, 0);
-        }
-        else if (type == "deepscanline")
-        {
-            cout << "deepscanline" << endl;
-            copy_scanlinedeep (*inputimage, out, p, 0);
-        }
-        else if (type == "deeptile")
-        {
-            cout << "deeptile" << endl;
-            copy_tiledeep (*inputimage, out, p, 0);
-        }
+        std::string type = inputimage->header (p).type ();
+        if (type == "scanlineimage") { cout << "scanlineimage" << endl; }
+        else if (type == "tiledimage") { cout << "tiledimage" << endl; }
+        else if (type == "deepscanline") { cout << "deepscanline" << endl; }
+        else if (type == "deeptile") { cout << "deeptile" << endl; }
+
+        RawPartSource src;
+        src.fileName = filename;
+        src.part     = p;
+
+        outputs[p].fileName = fornamecheck[p];
+        outputs[p].parts.push_back (src);
     }
 
     delete inputimage;
+
+    copyRawParts (outputs);
     cout << "\n"
          << "Separate Success" << endl;
 }
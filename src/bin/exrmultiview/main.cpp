@@ -12,7 +12,9 @@
 //-----------------------------------------------------------------------------
 
 #include "makeMultiView.h"
+#include <IlmThreadPool.h>
 #include <ImfMisc.h>
+#include <ImfThreading.h>
 #include <OpenEXRConfig.h>
 
 #include <exception>
@@ -61,7 +63,17 @@ usageMessage (ostream& stream, const char* program_name, bool verbose = false)
                "                ("
             << compressionNames.c_str ()
             << ",\n"
-               "                default is piz)\n"
+               "                default is piz, or the compression of\n"
+               "                the input files with -m)\n"
+               "\n"
+               "  -m            stores every view in a part of its own\n"
+               "                instead of combining the views' channels\n"
+               "                in one part.  Views whose compression is\n"
+               "                not changed are copied without being\n"
+               "                decompressed.\n"
+               "\n"
+               "  -j n          uses n threads (default depends on the\n"
+               "                number of processors)\n"
                "\n"
                "  -v            verbose mode\n"
                "\n"
@@ -97,9 +109,13 @@ main (int argc, char** argv)
     vector<string>      views;
     vector<const char*> inFiles;
     const char*         outFile     = 0;
-    Compression         compression = PIZ_COMPRESSION;
+    Compression         compression = NUM_COMPRESSION_METHODS;
+    bool                multiPart   = false;
     bool                verbose     = false;
 
+    int threads =
+        ILMTHREAD_NAMESPACE::ThreadPool::estimateThreadCountForFileIO ();
+
     //
     // Parse the command line.
     //
@@ -130,6 +146,33 @@ main (int argc, char** argv)
                 compression = getCompression (argv[i + 1]);
                 i += 2;
             }
+            else if (!strcmp (argv[i], "-m"))
+            {
+                //
+                // Multi-part output
+                //
+
+                multiPart = true;
+                i += 1;
+            }
+            else if (!strcmp (argv[i], "-j"))
+            {
+                //
+                // Set number of threads
+                //
+
+                if (i > argc - 2)
+                    throw invalid_argument (
+                        "Missing thread count for -j argument");
+
+                threads = strtol (argv[i + 1], 0, 0);
+
+                if (threads < 0)
+                    throw invalid_argument (
+                        "Thread count must not be negative");
+
+                i += 2;
+            }
             else if (!strcmp (argv[i], "-v"))
             {
                 //
@@ -203,7 +246,10 @@ main (int argc, char** argv)
         // Load inFiles, and save a combined multi-view image in outFile.
         //
 
-        makeMultiView (views, inFiles, outFile, compression, verbose);
+        setGlobalThreadCount (threads);
+
+        makeMultiView (
+            views, inFiles, outFile, compression, multiPart, verbose);
     }
     catch (const exception& e)
     {
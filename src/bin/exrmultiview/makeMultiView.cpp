@@ -13,43 +13,346 @@
 #include "makeMultiView.h"
 #include "Iex.h"
 #include "Image.h"
+#include <IlmThreadPool.h>
 #include <ImfChannelList.h>
 #include <ImfFrameBuffer.h>
 #include <ImfInputFile.h>
+#include <ImfMultiPartOutputFile.h>
 #include <ImfMultiView.h>
 #include <ImfOutputFile.h>
+#include <ImfOutputPart.h>
+#include <ImfPartType.h>
+#include <ImfRawPartCopy.h>
 #include <ImfStandardAttributes.h>
+#include <ImfThreading.h>
+#include <ImfTiledOutputPart.h>
 #include <algorithm>
+#include <cstring>
+#include <exception>
+#include <filesystem>
 #include <iostream>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <numeric>
 
 #include "namespaceAlias.h"
 using namespace IMF;
 using namespace IMATH_NAMESPACE;
 using namespace std;
+using ILMTHREAD_NAMESPACE::Task;
+using ILMTHREAD_NAMESPACE::TaskGroup;
+using ILMTHREAD_NAMESPACE::ThreadPool;
+
+namespace
+{
+
+//
+// An input file, and the names its channels have in the output.
+//
+
+struct Source
+{
+    InputFile*                   file;
+    vector<pair<string, string>> channels; // input name, output name
+};
+
+//
+// The views are copied in bands of scan lines; only the band that is
+// being written and the one that is being read are held in memory.
+//
+
+struct Band
+{
+    int y1;
+    int y2;
+};
+
+vector<Band>
+computeBands (const Box2i& dw, LineOrder lineOrder, int linesPerBand)
+{
+    vector<Band> bands;
+
+    for (int64_t y = dw.min.y; y <= dw.max.y; y += linesPerBand)
+    {
+        Band band;
+        band.y1 = int (y);
+        band.y2 = int (min<int64_t> (y + linesPerBand - 1, dw.max.y));
+        bands.push_back (band);
+    }
+
+    if (lineOrder == DECREASING_Y) reverse (bands.begin (), bands.end ());
+
+    return bands;
+}
+
+int
+computeLinesPerBand (
+    const vector<Source>& sources, const Header& outHeader, int numThreads)
+{
+    int lines = getCompressionNumScanlines (outHeader.compression ());
+
+    for (const Source& source: sources)
+        lines = max (
+            lines,
+            getCompressionNumScanlines (source.file->header ().compression ()));
+
+    lines *= max (2 * numThreads, 4);
+
+    //
+    // Bands must start at a multiple of the
+    // y sampling rate of every channel.
+    //
+
+    for (ChannelList::ConstIterator i = outHeader.channels ().begin ();
+         i != outHeader.channels ().end ();
+         ++i)
+        lines = lcm (lines, i.channel ().ySampling);
+
+    return lines;
+}
+
+//
+// The pixels of one band, and frame buffers that
+// refer to them, one for every source and one for
+// the output file.
+//
+
+struct BandBuffer
+{
+    unique_ptr<Image>   image;
+    vector<FrameBuffer> inFbs;
+    FrameBuffer         outFb;
+};
 
 void
-makeMultiView (
+allocateBand (
+    BandBuffer&           buffer,
+    const vector<Source>& sources,
+    const Box2i&          dw,
+    const Band&           band)
+{
+    buffer.image.reset (
+        new Image (Box2i (V2i (dw.min.x, band.y1), V2i (dw.max.x, band.y2))));
+
+    buffer.inFbs.assign (sources.size (), FrameBuffer ());
+    buffer.outFb = FrameBuffer ();
+
+    for (size_t i = 0; i < sources.size (); ++i)
+    {
+        const ChannelList& channels = sources[i].file->header ().channels ();
+
+        for (const auto& names: sources[i].channels)
+        {
+            Image& image = *buffer.image;
+
+            image.addChannel (names.second, channels[names.first]);
+            image.channel (names.second).black ();
+
+            buffer.inFbs[i].insert (
+                names.first, image.channel (names.second).slice ());
+            buffer.outFb.insert (
+                names.second, image.channel (names.second).slice ());
+        }
+    }
+}
+
+//
+// Read the part of a band that lies within a source's data window;
+// the rest of the band stays black.
+//
+
+void
+readSource (const Source& source, const FrameBuffer& fb, const Band& band)
+{
+    const Box2i& dw = source.file->header ().dataWindow ();
+
+    int y1 = max (band.y1, dw.min.y);
+    int y2 = min (band.y2, dw.max.y);
+
+    if (y1 > y2) return;
+
+    source.file->setFrameBuffer (fb);
+    source.file->readPixels (y1, y2);
+}
+
+class ReadSourceTask : public Task
+{
+public:
+    ReadSourceTask (
+        TaskGroup*         group,
+        const Source&      source,
+        const FrameBuffer& fb,
+        const Band&        band,
+        mutex&             errorMutex,
+        exception_ptr&     error)
+        : Task (group)
+        , _source (source)
+        , _fb (fb)
+        , _band (band)
+        , _errorMutex (errorMutex)
+        , _error (error)
+    {}
+
+    void execute () override
+    {
+        try
+        {
+            readSource (_source, _fb, _band);
+        }
+        catch (...)
+        {
+            lock_guard<mutex> lock (_errorMutex);
+            if (!_error) _error = current_exception ();
+        }
+    }
+
+private:
+    const Source&      _source;
+    const FrameBuffer& _fb;
+    const Band&        _band;
+    mutex&             _errorMutex;
+    exception_ptr&     _error;
+};
+
+//
+// Copy the channels of the sources to an output file or part, band
+// by band.  If sourceTasks is true, the sources must have been opened
+// without threads of their own, and they are read concurrently in
+// tasks in the thread pool, which also read the next band while the
+// current one is written.  Otherwise the sources are read one after
+// the other, each using the thread pool to decode its pixels.
+//
+
+template <class Out>
+void
+copyBands (
+    const vector<Source>& sources,
+    Out&                  out,
+    const Header&         outHeader,
+    bool                  sourceTasks)
+{
+    const Box2i& dw = outHeader.dataWindow ();
+
+    vector<Band> bands = computeBands (
+        dw,
+        outHeader.lineOrder (),
+        computeLinesPerBand (sources, outHeader, globalThreadCount ()));
+
+    BandBuffer current;
+    BandBuffer next;
+
+    mutex         errorMutex;
+    exception_ptr error;
+
+    for (size_t b = 0; b <= bands.size (); ++b)
+    {
+        {
+            TaskGroup group;
+
+            //
+            // Read band b, in the background if possible ...
+            //
+
+            if (b < bands.size ())
+            {
+                allocateBand (next, sources, dw, bands[b]);
+
+                for (size_t i = 0; i < sources.size (); ++i)
+                {
+                    if (sourceTasks)
+                    {
+                        ThreadPool::addGlobalTask (new ReadSourceTask (
+                            &group,
+                            sources[i],
+                            next.inFbs[i],
+                            bands[b],
+                            errorMutex,
+                            error));
+                    }
+                    else
+                    {
+                        readSource (sources[i], next.inFbs[i], bands[b]);
+                    }
+                }
+            }
+
+            //
+            // ... while band b - 1 is written.
+            //
+
+            if (b > 0)
+            {
+                out.setFrameBuffer (current.outFb);
+                out.writePixels (bands[b - 1].y2 - bands[b - 1].y1 + 1);
+            }
+        }
+
+        if (error) rethrow_exception (error);
+
+        swap (current, next);
+    }
+}
+
+void
+checkNotMultiView (const InputFile& in, const char* fileName)
+{
+    if (hasMultiView (in.header ()))
+    {
+        THROW (
+            IEX_NAMESPACE::NoImplExc,
+            "The image in file "
+                << fileName
+                << " is already a "
+                   "multi-view image.  Cannot combine multiple multi-view "
+                   "images.");
+    }
+}
+
+//
+// The output file is created while the input files are still being
+// read, so it must not be one of them.
+//
+
+void
+checkNotInput (const vector<const char*>& inFileNames, const char* outFileName)
+{
+    for (const char* inFileName: inFileNames)
+    {
+        std::error_code ec;
+
+        if (!strcmp (inFileName, outFileName) ||
+            std::filesystem::equivalent (
+                std::filesystem::path (inFileName),
+                std::filesystem::path (outFileName),
+                ec))
+        {
+            THROW (
+                IEX_NAMESPACE::ArgExc,
+                "Input file " << inFileName
+                              << " cannot also be the output file.");
+        }
+    }
+}
+
+//
+// Store every view in a part of its own.
+//
+
+void
+makeMultiPartMultiView (
     const vector<string>&      viewNames,
     const vector<const char*>& inFileNames,
     const char*                outFileName,
     Compression                compression,
     bool                       verbose)
 {
-    Header      header;
-    Image       image;
-    FrameBuffer outFb;
-
-    //
-    // Find the size of the dataWindow, check files
-    //
-
-    Box2i d;
+    vector<unique_ptr<InputFile>> inputs;
+    vector<Header>                headers;
+    vector<bool>                  recompress;
 
     for (size_t i = 0; i < viewNames.size (); ++i)
     {
-        InputFile in (inFileNames[i]);
-
         if (verbose)
         {
             cout << "reading file " << inFileNames[i]
@@ -58,37 +361,141 @@ makeMultiView (
                  << viewNames[i] << " view" << endl;
         }
 
-        if (hasMultiView (in.header ()))
+        inputs.emplace_back (new InputFile (inFileNames[i]));
+        checkNotMultiView (*inputs[i], inFileNames[i]);
+
+        Header header = inputs[i]->header ();
+
+        recompress.push_back (
+            compression != NUM_COMPRESSION_METHODS &&
+            compression != header.compression ());
+
+        if (recompress[i])
         {
-            THROW (
-                IEX_NAMESPACE::NoImplExc,
-                "The image in file "
-                    << inFileNames[i]
-                    << " is already a "
-                       "multi-view image.  Cannot combine multiple multi-view "
-                       "images.");
+            header.compression () = compression;
+            header.erase ("tiles");
+            header.setType (SCANLINEIMAGE);
+        }
+        else if (!header.hasType ())
+        {
+            header.setType (
+                header.hasTileDescription () ? TILEDIMAGE : SCANLINEIMAGE);
         }
 
-        header = in.header ();
-        if (i == 0) { d = header.dataWindow (); }
-        else { d.extendBy (header.dataWindow ()); }
+        header.setName (viewNames[i]);
+        header.setView (viewNames[i]);
+        headers.push_back (header);
     }
 
-    image.resize (d);
+    if (verbose) cout << "writing file " << outFileName << endl;
 
-    header.dataWindow () = d;
+    if (find (recompress.begin (), recompress.end (), true) ==
+        recompress.end ())
+    {
+        //
+        // All views keep their compression; copy the compressed
+        // chunks of all input files in one pass.
+        //
 
-    // blow away channels; we'll rebuild them
-    header.channels () = ChannelList ();
+        inputs.clear ();
+
+        RawCopyOutput output;
+        output.fileName = outFileName;
+
+        for (size_t i = 0; i < viewNames.size (); ++i)
+        {
+            RawPartSource part;
+            part.fileName = inFileNames[i];
+            part.name     = viewNames[i];
+            part.view     = viewNames[i];
+            output.parts.push_back (part);
+        }
+
+        copyRawParts (vector<RawCopyOutput> (1, output), true);
+        return;
+    }
+
+    MultiPartOutputFile out (
+        outFileName, headers.data (), int (headers.size ()), true);
+
+    for (size_t i = 0; i < viewNames.size (); ++i)
+    {
+        if (!recompress[i])
+        {
+            //
+            // Copy the compressed pixels of this view as they are.
+            //
+
+            if (headers[i].hasTileDescription ())
+            {
+                TiledOutputPart part (out, int (i));
+                part.copyPixels (*inputs[i]);
+            }
+            else
+            {
+                OutputPart part (out, int (i));
+                part.copyPixels (*inputs[i]);
+            }
+
+            continue;
+        }
+
+        Source source;
+        source.file = inputs[i].get ();
+
+        const ChannelList& channels = headers[i].channels ();
+
+        for (ChannelList::ConstIterator j = channels.begin ();
+             j != channels.end ();
+             ++j)
+            source.channels.push_back (make_pair (j.name (), j.name ()));
+
+        OutputPart part (out, int (i));
+        copyBands (vector<Source> (1, source), part, headers[i], false);
+    }
+}
+
+} // namespace
+
+void
+makeMultiView (
+    const vector<string>&      viewNames,
+    const vector<const char*>& inFileNames,
+    const char*                outFileName,
+    Compression                compression,
+    bool                       multiPart,
+    bool                       verbose)
+{
+    checkNotInput (inFileNames, outFileName);
+
+    if (multiPart)
+    {
+        makeMultiPartMultiView (
+            viewNames, inFileNames, outFileName, compression, verbose);
+        return;
+    }
+
+    //
+    // With enough views to keep all threads busy, the views are read
+    // concurrently, each one by a single thread.  Otherwise they are
+    // read one at a time, with all threads decoding the same view.
+    //
+
+    int  numThreads  = globalThreadCount ();
+    bool sourceTasks =
+        numThreads > 1 && viewNames.size () >= size_t (numThreads);
+
+    vector<unique_ptr<InputFile>> inputs;
+    Header                        header;
 
     //
-    // Read the input image files
+    // Find the size of the dataWindow, check files
     //
 
+    Box2i d;
+
     for (size_t i = 0; i < viewNames.size (); ++i)
     {
-        InputFile in (inFileNames[i]);
-
         if (verbose)
         {
             cout << "reading file " << inFileNames[i]
@@ -97,45 +504,52 @@ makeMultiView (
                  << viewNames[i] << " view" << endl;
         }
 
-        FrameBuffer inFb;
+        inputs.emplace_back (
+            new InputFile (inFileNames[i], sourceTasks ? 0 : numThreads));
+        checkNotMultiView (*inputs[i], inFileNames[i]);
 
-        for (ChannelList::ConstIterator j = in.header ().channels ().begin ();
-             j != in.header ().channels ().end ();
-             ++j)
-        {
-            const Channel& inChannel  = j.channel ();
-            string         inChanName = j.name ();
-            string outChanName = insertViewName (inChanName, viewNames, i);
+        header = inputs[i]->header ();
+        if (i == 0) { d = header.dataWindow (); }
+        else { d.extendBy (header.dataWindow ()); }
+    }
+
+    header.dataWindow () = d;
+
+    // blow away channels; we'll rebuild them
+    header.channels () = ChannelList ();
+
+    vector<Source> sources (viewNames.size ());
 
-            image.addChannel (outChanName, inChannel);
-            image.channel (outChanName).black ();
+    for (size_t i = 0; i < viewNames.size (); ++i)
+    {
+        const ChannelList& channels = inputs[i]->header ().channels ();
 
-            header.channels ().insert (outChanName, inChannel);
+        sources[i].file = inputs[i].get ();
 
-            inFb.insert (inChanName, image.channel (outChanName).slice ());
-            outFb.insert (outChanName, image.channel (outChanName).slice ());
-        }
+        for (ChannelList::ConstIterator j = channels.begin ();
+             j != channels.end ();
+             ++j)
+        {
+            string outChanName = insertViewName (j.name (), viewNames, i);
 
-        in.setFrameBuffer (inFb);
-        in.readPixels (
-            in.header ().dataWindow ().min.y, in.header ().dataWindow ().max.y);
+            header.channels ().insert (outChanName, j.channel ());
+            sources[i].channels.push_back (make_pair (j.name (), outChanName));
+        }
     }
 
     //
     // Write the output image file
     //
 
-    {
-        header.compression () = compression;
-        addMultiView (header, viewNames);
-
-        OutputFile out (outFileName, header);
+    header.erase ("tiles");
+    if (header.hasType ()) header.setType (SCANLINEIMAGE);
+    header.compression () =
+        compression == NUM_COMPRESSION_METHODS ? PIZ_COMPRESSION : compression;
+    addMultiView (header, viewNames);
 
-        if (verbose) cout << "writing file " << outFileName << endl;
+    OutputFile out (outFileName, header);
 
-        out.setFrameBuffer (outFb);
+    if (verbose) cout << "writing file " << outFileName << endl;
 
-        out.writePixels (
-            header.dataWindow ().max.y - header.dataWindow ().min.y + 1);
-    }
+    copyBands (sources, out, header, sourceTasks);
 }
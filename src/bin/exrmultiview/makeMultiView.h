@@ -18,11 +18,22 @@
 #include <string>
 #include <vector>
 
+//
+// Combine the views in inFileNames into outFileName.  If multiPart
+// is false, the output is a single part that contains the channels
+// of all views; otherwise every view is stored in a part of its own,
+// and the compressed pixels are copied as they are unless they have
+// to be recompressed.  NUM_COMPRESSION_METHODS for compression
+// selects PIZ for single-part output, and keeps the compression
+// of every view for multi-part output.
+//
+
 void makeMultiView (
     const std::vector<std::string>& viewNames,
     const std::vector<const char*>& inFileNames,
     const char*                     outFileName,
     IMF::Compression                compression,
+    bool                            multiPart,
     bool                            verbose);
 
 #endif
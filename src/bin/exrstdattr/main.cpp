@@ -11,31 +11,30 @@
 //-----------------------------------------------------------------------------
 
 #include <ImathNamespace.h>
-#include <ImfDeepScanLineInputPart.h>
-#include <ImfDeepScanLineOutputPart.h>
-#include <ImfDeepTiledInputPart.h>
-#include <ImfDeepTiledOutputPart.h>
-#include <ImfInputFile.h>
-#include <ImfInputPart.h>
 #include <ImfIntAttribute.h>
 #include <ImfMultiPartInputFile.h>
 #include <ImfMultiPartOutputFile.h>
 #include <ImfNamespace.h>
-#include <ImfOutputFile.h>
-#include <ImfOutputPart.h>
 #include <ImfPartType.h>
 #include <ImfStandardAttributes.h>
-#include <ImfTiledInputPart.h>
-#include <ImfTiledOutputFile.h>
-#include <ImfTiledOutputPart.h>
 #include <ImfVecAttribute.h>
 #include <ImfMisc.h>
+#include <ImfStdIO.h>
 #include <OpenEXRConfig.h>
 
+#include <openexr.h>
+
+#include <Iex.h>
+
+#include <errno.h>
 #include <exception>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
 #include <sstream>
 #include <map>
+#include <stdint.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <string>
@@ -47,16 +46,22 @@ using namespace IMATH_NAMESPACE;
 void
 usageMessage (ostream& stream, const char* program_name, bool verbose = false)
 {
-    stream << "Usage: " << program_name << " [commands] infile outfile" << endl;
+    stream << "Usage: " << program_name << " [commands] infile [outfile]"
+           << endl;
 
     if (verbose)
         stream
             << "\n"
                "Read OpenEXR image file infile, set the values of one\n"
                "or more attributes in the headers of the file, and save\n"
-               "the result in outfile.  Infile and outfile must not refer\n"
-               "to the same file (the program cannot edit an image file "
-               "\"in place\").\n"
+               "the result in outfile.  The pixel data are copied as they\n"
+               "are, without decompressing and recompressing them.\n"
+               "\n"
+               "If outfile is omitted, or if it is the same as infile,\n"
+               "infile is edited \"in place.\"  If the new values of the\n"
+               "attributes take up exactly as much space as the old ones,\n"
+               "only the headers are overwritten; otherwise the file is\n"
+               "rewritten.\n"
                "\n"
                "Command for selecting headers:\n"
                "\n"
@@ -608,6 +613,413 @@ getPart (const char attrName[], int argc, char** argv, int& i, int& part)
     i += 2;
 }
 
+//
+// Error messages from the Core library are kept, rather than printed,
+// so that the program can report them, or try something else instead.
+//
+
+string coreErrorMessage;
+
+void
+coreErrorHandler (exr_const_context_t, exr_result_t, const char* msg)
+{
+    coreErrorMessage = msg;
+}
+
+string
+coreError (exr_result_t rv)
+{
+    string message;
+    message.swap (coreErrorMessage);
+
+    return message.empty () ? exr_get_default_error_message (rv) : message;
+}
+
+//
+// Set the value of an attribute in a header of a file that is
+// being updated in place.  Returns false if the file does not
+// have the attribute yet, if the new value would take up more or
+// less space in the file than the old one, or if the attribute's
+// type cannot be handled.
+//
+
+bool
+setCoreAttr (exr_context_t f, int part, const SetAttr& a)
+{
+    const char*      n    = a.name.c_str ();
+    const Attribute* attr = a.attr;
+    exr_result_t     rv;
+
+    if (auto x = dynamic_cast<const FloatAttribute*> (attr))
+    {
+        rv = exr_attr_set_float (f, part, n, x->value ());
+    }
+    else if (auto x = dynamic_cast<const IntAttribute*> (attr))
+    {
+        rv = exr_attr_set_int (f, part, n, x->value ());
+    }
+    else if (auto x = dynamic_cast<const StringAttribute*> (attr))
+    {
+        rv = exr_attr_set_string (f, part, n, x->value ().c_str ());
+    }
+    else if (auto x = dynamic_cast<const V2fAttribute*> (attr))
+    {
+        exr_attr_v2f_t v = {x->value ().x, x->value ().y};
+        rv               = exr_attr_set_v2f (f, part, n, &v);
+    }
+    else if (auto x = dynamic_cast<const ChromaticitiesAttribute*> (attr))
+    {
+        const Chromaticities&     c  = x->value ();
+        exr_attr_chromaticities_t cc = {
+            c.red.x,
+            c.red.y,
+            c.green.x,
+            c.green.y,
+            c.blue.x,
+            c.blue.y,
+            c.white.x,
+            c.white.y};
+
+        rv = exr_attr_set_chromaticities (f, part, n, &cc);
+    }
+    else if (auto x = dynamic_cast<const RationalAttribute*> (attr))
+    {
+        exr_attr_rational_t r = {x->value ().n, x->value ().d};
+        rv                    = exr_attr_set_rational (f, part, n, &r);
+    }
+    else if (auto x = dynamic_cast<const KeyCodeAttribute*> (attr))
+    {
+        const KeyCode&     k  = x->value ();
+        exr_attr_keycode_t kc = {
+            k.filmMfcCode (),
+            k.filmType (),
+            k.prefix (),
+            k.count (),
+            k.perfOffset (),
+            k.perfsPerFrame (),
+            k.perfsPerCount ()};
+
+        rv = exr_attr_set_keycode (f, part, n, &kc);
+    }
+    else if (auto x = dynamic_cast<const TimeCodeAttribute*> (attr))
+    {
+        exr_attr_timecode_t t = {
+            x->value ().timeAndFlags (), x->value ().userData ()};
+
+        rv = exr_attr_set_timecode (f, part, n, &t);
+    }
+    else if (auto x = dynamic_cast<const EnvmapAttribute*> (attr))
+    {
+        rv = exr_attr_set_envmap (f, part, n, exr_envmap_t (x->value ()));
+    }
+    else
+    {
+        return false;
+    }
+
+    coreErrorMessage.clear ();
+    return rv == EXR_ERR_SUCCESS;
+}
+
+//
+// Try to set the values of the attributes by overwriting the headers
+// of an image file in place.  Returns false, without modifying the
+// file, if the new headers would not be exactly as large as the old
+// ones.
+//
+
+bool
+updateHeadersInPlace (
+    const char fileName[], int numParts, const SetAttrVector& attrs)
+{
+    exr_context_initializer_t init = EXR_DEFAULT_CONTEXT_INITIALIZER;
+    init.error_handler_fn          = &coreErrorHandler;
+
+    exr_context_t f;
+    exr_result_t  rv = exr_start_inplace_header_update (&f, fileName, &init);
+
+    if (rv != EXR_ERR_SUCCESS)
+        THROW (
+            IEX_NAMESPACE::InputExc,
+            "Cannot open image file \"" << fileName << "\" for update. "
+                                        << coreError (rv));
+
+    bool updated = true;
+
+    for (size_t i = 0; i < attrs.size () && updated; ++i)
+    {
+        for (int part = 0; part < numParts && updated; ++part)
+        {
+            if (attrs[i].part == -1 || attrs[i].part == part)
+                updated = setCoreAttr (f, part, attrs[i]);
+        }
+    }
+
+    if (updated)
+    {
+        rv = exr_write_header (f);
+
+        if (rv == EXR_ERR_MODIFY_SIZE_CHANGE)
+        {
+            updated = false;
+        }
+        else if (rv != EXR_ERR_SUCCESS)
+        {
+            string message = coreError (rv);
+            exr_finish (&f);
+
+            THROW (
+                IEX_NAMESPACE::IoExc,
+                "Cannot write the headers of image file \""
+                    << fileName << "\". " << message);
+        }
+    }
+
+    coreErrorMessage.clear ();
+    exr_finish (&f);
+    return updated;
+}
+
+//
+// Write a copy of image file inFileName, with new headers, to file
+// outFileName.  Everything that follows the headers in the input
+// file is copied byte for byte, without decompressing the pixels;
+// only the offsets in the chunk offset tables change, by the
+// difference in size between the old and the new headers.
+//
+
+void
+rewriteFile (
+    const char inFileName[],
+    const char outFileName[],
+    const vector<Header>& headers)
+{
+    //
+    // Find where the headers of the input file end,
+    // and how many chunk offsets follow them.
+    //
+
+    exr_context_initializer_t init = EXR_DEFAULT_CONTEXT_INITIALIZER;
+    init.error_handler_fn          = &coreErrorHandler;
+
+    exr_context_t f;
+    exr_result_t  rv = exr_start_read (&f, inFileName, &init);
+
+    if (rv != EXR_ERR_SUCCESS)
+        THROW (
+            IEX_NAMESPACE::InputExc,
+            "Cannot read image file \"" << inFileName << "\". "
+                                        << coreError (rv));
+
+    uint64_t oldHeaderSize = 0;
+    uint64_t numChunks     = 0;
+    int      numParts      = 0;
+
+    rv = exr_get_chunk_table_offset (f, 0, &oldHeaderSize);
+
+    if (rv == EXR_ERR_SUCCESS) rv = exr_get_count (f, &numParts);
+
+    for (int part = 0; part < numParts && rv == EXR_ERR_SUCCESS; ++part)
+    {
+        int32_t n = 0;
+        rv        = exr_get_chunk_count (f, part, &n);
+        numChunks += uint64_t (n);
+    }
+
+    exr_finish (&f);
+
+    if (rv != EXR_ERR_SUCCESS)
+        THROW (
+            IEX_NAMESPACE::InputExc,
+            "Cannot read image file \"" << inFileName << "\". "
+                                        << coreError (rv));
+
+    //
+    // Generate the new headers, followed by empty chunk offset tables.
+    // This checks the headers the same way as when a new file is
+    // written.
+    //
+
+    string newHeaders;
+
+    {
+        StdOSStream         os;
+        MultiPartOutputFile out (os, &headers[0], int (headers.size ()));
+        newHeaders = os.str ();
+    }
+
+    uint64_t newNumChunks = 0;
+
+    for (size_t i = 0; i < headers.size (); ++i)
+        newNumChunks += uint64_t (getChunkOffsetTableSize (headers[i]));
+
+    uint64_t tableSize = numChunks * sizeof (uint64_t);
+
+    if (newNumChunks != numChunks || newHeaders.size () < tableSize)
+        THROW (
+            IEX_NAMESPACE::LogicExc,
+            "The new headers for image file \""
+                << inFileName
+                << "\" do not describe the same number of chunks "
+                   "as the old headers.");
+
+    uint64_t newHeaderSize = newHeaders.size () - tableSize;
+
+    //
+    // Copy the file.
+    //
+
+    ifstream is (inFileName, ios_base::binary);
+
+    if (!is)
+        IEX_NAMESPACE::throwErrnoExc (
+            string ("Cannot open image file \"") + inFileName + "\". %T.");
+
+    ofstream os (outFileName, ios_base::binary | ios_base::trunc);
+
+    if (!os)
+        IEX_NAMESPACE::throwErrnoExc (
+            string ("Cannot open image file \"") + outFileName + "\". %T.");
+
+    os.write (newHeaders.data (), streamsize (newHeaderSize));
+
+    vector<char> buffer (tableSize);
+
+    is.seekg (streamoff (oldHeaderSize));
+    is.read (buffer.data (), streamsize (tableSize));
+
+    if (uint64_t (is.gcount ()) != tableSize)
+        THROW (
+            IEX_NAMESPACE::InputExc,
+            "Cannot read the chunk offset tables of image file \""
+                << inFileName << "\".");
+
+    for (uint64_t i = 0; i < numChunks; ++i)
+    {
+        unsigned char* b = reinterpret_cast<unsigned char*> (&buffer[i * 8]);
+        uint64_t       offset = 0;
+
+        for (int j = 7; j >= 0; --j)
+            offset = (offset << 8) | b[j];
+
+        //
+        // Offsets that do not point past the old headers are
+        // invalid, for example in an incomplete file; leave
+        // them alone.
+        //
+
+        if (offset < oldHeaderSize) continue;
+
+        offset = offset - oldHeaderSize + newHeaderSize;
+
+        for (int j = 0; j < 8; ++j, offset >>= 8)
+            b[j] = static_cast<unsigned char> (offset & 0xff);
+    }
+
+    os.write (buffer.data (), streamsize (tableSize));
+
+    buffer.resize (8 << 20);
+
+    while (is)
+    {
+        is.read (buffer.data (), streamsize (buffer.size ()));
+        os.write (buffer.data (), is.gcount ());
+    }
+
+    if (is.bad ())
+        IEX_NAMESPACE::throwErrnoExc (
+            string ("Cannot read image file \"") + inFileName + "\". %T.");
+
+    os.close ();
+
+    if (!os)
+        IEX_NAMESPACE::throwErrnoExc (
+            string ("Cannot write image file \"") + outFileName + "\". %T.");
+}
+
+//
+// Check whether two names refer to the same existing file, even if
+// the names differ, for example "x.exr" and "./x.exr", or a link.
+//
+
+bool
+sameFile (const char fileName1[], const char fileName2[])
+{
+    std::error_code ec;
+
+    return std::filesystem::equivalent (
+        std::filesystem::path (fileName1),
+        std::filesystem::path (fileName2),
+        ec);
+}
+
+//
+// Create a new, empty temporary file next to file fileName, and
+// return its name.  Existing files are never reused.
+//
+
+string
+createTmpFile (const char fileName[])
+{
+    for (int i = 0; i < 1000; ++i)
+    {
+        stringstream ss;
+        ss << fileName << ".tmp";
+        if (i > 0) ss << i;
+
+        string tmpFileName = ss.str ();
+        FILE*  f           = fopen (tmpFileName.c_str (), "wbx");
+
+        if (f)
+        {
+            fclose (f);
+            return tmpFileName;
+        }
+
+        if (errno != EEXIST) break;
+    }
+
+    IEX_NAMESPACE::throwErrnoExc (
+        string ("Cannot create a temporary file for image file \"") +
+        fileName + "\". %T.");
+    return string ();
+}
+
+//
+// Replace image file fileName with a rewritten copy.  The copy is
+// written to a temporary file next to the original first, so that
+// the original stays intact if anything goes wrong.
+//
+
+void
+rewriteFileInPlace (const char fileName[], const vector<Header>& headers)
+{
+    string tmpFileName = createTmpFile (fileName);
+
+    try
+    {
+        rewriteFile (fileName, tmpFileName.c_str (), headers);
+    }
+    catch (...)
+    {
+        remove (tmpFileName.c_str ());
+        throw;
+    }
+
+#ifdef _WIN32
+    //
+    // rename() does not replace existing files on Windows.
+    //
+
+    remove (fileName);
+#endif
+
+    if (rename (tmpFileName.c_str (), fileName))
+        IEX_NAMESPACE::throwErrnoExc (
+            "Cannot rename \"" + tmpFileName + "\" to \"" + fileName +
+            "\". %T.");
+}
+
 int
 main (int argc, char** argv)
 {
@@ -786,128 +1198,118 @@ main (int argc, char** argv)
         }
 
         if (inFileName == 0) throw invalid_argument ("Missing input filename");
-        if (outFileName == 0) throw invalid_argument ("Missing input filename");
-
-        if (!strcmp (inFileName, outFileName))
-            throw invalid_argument ("Input and output cannot be the same file");
 
         //
-        // Load the headers from the input file
-        // and add attributes to the headers.
+        // An output file that is the input file under another name,
+        // for example "./x.exr", is edited in place as well; writing
+        // a copy to it would truncate the input while it is read.
         //
 
-        MultiPartInputFile in (inFileName);
-        int                numParts = in.parts ();
-        vector<Header>     headers;
+        bool inPlace = outFileName == 0 || !strcmp (inFileName, outFileName) ||
+                       sameFile (inFileName, outFileName);
 
         //
-        // Treat attributes added to a header in its constructor
-        // as critical and don't allow them to be deleted.
-        // 'name' and 'type' are only required in multipart
-        // file and errors will be reported if they
-        // are erased
+        // Load the headers from the input file
+        // and add attributes to the headers.
         //
-        Header stdHdr;
 
-        for (int part = 0; part < numParts; ++part)
+        int            numParts = 0;
+        vector<Header> headers;
+
         {
-            Header h = in.header (part);
+            MultiPartInputFile in (inFileName);
+            numParts = in.parts ();
 
             //
-            // process attributes to erase first, so they can be reinserted
-            // with a different type
+            // Treat attributes added to a header in its constructor
+            // as critical and don't allow them to be deleted.
+            // 'name' and 'type' are only required in multipart
+            // file and errors will be reported if they
+            // are erased
             //
-            for (size_t i = 0 ; i < eraseattrs.size() ; ++i)
+            Header stdHdr;
+
+            for (int part = 0; part < numParts; ++part)
             {
-                const EraseAttr& attr = eraseattrs[i];
-                if (attr.part == -1 || attr.part == part)
+                Header h = in.header (part);
+
+                //
+                // process attributes to erase first, so they can be reinserted
+                // with a different type
+                //
+                for (size_t i = 0 ; i < eraseattrs.size() ; ++i)
                 {
-                    if( stdHdr.find(attr.name)!=stdHdr.end() )
+                    const EraseAttr& attr = eraseattrs[i];
+                    if (attr.part == -1 || attr.part == part)
                     {
-                        cerr << "Cannot erase attribute " << attr.name
+                        if( stdHdr.find(attr.name)!=stdHdr.end() )
+                        {
+                            cerr << "Cannot erase attribute " << attr.name
+                                 << ". "
+                                 << "It is an essential attribute" << endl;
+                            return 1;
+                        }
+                        h.erase( attr.name );
+                    }
+                    else if (attr.part < 0 || attr.part >= numParts)
+                    {
+                        cerr << "Invalid part number " << attr.part
                              << ". "
-                             << "It is an essential attribute" << endl;
+                                "Part numbers in file "
+                             << inFileName
+                             << " "
+                                "go from 0 to "
+                             << numParts - 1 << "." << endl;
+
                         return 1;
                     }
-                    h.erase( attr.name );
                 }
-                else if (attr.part < 0 || attr.part >= numParts)
-                {
-                    cerr << "Invalid part number " << attr.part
-                         << ". "
-                            "Part numbers in file "
-                         << inFileName
-                         << " "
-                            "go from 0 to "
-                         << numParts - 1 << "." << endl;
-
-                    return 1;
-                }
-            }
 
 
-            for (size_t i = 0; i < attrs.size (); ++i)
-            {
-                const SetAttr& attr = attrs[i];
-
-                if (attr.part == -1 || attr.part == part)
-                {
-                    h.insert (attr.name, *attr.attr);
-                }
-                else if (attr.part < 0 || attr.part >= numParts)
+                for (size_t i = 0; i < attrs.size (); ++i)
                 {
-                    cerr << "Invalid part number " << attr.part
-                         << ". "
-                            "Part numbers in file "
-                         << inFileName
-                         << " "
-                            "go from 0 to "
-                         << numParts - 1 << "." << endl;
-
-                    return 1;
+                    const SetAttr& attr = attrs[i];
+
+                    if (attr.part == -1 || attr.part == part)
+                    {
+                        h.insert (attr.name, *attr.attr);
+                    }
+                    else if (attr.part < 0 || attr.part >= numParts)
+                    {
+                        cerr << "Invalid part number " << attr.part
+                             << ". "
+                                "Part numbers in file "
+                             << inFileName
+                             << " "
+                                "go from 0 to "
+                             << numParts - 1 << "." << endl;
+
+                        return 1;
+                    }
                 }
-            }
 
-            headers.push_back (h);
+                headers.push_back (h);
+            }
         }
 
         //
-        // Create an output file with the modified headers,
-        // and copy the pixels from the input file to the
-        // output file.
+        // Write the modified headers.  When the input file is edited in
+        // place, and the values of the attributes change without adding
+        // or removing any, the new headers are usually the same size as
+        // the old ones, and they can overwrite the old ones directly.
+        // Otherwise a new file is written, with a copy of the chunk
+        // offset tables and pixel data of the input file.
         //
 
-        MultiPartOutputFile out (outFileName, &headers[0], numParts);
-
-        for (int p = 0; p < numParts; ++p)
+        if (!inPlace)
         {
-            const Header& h    = in.header (p);
-            const string& type = h.type ();
-
-            if (type == SCANLINEIMAGE)
-            {
-                InputPart  inPart (in, p);
-                OutputPart outPart (out, p);
-                outPart.copyPixels (inPart);
-            }
-            else if (type == TILEDIMAGE)
-            {
-                TiledInputPart  inPart (in, p);
-                TiledOutputPart outPart (out, p);
-                outPart.copyPixels (inPart);
-            }
-            else if (type == DEEPSCANLINE)
-            {
-                DeepScanLineInputPart  inPart (in, p);
-                DeepScanLineOutputPart outPart (out, p);
-                outPart.copyPixels (inPart);
-            }
-            else if (type == DEEPTILE)
-            {
-                DeepTiledInputPart  inPart (in, p);
-                DeepTiledOutputPart outPart (out, p);
-                outPart.copyPixels (inPart);
-            }
+            rewriteFile (inFileName, outFileName, headers);
+        }
+        else if (
+            !eraseattrs.empty () ||
+            !updateHeadersInPlace (inFileName, numParts, attrs))
+        {
+            rewriteFileInPlace (inFileName, headers);
         }
 
         for (size_t i = 0; i < attrs.size (); i++)
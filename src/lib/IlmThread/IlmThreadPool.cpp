@@ -14,10 +14,13 @@
 #include "IlmThread.h"
 #include "IlmThreadSemaphore.h"
 
+#include <algorithm>
 #include <atomic>
+#include <fstream>
 #include <limits>
 #include <memory>
 #include <mutex>
+#include <string>
 #include <thread>
 #include <vector>
 
@@ -27,6 +30,11 @@
 #    include <unistd.h>
 #endif
 
+#if defined(__linux__)
+#    include <pthread.h>
+#    include <sched.h>
+#endif
+
 ILMTHREAD_INTERNAL_NAMESPACE_SOURCE_ENTER
 
 #if ILMTHREAD_THREADING_ENABLED
@@ -36,6 +44,188 @@ ILMTHREAD_INTERNAL_NAMESPACE_SOURCE_ENTER
 namespace
 {
 
+#ifdef ENABLE_THREADING
+// group of the task currently executing on this thread
+thread_local TaskGroup* tCurrentGroup = nullptr;
+
+// bumped whenever a task group is cancelled, so providers know to
+// purge their queues of tasks which should no longer run
+std::atomic<uint64_t> gCancelEpoch (0);
+
+struct CurrentGroupScope
+{
+    explicit CurrentGroupScope (TaskGroup* g) : _prev (tCurrentGroup)
+    {
+        tCurrentGroup = g;
+    }
+    ~CurrentGroupScope () { tCurrentGroup = _prev; }
+
+    CurrentGroupScope (const CurrentGroupScope&)            = delete;
+    CurrentGroupScope& operator= (const CurrentGroupScope&) = delete;
+
+    TaskGroup* _prev;
+};
+
+// NUMA node of the pool worker running on this thread, -1 otherwise
+thread_local int tWorkerNode = -1;
+
+//
+// The processors usable by this process, grouped by NUMA node. On
+// linux this is discovered from /sys, everywhere else (or when /sys
+// is not available) all processors are considered a single node.
+//
+struct CpuTopology
+{
+    CpuTopology ();
+
+    int nodeOfCpu (int cpu) const
+    {
+        if (cpu < 0 || static_cast<size_t> (cpu) >= cpuNode.size ())
+            return -1;
+        return cpuNode[static_cast<size_t> (cpu)];
+    }
+
+    std::vector<std::vector<int>> nodeCpus; // usable cpus of each node
+    std::vector<int>              cpuNode;  // node index of each cpu, or -1
+};
+
+#    if defined(__linux__)
+// parses the kernel's cpu / node list format, i.e. "0-3,8,10-11"
+std::vector<int>
+parseCpuList (const std::string& str)
+{
+    std::vector<int> ret;
+    size_t           pos = 0;
+    while (pos < str.size ())
+    {
+        size_t end = str.find (',', pos);
+        if (end == std::string::npos) end = str.size ();
+
+        std::string range = str.substr (pos, end - pos);
+        size_t      dash  = range.find ('-');
+        try
+        {
+            int first = std::stoi (range.substr (0, dash));
+            int last  = first;
+            if (dash != std::string::npos)
+                last = std::stoi (range.substr (dash + 1));
+            for (int c = first; c <= last; ++c)
+                ret.push_back (c);
+        }
+        catch (...)
+        {
+            // whitespace / newline, just skip
+        }
+        pos = end + 1;
+    }
+    return ret;
+}
+
+bool
+readSysList (const std::string& path, std::vector<int>& out)
+{
+    std::ifstream in (path.c_str ());
+    std::string   line;
+    if (!in || !std::getline (in, line)) return false;
+    out = parseCpuList (line);
+    return true;
+}
+#    endif
+
+CpuTopology::CpuTopology ()
+{
+#    if defined(__linux__)
+    cpu_set_t allowed;
+    CPU_ZERO (&allowed);
+    bool haveMask = (sched_getaffinity (0, sizeof (allowed), &allowed) == 0);
+
+    std::vector<int> nodes;
+    if (readSysList ("/sys/devices/system/node/online", nodes))
+    {
+        for (int n: nodes)
+        {
+            std::vector<int> cpus;
+            if (!readSysList (
+                    "/sys/devices/system/node/node" + std::to_string (n) +
+                        "/cpulist",
+                    cpus))
+                continue;
+
+            std::vector<int> usable;
+            for (int c: cpus)
+            {
+                if (c < 0 || c >= CPU_SETSIZE) continue;
+                if (haveMask && !CPU_ISSET (c, &allowed)) continue;
+                usable.push_back (c);
+            }
+
+            // nodes without cpus (i.e. memory only) can't run workers
+            if (!usable.empty ()) nodeCpus.push_back (usable);
+        }
+    }
+
+    if (nodeCpus.empty () && haveMask)
+    {
+        std::vector<int> usable;
+        for (int c = 0; c < CPU_SETSIZE; ++c)
+            if (CPU_ISSET (c, &allowed)) usable.push_back (c);
+        if (!usable.empty ()) nodeCpus.push_back (usable);
+    }
+
+    for (size_t n = 0; n < nodeCpus.size (); ++n)
+    {
+        for (int c: nodeCpus[n])
+        {
+            if (static_cast<size_t> (c) >= cpuNode.size ())
+                cpuNode.resize (static_cast<size_t> (c) + 1, -1);
+            cpuNode[static_cast<size_t> (c)] = static_cast<int> (n);
+        }
+    }
+#    endif
+
+    // no processor information, pretend to be a single node which
+    // the workers are not pinned to
+    if (nodeCpus.empty ()) nodeCpus.resize (1);
+}
+
+const CpuTopology&
+cpuTopology ()
+{
+    static CpuTopology topo;
+    return topo;
+}
+
+// pin the calling thread to a processor, returns false if unable
+bool
+pinCurrentThread (int cpu)
+{
+#    if defined(__linux__)
+    if (cpu < 0 || cpu >= CPU_SETSIZE) return false;
+    cpu_set_t set;
+    CPU_ZERO (&set);
+    CPU_SET (cpu, &set);
+    return pthread_setaffinity_np (pthread_self (), sizeof (set), &set) == 0;
+#    else
+    (void) cpu;
+    return false;
+#    endif
+}
+
+// the NUMA node the calling thread is currently running on
+int
+currentNode (const CpuTopology& topo)
+{
+    if (tWorkerNode >= 0) return tWorkerNode;
+#    if defined(__linux__)
+    int n = topo.nodeOfCpu (sched_getcpu ());
+    if (n >= 0) return n;
+#    else
+    (void) topo;
+#    endif
+    return 0;
+}
+#endif
+
 static inline void
 handleProcessTask (Task* task)
 {
@@ -43,7 +233,15 @@ handleProcessTask (Task* task)
     {
         TaskGroup* taskGroup = task->group ();
 
-        task->execute ();
+        // tasks belonging to a cancelled group are dropped without
+        // being run, but still need to be released and accounted for
+        if (!taskGroup || !taskGroup->isCancelled ())
+        {
+#ifdef ENABLE_THREADING
+            CurrentGroupScope scope (taskGroup);
+#endif
+            task->execute ();
+        }
 
         // kill the task prior to notifying the group
         // such that any internal reference-based
@@ -56,11 +254,20 @@ handleProcessTask (Task* task)
     }
 }
 
+struct QueuedTask
+{
+    int   priority;
+    Task* task;
+};
+
 struct DefaultThreadPoolData
 {
     Semaphore          _taskSemaphore; // threads wait on this for ready tasks
-    mutable std::mutex _taskMutex;     // mutual exclusion for the tasks list
-    std::vector<Task*> _tasks;         // the list of tasks to execute
+    mutable std::mutex _taskMutex;     // mutual exclusion for the tasks lists
+    // tasks to execute per NUMA node, by ascending priority (a single
+    // list unless the pool uses THREAD_AFFINITY_NUMA)
+    std::vector<std::vector<QueuedTask>> _tasks;
+    uint64_t _cancelEpoch = 0; // last cancellation purged from _tasks
 
     mutable std::mutex       _threadMutex; // mutual exclusion for threads list
     std::vector<std::thread> _threads;     // the list of all threads
@@ -103,6 +310,10 @@ struct TaskGroup::Data
     std::atomic<int> numPending;
     std::atomic<int> inFlight;
     Semaphore        isEmpty; // used to signal that the taskgroup is empty
+
+    TaskGroup*        parent;
+    std::atomic<int>  priority;
+    std::atomic<bool> cancelled;
 };
 
 struct ThreadPool::Data
@@ -118,6 +329,8 @@ struct ThreadPool::Data
 
     ProviderPtr getProvider () const { return std::atomic_load (&_provider); }
 
+    ProviderPtr makeDefaultProvider (int count) const;
+
     void setProvider (ProviderPtr provider)
     {
         ProviderPtr curp = std::atomic_exchange (&_provider, provider);
@@ -125,6 +338,8 @@ struct ThreadPool::Data
     }
 
     std::shared_ptr<ThreadPoolProvider> _provider;
+
+    std::atomic<ThreadAffinity> _affinity;
 };
 
 namespace
@@ -136,7 +351,7 @@ namespace
 class DefaultThreadPoolProvider : public ThreadPoolProvider
 {
 public:
-    DefaultThreadPoolProvider (int count);
+    DefaultThreadPoolProvider (int count, ThreadPool::ThreadAffinity affinity);
     DefaultThreadPoolProvider (const DefaultThreadPoolProvider&) = delete;
     DefaultThreadPoolProvider&
     operator= (const DefaultThreadPoolProvider&)                       = delete;
@@ -150,16 +365,26 @@ public:
 
     void finish () override;
 
+    ThreadPool::ThreadAffinity affinity () const { return _affinity; }
+
 private:
     void lockedFinish ();
-    void threadLoop (std::shared_ptr<DefaultThreadPoolData> d);
+    void lockedPurgeCancelled (std::vector<Task*>& purged);
+    void threadLoop (std::shared_ptr<DefaultThreadPoolData> d, size_t index);
 
     std::shared_ptr<DefaultThreadPoolData> _data;
+    ThreadPool::ThreadAffinity             _affinity;
 };
 
-DefaultThreadPoolProvider::DefaultThreadPoolProvider (int count)
-    : _data (std::make_shared<DefaultThreadPoolData> ())
+DefaultThreadPoolProvider::DefaultThreadPoolProvider (
+    int count, ThreadPool::ThreadAffinity affinity)
+    : _data (std::make_shared<DefaultThreadPoolData> ()), _affinity (affinity)
 {
+    size_t nqueues = 1;
+    if (_affinity == ThreadPool::THREAD_AFFINITY_NUMA)
+        nqueues = cpuTopology ().nodeCpus.size ();
+    _data->_tasks.resize (nqueues);
+
     _data->resetAtomics ();
     setNumThreads (count);
 }
@@ -196,8 +421,8 @@ DefaultThreadPoolProvider::setNumThreads (int count)
     _data->_threads.resize (nToAdd);
     for (size_t i = curThreads; i < nToAdd; ++i)
     {
-        _data->_threads[i] =
-            std::thread (&DefaultThreadPoolProvider::threadLoop, this, _data);
+        _data->_threads[i] = std::thread (
+            &DefaultThreadPoolProvider::threadLoop, this, _data, i);
     }
     _data->_threadCount = static_cast<int> (_data->_threads.size ());
 }
@@ -209,13 +434,36 @@ DefaultThreadPoolProvider::addTask (Task* task)
     // if the thread count is set to 0, so we can always
     // go ahead and lock and assume we have a thread to do the
     // processing
+    TaskGroup* g        = task->group ();
+    int        priority = g ? g->priority () : 0;
+
+    // queue the task on the submitting thread's node so it
+    // preferably runs where its caller's memory lives
+    size_t node = 0;
+    if (_data->_tasks.size () > 1)
+        node = static_cast<size_t> (currentNode (cpuTopology ()));
+    if (node >= _data->_tasks.size ()) node = 0;
+
     {
         std::lock_guard<std::mutex> taskLock (_data->_taskMutex);
 
         //
-        // Push the new task into the FIFO
+        // Insert the new task after all tasks of lower or equal
+        // priority. Workers pop from the back, so the highest
+        // priority runs first, and with equal priorities (the
+        // common case) this is just a push_back
         //
-        _data->_tasks.push_back (task);
+        auto& tasks = _data->_tasks[node];
+        auto  pos   = tasks.end ();
+        if (!tasks.empty () && tasks.back ().priority > priority)
+        {
+            pos = std::upper_bound (
+                tasks.begin (),
+                tasks.end (),
+                priority,
+                [] (int p, const QueuedTask& qt) { return p < qt.priority; });
+        }
+        tasks.insert (pos, QueuedTask{priority, task});
     }
 
     //
@@ -288,10 +536,50 @@ DefaultThreadPoolProvider::lockedFinish ()
     _data->resetAtomics ();
 }
 
+void
+DefaultThreadPoolProvider::lockedPurgeCancelled (std::vector<Task*>& purged)
+{
+    for (auto& tasks: _data->_tasks)
+    {
+        auto keep = std::stable_partition (
+            tasks.begin (), tasks.end (), [] (const QueuedTask& qt) {
+                TaskGroup* g = qt.task->group ();
+                return !g || !g->isCancelled ();
+            });
+
+        for (auto i = keep; i != tasks.end (); ++i)
+            purged.push_back (i->task);
+        tasks.erase (keep, tasks.end ());
+    }
+}
+
 void
 DefaultThreadPoolProvider::threadLoop (
-    std::shared_ptr<DefaultThreadPoolData> data)
+    std::shared_ptr<DefaultThreadPoolData> data, size_t index)
 {
+    std::vector<Task*> purged;
+
+    //
+    // With NUMA affinity, spread the workers evenly over the nodes
+    // and pin each to its own processor within the node. Memory a
+    // task allocates and first touches is then placed on the worker's
+    // node by the OS. The input files pool their decoders per node
+    // (see currentNumaNode), so the decode buffers are node-local too.
+    //
+    size_t node = 0;
+    if (data->_tasks.size () > 1)
+    {
+        const CpuTopology& topo = cpuTopology ();
+        node                    = index % topo.nodeCpus.size ();
+
+        const std::vector<int>& cpus = topo.nodeCpus[node];
+        if (!cpus.empty ())
+            pinCurrentThread (
+                cpus[(index / topo.nodeCpus.size ()) % cpus.size ()]);
+
+        tWorkerNode = static_cast<int> (node);
+    }
+
     while (true)
     {
         //
@@ -304,23 +592,54 @@ DefaultThreadPoolProvider::threadLoop (
             std::unique_lock<std::mutex> taskLock (data->_taskMutex);
 
             //
-            // If there is a task pending, pop off the next task in the FIFO
+            // If a group was cancelled since the queue was last
+            // checked, pull its tasks out so they don't wait behind
+            // higher priority work. The semaphore posts for them are
+            // simply absorbed by the empty queue check below.
             //
 
-            if (!data->_tasks.empty ())
+            uint64_t epoch = gCancelEpoch.load (std::memory_order_acquire);
+            if (epoch != data->_cancelEpoch)
             {
-                Task* task = data->_tasks.back ();
-                data->_tasks.pop_back ();
+                data->_cancelEpoch = epoch;
+                lockedPurgeCancelled (purged);
+            }
 
-                // release the mutex while we process
-                taskLock.unlock ();
+            //
+            // If there is a task pending, pop off the highest priority
+            // one, preferring our own node's tasks among equals
+            //
 
-                handleProcessTask (task);
+            std::vector<QueuedTask>* best = &(data->_tasks[node]);
+            for (auto& tasks: data->_tasks)
+            {
+                if (tasks.empty ()) continue;
+                if (best->empty () ||
+                    tasks.back ().priority > best->back ().priority)
+                    best = &tasks;
+            }
 
-                // do not need to reacquire the lock at all since we
-                // will just loop around, pull any other task
+            Task* task = nullptr;
+            if (!best->empty ())
+            {
+                task = best->back ().task;
+                best->pop_back ();
             }
-            else if (data->stopped ()) { break; }
+            else if (purged.empty () && data->stopped ()) { break; }
+
+            // release the mutex while we process
+            taskLock.unlock ();
+
+            // cancelled tasks are not executed, this only releases
+            // them and notifies their groups
+            for (Task* t: purged)
+                handleProcessTask (t);
+            purged.clear ();
+
+            handleProcessTask (task);
+
+            // do not need to reacquire the lock at all since we
+            // will just loop around, pull any other task
         }
     }
 }
@@ -331,7 +650,13 @@ DefaultThreadPoolProvider::threadLoop (
 // struct TaskGroup::Data
 //
 
-TaskGroup::Data::Data () : numPending (0), inFlight (0), isEmpty (1)
+TaskGroup::Data::Data ()
+    : numPending (0)
+    , inFlight (0)
+    , isEmpty (1)
+    , parent (nullptr)
+    , priority (0)
+    , cancelled (false)
 {}
 
 TaskGroup::Data::~Data ()
@@ -397,11 +722,17 @@ TaskGroup::Data::removeTask ()
 // struct ThreadPool::Data
 //
 
-ThreadPool::Data::Data ()
+ThreadPool::Data::Data () : _affinity (THREAD_AFFINITY_NONE)
 {
     // empty
 }
 
+ThreadPool::Data::ProviderPtr
+ThreadPool::Data::makeDefaultProvider (int count) const
+{
+    return std::make_shared<DefaultThreadPoolProvider> (count, _affinity);
+}
+
 ThreadPool::Data::~Data ()
 {
     setProvider (nullptr);
@@ -431,6 +762,12 @@ Task::group ()
     return _group;
 }
 
+bool
+Task::isCancelled () const
+{
+    return _group && _group->isCancelled ();
+}
+
 TaskGroup::TaskGroup ()
     :
 #ifdef ENABLE_THREADING
@@ -442,6 +779,19 @@ TaskGroup::TaskGroup ()
     // empty
 }
 
+TaskGroup::TaskGroup (TaskGroup* parent) : TaskGroup ()
+{
+#ifdef ENABLE_THREADING
+    if (parent)
+    {
+        _data->parent   = parent;
+        _data->priority = parent->priority ();
+    }
+#else
+    (void) parent;
+#endif
+}
+
 TaskGroup::~TaskGroup ()
 {
 #ifdef ENABLE_THREADING
@@ -458,6 +808,57 @@ TaskGroup::finishOneTask ()
 #endif
 }
 
+void
+TaskGroup::setPriority (int priority)
+{
+#ifdef ENABLE_THREADING
+    _data->priority = priority;
+#else
+    (void) priority;
+#endif
+}
+
+int
+TaskGroup::priority () const
+{
+#ifdef ENABLE_THREADING
+    return _data->priority.load (std::memory_order_relaxed);
+#else
+    return 0;
+#endif
+}
+
+void
+TaskGroup::cancel ()
+{
+#ifdef ENABLE_THREADING
+    if (!_data->cancelled.exchange (true))
+        gCancelEpoch.fetch_add (1, std::memory_order_release);
+#endif
+}
+
+bool
+TaskGroup::isCancelled () const
+{
+#ifdef ENABLE_THREADING
+    for (const TaskGroup* g = this; g; g = g->_data->parent)
+    {
+        if (g->_data->cancelled.load (std::memory_order_relaxed)) return true;
+    }
+#endif
+    return false;
+}
+
+TaskGroup*
+TaskGroup::current ()
+{
+#ifdef ENABLE_THREADING
+    return tCurrentGroup;
+#else
+    return nullptr;
+#endif
+}
+
 //
 // class ThreadPoolProvider
 //
@@ -534,8 +935,7 @@ ThreadPool::setNumThreads (int count)
     if (count == 0)
         _data->setProvider (nullptr);
     else
-        _data->setProvider (
-            std::make_shared<DefaultThreadPoolProvider> (count));
+        _data->setProvider (_data->makeDefaultProvider (count));
 
 #else
     // just blindly ignore
@@ -556,6 +956,56 @@ ThreadPool::setThreadProvider (ThreadPoolProvider* provider)
 #endif
 }
 
+void
+ThreadPool::setThreadAffinity (ThreadAffinity affinity)
+{
+#ifdef ENABLE_THREADING
+    if (_data->_affinity.exchange (affinity) == affinity) return;
+
+    // restart the default provider's threads with the new placement,
+    // a custom provider is left alone
+    Data::ProviderPtr sp = _data->getProvider ();
+    if (sp && dynamic_cast<DefaultThreadPoolProvider*> (sp.get ()))
+    {
+        int count = sp->numThreads ();
+        sp.reset ();
+        _data->setProvider (_data->makeDefaultProvider (count));
+    }
+#else
+    (void) affinity;
+#endif
+}
+
+ThreadPool::ThreadAffinity
+ThreadPool::threadAffinity () const
+{
+#ifdef ENABLE_THREADING
+    return _data->_affinity;
+#else
+    return THREAD_AFFINITY_NONE;
+#endif
+}
+
+int
+ThreadPool::numNumaNodes ()
+{
+#ifdef ENABLE_THREADING
+    return static_cast<int> (cpuTopology ().nodeCpus.size ());
+#else
+    return 1;
+#endif
+}
+
+int
+ThreadPool::currentNumaNode ()
+{
+#ifdef ENABLE_THREADING
+    return currentNode (cpuTopology ());
+#else
+    return 0;
+#endif
+}
+
 void
 ThreadPool::addTask (Task* task)
 {
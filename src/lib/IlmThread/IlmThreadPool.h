@@ -23,6 +23,11 @@
 //	single TaskGroup.  The destructor of the TaskGroup waits for all
 //	tasks in the group to finish.
 //
+//	A TaskGroup also carries a scheduling priority and can be
+//	cancelled.  Tasks of a cancelled group that have not started
+//	yet are discarded without being executed, and running tasks
+//	can poll Task::isCancelled() to stop early.
+//
 //	Note: if you plan to use the ThreadPool interface in your own
 //	applications note that the implementation of the ThreadPool calls
 //	operator delete on tasks as they complete.  If you define a custom
@@ -82,7 +87,8 @@ public:
     // in the future, if core counts expand faster than
     // memory bandwidth, or higher order NUMA machines are built
     // that we can query, this routine gives a place where we
-    // can centralize that logic
+    // can centralize that logic. See also setThreadAffinity
+    // and numNumaNodes below.
     //-------------------------------------------------------
     ILMTHREAD_EXPORT
     static unsigned estimateThreadCountForFileIO ();
@@ -130,11 +136,54 @@ public:
     //--------------------------------------------------------
     ILMTHREAD_EXPORT void setThreadProvider (ThreadPoolProvider* provider);
 
+    //--------------------------------------------------------
+    // Control the placement of the worker threads of the
+    // default provider:
+    //
+    // THREAD_AFFINITY_NONE: threads are left to the OS
+    // scheduler (the default).
+    //
+    // THREAD_AFFINITY_NUMA: workers are spread evenly over the
+    // NUMA nodes and each is pinned to a processor of its node.
+    // Tasks are queued on the node of the thread adding them
+    // and preferably run there; idle workers take tasks from
+    // other nodes. Memory a task allocates and first writes
+    // itself is placed on the worker's node by the OS. The
+    // input files keep the decoders they reuse across tasks
+    // in one pool per node, and a worker only takes decoders
+    // from its own node's pool, so the decode buffers are
+    // first touched, and so placed, on the worker's node too.
+    // Node discovery uses /sys on linux; elsewhere the machine
+    // is treated as a single node and threads are not pinned.
+    //
+    // Changing the affinity restarts the default provider's
+    // threads. A custom provider set through setThreadProvider
+    // is not affected.
+    //
+    // numNumaNodes returns the number of NUMA nodes with
+    // processors usable by this process. currentNumaNode
+    // returns the node, from 0 to numNumaNodes () - 1, that the
+    // calling thread runs on (for a pinned worker, its node).
+    //--------------------------------------------------------
+
+    enum ThreadAffinity
+    {
+        THREAD_AFFINITY_NONE,
+        THREAD_AFFINITY_NUMA
+    };
+
+    ILMTHREAD_EXPORT void           setThreadAffinity (ThreadAffinity affinity);
+    ILMTHREAD_EXPORT ThreadAffinity threadAffinity () const;
+    ILMTHREAD_EXPORT static int     numNumaNodes ();
+    ILMTHREAD_EXPORT static int     currentNumaNode ();
+
     //------------------------------------------------------------
     // Add a task for processing.  The ThreadPool can handle any
     // number of tasks regardless of the number of worker threads.
     // The tasks are first added onto a queue, and are executed
-    // by threads as they become available, in FIFO order.
+    // by threads as they become available.  The default provider
+    // runs tasks from higher priority task groups first.  Tasks
+    // whose group has been cancelled are discarded.
     //------------------------------------------------------------
 
     ILMTHREAD_EXPORT void addTask (Task* task);
@@ -166,6 +215,14 @@ public:
     ILMTHREAD_EXPORT
     TaskGroup* group ();
 
+    //------------------------------------------------------------
+    // Returns true if the task's group (or one of its parents)
+    // has been cancelled. Long running tasks may poll this to
+    // stop early.
+    //------------------------------------------------------------
+    ILMTHREAD_EXPORT
+    bool isCancelled () const;
+
 protected:
     TaskGroup* _group;
 };
@@ -174,6 +231,15 @@ class ILMTHREAD_EXPORT_TYPE TaskGroup
 {
 public:
     ILMTHREAD_EXPORT TaskGroup ();
+
+    //------------------------------------------------------------
+    // Create a task group nested inside parent (which may be
+    // null). The group starts out with the priority of the
+    // parent and is considered cancelled whenever the parent is.
+    // The parent must outlive the group.
+    //------------------------------------------------------------
+    ILMTHREAD_EXPORT explicit TaskGroup (TaskGroup* parent);
+
     ILMTHREAD_EXPORT ~TaskGroup ();
 
     TaskGroup (const TaskGroup& other)            = delete;
@@ -186,6 +252,33 @@ public:
     // as it finishes tasks
     ILMTHREAD_EXPORT void finishOneTask ();
 
+    //------------------------------------------------------------
+    // Query and set the scheduling priority of the group. Tasks
+    // from groups with a higher priority are started before
+    // tasks from groups with a lower priority; the default is 0.
+    // The priority is sampled when a task is added to the pool,
+    // so set it before adding the group's tasks.
+    //------------------------------------------------------------
+    ILMTHREAD_EXPORT void setPriority (int priority);
+    ILMTHREAD_EXPORT int  priority () const;
+
+    //------------------------------------------------------------
+    // Cancel the group. Tasks that have not started yet are
+    // removed from the pool without being executed, and running
+    // tasks observe isCancelled() returning true. The destructor
+    // still waits for the running tasks to return.
+    //------------------------------------------------------------
+    ILMTHREAD_EXPORT void cancel ();
+    ILMTHREAD_EXPORT bool isCancelled () const;
+
+    //------------------------------------------------------------
+    // Returns the group of the task being executed by the calling
+    // thread, or null when not called from within a task. Library
+    // code uses this to nest its own task groups so priority and
+    // cancellation carry over to the work it spawns.
+    //------------------------------------------------------------
+    ILMTHREAD_EXPORT static TaskGroup* current ();
+
     struct ILMTHREAD_HIDDEN Data;
     Data* const             _data;
 };
@@ -10,6 +10,7 @@
 //-----------------------------------------------------------------------------
 
 #include <Iex.h>
+#include <IlmThreadPool.h>
 #include <ImfAcesFile.h>
 #include <ImfRgbaFile.h>
 #include <ImfStandardAttributes.h>
@@ -18,6 +19,9 @@
 using namespace std;
 using namespace IMATH_NAMESPACE;
 using namespace IEX_NAMESPACE;
+using ILMTHREAD_NAMESPACE::Task;
+using ILMTHREAD_NAMESPACE::TaskGroup;
+using ILMTHREAD_NAMESPACE::ThreadPool;
 #include "ImfNamespace.h"
 
 OPENEXR_IMF_INTERNAL_NAMESPACE_SOURCE_ENTER
@@ -281,6 +285,7 @@ public:
     void initColorConversion ();
 
     RgbaInputFile* rgbaFile;
+    int            numThreads;
 
     Rgba*  fbBase;
     size_t fbXStride;
@@ -294,6 +299,7 @@ public:
 
 AcesInputFile::Data::Data ()
     : rgbaFile (0)
+    , numThreads (0)
     , fbBase (0)
     , fbXStride (0)
     , fbYStride (0)
@@ -424,13 +430,15 @@ AcesInputFile::Data::initColorConversion ()
 AcesInputFile::AcesInputFile (const std::string& name, int numThreads)
     : _data (new Data)
 {
-    _data->rgbaFile = new RgbaInputFile (name.c_str (), numThreads);
+    _data->rgbaFile   = new RgbaInputFile (name.c_str (), numThreads);
+    _data->numThreads = numThreads;
     _data->initColorConversion ();
 }
 
 AcesInputFile::AcesInputFile (IStream& is, int numThreads) : _data (new Data)
 {
-    _data->rgbaFile = new RgbaInputFile (is, numThreads);
+    _data->rgbaFile   = new RgbaInputFile (is, numThreads);
+    _data->numThreads = numThreads;
     _data->initColorConversion ();
 }
 
@@ -448,6 +456,84 @@ AcesInputFile::setFrameBuffer (Rgba* base, size_t xStride, size_t yStride)
     _data->fbYStride = yStride;
 }
 
+namespace
+{
+
+//
+// A frame buffer whose pixels must be transformed into the
+// ACES RGB space, and the matrix that does so.
+//
+
+struct ColorConversion
+{
+    M44f   fileToAces;
+    Rgba*  fbBase;
+    size_t fbXStride;
+    size_t fbYStride;
+    int    minX;
+    int    maxX;
+};
+
+//
+// Transform scan lines y1 through y2 of the frame buffer.  This
+// is the same computation as V3f(r,g,b) * fileToAces, unrolled so
+// the compiler can vectorize it; fileToAces has no projective part,
+// so the divide by w is dropped.
+//
+
+void
+convertToAces (const ColorConversion& cc, int y1, int y2)
+{
+    const M44f& m = cc.fileToAces;
+
+    const float m00 = m[0][0], m01 = m[0][1], m02 = m[0][2];
+    const float m10 = m[1][0], m11 = m[1][1], m12 = m[1][2];
+    const float m20 = m[2][0], m21 = m[2][1], m22 = m[2][2];
+    const float m30 = m[3][0], m31 = m[3][1], m32 = m[3][2];
+
+    for (int y = y1; y <= y2; ++y)
+    {
+        Rgba* base = cc.fbBase + cc.fbXStride * cc.minX + cc.fbYStride * y;
+
+        for (int x = cc.minX; x <= cc.maxX; ++x)
+        {
+            float r = base->r;
+            float g = base->g;
+            float b = base->b;
+
+            base->r = r * m00 + g * m10 + b * m20 + m30;
+            base->g = r * m01 + g * m11 + b * m21 + m31;
+            base->b = r * m02 + g * m12 + b * m22 + m32;
+
+            base += cc.fbXStride;
+        }
+    }
+}
+
+//
+// Conversions of fewer pixels than this are not worth splitting up.
+//
+
+const int64_t minPixelsPerTask = 16384;
+
+class ColorConversionTask : public Task
+{
+public:
+    ColorConversionTask (
+        TaskGroup* group, const ColorConversion* cc, int y1, int y2)
+        : Task (group), _cc (cc), _y1 (y1), _y2 (y2)
+    {}
+
+    void execute () override { convertToAces (*_cc, _y1, _y2); }
+
+private:
+    const ColorConversion* _cc;
+    int                    _y1;
+    int                    _y2;
+};
+
+} // namespace
+
 void
 AcesInputFile::readPixels (int scanLine1, int scanLine2)
 {
@@ -468,22 +554,45 @@ AcesInputFile::readPixels (int scanLine1, int scanLine2)
     int minY = min (scanLine1, scanLine2);
     int maxY = max (scanLine1, scanLine2);
 
-    for (int y = minY; y <= maxY; ++y)
+    const ColorConversion cc = {
+        _data->fileToAces,
+        _data->fbBase,
+        _data->fbXStride,
+        _data->fbYStride,
+        _data->minX,
+        _data->maxX};
+
+#if ILMTHREAD_THREADING_ENABLED
+    //
+    // Split large conversions into bands of scan lines that are
+    // converted concurrently.  The tasks only touch the frame buffer,
+    // so they never wait on the thread pool themselves; leaving the
+    // scope of the task group waits for them to finish.
+    //
+
+    int     numRows   = maxY - minY + 1;
+    int64_t numPixels = int64_t (numRows) * (_data->maxX - _data->minX + 1);
+    int64_t numTasks  = min<int64_t> (
+        min (_data->numThreads, numRows), numPixels / minPixelsPerTask);
+
+    if (numTasks > 1)
     {
-        Rgba* base = _data->fbBase + _data->fbXStride * _data->minX +
-                     _data->fbYStride * y;
+        TaskGroup group (TaskGroup::current ());
 
-        for (int x = _data->minX; x <= _data->maxX; ++x)
+        for (int64_t i = 0; i < numTasks; ++i)
         {
-            V3f aces = V3f (base->r, base->g, base->b) * _data->fileToAces;
-
-            base->r = aces[0];
-            base->g = aces[1];
-            base->b = aces[2];
+            int y1 = minY + int (numRows * i / numTasks);
+            int y2 = minY + int (numRows * (i + 1) / numTasks) - 1;
 
-            base += _data->fbXStride;
+            ThreadPool::addGlobalTask (
+                new ColorConversionTask (&group, &cc, y1, y2));
         }
+
+        return;
     }
+#endif
+
+    convertToAces (cc, minY, maxY);
 }
 
 void
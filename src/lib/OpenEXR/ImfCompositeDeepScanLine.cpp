@@ -7,6 +7,7 @@
 #include "IlmThreadPool.h"
 #include "ImfChannelList.h"
 #include "ImfDeepCompositing.h"
+#include "ImfDefaultDeepCompositing.h"
 #include "ImfDeepFrameBuffer.h"
 #include "ImfDeepScanLineInputFile.h"
 #include "ImfDeepScanLineInputPart.h"
@@ -290,128 +291,135 @@ class LineCompositeTask : public Task
 {
 public:
     LineCompositeTask (
-        TaskGroup*                      group,
-        CompositeDeepScanLine::Data*    data,
-        int                             y,
-        int                             start,
-        vector<const char*>*            names,
-        vector<vector<vector<float*>>>* pointers,
-        vector<unsigned int>*           total_sizes,
-        vector<unsigned int>*           num_sources)
+        TaskGroup*                    group,
+        CompositeDeepScanLine::Data*  data,
+        int                           y,
+        int                           start,
+        vector<const char*>*          names,
+        vector<const float*>*         channel_data,
+        vector<int64_t>*              line_offsets,
+        vector<unsigned int>*         total_sizes,
+        vector<unsigned int>*         num_sources)
         : Task (group)
         , _Data (data)
         , _y (y)
         , _start (start)
         , _names (names)
-        , _pointers (pointers)
+        , _channel_data (channel_data)
+        , _line_offsets (line_offsets)
         , _total_sizes (total_sizes)
         , _num_sources (num_sources)
     {}
 
     virtual ~LineCompositeTask () {}
 
-    virtual void                    execute ();
-    CompositeDeepScanLine::Data*    _Data;
-    int                             _y;
-    int                             _start;
-    vector<const char*>*            _names;
-    vector<vector<vector<float*>>>* _pointers;
-    vector<unsigned int>*           _total_sizes;
-    vector<unsigned int>*           _num_sources;
+    virtual void                  execute ();
+    CompositeDeepScanLine::Data*  _Data;
+    int                           _y;
+    int                           _start;
+    vector<const char*>*          _names;
+    vector<const float*>*         _channel_data;
+    vector<int64_t>*              _line_offsets;
+    vector<unsigned int>*         _total_sizes;
+    vector<unsigned int>*         _num_sources;
 };
 
 void
 composite_line (
-    int                                   y,
-    int                                   start,
-    CompositeDeepScanLine::Data*          _Data,
-    vector<const char*>&                  names,
-    const vector<vector<vector<float*>>>& pointers,
-    const vector<unsigned int>&           total_sizes,
-    const vector<unsigned int>&           num_sources)
+    int                           y,
+    int                           start,
+    CompositeDeepScanLine::Data*  _Data,
+    vector<const char*>&          names,
+    const vector<const float*>&   channel_data,
+    const vector<int64_t>&        line_offsets,
+    const vector<unsigned int>&   total_sizes,
+    const vector<unsigned int>&   num_sources)
 {
-    vector<float> output_pixel (names.size ()); //the pixel we'll output to
-    vector<const float*> inputs (names.size ());
-    DeepCompositing      d; // fallback compositing engine
-    DeepCompositing*     comp = _Data->_comp ? _Data->_comp : &d;
+    DefaultDeepCompositing d; // fallback compositing engine
+    DeepCompositing*       comp = _Data->_comp ? _Data->_comp : &d;
 
-    int pixel =
-        (y - start) * (_Data->_dataWindow.max.x + 1 - _Data->_dataWindow.min.x);
+    int    width    = _Data->_dataWindow.max.x + 1 - _Data->_dataWindow.min.x;
+    size_t channels = names.size ();
+    size_t pixel    = size_t (y - start) * size_t (width);
 
-    for (int x = _Data->_dataWindow.min.x; x <= _Data->_dataWindow.max.x; x++)
+    //
+    // the samples of all pixels of the line are stored back to back in
+    // each channel, starting at the line's offset
+    //
+
+    vector<const float*> inputs (channels);
+    for (size_t channel = 0; channel < channels; channel++)
     {
-        // set inputs[] to point to the first sample of the first part of each channel
-        // if there's a zback, set all channel independently...
+        inputs[channel] = channel_data[channel]
+                              ? channel_data[channel] + line_offsets[y - start]
+                              : nullptr;
+    }
 
-        if (_Data->_zback)
-        {
+    vector<float>  output_line (channels * width); // composited values, per channel
+    vector<float*> outputs (channels);
+    for (size_t channel = 0; channel < channels; channel++)
+    {
+        outputs[channel] = &output_line[channel * width];
+    }
 
-            for (size_t channel = 0; channel < names.size (); channel++)
-            {
-                inputs[channel] = pointers[0][channel][pixel];
-            }
-        }
-        else
-        {
+    comp->composite_span (
+        &outputs[0],
+        &inputs[0],
+        &names[0],
+        static_cast<int> (channels),
+        &total_sizes[pixel],
+        &num_sources[pixel],
+        width);
 
-            // otherwise, set 0 and 1 to point to Z
+    //
+    // write out composited values into internal frame buffer
+    //
 
-            inputs[0] = pointers[0][0][pixel];
-            inputs[1] = pointers[0][0][pixel];
-            for (size_t channel = 2; channel < names.size (); channel++)
+    size_t channel_number = 0;
+    for (FrameBuffer::Iterator it = _Data->_outputFrameBuffer.begin ();
+         it != _Data->_outputFrameBuffer.end ();
+         it++)
+    {
+        const float* values = outputs[_Data->_bufferMap[channel_number]];
+        const Slice& slice  = it.slice ();
+        intptr_t     base   = reinterpret_cast<intptr_t> (slice.base) +
+                        y * slice.yStride +
+                        _Data->_dataWindow.min.x * slice.xStride;
+
+        // cast to half float if necessary
+        if (slice.type == OPENEXR_IMF_INTERNAL_NAMESPACE::FLOAT)
+        {
+            for (int x = 0; x < width; x++)
             {
-                inputs[channel] = pointers[0][channel][pixel];
+                *reinterpret_cast<float*> (base + x * slice.xStride) =
+                    values[x];
             }
         }
-        comp->composite_pixel (
-            &output_pixel[0],
-            &inputs[0],
-            &names[0],
-            static_cast<int> (names.size ()),
-            total_sizes[pixel],
-            num_sources[pixel]);
-
-        size_t channel_number = 0;
-
-        //
-        // write out composited value into internal frame buffer
-        //
-        for (FrameBuffer::Iterator it = _Data->_outputFrameBuffer.begin ();
-             it != _Data->_outputFrameBuffer.end ();
-             it++)
+        else if (slice.type == HALF)
         {
-
-            float value = output_pixel
-                [_Data->_bufferMap[channel_number]]; // value to write
-            intptr_t base = reinterpret_cast<intptr_t> (it.slice ().base);
-
-            // cast to half float if necessary
-            if (it.slice ().type == OPENEXR_IMF_INTERNAL_NAMESPACE::FLOAT)
+            for (int x = 0; x < width; x++)
             {
-                float* ptr = reinterpret_cast<float*> (
-                    base + y * it.slice ().yStride + x * it.slice ().xStride);
-                *ptr = value;
+                *reinterpret_cast<half*> (base + x * slice.xStride) =
+                    half (values[x]);
             }
-            else if (it.slice ().type == HALF)
-            {
-                half* ptr = reinterpret_cast<half*> (
-                    base + y * it.slice ().yStride + x * it.slice ().xStride);
-                *ptr = half (value);
-            }
-
-            channel_number++;
         }
 
-        pixel++;
-
-    } // next pixel on row
+        channel_number++;
+    }
 }
 
 void
 LineCompositeTask::execute ()
 {
     composite_line (
-        _y, _start, _Data, *_names, *_pointers, *_total_sizes, *_num_sources);
+        _y,
+        _start,
+        _Data,
+        *_names,
+        *_channel_data,
+        *_line_offsets,
+        *_total_sizes,
+        *_num_sources);
 }
 
 } // namespace
@@ -591,6 +599,30 @@ CompositeDeepScanLine::readPixels (int start, int end)
     if (!_Data->_zback)
         names[1] = names[0]; // no zback channel, so make it point to z
 
+    //
+    // each line composites a run of samples, starting at the
+    // offset of its first pixel
+    //
+
+    vector<const float*> channel_data (samples.size ());
+    for (size_t channel = 0; channel < samples.size (); channel++)
+    {
+        size_t src = (channel != 1 || _Data->_zback) ? channel : 0;
+        channel_data[channel] =
+            samples[src].empty () ? nullptr : samples[src].data ();
+    }
+
+    vector<int64_t> line_offsets (end - start + 1);
+    {
+        int64_t offset = 0;
+        for (int y = start; y <= end; y++)
+        {
+            line_offsets[y - start] = offset;
+            for (size_t x = 0; x < total_width; x++)
+                offset += total_sizes[(y - start) * total_width + x];
+        }
+    }
+
     TaskGroup g;
     for (int y = start; y <= end; y++)
     {
@@ -600,7 +632,8 @@ CompositeDeepScanLine::readPixels (int start, int end)
             y,
             start,
             &names,
-            &pointers,
+            &channel_data,
+            &line_offsets,
             &total_sizes,
             &num_sources));
     } //next row
@@ -25,8 +25,8 @@
 //
 //      The default compositing engine will give spurious results with overlapping
 //      volumetric samples - you may derive from DeepCompositing class, override the
-//      sort_pixel() and composite_pixel() functions, and pass an instance to
-//      setCompositing().
+//      sort_pixel() and composite_pixel() functions (or composite_span(), to
+//      process whole scanlines), and pass an instance to setCompositing().
 //
 //-----------------------------------------------------------------------------
 
@@ -0,0 +1,680 @@
+//
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) Contributors to the OpenEXR Project.
+//
+
+#include "ImfCompositeDeepTile.h"
+#include "IlmThreadPool.h"
+#include "ImfChannelList.h"
+#include "ImfCompositeDeepScanLine.h"
+#include "ImfDeepCompositing.h"
+#include "ImfDefaultDeepCompositing.h"
+#include "ImfDeepFrameBuffer.h"
+#include "ImfDeepTiledInputFile.h"
+#include "ImfDeepTiledInputPart.h"
+#include "ImfFrameBuffer.h"
+#include "ImfPixelType.h"
+
+#include <Iex.h>
+#include <algorithm>
+#include <limits.h>
+#include <stddef.h>
+#include <vector>
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_SOURCE_ENTER
+
+using ILMTHREAD_NAMESPACE::Task;
+using ILMTHREAD_NAMESPACE::TaskGroup;
+using ILMTHREAD_NAMESPACE::ThreadPool;
+using IMATH_NAMESPACE::Box2i;
+using IMATH_NAMESPACE::V2i;
+using std::max;
+using std::min;
+using std::string;
+using std::vector;
+
+namespace
+{
+
+//
+// a source is either a file or a part; both have the same interface
+//
+
+struct Source
+{
+    DeepTiledInputFile* file;
+    DeepTiledInputPart* part;
+
+    const Header& header () const
+    {
+        return file ? file->header () : part->header ();
+    }
+
+    void setFrameBuffer (const DeepFrameBuffer& buf)
+    {
+        if (file)
+            file->setFrameBuffer (buf);
+        else
+            part->setFrameBuffer (buf);
+    }
+
+    void readPixelSampleCounts (int dx1, int dx2, int dy, int lx, int ly)
+    {
+        if (file)
+            file->readPixelSampleCounts (dx1, dx2, dy, dy, lx, ly);
+        else
+            part->readPixelSampleCounts (dx1, dx2, dy, dy, lx, ly);
+    }
+
+    void readTiles (int dx1, int dx2, int dy, int lx, int ly)
+    {
+        if (file)
+            file->readTiles (dx1, dx2, dy, dy, lx, ly);
+        else
+            part->readTiles (dx1, dx2, dy, dy, lx, ly);
+    }
+
+    int numXTiles (int lx) const
+    {
+        return file ? file->numXTiles (lx) : part->numXTiles (lx);
+    }
+
+    int numYTiles (int ly) const
+    {
+        return file ? file->numYTiles (ly) : part->numYTiles (ly);
+    }
+
+    bool isValidLevel (int lx, int ly) const
+    {
+        return file ? file->isValidLevel (lx, ly)
+                    : part->isValidLevel (lx, ly);
+    }
+
+    Box2i dataWindowForLevel (int lx, int ly) const
+    {
+        return file ? file->dataWindowForLevel (lx, ly)
+                    : part->dataWindowForLevel (lx, ly);
+    }
+
+    Box2i dataWindowForTile (int dx, int dy, int lx, int ly) const
+    {
+        return file ? file->dataWindowForTile (dx, dy, lx, ly)
+                    : part->dataWindowForTile (dx, dy, lx, ly);
+    }
+};
+
+} // namespace
+
+struct CompositeDeepTile::Data
+{
+public:
+    vector<Source>   _sources;           // files and parts, in order added
+    FrameBuffer      _outputFrameBuffer; // output frame buffer provided
+    bool _zback; // true if we are using zback (otherwise channel 1 = channel 0)
+    Box2i            _dataWindow; // data window shared by all inputs
+    TileDescription  _tileDesc;   // tiling shared by all inputs
+    DeepCompositing* _comp;       // user-provided compositor
+    vector<string>   _channels;   // names of channels that will be composited
+    vector<int>
+        _bufferMap; // entry _outputFrameBuffer[n].name() == _channels[ _bufferMap[n] ].name()
+
+    void check_valid (
+        const Header&
+            header); // check newly added part/file is OK; on first good call, set _zback/_dataWindow
+
+    const Source& first () const;
+
+    //
+    // read and composite the tiles dx1 to dx2 of row dy of level (lx,ly),
+    // storing the lines yMin to yMax of the result in the output frame buffer
+    //
+
+    void compositeRow (
+        int dx1, int dx2, int dy, int lx, int ly, int yMin, int yMax);
+
+    Data ();
+};
+
+CompositeDeepTile::Data::Data () : _zback (false), _comp (NULL)
+{}
+
+CompositeDeepTile::CompositeDeepTile () : _Data (new Data)
+{}
+
+CompositeDeepTile::~CompositeDeepTile ()
+{
+    delete _Data;
+}
+
+void
+CompositeDeepTile::addSource (DeepTiledInputPart* part)
+{
+    _Data->check_valid (part->header ());
+    _Data->_sources.push_back (Source{nullptr, part});
+}
+
+void
+CompositeDeepTile::addSource (DeepTiledInputFile* file)
+{
+    _Data->check_valid (file->header ());
+    _Data->_sources.push_back (Source{file, nullptr});
+}
+
+int
+CompositeDeepTile::sources () const
+{
+    return int (_Data->_sources.size ());
+}
+
+void
+CompositeDeepTile::Data::check_valid (const Header& header)
+{
+    bool has_z     = false;
+    bool has_alpha = false;
+    bool has_zback = false;
+
+    for (ChannelList::ConstIterator i = header.channels ().begin ();
+         i != header.channels ().end ();
+         ++i)
+    {
+        std::string n (i.name ());
+        if (n == "ZBack") { has_zback = true; }
+        else if (n == "Z") { has_z = true; }
+        else if (n == "A") { has_alpha = true; }
+    }
+
+    if (!has_z)
+    {
+        throw IEX_NAMESPACE::ArgExc (
+            "Deep data provided to CompositeDeepTile is missing a Z channel");
+    }
+
+    if (!has_alpha)
+    {
+        throw IEX_NAMESPACE::ArgExc (
+            "Deep data provided to CompositeDeepTile is missing an alpha channel");
+    }
+
+    if (_sources.empty ())
+    {
+        // first in - update and return
+
+        _dataWindow = header.dataWindow ();
+        _tileDesc   = header.tileDescription ();
+        _zback      = has_zback;
+        return;
+    }
+
+    const Header& match_header = _sources[0].header ();
+
+    //
+    // the tiles of all sources must line up, so that a row of tiles
+    // covers the same pixels in each of them
+    //
+
+    if (match_header.displayWindow () != header.displayWindow ())
+    {
+        throw IEX_NAMESPACE::ArgExc (
+            "Deep data provided to CompositeDeepTile has a different displayWindow to previously provided data");
+    }
+
+    if (match_header.dataWindow () != header.dataWindow ())
+    {
+        throw IEX_NAMESPACE::ArgExc (
+            "Deep data provided to CompositeDeepTile has a different dataWindow to previously provided data");
+    }
+
+    const TileDescription& td = header.tileDescription ();
+    if (td.xSize != _tileDesc.xSize || td.ySize != _tileDesc.ySize ||
+        td.mode != _tileDesc.mode || td.roundingMode != _tileDesc.roundingMode)
+    {
+        throw IEX_NAMESPACE::ArgExc (
+            "Deep data provided to CompositeDeepTile has a different tile description to previously provided data");
+    }
+
+    _zback = _zback || has_zback;
+}
+
+const Source&
+CompositeDeepTile::Data::first () const
+{
+    if (_sources.empty ())
+    {
+        throw IEX_NAMESPACE::ArgExc ("No sources provided to CompositeDeepTile");
+    }
+    return _sources[0];
+}
+
+void
+CompositeDeepTile::setCompositing (DeepCompositing* c)
+{
+    _Data->_comp = c;
+}
+
+const IMATH_NAMESPACE::Box2i&
+CompositeDeepTile::dataWindow () const
+{
+    return _Data->_dataWindow;
+}
+
+const TileDescription&
+CompositeDeepTile::tileDescription () const
+{
+    return _Data->_tileDesc;
+}
+
+int
+CompositeDeepTile::numXTiles (int lx) const
+{
+    return _Data->first ().numXTiles (lx);
+}
+
+int
+CompositeDeepTile::numYTiles (int ly) const
+{
+    return _Data->first ().numYTiles (ly);
+}
+
+IMATH_NAMESPACE::Box2i
+CompositeDeepTile::dataWindowForLevel (int lx, int ly) const
+{
+    return _Data->first ().dataWindowForLevel (lx, ly);
+}
+
+void
+CompositeDeepTile::setFrameBuffer (const FrameBuffer& fr)
+{
+
+    //
+    // count channels; build map between channels in frame buffer
+    // and channels in internal buffers
+    //
+
+    _Data->_channels.resize (3);
+    _Data->_channels[0] = "Z";
+    _Data->_channels[1] = _Data->_zback ? "ZBack" : "Z";
+    _Data->_channels[2] = "A";
+    _Data->_bufferMap.resize (0);
+
+    for (FrameBuffer::ConstIterator q = fr.begin (); q != fr.end (); q++)
+    {
+        if (q.slice ().xSampling != 1 || q.slice ().ySampling != 1)
+        {
+            THROW (
+                IEX_NAMESPACE::ArgExc,
+                "X and/or y subsampling factors "
+                "of \""
+                    << q.name ()
+                    << "\" channel in framebuffer "
+                       "are not 1");
+        }
+
+        string name (q.name ());
+        if (name == "ZBack") { _Data->_bufferMap.push_back (1); }
+        else if (name == "Z") { _Data->_bufferMap.push_back (0); }
+        else if (name == "A") { _Data->_bufferMap.push_back (2); }
+        else
+        {
+            _Data->_bufferMap.push_back (
+                static_cast<int> (_Data->_channels.size ()));
+            _Data->_channels.push_back (name);
+        }
+    }
+
+    _Data->_outputFrameBuffer = fr;
+}
+
+const FrameBuffer&
+CompositeDeepTile::frameBuffer () const
+{
+    return _Data->_outputFrameBuffer;
+}
+
+namespace
+{
+
+//
+// samples of one row of tiles, merged from all sources
+//
+
+struct RowSamples
+{
+    Box2i                _box;          // pixels covered by the row
+    vector<const char*>  _names;        // channel names, for the compositor
+    vector<const float*> _channel_data; // samples of all pixels, per channel
+    vector<int64_t>      _offsets;      // offset of each pixel's samples
+    vector<unsigned int> _total_sizes;  // per-pixel sample counts
+    vector<unsigned int> _num_sources;  // number of sources with samples
+};
+
+class TileCompositeTask : public Task
+{
+public:
+    TileCompositeTask (
+        TaskGroup*               group,
+        CompositeDeepTile::Data* data,
+        const RowSamples*        row,
+        const Box2i&             tile,
+        int                      yMin,
+        int                      yMax)
+        : Task (group)
+        , _Data (data)
+        , _row (row)
+        , _tile (tile)
+        , _yMin (yMin)
+        , _yMax (yMax)
+    {}
+
+    virtual ~TileCompositeTask () {}
+
+    virtual void             execute ();
+    CompositeDeepTile::Data* _Data;
+    const RowSamples*        _row;
+    Box2i                    _tile;
+    int                      _yMin;
+    int                      _yMax;
+};
+
+void
+TileCompositeTask::execute ()
+{
+    DefaultDeepCompositing d; // fallback compositing engine
+    DeepCompositing*       comp = _Data->_comp ? _Data->_comp : &d;
+
+    const RowSamples& row      = *_row;
+    size_t            channels = row._names.size ();
+    int               width    = _tile.max.x - _tile.min.x + 1;
+    ptrdiff_t         rowWidth = row._box.max.x - row._box.min.x + 1;
+
+    vector<float>        output_line (channels * width);
+    vector<float*>       outputs (channels);
+    vector<const float*> inputs (channels);
+    for (size_t channel = 0; channel < channels; channel++)
+    {
+        outputs[channel] = &output_line[channel * width];
+    }
+
+    int y1 = max (_tile.min.y, _yMin);
+    int y2 = min (_tile.max.y, _yMax);
+
+    for (int y = y1; y <= y2; y++)
+    {
+        size_t pixel = size_t (y - row._box.min.y) * rowWidth +
+                       size_t (_tile.min.x - row._box.min.x);
+
+        for (size_t channel = 0; channel < channels; channel++)
+        {
+            inputs[channel] = row._channel_data[channel]
+                                  ? row._channel_data[channel] +
+                                        row._offsets[pixel]
+                                  : nullptr;
+        }
+
+        comp->composite_span (
+            &outputs[0],
+            &inputs[0],
+            const_cast<const char**> (&row._names[0]),
+            static_cast<int> (channels),
+            &row._total_sizes[pixel],
+            &row._num_sources[pixel],
+            width);
+
+        //
+        // write out composited values into the output frame buffer
+        //
+
+        size_t channel_number = 0;
+        for (FrameBuffer::ConstIterator it =
+                 _Data->_outputFrameBuffer.begin ();
+             it != _Data->_outputFrameBuffer.end ();
+             it++)
+        {
+            const float* values = outputs[_Data->_bufferMap[channel_number]];
+            const Slice& slice  = it.slice ();
+            intptr_t     base   = reinterpret_cast<intptr_t> (slice.base) +
+                            y * slice.yStride + _tile.min.x * slice.xStride;
+
+            if (slice.type == OPENEXR_IMF_INTERNAL_NAMESPACE::FLOAT)
+            {
+                for (int x = 0; x < width; x++)
+                {
+                    *reinterpret_cast<float*> (base + x * slice.xStride) =
+                        values[x];
+                }
+            }
+            else if (slice.type == HALF)
+            {
+                for (int x = 0; x < width; x++)
+                {
+                    *reinterpret_cast<half*> (base + x * slice.xStride) =
+                        half (values[x]);
+                }
+            }
+
+            channel_number++;
+        }
+    }
+}
+
+} // namespace
+
+void
+CompositeDeepTile::Data::compositeRow (
+    int dx1, int dx2, int dy, int lx, int ly, int yMin, int yMax)
+{
+    size_t parts    = _sources.size ();
+    size_t channels = _channels.size ();
+
+    vector<Box2i> tiles (dx2 - dx1 + 1);
+    for (int dx = dx1; dx <= dx2; dx++)
+        tiles[dx - dx1] = _sources[0].dataWindowForTile (dx, dy, lx, ly);
+
+    RowSamples row;
+    row._box = Box2i (
+        tiles.front ().min, V2i (tiles.back ().max.x, tiles.front ().max.y));
+
+    ptrdiff_t width  = row._box.max.x - row._box.min.x + 1;
+    ptrdiff_t height = row._box.max.y - row._box.min.y + 1;
+    size_t    pixels = size_t (width) * size_t (height);
+    ptrdiff_t origin = row._box.min.x + row._box.min.y * width;
+
+    //
+    // set up a deep frame buffer per source covering the row, and
+    // read the sample counts
+    //
+
+    vector<DeepFrameBuffer>        framebuffers (parts);
+    vector<vector<unsigned int>>   counts (parts);
+    vector<vector<vector<float*>>> pointers (parts);
+
+    for (size_t part = 0; part < parts; part++)
+    {
+        DeepFrameBuffer& buf = framebuffers[part];
+
+        counts[part].resize (pixels);
+        buf.insertSampleCountSlice (Slice (
+            OPENEXR_IMF_INTERNAL_NAMESPACE::UINT,
+            (char*) (&counts[part][0] - origin),
+            sizeof (unsigned int),
+            sizeof (unsigned int) * width));
+
+        pointers[part].resize (channels);
+        for (size_t channel = 0; channel < channels; channel++)
+        {
+            if (channel == 1 && !_zback) continue;
+
+            pointers[part][channel].resize (pixels);
+            buf.insert (
+                _channels[channel],
+                DeepSlice (
+                    OPENEXR_IMF_INTERNAL_NAMESPACE::FLOAT,
+                    (char*) (&pointers[part][channel][0] - origin),
+                    sizeof (float*),
+                    sizeof (float*) * width,
+                    sizeof (float)));
+        }
+
+        _sources[part].setFrameBuffer (buf);
+        _sources[part].readPixelSampleCounts (dx1, dx2, dy, lx, ly);
+    }
+
+    //
+    // accumulate pixel counts; the samples of a pixel are stored
+    // back to back, one source after the other, and the pixels
+    // of the row follow each other line by line
+    //
+
+    row._total_sizes.resize (pixels);
+    row._num_sources.resize (pixels);
+    row._offsets.resize (pixels);
+
+    int64_t overall_sample_count = 0;
+
+    for (size_t ptr = 0; ptr < pixels; ptr++)
+    {
+        unsigned int total   = 0;
+        unsigned int sources = 0;
+        for (size_t part = 0; part < parts; part++)
+        {
+            total += counts[part][ptr];
+            if (counts[part][ptr] > 0) sources++;
+        }
+        row._total_sizes[ptr] = total;
+        row._num_sources[ptr] = sources;
+        row._offsets[ptr]     = overall_sample_count;
+        overall_sample_count += total;
+    }
+
+    int64_t maximumSampleCount = CompositeDeepScanLine::getMaximumSampleCount ();
+    if (maximumSampleCount > 0 && overall_sample_count > maximumSampleCount)
+    {
+        throw IEX_NAMESPACE::ArgExc (
+            "Cannot composite tiles: total sample count in row of tiles exceeds "
+            "limit set by CompositeDeepScanLine::setMaximumSampleCount()");
+    }
+
+    //
+    // allocate arrays for pixel data, and point the sources at them
+    //
+
+    vector<vector<float>> samples (channels);
+
+    for (size_t channel = 0; channel < channels; channel++)
+    {
+        if (channel == 1 && !_zback) continue;
+
+        samples[channel].resize (overall_sample_count);
+        float* data = samples[channel].data ();
+
+        for (size_t pixel = 0; pixel < pixels; pixel++)
+        {
+            int64_t offset = row._offsets[pixel];
+            for (size_t part = 0; part < parts; part++)
+            {
+                pointers[part][channel][pixel] = data + offset;
+                offset += counts[part][pixel];
+            }
+        }
+    }
+
+    for (size_t part = 0; part < parts; part++)
+    {
+        _sources[part].readTiles (dx1, dx2, dy, lx, ly);
+    }
+
+    //
+    // composite the tiles of the row in parallel
+    //
+
+    row._names.resize (channels);
+    row._channel_data.resize (channels);
+    for (size_t channel = 0; channel < channels; channel++)
+    {
+        size_t src = (channel != 1 || _zback) ? channel : 0;
+        row._names[channel] = _channels[src].c_str ();
+        row._channel_data[channel] =
+            samples[src].empty () ? nullptr : samples[src].data ();
+    }
+
+    {
+        TaskGroup g;
+        for (size_t t = 0; t < tiles.size (); t++)
+        {
+            ThreadPool::addGlobalTask (
+                new TileCompositeTask (&g, this, &row, tiles[t], yMin, yMax));
+        }
+    }
+}
+
+void
+CompositeDeepTile::readTiles (int dx1, int dx2, int dy1, int dy2, int lx, int ly)
+{
+    const Source& src = _Data->first ();
+
+    if (!src.isValidLevel (lx, ly))
+    {
+        THROW (
+            IEX_NAMESPACE::ArgExc,
+            "Level coordinate (" << lx << ", " << ly
+                                 << ") is invalid for CompositeDeepTile.");
+    }
+
+    if (dx1 > dx2) std::swap (dx1, dx2);
+    if (dy1 > dy2) std::swap (dy1, dy2);
+
+    if (dx1 < 0 || dy1 < 0 || dx2 >= src.numXTiles (lx) ||
+        dy2 >= src.numYTiles (ly))
+    {
+        throw IEX_NAMESPACE::ArgExc (
+            "Tried to composite a tile outside the image's data window.");
+    }
+
+    for (int dy = dy1; dy <= dy2; dy++)
+    {
+        _Data->compositeRow (dx1, dx2, dy, lx, ly, INT_MIN, INT_MAX);
+    }
+}
+
+void
+CompositeDeepTile::readTiles (int dx1, int dx2, int dy1, int dy2, int l)
+{
+    readTiles (dx1, dx2, dy1, dy2, l, l);
+}
+
+void
+CompositeDeepTile::readTile (int dx, int dy, int lx, int ly)
+{
+    readTiles (dx, dx, dy, dy, lx, ly);
+}
+
+void
+CompositeDeepTile::readTile (int dx, int dy, int l)
+{
+    readTiles (dx, dx, dy, dy, l, l);
+}
+
+void
+CompositeDeepTile::readPixels (int start, int end)
+{
+    const Source& src = _Data->first ();
+    const Box2i&  dw  = _Data->_dataWindow;
+
+    if (start > end) std::swap (start, end);
+
+    if (start < dw.min.y || end > dw.max.y)
+    {
+        throw IEX_NAMESPACE::ArgExc (
+            "Tried to composite scan lines outside the image's data window.");
+    }
+
+    int dy1 = (start - dw.min.y) / int (_Data->_tileDesc.ySize);
+    int dy2 = (end - dw.min.y) / int (_Data->_tileDesc.ySize);
+    int nx  = src.numXTiles (0);
+
+    for (int dy = dy1; dy <= dy2; dy++)
+    {
+        _Data->compositeRow (0, nx - 1, dy, 0, 0, start, end);
+    }
+}
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_SOURCE_EXIT
@@ -0,0 +1,155 @@
+//
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) Contributors to the OpenEXR Project.
+//
+
+#ifndef INCLUDED_IMF_COMPOSITEDEEPTILE_H
+#define INCLUDED_IMF_COMPOSITEDEEPTILE_H
+
+//-----------------------------------------------------------------------------
+//
+//	Class to composite deep tiled samples into a flat frame buffer
+//      Initialise with one or more deep tiled input parts or files;
+//      their samples are merged and composited together.
+//
+//      Then call setFrameBuffer, and readTiles exactly as for reading
+//      regular tiled images, or readPixels to composite scan lines
+//      into a scanline frame buffer.
+//
+//      The sources are read one row of tiles at a time, and the tiles
+//      of a row are composited in parallel on the global thread pool,
+//      so memory use is bounded by the samples of one row of tiles
+//      rather than those of the whole image.  The limit set with
+//      CompositeDeepScanLine::setMaximumSampleCount() applies to the
+//      samples of each row of tiles.
+//
+//      Restrictions - source file(s) must contain at least Z and alpha channels
+//                   - all sources must have the same data window, display
+//                     window and tile description
+//                   - all requested channels will be composited as premultiplied
+//                   - only half and float channels can be requested
+//
+//      This object should not be considered threadsafe
+//
+//      As with CompositeDeepScanLine, a DeepCompositing instance may be
+//      passed to setCompositing() to override sorting and compositing.
+//      composite_span() is called once per row of each tile.
+//
+//-----------------------------------------------------------------------------
+
+#include "ImfForward.h"
+
+#include "ImfTileDescription.h"
+
+#include <ImathBox.h>
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_HEADER_ENTER
+
+class IMF_EXPORT_TYPE CompositeDeepTile
+{
+public:
+    IMF_EXPORT
+    CompositeDeepTile ();
+    IMF_EXPORT
+    virtual ~CompositeDeepTile ();
+
+    /// set the source data as a part
+    ///@note all parts must remain valid until after last interaction with CompositeDeepTile
+    IMF_EXPORT
+    void addSource (DeepTiledInputPart* part);
+
+    /// set the source data as a file
+    ///@note all files must remain valid until after last interaction with CompositeDeepTile
+    IMF_EXPORT
+    void addSource (DeepTiledInputFile* file);
+
+    IMF_EXPORT
+    int sources () const; // return number of sources
+
+    /////////////////////////////////////////
+    //
+    // set the frame buffer for output values
+    // The frame buffer uses the same pixel
+    // coordinates as the sources: for tiles,
+    // the coordinates of the level read
+    //
+    /////////////////////////////////////////
+
+    IMF_EXPORT
+    void setFrameBuffer (const FrameBuffer& fr);
+
+    IMF_EXPORT
+    const FrameBuffer& frameBuffer () const;
+
+    //
+    // override default sorting/compositing operation
+    // (otherwise an instance of the base class will be used)
+    //
+
+    IMF_EXPORT
+    void setCompositing (DeepCompositing*);
+
+    /////////////////////////////////////////////////
+    //
+    // data window and tiling of the sources; the
+    // level and tile queries are as for TiledInputFile
+    //
+    ////////////////////////////////////////////////
+
+    IMF_EXPORT
+    const IMATH_NAMESPACE::Box2i& dataWindow () const;
+
+    IMF_EXPORT
+    const TileDescription& tileDescription () const;
+
+    IMF_EXPORT
+    int numXTiles (int lx = 0) const;
+    IMF_EXPORT
+    int numYTiles (int ly = 0) const;
+
+    IMF_EXPORT
+    IMATH_NAMESPACE::Box2i dataWindowForLevel (int lx, int ly) const;
+
+    //////////////////////////////////////////////////
+    //
+    // composite tiles (dx1,dy1) to (dx2,dy2) of level
+    // (lx,ly) from the source(s), storing the result
+    // in the frame buffer provided
+    //
+    //////////////////////////////////////////////////
+
+    IMF_EXPORT
+    void readTile (int dx, int dy, int l = 0);
+    IMF_EXPORT
+    void readTile (int dx, int dy, int lx, int ly);
+
+    IMF_EXPORT
+    void readTiles (int dx1, int dx2, int dy1, int dy2, int lx, int ly);
+    IMF_EXPORT
+    void readTiles (int dx1, int dx2, int dy1, int dy2, int l = 0);
+
+    //////////////////////////////////////////////////
+    //
+    // composite scanlines start to end of level 0,
+    // for writing into a scanline frame buffer;
+    // only the lines in the range are stored
+    //
+    //////////////////////////////////////////////////
+
+    IMF_EXPORT
+    void readPixels (int start, int end);
+
+    struct IMF_HIDDEN Data;
+
+private:
+    struct Data* _Data;
+
+    CompositeDeepTile (const CompositeDeepTile&)            = delete;
+    CompositeDeepTile& operator= (const CompositeDeepTile&) = delete;
+    CompositeDeepTile (CompositeDeepTile&&)                 = delete;
+    CompositeDeepTile& operator= (CompositeDeepTile&&)      = delete;
+};
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_HEADER_EXIT
+
+#endif
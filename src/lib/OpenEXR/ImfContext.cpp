@@ -845,4 +845,22 @@ Context::chunkTableValid (int partidx) const
     return exr_validate_chunk_table (*_ctxt, partidx) == EXR_ERR_SUCCESS;
 }
 
+////////////////////////////////////////
+
+int
+Context::refreshChunkTable (int partidx, uint8_t* available) const
+{
+    int32_t navail = 0;
+
+    if (EXR_ERR_SUCCESS !=
+        exr_refresh_chunk_table (*_ctxt, partidx, &navail, available))
+    {
+        THROW (
+            IEX_NAMESPACE::InputExc,
+            "Unable to refresh chunk table of '" << fileName () << "'");
+    }
+
+    return navail;
+}
+
 OPENEXR_IMF_INTERNAL_NAMESPACE_SOURCE_EXIT
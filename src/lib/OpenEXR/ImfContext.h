@@ -89,6 +89,11 @@ public:
 
     IMF_EXPORT bool chunkTableValid (int partidx) const;
 
+    // re-reads the chunk table of a file still being written,
+    // returning the number of chunks available. If not null,
+    // available receives a flag per chunk of the part
+    IMF_EXPORT int refreshChunkTable (int partidx, uint8_t* available) const;
+
 private:
     std::shared_ptr<exr_context_t> _ctxt;
 }; // class Context
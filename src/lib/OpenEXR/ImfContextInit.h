@@ -123,6 +123,14 @@ public:
         return *this;
     }
 
+    /// Open a file which may still be in the process of being
+    /// written; see EXR_CONTEXT_FLAG_TAIL_FOLLOW.
+    ContextInitializer& tailFollow (bool onoff) noexcept
+    {
+        setFlag (EXR_CONTEXT_FLAG_TAIL_FOLLOW, onoff);
+        return *this;
+    }
+
     ContextInitializer& writeLegacyHeader (bool onoff) noexcept
     {
         setFlag (EXR_CONTEXT_FLAG_WRITE_LEGACY_HEADER, onoff);
@@ -4,9 +4,13 @@
 //
 
 #include "ImfDeepCompositing.h"
+#include "ImfDefaultDeepCompositing.h"
 
 #include "ImfNamespace.h"
+#include "ImfSimd.h"
 #include <algorithm>
+#include <stdint.h>
+#include <string.h>
 #include <vector>
 
 OPENEXR_IMF_INTERNAL_NAMESPACE_SOURCE_ENTER
@@ -75,6 +79,263 @@ struct sort_helper
     sort_helper (const float** i) : inputs (i) {}
 };
 
+namespace
+{
+
+//
+// Front to back sample order for a single pixel, by (Z, ZBack, sample
+// index), which is the order sort_helper gives.  Few samples are
+// insertion sorted; larger counts use a stable LSD radix sort on the
+// bits of ZBack then Z.
+//
+
+const int INSERTION_SORT_MAX = 16;
+
+inline uint32_t
+radixKey (float f)
+{
+    uint32_t u;
+    memcpy (&u, &f, sizeof (u));
+
+    // -0 and +0 compare equal
+    if (u == 0x80000000u) u = 0;
+
+    return (u & 0x80000000u) ? ~u : (u | 0x80000000u);
+}
+
+struct SpanScratch
+{
+    vector<int>      order;
+    vector<int>      orderTmp;
+    vector<uint32_t> key;
+    vector<uint32_t> keyTmp;
+    vector<float>    weight;
+};
+
+void
+radixSortBy (const float* values, int n, SpanScratch& s)
+{
+    for (int i = 0; i < n; ++i)
+        s.key[i] = radixKey (values[s.order[i]]);
+
+    for (int shift = 0; shift < 32; shift += 8)
+    {
+        int count[256] = {0};
+
+        for (int i = 0; i < n; ++i)
+            ++count[(s.key[i] >> shift) & 0xff];
+
+        // all samples share this digit, nothing moves
+        if (count[(s.key[0] >> shift) & 0xff] == n) continue;
+
+        int pos = 0;
+        for (int d = 0; d < 256; ++d)
+        {
+            int c    = count[d];
+            count[d] = pos;
+            pos += c;
+        }
+
+        for (int i = 0; i < n; ++i)
+        {
+            int dst         = count[(s.key[i] >> shift) & 0xff]++;
+            s.keyTmp[dst]   = s.key[i];
+            s.orderTmp[dst] = s.order[i];
+        }
+
+        s.key.swap (s.keyTmp);
+        s.order.swap (s.orderTmp);
+    }
+}
+
+void
+sortSamples (const float* z, const float* zback, int n, SpanScratch& s)
+{
+    if (int (s.order.size ()) < n)
+    {
+        s.order.resize (n);
+        s.orderTmp.resize (n);
+        s.key.resize (n);
+        s.keyTmp.resize (n);
+    }
+
+    for (int i = 0; i < n; ++i)
+        s.order[i] = i;
+
+    if (n <= INSERTION_SORT_MAX)
+    {
+        int* order = s.order.data ();
+        for (int i = 1; i < n; ++i)
+        {
+            int   v  = order[i];
+            float vz = z[v];
+            float vb = zback[v];
+            int   j  = i;
+
+            while (j > 0 && (z[order[j - 1]] > vz ||
+                             (z[order[j - 1]] == vz && zback[order[j - 1]] > vb)))
+            {
+                order[j] = order[j - 1];
+                --j;
+            }
+            order[j] = v;
+        }
+        return;
+    }
+
+    if (zback != z) radixSortBy (zback, n, s);
+    radixSortBy (z, n, s);
+}
+
+//
+// Composite one pixel front to back with the over operator.  The
+// per-sample weights (one minus the accumulated alpha) only depend on
+// the alpha channel, so they are computed first; the channels are then
+// accumulated independently, several at a time.  The arithmetic, and
+// its order, is that of DeepCompositing::composite_pixel().
+//
+
+void
+compositePixel (
+    float* const       outputs[],
+    const float* const inputs[],
+    int                num_channels,
+    int                num_samples,
+    const int*         order,
+    int                p,
+    SpanScratch&       s)
+{
+    if (int (s.weight.size ()) < num_samples) s.weight.resize (num_samples);
+
+    float* weight = s.weight.data ();
+    float  alpha  = 0.0f;
+    int    n      = 0;
+
+    for (; n < num_samples; ++n)
+    {
+        if (alpha >= 1.0f) break;
+        int smp   = order ? order[n] : n;
+        weight[n] = 1.0f - alpha;
+        alpha += weight[n] * inputs[2][smp];
+    }
+
+    int c = 0;
+
+#ifdef IMF_HAVE_SSE2
+    for (; c + 4 <= num_channels; c += 4)
+    {
+        const float* i0  = inputs[c];
+        const float* i1  = inputs[c + 1];
+        const float* i2  = inputs[c + 2];
+        const float* i3  = inputs[c + 3];
+        __m128       acc = _mm_setzero_ps ();
+
+        for (int k = 0; k < n; ++k)
+        {
+            int    smp = order ? order[k] : k;
+            __m128 v   = _mm_set_ps (i3[smp], i2[smp], i1[smp], i0[smp]);
+            acc = _mm_add_ps (acc, _mm_mul_ps (_mm_set1_ps (weight[k]), v));
+        }
+
+        float out[4];
+        _mm_storeu_ps (out, acc);
+        outputs[c][p]     = out[0];
+        outputs[c + 1][p] = out[1];
+        outputs[c + 2][p] = out[2];
+        outputs[c + 3][p] = out[3];
+    }
+#endif
+
+    for (; c < num_channels; ++c)
+    {
+        const float* in  = inputs[c];
+        float        acc = 0.0f;
+
+        if (order)
+        {
+            for (int k = 0; k < n; ++k)
+                acc += weight[k] * in[order[k]];
+        }
+        else
+        {
+            for (int k = 0; k < n; ++k)
+                acc += weight[k] * in[k];
+        }
+        outputs[c][p] = acc;
+    }
+}
+
+} // namespace
+
+void
+DeepCompositing::composite_span (
+    float*             outputs[],
+    const float*       inputs[],
+    const char*        channel_names[],
+    int                num_channels,
+    const unsigned int num_samples[],
+    const unsigned int sources[],
+    int                num_pixels)
+{
+    vector<const float*> in (inputs, inputs + num_channels);
+    vector<float>        out (num_channels);
+
+    for (int p = 0; p < num_pixels; ++p)
+    {
+        composite_pixel (
+            out.data (),
+            in.data (),
+            channel_names,
+            num_channels,
+            num_samples[p],
+            sources[p]);
+
+        for (int c = 0; c < num_channels; ++c)
+        {
+            outputs[c][p] = out[c];
+            in[c] += num_samples[p];
+        }
+    }
+}
+
+void
+DefaultDeepCompositing::composite_span (
+    float*             outputs[],
+    const float*       inputs[],
+    const char*        channel_names[],
+    int                num_channels,
+    const unsigned int num_samples[],
+    const unsigned int sources[],
+    int                num_pixels)
+{
+    vector<const float*> in (inputs, inputs + num_channels);
+    SpanScratch          scratch;
+
+    for (int p = 0; p < num_pixels; ++p)
+    {
+        int n = num_samples[p];
+
+        if (n == 0)
+        {
+            for (int c = 0; c < num_channels; ++c)
+                outputs[c][p] = 0.0f;
+            continue;
+        }
+
+        const int* order = nullptr;
+        if (sources[p] > 1)
+        {
+            sortSamples (in[0], in[1], n, scratch);
+            order = scratch.order.data ();
+        }
+
+        compositePixel (outputs, in.data (), num_channels, n, order, p, scratch);
+
+        for (int c = 0; c < num_channels; ++c)
+            in[c] += n;
+    }
+}
+
 void
 DeepCompositing::sort (
     int          order[],
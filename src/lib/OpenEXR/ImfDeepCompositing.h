@@ -96,6 +96,45 @@ public:
         int          num_channels,
         int          num_samples,
         int          sources);
+
+    //////////////////////////////////////////////
+    ///
+    /// composite together a run of pixels, such as a scanline
+    ///
+    ///  @param outputs       - per channel, array of num_pixels composited values
+    ///  @param inputs        - per channel, the samples of all pixels in the run
+    ///  @param channel_names - array of channel names for corresponding channels
+    ///  @param num_channels  - number of active channels (3 or greater)
+    ///  @param num_samples   - per pixel, the number of samples
+    ///  @param sources       - per pixel, the number of different sources
+    ///  @param num_pixels    - number of pixels in the run
+    ///
+    /// the samples of a pixel are stored back to back, following the samples of
+    /// the previous pixel: the samples of pixel p in channel c start at
+    /// inputs[c] + num_samples[0] + ... + num_samples[p-1]. outputs[c][p] receives
+    /// the composited value of channel c of pixel p.
+    ///
+    /// the channel layout is identical to composite_pixel()
+    ///
+    /// CompositeDeepScanLine and CompositeDeepTile call this once per run of
+    /// pixels. The default implementation calls composite_pixel() for each
+    /// pixel in turn, so classes overriding composite_pixel() or sort() keep
+    /// working unchanged; override composite_span() as well to process whole
+    /// runs. When no compositing object is set, the compositors use a built-in
+    /// one that composites runs directly, with the same results.
+    ///
+    /// note - multiple threads may call composite_span simultaneously for different runs
+    ///
+    //////////////////////////////////////////////
+    IMF_EXPORT
+    virtual void composite_span (
+        float*             outputs[],
+        const float*       inputs[],
+        const char*        channel_names[],
+        int                num_channels,
+        const unsigned int num_samples[],
+        const unsigned int sources[],
+        int                num_pixels);
 };
 
 OPENEXR_IMF_INTERNAL_NAMESPACE_HEADER_EXIT
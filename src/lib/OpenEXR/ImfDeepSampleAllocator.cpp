@@ -0,0 +1,83 @@
+//
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) Contributors to the OpenEXR Project.
+//
+
+//-----------------------------------------------------------------------------
+//
+//      class DeepSampleAllocator
+//      class DeepSampleArena
+//
+//-----------------------------------------------------------------------------
+
+#include "ImfDeepSampleAllocator.h"
+
+#include <algorithm>
+#include <stdint.h>
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_SOURCE_ENTER
+
+DeepSampleAllocator::~DeepSampleAllocator ()
+{}
+
+DeepSampleArena::DeepSampleArena (size_t blockSize)
+    : _blockSize (std::max (blockSize, size_t (4096)))
+    , _used (0)
+    , _available (0)
+    , _total (0)
+{}
+
+DeepSampleArena::~DeepSampleArena ()
+{
+    release ();
+}
+
+void*
+DeepSampleArena::allocate (size_t byteCount, int, int)
+{
+    size_t bytes = (byteCount + 7) & ~size_t (7);
+
+    std::lock_guard<std::mutex> lock (_mx);
+
+    if (_blocks.empty () || _used + bytes > _available)
+    {
+        //
+        // blocks are allocated as uint64_t such that they are 8 byte
+        // aligned; requests larger than the block size get their own
+        //
+
+        size_t size = std::max (bytes, _blockSize);
+        _blocks.push_back (
+            reinterpret_cast<char*> (new uint64_t[size / sizeof (uint64_t)]));
+        _used      = 0;
+        _available = size;
+    }
+
+    char* ret = _blocks.back () + _used;
+    _used += bytes;
+    _total += bytes;
+    return ret;
+}
+
+void
+DeepSampleArena::release ()
+{
+    std::lock_guard<std::mutex> lock (_mx);
+
+    for (char* b: _blocks)
+        delete[] reinterpret_cast<uint64_t*> (b);
+
+    _blocks.clear ();
+    _used      = 0;
+    _available = 0;
+    _total     = 0;
+}
+
+size_t
+DeepSampleArena::bytesAllocated () const
+{
+    std::lock_guard<std::mutex> lock (_mx);
+    return _total;
+}
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_SOURCE_EXIT
@@ -0,0 +1,98 @@
+//
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) Contributors to the OpenEXR Project.
+//
+
+#ifndef INCLUDED_IMF_DEEP_SAMPLE_ALLOCATOR_H
+#define INCLUDED_IMF_DEEP_SAMPLE_ALLOCATOR_H
+
+//-----------------------------------------------------------------------------
+//
+//      class DeepSampleAllocator
+//      class DeepSampleArena
+//
+//      Storage for the samples of deep images read in a single pass
+//      (see DeepScanLineInputFile::readPixelsAutoAlloc()).  As each
+//      chunk is decoded, the reader asks the allocator for one block of
+//      memory large enough for all samples of all channels of the chunk,
+//      and points the deep frame buffer's pixels into it.
+//
+//-----------------------------------------------------------------------------
+
+#include "ImfForward.h"
+
+#include <mutex>
+#include <stddef.h>
+#include <vector>
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_HEADER_ENTER
+
+class IMF_EXPORT_TYPE DeepSampleAllocator
+{
+public:
+    IMF_EXPORT
+    virtual ~DeepSampleAllocator ();
+
+    //------------------------------------------------------------------
+    // Return a block of at least byteCount bytes, aligned to 8 bytes,
+    // for the samples of scan lines firstScanLine to lastScanLine.
+    // The block must remain valid for as long as the caller uses the
+    // frame buffer's sample pointers.  byteCount is never zero.
+    //
+    // When reading with multiple threads, allocate() may be called
+    // from several threads at once.  To report an error, throw an
+    // exception; the read is then aborted.
+    //------------------------------------------------------------------
+
+    virtual void*
+    allocate (size_t byteCount, int firstScanLine, int lastScanLine) = 0;
+};
+
+//
+// A simple allocator that hands out memory from a list of large
+// blocks, which are freed all together by release() or when the
+// arena is destroyed.
+//
+
+class IMF_EXPORT_TYPE DeepSampleArena : public DeepSampleAllocator
+{
+public:
+    IMF_EXPORT
+    explicit DeepSampleArena (size_t blockSize = 4 << 20);
+    IMF_EXPORT
+    ~DeepSampleArena () override;
+
+    DeepSampleArena (const DeepSampleArena&)            = delete;
+    DeepSampleArena& operator= (const DeepSampleArena&) = delete;
+
+    IMF_EXPORT
+    void* allocate (size_t byteCount, int firstScanLine, int lastScanLine)
+        override;
+
+    //--------------------------------------------------
+    // Free all memory handed out so far, invalidating
+    // any sample pointers into it
+    //--------------------------------------------------
+
+    IMF_EXPORT
+    void release ();
+
+    //--------------------------------------------------
+    // Number of bytes handed out since the last release
+    //--------------------------------------------------
+
+    IMF_EXPORT
+    size_t bytesAllocated () const;
+
+private:
+    mutable std::mutex _mx;
+    size_t             _blockSize;
+    std::vector<char*> _blocks;
+    size_t             _used;      // bytes used in the last block
+    size_t             _available; // size of the last block
+    size_t             _total;
+};
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_HEADER_EXIT
+
+#endif
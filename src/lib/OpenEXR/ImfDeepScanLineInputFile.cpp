@@ -12,6 +12,7 @@
 #include "ImfDeepScanLineInputFile.h"
 
 #include "ImfDeepFrameBuffer.h"
+#include "ImfDeepSampleAllocator.h"
 #include "ImfInputPartData.h"
 
 #include "IlmThreadPool.h"
@@ -22,7 +23,9 @@
 #include "Iex.h"
 
 #include <algorithm>
+#include <exception>
 #include <limits>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <vector>
@@ -80,15 +83,155 @@ struct ScanLineProcess
         const DeepFrameBuffer *outfb,
         int fbY);
 
+    void allocate_samples ();
+
     exr_result_t          last_decode_err = EXR_ERR_UNKNOWN;
     bool                  first = true;
     bool                  counts_only = false;
     exr_chunk_info_t      cinfo;
     exr_decode_pipeline_t decoder;
 
+    // NUMA node of the thread which created this, and so first
+    // touched the decode buffers
+    int node = 0;
+
+    // single-pass reads: where the samples go, and the frame buffer
+    // whose pointers are set up once the sample counts are known
+    DeepSampleAllocator*   alloc = nullptr;
+    const DeepFrameBuffer* alloc_fb = nullptr;
+    std::exception_ptr     alloc_error;
+
     std::shared_ptr<ScanLineProcess> next;
 };
 
+//
+// Sum the samples of scan lines y1 to y2 in a run of chunks,
+// reading nothing but their sample count tables.  If perPixel is
+// not null, it points to the counts of scan line y1, and the count
+// of each pixel is stored there as well.
+//
+
+uint64_t
+countChunkSamples (
+    exr_const_context_t     ctxt,
+    int                     pn,
+    const exr_chunk_info_t* chunks,
+    size_t                  nChunks,
+    int                     y1,
+    int                     y2,
+    unsigned int*           perPixel)
+{
+    std::vector<int32_t> counts;
+    uint64_t             total = 0;
+
+    for (size_t c = 0; c < nChunks; ++c)
+    {
+        const exr_chunk_info_t& cinfo = chunks[c];
+        int                     first = std::max (cinfo.start_y, y1);
+        int                     last =
+            std::min (cinfo.start_y + cinfo.height - 1, y2);
+        exr_result_t rv;
+
+        if (!perPixel && first == cinfo.start_y &&
+            last == cinfo.start_y + cinfo.height - 1)
+        {
+            uint64_t chunkTotal = 0;
+
+            rv = exr_read_deep_sample_counts (
+                ctxt, pn, &cinfo, nullptr, &chunkTotal);
+            total += chunkTotal;
+        }
+        else
+        {
+            counts.resize (size_t (cinfo.width) * size_t (cinfo.height));
+
+            rv = exr_read_deep_sample_counts (
+                ctxt, pn, &cinfo, counts.data (), nullptr);
+
+            for (int y = first; rv == EXR_ERR_SUCCESS && y <= last; ++y)
+            {
+                const int32_t* line =
+                    counts.data () + size_t (y - cinfo.start_y) * cinfo.width;
+                for (int x = 0; x < cinfo.width; ++x)
+                    total += uint64_t (line[x]);
+
+                if (perPixel)
+                    std::copy (
+                        line,
+                        line + cinfo.width,
+                        perPixel + size_t (y - y1) * cinfo.width);
+            }
+        }
+
+        if (rv != EXR_ERR_SUCCESS)
+        {
+            THROW (
+                IEX_NAMESPACE::InputExc,
+                "Unable to read the sample counts of scan line "
+                    << cinfo.start_y);
+        }
+    }
+
+    return total;
+}
+
+#if ILMTHREAD_THREADING_ENABLED
+class SampleCountTask final : public ILMTHREAD_NAMESPACE::Task
+{
+public:
+    SampleCountTask (
+        ILMTHREAD_NAMESPACE::TaskGroup* group,
+        exr_const_context_t             ctxt,
+        int                             pn,
+        const exr_chunk_info_t*         chunks,
+        size_t                          nChunks,
+        int                             y1,
+        int                             y2,
+        unsigned int*                   perPixel,
+        uint64_t*                       total,
+        std::string*                    failure)
+        : Task (group)
+        , _ctxt (ctxt)
+        , _pn (pn)
+        , _chunks (chunks)
+        , _nChunks (nChunks)
+        , _y1 (y1)
+        , _y2 (y2)
+        , _perPixel (perPixel)
+        , _total (total)
+        , _failure (failure)
+    {}
+
+    void execute () override
+    {
+        try
+        {
+            *_total = countChunkSamples (
+                _ctxt, _pn, _chunks, _nChunks, _y1, _y2, _perPixel);
+        }
+        catch (std::exception& e)
+        {
+            *_failure = e.what ();
+        }
+        catch (...)
+        {
+            *_failure = "unknown exception";
+        }
+    }
+
+private:
+    exr_const_context_t     _ctxt;
+    int                     _pn;
+    const exr_chunk_info_t* _chunks;
+    size_t                  _nChunks;
+    int                     _y1;
+    int                     _y2;
+    unsigned int*           _perPixel;
+    uint64_t*               _total;
+    std::string*            _failure;
+};
+#endif
+
 } // empty namespace
 
 struct DeepScanLineInputFile::Data
@@ -112,7 +255,12 @@ struct DeepScanLineInputFile::Data
 
     std::pair<int, int> getChunkRange (int y) const;
 
-    void readData (const DeepFrameBuffer &fb, int scanLine1, int scanLine2, bool countsOnly);
+    void readData (
+        const DeepFrameBuffer &fb,
+        int scanLine1,
+        int scanLine2,
+        bool countsOnly,
+        DeepSampleAllocator *alloc = nullptr);
     void readMemData (
         const DeepFrameBuffer &fb,
         const char *rawPixelData,
@@ -122,6 +270,9 @@ struct DeepScanLineInputFile::Data
 
     void prepFillList (const DeepFrameBuffer &fb, std::vector<DeepSlice> &fill);
 
+    uint64_t countSamples (
+        int scanLine1, int scanLine2, unsigned int* perPixel) const;
+
     Context* _ctxt;
     int partNumber;
     int numThreads;
@@ -133,17 +284,28 @@ struct DeepScanLineInputFile::Data
     DeepFrameBuffer frameBuffer;
     std::vector<DeepSlice> fill_list;
 
-    std::shared_ptr<ScanLineProcess> processStack;
+    // default storage for readPixelsAutoAlloc
+    std::unique_ptr<DeepSampleArena> arena;
+
+    // one stack of decoders per NUMA node, so a thread reuses the
+    // buffers of its own node
+    std::vector<std::shared_ptr<ScanLineProcess>> processStacks;
     std::shared_ptr<ScanLineProcess> getChunkProcess ()
     {
+        int node = ILMTHREAD_NAMESPACE::ThreadPool::currentNumaNode ();
         std::shared_ptr<ScanLineProcess> retval;
 #if ILMTHREAD_THREADING_ENABLED
         std::lock_guard<std::mutex> lk (_mx);
 #endif
-        retval = processStack;
+        if (processStacks.size () <= size_t (node))
+            processStacks.resize (node + 1);
+        retval = processStacks[node];
         if (!retval)
+        {
             retval = std::make_shared<ScanLineProcess> ();
-        processStack = retval->next;
+            retval->node = node;
+        }
+        processStacks[node] = retval->next;
         retval->next.reset();
         return retval;
     }
@@ -152,8 +314,10 @@ struct DeepScanLineInputFile::Data
 #if ILMTHREAD_THREADING_ENABLED
         std::lock_guard<std::mutex> lk (_mx);
 #endif
-        sp->next = processStack;
-        processStack = sp;
+        if (processStacks.size () <= size_t (sp->node))
+            processStacks.resize (sp->node + 1);
+        sp->next = processStacks[sp->node];
+        processStacks[sp->node] = sp;
     }
 
 #if ILMTHREAD_THREADING_ENABLED
@@ -173,17 +337,17 @@ struct DeepScanLineInputFile::Data
             const exr_chunk_info_t& cinfo,
             int                     fby,
             int                     endScan,
-            bool                    countsOnly)
+            bool                    countsOnly,
+            DeepSampleAllocator*    alloc)
             : Task (group)
             , _outfb (outfb)
             , _ifd (ifd)
             , _fby (fby)
             , _last_fby (endScan)
-            , _line (ifd->getChunkProcess ())
-        {
-            _line->cinfo = cinfo;
-            _line->counts_only = countsOnly;
-        }
+            , _cinfo (cinfo)
+            , _countsOnly (countsOnly)
+            , _alloc (alloc)
+        {}
 
         ~LineBufferTask () override
         {
@@ -201,7 +365,11 @@ struct DeepScanLineInputFile::Data
         Data*                  _ifd;
         int                    _fby;
         int                    _last_fby;
+        exr_chunk_info_t       _cinfo;
+        bool                   _countsOnly;
+        DeepSampleAllocator*   _alloc;
 
+        // taken when the task runs, from the worker's NUMA node
         std::shared_ptr<ScanLineProcess> _line;
     };
 #endif
@@ -301,7 +469,7 @@ DeepScanLineInputFile::setFrameBuffer (const DeepFrameBuffer& frameBuffer)
     _data->prepFillList (frameBuffer, _data->fill_list);
     _data->frameBuffer = frameBuffer;
     _data->frameBufferValid = true;
-    _data->processStack.reset();
+    _data->processStacks.clear ();
 }
 
 const DeepFrameBuffer&
@@ -337,6 +505,32 @@ DeepScanLineInputFile::readPixels (int scanLine)
     readPixels (scanLine, scanLine);
 }
 
+void
+DeepScanLineInputFile::readPixelsAutoAlloc (
+    int scanLine1, int scanLine2, DeepSampleAllocator* allocator)
+{
+    if (!_data->frameBufferValid)
+    {
+        throw IEX_NAMESPACE::ArgExc (
+            "readPixelsAutoAlloc called with no valid frame buffer");
+    }
+
+    if (!allocator)
+    {
+        if (!_data->arena) _data->arena.reset (new DeepSampleArena);
+        allocator = _data->arena.get ();
+    }
+
+    _data->readData (
+        _data->frameBuffer, scanLine1, scanLine2, false, allocator);
+}
+
+void
+DeepScanLineInputFile::releaseAutoAllocData ()
+{
+    if (_data->arena) _data->arena->release ();
+}
+
 #pragma pack(push, 1)
 struct DeepChunkHeader
 {
@@ -446,6 +640,19 @@ DeepScanLineInputFile::readPixelSampleCounts (int scanline)
     readPixelSampleCounts (scanline, scanline);
 }
 
+uint64_t
+DeepScanLineInputFile::totalSampleCount (int scanLine1, int scanLine2) const
+{
+    return _data->countSamples (scanLine1, scanLine2, nullptr);
+}
+
+void
+DeepScanLineInputFile::sampleCounts (
+    int scanLine1, int scanLine2, unsigned int counts[]) const
+{
+    _data->countSamples (scanLine1, scanLine2, counts);
+}
+
 int
 DeepScanLineInputFile::firstScanLineInChunk (int y) const
 {
@@ -503,7 +710,11 @@ std::pair<int, int> DeepScanLineInputFile::Data::getChunkRange (int y) const
 
 void
 DeepScanLineInputFile::Data::readData (
-    const DeepFrameBuffer &fb, int scanLine1, int scanLine2, bool countsOnly)
+    const DeepFrameBuffer &fb,
+    int scanLine1,
+    int scanLine2,
+    bool countsOnly,
+    DeepSampleAllocator *alloc)
 {
     exr_attr_box2i_t dw = _ctxt->dataWindow (partNumber);
     exr_chunk_info_t cinfo;
@@ -550,7 +761,8 @@ DeepScanLineInputFile::Data::readData (
             _sem.wait ();
 
             ILMTHREAD_NAMESPACE::ThreadPool::addGlobalTask (
-                new LineBufferTask (&tg, this, &fb, cinfo, y, scanLine2, countsOnly) );
+                new LineBufferTask (
+                    &tg, this, &fb, cinfo, y, scanLine2, countsOnly, alloc));
 
             y += scansperchunk - (y - cinfo.start_y);
         }
@@ -559,9 +771,13 @@ DeepScanLineInputFile::Data::readData (
 #endif
     {
         auto sp = getChunkProcess ();
-        bool redo = sp->first || sp->counts_only != countsOnly;
+
+        // a chunk decoded before cannot be re-unpacked into storage
+        // that is only allocated as part of the decode
+        bool redo = sp->first || sp->counts_only != countsOnly || alloc;
 
         sp->counts_only = countsOnly;
+        sp->alloc = alloc;
         for (int y = scanLine1; y <= scanLine2; )
         {
             if (EXR_ERR_SUCCESS != exr_read_scanline_chunk_info (*_ctxt, partNumber, y, &cinfo))
@@ -614,6 +830,100 @@ DeepScanLineInputFile::Data::readData (
 
 ////////////////////////////////////////
 
+uint64_t
+DeepScanLineInputFile::Data::countSamples (
+    int scanLine1, int scanLine2, unsigned int* perPixel) const
+{
+    exr_attr_box2i_t dw = _ctxt->dataWindow (partNumber);
+    exr_chunk_info_t cinfo;
+    int32_t          scansperchunk = 1;
+
+    if (EXR_ERR_SUCCESS != exr_get_scanlines_per_chunk (*_ctxt, partNumber, &scansperchunk))
+    {
+        THROW (
+            IEX_NAMESPACE::ArgExc,
+            "Error querying scanline counts from image "
+            "file \"" << _ctxt->fileName () << "\".");
+    }
+
+    if (scanLine2 < scanLine1)
+        std::swap (scanLine1, scanLine2);
+
+    if (scanLine1 < dw.min.y || scanLine2 > dw.max.y)
+    {
+        THROW (
+            IEX_NAMESPACE::ArgExc,
+            "Tried to count samples of scan lines outside "
+            "the image file's data window: "
+            << scanLine1 << " - " << scanLine2
+            << " vs datawindow "
+            << dw.min.y << " - " << dw.max.y);
+    }
+
+    std::vector<exr_chunk_info_t> chunks;
+    for (int y = scanLine1; y <= scanLine2; )
+    {
+        if (EXR_ERR_SUCCESS != exr_read_scanline_chunk_info (*_ctxt, partNumber, y, &cinfo))
+            throw IEX_NAMESPACE::InputExc ("Unable to query scanline information");
+
+        chunks.push_back (cinfo);
+        y += scansperchunk - (y - cinfo.start_y);
+    }
+
+#if ILMTHREAD_THREADING_ENABLED
+    size_t nTasks = std::min (chunks.size (), size_t (std::max (numThreads, 1)));
+
+    if (nTasks > 1)
+    {
+        std::vector<uint64_t>    totals (nTasks, 0);
+        std::vector<std::string> failures (nTasks);
+
+        {
+            ILMTHREAD_NAMESPACE::TaskGroup tg;
+
+            for (size_t t = 0; t < nTasks; ++t)
+            {
+                size_t c0 = (chunks.size () * t) / nTasks;
+                size_t c1 = (chunks.size () * (t + 1)) / nTasks;
+
+                ILMTHREAD_NAMESPACE::ThreadPool::addGlobalTask (
+                    new SampleCountTask (
+                        &tg,
+                        *_ctxt,
+                        partNumber,
+                        chunks.data () + c0,
+                        c1 - c0,
+                        scanLine1,
+                        scanLine2,
+                        perPixel,
+                        &totals[t],
+                        &failures[t]));
+            }
+        }
+
+        uint64_t total = 0;
+        for (size_t t = 0; t < nTasks; ++t)
+        {
+            if (!failures[t].empty ())
+                throw IEX_NAMESPACE::IoExc (failures[t]);
+            total += totals[t];
+        }
+        return total;
+    }
+#endif
+
+    return countChunkSamples (
+        *_ctxt,
+        partNumber,
+        chunks.data (),
+        chunks.size (),
+        scanLine1,
+        scanLine2,
+        perPixel);
+}
+
+////////////////////////////////////////
+
 void
 DeepScanLineInputFile::Data::readMemData (
         const DeepFrameBuffer &fb,
@@ -717,6 +1027,10 @@ void DeepScanLineInputFile::Data::LineBufferTask::execute ()
 {
     try
     {
+        _line              = _ifd->getChunkProcess ();
+        _line->cinfo       = _cinfo;
+        _line->counts_only = _countsOnly;
+        _line->alloc       = _alloc;
         _line->run_decode (
             *(_ifd->_ctxt),
             _ifd->partNumber,
@@ -741,6 +1055,26 @@ mem_skip_read_chunk (exr_decode_pipeline_t* decode)
     return EXR_ERR_SUCCESS;
 }
 
+// called by the decode pipeline between unpacking the sample
+// counts and the sample data
+static exr_result_t
+auto_alloc_samples (exr_decode_pipeline_t* decode)
+{
+    ScanLineProcess* sp =
+        static_cast<ScanLineProcess*> (decode->decoding_user_data);
+
+    try
+    {
+        sp->allocate_samples ();
+    }
+    catch (...)
+    {
+        sp->alloc_error = std::current_exception ();
+        return EXR_ERR_OUT_OF_MEMORY;
+    }
+    return EXR_ERR_SUCCESS;
+}
+
 void ScanLineProcess::run_mem_decode (
         exr_const_context_t ctxt,
         int pn,
@@ -838,7 +1172,23 @@ void ScanLineProcess::run_decode (
         }
     }
 
+    if (alloc && !counts_only)
+    {
+        decoder.decoding_user_data       = this;
+        decoder.realloc_nonimage_data_fn = &auto_alloc_samples;
+        alloc_fb                         = outfb;
+        alloc_error                      = nullptr;
+    }
+    else
+        decoder.realloc_nonimage_data_fn = NULL;
+
     last_decode_err = exr_decoding_run (ctxt, pn, &decoder);
+    if (alloc_error)
+    {
+        std::exception_ptr e = alloc_error;
+        alloc_error          = nullptr;
+        std::rethrow_exception (e);
+    }
     if (EXR_ERR_SUCCESS != last_decode_err)
         throw IEX_NAMESPACE::IoExc ("Unable to run decoder");
 
@@ -1005,6 +1355,74 @@ void ScanLineProcess::run_fill (
 
 ////////////////////////////////////////
 
+void ScanLineProcess::allocate_samples ()
+{
+    int     y0    = decoder.user_line_begin_skip;
+    int     y1    = cinfo.height - decoder.user_line_end_ignore;
+    int     width = cinfo.width;
+    int64_t total = 0;
+
+    for (int y = y0; y < y1; ++y)
+    {
+        const int32_t* counts = decoder.sample_count_table + y * width;
+        for (int x = 0; x < width; ++x)
+            total += counts[x];
+    }
+
+    //
+    // one block for all slices, each slice's samples starting on
+    // an 8 byte boundary
+    //
+
+    size_t bytes = 0;
+    for (DeepFrameBuffer::ConstIterator i = alloc_fb->begin ();
+         i != alloc_fb->end ();
+         ++i)
+    {
+        size_t sz = size_t (total) * i.slice ().sampleStride;
+        bytes += (sz + 7) & ~size_t (7);
+    }
+
+    char* block = nullptr;
+    if (bytes > 0)
+    {
+        block = static_cast<char*> (alloc->allocate (
+            bytes, cinfo.start_y + y0, cinfo.start_y + y1 - 1));
+        if (!block)
+            throw IEX_NAMESPACE::ArgExc (
+                "Deep sample allocator returned no memory");
+    }
+
+    for (DeepFrameBuffer::ConstIterator i = alloc_fb->begin ();
+         i != alloc_fb->end ();
+         ++i)
+    {
+        const DeepSlice& fbslice = i.slice ();
+        size_t           stride  = fbslice.sampleStride;
+        char*            samples = block;
+
+        for (int y = y0; y < y1; ++y)
+        {
+            const int32_t* counts = decoder.sample_count_table + y * width;
+            char*          ptr    = fbslice.base;
+
+            ptr += int64_t (cinfo.start_x) * int64_t (fbslice.xStride);
+            ptr += (int64_t (cinfo.start_y) + y) * int64_t (fbslice.yStride);
+
+            for (int x = 0; x < width; ++x)
+            {
+                *reinterpret_cast<char**> (ptr) = samples;
+                samples += size_t (counts[x]) * stride;
+                ptr += fbslice.xStride;
+            }
+        }
+
+        if (block) block += (size_t (total) * stride + 7) & ~size_t (7);
+    }
+}
+
+////////////////////////////////////////
+
 void ScanLineProcess::copy_sample_count (
     const DeepFrameBuffer *outfb,
     int fbY)
@@ -132,6 +132,41 @@ public:
     IMF_EXPORT
     void readPixels (int scanLine);
 
+    //---------------------------------------------------------------
+    // Read sample counts and pixel data in a single pass:
+    //
+    // readPixelsAutoAlloc(s1,s2,allocator) reads the scan lines in
+    // the interval [min (s1, s2), max (s1, s2)] like readPixels(),
+    // but without the sample counts having to be read and the sample
+    // storage being set up beforehand.  Each chunk is read and
+    // decompressed once; once its sample counts are known, storage
+    // for its samples is requested from the allocator, and the
+    // pointers of the frame buffer's deep slices are set to point
+    // into it before the samples are unpacked.  The sample counts
+    // are stored in the sample count slice as by readPixelSampleCounts().
+    //
+    // The frame buffer's deep slices must therefore be arrays of
+    // pointers (one per pixel), whose contents are overwritten.  Each
+    // chunk's block holds the samples of every slice in turn, pixel
+    // by pixel, with sampleStride bytes per sample.
+    //
+    // If allocator is null, the memory comes from an arena owned by
+    // this file, which is kept until releaseAutoAllocData() is called
+    // or the file is destroyed.
+    //
+    // With threading enabled, chunks are decoded in parallel, and the
+    // allocator may be called from several threads at once.
+    //---------------------------------------------------------------
+
+    IMF_EXPORT
+    void readPixelsAutoAlloc (
+        int                  scanLine1,
+        int                  scanLine2,
+        DeepSampleAllocator* allocator = nullptr);
+
+    IMF_EXPORT
+    void releaseAutoAllocData ();
+
     //---------------------------------------------------------------
     // Extract pixel data from pre-read block
     //
@@ -233,6 +268,32 @@ public:
         int                    scanLine1,
         int                    scanLine2) const;
 
+    //-----------------------------------------------------------
+    // Count samples without reading them:
+    //
+    // totalSampleCount(s1, s2) returns the number of samples in the
+    // scan lines with y coordinates in the interval
+    // [min (s1, s2), max (s1, s2)].  Only the sample count table of
+    // each chunk is read from the file and decompressed; the sample
+    // data is skipped, so this is a cheap way to find out how much
+    // memory reading the lines will need.  No frame buffer is used,
+    // and with threading enabled the chunks are read in parallel.
+    //
+    // sampleCounts(s1, s2, counts) reads the same tables, and stores
+    // the sample count of each pixel of those scan lines in counts,
+    // row by row: the count of pixel (x, y) goes to
+    // counts[(y - min (s1, s2)) * w + (x - dataWindow.min.x)], where
+    // w is the width of the data window.
+    //
+    //-----------------------------------------------------------
+
+    IMF_EXPORT
+    uint64_t totalSampleCount (int scanLine1, int scanLine2) const;
+
+    IMF_EXPORT
+    void
+    sampleCounts (int scanLine1, int scanLine2, unsigned int counts[]) const;
+
 private:
     Context _ctxt;
     struct IMF_HIDDEN Data;
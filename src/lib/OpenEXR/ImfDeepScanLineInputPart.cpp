@@ -65,6 +65,19 @@ DeepScanLineInputPart::readPixels (int scanLine)
     file->readPixels (scanLine);
 }
 
+void
+DeepScanLineInputPart::readPixelsAutoAlloc (
+    int scanLine1, int scanLine2, DeepSampleAllocator* allocator)
+{
+    file->readPixelsAutoAlloc (scanLine1, scanLine2, allocator);
+}
+
+void
+DeepScanLineInputPart::releaseAutoAllocData ()
+{
+    file->releaseAutoAllocData ();
+}
+
 void
 DeepScanLineInputPart::rawPixelData (
     int firstScanLine, char* pixelData, uint64_t& pixelDataSize)
@@ -116,4 +129,17 @@ DeepScanLineInputPart::readPixelSampleCounts (
         rawdata, frameBuffer, scanLine1, scanLine2);
 }
 
+uint64_t
+DeepScanLineInputPart::totalSampleCount (int scanLine1, int scanLine2) const
+{
+    return file->totalSampleCount (scanLine1, scanLine2);
+}
+
+void
+DeepScanLineInputPart::sampleCounts (
+    int scanLine1, int scanLine2, unsigned int counts[]) const
+{
+    file->sampleCounts (scanLine1, scanLine2, counts);
+}
+
 OPENEXR_IMF_INTERNAL_NAMESPACE_SOURCE_EXIT
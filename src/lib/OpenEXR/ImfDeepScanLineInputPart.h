@@ -98,6 +98,20 @@ public:
     void readPixels (int scanLine1, int scanLine2);
     IMF_EXPORT
     void readPixels (int scanLine);
+
+    //----------------------------------------------------
+    // Single-pass read, see DeepScanLineInputFile for
+    // the details
+    //----------------------------------------------------
+
+    IMF_EXPORT
+    void readPixelsAutoAlloc (
+        int                  scanLine1,
+        int                  scanLine2,
+        DeepSampleAllocator* allocator = nullptr);
+    IMF_EXPORT
+    void releaseAutoAllocData ();
+
     IMF_EXPORT
     void readPixels (
         const char*            rawPixelData,
@@ -141,6 +155,13 @@ public:
         int                    scanLine1,
         int                    scanLine2) const;
 
+    IMF_EXPORT
+    uint64_t totalSampleCount (int scanLine1, int scanLine2) const;
+
+    IMF_EXPORT
+    void
+    sampleCounts (int scanLine1, int scanLine2, unsigned int counts[]) const;
+
     IMF_EXPORT
     int firstScanLineInChunk (int y) const;
     IMF_EXPORT
@@ -71,9 +71,140 @@ struct TileProcess
     exr_chunk_info_t      cinfo;
     exr_decode_pipeline_t decoder;
 
+    // NUMA node of the thread which created this, and so first
+    // touched the decode buffers
+    int node = 0;
+
     std::shared_ptr<TileProcess> next;
 };
 
+//
+// Where the per-pixel counts of a range of tiles go: base holds the
+// count of the first pixel of tile (dx0, dy0), followed by the rest of
+// the range, width counts per row
+//
+
+struct PixelCounts
+{
+    unsigned int* base;
+    int           dx0;
+    int           dy0;
+    int           tileXSize;
+    int           tileYSize;
+    size_t        width;
+};
+
+//
+// Sum the samples of a run of tiles, reading nothing but their
+// sample count tables.  If perPixel is not null, the count of each
+// pixel is stored as well.
+//
+
+uint64_t
+countTileSamples (
+    exr_const_context_t     ctxt,
+    int                     pn,
+    const exr_chunk_info_t* chunks,
+    size_t                  nChunks,
+    const PixelCounts*      perPixel)
+{
+    std::vector<int32_t> counts;
+    uint64_t             total = 0;
+
+    for (size_t c = 0; c < nChunks; ++c)
+    {
+        const exr_chunk_info_t& cinfo     = chunks[c];
+        uint64_t                tileTotal = 0;
+
+        if (perPixel)
+            counts.resize (size_t (cinfo.width) * size_t (cinfo.height));
+
+        if (EXR_ERR_SUCCESS != exr_read_deep_sample_counts (
+                ctxt,
+                pn,
+                &cinfo,
+                perPixel ? counts.data () : nullptr,
+                &tileTotal))
+        {
+            THROW (
+                IEX_NAMESPACE::InputExc,
+                "Unable to read the sample counts of tile ("
+                    << chunks[c].start_x << ", " << chunks[c].start_y << ", "
+                    << int (chunks[c].level_x) << ", "
+                    << int (chunks[c].level_y) << ")");
+        }
+
+        total += tileTotal;
+
+        for (int y = 0; perPixel && y < cinfo.height; ++y)
+        {
+            size_t row = size_t (cinfo.start_y - perPixel->dy0) *
+                             perPixel->tileYSize +
+                         y;
+            size_t col = size_t (cinfo.start_x - perPixel->dx0) *
+                         perPixel->tileXSize;
+
+            const int32_t* line = counts.data () + size_t (y) * cinfo.width;
+            unsigned int*  out  = perPixel->base + row * perPixel->width + col;
+
+            std::copy (line, line + cinfo.width, out);
+        }
+    }
+
+    return total;
+}
+
+#if ILMTHREAD_THREADING_ENABLED
+class SampleCountTask final : public ILMTHREAD_NAMESPACE::Task
+{
+public:
+    SampleCountTask (
+        ILMTHREAD_NAMESPACE::TaskGroup* group,
+        exr_const_context_t             ctxt,
+        int                             pn,
+        const exr_chunk_info_t*         chunks,
+        size_t                          nChunks,
+        const PixelCounts*              perPixel,
+        uint64_t*                       total,
+        std::string*                    failure)
+        : Task (group)
+        , _ctxt (ctxt)
+        , _pn (pn)
+        , _chunks (chunks)
+        , _nChunks (nChunks)
+        , _perPixel (perPixel)
+        , _total (total)
+        , _failure (failure)
+    {}
+
+    void execute () override
+    {
+        try
+        {
+            *_total = countTileSamples (
+                _ctxt, _pn, _chunks, _nChunks, _perPixel);
+        }
+        catch (std::exception& e)
+        {
+            *_failure = e.what ();
+        }
+        catch (...)
+        {
+            *_failure = "unknown exception";
+        }
+    }
+
+private:
+    exr_const_context_t     _ctxt;
+    int                     _pn;
+    const exr_chunk_info_t* _chunks;
+    size_t                  _nChunks;
+    const PixelCounts*      _perPixel;
+    uint64_t*               _total;
+    std::string*            _failure;
+};
+#endif
+
 } // empty namespace
 
 //
@@ -117,6 +248,15 @@ struct DeepTiledInputFile::Data
     // TODO: generalize to have async framebuffer path
     void readTiles (int dx1, int dx2, int dy1, int dy2, int lx, int ly, bool countsOnly);
 
+    uint64_t countSamples (
+        int           dx1,
+        int           dx2,
+        int           dy1,
+        int           dy2,
+        int           lx,
+        int           ly,
+        unsigned int* perPixel) const;
+
     Context* _ctxt;
     int partNumber;
     int numThreads;
@@ -142,17 +282,25 @@ struct DeepTiledInputFile::Data
     ILMTHREAD_NAMESPACE::Semaphore _sem;
 #endif
 
-    std::shared_ptr<TileProcess> processStack;
+    // one stack of decoders per NUMA node, so a thread reuses the
+    // buffers of its own node
+    std::vector<std::shared_ptr<TileProcess>> processStacks;
     std::shared_ptr<TileProcess> getChunkProcess ()
     {
+        int node = ILMTHREAD_NAMESPACE::ThreadPool::currentNumaNode ();
         std::shared_ptr<TileProcess> retval;
 #if ILMTHREAD_THREADING_ENABLED
         std::lock_guard<std::mutex> lk (_mx);
 #endif
-        retval = processStack;
+        if (processStacks.size () <= size_t (node))
+            processStacks.resize (node + 1);
+        retval = processStacks[node];
         if (!retval)
+        {
             retval = std::make_shared<TileProcess> ();
-        processStack = retval->next;
+            retval->node = node;
+        }
+        processStacks[node] = retval->next;
         retval->next.reset();
         return retval;
     }
@@ -161,8 +309,10 @@ struct DeepTiledInputFile::Data
 #if ILMTHREAD_THREADING_ENABLED
         std::lock_guard<std::mutex> lk (_mx);
 #endif
-        tp->next = processStack;
-        processStack = tp;
+        if (processStacks.size () <= size_t (tp->node))
+            processStacks.resize (tp->node + 1);
+        tp->next = processStacks[tp->node];
+        processStacks[tp->node] = tp;
     }
 
 #if ILMTHREAD_THREADING_ENABLED
@@ -178,11 +328,9 @@ struct DeepTiledInputFile::Data
             : Task (group)
             , _outfb (outfb)
             , _ifd (ifd)
-            , _tile (ifd->getChunkProcess ())
-        {
-            _tile->cinfo = cinfo;
-            _tile->counts_only = countsOnly;
-        }
+            , _cinfo (cinfo)
+            , _countsOnly (countsOnly)
+        {}
 
         ~TileBufferTask () override
         {
@@ -198,7 +346,10 @@ struct DeepTiledInputFile::Data
 
         const DeepFrameBuffer* _outfb;
         Data*                  _ifd;
+        exr_chunk_info_t       _cinfo;
+        bool                   _countsOnly;
 
+        // taken when the task runs, from the worker's NUMA node
         std::shared_ptr<TileProcess> _tile;
     };
 #endif
@@ -307,7 +458,7 @@ DeepTiledInputFile::setFrameBuffer (const DeepFrameBuffer& frameBuffer)
 
     _data->frameBuffer = frameBuffer;
     _data->frameBufferValid = true;
-    _data->processStack.reset();
+    _data->processStacks.clear ();
 }
 
 const DeepFrameBuffer&
@@ -734,6 +885,88 @@ DeepTiledInputFile::readPixelSampleCounts (
     readPixelSampleCounts (dx1, dx2, dy1, dy2, l, l);
 }
 
+uint64_t
+DeepTiledInputFile::totalSampleCount (
+    int dx1, int dx2, int dy1, int dy2, int lx, int ly) const
+{
+    try
+    {
+        if (!isValidLevel (lx, ly))
+            THROW (
+                IEX_NAMESPACE::ArgExc,
+                "Level coordinate "
+                "(" << lx
+                    << ", " << ly
+                    << ") "
+                       "is invalid.");
+
+        if (dx1 > dx2) std::swap (dx1, dx2);
+        if (dy1 > dy2) std::swap (dy1, dy2);
+
+        return _data->countSamples (dx1, dx2, dy1, dy2, lx, ly, nullptr);
+    }
+    catch (IEX_NAMESPACE::BaseExc& e)
+    {
+        REPLACE_EXC (
+            e,
+            "Error counting deep samples of image "
+            "file \""
+                << fileName () << "\". " << e.what ());
+        throw;
+    }
+}
+
+uint64_t
+DeepTiledInputFile::totalSampleCount (
+    int dx1, int dx2, int dy1, int dy2, int l) const
+{
+    return totalSampleCount (dx1, dx2, dy1, dy2, l, l);
+}
+
+void
+DeepTiledInputFile::sampleCounts (
+    int           dx1,
+    int           dx2,
+    int           dy1,
+    int           dy2,
+    int           lx,
+    int           ly,
+    unsigned int* counts) const
+{
+    try
+    {
+        if (!isValidLevel (lx, ly))
+            THROW (
+                IEX_NAMESPACE::ArgExc,
+                "Level coordinate "
+                "(" << lx
+                    << ", " << ly
+                    << ") "
+                       "is invalid.");
+
+        if (dx1 > dx2) std::swap (dx1, dx2);
+        if (dy1 > dy2) std::swap (dy1, dy2);
+
+        _data->countSamples (dx1, dx2, dy1, dy2, lx, ly, counts);
+    }
+    catch (IEX_NAMESPACE::BaseExc& e)
+    {
+        REPLACE_EXC (
+            e,
+            "Error reading deep sample counts of image "
+            "file \""
+                << fileName () << "\". " << e.what ());
+        throw;
+    }
+}
+
+void
+DeepTiledInputFile::sampleCounts (
+    int dx1, int dx2, int dy1, int dy2, int l, unsigned int* counts) const
+{
+    sampleCounts (dx1, dx2, dy1, dy2, l, l, counts);
+}
+
 size_t
 DeepTiledInputFile::totalTiles () const
 {
@@ -996,11 +1229,112 @@ void DeepTiledInputFile::Data::readTiles (
 
 ////////////////////////////////////////
 
+uint64_t DeepTiledInputFile::Data::countSamples (
+    int           dx1,
+    int           dx2,
+    int           dy1,
+    int           dy2,
+    int           lx,
+    int           ly,
+    unsigned int* perPixel) const
+{
+    std::vector<exr_chunk_info_t> chunks;
+    exr_chunk_info_t              cinfo;
+
+    for (int ty = dy1; ty <= dy2; ++ty)
+    {
+        for (int tx = dx1; tx <= dx2; ++tx)
+        {
+            exr_result_t rv = exr_read_tile_chunk_info (
+                *_ctxt, partNumber, tx, ty, lx, ly, &cinfo);
+            if (EXR_ERR_INCOMPLETE_CHUNK_TABLE == rv)
+            {
+                THROW (
+                    IEX_NAMESPACE::InputExc,
+                    "Tile (" << tx << ", " << ty << ", " << lx << ", " << ly
+                    << ") is missing.");
+            }
+            else if (EXR_ERR_SUCCESS != rv)
+                throw IEX_NAMESPACE::InputExc ("Unable to query tile information");
+
+            chunks.push_back (cinfo);
+        }
+    }
+
+    //
+    // chunks ends with tile (dx2, dy2), which may be narrower than the
+    // others if it lies on the right edge of the level
+    //
+
+    PixelCounts  target;
+    PixelCounts* pixelCounts = nullptr;
+
+    if (perPixel)
+    {
+        target.base      = perPixel;
+        target.dx0       = dx1;
+        target.dy0       = dy1;
+        target.tileXSize = int (tile_x_size);
+        target.tileYSize = int (tile_y_size);
+        target.width =
+            size_t (dx2 - dx1) * tile_x_size + size_t (chunks.back ().width);
+        pixelCounts = &target;
+    }
+
+#if ILMTHREAD_THREADING_ENABLED
+    size_t nTasks = std::min (chunks.size (), size_t (std::max (numThreads, 1)));
+
+    if (nTasks > 1)
+    {
+        std::vector<uint64_t>    totals (nTasks, 0);
+        std::vector<std::string> failures (nTasks);
+
+        {
+            ILMTHREAD_NAMESPACE::TaskGroup tg;
+
+            for (size_t t = 0; t < nTasks; ++t)
+            {
+                size_t c0 = (chunks.size () * t) / nTasks;
+                size_t c1 = (chunks.size () * (t + 1)) / nTasks;
+
+                ILMTHREAD_NAMESPACE::ThreadPool::addGlobalTask (
+                    new SampleCountTask (
+                        &tg,
+                        *_ctxt,
+                        partNumber,
+                        chunks.data () + c0,
+                        c1 - c0,
+                        pixelCounts,
+                        &totals[t],
+                        &failures[t]));
+            }
+        }
+
+        uint64_t total = 0;
+        for (size_t t = 0; t < nTasks; ++t)
+        {
+            if (!failures[t].empty ())
+                throw IEX_NAMESPACE::IoExc (failures[t]);
+            total += totals[t];
+        }
+        return total;
+    }
+#endif
+
+    return countTileSamples (
+        *_ctxt, partNumber, chunks.data (), chunks.size (), pixelCounts);
+}
+
+////////////////////////////////////////
+
 #if ILMTHREAD_THREADING_ENABLED
 void DeepTiledInputFile::Data::TileBufferTask::execute ()
 {
     try
     {
+        _tile              = _ifd->getChunkProcess ();
+        _tile->cinfo       = _cinfo;
+        _tile->counts_only = _countsOnly;
         _tile->run_decode (
             *(_ifd->_ctxt),
             _ifd->partNumber,
@@ -377,6 +377,56 @@ public:
     IMF_EXPORT
     void readPixelSampleCounts (int dx1, int dx2, int dy1, int dy2, int l = 0);
 
+    //------------------------------------------------------------------
+    // Count samples without reading them:
+    //
+    // totalSampleCount(dx1, dx2, dy1, dy2, lx, ly) returns the number
+    // of samples in the tiles within range
+    // [(min(dx1, dx2), min(dy1, dy2))...(max(dx1, dx2), max(dy1, dy2)],
+    // on level (lx, ly).  Only the sample count table of each tile is
+    // read from the file and decompressed; the sample data is skipped,
+    // so this is a cheap way to find out how much memory reading the
+    // tiles will need.  No frame buffer is used, and with threading
+    // enabled the tiles are read in parallel.
+    //
+    // totalSampleCount(dx1, dx2, dy1, dy2, l) calls
+    // totalSampleCount(dx1, dx2, dy1, dy2, lx = l, ly = l).
+    //
+    // sampleCounts(dx1, dx2, dy1, dy2, lx, ly, counts) reads the same
+    // tables, and stores the sample count of each pixel of those tiles
+    // in counts, row by row.  If (x0, y0) and (x1, y1) are the corners
+    // of the pixel region covered by the tiles, that is the union of
+    // dataWindowForTile() of the first and the last tile, the count of
+    // pixel (x, y) goes to counts[(y - y0) * (x1 - x0 + 1) + (x - x0)].
+    //
+    // sampleCounts(dx1, dx2, dy1, dy2, l, counts) calls
+    // sampleCounts(dx1, dx2, dy1, dy2, lx = l, ly = l, counts).
+    //------------------------------------------------------------------
+
+    IMF_EXPORT
+    uint64_t
+    totalSampleCount (int dx1, int dx2, int dy1, int dy2, int lx, int ly)
+        const;
+
+    IMF_EXPORT
+    uint64_t
+    totalSampleCount (int dx1, int dx2, int dy1, int dy2, int l = 0) const;
+
+    IMF_EXPORT
+    void sampleCounts (
+        int          dx1,
+        int          dx2,
+        int          dy1,
+        int          dy2,
+        int          lx,
+        int          ly,
+        unsigned int counts[]) const;
+
+    IMF_EXPORT
+    void sampleCounts (
+        int dx1, int dx2, int dy1, int dy2, int l, unsigned int counts[])
+        const;
+
 private:
     Context _ctxt;
     struct IMF_HIDDEN Data;
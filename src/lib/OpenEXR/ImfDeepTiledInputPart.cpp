@@ -207,4 +207,38 @@ DeepTiledInputPart::readPixelSampleCounts (
     file->readPixelSampleCounts (dx1, dx2, dy1, dy2, l);
 }
 
+uint64_t
+DeepTiledInputPart::totalSampleCount (
+    int dx1, int dx2, int dy1, int dy2, int lx, int ly) const
+{
+    return file->totalSampleCount (dx1, dx2, dy1, dy2, lx, ly);
+}
+
+uint64_t
+DeepTiledInputPart::totalSampleCount (
+    int dx1, int dx2, int dy1, int dy2, int l) const
+{
+    return file->totalSampleCount (dx1, dx2, dy1, dy2, l);
+}
+
+void
+DeepTiledInputPart::sampleCounts (
+    int           dx1,
+    int           dx2,
+    int           dy1,
+    int           dy2,
+    int           lx,
+    int           ly,
+    unsigned int* counts) const
+{
+    file->sampleCounts (dx1, dx2, dy1, dy2, lx, ly, counts);
+}
+
+void
+DeepTiledInputPart::sampleCounts (
+    int dx1, int dx2, int dy1, int dy2, int l, unsigned int* counts) const
+{
+    file->sampleCounts (dx1, dx2, dy1, dy2, l, counts);
+}
+
 OPENEXR_IMF_INTERNAL_NAMESPACE_SOURCE_EXIT
@@ -334,6 +334,30 @@ public:
     IMF_EXPORT
     void readPixelSampleCounts (int dx1, int dx2, int dy1, int dy2, int l = 0);
 
+    IMF_EXPORT
+    uint64_t
+    totalSampleCount (int dx1, int dx2, int dy1, int dy2, int lx, int ly)
+        const;
+
+    IMF_EXPORT
+    uint64_t
+    totalSampleCount (int dx1, int dx2, int dy1, int dy2, int l = 0) const;
+
+    IMF_EXPORT
+    void sampleCounts (
+        int          dx1,
+        int          dx2,
+        int          dy1,
+        int          dy2,
+        int          lx,
+        int          ly,
+        unsigned int counts[]) const;
+
+    IMF_EXPORT
+    void sampleCounts (
+        int dx1, int dx2, int dy1, int dy2, int l, unsigned int counts[])
+        const;
+
 private:
     DeepTiledInputFile* file;
 
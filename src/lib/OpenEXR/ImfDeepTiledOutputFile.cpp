@@ -967,12 +967,15 @@ TileBufferTask::execute ()
 
         //
         // If we can't make data shrink (or compression was disabled), then just use the raw data.
+        // Tiles on the right and bottom edges have smaller tables than a full
+        // tile, so compare against, and store, this tile's own table; storing
+        // a full tile's worth of bytes would pad the table with stale data.
         //
 
         if (!_tileBuffer->sampleCountTableCompressor ||
-            _tileBuffer->sampleCountTableSize >= _ofd->maxSampleCountTableSize)
+            _tileBuffer->sampleCountTableSize >= tableDataSize)
         {
-            _tileBuffer->sampleCountTableSize = _ofd->maxSampleCountTableSize;
+            _tileBuffer->sampleCountTableSize = tableDataSize;
             _tileBuffer->sampleCountTablePtr =
                 _tileBuffer->sampleCountTableBuffer;
         }
@@ -0,0 +1,41 @@
+//
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) Contributors to the OpenEXR Project.
+//
+
+#ifndef INCLUDED_IMF_DEFAULT_DEEP_COMPOSITING_H
+#define INCLUDED_IMF_DEFAULT_DEEP_COMPOSITING_H
+
+//-----------------------------------------------------------------------------
+//
+//	The compositing engine that CompositeDeepScanLine and
+//	CompositeDeepTile use when no DeepCompositing object is set.
+//	It gives the same results as DeepCompositing's composite_pixel()
+//	and sort(), but composites whole runs of pixels without the per
+//	pixel overhead: samples are ordered with an insertion sort (few
+//	samples) or a radix sort on Z and ZBack (many samples), and several
+//	channels are composited at once using SIMD instructions where
+//	available.
+//
+//-----------------------------------------------------------------------------
+
+#include "ImfDeepCompositing.h"
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_HEADER_ENTER
+
+class DefaultDeepCompositing final : public DeepCompositing
+{
+public:
+    void composite_span (
+        float*             outputs[],
+        const float*       inputs[],
+        const char*        channel_names[],
+        int                num_channels,
+        const unsigned int num_samples[],
+        const unsigned int sources[],
+        int                num_pixels) override;
+};
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_HEADER_EXIT
+
+#endif
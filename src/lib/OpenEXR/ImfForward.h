@@ -44,6 +44,7 @@ class IMF_EXPORT_TYPE AcesOutputFile;
 class IMF_EXPORT_TYPE TiledInputPart;
 class IMF_EXPORT_TYPE TiledInputFile;
 class IMF_EXPORT_TYPE TileOffsets;
+class IMF_EXPORT_TYPE ReadPlan;
 
 // multipart file handling
 class IMF_EXPORT_TYPE GenericInputFile;
@@ -64,6 +65,7 @@ class IMF_EXPORT_TYPE DeepTiledOutputPart;
 
 // internal use only
 struct InputPartData;
+struct ReadPlanData;
 struct OutputStreamMutex;
 struct OutputPartData;
 struct InputStreamMutex;
@@ -73,10 +75,13 @@ struct InputStreamMutex;
 class IMF_EXPORT_TYPE  FrameBuffer;
 class IMF_EXPORT_TYPE  DeepFrameBuffer;
 struct IMF_EXPORT_TYPE DeepSlice;
+class IMF_EXPORT_TYPE  DeepSampleAllocator;
+class IMF_EXPORT_TYPE  DeepSampleArena;
 
 // compositing
 class IMF_EXPORT_TYPE DeepCompositing;
 class IMF_EXPORT_TYPE CompositeDeepScanLine;
+class IMF_EXPORT_TYPE CompositeDeepTile;
 
 // preview image
 class IMF_EXPORT_TYPE  PreviewImage;
@@ -88,6 +93,8 @@ class IMF_EXPORT_TYPE IStream;
 
 class IMF_EXPORT_TYPE IDManifest;
 class IMF_EXPORT_TYPE CompressedIDManifest;
+class IMF_EXPORT_TYPE FlatIDManifest;
+class IMF_EXPORT_TYPE LazyIDManifest;
 
 OPENEXR_IMF_INTERNAL_NAMESPACE_HEADER_EXIT
 
@@ -8,12 +8,18 @@
 //-----------------------------------------------------------------------------
 
 #include "ImfIO.h"
+#include "ImfThreading.h"
 #include "ImfXdr.h"
 #include <Iex.h>
+#include <IlmThreadPool.h>
 #include <ImfIDManifest.h>
 #include <openexr_compression.h>
 
 #include <algorithm>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <numeric>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
@@ -299,28 +305,27 @@ writePascalString (char*& outPtr, const string& str)
     Xdr::write<CharPtrIO> ((char*&) outPtr, (const char*) str.c_str (), length);
 }
 
-} // namespace
-
-IDManifest::IDManifest (const char* data, const char* endOfData)
-{
-    init (data, endOfData);
-}
+void readStringMapping (
+    const char*& data,
+    const char*  endOfData,
+    size_t       numStrings,
+    vector<int>& mapping);
 
+//
+// read the table of all strings used in a serialized manifest, and the
+// mapping from the indices used by the manifest entries to indices in
+// that table
+//
 void
-IDManifest::init (const char* data, const char* endOfData)
+readStringTable (
+    const char*&    data,
+    const char*     endOfData,
+    vector<string>& stringList,
+    vector<int>&    mapping)
 {
-
-    unsigned int version;
-    Xdr::read<CharPtrIO> (data, version);
-    if (version != 0)
-    {
-        throw IEX_NAMESPACE::InputExc ("Unrecognized IDmanifest version");
-    }
-
     //
     // first comes list of all strings used in manifest
     //
-    vector<string> stringList;
     readStringList (data, endOfData, stringList);
 
     //
@@ -353,13 +358,22 @@ IDManifest::init (const char* data, const char* endOfData)
                         stringList[i].substr (stringStart);
     }
 
-    //
-    // decode mapping table from indices in table to indices in string list
-    // the mapping uses smaller indices for more commonly occurring strings, since these are encoded with fewer bits
-    // comments in serialize function describe the format
-    //
+    readStringMapping (data, endOfData, stringList.size (), mapping);
+}
 
-    vector<int> mapping (stringList.size ());
+//
+// decode mapping table from indices in table to indices in string list
+// the mapping uses smaller indices for more commonly occurring strings, since these are encoded with fewer bits
+// comments in serialize function describe the format
+//
+void
+readStringMapping (
+    const char*& data,
+    const char*  endOfData,
+    size_t       numStrings,
+    vector<int>& mapping)
+{
+    mapping.assign (numStrings, 0);
 
     //
     // overlapping sequences: A list [(4,5),(3,6)] expands to 4,5,3,6 - because 4 and 5 are including already
@@ -367,7 +381,7 @@ IDManifest::init (const char* data, const char* endOfData)
     // the 'seen' list indicates which values have already been used, so they are not re-referenced
     //
 
-    vector<char> seen (stringList.size ());
+    vector<char> seen (numStrings);
 
     int rleLength;
     if (endOfData < data + 4)
@@ -390,8 +404,7 @@ IDManifest::init (const char* data, const char* endOfData)
         Xdr::read<CharPtrIO> (data, last);
 
         if (first < 0 || last < 0 || first > last ||
-            first >= int (stringList.size ()) ||
-            last >= int (stringList.size ()))
+            first >= int (numStrings) || last >= int (numStrings))
         {
             throw IEX_NAMESPACE::InputExc (
                 "Bad mapping table entry in IDManifest");
@@ -417,6 +430,96 @@ IDManifest::init (const char* data, const char* endOfData)
         std::cout << i << ' ' << mapping[i] << std::endl;
     }
 #endif
+}
+
+//
+// read one (delta encoded) ID number of a manifest entry
+//
+uint64_t
+readId (const char*& data, const char* endOfData, char storageScheme)
+{
+    uint64_t id;
+
+    switch (storageScheme)
+    {
+        case 0: {
+            if (endOfData < data + 8)
+            {
+                throw IEX_NAMESPACE::InputExc ("IDManifest too small");
+            }
+            Xdr::read<CharPtrIO> (data, id);
+            break;
+        }
+        case 1: {
+            if (endOfData < data + 4)
+            {
+                throw IEX_NAMESPACE::InputExc ("IDManifest too small");
+            }
+            unsigned int id32;
+            Xdr::read<CharPtrIO> (data, id32);
+            id = id32;
+            break;
+        }
+        default: {
+            id = readVariableLengthInteger (data, endOfData);
+        }
+    }
+
+    return id;
+}
+
+//
+// decompress a compressed manifest into its serialized representation
+//
+void
+uncompressManifest (const CompressedIDManifest& compressed, vector<char>& uncomp)
+{
+    uncomp.resize (compressed._uncompressedDataSize);
+    size_t outSize;
+    size_t inSize = static_cast<size_t> (compressed._compressedDataSize);
+    if (EXR_ERR_SUCCESS != exr_uncompress_buffer (
+                               nullptr,
+                               compressed._data,
+                               inSize,
+                               uncomp.data (),
+                               compressed._uncompressedDataSize,
+                               &outSize))
+    {
+        throw IEX_NAMESPACE::InputExc (
+            "IDManifest decompression (zlib) failed.");
+    }
+    if (outSize != compressed._uncompressedDataSize)
+    {
+        throw IEX_NAMESPACE::InputExc (
+            "IDManifest decompression (zlib) failed: mismatch in decompressed data size");
+    }
+}
+
+} // namespace
+
+IDManifest::IDManifest (const char* data, const char* endOfData)
+{
+    init (data, endOfData);
+}
+
+void
+IDManifest::init (const char* data, const char* endOfData)
+{
+
+    unsigned int version;
+    Xdr::read<CharPtrIO> (data, version);
+    if (version != 0)
+    {
+        throw IEX_NAMESPACE::InputExc ("Unrecognized IDmanifest version");
+    }
+
+    //
+    // first comes list of all strings used in manifest, followed by
+    // the mapping from indices in the table to indices in the list
+    //
+    vector<string> stringList;
+    vector<int>    mapping;
+    readStringTable (data, endOfData, stringList, mapping);
 
     //
     // number of manifest entries comes after string list
@@ -471,32 +574,7 @@ IDManifest::init (const char* data, const char* endOfData)
 
         for (int entry = 0; entry < tableSize; ++entry)
         {
-            uint64_t id;
-
-            switch (storageScheme)
-            {
-                case 0: {
-                    if (endOfData < data + 8)
-                    {
-                        throw IEX_NAMESPACE::InputExc ("IDManifest too small");
-                    }
-                    Xdr::read<CharPtrIO> (data, id);
-                    break;
-                }
-                case 1: {
-                    if (endOfData < data + 4)
-                    {
-                        throw IEX_NAMESPACE::InputExc ("IDManifest too small");
-                    }
-                    unsigned int id32;
-                    Xdr::read<CharPtrIO> (data, id32);
-                    id = id32;
-                    break;
-                }
-                default: {
-                    id = readVariableLengthInteger (data, endOfData);
-                }
-            }
+            uint64_t id = readId (data, endOfData, storageScheme);
 
             id += previousId;
             previousId = id;
@@ -515,7 +593,7 @@ IDManifest::init (const char* data, const char* endOfData)
             for (size_t i = 0; i < m.getComponents ().size (); ++i)
             {
                 int stringIndex = readVariableLengthInteger (data, endOfData);
-                if (size_t (stringIndex) > stringList.size () ||
+                if (size_t (stringIndex) >= stringList.size () ||
                     stringIndex < 0)
                 {
                     throw IEX_NAMESPACE::InputExc (
@@ -529,31 +607,9 @@ IDManifest::init (const char* data, const char* endOfData)
 
 IDManifest::IDManifest (const CompressedIDManifest& compressed)
 {
-    //
-    // decompress the compressed manifest
-    //
-
-    vector<char> uncomp (compressed._uncompressedDataSize);
-    size_t       outSize;
-    size_t       inSize = static_cast<size_t> (compressed._compressedDataSize);
-    if (EXR_ERR_SUCCESS != exr_uncompress_buffer (
-                               nullptr,
-                               compressed._data,
-                               inSize,
-                               uncomp.data (),
-                               compressed._uncompressedDataSize,
-                               &outSize))
-    {
-        throw IEX_NAMESPACE::InputExc (
-            "IDManifest decompression (zlib) failed.");
-    }
-    if (outSize != compressed._uncompressedDataSize)
-    {
-        throw IEX_NAMESPACE::InputExc (
-            "IDManifest decompression (zlib) failed: mismatch in decompressed data size");
-    }
-
-    init ((const char*) &uncomp[0], (const char*) &uncomp[0] + outSize);
+    vector<char> uncomp;
+    uncompressManifest (compressed, uncomp);
+    init (uncomp.data (), uncomp.data () + uncomp.size ());
 }
 
 void
@@ -1396,6 +1452,792 @@ IDManifest::operator[] (size_t index) const
 namespace
 {
 
+class IndexGroupTask : public ILMTHREAD_NAMESPACE::Task
+{
+public:
+    IndexGroupTask (
+        ILMTHREAD_NAMESPACE::TaskGroup* group,
+        std::function<void ()>          indexGroup,
+        std::mutex&                     errorMutex,
+        std::exception_ptr&             error)
+        : Task (group)
+        , _indexGroup (indexGroup)
+        , _errorMutex (errorMutex)
+        , _error (error)
+    {}
+
+    void execute () override
+    {
+        try
+        {
+            _indexGroup ();
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock (_errorMutex);
+            if (!_error) _error = std::current_exception ();
+        }
+    }
+
+private:
+    std::function<void ()> _indexGroup;
+    std::mutex&            _errorMutex;
+    std::exception_ptr&    _error;
+};
+
+inline size_t
+hashSlot (uint64_t idValue, int shift)
+{
+    //
+    // ID numbers are usually hashes themselves, but may also be small
+    // consecutive integers; multiply to spread them over the table
+    //
+
+    return size_t ((idValue * 0x9E3779B97F4A7C15ull) >> shift);
+}
+
+} // namespace
+
+FlatIDManifest::FlatIDManifest ()
+    : _strings (std::make_shared<const vector<string>> ())
+{}
+
+FlatIDManifest::FlatIDManifest (const IDManifest& manifest)
+{
+    //
+    // intern the text of all entries, storing each distinct string once
+    //
+
+    std::shared_ptr<vector<string>> strings =
+        std::make_shared<vector<string>> ();
+    std::unordered_map<string, uint32_t> stringIndices;
+
+    _groups.resize (manifest.size ());
+
+    for (size_t g = 0; g < manifest.size (); ++g)
+    {
+        const IDManifest::ChannelGroupManifest& m     = manifest[g];
+        Group&                                  group = _groups[g];
+
+        group._channels       = m.getChannels ();
+        group._components     = m.getComponents ();
+        group._lifeTime       = m.getLifetime ();
+        group._hashScheme     = m.getHashScheme ();
+        group._encodingScheme = m.getEncodingScheme ();
+
+        group._ids.reserve (m.size ());
+        group._text.reserve (m.size () * m.getComponents ().size ());
+
+        for (IDManifest::ChannelGroupManifest::ConstIterator i = m.begin ();
+             i != m.end ();
+             ++i)
+        {
+            if (i.text ().size () != group._components.size ())
+            {
+                throw IEX_NAMESPACE::ArgExc (
+                    "Incorrect number of components stored in ID Manifest");
+            }
+
+            group._ids.push_back (i.id ());
+
+            for (const string& text: i.text ())
+            {
+                auto insertion = stringIndices.insert (
+                    make_pair (text, uint32_t (strings->size ())));
+                if (insertion.second) strings->push_back (text);
+                group._text.push_back (insertion.first->second);
+            }
+        }
+    }
+
+    _strings = strings;
+    index ();
+}
+
+FlatIDManifest::FlatIDManifest (const CompressedIDManifest& compressed)
+{
+    vector<char> uncomp;
+    uncompressManifest (compressed, uncomp);
+    init (uncomp.data (), uncomp.data () + uncomp.size ());
+}
+
+FlatIDManifest::FlatIDManifest (const char* data, const char* endOfData)
+{
+    init (data, endOfData);
+}
+
+void
+FlatIDManifest::init (const char* data, const char* endOfData)
+{
+    //
+    // the serialized representation already stores every distinct
+    // string once; it becomes the string pool, and the entries refer
+    // to it by index
+    //
+
+    if (endOfData < data + 4)
+    {
+        throw IEX_NAMESPACE::InputExc ("IDManifest too small");
+    }
+
+    unsigned int version;
+    Xdr::read<CharPtrIO> (data, version);
+    if (version != 0)
+    {
+        throw IEX_NAMESPACE::InputExc ("Unrecognized IDmanifest version");
+    }
+
+    std::shared_ptr<vector<string>> strings =
+        std::make_shared<vector<string>> ();
+    vector<int> mapping;
+    readStringTable (data, endOfData, *strings, mapping);
+
+    int manifestEntries;
+
+    if (endOfData < data + 4)
+    {
+        throw IEX_NAMESPACE::InputExc ("IDManifest too small");
+    }
+
+    Xdr::read<CharPtrIO> (data, manifestEntries);
+
+    if (manifestEntries < 0)
+    {
+        throw IEX_NAMESPACE::InputExc ("Bad IDManifest size");
+    }
+
+    _groups.resize (manifestEntries);
+
+    for (Group& group: _groups)
+    {
+        readStringList (data, endOfData, group._channels);
+        readStringList (data, endOfData, group._components);
+
+        char lifetime;
+        if (endOfData < data + 4)
+        {
+            throw IEX_NAMESPACE::InputExc ("IDManifest too small");
+        }
+        Xdr::read<CharPtrIO> (data, lifetime);
+
+        group._lifeTime = IDManifest::IdLifetime (lifetime);
+        readPascalString (data, endOfData, group._hashScheme);
+        readPascalString (data, endOfData, group._encodingScheme);
+
+        if (endOfData < data + 5)
+        {
+            throw IEX_NAMESPACE::InputExc ("IDManifest too small");
+        }
+        char storageScheme;
+        Xdr::read<CharPtrIO> (data, storageScheme);
+
+        int tableSize;
+        Xdr::read<CharPtrIO> (data, tableSize);
+
+        //
+        // each entry takes at least one byte, which bounds
+        // the memory reserved for a corrupt table size
+        //
+
+        size_t components = group._components.size ();
+
+        if (tableSize < 0 || tableSize > endOfData - data)
+        {
+            throw IEX_NAMESPACE::InputExc ("Bad IDManifest table size");
+        }
+
+        group._ids.resize (tableSize);
+        group._text.resize (size_t (tableSize) * components);
+
+        uint64_t previousId = 0;
+
+        for (int entry = 0; entry < tableSize; ++entry)
+        {
+            uint64_t id = readId (data, endOfData, storageScheme);
+
+            id += previousId;
+            previousId         = id;
+            group._ids[entry] = id;
+
+            for (size_t i = 0; i < components; ++i)
+            {
+                int stringIndex = readVariableLengthInteger (data, endOfData);
+                if (size_t (stringIndex) >= strings->size () ||
+                    stringIndex < 0)
+                {
+                    throw IEX_NAMESPACE::InputExc (
+                        "Bad string index in IDManifest");
+                }
+                group._text[entry * components + i] = mapping[stringIndex];
+            }
+        }
+    }
+
+    _strings = strings;
+    index ();
+}
+
+void
+FlatIDManifest::index ()
+{
+    for (size_t g = 0; g < _groups.size (); ++g)
+    {
+        _groups[g]._strings = _strings;
+
+        for (const string& channel: _groups[g]._channels)
+            _channelGroups.insert (make_pair (channel, g));
+    }
+
+    //
+    // channel groups are independent of each other, so they are
+    // indexed in parallel
+    //
+
+    if (_groups.size () < 2 || globalThreadCount () < 2)
+    {
+        for (Group& group: _groups)
+            group.index ();
+
+        return;
+    }
+
+    std::mutex         errorMutex;
+    std::exception_ptr error;
+
+    {
+        ILMTHREAD_NAMESPACE::TaskGroup taskGroup;
+
+        for (Group& group: _groups)
+        {
+            ILMTHREAD_NAMESPACE::ThreadPool::addGlobalTask (new IndexGroupTask (
+                &taskGroup,
+                [&group] () { group.index (); },
+                errorMutex,
+                error));
+        }
+    }
+
+    if (error) std::rethrow_exception (error);
+}
+
+size_t
+FlatIDManifest::size () const
+{
+    return _groups.size ();
+}
+
+size_t
+FlatIDManifest::find (const string& channel) const
+{
+    auto i = _channelGroups.find (channel);
+    return i == _channelGroups.end () ? _groups.size () : i->second;
+}
+
+const FlatIDManifest::Group&
+FlatIDManifest::operator[] (size_t index) const
+{
+    return _groups[index];
+}
+
+size_t
+FlatIDManifest::numStrings () const
+{
+    return _strings->size ();
+}
+
+const string&
+FlatIDManifest::pooledString (size_t index) const
+{
+    return (*_strings)[index];
+}
+
+FlatIDManifest::Group::Group ()
+    : _lifeTime (IDManifest::LIFETIME_STABLE), _hashShift (64)
+{}
+
+void
+FlatIDManifest::Group::index ()
+{
+    size_t components = _components.size ();
+
+    //
+    // serialized manifests store their entries in ascending order
+    // of ID numbers; sort them if they are not
+    //
+
+    if (!std::is_sorted (_ids.begin (), _ids.end ()))
+    {
+        vector<size_t> order (_ids.size ());
+        std::iota (order.begin (), order.end (), size_t (0));
+        std::sort (order.begin (), order.end (), [this] (size_t a, size_t b) {
+            return _ids[a] < _ids[b];
+        });
+
+        vector<uint64_t> ids (_ids.size ());
+        vector<uint32_t> text (_text.size ());
+
+        for (size_t i = 0; i < order.size (); ++i)
+        {
+            ids[i] = _ids[order[i]];
+            for (size_t c = 0; c < components; ++c)
+                text[i * components + c] = _text[order[i] * components + c];
+        }
+
+        _ids.swap (ids);
+        _text.swap (text);
+    }
+
+    if (std::adjacent_find (_ids.begin (), _ids.end ()) != _ids.end ())
+    {
+        throw IEX_NAMESPACE::InputExc (
+            "ID manifest contains multiple entries for the same ID");
+    }
+
+    if (_ids.size () >= 0x7fffffff)
+    {
+        throw IEX_NAMESPACE::ArgExc ("ID manifest channel group too large");
+    }
+
+    //
+    // open addressing with linear probing; the table is kept
+    // at most half full
+    //
+
+    int bits = 1;
+    while ((size_t (1) << bits) < 2 * _ids.size ())
+        ++bits;
+
+    _hashShift = 64 - bits;
+    _hash.assign (size_t (1) << bits, 0);
+
+    size_t mask = _hash.size () - 1;
+
+    for (size_t i = 0; i < _ids.size (); ++i)
+    {
+        size_t slot = hashSlot (_ids[i], _hashShift);
+
+        while (_hash[slot] != 0)
+            slot = (slot + 1) & mask;
+
+        _hash[slot] = uint32_t (i + 1);
+    }
+}
+
+FlatIDManifest::Group::ConstIterator
+FlatIDManifest::Group::begin () const
+{
+    return ConstIterator (this, 0);
+}
+
+FlatIDManifest::Group::ConstIterator
+FlatIDManifest::Group::end () const
+{
+    return ConstIterator (this, _ids.size ());
+}
+
+FlatIDManifest::Group::ConstIterator
+FlatIDManifest::Group::find (uint64_t idValue) const
+{
+    if (_hash.empty ()) return end ();
+
+    size_t mask = _hash.size () - 1;
+    size_t slot = hashSlot (idValue, _hashShift);
+
+    while (_hash[slot] != 0)
+    {
+        size_t i = _hash[slot] - 1;
+        if (_ids[i] == idValue) return ConstIterator (this, i);
+        slot = (slot + 1) & mask;
+    }
+
+    return end ();
+}
+
+std::vector<std::string>
+FlatIDManifest::Group::ConstIterator::text () const
+{
+    vector<string> text (_group->getComponents ().size ());
+
+    for (size_t c = 0; c < text.size (); ++c)
+        text[c] = _group->text (_i, c);
+
+    return text;
+}
+
+namespace
+{
+
+//
+// a LazyIDManifest records the position of one in this many entries
+//
+const size_t LAZY_INDEX_INTERVAL = 64;
+
+//
+// read the list of all strings used in a serialized manifest, expanding
+// them into a single buffer; string i occupies pool[offsets[i]] up to
+// pool[offsets[i + 1]].  The format is described in readStringTable
+//
+void
+readStringPool (
+    const char*&    data,
+    const char*     endOfData,
+    vector<char>&   pool,
+    vector<size_t>& offsets)
+{
+    if (endOfData < data + 4)
+    {
+        throw IEX_NAMESPACE::InputExc (
+            "IDManifest too small for string list size");
+    }
+
+    int numberOfStrings;
+    Xdr::read<CharPtrIO> (data, numberOfStrings);
+
+    if (numberOfStrings < 0 || numberOfStrings > endOfData - data)
+    {
+        throw IEX_NAMESPACE::InputExc ("Bad IDManifest string list size");
+    }
+
+    vector<size_t> lengths (numberOfStrings);
+    size_t         storedSize = 0;
+
+    //
+    // the strings follow the lengths, so their total cannot exceed what is
+    // left of the input; check before it is used to size the pool
+    //
+    for (int i = 0; i < numberOfStrings; ++i)
+    {
+        uint64_t length = readVariableLengthInteger (data, endOfData);
+        size_t   left   = size_t (endOfData - data);
+
+        if (length > left || storedSize > left - length)
+        {
+            throw IEX_NAMESPACE::InputExc ("IDManifest too small for strings");
+        }
+
+        lengths[i] = size_t (length);
+        storedSize += lengths[i];
+    }
+
+    pool.clear ();
+    pool.reserve (storedSize);
+    offsets.resize (numberOfStrings + 1);
+    offsets[0] = 0;
+
+    for (int i = 0; i < numberOfStrings; ++i)
+    {
+        if (lengths[i] > size_t (endOfData - data))
+        {
+            throw IEX_NAMESPACE::InputExc ("IDManifest too small for string");
+        }
+
+        size_t start       = pool.size ();
+        size_t common      = 0;
+        size_t stringStart = 0;
+
+        if (i > 0)
+        {
+            size_t previous = offsets[i] - offsets[i - 1];
+
+            stringStart = previous > 255 ? 2 : 1;
+            if (lengths[i] < stringStart)
+            {
+                throw IEX_NAMESPACE::InputExc (
+                    "Bad string length in IDmanifest string table");
+            }
+
+            common = (unsigned char) data[0];
+            if (stringStart == 2)
+                common = (common << 8) + (unsigned char) data[1];
+
+            if (common > previous)
+            {
+                throw IEX_NAMESPACE::InputExc (
+                    "Bad common string length in IDmanifest string table");
+            }
+        }
+
+        pool.resize (start + common + lengths[i] - stringStart);
+        if (common)
+            memcpy (pool.data () + start, pool.data () + offsets[i - 1], common);
+        memcpy (
+            pool.data () + start + common,
+            data + stringStart,
+            lengths[i] - stringStart);
+
+        data += lengths[i];
+        offsets[i + 1] = pool.size ();
+    }
+}
+
+} // namespace
+
+struct LazyIDManifest::Storage
+{
+    vector<char>   serial;  // serialized manifest
+    vector<char>   pool;    // expanded text of all strings
+    vector<size_t> offsets; // start of each string in pool
+    vector<int>    mapping; // string table index of each entry index
+};
+
+LazyIDManifest::LazyIDManifest () : _storage (std::make_shared<Storage> ())
+{}
+
+LazyIDManifest::LazyIDManifest (const CompressedIDManifest& compressed)
+    : _storage (std::make_shared<Storage> ())
+{
+    uncompressManifest (compressed, _storage->serial);
+    init ();
+}
+
+LazyIDManifest::LazyIDManifest (const char* data, const char* endOfData)
+    : _storage (std::make_shared<Storage> ())
+{
+    _storage->serial.assign (data, endOfData);
+    init ();
+}
+
+void
+LazyIDManifest::init ()
+{
+    const char* start     = _storage->serial.data ();
+    const char* data      = start;
+    const char* endOfData = start + _storage->serial.size ();
+
+    if (endOfData < data + 4)
+    {
+        throw IEX_NAMESPACE::InputExc ("IDManifest too small");
+    }
+
+    unsigned int version;
+    Xdr::read<CharPtrIO> (data, version);
+    if (version != 0)
+    {
+        throw IEX_NAMESPACE::InputExc ("Unrecognized IDmanifest version");
+    }
+
+    readStringPool (data, endOfData, _storage->pool, _storage->offsets);
+    size_t numStrings = _storage->offsets.size () - 1;
+    readStringMapping (data, endOfData, numStrings, _storage->mapping);
+
+    int manifestEntries;
+
+    if (endOfData < data + 4)
+    {
+        throw IEX_NAMESPACE::InputExc ("IDManifest too small");
+    }
+
+    Xdr::read<CharPtrIO> (data, manifestEntries);
+
+    if (manifestEntries < 0 || manifestEntries > endOfData - data)
+    {
+        throw IEX_NAMESPACE::InputExc ("Bad IDManifest size");
+    }
+
+    _groups.resize (manifestEntries);
+
+    for (size_t g = 0; g < _groups.size (); ++g)
+    {
+        Group& group = _groups[g];
+
+        readStringList (data, endOfData, group._channels);
+        readStringList (data, endOfData, group._components);
+
+        char lifetime;
+        if (endOfData < data + 4)
+        {
+            throw IEX_NAMESPACE::InputExc ("IDManifest too small");
+        }
+        Xdr::read<CharPtrIO> (data, lifetime);
+
+        group._lifeTime = IDManifest::IdLifetime (lifetime);
+        readPascalString (data, endOfData, group._hashScheme);
+        readPascalString (data, endOfData, group._encodingScheme);
+
+        if (endOfData < data + 5)
+        {
+            throw IEX_NAMESPACE::InputExc ("IDManifest too small");
+        }
+        Xdr::read<CharPtrIO> (data, group._storageScheme);
+
+        int tableSize;
+        Xdr::read<CharPtrIO> (data, tableSize);
+
+        if (tableSize < 0 || tableSize > endOfData - data)
+        {
+            throw IEX_NAMESPACE::InputExc ("Bad IDManifest table size");
+        }
+
+        group._size = tableSize;
+        group._index.reserve (
+            (group._size + LAZY_INDEX_INTERVAL - 1) / LAZY_INDEX_INTERVAL);
+
+        //
+        // the entries have to be stepped over to reach the next group;
+        // on the way, record the index points and validate the string
+        // indices, so that lookups cannot fail later
+        //
+
+        size_t   components = group._components.size ();
+        uint64_t previousId = 0;
+
+        for (size_t entry = 0; entry < group._size; ++entry)
+        {
+            uint64_t id = readId (data, endOfData, group._storageScheme);
+
+            id += previousId;
+
+            if (entry > 0 && id <= previousId)
+            {
+                if (id == previousId)
+                {
+                    throw IEX_NAMESPACE::InputExc (
+                        "ID manifest contains multiple entries for the same ID");
+                }
+                group._sorted = false;
+            }
+
+            previousId = id;
+
+            if (entry % LAZY_INDEX_INTERVAL == 0)
+                group._index.push_back ({id, size_t (data - start)});
+
+            for (size_t i = 0; i < components; ++i)
+            {
+                uint64_t stringIndex =
+                    readVariableLengthInteger (data, endOfData);
+                if (stringIndex >= numStrings)
+                {
+                    throw IEX_NAMESPACE::InputExc (
+                        "Bad string index in IDManifest");
+                }
+            }
+        }
+
+        group._end     = size_t (data - start);
+        group._storage = _storage;
+
+        for (const string& channel: group._channels)
+            _channelGroups.insert (make_pair (channel, g));
+    }
+}
+
+size_t
+LazyIDManifest::size () const
+{
+    return _groups.size ();
+}
+
+size_t
+LazyIDManifest::find (const string& channel) const
+{
+    auto i = _channelGroups.find (channel);
+    return i == _channelGroups.end () ? _groups.size () : i->second;
+}
+
+const LazyIDManifest::Group&
+LazyIDManifest::operator[] (size_t index) const
+{
+    return _groups[index];
+}
+
+size_t
+LazyIDManifest::numStrings () const
+{
+    return _storage->offsets.empty () ? 0 : _storage->offsets.size () - 1;
+}
+
+LazyIDManifest::Group::Group ()
+    : _lifeTime (IDManifest::LIFETIME_STABLE)
+    , _storageScheme (0)
+    , _size (0)
+    , _end (0)
+    , _sorted (true)
+{}
+
+//
+// return the position of the components of the entry for idValue,
+// or null if there is no such entry
+//
+const char*
+LazyIDManifest::Group::seek (uint64_t idValue) const
+{
+    if (_index.empty ()) return nullptr;
+
+    size_t first = 0;
+    size_t count = _size;
+
+    if (_sorted)
+    {
+        //
+        // find the last index point at or before idValue, and only
+        // decode the entries up to the next one
+        //
+
+        auto point = std::upper_bound (
+            _index.begin (),
+            _index.end (),
+            idValue,
+            [] (uint64_t id, const IndexPoint& p) { return id < p.id; });
+
+        if (point == _index.begin ()) return nullptr;
+
+        first = size_t (point - _index.begin ()) - 1;
+        count = std::min (
+            LAZY_INDEX_INTERVAL, _size - first * LAZY_INDEX_INTERVAL);
+    }
+
+    const char* start      = _storage->serial.data ();
+    const char* data       = start + _index[first].offset;
+    const char* endOfData  = start + _end;
+    uint64_t    id         = _index[first].id;
+    size_t      components = _components.size ();
+
+    for (size_t entry = 0;;)
+    {
+        if (id == idValue) return data;
+        if (_sorted && id > idValue) return nullptr;
+        if (++entry == count) return nullptr;
+
+        for (size_t i = 0; i < components; ++i)
+            readVariableLengthInteger (data, endOfData);
+
+        id += readId (data, endOfData, _storageScheme);
+    }
+}
+
+bool
+LazyIDManifest::Group::contains (uint64_t idValue) const
+{
+    return seek (idValue) != nullptr;
+}
+
+bool
+LazyIDManifest::Group::lookup (
+    uint64_t idValue, std::vector<std::string>& text) const
+{
+    const char* data = seek (idValue);
+    if (!data) return false;
+
+    const char* endOfData = _storage->serial.data () + _end;
+
+    text.resize (_components.size ());
+
+    for (size_t i = 0; i < text.size (); ++i)
+    {
+        uint64_t index = readVariableLengthInteger (data, endOfData);
+        size_t   s     = _storage->mapping[index];
+        text[i].assign (
+            _storage->pool.data () + _storage->offsets[s],
+            _storage->offsets[s + 1] - _storage->offsets[s]);
+    }
+
+    return true;
+}
+
+namespace
+{
+
 //-----------------------------------------------------------------------------
 // MurmurHash3 was written by Austin Appleby, and is placed in the public
 // domain. The author hereby disclaims copyright to this source code.
@@ -13,8 +13,10 @@
 
 #include <cstdint>
 #include <map>
+#include <memory>
 #include <set>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 OPENEXR_IMF_INTERNAL_NAMESPACE_HEADER_ENTER
@@ -319,6 +321,296 @@ public:
     unsigned char* _data;
 };
 
+//
+// Read-only form of an IDManifest, for fast lookups in large manifests.
+// The text of all entries is stored once, in a pool of distinct strings
+// shared by all channel groups.  Each channel group stores its ID numbers
+// in a sorted array, with an open-addressing hash table to find them,
+// and for each entry the indices of its components in the string pool.
+// Channel names are hashed to find the channel group that defines them.
+//
+// A FlatIDManifest can be built from an IDManifest, or directly from the
+// serialized or compressed representation without building an IDManifest
+// first.  Channel groups are indexed in parallel, using the global thread
+// pool.
+//
+class IMF_EXPORT_TYPE FlatIDManifest
+{
+public:
+    class Group;
+
+    IMF_EXPORT
+    FlatIDManifest ();
+
+    IMF_EXPORT
+    explicit FlatIDManifest (const IDManifest& manifest);
+
+    IMF_EXPORT
+    explicit FlatIDManifest (const CompressedIDManifest& compressed);
+
+    //
+    // construct from serialized representation stored at 'data'
+    //
+    IMF_EXPORT
+    FlatIDManifest (const char* data, const char* end);
+
+    // return number of channel groups in manifest
+    IMF_EXPORT
+    size_t size () const;
+
+    // find the first channel group that defines the given channel
+    // if channel not found, returns a value equal to size()
+    IMF_EXPORT
+    size_t find (const std::string& channel) const;
+
+    IMF_EXPORT
+    const Group& operator[] (size_t index) const;
+
+    // number of distinct strings in the manifest, and access to them
+    IMF_EXPORT
+    size_t numStrings () const;
+    IMF_EXPORT
+    const std::string& pooledString (size_t index) const;
+
+private:
+    IMF_HIDDEN void init (const char* data, const char* end);
+    IMF_HIDDEN void index ();
+
+    std::shared_ptr<const std::vector<std::string>> _strings;
+    std::vector<Group>                              _groups;
+    std::unordered_map<std::string, size_t>         _channelGroups;
+};
+
+class IMF_EXPORT_TYPE FlatIDManifest::Group
+{
+public:
+    class ConstIterator;
+
+    IMF_EXPORT
+    Group ();
+
+    const std::set<std::string>& getChannels () const { return _channels; }
+
+    const std::vector<std::string>& getComponents () const
+    {
+        return _components;
+    }
+
+    IDManifest::IdLifetime getLifetime () const { return _lifeTime; }
+
+    const std::string& getHashScheme () const { return _hashScheme; }
+
+    const std::string& getEncodingScheme () const
+    {
+        return _encodingScheme;
+    }
+
+    // return number of entries in channel group - could be 0
+    size_t size () const { return _ids.size (); }
+
+    //
+    // entries are visited in ascending order of their ID numbers;
+    // find() returns end() if there is no entry for idValue
+    //
+    IMF_EXPORT
+    ConstIterator begin () const;
+    IMF_EXPORT
+    ConstIterator end () const;
+    IMF_EXPORT
+    ConstIterator find (uint64_t idValue) const;
+
+    //
+    // direct access to the ID number and to component c of the
+    // i-th entry, in ascending order of ID numbers
+    //
+    uint64_t id (size_t i) const { return _ids[i]; }
+
+    const std::string& text (size_t i, size_t c) const
+    {
+        return (*_strings)[_text[i * _components.size () + c]];
+    }
+
+private:
+    friend class FlatIDManifest;
+
+    IMF_HIDDEN void index ();
+
+    std::set<std::string>    _channels;
+    std::vector<std::string> _components;
+    IDManifest::IdLifetime   _lifeTime;
+    std::string              _hashScheme;
+    std::string              _encodingScheme;
+
+    std::vector<uint64_t> _ids;  // sorted ID numbers
+    std::vector<uint32_t> _text; // string pool indices of each entry's
+                                 // components
+    std::vector<uint32_t> _hash; // hash table of entry indices + 1,
+                                 // 0 marks an empty slot
+    int _hashShift;              // 64 - log2 (_hash.size ())
+
+    std::shared_ptr<const std::vector<std::string>> _strings;
+};
+
+//
+// Lazily decoded form of a compressed IDManifest, for looking up a few
+// entries of a large manifest without decoding all of it.  The manifest
+// is inflated once, after which only the string table and the header of
+// each channel group are decoded: the distinct strings are expanded into
+// a single character buffer, and the position of every 64th entry of
+// each channel group is recorded in a sparse index.  A lookup decodes at
+// most the entries between two index points, and copies out only the
+// text of the entry that was asked for.
+//
+// A LazyIDManifest is not modified after construction, so it may be
+// queried from several threads at once.
+//
+class IMF_EXPORT_TYPE LazyIDManifest
+{
+public:
+    class Group;
+
+    IMF_EXPORT
+    LazyIDManifest ();
+
+    IMF_EXPORT
+    explicit LazyIDManifest (const CompressedIDManifest& compressed);
+
+    //
+    // construct from serialized representation stored at 'data',
+    // which is copied
+    //
+    IMF_EXPORT
+    LazyIDManifest (const char* data, const char* end);
+
+    // return number of channel groups in manifest
+    IMF_EXPORT
+    size_t size () const;
+
+    // find the first channel group that defines the given channel
+    // if channel not found, returns a value equal to size()
+    IMF_EXPORT
+    size_t find (const std::string& channel) const;
+
+    IMF_EXPORT
+    const Group& operator[] (size_t index) const;
+
+    // number of distinct strings in the manifest
+    IMF_EXPORT
+    size_t numStrings () const;
+
+private:
+    struct Storage;
+
+    IMF_HIDDEN void init ();
+
+    std::shared_ptr<Storage>                _storage;
+    std::vector<Group>                      _groups;
+    std::unordered_map<std::string, size_t> _channelGroups;
+};
+
+class IMF_EXPORT_TYPE LazyIDManifest::Group
+{
+public:
+    IMF_EXPORT
+    Group ();
+
+    const std::set<std::string>& getChannels () const { return _channels; }
+
+    const std::vector<std::string>& getComponents () const
+    {
+        return _components;
+    }
+
+    IDManifest::IdLifetime getLifetime () const { return _lifeTime; }
+
+    const std::string& getHashScheme () const { return _hashScheme; }
+
+    const std::string& getEncodingScheme () const
+    {
+        return _encodingScheme;
+    }
+
+    // return number of entries in channel group - could be 0
+    size_t size () const { return _size; }
+
+    IMF_EXPORT
+    bool contains (uint64_t idValue) const;
+
+    //
+    // set 'text' to the components of the entry for idValue;
+    // returns false, leaving 'text' unchanged, if there is no such entry
+    //
+    IMF_EXPORT
+    bool lookup (uint64_t idValue, std::vector<std::string>& text) const;
+
+private:
+    friend class LazyIDManifest;
+
+    struct IndexPoint
+    {
+        uint64_t id;     // ID number of the entry
+        size_t   offset; // position of the entry's components
+    };
+
+    IMF_HIDDEN const char* seek (uint64_t idValue) const;
+
+    std::set<std::string>    _channels;
+    std::vector<std::string> _components;
+    IDManifest::IdLifetime   _lifeTime;
+    std::string              _hashScheme;
+    std::string              _encodingScheme;
+
+    char                    _storageScheme;
+    size_t                  _size;
+    size_t                  _end;    // end of the entries in the manifest
+    bool                    _sorted; // entries in ascending order of ID
+    std::vector<IndexPoint> _index;
+
+    std::shared_ptr<const Storage> _storage;
+};
+
+//
+// Read-only Iterator object to access individual entries within a
+// FlatIDManifest channel group
+//
+
+class FlatIDManifest::Group::ConstIterator
+{
+public:
+    ConstIterator () : _group (nullptr), _i (0) {}
+
+    ConstIterator (const Group* group, size_t i) : _group (group), _i (i) {}
+
+    ConstIterator& operator++ ()
+    {
+        ++_i;
+        return *this;
+    }
+
+    uint64_t id () const { return _group->id (_i); }
+
+    // component c of the entry
+    const std::string& text (size_t c) const { return _group->text (_i, c); }
+
+    // all components of the entry
+    IMF_EXPORT
+    std::vector<std::string> text () const;
+
+    bool operator== (const ConstIterator& other) const
+    {
+        return _group == other._group && _i == other._i;
+    }
+
+    bool operator!= (const ConstIterator& other) const
+    {
+        return !(*this == other);
+    }
+
+private:
+    const Group* _group;
+    size_t       _i;
+};
+
 //
 // Read/Write Iterator object to access individual entries within a manifest
 //
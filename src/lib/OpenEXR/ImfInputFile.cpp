@@ -19,6 +19,8 @@
 #include "ImfMisc.h"
 #include "ImfMultiPartInputFile.h"
 #include "ImfPartType.h"
+#include "ImfReadPlan.h"
+#include "ImfReadPlanData.h"
 #include "ImfScanLineInputFile.h"
 #include "ImfStdIO.h"
 #include "ImfTiledInputFile.h"
@@ -184,6 +186,28 @@ InputFile::setFrameBuffer (const FrameBuffer& frameBuffer)
     _data->setFrameBuffer (frameBuffer);
 }
 
+void
+InputFile::setReadPlan (const ReadPlan& plan)
+{
+    if (_data->_sFile)
+    {
+#if ILMTHREAD_THREADING_ENABLED
+        std::lock_guard<std::mutex> lk (_data->_mx);
+#endif
+        _data->_sFile->setReadPlan (plan);
+        _data->_cacheFrameBuffer = plan.frameBuffer ();
+        return;
+    }
+
+    if (!plan._data->matches (_ctxt, _data->getPartIdx ()))
+        THROW (
+            IEX_NAMESPACE::ArgExc,
+            "Read plan does not match the layout of input file \""
+                << fileName () << "\".");
+
+    _data->setFrameBuffer (plan.frameBuffer ());
+}
+
 const FrameBuffer&
 InputFile::frameBuffer () const
 {
@@ -134,6 +134,19 @@ public:
     IMF_EXPORT
     void setFrameBuffer (const FrameBuffer& frameBuffer);
 
+    //-----------------------------------------------------------------
+    // Set the current frame buffer from a ReadPlan (see ImfReadPlan.h)
+    //
+    // Equivalent to setFrameBuffer (plan.frameBuffer ()), except that
+    // for scan line files the decoders set up for reading are shared
+    // with other files read using the same plan.  Tiled and deep
+    // files are read through the plan's frame buffer as usual.
+    // Throws an ArgExc if the file's layout does not match the plan.
+    //-----------------------------------------------------------------
+
+    IMF_EXPORT
+    void setReadPlan (const ReadPlan& plan);
+
     //-----------------------------------
     // Access to the current frame buffer
     //-----------------------------------
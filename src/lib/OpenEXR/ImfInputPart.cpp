@@ -40,6 +40,12 @@ InputPart::setFrameBuffer (const FrameBuffer& frameBuffer)
     file->setFrameBuffer (frameBuffer);
 }
 
+void
+InputPart::setReadPlan (const ReadPlan& plan)
+{
+    file->setReadPlan (plan);
+}
+
 const FrameBuffer&
 InputPart::frameBuffer () const
 {
@@ -31,6 +31,8 @@ public:
     IMF_EXPORT
     void setFrameBuffer (const FrameBuffer& frameBuffer);
     IMF_EXPORT
+    void setReadPlan (const ReadPlan& plan);
+    IMF_EXPORT
     const FrameBuffer& frameBuffer () const;
     IMF_EXPORT
     bool isComplete () const;
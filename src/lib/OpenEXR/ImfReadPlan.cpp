@@ -0,0 +1,310 @@
+//
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) Contributors to the OpenEXR Project.
+//
+
+//-----------------------------------------------------------------------------
+//
+//	class ReadPlan
+//
+//-----------------------------------------------------------------------------
+
+#include "ImfReadPlan.h"
+#include "ImfReadPlanData.h"
+
+#include "ImfChannelList.h"
+#include "ImfPartType.h"
+#include "ImfTileDescription.h"
+
+#include "Iex.h"
+
+#include <string.h>
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_SOURCE_ENTER
+
+namespace {
+
+//
+// exr_decode_pipeline_t keeps the channel info for small channel
+// counts inside the structure itself, so it can not just be copied
+//
+
+void
+moveDecoder (exr_decode_pipeline_t& dst, exr_decode_pipeline_t& src)
+{
+    exr_decode_pipeline_t nil = {};
+
+    dst = src;
+    if (src.channels == src._quick_chan_store)
+        dst.channels = dst._quick_chan_store;
+    src = nil;
+}
+
+} // namespace
+
+ReadPlanData::Layout::Layout (const Header& hdr)
+{
+    const IMATH_NAMESPACE::Box2i& dw = hdr.dataWindow ();
+
+    dataWindow.min.x = dw.min.x;
+    dataWindow.min.y = dw.min.y;
+    dataWindow.max.x = dw.max.x;
+    dataWindow.max.y = dw.max.y;
+    compression      = (exr_compression_t) hdr.compression ();
+
+    if (hdr.hasType ())
+    {
+        const std::string& t = hdr.type ();
+        if (t == DEEPSCANLINE)
+            storage = EXR_STORAGE_DEEP_SCANLINE;
+        else if (t == DEEPTILE)
+            storage = EXR_STORAGE_DEEP_TILED;
+        else if (t == TILEDIMAGE)
+            storage = EXR_STORAGE_TILED;
+        else
+            storage = EXR_STORAGE_SCANLINE;
+    }
+    else
+    {
+        storage = hdr.hasTileDescription () ? EXR_STORAGE_TILED
+                                            : EXR_STORAGE_SCANLINE;
+    }
+
+    if (storage == EXR_STORAGE_TILED || storage == EXR_STORAGE_DEEP_TILED)
+    {
+        const TileDescription& td = hdr.tileDescription ();
+
+        tile_x_size     = td.xSize;
+        tile_y_size     = td.ySize;
+        tile_level_mode = (exr_tile_level_mode_t) td.mode;
+        tile_round_mode = (exr_tile_round_mode_t) td.roundingMode;
+    }
+
+    for (ChannelList::ConstIterator i = hdr.channels ().begin ();
+         i != hdr.channels ().end ();
+         ++i)
+    {
+        channels.push_back (Chan{
+            i.name (),
+            (int) i.channel ().type,
+            i.channel ().xSampling,
+            i.channel ().ySampling});
+    }
+}
+
+ReadPlanData::Layout::Layout (const Context& ctxt, int partNumber)
+{
+    storage    = ctxt.storage (partNumber);
+    dataWindow = ctxt.dataWindow (partNumber);
+
+    if (EXR_ERR_SUCCESS != exr_get_compression (ctxt, partNumber, &compression))
+        throw IEX_NAMESPACE::ArgExc ("Unable to query compression type");
+
+    if (storage == EXR_STORAGE_TILED || storage == EXR_STORAGE_DEEP_TILED)
+    {
+        if (EXR_ERR_SUCCESS != exr_get_tile_descriptor (
+                ctxt,
+                partNumber,
+                &tile_x_size,
+                &tile_y_size,
+                &tile_level_mode,
+                &tile_round_mode))
+            throw IEX_NAMESPACE::ArgExc ("Unable to query tile descriptor");
+    }
+
+    const exr_attr_chlist_t* cl = ctxt.channels (partNumber);
+    channels.reserve (static_cast<size_t> (cl->num_channels));
+    for (int c = 0; c < cl->num_channels; ++c)
+    {
+        const exr_attr_chlist_entry_t& e = cl->entries[c];
+        channels.push_back (Chan{
+            std::string (e.name.str, static_cast<size_t> (e.name.length)),
+            (int) e.pixel_type,
+            e.x_sampling,
+            e.y_sampling});
+    }
+}
+
+bool
+ReadPlanData::Layout::operator== (const Layout& other) const
+{
+    if (storage != other.storage || compression != other.compression ||
+        memcmp (&dataWindow, &other.dataWindow, sizeof (dataWindow)) ||
+        tile_x_size != other.tile_x_size ||
+        tile_y_size != other.tile_y_size ||
+        tile_level_mode != other.tile_level_mode ||
+        tile_round_mode != other.tile_round_mode ||
+        channels.size () != other.channels.size ())
+        return false;
+
+    for (size_t c = 0; c < channels.size (); ++c)
+    {
+        const Chan& a = channels[c];
+        const Chan& b = other.channels[c];
+
+        if (a.type != b.type || a.xSampling != b.xSampling ||
+            a.ySampling != b.ySampling || a.name != b.name)
+            return false;
+    }
+    return true;
+}
+
+////////////////////////////////////////
+
+ReadPlanData::ReadPlanData (const Header& hdr, const FrameBuffer& fb)
+    : header (hdr), frameBuffer (fb), layout (hdr)
+{
+    for (FrameBuffer::ConstIterator j = frameBuffer.begin ();
+         j != frameBuffer.end ();
+         ++j)
+    {
+        const Channel* c = header.channels ().findChannel (j.name ());
+
+        if (!c)
+        {
+            fill_list.push_back (j.slice ());
+            continue;
+        }
+
+        if (c->xSampling != j.slice ().xSampling ||
+            c->ySampling != j.slice ().ySampling)
+            THROW (
+                IEX_NAMESPACE::ArgExc,
+                "X and/or y subsampling factors "
+                "of \""
+                    << j.name ()
+                    << "\" channel "
+                       "are not compatible with the frame buffer's "
+                       "subsampling factors.");
+    }
+}
+
+ReadPlanData::~ReadPlanData ()
+{
+    releaseDecoders ();
+}
+
+bool
+ReadPlanData::matches (const Header& hdr) const
+{
+    return layout == Layout (hdr);
+}
+
+bool
+ReadPlanData::matches (const Context& ctxt, int partNumber) const
+{
+    return layout == Layout (ctxt, partNumber);
+}
+
+bool
+ReadPlanData::takeDecoder (
+    const Context&          ctxt,
+    int                     partNumber,
+    const exr_chunk_info_t& cinfo,
+    exr_decode_pipeline_t&  decoder,
+    int                     node)
+{
+    std::unique_ptr<ParkedDecoder> pd;
+
+    {
+#if ILMTHREAD_THREADING_ENABLED
+        std::lock_guard<std::mutex> lk (_mx);
+#endif
+        for (size_t i = _parked.size (); i-- > 0 && !pd;)
+        {
+            if (_parked[i]->node != node) continue;
+
+            pd = std::move (_parked[i]);
+            _parked.erase (_parked.begin () + i);
+        }
+        if (!pd) return false;
+    }
+
+    if (EXR_ERR_SUCCESS !=
+        exr_decoding_rebind (ctxt, partNumber, &cinfo, &pd->decoder))
+    {
+        exr_decoding_destroy (pd->ctxt, &pd->decoder);
+        return false;
+    }
+
+    moveDecoder (decoder, pd->decoder);
+    return true;
+}
+
+void
+ReadPlanData::parkDecoder (
+    const Context& ctxt, exr_decode_pipeline_t& decoder, int node)
+{
+    // only decoders which made it through routine selection are
+    // worth keeping
+    if (!decoder.read_fn)
+    {
+        exr_decoding_destroy (ctxt, &decoder);
+        return;
+    }
+
+    std::unique_ptr<ParkedDecoder> pd (new ParkedDecoder);
+    pd->ctxt = ctxt;
+    pd->node = node;
+    moveDecoder (pd->decoder, decoder);
+
+#if ILMTHREAD_THREADING_ENABLED
+    std::lock_guard<std::mutex> lk (_mx);
+#endif
+    _parked.push_back (std::move (pd));
+}
+
+void
+ReadPlanData::releaseDecoders ()
+{
+    std::vector<std::unique_ptr<ParkedDecoder>> parked;
+
+    {
+#if ILMTHREAD_THREADING_ENABLED
+        std::lock_guard<std::mutex> lk (_mx);
+#endif
+        parked.swap (_parked);
+    }
+
+    for (auto& pd: parked)
+        exr_decoding_destroy (pd->ctxt, &pd->decoder);
+}
+
+////////////////////////////////////////
+
+ReadPlan::ReadPlan (const Header& header, const FrameBuffer& frameBuffer)
+    : _data (std::make_shared<ReadPlanData> (header, frameBuffer))
+{}
+
+ReadPlan::ReadPlan (const ReadPlan& other) = default;
+
+ReadPlan&
+ReadPlan::operator= (const ReadPlan& other) = default;
+
+ReadPlan::~ReadPlan () = default;
+
+const Header&
+ReadPlan::header () const
+{
+    return _data->header;
+}
+
+const FrameBuffer&
+ReadPlan::frameBuffer () const
+{
+    return _data->frameBuffer;
+}
+
+bool
+ReadPlan::matches (const Header& header) const
+{
+    return _data->matches (header);
+}
+
+void
+ReadPlan::releaseDecoders ()
+{
+    _data->releaseDecoders ();
+}
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_SOURCE_EXIT
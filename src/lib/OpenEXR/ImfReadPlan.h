@@ -0,0 +1,115 @@
+//
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) Contributors to the OpenEXR Project.
+//
+
+#ifndef INCLUDED_IMF_READ_PLAN_H
+#define INCLUDED_IMF_READ_PLAN_H
+
+//-----------------------------------------------------------------------------
+//
+//	class ReadPlan
+//
+//	A ReadPlan captures the work done when a frame buffer is attached
+//	to an input file -- validating the slices against the file's
+//	channels, working out which slices must be filled, and choosing
+//	the decode routines and sizing the intermediate buffers for each
+//	chunk -- such that it can be carried over to other files with the
+//	same layout.
+//
+//	This is intended for reading image sequences, where every frame
+//	has the same header layout and is read into the same frame
+//	buffer:
+//
+//	    ReadPlan plan (firstFile.header (), frameBuffer);
+//
+//	    for (each frame)
+//	    {
+//	        InputFile in (frameName);
+//	        in.setReadPlan (plan);
+//	        in.readPixels (dw.min.y, dw.max.y);
+//	    }
+//
+//	The decoders used while reading a frame are handed back to the
+//	plan when the file is closed, and picked up again by the next
+//	file, skipping their setup entirely.
+//
+//-----------------------------------------------------------------------------
+
+#include "ImfForward.h"
+
+#include "ImfFrameBuffer.h"
+#include "ImfHeader.h"
+
+#include <memory>
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_HEADER_ENTER
+
+class IMF_EXPORT_TYPE ReadPlan
+{
+public:
+    //-----------------------------------------------------------------
+    // Constructor -- compiles a plan for reading files with the given
+    // header into the given frame buffer.  The frame buffer is copied
+    // into the plan.
+    //
+    // Throws an ArgExc if the sampling of a slice does not match the
+    // corresponding channel in the header.
+    //-----------------------------------------------------------------
+
+    IMF_EXPORT
+    ReadPlan (const Header& header, const FrameBuffer& frameBuffer);
+
+    //-----------------------------------------------------------------
+    // ReadPlan objects are handles; copies share the same underlying
+    // plan, and may be used concurrently from multiple threads.
+    //-----------------------------------------------------------------
+
+    IMF_EXPORT ReadPlan (const ReadPlan& other);
+    IMF_EXPORT ReadPlan& operator= (const ReadPlan& other);
+    IMF_EXPORT ~ReadPlan ();
+
+    //---------------------------------------------
+    // Access to the header and frame buffer the
+    // plan was compiled for
+    //---------------------------------------------
+
+    IMF_EXPORT
+    const Header& header () const;
+
+    IMF_EXPORT
+    const FrameBuffer& frameBuffer () const;
+
+    //-----------------------------------------------------------------
+    // Check if a header has the same layout as the one the plan was
+    // compiled for: the same part type, data window, compression,
+    // tile description and channels (names, types and sampling).
+    // Only files whose headers match can be read with the plan.
+    //-----------------------------------------------------------------
+
+    IMF_EXPORT
+    bool matches (const Header& header) const;
+
+    //-----------------------------------------------------------------
+    // Release the decoders the plan is holding on to.
+    //
+    // A decoder handed back to the plan keeps the file it was last
+    // used for open until it is picked up by another file, or until
+    // the plan is destroyed.  Call releaseDecoders() when pausing
+    // playback to close that file early.
+    //-----------------------------------------------------------------
+
+    IMF_EXPORT
+    void releaseDecoders ();
+
+private:
+    std::shared_ptr<ReadPlanData> _data;
+
+    friend class InputFile;
+    friend class ScanLineInputFile;
+    friend class TiledInputFile;
+};
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_HEADER_EXIT
+
+#endif
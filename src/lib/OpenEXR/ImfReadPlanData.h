@@ -0,0 +1,103 @@
+//
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) Contributors to the OpenEXR Project.
+//
+
+#ifndef IMFREADPLANDATA_H_
+#define IMFREADPLANDATA_H_
+
+#include "ImfForward.h"
+
+#include "ImfContext.h"
+#include "ImfFrameBuffer.h"
+#include "ImfHeader.h"
+
+#include "IlmThreadConfig.h"
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_HEADER_ENTER
+
+struct ReadPlanData
+{
+    ReadPlanData (const Header& hdr, const FrameBuffer& fb);
+    ~ReadPlanData ();
+
+    ReadPlanData (const ReadPlanData&)            = delete;
+    ReadPlanData& operator= (const ReadPlanData&) = delete;
+
+    bool matches (const Header& hdr) const;
+    bool matches (const Context& ctxt, int partNumber) const;
+
+    // hands out a decoder parked by a previous file on the given
+    // NUMA node, rebound to the given context and chunk; returns
+    // false if there is none to reuse, in which case the caller sets
+    // up a fresh one
+    bool takeDecoder (
+        const Context&          ctxt,
+        int                     partNumber,
+        const exr_chunk_info_t& cinfo,
+        exr_decode_pipeline_t&  decoder,
+        int                     node);
+
+    // takes ownership of the decoder (and resets it); ctxt must be
+    // the context the decoder is currently bound to, and node the
+    // NUMA node its buffers were first touched on
+    void parkDecoder (
+        const Context& ctxt, exr_decode_pipeline_t& decoder, int node);
+
+    void releaseDecoders ();
+
+    // the parts of a header which determine how its chunks are
+    // decoded into a frame buffer
+    struct Layout
+    {
+        Layout () = default;
+        explicit Layout (const Header& hdr);
+        Layout (const Context& ctxt, int partNumber);
+
+        bool operator== (const Layout& other) const;
+
+        struct Chan
+        {
+            std::string name;
+            int         type;
+            int         xSampling;
+            int         ySampling;
+        };
+
+        exr_storage_t         storage     = EXR_STORAGE_LAST_TYPE;
+        exr_compression_t     compression = EXR_COMPRESSION_LAST_TYPE;
+        exr_attr_box2i_t      dataWindow  = {};
+        uint32_t              tile_x_size = 0;
+        uint32_t              tile_y_size = 0;
+        exr_tile_level_mode_t tile_level_mode = EXR_TILE_LAST_TYPE;
+        exr_tile_round_mode_t tile_round_mode = EXR_TILE_ROUND_LAST_TYPE;
+        std::vector<Chan>     channels;
+    };
+
+    Header             header;
+    FrameBuffer        frameBuffer;
+    std::vector<Slice> fill_list;
+    Layout             layout;
+
+private:
+    struct ParkedDecoder
+    {
+        Context               ctxt;
+        exr_decode_pipeline_t decoder;
+        int                   node;
+    };
+
+#if ILMTHREAD_THREADING_ENABLED
+    std::mutex _mx;
+#endif
+    std::vector<std::unique_ptr<ParkedDecoder>> _parked;
+};
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_HEADER_EXIT
+
+#endif /* IMFREADPLANDATA_H_ */
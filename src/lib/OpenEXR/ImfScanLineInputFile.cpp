@@ -20,7 +20,10 @@
 
 #include "ImfFrameBuffer.h"
 #include "ImfInputPartData.h"
+#include "ImfReadPlan.h"
+#include "ImfReadPlanData.h"
 
+#include <algorithm>
 #include <mutex>
 #include <vector>
 
@@ -33,7 +36,12 @@ struct ScanLineProcess
     ~ScanLineProcess ()
     {
         if (!first)
-            exr_decoding_destroy (decoder.context, &decoder);
+        {
+            if (plan)
+                plan->parkDecoder (planCtxt, decoder, node);
+            else
+                exr_decoding_destroy (decoder.context, &decoder);
+        }
     }
 
     void run_decode (
@@ -67,6 +75,15 @@ struct ScanLineProcess
     exr_chunk_info_t      cinfo;
     exr_decode_pipeline_t decoder;
 
+    // NUMA node of the thread which created this, and so first
+    // touched the decode buffers
+    int node = 0;
+
+    // when reading with a ReadPlan, the decoder is taken from and
+    // handed back to the plan instead of being set up from scratch
+    std::shared_ptr<ReadPlanData> plan;
+    Context                       planCtxt;
+
     std::shared_ptr<ScanLineProcess> next;
 };
 
@@ -99,9 +116,17 @@ struct ScanLineInputFile::Data
     std::vector<char> _pixel_data_scratch;
 
     void readPixels (const FrameBuffer &fb, int scanLine1, int scanLine2);
+    int  readAvailablePixels (
+        const FrameBuffer &fb, int scanLine1, int scanLine2);
 
     FrameBuffer frameBuffer;
     std::vector<Slice> fill_list;
+    std::shared_ptr<ReadPlanData> plan;
+
+    // chunks handed out by readAvailablePixels since the frame
+    // buffer was last set
+    std::vector<uint8_t> chunksAvailable;
+    std::vector<uint8_t> chunksRead;
 
 #if ILMTHREAD_THREADING_ENABLED
     std::mutex _mx;
@@ -110,17 +135,30 @@ struct ScanLineInputFile::Data
     std::vector<std::string> _failures;
 #endif
 
-    std::shared_ptr<ScanLineProcess> processStack;
+    // one stack of decoders per NUMA node, so a thread reuses the
+    // buffers of its own node
+    std::vector<std::shared_ptr<ScanLineProcess>> processStacks;
     std::shared_ptr<ScanLineProcess> getChunkProcess ()
     {
+        int node = ILMTHREAD_NAMESPACE::ThreadPool::currentNumaNode ();
         std::shared_ptr<ScanLineProcess> retval;
 #if ILMTHREAD_THREADING_ENABLED
         std::lock_guard<std::mutex> lk (_mx);
 #endif
-        retval = processStack;
+        if (processStacks.size () <= size_t (node))
+            processStacks.resize (node + 1);
+        retval = processStacks[node];
         if (!retval)
+        {
             retval = std::make_shared<ScanLineProcess> ();
-        processStack = retval->next;
+            retval->node = node;
+            if (plan)
+            {
+                retval->plan     = plan;
+                retval->planCtxt = *_ctxt;
+            }
+        }
+        processStacks[node] = retval->next;
         retval->next.reset();
         return retval;
     }
@@ -129,8 +167,10 @@ struct ScanLineInputFile::Data
 #if ILMTHREAD_THREADING_ENABLED
         std::lock_guard<std::mutex> lk (_mx);
 #endif
-        sp->next = processStack;
-        processStack = std::move (sp);
+        if (processStacks.size () <= size_t (sp->node))
+            processStacks.resize (sp->node + 1);
+        sp->next = processStacks[sp->node];
+        processStacks[sp->node] = std::move (sp);
     }
 
 #if ILMTHREAD_THREADING_ENABLED
@@ -149,10 +189,8 @@ struct ScanLineInputFile::Data
             , _ifd (ifd)
             , _fby (fby)
             , _last_fby (endScan)
-            , _line (ifd->getChunkProcess ())
-        {
-            _line->cinfo = cinfo;
-        }
+            , _cinfo (cinfo)
+        {}
 
         ~LineBufferTask () override
         {
@@ -170,7 +208,9 @@ struct ScanLineInputFile::Data
         Data*              _ifd;
         int                _fby;
         int                _last_fby;
+        exr_chunk_info_t   _cinfo;
 
+        // taken when the task runs, from the worker's NUMA node
         std::shared_ptr<ScanLineProcess> _line;
     };
 #endif
@@ -279,7 +319,30 @@ ScanLineInputFile::setFrameBuffer (const FrameBuffer& frameBuffer)
     }
 
     _data->frameBuffer = frameBuffer;
-    _data->processStack.reset();
+    _data->plan.reset ();
+    _data->processStacks.clear ();
+    _data->chunksRead.clear ();
+}
+
+void
+ScanLineInputFile::setReadPlan (const ReadPlan& plan)
+{
+    if (!plan._data->matches (_ctxt, _data->partNumber))
+        THROW (
+            IEX_NAMESPACE::ArgExc,
+            "Read plan does not match the layout of input file \""
+                << fileName () << "\".");
+
+#if ILMTHREAD_THREADING_ENABLED
+    std::lock_guard<std::mutex> lock (_data->_mx);
+#endif
+    // drop (and so hand back) any decoders from a previous plan
+    // before switching over
+    _data->processStacks.clear ();
+    _data->fill_list   = plan._data->fill_list;
+    _data->frameBuffer = plan._data->frameBuffer;
+    _data->plan        = plan._data;
+    _data->chunksRead.clear ();
 }
 
 const FrameBuffer&
@@ -314,6 +377,14 @@ ScanLineInputFile::readPixels (int scanLine1, int scanLine2)
 
 ////////////////////////////////////////
 
+int
+ScanLineInputFile::readAvailablePixels (int scanLine1, int scanLine2)
+{
+    return _data->readAvailablePixels (frameBuffer (), scanLine1, scanLine2);
+}
+
+////////////////////////////////////////
+
 void
 ScanLineInputFile::readPixels (int scanLine)
 {
@@ -445,16 +516,28 @@ void ScanLineInputFile::Data::readPixels (
 
     if (nchunks > 1 && numThreads > 1)
     {
-        ILMTHREAD_NAMESPACE::TaskGroup tg;
+        // nest under the calling task's group (if any) such that the
+        // chunk tasks inherit its priority and cancellation
+        ILMTHREAD_NAMESPACE::TaskGroup tg (
+            ILMTHREAD_NAMESPACE::TaskGroup::current ());
 
         for (int y = scanLine1; y <= scanLine2; )
         {
+            if (tg.isCancelled ())
+                break;
+
             if (EXR_ERR_SUCCESS != exr_read_scanline_chunk_info (*_ctxt, partNumber, y, &cinfo))
                 throw IEX_NAMESPACE::InputExc ("Unable to query scanline information");
 
             // used for honoring the numThreads
             _sem.wait ();
 
+            if (tg.isCancelled ())
+            {
+                _sem.post ();
+                break;
+            }
+
             ILMTHREAD_NAMESPACE::ThreadPool::addGlobalTask (
                 new LineBufferTask (&tg, this, &fb, cinfo, y, scanLine2) );
 
@@ -465,9 +548,13 @@ void ScanLineInputFile::Data::readPixels (
 #endif
     {
         auto sp = getChunkProcess ();
+        auto parent = ILMTHREAD_NAMESPACE::TaskGroup::current ();
 
         for (int y = scanLine1; y <= scanLine2; )
         {
+            if (parent && parent->isCancelled ())
+                break;
+
             if (EXR_ERR_SUCCESS != exr_read_scanline_chunk_info (*_ctxt, partNumber, y, &cinfo))
                 throw IEX_NAMESPACE::InputExc ("Unable to query scanline information");
 
@@ -516,11 +603,125 @@ void ScanLineInputFile::Data::readPixels (
 
 ////////////////////////////////////////
 
+int ScanLineInputFile::Data::readAvailablePixels (
+    const FrameBuffer &fb, int scanLine1, int scanLine2)
+{
+    exr_attr_box2i_t dw = _ctxt->dataWindow (partNumber);
+    int32_t          scansperchunk = 1;
+    int32_t          nchunks = 0;
+    int              nread = 0;
+
+    if (EXR_ERR_SUCCESS != exr_get_scanlines_per_chunk (*_ctxt, partNumber, &scansperchunk) ||
+        EXR_ERR_SUCCESS != exr_get_chunk_count (*_ctxt, partNumber, &nchunks))
+    {
+        THROW (
+            IEX_NAMESPACE::ArgExc,
+            "Error querying scanline counts from image "
+            "file \"" << _ctxt->fileName () << "\".");
+    }
+
+    if (scanLine2 < scanLine1)
+        std::swap (scanLine1, scanLine2);
+
+    if (scanLine1 < dw.min.y || scanLine2 > dw.max.y)
+    {
+        THROW (
+            IEX_NAMESPACE::ArgExc,
+            "Tried to read scan line outside "
+            "the image file's data window: "
+            << scanLine1 << " - " << scanLine2
+            << " vs datawindow "
+            << dw.min.y << " - " << dw.max.y);
+    }
+
+    //
+    // The chunk table and the record of the chunks read so far are
+    // only touched with _mx held.  The lock is released while the
+    // chunks are decoded, since the decoding tasks take it, too.
+    //
+
+    std::vector<std::pair<int, int>> runs;
+    {
+#if ILMTHREAD_THREADING_ENABLED
+        std::lock_guard<std::mutex> lock (_mx);
+#endif
+        chunksAvailable.resize (static_cast<size_t> (nchunks));
+        chunksRead.resize (static_cast<size_t> (nchunks), 0);
+
+        _ctxt->refreshChunkTable (partNumber, chunksAvailable.data ());
+
+        // collect runs of newly arrived chunks, to be read with one
+        // readPixels call each, such that they are decoded in parallel
+        int c1 = (scanLine1 - dw.min.y) / scansperchunk;
+        int c2 = (scanLine2 - dw.min.y) / scansperchunk;
+
+        for (int c = c1; c <= c2; )
+        {
+            if (!chunksAvailable[c] || chunksRead[c])
+            {
+                ++c;
+                continue;
+            }
+
+            int last = c;
+            while (last < c2 && chunksAvailable[last + 1] &&
+                   !chunksRead[last + 1])
+                ++last;
+
+            runs.emplace_back (c, last);
+            c = last + 1;
+        }
+    }
+
+    auto parent = ILMTHREAD_NAMESPACE::TaskGroup::current ();
+
+    for (const std::pair<int, int>& run: runs)
+    {
+        int y1 = std::max (scanLine1, dw.min.y + run.first * scansperchunk);
+        int y2 = std::min (
+            scanLine2, dw.min.y + (run.second + 1) * scansperchunk - 1);
+
+        readPixels (fb, y1, y2);
+
+        // a cancelled read may have skipped some of the chunks
+        if (parent && parent->isCancelled ())
+            break;
+
+        nread += run.second - run.first + 1;
+
+        //
+        // Only chunks which lie entirely within [scanLine1, scanLine2]
+        // have been delivered in full; the others are read again by a
+        // later call that covers the rest of their scan lines.
+        //
+
+#if ILMTHREAD_THREADING_ENABLED
+        std::lock_guard<std::mutex> lock (_mx);
+#endif
+        for (int i = run.first; i <= run.second; ++i)
+        {
+            int64_t cy1 = int64_t (dw.min.y) + int64_t (i) * scansperchunk;
+            int64_t cy2 =
+                std::min<int64_t> (cy1 + scansperchunk - 1, dw.max.y);
+
+            if (cy1 >= scanLine1 && cy2 <= scanLine2 &&
+                size_t (i) < chunksRead.size ())
+                chunksRead[i] = 1;
+        }
+    }
+
+    return nread;
+}
+
+////////////////////////////////////////
+
 #if ILMTHREAD_THREADING_ENABLED
 void ScanLineInputFile::Data::LineBufferTask::execute ()
 {
     try
     {
+        _line        = _ifd->getChunkProcess ();
+        _line->cinfo = _cinfo;
         _line->run_decode (
             *(_ifd->_ctxt),
             _ifd->partNumber,
@@ -551,7 +752,14 @@ void ScanLineProcess::run_decode (
     // stash the flag off to make sure to clean up in the event
     // of an exception by changing the flag after init...
     bool isfirst = first;
-    if (first)
+    if (first && plan &&
+        plan->takeDecoder (planCtxt, pn, cinfo, decoder, node))
+    {
+        // routines were already chosen for this layout
+        first   = false;
+        isfirst = false;
+    }
+    else if (first)
     {
         if (EXR_ERR_SUCCESS !=
             exr_decoding_initialize (ctxt, pn, &cinfo, &decoder))
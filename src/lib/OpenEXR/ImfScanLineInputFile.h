@@ -77,6 +77,19 @@ public:
     IMF_EXPORT
     void setFrameBuffer (const FrameBuffer& frameBuffer);
 
+    //-----------------------------------------------------------------
+    // Set the current frame buffer from a ReadPlan (see ImfReadPlan.h)
+    //
+    // Equivalent to setFrameBuffer (plan.frameBuffer ()), except that
+    // the decoders set up for reading are shared with other files
+    // read using the same plan.  Throws an ArgExc if the file's
+    // layout does not match the plan.  A subsequent call to
+    // setFrameBuffer() detaches the file from the plan.
+    //-----------------------------------------------------------------
+
+    IMF_EXPORT
+    void setReadPlan (const ReadPlan& plan);
+
     //-----------------------------------
     // Access to the current frame buffer
     //-----------------------------------
@@ -133,6 +146,11 @@ public:
     // If threading is enabled, readPixels (s1, s2) tries to perform
     // decopmression of multiple scanlines in parallel.
     //
+    // When called from within a thread pool task, the chunk tasks
+    // run with the priority of the caller's task group. If that
+    // group is cancelled, readPixels stops issuing new chunks and
+    // returns early, leaving the remaining scan lines untouched.
+    //
     //---------------------------------------------------------------
 
     IMF_EXPORT
@@ -140,6 +158,26 @@ public:
     IMF_EXPORT
     void readPixels (int scanLine);
 
+    //---------------------------------------------------------------
+    // Read the pixel data which has become available so far in a
+    // file which is still being written:
+    //
+    // readAvailablePixels(s1,s2) re-reads the file's line offset
+    // table and reads those scan line blocks within [min (s1, s2),
+    // max (s1, s2)] that have been written since the last call,
+    // returning the number of blocks read.  Blocks already read
+    // by an earlier call are skipped, until the frame buffer is
+    // changed.  Call repeatedly, e.g. until isComplete() returns
+    // true, to pick up the image while it is being rendered.
+    //
+    // The file should be opened with a ContextInitializer with
+    // tailFollow (true) set, such that missing blocks are not
+    // treated as a damaged file.
+    //---------------------------------------------------------------
+
+    IMF_EXPORT
+    int readAvailablePixels (int scanLine1, int scanLine2);
+
     //----------------------------------------------
     // Read a block of raw pixel data from the file,
     // without uncompressing it (this function is
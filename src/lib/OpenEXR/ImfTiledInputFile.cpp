@@ -20,6 +20,8 @@
 
 #include "ImfFrameBuffer.h"
 #include "ImfInputPartData.h"
+#include "ImfReadPlan.h"
+#include "ImfReadPlanData.h"
 
 // TODO: remove once TiledOutput is converted
 #include "ImfTileOffsets.h"
@@ -38,7 +40,12 @@ struct TileProcess
     ~TileProcess ()
     {
         if (!first)
-            exr_decoding_destroy (decoder.context, &decoder);
+        {
+            if (plan)
+                plan->parkDecoder (planCtxt, decoder, node);
+            else
+                exr_decoding_destroy (decoder.context, &decoder);
+        }
     }
 
     void run_decode (
@@ -62,6 +69,15 @@ struct TileProcess
     exr_chunk_info_t      cinfo;
     exr_decode_pipeline_t decoder;
 
+    // NUMA node of the thread which created this, and so first
+    // touched the decode buffers
+    int node = 0;
+
+    // when reading with a ReadPlan, the decoder is taken from and
+    // handed back to the plan instead of being set up from scratch
+    std::shared_ptr<ReadPlanData> plan;
+    Context                       planCtxt;
+
     std::shared_ptr<TileProcess> next;
 };
 
@@ -106,6 +122,11 @@ struct TiledInputFile::Data
     }
 
     void readTiles (int dx1, int dx2, int dy1, int dy2, int lx, int ly);
+    int  readAvailableTiles (
+        int dx1, int dx2, int dy1, int dy2, int lx, int ly, int nx, int ny);
+    void readChunks (
+        const std::vector<exr_chunk_info_t>& chunks,
+        uint8_t*                             decoded = nullptr);
 
     Context* _ctxt;
     int partNumber;
@@ -126,6 +147,11 @@ struct TiledInputFile::Data
 
     FrameBuffer frameBuffer;
     std::vector<Slice> fill_list;
+    std::shared_ptr<ReadPlanData> plan;
+
+    // per level, the tiles handed out by readAvailableTiles since
+    // the frame buffer was last set
+    std::vector<std::vector<uint8_t>> tilesRead;
 
     std::vector<std::string> _failures;
 
@@ -134,17 +160,30 @@ struct TiledInputFile::Data
     ILMTHREAD_NAMESPACE::Semaphore _sem;
 #endif
 
-    std::shared_ptr<TileProcess> processStack;
+    // one stack of decoders per NUMA node, so a thread reuses the
+    // buffers of its own node
+    std::vector<std::shared_ptr<TileProcess>> processStacks;
     std::shared_ptr<TileProcess> getChunkProcess ()
     {
+        int node = ILMTHREAD_NAMESPACE::ThreadPool::currentNumaNode ();
         std::shared_ptr<TileProcess> retval;
 #if ILMTHREAD_THREADING_ENABLED
         std::lock_guard<std::mutex> lk (_mx);
 #endif
-        retval = processStack;
+        if (processStacks.size () <= size_t (node))
+            processStacks.resize (node + 1);
+        retval = processStacks[node];
         if (!retval)
+        {
             retval = std::make_shared<TileProcess> ();
-        processStack = retval->next;
+            retval->node = node;
+            if (plan)
+            {
+                retval->plan     = plan;
+                retval->planCtxt = *_ctxt;
+            }
+        }
+        processStacks[node] = retval->next;
         retval->next.reset();
         return retval;
     }
@@ -153,8 +192,10 @@ struct TiledInputFile::Data
 #if ILMTHREAD_THREADING_ENABLED
         std::lock_guard<std::mutex> lk (_mx);
 #endif
-        tp->next = processStack;
-        processStack = tp;
+        if (processStacks.size () <= size_t (tp->node))
+            processStacks.resize (tp->node + 1);
+        tp->next = processStacks[tp->node];
+        processStacks[tp->node] = tp;
     }
 
 #if ILMTHREAD_THREADING_ENABLED
@@ -165,14 +206,14 @@ struct TiledInputFile::Data
             ILMTHREAD_NAMESPACE::TaskGroup* group,
             Data*                   ifd,
             const FrameBuffer*      outfb,
-            const exr_chunk_info_t& cinfo)
+            const exr_chunk_info_t& cinfo,
+            uint8_t*                decoded)
             : Task (group)
             , _outfb (outfb)
             , _ifd (ifd)
-            , _tile (ifd->getChunkProcess ())
-        {
-            _tile->cinfo = cinfo;
-        }
+            , _decoded (decoded)
+            , _cinfo (cinfo)
+        {}
 
         ~TileBufferTask () override
         {
@@ -188,7 +229,10 @@ struct TiledInputFile::Data
 
         const FrameBuffer* _outfb;
         Data*              _ifd;
+        uint8_t*           _decoded; // set once the tile is in _outfb
+        exr_chunk_info_t   _cinfo;
 
+        // taken when the task runs, from the worker's NUMA node
         std::shared_ptr<TileProcess> _tile;
     };
 #endif
@@ -296,7 +340,30 @@ TiledInputFile::setFrameBuffer (const FrameBuffer& frameBuffer)
     }
 
     _data->frameBuffer = frameBuffer;
-    _data->processStack.reset();
+    _data->plan.reset ();
+    _data->processStacks.clear ();
+    _data->tilesRead.clear ();
+}
+
+void
+TiledInputFile::setReadPlan (const ReadPlan& plan)
+{
+    if (!plan._data->matches (_ctxt, _data->partNumber))
+        THROW (
+            IEX_NAMESPACE::ArgExc,
+            "Read plan does not match the layout of input file \""
+                << fileName () << "\".");
+
+#if ILMTHREAD_THREADING_ENABLED
+    std::lock_guard<std::mutex> lock (_data->_mx);
+#endif
+    // drop (and so hand back) any decoders from a previous plan
+    // before switching over
+    _data->processStacks.clear ();
+    _data->fill_list   = plan._data->fill_list;
+    _data->frameBuffer = plan._data->frameBuffer;
+    _data->plan        = plan._data;
+    _data->tilesRead.clear ();
 }
 
 const FrameBuffer&
@@ -354,6 +421,54 @@ TiledInputFile::readTiles (int dx1, int dx2, int dy1, int dy2, int l)
     readTiles (dx1, dx2, dy1, dy2, l, l);
 }
 
+int
+TiledInputFile::readAvailableTiles (
+    int dx1, int dx2, int dy1, int dy2, int lx, int ly)
+{
+    try
+    {
+        if (!isValidLevel (lx, ly))
+            THROW (
+                IEX_NAMESPACE::ArgExc,
+                "Level coordinate "
+                "(" << lx
+                    << ", " << ly
+                    << ") "
+                       "is invalid.");
+
+        if (dx1 > dx2) std::swap (dx1, dx2);
+        if (dy1 > dy2) std::swap (dy1, dy2);
+
+        int nx = numXTiles (lx);
+        int ny = numYTiles (ly);
+
+        if (dx1 < 0 || dy1 < 0 || dx2 >= nx || dy2 >= ny)
+            THROW (
+                IEX_NAMESPACE::ArgExc,
+                "Tile range (" << dx1 << ", " << dy1 << ") - (" << dx2
+                               << ", " << dy2
+                               << ") is outside the tiles of level ("
+                               << lx << ", " << ly << ").");
+
+        return _data->readAvailableTiles (dx1, dx2, dy1, dy2, lx, ly, nx, ny);
+    }
+    catch (IEX_NAMESPACE::BaseExc& e)
+    {
+        REPLACE_EXC (
+            e,
+            "Error reading pixel data from image "
+            "file \""
+                << fileName () << "\". " << e.what ());
+        throw;
+    }
+}
+
+int
+TiledInputFile::readAvailableTiles (int dx1, int dx2, int dy1, int dy2, int l)
+{
+    return readAvailableTiles (dx1, dx2, dy1, dy2, l, l);
+}
+
 void
 TiledInputFile::readTile (int dx, int dy, int lx, int ly)
 {
@@ -785,67 +900,185 @@ TiledInputFile::tileOrder (int dx[], int dy[], int lx[], int ly[]) const
 
 void TiledInputFile::Data::readTiles (int dx1, int dx2, int dy1, int dy2, int lx, int ly)
 {
-    int nTiles = dx2 - dx1 + 1;
-    nTiles *= dy2 - dy1 + 1;
+    std::vector<exr_chunk_info_t> chunks;
+    exr_chunk_info_t              cinfo;
 
-    exr_chunk_info_t      cinfo;
-#if ILMTHREAD_THREADING_ENABLED
-    if (nTiles > 1 && numThreads > 1)
+    auto parent = ILMTHREAD_NAMESPACE::TaskGroup::current ();
+
+    chunks.reserve (
+        static_cast<size_t> (dx2 - dx1 + 1) *
+        static_cast<size_t> (dy2 - dy1 + 1));
+
+    for (int ty = dy1; ty <= dy2; ++ty)
     {
-        ILMTHREAD_NAMESPACE::TaskGroup tg;
+        for (int tx = dx1; tx <= dx2; ++tx)
+        {
+            if (parent && parent->isCancelled ())
+                return;
+
+            exr_result_t rv = exr_read_tile_chunk_info (
+                *_ctxt, partNumber, tx, ty, lx, ly, &cinfo);
+            if (EXR_ERR_INCOMPLETE_CHUNK_TABLE == rv)
+            {
+                THROW (
+                    IEX_NAMESPACE::InputExc,
+                    "Tile (" << tx << ", " << ty << ", " << lx << ", " << ly
+                    << ") is missing.");
+            }
+            else if (EXR_ERR_SUCCESS != rv)
+                throw IEX_NAMESPACE::InputExc ("Unable to query tile information");
+
+            chunks.push_back (cinfo);
+        }
+    }
 
+    readChunks (chunks);
+}
+
+////////////////////////////////////////
+
+int TiledInputFile::Data::readAvailableTiles (
+    int dx1, int dx2, int dy1, int dy2, int lx, int ly, int nx, int ny)
+{
+    std::vector<exr_chunk_info_t> chunks;
+    std::vector<size_t>           newTiles;
+    exr_chunk_info_t              cinfo;
+    size_t level = static_cast<size_t> (ly) * num_x_levels + lx;
+
+    //
+    // The chunk table and the record of the tiles read so far are
+    // only touched with _mx held.  The lock is released while the
+    // tiles are decoded, since the decoding tasks take it, too.
+    //
+
+    {
+#if ILMTHREAD_THREADING_ENABLED
+        std::lock_guard<std::mutex> lock (_mx);
+#endif
+        _ctxt->refreshChunkTable (partNumber, nullptr);
+
+        if (tilesRead.size () <= level)
+            tilesRead.resize (
+                static_cast<size_t> (num_x_levels) * num_y_levels);
+
+        std::vector<uint8_t>& done = tilesRead[level];
+        done.resize (static_cast<size_t> (nx) * ny, 0);
+
+        // tiles not yet written have no offset, so are rejected without
+        // touching the file
         for (int ty = dy1; ty <= dy2; ++ty)
         {
             for (int tx = dx1; tx <= dx2; ++tx)
             {
+                size_t t = static_cast<size_t> (ty) * nx + tx;
+                if (done[t])
+                    continue;
+
                 exr_result_t rv = exr_read_tile_chunk_info (
                     *_ctxt, partNumber, tx, ty, lx, ly, &cinfo);
                 if (EXR_ERR_INCOMPLETE_CHUNK_TABLE == rv)
-                {
-                    THROW (
-                        IEX_NAMESPACE::InputExc,
-                        "Tile (" << tx << ", " << ty << ", " << lx << ", " << ly
-                        << ") is missing.");
-                }
+                    continue;
                 else if (EXR_ERR_SUCCESS != rv)
                     throw IEX_NAMESPACE::InputExc ("Unable to query tile information");
 
-                // used for honoring the numThreads
-                _sem.wait ();
+                chunks.push_back (cinfo);
+                newTiles.push_back (t);
+            }
+        }
+    }
+
+    // a cancelled read stops early; only the tiles it actually
+    // decoded count as read
+    std::vector<uint8_t> decoded (chunks.size (), 0);
+    readChunks (chunks, decoded.data ());
+
+    int ndecoded = 0;
+
+    {
+#if ILMTHREAD_THREADING_ENABLED
+        std::lock_guard<std::mutex> lock (_mx);
+#endif
+        // the frame buffer, and with it the record, may have been
+        // replaced in the meantime
+        if (level < tilesRead.size ())
+        {
+            std::vector<uint8_t>& done = tilesRead[level];
+            done.resize (static_cast<size_t> (nx) * ny, 0);
+
+            for (size_t i = 0; i < newTiles.size (); ++i)
+            {
+                if (decoded[i])
+                {
+                    done[newTiles[i]] = 1;
+                    ++ndecoded;
+                }
+            }
+        }
+    }
+
+    return ndecoded;
+}
+
+////////////////////////////////////////
 
-                ILMTHREAD_NAMESPACE::ThreadPool::addGlobalTask (
-                    new TileBufferTask (&tg, this, &frameBuffer, cinfo) );
+//
+// Decode the given tiles into the frame buffer.  If decoded is not
+// null, decoded[i] is set to 1 once chunks[i] has been decoded; when
+// the calling task group is cancelled, some tiles are skipped.
+//
+
+void TiledInputFile::Data::readChunks (
+    const std::vector<exr_chunk_info_t>& chunks, uint8_t* decoded)
+{
+#if ILMTHREAD_THREADING_ENABLED
+    if (chunks.size () > 1 && numThreads > 1)
+    {
+        // nest under the calling task's group (if any) such that the
+        // tile tasks inherit its priority and cancellation
+        ILMTHREAD_NAMESPACE::TaskGroup tg (
+            ILMTHREAD_NAMESPACE::TaskGroup::current ());
+
+        for (size_t i = 0; i < chunks.size (); ++i)
+        {
+            if (tg.isCancelled ())
+                break;
+
+            // used for honoring the numThreads
+            _sem.wait ();
+
+            if (tg.isCancelled ())
+            {
+                _sem.post ();
+                break;
             }
+
+            ILMTHREAD_NAMESPACE::ThreadPool::addGlobalTask (new TileBufferTask (
+                &tg,
+                this,
+                &frameBuffer,
+                chunks[i],
+                decoded ? decoded + i : nullptr));
         }
     }
     else
 #endif
     {
         auto tp = getChunkProcess ();
+        auto parent = ILMTHREAD_NAMESPACE::TaskGroup::current ();
 
-        for (int ty = dy1; ty <= dy2; ++ty)
+        for (size_t i = 0; i < chunks.size (); ++i)
         {
-            for (int tx = dx1; tx <= dx2; ++tx)
-            {
-                exr_result_t rv = exr_read_tile_chunk_info (
-                    *_ctxt, partNumber, tx, ty, lx, ly, &cinfo);
-                if (EXR_ERR_INCOMPLETE_CHUNK_TABLE == rv)
-                {
-                    THROW (
-                        IEX_NAMESPACE::InputExc,
-                        "Tile (" << tx << ", " << ty << ", " << lx << ", " << ly
-                        << ") is missing.");
-                }
-                else if (EXR_ERR_SUCCESS != rv)
-                    throw IEX_NAMESPACE::InputExc ("Unable to query tile information");
+            if (parent && parent->isCancelled ())
+                break;
 
-                tp->cinfo = cinfo;
-                tp->run_decode (
-                    *_ctxt,
-                    partNumber,
-                    &frameBuffer,
-                    fill_list);
-            }
+            tp->cinfo = chunks[i];
+            tp->run_decode (
+                *_ctxt,
+                partNumber,
+                &frameBuffer,
+                fill_list);
+
+            if (decoded) decoded[i] = 1;
         }
 
         putChunkProcess (std::move(tp));
@@ -866,11 +1099,15 @@ void TiledInputFile::Data::TileBufferTask::execute ()
 {
     try
     {
+        _tile        = _ifd->getChunkProcess ();
+        _tile->cinfo = _cinfo;
         _tile->run_decode (
             *(_ifd->_ctxt),
             _ifd->partNumber,
             _outfb,
             _ifd->fill_list);
+
+        if (_decoded) *_decoded = 1;
     }
     catch (std::exception &e)
     {
@@ -894,7 +1131,14 @@ void TileProcess::run_decode (
     // stash the flag off to make sure to clean up in the event
     // of an exception by changing the flag after init...
     bool isfirst = first;
-    if (first)
+    if (first && plan &&
+        plan->takeDecoder (planCtxt, pn, cinfo, decoder, node))
+    {
+        // routines were already chosen for this layout
+        first   = false;
+        isfirst = false;
+    }
+    else if (first)
     {
         if (EXR_ERR_SUCCESS !=
             exr_decoding_initialize (ctxt, pn, &cinfo, &decoder))
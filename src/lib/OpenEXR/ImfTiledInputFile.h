@@ -94,6 +94,19 @@ public:
     IMF_EXPORT
     void setFrameBuffer (const FrameBuffer& frameBuffer);
 
+    //-----------------------------------------------------------------
+    // Set the current frame buffer from a ReadPlan (see ImfReadPlan.h)
+    //
+    // Equivalent to setFrameBuffer (plan.frameBuffer ()), except that
+    // the decoders set up for reading are shared with other files
+    // read using the same plan.  Throws an ArgExc if the file's
+    // layout does not match the plan.  A subsequent call to
+    // setFrameBuffer() detaches the file from the plan.
+    //-----------------------------------------------------------------
+
+    IMF_EXPORT
+    void setReadPlan (const ReadPlan& plan);
+
     //-----------------------------------
     // Access to the current frame buffer
     //-----------------------------------
@@ -304,7 +317,9 @@ public:
     //
     // The two readTiles(dx1, dx2, dy1, dy2, ...) functions allow
     // reading multiple tiles at once.  If multi-threading is used
-    // the multiple tiles are read concurrently.
+    // the multiple tiles are read concurrently.  When called from
+    // within a thread pool task whose task group gets cancelled,
+    // no further tiles are read.
     //
     // Pixels that are outside the pixel coordinate range for the
     // tile's level, are never accessed by readTile().
@@ -325,6 +340,29 @@ public:
     IMF_EXPORT
     void readTiles (int dx1, int dx2, int dy1, int dy2, int l = 0);
 
+    //------------------------------------------------------------
+    // Read the tiles which have become available so far in a
+    // file which is still being written:
+    //
+    // readAvailableTiles(dx1, dx2, dy1, dy2, lx, ly) re-reads the
+    // file's tile offset table and reads those tiles in the given
+    // range that have been written since the last call, returning
+    // the number of tiles read.  Tiles already read by an earlier
+    // call are skipped, until the frame buffer is changed.  Call
+    // repeatedly, e.g. until isComplete() returns true, to show
+    // the buckets of an image while it is being rendered.
+    //
+    // The file should be opened with a ContextInitializer with
+    // tailFollow (true) set, such that missing tiles are not
+    // treated as a damaged file.
+    //------------------------------------------------------------
+
+    IMF_EXPORT
+    int readAvailableTiles (int dx1, int dx2, int dy1, int dy2, int lx, int ly);
+
+    IMF_EXPORT
+    int readAvailableTiles (int dx1, int dx2, int dy1, int dy2, int l = 0);
+
     //--------------------------------------------------
     // Read a tile of raw pixel data from the file,
     // without uncompressing it (this function is
@@ -555,10 +555,10 @@ bufferedTileWrite (
 
 void
 convertToXdr (
-    TiledOutputFile::Data* ofd,
-    Array<char>&           tileBuffer,
-    int                    numScanLines,
-    int                    numPixelsPerScanLine)
+    const vector<TOutSliceInfo>& slices,
+    Array<char>&                 tileBuffer,
+    int                          numScanLines,
+    int                          numPixelsPerScanLine)
 {
     //
     // Convert the contents of a TiledOutputFile's tileBuffer from the
@@ -591,9 +591,9 @@ convertToXdr (
         // Iterate over all slices in the file.
         //
 
-        for (unsigned int i = 0; i < ofd->slices.size (); ++i)
+        for (unsigned int i = 0; i < slices.size (); ++i)
         {
-            const TOutSliceInfo& slice = ofd->slices[i];
+            const TOutSliceInfo& slice = slices[i];
 
             //
             // Convert the samples in place.
@@ -621,32 +621,38 @@ class TileBufferTask : public Task
 {
 public:
     TileBufferTask (
-        TaskGroup*             group,
-        TiledOutputFile::Data* ofd,
-        int                    number,
-        int                    dx,
-        int                    dy,
-        int                    lx,
-        int                    ly);
+        TaskGroup*                   group,
+        TiledOutputFile::Data*       ofd,
+        const vector<TOutSliceInfo>& slices,
+        int                          number,
+        int                          dx,
+        int                          dy,
+        int                          lx,
+        int                          ly);
 
     virtual ~TileBufferTask ();
 
     virtual void execute ();
 
 private:
-    TiledOutputFile::Data* _ofd;
-    TileBuffer*            _tileBuffer;
+    TiledOutputFile::Data*       _ofd;
+    const vector<TOutSliceInfo>* _slices;
+    TileBuffer*                  _tileBuffer;
 };
 
 TileBufferTask::TileBufferTask (
-    TaskGroup*             group,
-    TiledOutputFile::Data* ofd,
-    int                    number,
-    int                    dx,
-    int                    dy,
-    int                    lx,
-    int                    ly)
-    : Task (group), _ofd (ofd), _tileBuffer (_ofd->getTileBuffer (number))
+    TaskGroup*                   group,
+    TiledOutputFile::Data*       ofd,
+    const vector<TOutSliceInfo>& slices,
+    int                          number,
+    int                          dx,
+    int                          dy,
+    int                          lx,
+    int                          ly)
+    : Task (group)
+    , _ofd (ofd)
+    , _slices (&slices)
+    , _tileBuffer (_ofd->getTileBuffer (number))
 {
     //
     // Wait for the tileBuffer to become available
@@ -705,9 +711,9 @@ TileBufferTask::execute ()
             // Iterate over all image channels.
             //
 
-            for (unsigned int i = 0; i < _ofd->slices.size (); ++i)
+            for (unsigned int i = 0; i < _slices->size (); ++i)
             {
-                const TOutSliceInfo& slice = _ofd->slices[i];
+                const TOutSliceInfo& slice = (*_slices)[i];
 
                 //
                 // These offsets are used to facilitate both absolute
@@ -794,7 +800,7 @@ TileBufferTask::execute ()
                 //
 
                 convertToXdr (
-                    _ofd,
+                    *_slices,
                     _tileBuffer->buffer,
                     numScanLines,
                     numPixelsPerScanLine);
@@ -819,6 +825,271 @@ TileBufferTask::execute ()
     }
 }
 
+//
+// Build the slice table that TileBufferTask reads the pixels of a tile
+// from, after checking that the frame buffer is compatible with the
+// file's channels
+//
+
+vector<TOutSliceInfo>
+sliceTable (
+    const ChannelList& channels,
+    const FrameBuffer& frameBuffer,
+    const char*        fileName)
+{
+    for (ChannelList::ConstIterator i = channels.begin (); i != channels.end ();
+         ++i)
+    {
+        FrameBuffer::ConstIterator j = frameBuffer.find (i.name ());
+
+        if (j == frameBuffer.end ()) continue;
+
+        if (i.channel ().type != j.slice ().type)
+            THROW (
+                IEX_NAMESPACE::ArgExc,
+                "Pixel type of \"" << i.name ()
+                                   << "\" channel "
+                                      "of output file \""
+                                   << fileName
+                                   << "\" is "
+                                      "not compatible with the frame buffer's "
+                                      "pixel type.");
+
+        if (j.slice ().xSampling != 1 || j.slice ().ySampling != 1)
+            THROW (
+                IEX_NAMESPACE::ArgExc,
+                "All channels in a tiled file must have"
+                "sampling (1,1).");
+    }
+
+    vector<TOutSliceInfo> slices;
+
+    for (ChannelList::ConstIterator i = channels.begin (); i != channels.end ();
+         ++i)
+    {
+        FrameBuffer::ConstIterator j = frameBuffer.find (i.name ());
+
+        if (j == frameBuffer.end ())
+        {
+            //
+            // Channel i is not present in the frame buffer.
+            // In the file, channel i will contain only zeroes.
+            //
+
+            slices.push_back (TOutSliceInfo (
+                i.channel ().type,
+                0,      // base
+                0,      // xStride,
+                0,      // yStride,
+                true)); // zero
+        }
+        else
+        {
+            //
+            // Channel i is present in the frame buffer.
+            //
+
+            slices.push_back (TOutSliceInfo (
+                j.slice ().type,
+                j.slice ().base,
+                j.slice ().xStride,
+                j.slice ().yStride,
+                false, // zero
+                (j.slice ().xTileCoords) ? 1 : 0,
+                (j.slice ().yTileCoords) ? 1 : 0));
+        }
+    }
+
+    return slices;
+}
+
+//
+// A tile to be written, and the slice table to take its pixels from
+//
+
+struct TileToWrite
+{
+    TileCoord                    coord;
+    const vector<TOutSliceInfo>* slices;
+};
+
+//
+// Append a range of tiles of level (lx, ly) to a list of tiles to be
+// written, in the order given by the file's line order
+//
+
+void
+appendLevelTiles (
+    const TiledOutputFile::Data* ofd,
+    const vector<TOutSliceInfo>& slices,
+    int                          dx1,
+    int                          dx2,
+    int                          dy1,
+    int                          dy2,
+    int                          lx,
+    int                          ly,
+    vector<TileToWrite>&         tiles)
+{
+    int dyStart = dy1;
+    int dY      = 1;
+
+    if (ofd->lineOrder == DECREASING_Y)
+    {
+        dyStart = dy2;
+        dY      = -1;
+    }
+
+    for (int i = 0, dy = dyStart; i <= dy2 - dy1; ++i, dy += dY)
+        for (int dx = dx1; dx <= dx2; ++dx)
+            tiles.push_back ({TileCoord (dx, dy, lx, ly), &slices});
+}
+
+//
+// Compress a list of tiles using the thread pool, and write them to
+// the file in the order in which they are listed.  Writing a tile
+// overlaps with compressing the tiles that follow it; when the list
+// spans several levels, the threads are kept busy across the end of
+// each level.
+//
+
+void
+writeTileList (
+    OutputStreamMutex*         streamData,
+    TiledOutputFile::Data*     ofd,
+    const vector<TileToWrite>& tiles)
+{
+    int numTiles = static_cast<int> (tiles.size ());
+    int numTasks = min ((int) ofd->tileBuffers.size (), numTiles);
+
+    //
+    // Create a task group for all tile buffer tasks.  When the
+    // task group goes out of scope, the destructor waits until
+    // all tasks are complete.
+    //
+
+    {
+        TaskGroup taskGroup;
+
+        //
+        // Add in the initial compression tasks to the thread pool
+        //
+
+        int nextCompBuffer = 0;
+
+        while (nextCompBuffer < numTasks)
+        {
+            const TileToWrite& comp = tiles[nextCompBuffer];
+
+            ThreadPool::addGlobalTask (new TileBufferTask (
+                &taskGroup,
+                ofd,
+                *comp.slices,
+                nextCompBuffer,
+                comp.coord.dx,
+                comp.coord.dy,
+                comp.coord.lx,
+                comp.coord.ly));
+
+            nextCompBuffer++;
+        }
+
+        //
+        // Write the compressed buffers and add in more compression
+        // tasks until done
+        //
+
+        for (int nextWriteBuffer = 0; nextWriteBuffer < numTiles;
+             ++nextWriteBuffer)
+        {
+            //
+            // Wait until the nextWriteBuffer is ready to be written
+            //
+
+            TileBuffer* writeBuffer = ofd->getTileBuffer (nextWriteBuffer);
+
+            writeBuffer->wait ();
+
+            //
+            // Write the tilebuffer
+            //
+
+            const TileCoord& write = tiles[nextWriteBuffer].coord;
+
+            bufferedTileWrite (
+                streamData,
+                ofd,
+                write.dx,
+                write.dy,
+                write.lx,
+                write.ly,
+                writeBuffer->dataPtr,
+                writeBuffer->dataSize);
+
+            //
+            // Release the lock on nextWriteBuffer
+            //
+
+            writeBuffer->post ();
+
+            //
+            // If there are no more tileBuffers to compress, then
+            // only continue to write out remaining tileBuffers,
+            // otherwise keep adding compression tasks.
+            //
+
+            if (nextCompBuffer < numTiles)
+            {
+                const TileToWrite& comp = tiles[nextCompBuffer];
+
+                ThreadPool::addGlobalTask (new TileBufferTask (
+                    &taskGroup,
+                    ofd,
+                    *comp.slices,
+                    nextCompBuffer,
+                    comp.coord.dx,
+                    comp.coord.dy,
+                    comp.coord.lx,
+                    comp.coord.ly));
+            }
+
+            nextCompBuffer++;
+        }
+
+        //
+        // finish all tasks
+        //
+    }
+
+    //
+    // Exception handling:
+    //
+    // TileBufferTask::execute() may have encountered exceptions, but
+    // those exceptions occurred in another thread, not in the thread
+    // that is executing this function.  TileBufferTask::execute() has
+    // caught all exceptions and stored the exceptions' what() strings
+    // in the tile buffers.
+    // Now we check if any tile buffer contains a stored exception; if
+    // this is the case then we re-throw the exception in this thread.
+    // (It is possible that multiple tile buffers contain stored
+    // exceptions.  We re-throw the first exception we find and
+    // ignore all others.)
+    //
+
+    const string* exception = 0;
+
+    for (size_t i = 0; i < ofd->tileBuffers.size (); ++i)
+    {
+        TileBuffer* tileBuffer = ofd->tileBuffers[i];
+
+        if (tileBuffer->hasException && !exception)
+            exception = &tileBuffer->exception;
+
+        tileBuffer->hasException = false;
+    }
+
+    if (exception) throw IEX_NAMESPACE::IoExc (*exception);
+}
+
 } // namespace
 
 TiledOutputFile::TiledOutputFile (
@@ -1098,77 +1369,12 @@ TiledOutputFile::setFrameBuffer (const FrameBuffer& frameBuffer)
 #endif
     //
     // Check if the new frame buffer descriptor
-    // is compatible with the image file header.
+    // is compatible with the image file header,
+    // and initialize slice table for writePixels().
     //
 
-    const ChannelList& channels = _data->header.channels ();
-
-    for (ChannelList::ConstIterator i = channels.begin (); i != channels.end ();
-         ++i)
-    {
-        FrameBuffer::ConstIterator j = frameBuffer.find (i.name ());
-
-        if (j == frameBuffer.end ()) continue;
-
-        if (i.channel ().type != j.slice ().type)
-            THROW (
-                IEX_NAMESPACE::ArgExc,
-                "Pixel type of \"" << i.name ()
-                                   << "\" channel "
-                                      "of output file \""
-                                   << fileName ()
-                                   << "\" is "
-                                      "not compatible with the frame buffer's "
-                                      "pixel type.");
-
-        if (j.slice ().xSampling != 1 || j.slice ().ySampling != 1)
-            THROW (
-                IEX_NAMESPACE::ArgExc,
-                "All channels in a tiled file must have"
-                "sampling (1,1).");
-    }
-
-    //
-    // Initialize slice table for writePixels().
-    //
-
-    vector<TOutSliceInfo> slices;
-
-    for (ChannelList::ConstIterator i = channels.begin (); i != channels.end ();
-         ++i)
-    {
-        FrameBuffer::ConstIterator j = frameBuffer.find (i.name ());
-
-        if (j == frameBuffer.end ())
-        {
-            //
-            // Channel i is not present in the frame buffer.
-            // In the file, channel i will contain only zeroes.
-            //
-
-            slices.push_back (TOutSliceInfo (
-                i.channel ().type,
-                0,      // base
-                0,      // xStride,
-                0,      // yStride,
-                true)); // zero
-        }
-        else
-        {
-            //
-            // Channel i is present in the frame buffer.
-            //
-
-            slices.push_back (TOutSliceInfo (
-                j.slice ().type,
-                j.slice ().base,
-                j.slice ().xStride,
-                j.slice ().yStride,
-                false, // zero
-                (j.slice ().xTileCoords) ? 1 : 0,
-                (j.slice ().yTileCoords) ? 1 : 0));
-        }
-    }
+    vector<TOutSliceInfo> slices =
+        sliceTable (_data->header.channels (), frameBuffer, fileName ());
 
     //
     // Store the new frame buffer.
@@ -1210,195 +1416,108 @@ TiledOutputFile::writeTiles (int dx1, int dx2, int dy1, int dy2, int lx, int ly)
                     << ", " << ly
                     << ") "
                        "is invalid.");
-        //
-        // Determine the first and last tile coordinates in both dimensions
-        // based on the file's lineOrder
-        //
 
         if (dx1 > dx2) swap (dx1, dx2);
 
         if (dy1 > dy2) swap (dy1, dy2);
 
-        int dyStart = dy1;
-        int dY      = 1;
-
-        if (_data->lineOrder == DECREASING_Y)
-        {
-            dyStart = dy2;
-            dY      = -1;
-        }
-
-        int numTiles = (dx2 - dx1 + 1) * (dy2 - dy1 + 1);
-        int numTasks = min ((int) _data->tileBuffers.size (), numTiles);
-
         //
-        // Create a task group for all tile buffer tasks.  When the
-        // task group goes out of scope, the destructor waits until
-        // all tasks are complete.
+        // The tiles are written in the order given by the file's lineOrder
         //
 
-        {
-            TaskGroup taskGroup;
-
-            //
-            // Add in the initial compression tasks to the thread pool
-            //
+        vector<TileToWrite> tiles;
+        tiles.reserve (size_t (dx2 - dx1 + 1) * size_t (dy2 - dy1 + 1));
 
-            int nextCompBuffer = 0;
-            int dxComp         = dx1;
-            int dyComp         = dyStart;
-
-            while (nextCompBuffer < numTasks)
-            {
-                ThreadPool::addGlobalTask (new TileBufferTask (
-                    &taskGroup,
-                    _data,
-                    nextCompBuffer++,
-                    dxComp,
-                    dyComp,
-                    lx,
-                    ly));
-                dxComp++;
+        appendLevelTiles (
+            _data, _data->slices, dx1, dx2, dy1, dy2, lx, ly, tiles);
 
-                if (dxComp > dx2)
-                {
-                    dxComp = dx1;
-                    dyComp += dY;
-                }
-            }
-
-            //
-            // Write the compressed buffers and add in more compression
-            // tasks until done
-            //
-
-            int nextWriteBuffer = 0;
-            int dxWrite         = dx1;
-            int dyWrite         = dyStart;
-
-            while (nextWriteBuffer < numTiles)
-            {
-                //
-                // Wait until the nextWriteBuffer is ready to be written
-                //
-
-                TileBuffer* writeBuffer =
-                    _data->getTileBuffer (nextWriteBuffer);
-
-                writeBuffer->wait ();
-
-                //
-                // Write the tilebuffer
-                //
-
-                bufferedTileWrite (
-                    _streamData,
-                    _data,
-                    dxWrite,
-                    dyWrite,
-                    lx,
-                    ly,
-                    writeBuffer->dataPtr,
-                    writeBuffer->dataSize);
-
-                //
-                // Release the lock on nextWriteBuffer
-                //
-
-                writeBuffer->post ();
-
-                //
-                // If there are no more tileBuffers to compress, then
-                // only continue to write out remaining tileBuffers,
-                // otherwise keep adding compression tasks.
-                //
-
-                if (nextCompBuffer < numTiles)
-                {
-                    //
-                    // add nextCompBuffer as a compression Task
-                    //
-
-                    ThreadPool::addGlobalTask (new TileBufferTask (
-                        &taskGroup,
-                        _data,
-                        nextCompBuffer,
-                        dxComp,
-                        dyComp,
-                        lx,
-                        ly));
-                }
+        writeTileList (_streamData, _data, tiles);
+    }
+    catch (IEX_NAMESPACE::BaseExc& e)
+    {
+        REPLACE_EXC (
+            e,
+            "Failed to write pixel data to image "
+            "file \""
+                << fileName () << "\". " << e.what ());
+        throw;
+    }
+}
 
-                nextWriteBuffer++;
-                dxWrite++;
+void
+TiledOutputFile::writeTiles (int dx1, int dxMax, int dyMin, int dyMax, int l)
+{
+    writeTiles (dx1, dxMax, dyMin, dyMax, l, l);
+}
 
-                if (dxWrite > dx2)
-                {
-                    dxWrite = dx1;
-                    dyWrite += dY;
-                }
+void
+TiledOutputFile::writeLevels (const vector<FrameBuffer>& frameBuffers)
+{
+    try
+    {
+#if ILMTHREAD_THREADING_ENABLED
+        std::lock_guard<std::mutex> lock (*_streamData);
+#endif
+        bool   ripmap    = _data->tileDesc.mode == RIPMAP_LEVELS;
+        size_t numLevels = ripmap ? size_t (_data->numXLevels) *
+                                        size_t (_data->numYLevels)
+                                  : size_t (_data->numXLevels);
 
-                nextCompBuffer++;
-                dxComp++;
+        if (frameBuffers.size () != numLevels)
+            THROW (
+                IEX_NAMESPACE::ArgExc,
+                "Expected " << numLevels
+                            << " frame buffers, one for each "
+                               "level of the file, but got "
+                            << frameBuffers.size () << ".");
 
-                if (dxComp > dx2)
-                {
-                    dxComp = dx1;
-                    dyComp += dY;
-                }
-            }
+        vector<vector<TOutSliceInfo>> slices (numLevels);
 
-            //
-            // finish all tasks
-            //
-        }
+        for (size_t i = 0; i < numLevels; ++i)
+            slices[i] = sliceTable (
+                _data->header.channels (), frameBuffers[i], fileName ());
 
         //
-        // Exception handling:
-        //
-        // TileBufferTask::execute() may have encountered exceptions, but
-        // those exceptions occurred in another thread, not in the thread
-        // that is executing this call to TiledOutputFile::writeTiles().
-        // TileBufferTask::execute() has caught all exceptions and stored
-        // the exceptions' what() strings in the tile buffers.
-        // Now we check if any tile buffer contains a stored exception; if
-        // this is the case then we re-throw the exception in this thread.
-        // (It is possible that multiple tile buffers contain stored
-        // exceptions.  We re-throw the first exception we find and
-        // ignore all others.)
+        // List the tiles of all levels, in the order in which
+        // the levels are stored in the file.
         //
 
-        const string* exception = 0;
+        vector<TileToWrite> tiles;
 
-        for (size_t i = 0; i < _data->tileBuffers.size (); ++i)
+        for (int ly = 0; ly < _data->numYLevels; ++ly)
         {
-            TileBuffer* tileBuffer = _data->tileBuffers[i];
+            for (int lx = 0; lx < _data->numXLevels; ++lx)
+            {
+                if (!ripmap && lx != ly) continue;
 
-            if (tileBuffer->hasException && !exception)
-                exception = &tileBuffer->exception;
+                size_t level = ripmap ? size_t (ly) * _data->numXLevels + lx
+                                      : size_t (lx);
 
-            tileBuffer->hasException = false;
+                appendLevelTiles (
+                    _data,
+                    slices[level],
+                    0,
+                    _data->numXTiles[lx] - 1,
+                    0,
+                    _data->numYTiles[ly] - 1,
+                    lx,
+                    ly,
+                    tiles);
+            }
         }
 
-        if (exception) throw IEX_NAMESPACE::IoExc (*exception);
+        writeTileList (_streamData, _data, tiles);
     }
     catch (IEX_NAMESPACE::BaseExc& e)
     {
         REPLACE_EXC (
             e,
             "Failed to write pixel data to image "
-            "file \""
-                << fileName () << "\". " << e.what ());
+            "file \"" << fileName () << "\". " << e.what ());
         throw;
     }
 }
 
-void
-TiledOutputFile::writeTiles (int dx1, int dxMax, int dyMin, int dyMax, int l)
-{
-    writeTiles (dx1, dxMax, dyMin, dyMax, l, l);
-}
-
 void
 TiledOutputFile::writeTile (int dx, int dy, int lx, int ly)
 {
@@ -20,6 +20,8 @@
 
 #include <ImathBox.h>
 
+#include <vector>
+
 OPENEXR_IMF_INTERNAL_NAMESPACE_HEADER_ENTER
 
 struct PreviewRgba;
@@ -368,6 +370,25 @@ public:
     IMF_EXPORT
     void writeTiles (int dx1, int dx2, int dy1, int dy2, int l = 0);
 
+    //------------------------------------------------------------------
+    // Write all tiles of all levels, taking the pixels of each level
+    // from its own frame buffer:
+    //
+    //   ONE_LEVEL      frameBuffers[0] holds level (0, 0)
+    //   MIPMAP_LEVELS  frameBuffers[l] holds level (l, l)
+    //   RIPMAP_LEVELS  frameBuffers[ly * numXLevels() + lx]
+    //                  holds level (lx, ly)
+    //
+    // This is equivalent to calling setFrameBuffer() and writeTiles()
+    // for each level in turn, but the tiles of all levels are
+    // compressed in one pass over the thread pool, so that the many
+    // small levels of a mipmap or ripmap do not leave threads idle.
+    // The frame buffer set with setFrameBuffer() is not changed.
+    //------------------------------------------------------------------
+
+    IMF_EXPORT
+    void writeLevels (const std::vector<FrameBuffer>& frameBuffers);
+
     //------------------------------------------------------------------
     // Shortcut to copy all pixels from a TiledInputFile into this file,
     // without uncompressing and then recompressing the pixel data.
@@ -160,6 +160,12 @@ TiledOutputPart::writeTiles (int dx1, int dx2, int dy1, int dy2, int l)
     file->writeTiles (dx1, dx2, dy1, dy2, l);
 }
 
+void
+TiledOutputPart::writeLevels (const std::vector<FrameBuffer>& frameBuffers)
+{
+    file->writeLevels (frameBuffers);
+}
+
 void
 TiledOutputPart::copyPixels (TiledInputFile& in)
 {
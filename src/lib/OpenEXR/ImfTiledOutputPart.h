@@ -11,6 +11,8 @@
 #include "ImfTileDescription.h"
 #include <ImathBox.h>
 
+#include <vector>
+
 OPENEXR_IMF_INTERNAL_NAMESPACE_HEADER_ENTER
 
 //-------------------------------------------------------------------------------
@@ -75,6 +77,8 @@ public:
     IMF_EXPORT
     void writeTiles (int dx1, int dx2, int dy1, int dy2, int l = 0);
     IMF_EXPORT
+    void writeLevels (const std::vector<FrameBuffer>& frameBuffers);
+    IMF_EXPORT
     void copyPixels (TiledInputFile& in);
     IMF_EXPORT
     void copyPixels (InputFile& in);
@@ -547,6 +547,99 @@ exr_get_chunk_table_offset (
     return EXR_ERR_SUCCESS;
 }
 
+/* reads the leader of a chunk of a file still being written, and checks
+ * that the leader and the packed data of the chunk end within the file.
+ * Silent, as chunks which are still being written are expected to be
+ * incomplete. */
+static int
+tail_chunk_complete (
+    exr_const_context_t ctxt, exr_const_priv_part_t part, uint64_t offset)
+{
+    int32_t  data[6];
+    int64_t  deep_data[3];
+    uint64_t maxoff = (uint64_t) ctxt->file_size;
+    uint64_t nextoffset = offset;
+    int64_t  packed;
+    int      ntoread = (ctxt->is_multipart) ? 1 : 0;
+    int      deep    = (part->storage_mode == EXR_STORAGE_DEEP_SCANLINE ||
+                 part->storage_mode == EXR_STORAGE_DEEP_TILED);
+
+    if (part->storage_mode == EXR_STORAGE_SCANLINE ||
+        part->storage_mode == EXR_STORAGE_DEEP_SCANLINE)
+        ntoread += 1;
+    else
+        ntoread += 4;
+    if (!deep) ++ntoread;
+
+    if ((uint64_t) ntoread * sizeof (int32_t) > maxoff - offset) return 0;
+    if (EXR_ERR_SUCCESS != ctxt->do_read (
+                               ctxt,
+                               data,
+                               (size_t) ntoread * sizeof (int32_t),
+                               &nextoffset,
+                               NULL,
+                               EXR_MUST_READ_ALL))
+        return 0;
+    priv_to_native32 (data, ntoread);
+
+    if (deep)
+    {
+        if (sizeof (deep_data) > maxoff - nextoffset) return 0;
+        if (EXR_ERR_SUCCESS != ctxt->do_read (
+                                   ctxt,
+                                   deep_data,
+                                   sizeof (deep_data),
+                                   &nextoffset,
+                                   NULL,
+                                   EXR_MUST_READ_ALL))
+            return 0;
+        priv_to_native64 (deep_data, 3);
+
+        if (deep_data[0] < 0 || deep_data[1] < 0 ||
+            deep_data[0] > (int64_t) maxoff || deep_data[1] > (int64_t) maxoff)
+            return 0;
+        packed = deep_data[0] + deep_data[1];
+    }
+    else
+        packed = data[ntoread - 1];
+
+    return packed >= 0 && (uint64_t) packed <= maxoff - nextoffset;
+}
+
+/* when following a file still being written, any entry which does not
+ * (yet) point at a complete chunk inside the file is a chunk still to
+ * come. Entries which match those in known, the previous table (if any),
+ * have already been checked. */
+static int32_t
+sanitize_tail_chunk_table (
+    exr_const_context_t   ctxt,
+    exr_const_priv_part_t part,
+    uint64_t*             ctable,
+    const uint64_t*       known)
+{
+    uint64_t chunkmin, maxoff = ((uint64_t) -1);
+    int32_t  navail = 0;
+
+    chunkmin = part->chunk_table_offset +
+               sizeof (uint64_t) * (uint64_t) part->chunk_count;
+    if (ctxt->file_size > 0) maxoff = (uint64_t) ctxt->file_size;
+
+    for (int ci = 0; ci < part->chunk_count; ++ci)
+    {
+        uint64_t cchunk = one_to_native64 (ctable[ci]);
+        if (cchunk < chunkmin || cchunk >= maxoff)
+            cchunk = 0;
+        else if (
+            ctxt->file_size > 0 && !(known && known[ci] == cchunk) &&
+            !tail_chunk_complete (ctxt, part, cchunk))
+            cchunk = 0;
+        else
+            ++navail;
+        ctable[ci] = cchunk;
+    }
+    return navail;
+}
+
 exr_result_t
 extract_chunk_table (
     exr_const_context_t   ctxt,
@@ -600,6 +693,10 @@ extract_chunk_table (
             ctxt->free_fn (ctable);
             ctable = (uint64_t*) UINTPTR_MAX;
         }
+        else if (ctxt->tail_follow)
+        {
+            sanitize_tail_chunk_table (ctxt, part, ctable, NULL);
+        }
         else if (!ctxt->disable_chunk_reconstruct)
         {
             // could convert table all at once, but need to check if the
@@ -660,6 +757,112 @@ extract_chunk_table (
 
 /**************************************/
 
+exr_result_t
+exr_refresh_chunk_table (
+    exr_const_context_t ctxt,
+    int                 part_index,
+    int32_t*            num_available,
+    uint8_t*            available)
+{
+    exr_result_t rv = EXR_ERR_SUCCESS;
+    uint64_t*    ctable;
+    uint64_t*    newtable;
+    uint64_t     chunkoff, chunkmin, chunkbytes;
+    uintptr_t    eptr;
+
+    EXR_READONLY_AND_DEFINE_PART (part_index);
+
+    if (!num_available)
+        return ctxt->standard_error (ctxt, EXR_ERR_INVALID_ARGUMENT);
+    *num_available = 0;
+    if (available && part->chunk_count > 0)
+        memset (available, 0, (size_t) part->chunk_count);
+
+    if (ctxt->size_fn)
+    {
+        EXR_CONST_CAST (exr_context_t, ctxt)->file_size =
+            ctxt->size_fn (ctxt, ctxt->user_data);
+    }
+
+    chunkoff   = part->chunk_table_offset;
+    chunkbytes = sizeof (uint64_t) * (uint64_t) part->chunk_count;
+
+    /* the table itself has not made it to disk yet, nothing to read */
+    if (part->chunk_count > 0 && ctxt->file_size > 0 &&
+        chunkbytes + chunkoff > (uint64_t) ctxt->file_size)
+        return EXR_ERR_SUCCESS;
+
+    eptr = (uintptr_t) atomic_load (
+        EXR_CONST_CAST (atomic_uintptr_t*, &(part->chunk_table)));
+    if (eptr == 0)
+    {
+        /* first look, the regular path reads (and sanitizes) the table */
+        rv = extract_chunk_table (ctxt, part, &ctable, &chunkmin);
+        if (rv == EXR_ERR_SUCCESS)
+        {
+            for (int ci = 0; ci < part->chunk_count; ++ci)
+            {
+                if (ctable[ci] == 0) continue;
+                ++(*num_available);
+                if (available) available[ci] = 1;
+            }
+            return rv;
+        }
+        eptr = (uintptr_t) atomic_load (
+            EXR_CONST_CAST (atomic_uintptr_t*, &(part->chunk_table)));
+        if (eptr != UINTPTR_MAX) return rv;
+    }
+
+    newtable = (uint64_t*) ctxt->alloc_fn (chunkbytes);
+    if (newtable == NULL)
+        return ctxt->standard_error (ctxt, EXR_ERR_OUT_OF_MEMORY);
+
+    rv = ctxt->do_read (
+        ctxt, newtable, chunkbytes, &chunkoff, NULL, EXR_MUST_READ_ALL);
+    if (rv != EXR_ERR_SUCCESS)
+    {
+        ctxt->free_fn (newtable);
+        return rv;
+    }
+
+    *num_available = sanitize_tail_chunk_table (
+        ctxt,
+        part,
+        newtable,
+        (eptr == UINTPTR_MAX) ? NULL : (const uint64_t*) eptr);
+
+    if (available)
+    {
+        for (int ci = 0; ci < part->chunk_count; ++ci)
+            available[ci] = (newtable[ci] != 0) ? 1 : 0;
+    }
+
+    if (eptr == UINTPTR_MAX)
+    {
+        /* a previous attempt to read the table failed, replace the marker */
+        if (!atomic_compare_exchange_strong (
+                EXR_CONST_CAST (atomic_uintptr_t*, &(part->chunk_table)),
+                &eptr,
+                (uintptr_t) newtable))
+        {
+            ctxt->free_fn (newtable);
+            return ctxt->report_error (
+                ctxt,
+                EXR_ERR_INVALID_ARGUMENT,
+                "Chunk table refreshed concurrently");
+        }
+    }
+    else
+    {
+        memcpy ((uint64_t*) eptr, newtable, chunkbytes);
+        ctxt->free_fn (newtable);
+    }
+
+    return EXR_ERR_SUCCESS;
+}
+
+/**************************************/
+
 static exr_result_t
 alloc_chunk_table (
     exr_const_context_t ctxt, exr_const_priv_part_t part, uint64_t** chunktable)
@@ -1940,6 +2143,7 @@ exr_write_tile_chunk_info (
     const exr_attr_chlist_t*   chanlist;
     const exr_attr_tiledesc_t* tiledesc;
     int                        tilew, tileh;
+    int64_t                    dend, tend;
     uint64_t                   unpacksize = 0;
     exr_chunk_info_t           nil        = {0};
 
@@ -1971,27 +2175,24 @@ exr_write_tile_chunk_info (
     if (rv != EXR_ERR_SUCCESS) return EXR_UNLOCK_AND_RETURN (rv);
 
     tiledesc = part->tiles->tiledesc;
-    tilew    = part->tile_level_tile_size_x[levelx];
-    if (tiledesc->x_size < (uint32_t) tilew) tilew = (int) tiledesc->x_size;
-    tileh = part->tile_level_tile_size_y[levely];
-    if (tiledesc->y_size < (uint32_t) tileh) tileh = (int) tiledesc->y_size;
 
-    if (((int64_t) (tilex) * (int64_t) (tilew) + (int64_t) (tilew) +
-         (int64_t) (part->data_window.min.x) - 1) >
-        (int64_t) (part->data_window.max.x))
+    /* edge tiles are clipped to the size of their level, as when reading */
+    tilew = (int) (tiledesc->x_size);
+    dend  = ((int64_t) part->tile_level_tile_size_x[levelx]);
+    tend  = ((int64_t) tilew) * ((int64_t) (tilex + 1));
+    if (tend > dend)
     {
-        int64_t sz = (int64_t) (part->data_window.max.x) -
-                     (int64_t) (part->data_window.min.x) + 1;
-        tilew = (int) (sz - ((int64_t) (tilex) * (int64_t) (tilew)));
+        tend -= dend;
+        if (tend < tilew) tilew = tilew - ((int) tend);
     }
 
-    if (((int64_t) (tiley) * (int64_t) (tileh) + (int64_t) (tileh) +
-         (int64_t) (part->data_window.min.y) - 1) >
-        (int64_t) (part->data_window.max.y))
+    tileh = (int) (tiledesc->y_size);
+    dend  = ((int64_t) part->tile_level_tile_size_y[levely]);
+    tend  = ((int64_t) tileh) * ((int64_t) (tiley + 1));
+    if (tend > dend)
     {
-        int64_t sz = (int64_t) (part->data_window.max.y) -
-                     (int64_t) (part->data_window.min.y) + 1;
-        tileh = (int) (sz - ((int64_t) (tiley) * (int64_t) (tileh)));
+        tend -= dend;
+        if (tend < tileh) tileh = tileh - ((int) tend);
     }
 
     *cinfo             = nil;
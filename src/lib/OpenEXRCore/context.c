@@ -93,9 +93,24 @@ dispatch_write (
 
 /**************************************/
 
+/* stands in for dispatch_write to measure the size of the header
+ * without writing it */
+static exr_result_t
+dispatch_measure_write (
+    exr_context_t ctxt, const void* buf, uint64_t sz, uint64_t* offsetp)
+{
+    (void) ctxt;
+    (void) buf;
+    *offsetp += sz;
+    return EXR_ERR_SUCCESS;
+}
+
+/**************************************/
+
 static exr_result_t
 process_query_size (exr_context_t ctxt, exr_context_initializer_t* inits)
 {
+    ctxt->size_fn = inits->size_fn;
     if (inits->size_fn)
     {
         ctxt->file_size =
@@ -362,11 +377,71 @@ exr_start_inplace_header_update (
     const char*                      filename,
     const exr_context_initializer_t* ctxtdata)
 {
-    /* TODO: not yet implemented */
-    (void) ctxt;
-    (void) filename;
-    (void) ctxtdata;
-    return EXR_ERR_INVALID_ARGUMENT;
+    exr_result_t              rv    = EXR_ERR_UNKNOWN;
+    exr_context_t             ret   = NULL;
+    exr_context_initializer_t inits = fill_context_data (ctxtdata);
+
+    if (!ctxt)
+    {
+        inits.error_handler_fn (
+            NULL,
+            EXR_ERR_INVALID_ARGUMENT,
+            "Invalid context handle passed to start_inplace_header_update function");
+        return EXR_ERR_INVALID_ARGUMENT;
+    }
+
+    if (!inits.read_fn != !inits.write_fn)
+    {
+        inits.error_handler_fn (
+            NULL,
+            EXR_ERR_INVALID_ARGUMENT,
+            "Updating a header in place requires both a read and a write function");
+        return EXR_ERR_INVALID_ARGUMENT;
+    }
+
+    if (filename && filename[0] != '\0')
+    {
+        rv = internal_exr_alloc_context (
+            &ret,
+            &inits,
+            EXR_CONTEXT_UPDATE_HEADER,
+            sizeof (struct _internal_exr_filehandle));
+        if (rv == EXR_ERR_SUCCESS)
+        {
+            ret->do_read  = &dispatch_read;
+            ret->do_write = &dispatch_write;
+
+            rv = exr_attr_string_create (
+                (exr_context_t) ret, &(ret->filename), filename);
+            if (rv == EXR_ERR_SUCCESS)
+            {
+                if (!inits.read_fn)
+                {
+                    inits.size_fn = &default_query_size_func;
+                    rv            = default_init_update_file (ret);
+                }
+
+                if (rv == EXR_ERR_SUCCESS)
+                    rv = process_query_size (ret, &inits);
+                if (rv == EXR_ERR_SUCCESS) rv = internal_exr_parse_header (ret);
+            }
+
+            if (rv != EXR_ERR_SUCCESS) exr_finish ((exr_context_t*) &ret);
+        }
+        else
+            rv = EXR_ERR_OUT_OF_MEMORY;
+    }
+    else
+    {
+        inits.error_handler_fn (
+            NULL,
+            EXR_ERR_INVALID_ARGUMENT,
+            "Invalid filename passed to start_inplace_header_update function");
+        rv = EXR_ERR_INVALID_ARGUMENT;
+    }
+
+    *ctxt = (exr_context_t) ret;
+    return rv;
 }
 
 /**************************************/
@@ -632,6 +707,38 @@ exr_set_longname_support (exr_context_t ctxt, int onoff)
 
 /**************************************/
 
+/* The header of a file that is being updated in place is written
+ * back only if it is still exactly as large as it was in the file,
+ * since the chunk offset tables follow it directly */
+static exr_result_t
+rewrite_header_in_place (exr_context_t ctxt)
+{
+    exr_result_t rv;
+    uint64_t     hdrsize = ctxt->parts[0]->chunk_table_offset;
+
+    ctxt->do_write           = &dispatch_measure_write;
+    ctxt->output_file_offset = 0;
+
+    rv = internal_exr_write_header (ctxt);
+
+    ctxt->do_write = &dispatch_write;
+    if (rv != EXR_ERR_SUCCESS) return rv;
+
+    if (ctxt->output_file_offset != hdrsize)
+        return ctxt->print_error (
+            ctxt,
+            EXR_ERR_MODIFY_SIZE_CHANGE,
+            "Updated header is %" PRIu64
+            " bytes, but there are %" PRIu64 " bytes for it in the file",
+            ctxt->output_file_offset,
+            hdrsize);
+
+    ctxt->output_file_offset = 0;
+    return internal_exr_write_header (ctxt);
+}
+
+/**************************************/
+
 exr_result_t
 exr_write_header (exr_context_t ctxt)
 {
@@ -640,6 +747,9 @@ exr_write_header (exr_context_t ctxt)
     if (!ctxt) return EXR_ERR_MISSING_CONTEXT_ARG;
     internal_exr_lock (ctxt);
 
+    if (ctxt->mode == EXR_CONTEXT_UPDATE_HEADER)
+        return EXR_UNLOCK_AND_RETURN (rewrite_header_in_place (ctxt));
+
     if (ctxt->mode != EXR_CONTEXT_WRITE)
         return EXR_UNLOCK_AND_RETURN (
             ctxt->standard_error (ctxt, EXR_ERR_NOT_OPEN_WRITE));
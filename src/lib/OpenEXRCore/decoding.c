@@ -9,6 +9,7 @@
 
 #include "internal_coding.h"
 #include "internal_decompress.h"
+#include "internal_simd.h"
 #include "internal_structs.h"
 #include "internal_xdr.h"
 
@@ -211,6 +212,76 @@ default_read_chunk (exr_decode_pipeline_t* decode)
     return rv;
 }
 
+/*
+ * Checks one line of a cumulative sample count table (n, n+m,
+ * n+m+o, ...) is non-decreasing, returning the line total or -1 if
+ * not. If individual is set, the line is converted in place to the
+ * individual counts (n, m, o, ...). The check compares the counts
+ * themselves, as the difference of two counts from a corrupt table
+ * may wrap around; differences are only meaningful once the line is
+ * known to be valid.
+ */
+static int32_t
+unpack_sample_line (int32_t* line, int32_t w, int individual)
+{
+    int32_t x = 0, prevsamp = 0;
+
+    /* the vector loops read the table as is, so only little endian */
+#if defined(IMF_HAVE_SSE2) && !EXR_HOST_IS_NOT_LITTLE_ENDIAN
+    __m128i vprev = _mm_setzero_si128 ();
+    __m128i vbad  = _mm_setzero_si128 ();
+
+    for (; x + 4 <= w; x += 4)
+    {
+        __m128i cur = _mm_loadu_si128 ((const __m128i*) (line + x));
+        /* (prev[3], cur[0], cur[1], cur[2]) */
+        __m128i sh = _mm_or_si128 (
+            _mm_slli_si128 (cur, 4), _mm_srli_si128 (vprev, 12));
+
+        vbad = _mm_or_si128 (vbad, _mm_cmpgt_epi32 (sh, cur));
+        if (individual)
+            _mm_storeu_si128 ((__m128i*) (line + x), _mm_sub_epi32 (cur, sh));
+        vprev = cur;
+    }
+    if (x > 0)
+    {
+        if (_mm_movemask_epi8 (vbad)) return -1;
+        prevsamp = _mm_cvtsi128_si32 (_mm_srli_si128 (vprev, 12));
+    }
+#elif defined(IMF_HAVE_NEON_AARCH64) && !EXR_HOST_IS_NOT_LITTLE_ENDIAN
+    int32x4_t  vprev = vdupq_n_s32 (0);
+    uint32x4_t vbad  = vdupq_n_u32 (0);
+
+    for (; x + 4 <= w; x += 4)
+    {
+        int32x4_t cur  = vld1q_s32 (line + x);
+        int32x4_t prev = vextq_s32 (vprev, cur, 3);
+
+        vbad = vorrq_u32 (vbad, vcltq_s32 (cur, prev));
+        if (individual) vst1q_s32 (line + x, vsubq_s32 (cur, prev));
+        vprev = cur;
+    }
+    if (x > 0)
+    {
+        if (vmaxvq_u32 (vbad)) return -1;
+        prevsamp = vgetq_lane_s32 (vprev, 3);
+    }
+#endif
+
+    for (; x < w; ++x)
+    {
+        int32_t nsamps = (int32_t) one_to_native32 ((uint32_t) line[x]);
+
+        /* not monotonic, violation */
+        if (nsamps < prevsamp) return -1;
+
+        line[x]  = individual ? nsamps - prevsamp : nsamps;
+        prevsamp = nsamps;
+    }
+
+    return prevsamp;
+}
+
 static exr_result_t
 unpack_sample_table (exr_const_context_t ctxt, exr_decode_pipeline_t* decode)
 {
@@ -220,51 +291,23 @@ unpack_sample_table (exr_const_context_t ctxt, exr_decode_pipeline_t* decode)
     uint64_t     totsamp      = 0;
     int32_t*     samptable    = decode->sample_count_table;
     size_t       combSampSize = 0;
+    int          individual   = 0;
 
     for (int c = 0; c < decode->channel_count; ++c)
         combSampSize += ((size_t) decode->channels[c].bytes_per_element);
 
     if ((decode->decode_flags & EXR_DECODE_SAMPLE_COUNTS_AS_INDIVIDUAL))
-    {
-        for (int32_t y = 0; y < h; ++y)
-        {
-            int32_t* cursampline = samptable + y * w;
-            int32_t  prevsamp    = 0;
-            for (int32_t x = 0; x < w; ++x)
-            {
-                int32_t nsamps =
-                    (int32_t) one_to_native32 ((uint32_t) cursampline[x]);
-                // not monotonic, violation
-                if (nsamps < prevsamp) return EXR_ERR_INVALID_SAMPLE_DATA;
-                cursampline[x] = nsamps - prevsamp;
-                prevsamp       = nsamps;
-            }
-            totsamp += (uint64_t) prevsamp;
-        }
-        if (totsamp >= (uint64_t) INT32_MAX) return EXR_ERR_INVALID_SAMPLE_DATA;
-        samptable[w * h] = (int32_t) totsamp;
-    }
-    else
-    {
-        for (int32_t y = 0; y < h; ++y)
-        {
-            int32_t* cursampline = samptable + y * w;
-            int32_t  prevsamp    = 0;
-            for (int32_t x = 0; x < w; ++x)
-            {
-                int32_t nsamps =
-                    (int32_t) one_to_native32 ((uint32_t) cursampline[x]);
-                // not monotonic, violation
-                if (nsamps < prevsamp) return EXR_ERR_INVALID_SAMPLE_DATA;
+        individual = 1;
 
-                cursampline[x] = nsamps;
-                prevsamp       = nsamps;
-            }
-
-            totsamp += (uint64_t) prevsamp;
-        }
-        if (totsamp >= (uint64_t) INT32_MAX) return EXR_ERR_INVALID_SAMPLE_DATA;
+    for (int32_t y = 0; y < h; ++y)
+    {
+        int32_t linesamps =
+            unpack_sample_line (samptable + y * w, w, individual);
+        if (linesamps < 0) return EXR_ERR_INVALID_SAMPLE_DATA;
+        totsamp += (uint64_t) linesamps;
     }
+    if (totsamp >= (uint64_t) INT32_MAX) return EXR_ERR_INVALID_SAMPLE_DATA;
+    if (individual) samptable[w * h] = (int32_t) totsamp;
 
     if ((totsamp * combSampSize) > decode->chunk.unpacked_size)
     {
@@ -538,6 +581,95 @@ exr_decoding_update (
 
 /**************************************/
 
+exr_result_t
+exr_decoding_rebind (
+    exr_const_context_t     ctxt,
+    int                     part_index,
+    const exr_chunk_info_t* cinfo,
+    exr_decode_pipeline_t*  decode)
+{
+    exr_result_t          rv;
+    exr_const_context_t   prevctxt;
+    exr_const_priv_part_t part, prevpart;
+    exr_attr_chlist_t *   chans, *prevchans;
+
+    if (!ctxt) return EXR_ERR_MISSING_CONTEXT_ARG;
+    if (part_index < 0 || part_index >= ctxt->num_parts)
+        return EXR_ERR_ARGUMENT_OUT_OF_RANGE;
+
+    if (!cinfo || !decode)
+        return ctxt->standard_error (ctxt, EXR_ERR_INVALID_ARGUMENT);
+
+    prevctxt = decode->context;
+    if (!prevctxt || !decode->read_fn || decode->part_index < 0 ||
+        decode->part_index >= prevctxt->num_parts)
+        return ctxt->report_error (
+            ctxt,
+            EXR_ERR_INVALID_ARGUMENT,
+            "Request to rebind a decode pipeline which has not been initialized");
+
+    if (prevctxt == ctxt && decode->part_index == part_index)
+        return exr_decoding_update (ctxt, part_index, cinfo, decode);
+
+    if (ctxt->mode != EXR_CONTEXT_READ)
+        return ctxt->standard_error (ctxt, EXR_ERR_NOT_OPEN_READ);
+
+    if (ctxt->alloc_fn != prevctxt->alloc_fn ||
+        ctxt->free_fn != prevctxt->free_fn)
+        return ctxt->report_error (
+            ctxt,
+            EXR_ERR_INVALID_ARGUMENT,
+            "Unable to rebind decode pipeline between contexts with different allocators");
+
+    part     = ctxt->parts[part_index];
+    prevpart = prevctxt->parts[decode->part_index];
+
+    if (!part->channels || part->channels->type != EXR_ATTR_CHLIST)
+        return EXR_ERR_INVALID_ATTR;
+
+    chans     = part->channels->chlist;
+    prevchans = prevpart->channels->chlist;
+
+    if (part->storage_mode != prevpart->storage_mode ||
+        part->comp_type != prevpart->comp_type ||
+        chans->num_channels != prevchans->num_channels ||
+        chans->num_channels != decode->channel_count)
+        return ctxt->report_error (
+            ctxt,
+            EXR_ERR_INVALID_ARGUMENT,
+            "Unable to rebind decode pipeline to a part with a different layout");
+
+    for (int c = 0; c < chans->num_channels; ++c)
+    {
+        const exr_attr_chlist_entry_t* curc  = chans->entries + c;
+        const exr_attr_chlist_entry_t* prevc = prevchans->entries + c;
+
+        if (curc->pixel_type != prevc->pixel_type ||
+            curc->x_sampling != prevc->x_sampling ||
+            curc->y_sampling != prevc->y_sampling ||
+            curc->name.length != prevc->name.length ||
+            strcmp (curc->name.str, prevc->name.str))
+            return ctxt->print_error (
+                ctxt,
+                EXR_ERR_INVALID_ARGUMENT,
+                "Unable to rebind decode pipeline, channel %d (%s) differs",
+                c,
+                curc->name.str);
+    }
+
+    rv = internal_coding_update_channel_info (
+        decode->channels, decode->channel_count, cinfo, ctxt, part);
+    if (rv == EXR_ERR_SUCCESS)
+    {
+        decode->context    = ctxt;
+        decode->part_index = part_index;
+        decode->chunk      = *cinfo;
+    }
+    return rv;
+}
+
+/**************************************/
+
 exr_result_t
 exr_decoding_run (
     exr_const_context_t ctxt, int part_index, exr_decode_pipeline_t* decode)
@@ -726,3 +858,68 @@ exr_decoding_destroy (exr_const_context_t ctxt, exr_decode_pipeline_t* decode)
     }
     return EXR_ERR_SUCCESS;
 }
+
+/**************************************/
+
+exr_result_t
+exr_read_deep_sample_counts (
+    exr_const_context_t     ctxt,
+    int                     part_index,
+    const exr_chunk_info_t* cinfo,
+    int32_t*                sample_counts,
+    uint64_t*               total_samples)
+{
+    exr_result_t          rv;
+    exr_decode_pipeline_t decode = EXR_DECODE_PIPELINE_INITIALIZER;
+    exr_const_priv_part_t part;
+    size_t                npix;
+
+    if (!ctxt) return EXR_ERR_MISSING_CONTEXT_ARG;
+
+    if (!cinfo) return ctxt->standard_error (ctxt, EXR_ERR_INVALID_ARGUMENT);
+
+    if (part_index < 0 || part_index >= ctxt->num_parts)
+        return ctxt->print_error (
+            ctxt,
+            EXR_ERR_ARGUMENT_OUT_OF_RANGE,
+            "Part index (%d) out of range",
+            part_index);
+
+    part = ctxt->parts[part_index];
+    if (part->storage_mode != EXR_STORAGE_DEEP_SCANLINE &&
+        part->storage_mode != EXR_STORAGE_DEEP_TILED)
+        return ctxt->report_error (
+            ctxt,
+            EXR_ERR_INVALID_ARGUMENT,
+            "Request for sample counts of a part which is not deep");
+
+    rv = exr_decoding_initialize (ctxt, part_index, cinfo, &decode);
+    if (rv != EXR_ERR_SUCCESS) return rv;
+
+    /*
+     * the default read routine only fetches the sample count table in
+     * this mode, and the decompressor stops once that is unpacked
+     */
+    decode.decode_flags = EXR_DECODE_SAMPLE_COUNTS_AS_INDIVIDUAL |
+                          EXR_DECODE_SAMPLE_DATA_ONLY;
+    decode.read_fn = &default_read_chunk;
+    if (part->comp_type != EXR_COMPRESSION_NONE)
+        decode.decompress_fn = &exr_uncompress_chunk;
+
+    rv = exr_decoding_run (ctxt, part_index, &decode);
+    if (rv == EXR_ERR_SUCCESS)
+    {
+        npix = ((size_t) decode.chunk.width) * ((size_t) decode.chunk.height);
+
+        if (sample_counts)
+            memcpy (
+                sample_counts,
+                decode.sample_count_table,
+                npix * sizeof (int32_t));
+        if (total_samples)
+            *total_samples = (uint64_t) decode.sample_count_table[npix];
+    }
+
+    exr_decoding_destroy (ctxt, &decode);
+    return rv;
+}
@@ -401,6 +401,43 @@ default_init_write_file (exr_context_t file)
 
 /**************************************/
 
+static exr_result_t
+default_init_update_file (exr_context_t file)
+{
+    int                              fd;
+    struct _internal_exr_filehandle* fh = file->user_data;
+
+    fh->fd = -1;
+#if !CAN_USE_PREAD
+#    ifdef ILMTHREAD_THREADING_ENABLED
+    fd = pthread_mutex_init (&(fh->mutex), NULL);
+    if (fd != 0)
+        return file->print_error (
+            file,
+            EXR_ERR_OUT_OF_MEMORY,
+            "Unable to initialize file mutex: %s",
+            strerror (fd));
+#    endif
+#endif
+
+    file->destroy_fn = &default_shutdown;
+    file->read_fn    = &default_read_func;
+    file->write_fn   = &default_write_func;
+
+    fd = open (file->filename.str, O_RDWR | O_CLOEXEC);
+    if (fd < 0)
+        return file->print_error (
+            file,
+            EXR_ERR_FILE_ACCESS,
+            "Unable to open file for update: %s",
+            strerror (errno));
+
+    fh->fd = fd;
+    return EXR_ERR_SUCCESS;
+}
+
+/**************************************/
+
 static int64_t
 default_query_size_func (exr_const_context_t ctxt, void* userdata)
 {
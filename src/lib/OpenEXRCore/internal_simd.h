@@ -0,0 +1,29 @@
+/*
+** SPDX-License-Identifier: BSD-3-Clause
+** Copyright Contributors to the OpenEXR Project.
+*/
+
+#ifndef OPENEXR_PRIVATE_SIMD_H
+#define OPENEXR_PRIVATE_SIMD_H
+
+/*
+ * Compile time SIMD support for the core coding routines. These
+ * only tell what the compiler targets, no runtime check is done
+ * (see internal_cpuid.h for that). The DWA code has its own set in
+ * internal_dwa_simd.h.
+ */
+#if defined __SSE2__ || (_MSC_VER >= 1300 && (_M_IX86 || _M_X64))
+#    define IMF_HAVE_SSE2 1
+#    include <emmintrin.h>
+#    include <mmintrin.h>
+#endif
+#if defined __SSE4_1__
+#    define IMF_HAVE_SSE4_1 1
+#    include <smmintrin.h>
+#endif
+#if defined(__aarch64__)
+#    define IMF_HAVE_NEON_AARCH64 1
+#    include <arm_neon.h>
+#endif
+
+#endif /* OPENEXR_PRIVATE_SIMD_H */
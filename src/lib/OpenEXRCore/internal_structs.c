@@ -396,6 +396,8 @@ internal_exr_alloc_context (
              EXR_CONTEXT_FLAG_DISABLE_CHUNK_RECONSTRUCTION);
         ret->legacy_header =
             (initializers->flags & EXR_CONTEXT_FLAG_WRITE_LEGACY_HEADER);
+        if (initializers->flags & EXR_CONTEXT_FLAG_TAIL_FOLLOW)
+            ret->tail_follow = 1;
 
         ret->file_size       = -1;
         ret->max_name_length = EXR_SHORTNAME_MAXLEN;
@@ -186,8 +186,9 @@ struct _priv_exr_context_t
     void*                         user_data;
     exr_destroy_stream_func_ptr_t destroy_fn;
 
-    int64_t             file_size;
-    exr_read_func_ptr_t read_fn;
+    int64_t                   file_size;
+    exr_read_func_ptr_t       read_fn;
+    exr_query_size_func_ptr_t size_fn;
 
     exr_write_func_ptr_t write_fn;
     /* used when writing under a mutex, is there a better way? */
@@ -217,7 +218,8 @@ struct _priv_exr_context_t
 #endif
     uint8_t disable_chunk_reconstruct;
     uint8_t legacy_header;
-    uint8_t _pad[2];
+    uint8_t tail_follow;
+    uint8_t _pad[1];
     uint32_t orig_version_and_flags;
 };
 
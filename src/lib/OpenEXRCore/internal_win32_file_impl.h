@@ -385,6 +385,55 @@ default_init_write_file (exr_context_t file)
 
 /**************************************/
 
+static exr_result_t
+default_init_update_file (exr_context_t file)
+{
+    wchar_t*                         wcFn = NULL;
+    HANDLE                           fd;
+    struct _internal_exr_filehandle* fh = file->user_data;
+
+    fh->fd           = INVALID_HANDLE_VALUE;
+    file->destroy_fn = &default_shutdown;
+    file->read_fn    = &default_read_func;
+    file->write_fn   = &default_write_func;
+
+    wcFn = widen_filename (file, file->filename.str);
+    if (wcFn)
+    {
+#if defined(_WIN32_WINNT) && (_WIN32_WINNT >= _WIN32_WINNT_WIN8)
+        fd = CreateFile2 (
+            wcFn,
+            GENERIC_READ | GENERIC_WRITE,
+            FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+            OPEN_EXISTING,
+            NULL);
+#else
+        fd = CreateFileW (
+            wcFn,
+            GENERIC_READ | GENERIC_WRITE,
+            FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+            NULL,
+            OPEN_EXISTING,
+            FILE_ATTRIBUTE_NORMAL, /* TBD: use overlapped? | FILE_FLAG_OVERLAPPED */
+            NULL);
+#endif
+        file->free_fn (wcFn);
+
+        if (fd == INVALID_HANDLE_VALUE)
+            return print_error (
+                file, EXR_ERR_FILE_ACCESS, "Unable to open file for update");
+    }
+    else
+        return print_error (
+            file, EXR_ERR_OUT_OF_MEMORY, "Unable to allocate unicode filename");
+
+    fh->fd = fd;
+
+    return EXR_ERR_SUCCESS;
+}
+
+/**************************************/
+
 static int64_t
 default_query_size_func (exr_const_context_t ctxt, void* userdata)
 {
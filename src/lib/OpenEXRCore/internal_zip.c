@@ -7,6 +7,7 @@
 #include "internal_decompress.h"
 
 #include "internal_coding.h"
+#include "internal_simd.h"
 #include "internal_structs.h"
 
 #include <limits.h>
@@ -15,20 +16,6 @@
 
 #include "openexr_compression.h"
 
-#if defined __SSE2__ || (_MSC_VER >= 1300 && (_M_IX86 || _M_X64))
-#    define IMF_HAVE_SSE2 1
-#    include <emmintrin.h>
-#    include <mmintrin.h>
-#endif
-#if defined __SSE4_1__
-#    define IMF_HAVE_SSE4_1 1
-#    include <smmintrin.h>
-#endif
-#if defined(__aarch64__)
-#    define IMF_HAVE_NEON_AARCH64 1
-#    include <arm_neon.h>
-#endif
-
 /**************************************/
 
 #ifdef IMF_HAVE_SSE4_1
@@ -374,7 +361,9 @@ apply_zip_impl (exr_encode_pipeline_t* encode)
 
     if (rv == EXR_ERR_SUCCESS)
     {
-        if (compbufsz > encode->packed_bytes)
+        /* readers take a chunk as large as its raw data to be stored
+         * raw, so fall back to that on a tie as well, as RLE does */
+        if (compbufsz >= encode->packed_bytes)
         {
             memcpy (
                 encode->compressed_buffer,
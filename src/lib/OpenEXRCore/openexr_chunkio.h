@@ -115,6 +115,33 @@ exr_result_t exr_read_deep_chunk (
     void*                   packed_data,
     void*                   sample_data);
 
+/** Re-read the chunk table of a file which is still being written.
+ *
+ * Queries the current file size (if the context has a size function)
+ * and re-reads the chunk offset table for the part, keeping the
+ * entries which now point at complete chunks inside the file, that is,
+ * chunks whose leader and packed data end before the end of the file.
+ * Other entries are considered not yet written and reading those chunks
+ * returns \ref EXR_ERR_INCOMPLETE_CHUNK_TABLE. Besides the offset table,
+ * this only reads the leaders of chunks which appeared since the previous
+ * call, and is meant to be called repeatedly on contexts opened with
+ * \ref EXR_CONTEXT_FLAG_TAIL_FOLLOW.
+ *
+ * @p num_available receives the number of chunks in the part which
+ * are available. If @p available is not NULL, it must point to (at
+ * least) the chunk count of the part entries, and is set to 1 for
+ * each available chunk and 0 otherwise.
+ *
+ * Updates the table in place, so must not be called while other
+ * threads are reading chunks of the same context.
+ */
+EXR_EXPORT
+exr_result_t exr_refresh_chunk_table (
+    exr_const_context_t ctxt,
+    int                 part_index,
+    int32_t*            num_available,
+    uint8_t*            available);
+
 /**************************************/
 
 /** Initialize a \c exr_chunk_info_t structure when encoding scanline
@@ -350,6 +350,17 @@ typedef struct _exr_context_initializer_v3
 /** @brief Writes an old-style, sorted header with minimal information */
 #define EXR_CONTEXT_FLAG_WRITE_LEGACY_HEADER (1 << 3)
 
+/** @brief Reads a file which may still be in the process of being written
+ *
+ * Chunk table entries which are zero or point past the current end of
+ * the file are treated as chunks which have not been written yet:
+ * reading them returns \ref EXR_ERR_INCOMPLETE_CHUNK_TABLE instead of
+ * triggering the chunk table reconstruction logic. Use
+ * \ref exr_refresh_chunk_table to pick up chunks written since the
+ * file was opened. This is only valid for reading contexts
+ */
+#define EXR_CONTEXT_FLAG_TAIL_FOLLOW (1 << 4)
+
 /* clang-format off */
 /** @brief Simple macro to initialize the context initializer with default values. */
 #define EXR_DEFAULT_CONTEXT_INITIALIZER                                        \
@@ -457,9 +468,19 @@ EXR_EXPORT exr_result_t exr_start_write (
  * metadata entry, although not to change the size of the header, or
  * any of the image data.
  *
+ * The header of the file is read as by exr_start_read(). Existing
+ * attributes may then be given new values of the same size using the
+ * attribute setters; adding attributes, or changing the size of one,
+ * fails with \c EXR_ERR_NO_ATTR_BY_NAME or \c EXR_ERR_MODIFY_SIZE_CHANGE.
+ * exr_write_header() writes the modified header back over the old
+ * one, but only if its size is unchanged, otherwise it returns
+ * \c EXR_ERR_MODIFY_SIZE_CHANGE and the file is not modified. The
+ * attributes keep the order in which they are stored in the file.
+ *
  * If you have custom I/O requirements, see the initializer context
  * documentation \ref exr_context_initializer_t. The @p ctxtdata parameter
- * is optional, if `NULL`, default values will be used.
+ * is optional, if `NULL`, default values will be used. A custom read
+ * function requires a custom write function, and vice versa.
  */
 EXR_EXPORT exr_result_t exr_start_inplace_header_update (
     exr_context_t*                   ctxt,
@@ -557,6 +578,9 @@ exr_set_longname_support (exr_context_t ctxt, int onoff);
  * It will recompute the number of chunks that will be written, and
  * reset the chunk offsets. If you modify file attributes or part
  * information after a call to this, it will error.
+ *
+ * For a context created by exr_start_inplace_header_update(), this
+ * writes the modified header back to the file instead; see there.
  */
 EXR_EXPORT exr_result_t exr_write_header (exr_context_t ctxt);
 
@@ -312,6 +312,31 @@ exr_result_t exr_decoding_update (
     const exr_chunk_info_t* cinfo,
     exr_decode_pipeline_t*  decode);
 
+/** Re-target a decode pipeline at a part of a different context.
+ *
+ * The pipeline must have been initialized and had its routines
+ * chosen (either by exr_decoding_choose_default_routines() or by
+ * the caller) against a context which is still open. The new part
+ * must have the same storage type, compression and channel list
+ * (names, types and sampling) as the one the pipeline was set up
+ * for, and both contexts must use the same memory allocator.
+ *
+ * On success, the pipeline refers to the new context and chunk, and
+ * keeps its previously chosen routines and intermediate buffers, so
+ * a sequence of files with identical layouts can be read without
+ * paying for routine selection or buffer allocation on each file.
+ * The previous context may then be closed.
+ *
+ * On failure, the pipeline is left untouched and still refers to
+ * the previous context.
+ */
+EXR_EXPORT
+exr_result_t exr_decoding_rebind (
+    exr_const_context_t     ctxt,
+    int                     part_index,
+    const exr_chunk_info_t* cinfo,
+    exr_decode_pipeline_t*  decode);
+
 /** Execute the decoding pipeline. */
 EXR_EXPORT
 exr_result_t exr_decoding_run (
@@ -327,6 +352,32 @@ EXR_EXPORT
 exr_result_t
 exr_decoding_destroy (exr_const_context_t ctxt, exr_decode_pipeline_t* decode);
 
+/** Read only the sample count table of a deep chunk.
+ *
+ * This is a shortcut for tools which only need deep statistics
+ * (memory budgets, sample count heatmaps, etc.): the packed sample
+ * count table is read from the chunk's sample_count_data_offset and
+ * decompressed, but the sample data itself is never read from the
+ * file.
+ *
+ * If sample_counts is not `NULL`, it must point to cinfo->width *
+ * cinfo->height values, and receives the individual (not cumulative)
+ * sample count of each pixel of the chunk, row by row. If
+ * total_samples is not `NULL`, it receives the total number of
+ * samples in the chunk.
+ *
+ * As with the other chunk reading routines, this is safe to call
+ * from multiple threads at once for different chunks of the same
+ * context.
+ */
+EXR_EXPORT
+exr_result_t exr_read_deep_sample_counts (
+    exr_const_context_t     ctxt,
+    int                     part_index,
+    const exr_chunk_info_t* cinfo,
+    int32_t*                sample_counts,
+    uint64_t*               total_samples);
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
@@ -54,6 +54,8 @@ struct _internal_exr_seq_scratch
     uint64_t curpos;
     int64_t  navail;
     uint64_t fileoff;
+    uint64_t bufsize;
+    int      nfills;
 
     exr_result_t (*sequential_read) (
         struct _internal_exr_seq_scratch*, void*, uint64_t);
@@ -79,7 +81,59 @@ scratch_attr_too_big (struct _internal_exr_seq_scratch* scr, int32_t attrsz)
     return 0;
 }
 
-#define SCRATCH_BUFFER_SIZE 4096
+/* the header is read in spans which start at SCRATCH_BUFFER_SIZE and
+ * double every time the header turns out not to fit, up to
+ * SCRATCH_BUFFER_MAX_SIZE, so large headers (previews, manifests,
+ * long string vectors) take a handful of reads instead of one per
+ * page */
+#define SCRATCH_BUFFER_SIZE 16384
+#define SCRATCH_BUFFER_MAX_SIZE (1024 * 1024)
+
+static exr_result_t
+scratch_refill (struct _internal_exr_seq_scratch* scr)
+{
+    exr_context_t ctxt   = scr->ctxt;
+    int64_t       nread  = 0;
+    uint64_t      toread = scr->bufsize;
+    exr_result_t  rv;
+
+    if (scr->nfills > 0 && scr->bufsize < SCRATCH_BUFFER_MAX_SIZE)
+    {
+        uint8_t* bigger = ctxt->alloc_fn (scr->bufsize * 2);
+        if (bigger)
+        {
+            ctxt->free_fn (scr->scratch);
+            scr->scratch = bigger;
+            scr->bufsize *= 2;
+            toread = scr->bufsize;
+        }
+    }
+    ++(scr->nfills);
+
+    /* no point asking for more than the file has left */
+    if (ctxt->file_size > 0 && scr->fileoff < (uint64_t) ctxt->file_size &&
+        toread > ((uint64_t) ctxt->file_size - scr->fileoff))
+        toread = (uint64_t) ctxt->file_size - scr->fileoff;
+
+    rv = ctxt->do_read (
+        ctxt,
+        scr->scratch,
+        toread,
+        &(scr->fileoff),
+        &nread,
+        EXR_ALLOW_SHORT_READ);
+    if (nread > 0)
+    {
+        scr->navail = nread;
+        scr->curpos = 0;
+    }
+    else if (nread == 0)
+    {
+        rv = ctxt->report_error (
+            ctxt, EXR_ERR_READ_IO, "End of file attempting to read header");
+    }
+    return rv;
+}
 
 static exr_result_t
 scratch_seq_read (struct _internal_exr_seq_scratch* scr, void* buf, uint64_t sz)
@@ -103,7 +157,7 @@ scratch_seq_read (struct _internal_exr_seq_scratch* scr, void* buf, uint64_t sz)
             outbuf += nCopy;
             nCopied += nCopy;
         }
-        else if (notdone > SCRATCH_BUFFER_SIZE)
+        else if (notdone > scr->bufsize)
         {
             uint64_t nPages  = notdone / SCRATCH_BUFFER_SIZE;
             int64_t  nread   = 0;
@@ -125,28 +179,8 @@ scratch_seq_read (struct _internal_exr_seq_scratch* scr, void* buf, uint64_t sz)
         }
         else
         {
-            int64_t nread = 0;
-            rv            = scr->ctxt->do_read (
-                scr->ctxt,
-                scr->scratch,
-                SCRATCH_BUFFER_SIZE,
-                &(scr->fileoff),
-                &nread,
-                EXR_ALLOW_SHORT_READ);
-            if (nread > 0)
-            {
-                scr->navail = nread;
-                scr->curpos = 0;
-            }
-            else
-            {
-                if (nread == 0)
-                    rv = scr->ctxt->report_error (
-                        scr->ctxt,
-                        EXR_ERR_READ_IO,
-                        "End of file attempting to read header");
-                break;
-            }
+            rv = scratch_refill (scr);
+            if (scr->navail <= 0) break;
         }
     }
     if (rv == -1)
@@ -178,30 +212,26 @@ scratch_seq_skip (struct _internal_exr_seq_scratch* scr, int32_t sz)
             notdone -= nCopy;
             nCopied += nCopy;
         }
-        else
+        else if (scr->ctxt->file_size > 0)
         {
-            int64_t nread = 0;
-            rv            = scr->ctxt->do_read (
-                scr->ctxt,
-                scr->scratch,
-                SCRATCH_BUFFER_SIZE,
-                &(scr->fileoff),
-                &nread,
-                EXR_ALLOW_SHORT_READ);
-            if (nread > 0)
-            {
-                scr->navail = nread;
-                scr->curpos = 0;
-            }
-            else
+            /* the stream has a size, so reads may jump: skip the rest
+             * instead of reading it */
+            if (scr->fileoff + notdone > (uint64_t) scr->ctxt->file_size)
             {
-                if (nread == 0)
-                    rv = scr->ctxt->report_error (
-                        scr->ctxt,
-                        EXR_ERR_READ_IO,
-                        "End of file attempting to read header");
+                rv = scr->ctxt->report_error (
+                    scr->ctxt,
+                    EXR_ERR_READ_IO,
+                    "End of file attempting to read header");
                 break;
             }
+            scr->fileoff += notdone;
+            nCopied += notdone;
+            notdone = 0;
+        }
+        else
+        {
+            rv = scratch_refill (scr);
+            if (scr->navail <= 0) break;
         }
     }
     if (rv == -1)
@@ -223,6 +253,8 @@ priv_init_scratch (
     scr->curpos          = 0;
     scr->navail          = 0;
     scr->fileoff         = offset;
+    scr->bufsize         = SCRATCH_BUFFER_SIZE;
+    scr->nfills          = 0;
     scr->sequential_read = &scratch_seq_read;
     scr->sequential_skip = &scratch_seq_skip;
     scr->ctxt            = ctxt;
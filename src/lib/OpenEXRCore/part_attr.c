@@ -1971,8 +1971,12 @@ exr_attr_set_string (
                 "'%s' requested type 'string', but attribute is type '%s'",
                 name,
                 attr->type_name));
+        /* a string read from a file that is updated in place is
+         * stored along with its attribute, so it can be overwritten
+         * even though it was not allocated separately */
         if (attr->string->length == (int32_t) bytes &&
-            attr->string->alloc_size > 0)
+            (attr->string->alloc_size > 0 ||
+             ctxt->mode == EXR_CONTEXT_UPDATE_HEADER))
         {
             if (val)
                 memcpy (EXR_CONST_CAST (void*, attr->string->str), val, bytes);
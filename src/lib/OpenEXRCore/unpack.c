@@ -1395,6 +1395,185 @@ generic_unpack_deep (exr_decode_pipeline_t* decode)
     return EXR_ERR_SUCCESS;
 }
 
+/*
+ * Specialized deep unpackers, for when every channel to be filled
+ * either keeps its type or goes from half to float, with the samples
+ * packed at their natural size. A channel's samples for one line are
+ * stored back to back in the unpacked buffer, so can be moved as a
+ * whole run instead of sample by sample.
+ */
+
+static inline exr_result_t
+unpack_deep_run (
+    const exr_coding_channel_info_t* decc,
+    uint8_t*                         cdata,
+    const uint8_t*                   srcbuffer,
+    int32_t                          samps)
+{
+    int ubpc = decc->user_bytes_per_element;
+
+    if (samps <= 0) return EXR_ERR_SUCCESS;
+
+    if (decc->data_type == decc->user_data_type &&
+        ubpc == decc->bytes_per_element)
+    {
+        memcpy (cdata, srcbuffer, ((size_t) samps) * ((size_t) ubpc));
+        return EXR_ERR_SUCCESS;
+    }
+
+    if (decc->data_type == EXR_PIXEL_HALF &&
+        decc->user_data_type == EXR_PIXEL_FLOAT && ubpc == 4)
+    {
+        half_to_float_buffer (
+            (float*) cdata, (const uint16_t*) srcbuffer, samps);
+        return EXR_ERR_SUCCESS;
+    }
+
+    /* the frame buffer changed since the routine was chosen */
+    UNPACK_SAMPLES (samps)
+    return EXR_ERR_SUCCESS;
+}
+
+static inline int32_t
+deep_line_samples (
+    const exr_decode_pipeline_t* decode, const int32_t* sampbuffer)
+{
+    int32_t w = decode->chunk.width;
+    int32_t n = 0;
+
+    if (w <= 0) return 0;
+    if (0 ==
+        (decode->decode_flags & EXR_DECODE_SAMPLE_COUNTS_AS_INDIVIDUAL))
+        return sampbuffer[w - 1];
+    for (int32_t x = 0; x < w; ++x)
+        n += sampbuffer[x];
+    return n;
+}
+
+static exr_result_t
+unpack_deep_runs (exr_decode_pipeline_t* decode)
+{
+    const uint8_t* srcbuffer  = decode->unpacked_buffer;
+    const int32_t* sampbuffer = decode->sample_count_table;
+    int            h, uls;
+    size_t         totsamps = 0;
+
+    h   = decode->chunk.height - decode->user_line_end_ignore;
+    uls = decode->user_line_begin_skip;
+
+    for (int y = 0; y < h; ++y)
+    {
+        int32_t linesamps = deep_line_samples (decode, sampbuffer);
+
+        for (int c = 0; c < decode->channel_count; ++c)
+        {
+            exr_coding_channel_info_t* decc = (decode->channels + c);
+            uint8_t*                   cdata = decc->decode_to_ptr;
+
+            if (cdata)
+            {
+                exr_result_t rv = unpack_deep_run (
+                    decc,
+                    cdata + totsamps * ((size_t) decc->user_bytes_per_element),
+                    srcbuffer,
+                    linesamps);
+                if (rv != EXR_ERR_SUCCESS) return rv;
+            }
+
+            srcbuffer +=
+                ((size_t) decc->bytes_per_element) * ((size_t) linesamps);
+        }
+        if (y >= uls) totsamps += (size_t) linesamps;
+        sampbuffer += decode->chunk.width;
+    }
+
+    return EXR_ERR_SUCCESS;
+}
+
+/*
+ * The pointer form. Where the per-pixel pointers of a line follow on
+ * from each other, as when they were handed out of one block by an
+ * arena allocator, neighbouring pixels are merged into a single run.
+ */
+static exr_result_t
+unpack_deep_pointer_runs (exr_decode_pipeline_t* decode)
+{
+    const uint8_t* srcbuffer  = decode->unpacked_buffer;
+    const int32_t* sampbuffer = decode->sample_count_table;
+    exr_result_t   rv         = EXR_ERR_SUCCESS;
+    int            w, h, uls, individual;
+
+    w   = decode->chunk.width;
+    h   = decode->chunk.height - decode->user_line_end_ignore;
+    uls = decode->user_line_begin_skip;
+
+    individual =
+        (decode->decode_flags & EXR_DECODE_SAMPLE_COUNTS_AS_INDIVIDUAL) != 0;
+
+    for (int y = 0; y < h; ++y)
+    {
+        for (int c = 0; c < decode->channel_count; ++c)
+        {
+            exr_coding_channel_info_t* decc = (decode->channels + c);
+            size_t                     bpc  = decc->bytes_per_element;
+            size_t                     ubpc = decc->user_bytes_per_element;
+            void**                     pdata = (void**) decc->decode_to_ptr;
+            size_t                     pixstride;
+            uint8_t*                   rundst  = NULL;
+            const uint8_t*             runsrc  = srcbuffer;
+            int32_t                    runsamps = 0;
+            int32_t                    prevsamps = 0;
+
+            if (y < uls || !pdata)
+            {
+                srcbuffer +=
+                    bpc * (size_t) deep_line_samples (decode, sampbuffer);
+                continue;
+            }
+
+            pdata += ((size_t) y - uls) *
+                     (((size_t) decc->user_line_stride) / sizeof (void*));
+            pixstride = ((size_t) decc->user_pixel_stride) / sizeof (void*);
+
+            for (int x = 0; x < w; ++x)
+            {
+                uint8_t* outpix = (uint8_t*) *pdata;
+                int32_t  samps  = sampbuffer[x];
+
+                if (!individual)
+                {
+                    int32_t tmp = samps - prevsamps;
+                    prevsamps   = samps;
+                    samps       = tmp;
+                }
+                pdata += pixstride;
+
+                if (samps == 0) continue;
+
+                if (outpix && rundst &&
+                    outpix == rundst + ((size_t) runsamps) * ubpc)
+                {
+                    runsamps += samps;
+                }
+                else
+                {
+                    if (rundst)
+                        rv = unpack_deep_run (decc, rundst, runsrc, runsamps);
+                    if (rv != EXR_ERR_SUCCESS) return rv;
+                    rundst   = outpix;
+                    runsrc   = srcbuffer;
+                    runsamps = outpix ? samps : 0;
+                }
+                srcbuffer += bpc * ((size_t) samps);
+            }
+            if (rundst) rv = unpack_deep_run (decc, rundst, runsrc, runsamps);
+            if (rv != EXR_ERR_SUCCESS) return rv;
+        }
+        sampbuffer += w;
+    }
+    return EXR_ERR_SUCCESS;
+}
+
 /**************************************/
 
 internal_exr_unpack_fn
@@ -1427,9 +1606,29 @@ internal_exr_match_decode (
 
     if (isdeep)
     {
+        int runs = 1;
+
+#if EXR_HOST_IS_NOT_LITTLE_ENDIAN
+        runs = 0;
+#endif
+        for (int c = 0; runs && c < decode->channel_count; ++c)
+        {
+            const exr_coding_channel_info_t* decc = decode->channels + c;
+
+            if (!decc->decode_to_ptr) continue;
+            if (decc->data_type == decc->user_data_type)
+                runs = (decc->user_bytes_per_element ==
+                        decc->bytes_per_element);
+            else
+                runs = (decc->data_type == EXR_PIXEL_HALF &&
+                        decc->user_data_type == EXR_PIXEL_FLOAT &&
+                        decc->user_bytes_per_element == 4);
+        }
+
         if ((decode->decode_flags & EXR_DECODE_NON_IMAGE_DATA_AS_POINTERS))
-            return &generic_unpack_deep_pointers;
-        return &generic_unpack_deep;
+            return runs ? &unpack_deep_pointer_runs
+                        : &generic_unpack_deep_pointers;
+        return runs ? &unpack_deep_runs : &generic_unpack_deep;
     }
 
     if (hastypechange > 0)
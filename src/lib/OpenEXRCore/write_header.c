@@ -669,6 +669,12 @@ internal_exr_write_header (exr_context_t ctxt)
 
     rv = internal_exr_calc_header_version_flags (ctxt, &flags);
 
+    /* neither the parts nor the names of the attributes can change
+     * when a header is updated in place, so keep the flags as they are */
+    if (ctxt->mode == EXR_CONTEXT_UPDATE_HEADER &&
+        ctxt->orig_version_and_flags != 0)
+        flags = ctxt->orig_version_and_flags;
+
     magic_and_version[0] = 20000630;
     magic_and_version[1] = flags;
 
@@ -684,7 +690,9 @@ internal_exr_write_header (exr_context_t ctxt)
     for (int p = 0; rv == EXR_ERR_SUCCESS && p < ctxt->num_parts; ++p)
     {
         exr_priv_part_t curp = ctxt->parts[p];
-        if (ctxt->legacy_header)
+        /* a header that is updated in place keeps the order of
+         * the attributes in the file */
+        if (ctxt->legacy_header && ctxt->mode != EXR_CONTEXT_UPDATE_HEADER)
         {
             for (int a = 0; a < curp->attributes.num_attributes; ++a)
             {
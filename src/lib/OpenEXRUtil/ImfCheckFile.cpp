@@ -3,10 +3,12 @@
 
 #include "ImfCheckFile.h"
 #include "Iex.h"
+#include "IlmThreadPool.h"
 #include "ImfArray.h"
 #include "ImfChannelList.h"
 #include "ImfCompositeDeepScanLine.h"
 #include "ImfCompressor.h"
+#include "ImfCoreChunks.h"
 #include "ImfDeepFrameBuffer.h"
 #include "ImfDeepScanLineInputFile.h"
 #include "ImfDeepScanLineInputPart.h"
@@ -27,7 +29,13 @@
 #include "openexr.h"
 
 #include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
 #include <stdlib.h>
+#include <thread>
 #include <vector>
 
 OPENEXR_IMF_INTERNAL_NAMESPACE_SOURCE_ENTER
@@ -1782,6 +1790,380 @@ runCoreChecks (
     return hadfail;
 }
 
+////////////////////////////////////////
+
+//
+// the last error message the Core library reported in each thread
+// that reads from a file
+//
+
+struct CoreMessages
+{
+    std::mutex                             mutex;
+    std::map<std::thread::id, std::string> last;
+
+    void set (const char* msg)
+    {
+        std::lock_guard<std::mutex> lock (mutex);
+        last[std::this_thread::get_id ()] = msg ? msg : "";
+    }
+
+    void clear ()
+    {
+        std::lock_guard<std::mutex> lock (mutex);
+        last.erase (std::this_thread::get_id ());
+    }
+
+    std::string get (exr_result_t rv)
+    {
+        std::string msg;
+
+        {
+            std::lock_guard<std::mutex> lock (mutex);
+            auto i = last.find (std::this_thread::get_id ());
+            if (i != last.end ()) msg = i->second;
+        }
+
+        if (msg.empty ()) msg = exr_get_default_error_message (rv);
+        return std::string (exr_get_error_code_as_string (rv)) + ": " + msg;
+    }
+};
+
+static void
+core_message_handler_cb (exr_const_context_t f, int code, const char* msg)
+{
+    void* ud = nullptr;
+    if (exr_get_user_data (f, &ud) == EXR_ERR_SUCCESS && ud)
+        static_cast<CoreMessages*> (ud)->set (msg);
+
+    core_error_handler_cb (f, code, msg);
+}
+
+//
+// the position of a chunk in the file, as recorded in the chunk
+// offset table, or 0 if it cannot be read
+//
+
+uint64_t
+chunkOffset (exr_context_t f, const char* fileName, const CoreChunkRef& c)
+{
+    uint64_t table;
+    if (exr_get_chunk_table_offset (f, c.part, &table) != EXR_ERR_SUCCESS)
+        return 0;
+
+    std::ifstream is (fileName, std::ios_base::binary);
+    is.seekg (std::streamoff (table + 8 * uint64_t (c.chunk)));
+
+    unsigned char b[8];
+    if (!is.read (reinterpret_cast<char*> (b), 8)) return 0;
+
+    uint64_t offset = 0;
+    for (int i = 7; i >= 0; --i)
+        offset = (offset << 8) | b[i];
+
+    return offset;
+}
+
+//
+// A CheckChunksTask reads, and unless structureOnly is set decodes,
+// chunks taken from a list shared with the other tasks, until the
+// list is exhausted.  Chunks that follow the earliest failure found
+// so far are skipped, but all chunks before it are still checked, so
+// the failure that is reported does not depend on the timing of the
+// threads.
+//
+
+class CheckChunksTask : public ILMTHREAD_NAMESPACE::Task
+{
+public:
+    CheckChunksTask (
+        ILMTHREAD_NAMESPACE::TaskGroup* group,
+        exr_context_t                   f,
+        const vector<CoreChunkRef>&     chunks,
+        bool                            structureOnly,
+        CoreMessages&                   messages,
+        std::atomic<size_t>&            next,
+        std::mutex&                     failureMutex,
+        size_t&                         failure,
+        std::string&                    message)
+        : Task (group)
+        , _f (f)
+        , _chunks (chunks)
+        , _structureOnly (structureOnly)
+        , _messages (messages)
+        , _next (next)
+        , _failureMutex (failureMutex)
+        , _failure (failure)
+        , _message (message)
+    {}
+
+    void execute () override
+    {
+        exr_decode_pipeline_t decoder = EXR_DECODE_PIPELINE_INITIALIZER;
+        vector<uint8_t>       imgdata;
+        int                   part = -1;
+
+        for (size_t i = _next++; i < _chunks.size (); i = _next++)
+        {
+            {
+                std::lock_guard<std::mutex> lock (_failureMutex);
+                if (i > _failure) break;
+            }
+
+            const CoreChunkRef& c = _chunks[i];
+
+            if (c.part != part)
+            {
+                exr_decoding_destroy (_f, &decoder);
+                part = c.part;
+            }
+
+            //
+            // a message left over from an earlier chunk must not be
+            // reported for this one, if Core fails without a message
+            //
+
+            _messages.clear ();
+
+            try
+            {
+                exr_result_t rv = checkChunk (c, decoder, imgdata);
+
+                if (rv != EXR_ERR_SUCCESS) fail (i, _messages.get (rv));
+            }
+            catch (std::exception& e)
+            {
+                fail (i, e.what ());
+            }
+            catch (...)
+            {
+                fail (i, "unknown exception");
+            }
+        }
+
+        exr_decoding_destroy (_f, &decoder);
+    }
+
+private:
+    void fail (size_t i, const std::string& msg)
+    {
+        std::lock_guard<std::mutex> lock (_failureMutex);
+
+        if (i < _failure)
+        {
+            _failure = i;
+            _message = msg;
+        }
+    }
+
+    exr_result_t checkChunk (
+        const CoreChunkRef&    c,
+        exr_decode_pipeline_t& decoder,
+        vector<uint8_t>&       imgdata)
+    {
+        exr_chunk_info_t cinfo;
+        exr_result_t     rv;
+
+        if (c.tiled)
+            rv = exr_read_tile_chunk_info (
+                _f, c.part, c.tx, c.ty, c.lx, c.ly, &cinfo);
+        else
+            rv = exr_read_scanline_chunk_info (_f, c.part, c.y, &cinfo);
+
+        if (rv != EXR_ERR_SUCCESS || _structureOnly) return rv;
+
+        bool deep = cinfo.type == EXR_STORAGE_DEEP_SCANLINE ||
+                    cinfo.type == EXR_STORAGE_DEEP_TILED;
+
+        if (decoder.channels == NULL)
+        {
+            rv = exr_decoding_initialize (_f, c.part, &cinfo, &decoder);
+            if (rv != EXR_ERR_SUCCESS) return rv;
+
+            if (deep)
+            {
+                decoder.decoding_user_data       = &imgdata;
+                decoder.realloc_nonimage_data_fn = &realloc_deepdata;
+            }
+            else
+            {
+                // fake address for the default routines
+                for (int ch = 0; ch < decoder.channel_count; ++ch)
+                    decoder.channels[ch].decode_to_ptr = (uint8_t*) 0x1000;
+            }
+
+            rv = exr_decoding_choose_default_routines (_f, c.part, &decoder);
+        }
+        else
+        {
+            rv = exr_decoding_update (_f, c.part, &cinfo, &decoder);
+        }
+
+        if (rv != EXR_ERR_SUCCESS) return rv;
+
+        if (!deep)
+        {
+            uint64_t bytes = 0;
+            for (int ch = 0; ch < decoder.channel_count; ++ch)
+            {
+                const exr_coding_channel_info_t& outc = decoder.channels[ch];
+                bytes += (uint64_t) outc.width * (uint64_t) outc.height *
+                         (uint64_t) outc.user_bytes_per_element;
+            }
+
+            if (imgdata.size () < bytes) imgdata.resize (bytes);
+
+            uint8_t* dptr = imgdata.data ();
+            for (int ch = 0; ch < decoder.channel_count; ++ch)
+            {
+                exr_coding_channel_info_t& outc = decoder.channels[ch];
+                outc.decode_to_ptr              = dptr;
+                outc.user_pixel_stride          = outc.user_bytes_per_element;
+                outc.user_line_stride = outc.user_pixel_stride * outc.width;
+
+                dptr += (uint64_t) outc.width * (uint64_t) outc.height *
+                        (uint64_t) outc.user_bytes_per_element;
+            }
+        }
+
+        return exr_decoding_run (_f, c.part, &decoder);
+    }
+
+    exr_context_t               _f;
+    const vector<CoreChunkRef>& _chunks;
+    bool                        _structureOnly;
+    CoreMessages&               _messages;
+    std::atomic<size_t>&        _next;
+    std::mutex&                 _failureMutex;
+    size_t&                     _failure;
+    std::string&                _message;
+};
+
+bool
+runCoreChunkChecks (
+    const char*        fileName,
+    bool               structureOnly,
+    int                numThreads,
+    ChunkCheckFailure& failure)
+{
+    CoreMessages              messages;
+    exr_context_t             f;
+    exr_context_initializer_t cinit = EXR_DEFAULT_CONTEXT_INITIALIZER;
+
+    cinit.user_data        = &messages;
+    cinit.error_handler_fn = &core_message_handler_cb;
+
+    // a damaged chunk offset table is a failure to report, not
+    // something to work around by scanning the file for the chunks
+    cinit.flags |= EXR_CONTEXT_FLAG_DISABLE_CHUNK_RECONSTRUCTION;
+
+    exr_result_t rv = exr_start_read (&f, fileName, &cinit);
+    if (rv != EXR_ERR_SUCCESS)
+    {
+        failure.message = messages.get (rv);
+        return true;
+    }
+
+    //
+    // list the chunks of all parts
+    //
+
+    vector<CoreChunkRef> chunks;
+    int                  numParts = 0;
+
+    rv = exr_get_count (f, &numParts);
+
+    for (int p = 0; rv == EXR_ERR_SUCCESS && p < numParts; ++p)
+    {
+        size_t  first = chunks.size ();
+        int32_t count = 0;
+
+        rv = listCoreChunks (f, p, chunks);
+        if (rv == EXR_ERR_SUCCESS) rv = exr_get_chunk_count (f, p, &count);
+
+        if (rv == EXR_ERR_SUCCESS && size_t (count) != chunks.size () - first)
+        {
+            std::stringstream ss;
+            ss << "chunk offset table has " << count << " entries, "
+               << "but the part has " << chunks.size () - first << " chunks";
+
+            exr_finish (&f);
+            failure.part    = p;
+            failure.message = ss.str ();
+            return true;
+        }
+
+        if (rv != EXR_ERR_SUCCESS) failure.part = p;
+    }
+
+    if (rv != EXR_ERR_SUCCESS)
+    {
+        failure.message = messages.get (rv);
+        exr_finish (&f);
+        return true;
+    }
+
+    //
+    // check the chunks; unless we are running in a task of the
+    // thread pool ourselves, where waiting for more tasks could tie
+    // up all the pool's threads, numThreads tasks share the work
+    //
+
+    std::atomic<size_t> next (0);
+    std::mutex          failureMutex;
+    size_t              first = chunks.size ();
+    std::string         message;
+
+    size_t numTasks = std::min (chunks.size (), size_t (max (numThreads, 1)));
+
+    if (numTasks < 2 || ILMTHREAD_NAMESPACE::TaskGroup::current ())
+    {
+        CheckChunksTask task (
+            nullptr,
+            f,
+            chunks,
+            structureOnly,
+            messages,
+            next,
+            failureMutex,
+            first,
+            message);
+
+        task.execute ();
+    }
+    else
+    {
+        ILMTHREAD_NAMESPACE::TaskGroup group;
+
+        for (size_t t = 0; t < numTasks; ++t)
+        {
+            ILMTHREAD_NAMESPACE::ThreadPool::addGlobalTask (
+                new CheckChunksTask (
+                    &group,
+                    f,
+                    chunks,
+                    structureOnly,
+                    messages,
+                    next,
+                    failureMutex,
+                    first,
+                    message));
+        }
+    }
+
+    if (first < chunks.size ())
+    {
+        failure.part    = chunks[first].part;
+        failure.chunk   = chunks[first].chunk;
+        failure.offset  = chunkOffset (f, fileName, chunks[first]);
+        failure.message = message;
+    }
+
+    exr_finish (&f);
+
+    return first < chunks.size ();
+}
+
 } // namespace
 
 bool
@@ -1816,4 +2198,20 @@ checkOpenEXRFile (
     }
 }
 
+bool
+checkOpenEXRFileChunks (
+    const char*        fileName,
+    bool               structureOnly,
+    int                numThreads,
+    ChunkCheckFailure* failure)
+{
+    ChunkCheckFailure f;
+
+    bool hadfail = runCoreChunkChecks (fileName, structureOnly, numThreads, f);
+
+    if (failure) *failure = f;
+
+    return hadfail;
+}
+
 OPENEXR_IMF_INTERNAL_NAMESPACE_SOURCE_EXIT
@@ -5,9 +5,12 @@
 #define INCLUDED_IMF_CHECKFILE_H
 
 #include "ImfNamespace.h"
+#include "ImfThreading.h"
 #include "ImfUtilExport.h"
 
 #include <cstddef>
+#include <cstdint>
+#include <string>
 
 OPENEXR_IMF_INTERNAL_NAMESPACE_HEADER_ENTER
 
@@ -45,6 +48,47 @@ IMFUTIL_EXPORT bool checkOpenEXRFile (
     bool        reduceTime   = false,
     bool        runCoreCheck = false);
 
+//
+// where checkOpenEXRFileChunks() found the first problem in a file.
+// part and chunk are -1 if the problem is not in a chunk, for example
+// if the header is invalid.  chunk is the index of the chunk in the
+// part's chunk offset table, and offset is the position of the chunk
+// in the file, or 0 if the offset could not be read.
+//
+
+struct IMFUTIL_EXPORT_TYPE ChunkCheckFailure
+{
+    int         part   = -1;
+    int         chunk  = -1;
+    uint64_t    offset = 0;
+    std::string message;
+};
+
+//
+// check the chunks of a file using the OpenEXRCore (C) API, with
+// numThreads threads.  The chunks of all parts are checked in
+// parallel, and the first failing chunk, in file order, is reported
+// in failure, if failure is not null.
+//
+// if structureOnly is true, only the structure of the file is
+// checked: the header, the chunk offset tables against the file size,
+// and the chunk leaders; no pixel data is decompressed.  Otherwise
+// every chunk is also decompressed and unpacked.  Either way, a
+// damaged chunk offset table is reported as a problem, rather than
+// rebuilt from the chunks as readers do.
+//
+// returns true if a problem was found, like checkOpenEXRFile
+//
+// If called from a task in the global thread pool, the chunks
+// are checked in the calling thread.
+//
+
+IMFUTIL_EXPORT bool checkOpenEXRFileChunks (
+    const char*        fileName,
+    bool               structureOnly = false,
+    int                numThreads    = globalThreadCount (),
+    ChunkCheckFailure* failure       = nullptr);
+
 OPENEXR_IMF_INTERNAL_NAMESPACE_HEADER_EXIT
 
 #endif
@@ -0,0 +1,76 @@
+//
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) Contributors to the OpenEXR Project.
+//
+
+//----------------------------------------------------------------------------
+//
+//      function listCoreChunks()
+//
+//----------------------------------------------------------------------------
+
+#include "ImfCoreChunks.h"
+
+using namespace std;
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_SOURCE_ENTER
+
+exr_result_t
+listCoreChunks (exr_context_t f, int part, vector<CoreChunkRef>& chunks)
+{
+    exr_result_t  rv;
+    exr_storage_t store;
+
+    rv = exr_get_storage (f, part, &store);
+    if (rv != EXR_ERR_SUCCESS) return rv;
+
+    exr_attr_box2i_t dw;
+    rv = exr_get_data_window (f, part, &dw);
+    if (rv != EXR_ERR_SUCCESS) return rv;
+
+    int chunk = 0;
+
+    if (store == EXR_STORAGE_SCANLINE || store == EXR_STORAGE_DEEP_SCANLINE)
+    {
+        int32_t lpc;
+        rv = exr_get_scanlines_per_chunk (f, part, &lpc);
+        if (rv != EXR_ERR_SUCCESS) return rv;
+
+        for (int64_t y = dw.min.y; y <= dw.max.y; y += lpc)
+            chunks.push_back ({part, chunk++, false, int (y), 0, 0, 0, 0});
+
+        return EXR_ERR_SUCCESS;
+    }
+
+    uint32_t              txsz, tysz;
+    exr_tile_level_mode_t levelmode;
+    exr_tile_round_mode_t roundingmode;
+
+    rv = exr_get_tile_descriptor (
+        f, part, &txsz, &tysz, &levelmode, &roundingmode);
+    if (rv != EXR_ERR_SUCCESS) return rv;
+
+    int32_t levelsx, levelsy;
+    rv = exr_get_tile_levels (f, part, &levelsx, &levelsy);
+    if (rv != EXR_ERR_SUCCESS) return rv;
+
+    for (int32_t ly = 0; ly < levelsy; ++ly)
+    {
+        for (int32_t lx = 0; lx < levelsx; ++lx)
+        {
+            if (levelmode != EXR_TILE_RIPMAP_LEVELS && lx != ly) continue;
+
+            int32_t nx, ny;
+            rv = exr_get_tile_counts (f, part, lx, ly, &nx, &ny);
+            if (rv != EXR_ERR_SUCCESS) return rv;
+
+            for (int32_t ty = 0; ty < ny; ++ty)
+                for (int32_t tx = 0; tx < nx; ++tx)
+                    chunks.push_back ({part, chunk++, true, 0, tx, ty, lx, ly});
+        }
+    }
+
+    return EXR_ERR_SUCCESS;
+}
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_SOURCE_EXIT
@@ -0,0 +1,51 @@
+//
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) Contributors to the OpenEXR Project.
+//
+
+#ifndef INCLUDED_IMF_CORE_CHUNKS_H
+#define INCLUDED_IMF_CORE_CHUNKS_H
+
+//----------------------------------------------------------------------------
+//
+//      struct CoreChunkRef,
+//      function listCoreChunks()
+//
+//      Enumerate the chunks of a part of a file opened through the
+//      Core library.  For use inside the OpenEXRUtil library only.
+//
+//----------------------------------------------------------------------------
+
+#include "ImfNamespace.h"
+
+#include "openexr.h"
+
+#include <vector>
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_HEADER_ENTER
+
+//
+// one chunk of a file, in the order of the parts' chunk offset tables
+//
+
+struct CoreChunkRef
+{
+    int  part;
+    int  chunk; // index in the part's chunk offset table
+    bool tiled;
+    int  y;     // first scan line, for scan line chunks
+    int  tx, ty, lx, ly;
+};
+
+//
+// Append the chunks of a part to chunks, in the order of the part's
+// chunk offset table; for tiled parts that is the order in which
+// Core computes a tile's index.
+//
+
+exr_result_t
+listCoreChunks (exr_context_t f, int part, std::vector<CoreChunkRef>& chunks);
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_HEADER_EXIT
+
+#endif
@@ -21,6 +21,11 @@ IMATH_INTERNAL_NAMESPACE_HEADER_EXIT
 #include "ImfDeepImageChannel.h"
 #include "ImfDeepImageLevel.h"
 #include <Iex.h>
+#include <IlmThreadPool.h>
+#include <ImfThreading.h>
+#include <algorithm>
+#include <exception>
+#include <mutex>
 
 using namespace IMATH_NAMESPACE;
 using namespace IEX_NAMESPACE;
@@ -71,13 +76,107 @@ DeepImageChannel::resize ()
 
 //-----------------------------------------------------------------------------
 
+namespace
+{
+
+template <class T>
+void
+initializeBlocks (
+    const SampleCountChannel& sampleCounts,
+    T**                       blockBuffers,
+    T**                       sampleListPointers,
+    int                       firstBlock,
+    int                       endBlock)
+{
+    //
+    // Allocate new sample buffers for blocks firstBlock to endBlock-1,
+    // and construct zero-filled sample lists for the blocks' pixels.
+    //
+
+    const unsigned int* numSamples = sampleCounts.numSamples ();
+    const size_t* sampleListPositions = sampleCounts.sampleListPositions ();
+
+    for (int b = firstBlock; b < endBlock; ++b)
+    {
+        delete[] blockBuffers[b];
+
+        blockBuffers[b] = 0; // set to 0 to prevent double deletion
+                             // in case of an exception
+
+        blockBuffers[b] = new T[sampleCounts.blockBufferSize (b)];
+
+        for (size_t i = sampleCounts.blockFirstPixel (b);
+             i < sampleCounts.blockFirstPixel (b + 1);
+             ++i)
+        {
+            sampleListPointers[i] = blockBuffers[b] + sampleListPositions[i];
+
+            for (unsigned int j = 0; j < numSamples[i]; ++j)
+                sampleListPointers[i][j] = T (0);
+        }
+    }
+}
+
+template <class T> class InitializeBlocksTask : public ILMTHREAD_NAMESPACE::Task
+{
+public:
+    InitializeBlocksTask (
+        ILMTHREAD_NAMESPACE::TaskGroup* group,
+        const SampleCountChannel&       sampleCounts,
+        T**                             blockBuffers,
+        T**                             sampleListPointers,
+        int                             firstBlock,
+        int                             endBlock,
+        std::mutex&                     errorMutex,
+        std::exception_ptr&             error)
+        : Task (group)
+        , _sampleCounts (sampleCounts)
+        , _blockBuffers (blockBuffers)
+        , _sampleListPointers (sampleListPointers)
+        , _firstBlock (firstBlock)
+        , _endBlock (endBlock)
+        , _errorMutex (errorMutex)
+        , _error (error)
+    {}
+
+    void execute () override
+    {
+        try
+        {
+            initializeBlocks (
+                _sampleCounts,
+                _blockBuffers,
+                _sampleListPointers,
+                _firstBlock,
+                _endBlock);
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock (_errorMutex);
+            if (!_error) _error = std::current_exception ();
+        }
+    }
+
+private:
+    const SampleCountChannel& _sampleCounts;
+    T**                       _blockBuffers;
+    T**                       _sampleListPointers;
+    int                       _firstBlock;
+    int                       _endBlock;
+    std::mutex&               _errorMutex;
+    std::exception_ptr&       _error;
+};
+
+} // namespace
+
 template <class T>
 TypedDeepImageChannel<T>::TypedDeepImageChannel (
     DeepImageLevel& level, bool pLinear)
     : DeepImageChannel (level, pLinear)
     , _sampleListPointers (0)
     , _base (0)
-    , _sampleBuffer (0)
+    , _numBlocks (0)
+    , _blockBuffers (0)
 {
     resize ();
 }
@@ -85,7 +184,11 @@ TypedDeepImageChannel<T>::TypedDeepImageChannel (
 template <class T> TypedDeepImageChannel<T>::~TypedDeepImageChannel ()
 {
     delete[] _sampleListPointers;
-    delete[] _sampleBuffer;
+
+    for (int b = 0; b < _numBlocks; ++b)
+        delete[] _blockBuffers[b];
+
+    delete[] _blockBuffers;
 }
 
 template <class T>
@@ -149,11 +252,12 @@ TypedDeepImageChannel<T>::moveSampleList (
     //                          are discarded.
     //
     // newSampleListPosition    The new position of the sample list in the
-    //                          sample buffer.
+    //                          sample buffer of the pixel's block.
     //
 
     T* oldSampleList = _sampleListPointers[i];
-    T* newSampleList = _sampleBuffer + newSampleListPosition;
+    T* newSampleList = _blockBuffers[sampleCounts ().blockForPixel (i)] +
+                       newSampleListPosition;
 
     if (oldNumSamples > newNumSamples)
     {
@@ -175,20 +279,20 @@ TypedDeepImageChannel<T>::moveSampleList (
 template <class T>
 void
 TypedDeepImageChannel<T>::moveSamplesToNewBuffer (
-    const unsigned int* oldNumSamples,
-    const unsigned int* newNumSamples,
-    const size_t*       newSampleListPositions)
+    int b, const unsigned int* oldNumSamples)
 {
     //
-    // Allocate a new sample buffer for this channel.
-    // Copy the sample lists for all pixels into the new buffer.
-    // Then delete the old sample buffer.
+    // Allocate a new sample buffer for block b of this channel.
+    // Copy the sample lists for the pixels in the block into the
+    // new buffer.  Then delete the block's old sample buffer.
     //
-    // oldNumSamples            Number of samples in each sample list in the
-    //                          old sample buffer.
+    // b                        The block whose samples are moved.
     //
-    // newNumSamples            Number of samples in each sample list in
-    //                          the new sample buffer.  If the new number
+    // oldNumSamples            Number of samples in each sample list of
+    //                          the block in the old sample buffer, starting
+    //                          with the block's first pixel.  The new
+    //                          numbers of samples are taken from the
+    //                          sample count channel.  If the new number
     //                          of samples is larger than the old number of
     //                          samples for a given sample list, then the
     //                          end of the new sample list is filled with
@@ -196,35 +300,42 @@ TypedDeepImageChannel<T>::moveSamplesToNewBuffer (
     //                          smaller than the old one, then samples at
     //                          the end of the old sample list are discarded.
     //
-    // newSampleListPositions   The positions of the new sample lists in the
-    //                          new sample buffer.
-    //
 
-    T* oldSampleBuffer = _sampleBuffer;
-    _sampleBuffer      = new T[sampleCounts ().sampleBufferSize ()];
+    const SampleCountChannel& scc           = sampleCounts ();
+    const unsigned int*       newNumSamples = scc.numSamples ();
+    const size_t* newSampleListPositions    = scc.sampleListPositions ();
+
+    T* oldSampleBuffer = _blockBuffers[b];
+    T* newSampleBuffer = new T[scc.blockBufferSize (b)];
+
+    size_t firstPixel = scc.blockFirstPixel (b);
 
-    for (size_t i = 0; i < numPixels (); ++i)
+    for (size_t i = firstPixel; i < scc.blockFirstPixel (b + 1); ++i)
     {
+        unsigned int oldN = oldNumSamples[i - firstPixel];
+        unsigned int newN = newNumSamples[i];
+
         T* oldSampleList = _sampleListPointers[i];
-        T* newSampleList = _sampleBuffer + newSampleListPositions[i];
+        T* newSampleList = newSampleBuffer + newSampleListPositions[i];
 
-        if (oldNumSamples[i] > newNumSamples[i])
+        if (oldN > newN)
         {
-            for (unsigned int j = 0; j < newNumSamples[i]; ++j)
+            for (unsigned int j = 0; j < newN; ++j)
                 newSampleList[j] = oldSampleList[j];
         }
         else
         {
-            for (unsigned int j = 0; j < oldNumSamples[i]; ++j)
+            for (unsigned int j = 0; j < oldN; ++j)
                 newSampleList[j] = oldSampleList[j];
 
-            for (unsigned int j = oldNumSamples[i]; j < newNumSamples[i]; ++j)
+            for (unsigned int j = oldN; j < newN; ++j)
                 newSampleList[j] = 0;
         }
 
         _sampleListPointers[i] = newSampleList;
     }
 
+    _blockBuffers[b] = newSampleBuffer;
     delete[] oldSampleBuffer;
 }
 
@@ -234,28 +345,45 @@ TypedDeepImageChannel<T>::initializeSampleLists ()
 {
     //
     // Allocate a new set of sample lists for this channel, and
-    // construct zero-filled sample lists for the pixels.
+    // construct zero-filled sample lists for the pixels.  Each
+    // block has its own sample buffer, so the blocks can be
+    // initialized in parallel.
     //
 
-    delete[] _sampleBuffer;
+    const SampleCountChannel& scc = sampleCounts ();
 
-    _sampleBuffer = 0; // set to 0 to prevent double deletion
-                       // in case of an exception
+    resetBasePointer ();
 
-    const unsigned int* numSamples    = sampleCounts ().numSamples ();
-    const size_t* sampleListPositions = sampleCounts ().sampleListPositions ();
+    int numTasks = std::min (_numBlocks, globalThreadCount ());
 
-    _sampleBuffer = new T[sampleCounts ().sampleBufferSize ()];
+    if (numTasks < 2)
+    {
+        initializeBlocks (scc, _blockBuffers, _sampleListPointers, 0, _numBlocks);
+        return;
+    }
 
-    resetBasePointer ();
+    std::mutex         errorMutex;
+    std::exception_ptr error;
 
-    for (size_t i = 0; i < numPixels (); ++i)
     {
-        _sampleListPointers[i] = _sampleBuffer + sampleListPositions[i];
+        ILMTHREAD_NAMESPACE::TaskGroup group;
 
-        for (unsigned int j = 0; j < numSamples[i]; ++j)
-            _sampleListPointers[i][j] = T (0);
+        for (int t = 0; t < numTasks; ++t)
+        {
+            ILMTHREAD_NAMESPACE::ThreadPool::addGlobalTask (
+                new InitializeBlocksTask<T> (
+                    &group,
+                    scc,
+                    _blockBuffers,
+                    _sampleListPointers,
+                    _numBlocks * t / numTasks,
+                    _numBlocks * (t + 1) / numTasks,
+                    errorMutex,
+                    error));
+        }
     }
+
+    if (error) std::rethrow_exception (error);
 }
 
 template <class T>
@@ -266,7 +394,24 @@ TypedDeepImageChannel<T>::resize ()
 
     delete[] _sampleListPointers;
     _sampleListPointers = 0;
+
+    for (int b = 0; b < _numBlocks; ++b)
+        delete[] _blockBuffers[b];
+
+    delete[] _blockBuffers;
+    _blockBuffers = 0;
+    _numBlocks    = 0;
+
     _sampleListPointers = new T*[numPixels ()];
+
+    int numBlocks = sampleCounts ().numBlocks ();
+    _blockBuffers = new T*[numBlocks];
+
+    for (int b = 0; b < numBlocks; ++b)
+        _blockBuffers[b] = 0;
+
+    _numBlocks = numBlocks;
+
     initializeSampleLists ();
 }
 
@@ -86,10 +86,8 @@ protected:
         unsigned int newNumSamples,
         size_t       newSampleListPosition) = 0;
 
-    virtual void moveSamplesToNewBuffer (
-        const unsigned int* oldNumSamples,
-        const unsigned int* newNumSamples,
-        const size_t*       newSampleListPositions) = 0;
+    virtual void
+    moveSamplesToNewBuffer (int b, const unsigned int* oldNumSamples) = 0;
 
     virtual void initializeSampleLists () = 0;
 
@@ -177,10 +175,8 @@ private:
         size_t       newSampleListPosition);
 
     IMFUTIL_HIDDEN
-    virtual void moveSamplesToNewBuffer (
-        const unsigned int* oldNumSamples,
-        const unsigned int* newNumSamples,
-        const size_t*       newSampleListPositions);
+    virtual void
+    moveSamplesToNewBuffer (int b, const unsigned int* oldNumSamples);
 
     IMFUTIL_HIDDEN
     virtual void initializeSampleLists ();
@@ -197,9 +193,11 @@ private:
     T** _base; // Base pointer for faster access
                // to entries in _sampleListPointers
 
-    T* _sampleBuffer; // Contiguous memory block that
-                      // contains all sample lists for
-                      // this channel
+    int _numBlocks; // Number of entries in _blockBuffers
+
+    T** _blockBuffers; // Per-block memory blocks that
+                       // contain the sample lists of the
+                       // pixels in each block
 };
 
 //
@@ -11,6 +11,7 @@
 
 #include "ImfDeepImageIO.h"
 #include <Iex.h>
+#include <IlmThreadPool.h>
 #include <ImfChannelList.h>
 #include <ImfDeepScanLineInputFile.h>
 #include <ImfDeepScanLineOutputFile.h>
@@ -20,8 +21,14 @@
 #include <ImfMultiPartInputFile.h>
 #include <ImfPartType.h>
 #include <ImfTestFile.h>
+#include <ImfThreading.h>
+#include <atomic>
 #include <cassert>
 #include <cstring>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <vector>
 
 using namespace IMATH_NAMESPACE;
 using namespace IEX_NAMESPACE;
@@ -315,10 +322,14 @@ saveDeepTiledImage (const string& fileName, const DeepImage& img)
 namespace
 {
 
-void
-loadLevel (DeepTiledInputFile& in, DeepImage& img, int x, int y)
+//
+// a frame buffer whose slices point directly into the
+// channels of an image level
+//
+
+DeepFrameBuffer
+levelFrameBuffer (DeepImageLevel& level)
 {
-    DeepImageLevel& level = img.level (x, y);
     DeepFrameBuffer fb;
 
     fb.insertSampleCountSlice (level.sampleCounts ().slice ());
@@ -327,7 +338,15 @@ loadLevel (DeepTiledInputFile& in, DeepImage& img, int x, int y)
          ++i)
         fb.insert (i.name (), i.channel ().slice ());
 
-    in.setFrameBuffer (fb);
+    return fb;
+}
+
+void
+loadLevel (DeepTiledInputFile& in, DeepImage& img, int x, int y)
+{
+    DeepImageLevel& level = img.level (x, y);
+
+    in.setFrameBuffer (levelFrameBuffer (level));
 
     {
         SampleCountChannel::Edit edit (level.sampleCounts ());
@@ -339,6 +358,170 @@ loadLevel (DeepTiledInputFile& in, DeepImage& img, int x, int y)
     in.readTiles (0, in.numXTiles (x) - 1, 0, in.numYTiles (y) - 1, x, y);
 }
 
+//
+// one row of tiles of one level of a multi-level image
+//
+
+struct TileRow
+{
+    int lx;
+    int ly;
+    int dy;
+};
+
+//
+// A LoadTilesTask reads either the sample counts or the samples of
+// rows of tiles, taken from a list shared with the other tasks, until
+// the list is exhausted.  Each task reads through its own
+// DeepTiledInputFile, without threads of its own, so the levels of an
+// image are read concurrently, and small levels do not leave threads
+// idle.  The file is kept from reading the sample counts to reading
+// the samples.
+//
+
+class LoadTilesTask : public ILMTHREAD_NAMESPACE::Task
+{
+public:
+    LoadTilesTask (
+        ILMTHREAD_NAMESPACE::TaskGroup*      group,
+        const string&                        fileName,
+        std::unique_ptr<DeepTiledInputFile>& in,
+        DeepImage&                           img,
+        const vector<TileRow>&               rows,
+        bool                                 sampleCounts,
+        std::atomic<size_t>&                 nextRow,
+        std::mutex&                          errorMutex,
+        std::exception_ptr&                  error)
+        : Task (group)
+        , _fileName (fileName)
+        , _in (in)
+        , _img (img)
+        , _rows (rows)
+        , _sampleCounts (sampleCounts)
+        , _nextRow (nextRow)
+        , _errorMutex (errorMutex)
+        , _error (error)
+    {}
+
+    void execute () override
+    {
+        try
+        {
+            if (!_in)
+                _in.reset (new DeepTiledInputFile (_fileName.c_str (), 0));
+
+            int lx = -1;
+            int ly = -1;
+
+            for (size_t r = _nextRow++; r < _rows.size (); r = _nextRow++)
+            {
+                const TileRow& row = _rows[r];
+
+                if (row.lx != lx || row.ly != ly)
+                {
+                    lx = row.lx;
+                    ly = row.ly;
+                    DeepImageLevel& level = _img.level (lx, ly);
+                    _in->setFrameBuffer (levelFrameBuffer (level));
+                }
+
+                int nx = _in->numXTiles (lx) - 1;
+
+                if (_sampleCounts)
+                    _in->readPixelSampleCounts (0, nx, row.dy, row.dy, lx, ly);
+                else
+                    _in->readTiles (0, nx, row.dy, row.dy, lx, ly);
+            }
+        }
+        catch (...)
+        {
+            // stop the other tasks
+            _nextRow = _rows.size ();
+
+            std::lock_guard<std::mutex> lock (_errorMutex);
+            if (!_error) _error = std::current_exception ();
+        }
+    }
+
+private:
+    const string&                        _fileName;
+    std::unique_ptr<DeepTiledInputFile>& _in;
+    DeepImage&                           _img;
+    const vector<TileRow>&               _rows;
+    bool                                 _sampleCounts;
+    std::atomic<size_t>&                 _nextRow;
+    std::mutex&                          _errorMutex;
+    std::exception_ptr&                  _error;
+};
+
+void
+loadLevels (const string& fileName, DeepTiledInputFile& in, DeepImage& img)
+{
+    //
+    // list the tile rows of all levels, in the order in which
+    // they are stored in the file
+    //
+
+    vector<TileRow> rows;
+
+    for (int y = 0; y < img.numYLevels (); ++y)
+    {
+        for (int x = 0; x < img.numXLevels (); ++x)
+        {
+            if (!in.isValidLevel (x, y)) continue;
+
+            for (int dy = 0; dy < in.numYTiles (y); ++dy)
+                rows.push_back ({x, y, dy});
+        }
+    }
+
+    size_t numTasks = std::min (rows.size (), size_t (globalThreadCount ()));
+
+    vector<std::unique_ptr<DeepTiledInputFile>> files (numTasks);
+    std::mutex                                  errorMutex;
+    std::exception_ptr                          error;
+
+    auto readRows = [&] (bool sampleCounts) {
+        std::atomic<size_t>            nextRow (0);
+        ILMTHREAD_NAMESPACE::TaskGroup group;
+
+        for (size_t t = 0; t < numTasks; ++t)
+        {
+            ILMTHREAD_NAMESPACE::ThreadPool::addGlobalTask (new LoadTilesTask (
+                &group,
+                fileName,
+                files[t],
+                img,
+                rows,
+                sampleCounts,
+                nextRow,
+                errorMutex,
+                error));
+        }
+    };
+
+    //
+    // Read the sample counts of all levels first.  Ending the edits
+    // of the sample counts allocates the samples, which are read next.
+    //
+
+    {
+        vector<std::unique_ptr<SampleCountChannel::Edit>> edits;
+
+        for (int y = 0; y < img.numYLevels (); ++y)
+            for (int x = 0; x < img.numXLevels (); ++x)
+                if (in.isValidLevel (x, y))
+                    edits.emplace_back (new SampleCountChannel::Edit (
+                        img.level (x, y).sampleCounts ()));
+
+        readRows (true);
+    }
+
+    if (!error) readRows (false);
+
+    if (error) std::rethrow_exception (error);
+}
+
 } // namespace
 
 void
@@ -358,26 +541,40 @@ loadDeepTiledImage (const string& fileName, Header& hdr, DeepImage& img)
         in.header ().tileDescription ().mode,
         in.header ().tileDescription ().roundingMode);
 
-    switch (img.levelMode ())
+    //
+    // The levels of a mipmap or ripmap are read concurrently, unless
+    // we are running in a task of the thread pool ourselves, where
+    // waiting for more tasks could tie up all the pool's threads.
+    //
+
+    bool concurrentLevels = img.levelMode () != ONE_LEVEL &&
+                            globalThreadCount () > 1 &&
+                            !ILMTHREAD_NAMESPACE::TaskGroup::current ();
+
+    if (concurrentLevels) { loadLevels (fileName, in, img); }
+    else
     {
-        case ONE_LEVEL: loadLevel (in, img, 0, 0); break;
+        switch (img.levelMode ())
+        {
+            case ONE_LEVEL: loadLevel (in, img, 0, 0); break;
 
-        case MIPMAP_LEVELS:
+            case MIPMAP_LEVELS:
 
-            for (int x = 0; x < img.numLevels (); ++x)
-                loadLevel (in, img, x, x);
+                for (int x = 0; x < img.numLevels (); ++x)
+                    loadLevel (in, img, x, x);
 
-            break;
+                break;
 
-        case RIPMAP_LEVELS:
+            case RIPMAP_LEVELS:
 
-            for (int y = 0; y < img.numYLevels (); ++y)
-                for (int x = 0; x < img.numXLevels (); ++x)
-                    loadLevel (in, img, x, y);
+                for (int y = 0; y < img.numYLevels (); ++y)
+                    for (int x = 0; x < img.numXLevels (); ++x)
+                        loadLevel (in, img, x, y);
 
-            break;
+                break;
 
-        default: assert (false);
+            default: assert (false);
+        }
     }
 
     for (Header::ConstIterator i = in.header ().begin ();
@@ -74,16 +74,12 @@ DeepImageLevel::moveSampleList (
 }
 
 void
-DeepImageLevel::moveSamplesToNewBuffer (
-    const unsigned int* oldNumSamples,
-    const unsigned int* newNumSamples,
-    const size_t*       newSampleListPositions)
+DeepImageLevel::moveSamplesToNewBuffer (int b, const unsigned int* oldNumSamples)
 {
     for (ChannelMap::iterator j = _channels.begin (); j != _channels.end ();
          ++j)
     {
-        j->second->moveSamplesToNewBuffer (
-            oldNumSamples, newNumSamples, newSampleListPositions);
+        j->second->moveSamplesToNewBuffer (b, oldNumSamples);
     }
 }
 
@@ -144,10 +144,7 @@ private:
         size_t       newSampleListPosition);
 
     IMF_HIDDEN
-    void moveSamplesToNewBuffer (
-        const unsigned int* oldNumSamples,
-        const unsigned int* newNumSamples,
-        const size_t*       newSampleListPositions);
+    void moveSamplesToNewBuffer (int b, const unsigned int* oldNumSamples);
 
     IMF_HIDDEN
     void initializeSampleLists ();
@@ -11,7 +11,14 @@
 
 #include "ImfFlatImage.h"
 #include <Iex.h>
+#include <IlmThreadPool.h>
+#include <ImfThreading.h>
+#include <algorithm>
 #include <cassert>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <vector>
 
 using namespace IMATH_NAMESPACE;
 using namespace IEX_NAMESPACE;
@@ -19,6 +26,245 @@ using namespace std;
 
 OPENEXR_IMF_INTERNAL_NAMESPACE_SOURCE_ENTER
 
+namespace
+{
+
+//
+// Shrink rows y0 to y1 - 1 of a channel horizontally.  The rows
+// are numbered relative to the top of the data window.
+//
+
+template <class T>
+void
+reduceRowsX (
+    const TypedFlatImageChannel<T>& c0,
+    TypedFlatImageChannel<T>&       c1,
+    const LevelReducer&             reducer,
+    int                             y0,
+    int                             y1)
+{
+    const Box2i&          dw0 = c0.level ().dataWindow ();
+    const Box2i&          dw1 = c1.level ().dataWindow ();
+    LevelReducer::Scratch scratch;
+
+    for (int y = y0; y < y1; ++y)
+    {
+        reducer.reduceRow (
+            &c0 (dw0.min.x, dw0.min.y + y),
+            &c1 (dw1.min.x, dw1.min.y + y),
+            scratch);
+    }
+}
+
+//
+// Shrink a channel vertically, computing rows y0 to y1 - 1 of the
+// smaller level.
+//
+
+template <class T>
+void
+reduceRowsY (
+    const TypedFlatImageChannel<T>& c0,
+    TypedFlatImageChannel<T>&       c1,
+    const LevelReducer&             reducer,
+    int                             y0,
+    int                             y1)
+{
+    const Box2i&          dw0 = c0.level ().dataWindow ();
+    const Box2i&          dw1 = c1.level ().dataWindow ();
+    int                   w   = dw1.max.x - dw1.min.x + 1;
+    LevelReducer::Scratch scratch;
+
+    for (int y = y0; y < y1; ++y)
+    {
+        const T* rows[LevelReducer::NUM_TAPS];
+
+        for (int k = 0; k < LevelReducer::NUM_TAPS; ++k)
+        {
+            rows[k] = (reducer.weight (y, k) != 0)
+                          ? &c0 (dw0.min.x, dw0.min.y + reducer.index (y, k))
+                          : 0;
+        }
+
+        reducer.reduceRows (
+            y, rows, &c1 (dw1.min.x, dw1.min.y + y), w, scratch);
+    }
+}
+
+//
+// A RowsTask calls a function for a range of rows.
+//
+
+class RowsTask : public ILMTHREAD_NAMESPACE::Task
+{
+public:
+    RowsTask (
+        ILMTHREAD_NAMESPACE::TaskGroup*   group,
+        const function<void (int, int)>& rows,
+        int                              y0,
+        int                              y1,
+        std::mutex&                      errorMutex,
+        std::exception_ptr&              error)
+        : Task (group)
+        , _rows (rows)
+        , _y0 (y0)
+        , _y1 (y1)
+        , _errorMutex (errorMutex)
+        , _error (error)
+    {}
+
+    void execute () override
+    {
+        try
+        {
+            _rows (_y0, _y1);
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock (_errorMutex);
+            if (!_error) _error = std::current_exception ();
+        }
+    }
+
+private:
+    const function<void (int, int)>& _rows;
+    int                              _y0;
+    int                              _y1;
+    std::mutex&                      _errorMutex;
+    std::exception_ptr&              _error;
+};
+
+//
+// Call rows(y0,y1) for ranges of rows that together cover rows 0
+// to n - 1.  The ranges are processed in parallel by the global
+// thread pool, unless there is too little work to go around, or
+// we are running in a task of the pool ourselves, where waiting
+// for more tasks could tie up all the pool's threads.
+//
+
+void
+forEachRowRange (
+    int n, size_t valuesPerRow, const function<void (int, int)>& rows)
+{
+    const size_t minValuesPerTask = 1 << 14;
+
+    size_t numTasks = std::min (
+        size_t (n) * valuesPerRow / minValuesPerTask,
+        std::min (size_t (n), size_t (globalThreadCount ()) * 4));
+
+    if (numTasks < 2 || ILMTHREAD_NAMESPACE::TaskGroup::current ())
+    {
+        rows (0, n);
+        return;
+    }
+
+    std::mutex         errorMutex;
+    std::exception_ptr error;
+
+    {
+        ILMTHREAD_NAMESPACE::TaskGroup group;
+
+        for (size_t i = 0; i < numTasks; ++i)
+        {
+            int y0 = int (n * i / numTasks);
+            int y1 = int (n * (i + 1) / numTasks);
+
+            ILMTHREAD_NAMESPACE::ThreadPool::addGlobalTask (
+                new RowsTask (&group, rows, y0, y1, errorMutex, error));
+        }
+    }
+
+    if (error) std::rethrow_exception (error);
+}
+
+size_t
+numChannels (const FlatImageLevel& level)
+{
+    size_t n = 0;
+
+    for (FlatImageLevel::ConstIterator i = level.begin (); i != level.end ();
+         ++i)
+        ++n;
+
+    return n;
+}
+
+} // namespace
+
+void
+reduceLevel (
+    const FlatImageLevel& level0,
+    FlatImageLevel&       level1,
+    const LevelFilter&    filter,
+    bool                  horizontal,
+    bool                  odd)
+{
+    const Box2i&  dw0  = level0.dataWindow ();
+    const Box2i&  dw1  = level1.dataWindow ();
+    LevelWrapMode wrap = horizontal ? filter.wrapX : filter.wrapY;
+
+    int w0 = dw0.max.x - dw0.min.x + 1;
+    int h0 = dw0.max.y - dw0.min.y + 1;
+    int w1 = dw1.max.x - dw1.min.x + 1;
+    int h1 = dw1.max.y - dw1.min.y + 1;
+    int n0 = horizontal ? w0 : h0;
+    int n1 = horizontal ? w1 : h1;
+
+    LevelReducer filtered (n0, n1, true, wrap, odd);
+    LevelReducer skipped (n0, n1, false, wrap, odd);
+
+    function<void (int, int)> rows = [&] (int y0, int y1) {
+        for (FlatImageLevel::ConstIterator i = level0.begin ();
+             i != level0.end ();
+             ++i)
+        {
+            const string& name = i.name ();
+            bool f = filter.doNotFilter.find (name) ==
+                     filter.doNotFilter.end ();
+
+            const LevelReducer& reducer = f ? filtered : skipped;
+
+            switch (i.channel ().pixelType ())
+            {
+                case HALF:
+
+                    (horizontal ? reduceRowsX<half> : reduceRowsY<half>) (
+                        level0.typedChannel<half> (name),
+                        level1.typedChannel<half> (name),
+                        reducer,
+                        y0,
+                        y1);
+                    break;
+
+                case FLOAT:
+
+                    (horizontal ? reduceRowsX<float> : reduceRowsY<float>) (
+                        level0.typedChannel<float> (name),
+                        level1.typedChannel<float> (name),
+                        reducer,
+                        y0,
+                        y1);
+                    break;
+
+                case UINT:
+
+                    (horizontal ? reduceRowsX<unsigned int>
+                                : reduceRowsY<unsigned int>) (
+                        level0.typedChannel<unsigned int> (name),
+                        level1.typedChannel<unsigned int> (name),
+                        reducer,
+                        y0,
+                        y1);
+                    break;
+
+                default: assert (false);
+            }
+        }
+    };
+
+    forEachRowRange (h1, size_t (w1) * numChannels (level0), rows);
+}
+
 FlatImage::FlatImage () : Image ()
 {
     resize (Box2i (V2i (0, 0), V2i (-1, -1)), ONE_LEVEL, ROUND_DOWN);
@@ -62,6 +308,72 @@ FlatImage::level (int lx, int ly) const
     return static_cast<const FlatImageLevel&> (Image::level (lx, ly));
 }
 
+void
+FlatImage::generateLevels (const LevelFilter& filter)
+{
+    if (levelMode () == ONE_LEVEL || dataWindow ().isEmpty ()) return;
+
+    if (levelMode () == MIPMAP_LEVELS)
+    {
+        //
+        // Shrink each level horizontally into a temporary
+        // image, and from there vertically into the next level.
+        //
+
+        FlatImage tmp;
+
+        for (FlatImageLevel::ConstIterator i = level ().begin ();
+             i != level ().end ();
+             ++i)
+            tmp.insertChannel (i.name (), i.channel ().channel ());
+
+        for (int l = 1; l < numLevels (); ++l)
+        {
+            const Box2i& dw = dataWindow ();
+
+            tmp.resize (
+                Box2i (
+                    dw.min,
+                    dw.min + V2i (levelWidth (l) - 1, levelHeight (l - 1) - 1)),
+                ONE_LEVEL,
+                ROUND_DOWN);
+
+            reduceLevel (level (l - 1), tmp.level (), filter, true, l & 1);
+            reduceLevel (tmp.level (), level (l), filter, false, l & 1);
+        }
+    }
+    else
+    {
+        //
+        // Shrink level (0, ly - 1) vertically into level (0, ly),
+        // and level (lx - 1, ly) horizontally into level (lx, ly).
+        //
+
+        for (int ly = 0; ly < numYLevels (); ++ly)
+        {
+            if (ly > 0)
+            {
+                reduceLevel (
+                    level (0, ly - 1),
+                    level (0, ly),
+                    filter,
+                    false,
+                    (ly - 1) & 1);
+            }
+
+            for (int lx = 1; lx < numXLevels (); ++lx)
+            {
+                reduceLevel (
+                    level (lx - 1, ly),
+                    level (lx, ly),
+                    filter,
+                    true,
+                    (lx - 1) & 1);
+            }
+        }
+    }
+}
+
 FlatImageLevel*
 FlatImage::newLevel (int lx, int ly, const Box2i& dataWindow)
 {
@@ -8,7 +8,8 @@
 
 //----------------------------------------------------------------------------
 //
-//      class FlatImage
+//      class FlatImage,
+//      function reduceLevel()
 //
 //      For an explanation of images, levels and channels,
 //      see the comments in header file Image.h.
@@ -17,6 +18,7 @@
 
 #include "ImfFlatImageLevel.h"
 #include "ImfImage.h"
+#include "ImfLevelFilter.h"
 #include "ImfUtilExport.h"
 
 #include "ImfTileDescription.h"
@@ -52,11 +54,54 @@ public:
     IMFUTIL_EXPORT virtual FlatImageLevel&       level (int lx, int ly);
     IMFUTIL_EXPORT virtual const FlatImageLevel& level (int lx, int ly) const;
 
+    //
+    // Computing the lower-resolution levels of a multi-resolution image:
+    //
+    // generateLevels(f) fills all levels of the image, except level
+    // (0,0), with successively downsampled copies of level (0,0).  Each
+    // level is computed from the next larger level by shrinking it by
+    // a factor of two, horizontally, vertically, or both, using a
+    // separable four-tap low-pass filter.  The filter extends the image
+    // beyond its edges according to f.wrapX and f.wrapY.  The channels
+    // listed in f.doNotFilter are not low-pass filtered; they are
+    // resampled by skipping every other pixel.
+    //
+    // The image's level mode and rounding mode, set by resize(), decide
+    // which levels are generated.  If the level mode is ONE_LEVEL, then
+    // generateLevels() does nothing.  The rows of each level are
+    // computed in parallel, using the global thread pool.
+    //
+
+    IMFUTIL_EXPORT
+    void generateLevels (const LevelFilter& filter = LevelFilter ());
+
 protected:
     IMFUTIL_EXPORT virtual FlatImageLevel*
     newLevel (int lx, int ly, const IMATH_NAMESPACE::Box2i& dataWindow);
 };
 
+//
+// reduceLevel(l0, l1, f, horizontal, odd) computes one image level
+// from another the way FlatImage::generateLevels() does: it shrinks
+// all channels of level l0 horizontally or vertically to the size of
+// level l1, and stores the result in l1.  The levels may belong to
+// different images, for example to ONE_LEVEL images that each hold
+// one level, so that a program can compute and write the levels of a
+// large image one at a time.  l1 must have all channels of l0.
+//
+// odd is passed on to LevelReducer.  generateLevels() computes mipmap
+// level l with odd = l & 1, and ripmap level lx (or ly) from the level
+// before it in the direction of the shrink with odd = (lx - 1) & 1.
+//
+
+IMFUTIL_EXPORT
+void reduceLevel (
+    const FlatImageLevel& l0,
+    FlatImageLevel&       l1,
+    const LevelFilter&    filter,
+    bool                  horizontal,
+    bool                  odd);
+
 OPENEXR_IMF_INTERNAL_NAMESPACE_HEADER_EXIT
 
 #endif
@@ -11,15 +11,22 @@
 
 #include "ImfFlatImageIO.h"
 #include <Iex.h>
+#include <IlmThreadPool.h>
 #include <ImfChannelList.h>
 #include <ImfHeader.h>
 #include <ImfInputFile.h>
 #include <ImfOutputFile.h>
 #include <ImfTestFile.h>
+#include <ImfThreading.h>
 #include <ImfTiledInputFile.h>
 #include <ImfTiledOutputFile.h>
+#include <atomic>
 #include <cassert>
 #include <cstring>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <vector>
 
 using namespace IMATH_NAMESPACE;
 using namespace IEX_NAMESPACE;
@@ -180,18 +187,21 @@ loadFlatScanLineImage (const string& fileName, FlatImage& img)
 namespace
 {
 
-void
-saveLevel (TiledOutputFile& out, const FlatImage& img, int x, int y)
+//
+// a frame buffer whose slices point directly into the
+// channels of an image level
+//
+
+FrameBuffer
+levelFrameBuffer (const FlatImageLevel& level)
 {
-    const FlatImageLevel& level = img.level (x, y);
-    FrameBuffer           fb;
+    FrameBuffer fb;
 
     for (FlatImageLevel::ConstIterator i = level.begin (); i != level.end ();
          ++i)
         fb.insert (i.name (), i.channel ().slice ());
 
-    out.setFrameBuffer (fb);
-    out.writeTiles (0, out.numXTiles (x) - 1, 0, out.numYTiles (y) - 1, x, y);
+    return fb;
 }
 
 } // namespace
@@ -241,14 +251,20 @@ saveFlatTiledImage (
 
     TiledOutputFile out (fileName.c_str (), newHdr);
 
+    //
+    // the tiles of all levels are compressed in a single pass
+    //
+
+    vector<FrameBuffer> fbs;
+
     switch (img.levelMode ())
     {
-        case ONE_LEVEL: saveLevel (out, img, 0, 0); break;
+        case ONE_LEVEL: fbs.push_back (levelFrameBuffer (img.level ())); break;
 
         case MIPMAP_LEVELS:
 
             for (int x = 0; x < out.numLevels (); ++x)
-                saveLevel (out, img, x, x);
+                fbs.push_back (levelFrameBuffer (img.level (x, x)));
 
             break;
 
@@ -256,12 +272,14 @@ saveFlatTiledImage (
 
             for (int y = 0; y < out.numYLevels (); ++y)
                 for (int x = 0; x < out.numXLevels (); ++x)
-                    saveLevel (out, img, x, y);
+                    fbs.push_back (levelFrameBuffer (img.level (x, y)));
 
             break;
 
         default: assert (false);
     }
+
+    out.writeLevels (fbs);
 }
 
 void
@@ -278,15 +296,128 @@ namespace
 void
 loadLevel (TiledInputFile& in, FlatImage& img, int x, int y)
 {
-    FlatImageLevel& level = img.level (x, y);
-    FrameBuffer     fb;
+    in.setFrameBuffer (levelFrameBuffer (img.level (x, y)));
+    in.readTiles (0, in.numXTiles (x) - 1, 0, in.numYTiles (y) - 1, x, y);
+}
 
-    for (FlatImageLevel::ConstIterator i = level.begin (); i != level.end ();
-         ++i)
-        fb.insert (i.name (), i.channel ().slice ());
+//
+// one row of tiles of one level of a multi-level image
+//
 
-    in.setFrameBuffer (fb);
-    in.readTiles (0, in.numXTiles (x) - 1, 0, in.numYTiles (y) - 1, x, y);
+struct TileRow
+{
+    int lx;
+    int ly;
+    int dy;
+};
+
+//
+// A LoadTilesTask reads rows of tiles, taken from a list shared with
+// the other tasks, until the list is exhausted.  Each task reads
+// through its own TiledInputFile, without threads of its own, so the
+// levels of an image are read concurrently, and small levels do not
+// leave threads idle.
+//
+
+class LoadTilesTask : public ILMTHREAD_NAMESPACE::Task
+{
+public:
+    LoadTilesTask (
+        ILMTHREAD_NAMESPACE::TaskGroup* group,
+        const string&                   fileName,
+        FlatImage&                      img,
+        const vector<TileRow>&          rows,
+        std::atomic<size_t>&            nextRow,
+        std::mutex&                     errorMutex,
+        std::exception_ptr&             error)
+        : Task (group)
+        , _fileName (fileName)
+        , _img (img)
+        , _rows (rows)
+        , _nextRow (nextRow)
+        , _errorMutex (errorMutex)
+        , _error (error)
+    {}
+
+    void execute () override
+    {
+        try
+        {
+            TiledInputFile in (_fileName.c_str (), 0);
+            int            lx = -1;
+            int            ly = -1;
+
+            for (size_t r = _nextRow++; r < _rows.size (); r = _nextRow++)
+            {
+                const TileRow& row = _rows[r];
+
+                if (row.lx != lx || row.ly != ly)
+                {
+                    lx = row.lx;
+                    ly = row.ly;
+                    in.setFrameBuffer (levelFrameBuffer (_img.level (lx, ly)));
+                }
+
+                in.readTiles (0, in.numXTiles (lx) - 1, row.dy, row.dy, lx, ly);
+            }
+        }
+        catch (...)
+        {
+            // stop the other tasks
+            _nextRow = _rows.size ();
+
+            std::lock_guard<std::mutex> lock (_errorMutex);
+            if (!_error) _error = std::current_exception ();
+        }
+    }
+
+private:
+    const string&          _fileName;
+    FlatImage&             _img;
+    const vector<TileRow>& _rows;
+    std::atomic<size_t>&   _nextRow;
+    std::mutex&            _errorMutex;
+    std::exception_ptr&    _error;
+};
+
+void
+loadLevels (const string& fileName, TiledInputFile& in, FlatImage& img)
+{
+    //
+    // list the tile rows of all levels, in the order in which
+    // they are stored in the file
+    //
+
+    vector<TileRow> rows;
+
+    for (int y = 0; y < img.numYLevels (); ++y)
+    {
+        for (int x = 0; x < img.numXLevels (); ++x)
+        {
+            if (!in.isValidLevel (x, y)) continue;
+
+            for (int dy = 0; dy < in.numYTiles (y); ++dy)
+                rows.push_back ({x, y, dy});
+        }
+    }
+
+    int numTasks = int (std::min (rows.size (), size_t (globalThreadCount ())));
+
+    std::atomic<size_t> nextRow (0);
+    std::mutex          errorMutex;
+    std::exception_ptr  error;
+
+    {
+        ILMTHREAD_NAMESPACE::TaskGroup group;
+
+        for (int t = 0; t < numTasks; ++t)
+        {
+            ILMTHREAD_NAMESPACE::ThreadPool::addGlobalTask (new LoadTilesTask (
+                &group, fileName, img, rows, nextRow, errorMutex, error));
+        }
+    }
+
+    if (error) std::rethrow_exception (error);
 }
 
 } // namespace
@@ -308,26 +439,42 @@ loadFlatTiledImage (const string& fileName, Header& hdr, FlatImage& img)
         in.header ().tileDescription ().mode,
         in.header ().tileDescription ().roundingMode);
 
-    switch (img.levelMode ())
+    //
+    // The tiles of a single level are already read in parallel by
+    // TiledInputFile.  The levels of a mipmap or ripmap are read
+    // concurrently, unless we are running in a task of the thread
+    // pool ourselves, where waiting for more tasks could tie up all
+    // the pool's threads.
+    //
+
+    bool concurrentLevels = img.levelMode () != ONE_LEVEL &&
+                            globalThreadCount () > 1 &&
+                            !ILMTHREAD_NAMESPACE::TaskGroup::current ();
+
+    if (concurrentLevels) { loadLevels (fileName, in, img); }
+    else
     {
-        case ONE_LEVEL: loadLevel (in, img, 0, 0); break;
+        switch (img.levelMode ())
+        {
+            case ONE_LEVEL: loadLevel (in, img, 0, 0); break;
 
-        case MIPMAP_LEVELS:
+            case MIPMAP_LEVELS:
 
-            for (int x = 0; x < img.numLevels (); ++x)
-                loadLevel (in, img, x, x);
+                for (int x = 0; x < img.numLevels (); ++x)
+                    loadLevel (in, img, x, x);
 
-            break;
+                break;
 
-        case RIPMAP_LEVELS:
+            case RIPMAP_LEVELS:
 
-            for (int y = 0; y < img.numYLevels (); ++y)
-                for (int x = 0; x < img.numXLevels (); ++x)
-                    loadLevel (in, img, x, y);
+                for (int y = 0; y < img.numYLevels (); ++y)
+                    for (int x = 0; x < img.numXLevels (); ++x)
+                        loadLevel (in, img, x, y);
 
-            break;
+                break;
 
-        default: assert (false);
+            default: assert (false);
+        }
     }
 
     for (Header::ConstIterator i = in.header ().begin ();
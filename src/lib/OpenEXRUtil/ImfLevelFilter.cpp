@@ -0,0 +1,299 @@
+//
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) Contributors to the OpenEXR Project.
+//
+
+//----------------------------------------------------------------------------
+//
+//      class LevelReducer
+//
+//----------------------------------------------------------------------------
+
+#include "ImfLevelFilter.h"
+#include <Iex.h>
+#include <ImathFun.h>
+#include <algorithm>
+
+using namespace IMATH_NAMESPACE;
+using namespace IEX_NAMESPACE;
+using namespace std;
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_SOURCE_ENTER
+
+namespace
+{
+
+//
+// The index in [0, n) of pixel x of a row or column of n pixels that
+// is extended beyond its ends according to wrap mode m, or -1 if the
+// pixel is black.
+//
+
+int
+wrapIndex (int x, int n, LevelWrapMode m)
+{
+    if (x >= 0 && x < n) return x;
+
+    switch (m)
+    {
+        case WRAP_BLACK: return -1;
+
+        case WRAP_PERIODIC: return modp (x, n);
+
+        case WRAP_MIRROR:
+        {
+            int d = divp (x, n);
+            int r = modp (x, n);
+            return (d & 1) ? n - 1 - r : r;
+        }
+
+        default: return IMATH_NAMESPACE::clamp (x, 0, n - 1);
+    }
+}
+
+//
+// Type in which the filtered values of a channel are accumulated;
+// float keeps the inner loops short and vectorizable, double keeps
+// large UINT values exact.
+//
+
+template <class T> struct Accumulator
+{
+    typedef float type;
+};
+
+template <> struct Accumulator<unsigned int>
+{
+    typedef double type;
+};
+
+} // namespace
+
+//
+// With filtering, a four-tap filter with weights 1/8, 3/8, 3/8, 1/8
+// is centered on position 0.5 of the source for pixel 0, and on
+// position n0 - 1.5 for pixel n1 - 1.  In between, the center of the
+// filter moves in equal steps, and the filter samples the source by
+// interpolating linearly between adjacent pixels.  Combining the
+// interpolation with the filter yields five taps.
+//
+// Without filtering, every other pixel is picked.  In order to keep
+// the image from sliding to one side if it is shrunk repeatedly, the
+// last pixel is skipped on even passes, and the first one on odd
+// passes.  For level sizes produced by the library the picked index
+// always lies inside the row; it is clamped anyway so that other n1
+// values cannot read outside it.
+//
+
+LevelReducer::LevelReducer (
+    int n0, int n1, bool filter, LevelWrapMode wrap, bool odd)
+    : _n0 (n0), _n1 (n1), _filter (filter), _taps (n1)
+{
+    if (n0 < 1 || n1 < 1 || n1 > n0)
+        THROW (
+            ArgExc,
+            "Cannot shrink " << n0 << " pixels to " << n1 << " pixels.");
+
+    if (filter)
+    {
+        double f = (n1 > 1) ? double (n0 - 2) / (n1 - 1) : 1;
+
+        for (int i = 0; i < n1; ++i)
+        {
+            double c = i * f;
+            int    x = IMATH_NAMESPACE::floor (c);
+            double t = c - x;
+            double s = 1 - t;
+
+            const double w[NUM_TAPS] = {
+                0.125 * s,
+                0.375 * s + 0.125 * t,
+                0.375 * s + 0.375 * t,
+                0.125 * s + 0.375 * t,
+                0.125 * t};
+
+            for (int k = 0; k < NUM_TAPS; ++k)
+            {
+                int j = wrapIndex (x - 1 + k, n0, wrap);
+
+                _taps[i].index[k]  = std::max (j, 0);
+                _taps[i].weight[k] = (j < 0) ? 0.0 : w[k];
+            }
+        }
+    }
+    else
+    {
+        int offset = odd ? ((n0 - 1) - 2 * (n1 - 1)) : 0;
+
+        for (int i = 0; i < n1; ++i)
+        {
+            for (int k = 0; k < NUM_TAPS; ++k)
+            {
+                _taps[i].index[k]  = 0;
+                _taps[i].weight[k] = 0;
+            }
+
+            int j = std::min (2 * i + offset, n0 - 1);
+
+            _taps[i].index[0]  = std::max (j, 0);
+            _taps[i].weight[0] = 1;
+        }
+    }
+}
+
+int
+LevelReducer::firstIndex (int i) const
+{
+    int first = _n0;
+
+    for (int k = 0; k < NUM_TAPS; ++k)
+        if (_taps[i].weight[k] != 0) first = min (first, _taps[i].index[k]);
+
+    return first;
+}
+
+int
+LevelReducer::lastIndex (int i) const
+{
+    int last = -1;
+
+    for (int k = 0; k < NUM_TAPS; ++k)
+        if (_taps[i].weight[k] != 0) last = max (last, _taps[i].index[k]);
+
+    return last;
+}
+
+float*
+LevelReducer::buffer (Scratch& scratch, size_t n, float)
+{
+    if (scratch._floats.size () < n) scratch._floats.resize (n);
+    return scratch._floats.data ();
+}
+
+double*
+LevelReducer::buffer (Scratch& scratch, size_t n, double)
+{
+    if (scratch._doubles.size () < n) scratch._doubles.resize (n);
+    return scratch._doubles.data ();
+}
+
+template <class T>
+void
+LevelReducer::reduceRowImpl (const T* src, T* dst, Scratch& scratch) const
+{
+    typedef typename Accumulator<T>::type A;
+
+    if (!_filter)
+    {
+        for (int x = 0; x < _n1; ++x)
+            dst[x] = src[_taps[x].index[0]];
+
+        return;
+    }
+
+    A* in = buffer (scratch, size_t (_n0), A ());
+    std::copy (src, src + _n0, in);
+
+    for (int x = 0; x < _n1; ++x)
+    {
+        const Taps& t = _taps[x];
+        A           v = 0;
+
+        for (int k = 0; k < NUM_TAPS; ++k)
+            v += A (t.weight[k]) * in[t.index[k]];
+
+        dst[x] = T (v);
+    }
+}
+
+template <class T>
+void
+LevelReducer::reduceRowsImpl (
+    int i, const T* const rows[], T* dst, int width, Scratch& scratch) const
+{
+    typedef typename Accumulator<T>::type A;
+
+    const Taps& t = _taps[i];
+
+    if (!_filter)
+    {
+        std::copy (rows[0], rows[0] + width, dst);
+        return;
+    }
+
+    //
+    // Accumulate one source row at a time, so that the
+    // inner loop runs over contiguous pixels.
+    //
+
+    A* acc = buffer (scratch, size_t (width), A ());
+    std::fill (acc, acc + width, A (0));
+
+    for (int k = 0; k < NUM_TAPS; ++k)
+    {
+        if (t.weight[k] == 0) continue;
+
+        const T* src = rows[k];
+        A        wk  = A (t.weight[k]);
+
+        for (int x = 0; x < width; ++x)
+            acc[x] += wk * A (src[x]);
+    }
+
+    for (int x = 0; x < width; ++x)
+        dst[x] = T (acc[x]);
+}
+
+void
+LevelReducer::reduceRow (const half* src, half* dst, Scratch& scratch) const
+{
+    reduceRowImpl (src, dst, scratch);
+}
+
+void
+LevelReducer::reduceRow (const float* src, float* dst, Scratch& scratch) const
+{
+    reduceRowImpl (src, dst, scratch);
+}
+
+void
+LevelReducer::reduceRow (
+    const unsigned int* src, unsigned int* dst, Scratch& scratch) const
+{
+    reduceRowImpl (src, dst, scratch);
+}
+
+void
+LevelReducer::reduceRows (
+    int               i,
+    const half* const rows[],
+    half*             dst,
+    int               width,
+    Scratch&          scratch) const
+{
+    reduceRowsImpl (i, rows, dst, width, scratch);
+}
+
+void
+LevelReducer::reduceRows (
+    int                i,
+    const float* const rows[],
+    float*             dst,
+    int                width,
+    Scratch&           scratch) const
+{
+    reduceRowsImpl (i, rows, dst, width, scratch);
+}
+
+void
+LevelReducer::reduceRows (
+    int                       i,
+    const unsigned int* const rows[],
+    unsigned int*             dst,
+    int                       width,
+    Scratch&                  scratch) const
+{
+    reduceRowsImpl (i, rows, dst, width, scratch);
+}
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_SOURCE_EXIT
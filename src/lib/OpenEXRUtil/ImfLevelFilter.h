@@ -0,0 +1,188 @@
+//
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) Contributors to the OpenEXR Project.
+//
+
+#ifndef INCLUDED_IMF_LEVEL_FILTER_H
+#define INCLUDED_IMF_LEVEL_FILTER_H
+
+//----------------------------------------------------------------------------
+//
+//      enum LevelWrapMode,
+//      struct LevelFilter,
+//      class LevelReducer
+//
+//      Options that control how FlatImage::generateLevels() computes
+//      the lower-resolution levels of a mipmap or ripmap image, and
+//      the filter that it uses.
+//
+//----------------------------------------------------------------------------
+
+#include "ImfNamespace.h"
+#include "ImfUtilExport.h"
+
+#include <half.h>
+#include <set>
+#include <string>
+#include <vector>
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_HEADER_ENTER
+
+//
+// How the low-pass filter extends an image level beyond its edges:
+//
+//  WRAP_BLACK      pixels outside the level are zero
+//
+//  WRAP_CLAMP      pixels outside the level repeat the nearest edge pixel
+//
+//  WRAP_PERIODIC   the level repeats, like the tiles of a wallpaper
+//
+//  WRAP_MIRROR     the level repeats, with every other copy mirrored
+//
+// The names of the modes match the strings stored in the "wrapmodes"
+// attribute of a texture file; see ImfStandardAttributes.h.
+//
+
+enum IMFUTIL_EXPORT_ENUM LevelWrapMode
+{
+    WRAP_BLACK,
+    WRAP_CLAMP,
+    WRAP_PERIODIC,
+    WRAP_MIRROR,
+
+    NUM_LEVELWRAPMODES // number of different wrap modes
+};
+
+struct IMFUTIL_EXPORT_TYPE LevelFilter
+{
+    //
+    // Wrap modes in the horizontal and vertical direction
+    //
+
+    LevelWrapMode wrapX;
+    LevelWrapMode wrapY;
+
+    //
+    // Channels that are resampled by picking every other pixel,
+    // without low-pass filtering, for example channels that
+    // contain object identifiers rather than light levels.
+    //
+
+    std::set<std::string> doNotFilter;
+
+    LevelFilter (LevelWrapMode x = WRAP_CLAMP, LevelWrapMode y = WRAP_CLAMP)
+        : wrapX (x), wrapY (y)
+    {}
+};
+
+//
+// A LevelReducer shrinks the rows or the columns of one image level
+// to the size of the next smaller level, the same way as
+// FlatImage::generateLevels().  It lets programs generate the levels
+// of an image that is too large to be held in memory a few rows at
+// a time.
+//
+// Pixel i of the result is a weighted sum of up to NUM_TAPS pixels of
+// the source, pixels index(i,0) through index(i,NUM_TAPS-1); the
+// taps whose weight is zero can be ignored.  lastIndex(i) is the
+// highest index of a tap with a non-zero weight, and firstIndex(i)
+// the lowest.
+//
+// reduceRow() shrinks a row of n0 pixels to n1 pixels.
+//
+// reduceRows() computes row i of a vertically shrunk level: rows[k]
+// must point to the source row index(i,k), or may be 0 if the tap's
+// weight is zero.  All rows are width pixels wide.
+//
+// Both functions accumulate the filtered values in a Scratch object
+// that the caller owns, so that shrinking many rows does not allocate
+// memory for each row.  A Scratch object can be used with any
+// LevelReducer, but only by one thread at a time.
+//
+
+class IMFUTIL_EXPORT_TYPE LevelReducer
+{
+public:
+    static const int NUM_TAPS = 5;
+
+    class Scratch
+    {
+        friend class LevelReducer;
+
+        std::vector<float>  _floats;
+        std::vector<double> _doubles;
+    };
+
+    //
+    // Constructor: shrink n0 pixels to n1 pixels.  If filter is true,
+    // the pixels are low-pass filtered, and the source is extended
+    // beyond its ends according to wrap mode wrap.  Otherwise every
+    // other pixel is picked, skipping the first pixel if odd is true,
+    // or the last pixel if odd is false.
+    //
+
+    IMFUTIL_EXPORT
+    LevelReducer (int n0, int n1, bool filter, LevelWrapMode wrap, bool odd);
+
+    int size0 () const { return _n0; }
+    int size1 () const { return _n1; }
+
+    int index (int i, int k) const { return _taps[i].index[k]; }
+    double weight (int i, int k) const { return _taps[i].weight[k]; }
+
+    IMFUTIL_EXPORT int firstIndex (int i) const;
+    IMFUTIL_EXPORT int lastIndex (int i) const;
+
+    IMFUTIL_EXPORT void
+    reduceRow (const half* src, half* dst, Scratch& scratch) const;
+    IMFUTIL_EXPORT void
+    reduceRow (const float* src, float* dst, Scratch& scratch) const;
+    IMFUTIL_EXPORT void reduceRow (
+        const unsigned int* src, unsigned int* dst, Scratch& scratch) const;
+
+    IMFUTIL_EXPORT void reduceRows (
+        int               i,
+        const half* const rows[],
+        half*             dst,
+        int               width,
+        Scratch&          scratch) const;
+    IMFUTIL_EXPORT void reduceRows (
+        int                i,
+        const float* const rows[],
+        float*             dst,
+        int                width,
+        Scratch&           scratch) const;
+    IMFUTIL_EXPORT void reduceRows (
+        int                       i,
+        const unsigned int* const rows[],
+        unsigned int*             dst,
+        int                       width,
+        Scratch&                  scratch) const;
+
+private:
+    struct Taps
+    {
+        int    index[NUM_TAPS];
+        double weight[NUM_TAPS];
+    };
+
+    static float*  buffer (Scratch& scratch, size_t n, float);
+    static double* buffer (Scratch& scratch, size_t n, double);
+
+    template <class T>
+    void reduceRowImpl (const T* src, T* dst, Scratch& scratch) const;
+
+    template <class T>
+    void reduceRowsImpl (
+        int i, const T* const rows[], T* dst, int width, Scratch& scratch)
+        const;
+
+    int               _n0;
+    int               _n1;
+    bool              _filter;
+    std::vector<Taps> _taps;
+};
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_HEADER_EXIT
+
+#endif
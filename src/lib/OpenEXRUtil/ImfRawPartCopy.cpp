@@ -0,0 +1,860 @@
+//
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) Contributors to the OpenEXR Project.
+//
+
+//----------------------------------------------------------------------------
+//
+//      function copyRawParts()
+//
+//----------------------------------------------------------------------------
+
+#include "ImfRawPartCopy.h"
+#include "ImfCoreChunks.h"
+#include <Iex.h>
+
+#include "openexr.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <queue>
+
+using namespace std;
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_SOURCE_ENTER
+
+namespace
+{
+
+//
+// size of the blocks in which files are read and written
+//
+
+const uint64_t gBlockSize = 8 << 20;
+
+//
+// The last error message the Core library reported on this thread.
+// Every failed call is reported right away, so the message belongs
+// to the file whose call failed.  (The handler cannot look up the
+// context's user data: while a header is being defined, the context
+// is locked when the handler runs.)
+//
+
+thread_local string tLastMessage;
+
+void
+errorHandler (exr_const_context_t, int, const char* msg)
+{
+    tLastMessage = msg ? msg : "";
+}
+
+//
+// Check whether two names refer to the same file, even if the names
+// differ, for example "x.exr" and "./x.exr", or a link.  Names of
+// files that do not exist yet are compared as normalized paths.
+//
+
+bool
+sameFile (const string& fileName1, const string& fileName2)
+{
+    if (fileName1 == fileName2) return true;
+
+    std::error_code ec;
+
+    if (filesystem::equivalent (fileName1, fileName2, ec)) return true;
+
+    filesystem::path p1 = filesystem::weakly_canonical (fileName1, ec);
+    if (ec) return false;
+
+    filesystem::path p2 = filesystem::weakly_canonical (fileName2, ec);
+    if (ec) return false;
+
+    return p1 == p2;
+}
+
+//
+// a file that is read or written through the Core library
+//
+
+struct CoreStream
+{
+    string fileName;
+
+    string error (exr_result_t rv) const
+    {
+        string message;
+        message.swap (tLastMessage);
+
+        return message.empty () ? exr_get_default_error_message (rv)
+                                : message;
+    }
+};
+
+//
+// A BlockReader serves the Core library's read requests from a buffer
+// that holds a large block of the file.  When a request falls outside
+// the buffer, the block that is read next starts at the request, or
+// ends with it if the file is being read backwards.
+//
+
+class BlockReader : public CoreStream
+{
+public:
+    BlockReader (const string& name) : _size (0), _start (0)
+    {
+        fileName = name;
+
+        _is.open (name.c_str (), ios_base::binary);
+
+        if (!_is)
+            IEX_NAMESPACE::throwErrnoExc (
+                "Cannot open image file \"" + name + "\". %T.");
+
+        _is.seekg (0, ios_base::end);
+        _size = uint64_t (_is.tellg ());
+    }
+
+    uint64_t size () const { return _size; }
+
+    int64_t read (void* buffer, uint64_t sz, uint64_t offset)
+    {
+        if (offset >= _size) return 0;
+
+        sz = min (sz, _size - offset);
+
+        if (sz >= gBlockSize) return readFile (buffer, sz, offset) ? sz : -1;
+
+        if (offset < _start || offset + sz > _start + _block.size ())
+        {
+            uint64_t start = offset;
+
+            if (offset < _start && offset + sz > gBlockSize)
+                start = offset + sz - gBlockSize;
+            else if (offset < _start)
+                start = 0;
+
+            _block.resize (size_t (min (gBlockSize, _size - start)));
+            _start = start;
+
+            if (!readFile (&_block[0], _block.size (), _start))
+            {
+                _block.clear ();
+                return -1;
+            }
+        }
+
+        memcpy (buffer, &_block[size_t (offset - _start)], size_t (sz));
+        return int64_t (sz);
+    }
+
+    static int64_t readFn (
+        exr_const_context_t,
+        void*    userdata,
+        void*    buffer,
+        uint64_t sz,
+        uint64_t offset,
+        exr_stream_error_func_ptr_t)
+    {
+        BlockReader* reader = static_cast<BlockReader*> (userdata);
+        return reader->read (buffer, sz, offset);
+    }
+
+    static int64_t sizeFn (exr_const_context_t, void* userdata)
+    {
+        return int64_t (static_cast<BlockReader*> (userdata)->size ());
+    }
+
+private:
+    bool readFile (void* buffer, uint64_t sz, uint64_t offset)
+    {
+        _is.clear ();
+        _is.seekg (streamoff (offset));
+        _is.read (static_cast<char*> (buffer), streamsize (sz));
+        return uint64_t (_is.gcount ()) == sz;
+    }
+
+    ifstream     _is;
+    uint64_t     _size;
+    uint64_t     _start;
+    vector<char> _block;
+};
+
+//
+// A BlockWriter collects the Core library's writes to consecutive
+// locations in a buffer, and writes the buffer to the file when it
+// is full, or when a write goes elsewhere.  The file is not created
+// until open() is called, once the header is known to be valid.
+//
+
+class BlockWriter : public CoreStream
+{
+public:
+    BlockWriter (const string& name) : _start (0), _ok (true)
+    {
+        fileName = name;
+    }
+
+    void open ()
+    {
+        _os.open (fileName.c_str (), ios_base::binary | ios_base::trunc);
+
+        if (!_os)
+            IEX_NAMESPACE::throwErrnoExc (
+                "Cannot open image file \"" + fileName + "\". %T.");
+    }
+
+    int64_t write (const void* buffer, uint64_t sz, uint64_t offset)
+    {
+        if (offset != _start + _block.size () ||
+            _block.size () + sz > gBlockSize)
+        {
+            flush ();
+            _start = offset;
+        }
+
+        if (sz >= gBlockSize)
+        {
+            _os.seekp (streamoff (offset));
+            _os.write (static_cast<const char*> (buffer), streamsize (sz));
+            _start = offset + sz;
+            _ok    = _ok && _os.good ();
+        }
+        else
+        {
+            const char* p = static_cast<const char*> (buffer);
+            _block.insert (_block.end (), p, p + sz);
+        }
+
+        return _ok ? int64_t (sz) : -1;
+    }
+
+    bool flush ()
+    {
+        if (!_block.empty ())
+        {
+            _os.seekp (streamoff (_start));
+            _os.write (&_block[0], streamsize (_block.size ()));
+            _start += _block.size ();
+            _block.clear ();
+        }
+
+        _os.flush ();
+        _ok = _ok && _os.good ();
+        return _ok;
+    }
+
+    static int64_t writeFn (
+        exr_const_context_t,
+        void*       userdata,
+        const void* buffer,
+        uint64_t    sz,
+        uint64_t    offset,
+        exr_stream_error_func_ptr_t)
+    {
+        BlockWriter* writer = static_cast<BlockWriter*> (userdata);
+        return writer->write (buffer, sz, offset);
+    }
+
+private:
+    ofstream     _os;
+    uint64_t     _start;
+    bool         _ok;
+    vector<char> _block;
+};
+
+//
+// a Core library context that is finished when it goes out of scope
+//
+
+struct CoreContext
+{
+    exr_context_t ctxt = nullptr;
+
+    CoreContext () = default;
+    CoreContext (const CoreContext&) = delete;
+    CoreContext& operator= (const CoreContext&) = delete;
+
+    ~CoreContext ()
+    {
+        if (ctxt) exr_finish (&ctxt);
+    }
+};
+
+struct Input
+{
+    size_t                  index; // in the order the inputs were opened
+    unique_ptr<BlockReader> reader;
+    CoreContext             core;
+
+    //
+    // the chunk offset tables of the parts, as stored in the file,
+    // read when they are first needed
+    //
+
+    map<int, vector<uint64_t>> offsets;
+
+    const vector<uint64_t>& chunkOffsets (int part)
+    {
+        auto i = offsets.find (part);
+        if (i != offsets.end ()) return i->second;
+
+        vector<uint64_t>& table = offsets[part];
+        uint64_t          start;
+        int32_t           count;
+
+        if (exr_get_chunk_table_offset (core.ctxt, part, &start) !=
+                EXR_ERR_SUCCESS ||
+            exr_get_chunk_count (core.ctxt, part, &count) != EXR_ERR_SUCCESS)
+            return table;
+
+        vector<unsigned char> bytes (size_t (count) * 8);
+
+        if (count > 0 &&
+            reader->read (&bytes[0], bytes.size (), start) ==
+                int64_t (bytes.size ()))
+        {
+            table.resize (size_t (count));
+
+            for (size_t c = 0; c < table.size (); ++c)
+            {
+                uint64_t offset = 0;
+                for (int b = 7; b >= 0; --b)
+                    offset = (offset << 8) | bytes[c * 8 + b];
+                table[c] = offset;
+            }
+        }
+
+        return table;
+    }
+};
+
+struct Output
+{
+    const RawCopyOutput*    desc;
+    unique_ptr<BlockWriter> writer;
+    CoreContext             core;
+    vector<Input*>          inputs; // the input of each part
+    size_t                  part;   // the part being written
+    size_t                  chunk;  // the next chunk of that part
+    vector<CoreChunkRef>    chunks; // the chunks of that part
+};
+
+bool
+sameAttribute (const exr_attribute_t* a, const exr_attribute_t* b)
+{
+    if (!a || !b || a->type != b->type) return a == b;
+
+    switch (a->type)
+    {
+        case EXR_ATTR_BOX2I:
+            return !memcmp (a->box2i, b->box2i, sizeof (exr_attr_box2i_t));
+        case EXR_ATTR_FLOAT: return a->f == b->f;
+        case EXR_ATTR_TIMECODE:
+            return !memcmp (
+                a->timecode, b->timecode, sizeof (exr_attr_timecode_t));
+        case EXR_ATTR_CHROMATICITIES:
+            return !memcmp (
+                a->chromaticities,
+                b->chromaticities,
+                sizeof (exr_attr_chromaticities_t));
+        default: return false;
+    }
+}
+
+const exr_attribute_t*
+findAttribute (exr_context_t f, int part, const char* name)
+{
+    const exr_attribute_t* attr = nullptr;
+
+    if (exr_get_attribute_by_name (f, part, name, &attr) != EXR_ERR_SUCCESS)
+        return nullptr;
+
+    return attr;
+}
+
+const char* const gSharedAttributes[] = {
+    "displayWindow", "pixelAspectRatio", "timecode", "chromaticities"};
+
+//
+// Give part p of an output file the values of the shared attributes
+// of part 0; this is done before the other attributes are copied from
+// the input, which does not replace attributes that are already set.
+//
+
+exr_result_t
+overrideSharedAttributes (exr_context_t out, int p)
+{
+    exr_result_t           rv = EXR_ERR_SUCCESS;
+    const exr_attribute_t* a;
+
+    if ((a = findAttribute (out, 0, "displayWindow")) &&
+        a->type == EXR_ATTR_BOX2I)
+        rv = exr_set_display_window (out, p, a->box2i);
+
+    if (rv == EXR_ERR_SUCCESS &&
+        (a = findAttribute (out, 0, "pixelAspectRatio")) &&
+        a->type == EXR_ATTR_FLOAT)
+        rv = exr_set_pixel_aspect_ratio (out, p, a->f);
+
+    if (rv == EXR_ERR_SUCCESS && (a = findAttribute (out, 0, "timecode")) &&
+        a->type == EXR_ATTR_TIMECODE)
+        rv = exr_attr_set_timecode (out, p, "timecode", a->timecode);
+
+    if (rv == EXR_ERR_SUCCESS &&
+        (a = findAttribute (out, 0, "chromaticities")) &&
+        a->type == EXR_ATTR_CHROMATICITIES)
+        rv = exr_attr_set_chromaticities (
+            out, p, "chromaticities", a->chromaticities);
+
+    return rv;
+}
+
+void
+writeHeader (Output& out, bool overrideShared)
+{
+    exr_context_t f = out.core.ctxt;
+
+    for (size_t i = 0; i < out.desc->parts.size (); ++i)
+    {
+        const RawPartSource& src   = out.desc->parts[i];
+        exr_context_t        in    = out.inputs[i]->core.ctxt;
+        const char*          name  = nullptr;
+        exr_storage_t        store = EXR_STORAGE_LAST_TYPE;
+        exr_result_t         rv;
+        int                  p;
+
+        rv = exr_get_storage (in, src.part, &store);
+
+        if (rv != EXR_ERR_SUCCESS)
+            THROW (
+                IEX_NAMESPACE::ArgExc,
+                "Cannot copy part " << src.part << " of image file \""
+                                    << src.fileName << "\". "
+                                    << out.inputs[i]->reader->error (rv));
+
+        if (!src.name.empty ())
+            name = src.name.c_str ();
+        else if (exr_get_name (in, src.part, &name) != EXR_ERR_SUCCESS)
+            name = nullptr;
+
+        rv = exr_add_part (f, name, store, &p);
+
+        if (rv == EXR_ERR_SUCCESS && !src.view.empty ())
+            rv = exr_attr_set_string (f, p, "view", src.view.c_str ());
+
+        if (rv == EXR_ERR_SUCCESS && p > 0 && overrideShared)
+            rv = overrideSharedAttributes (f, p);
+
+        if (rv == EXR_ERR_SUCCESS)
+            rv = exr_copy_unset_attributes (f, p, in, src.part);
+
+        if (rv != EXR_ERR_SUCCESS)
+            THROW (
+                IEX_NAMESPACE::ArgExc,
+                "Cannot copy part " << src.part << " of image file \""
+                                    << src.fileName << "\" to image file \""
+                                    << out.desc->fileName << "\". "
+                                    << out.writer->error (rv));
+
+        if (p == 0 || overrideShared) continue;
+
+        string conflicts;
+
+        for (const char* attr: gSharedAttributes)
+        {
+            const exr_attribute_t* a = findAttribute (f, 0, attr);
+            const exr_attribute_t* b = findAttribute (f, p, attr);
+
+            if (!b && (!strcmp (attr, "timecode") ||
+                       !strcmp (attr, "chromaticities")))
+                continue;
+
+            if (!sameAttribute (a, b))
+                conflicts += string (" '") + attr + "' ";
+        }
+
+        if (!conflicts.empty ())
+            THROW (
+                IEX_NAMESPACE::ArgExc,
+                "Conflicting attributes found for header :: "
+                    << (name ? name : "") << conflicts);
+    }
+
+    //
+    // In a file that contains deep data, every part must have a
+    // version attribute, even the parts that are not deep.
+    //
+
+    bool deep = false;
+
+    for (size_t i = 0; i < out.desc->parts.size (); ++i)
+    {
+        exr_storage_t store = EXR_STORAGE_LAST_TYPE;
+        exr_get_storage (f, int (i), &store);
+
+        deep = deep || store == EXR_STORAGE_DEEP_SCANLINE ||
+               store == EXR_STORAGE_DEEP_TILED;
+    }
+
+    for (size_t i = 0; deep && i < out.desc->parts.size (); ++i)
+    {
+        if (findAttribute (f, int (i), "version")) continue;
+
+        exr_result_t rv = exr_attr_set_int (f, int (i), "version", 1);
+
+        if (rv != EXR_ERR_SUCCESS)
+            THROW (
+                IEX_NAMESPACE::ArgExc,
+                "Cannot write the header of image file \""
+                    << out.desc->fileName << "\". " << out.writer->error (rv));
+    }
+
+    out.writer->open ();
+
+    exr_result_t rv = exr_write_header (f);
+
+    if (rv != EXR_ERR_SUCCESS)
+        THROW (
+            IEX_NAMESPACE::IoExc,
+            "Cannot write the header of image file \""
+                << out.desc->fileName << "\". " << out.writer->error (rv));
+}
+
+//
+// prepare to write the next part of an output file; returns false
+// if all parts have been written
+//
+
+bool
+startPart (Output& out)
+{
+    while (out.part < out.desc->parts.size ())
+    {
+        const RawPartSource& src = out.desc->parts[out.part];
+        Input&               in  = *out.inputs[out.part];
+
+        out.chunks.clear ();
+
+        exr_result_t rv = listCoreChunks (in.core.ctxt, src.part, out.chunks);
+
+        if (rv != EXR_ERR_SUCCESS)
+            THROW (
+                IEX_NAMESPACE::InputExc,
+                "Cannot read part " << src.part << " of image file \""
+                                    << src.fileName << "\". "
+                                    << in.reader->error (rv));
+
+        out.chunk = 0;
+
+        if (!out.chunks.empty ()) return true;
+
+        ++out.part;
+    }
+
+    return false;
+}
+
+//
+// the position in its input file of the next chunk an output needs
+//
+
+uint64_t
+nextChunkOffset (Output& out)
+{
+    const vector<uint64_t>& offsets = out.inputs[out.part]->chunkOffsets (
+        out.desc->parts[out.part].part);
+
+    return out.chunk < offsets.size () ? offsets[out.chunk] : 0;
+}
+
+void
+copyChunk (Output& out, vector<char>& packed, vector<char>& samples)
+{
+    const RawPartSource& src  = out.desc->parts[out.part];
+    Input&               in   = *out.inputs[out.part];
+    const CoreChunkRef&  c    = out.chunks[out.chunk];
+    int                  p    = int (out.part);
+    exr_context_t        f    = in.core.ctxt;
+    exr_context_t        of   = out.core.ctxt;
+    exr_chunk_info_t     cinfo;
+    exr_storage_t        store;
+    exr_result_t         rv;
+
+    rv = exr_get_storage (f, src.part, &store);
+
+    bool tiled = store == EXR_STORAGE_TILED || store == EXR_STORAGE_DEEP_TILED;
+    bool deep  = store == EXR_STORAGE_DEEP_SCANLINE ||
+                store == EXR_STORAGE_DEEP_TILED;
+
+    if (rv == EXR_ERR_SUCCESS)
+    {
+        if (tiled)
+            rv = exr_read_tile_chunk_info (
+                f, src.part, c.tx, c.ty, c.lx, c.ly, &cinfo);
+        else
+            rv = exr_read_scanline_chunk_info (f, src.part, c.y, &cinfo);
+    }
+
+    if (rv == EXR_ERR_SUCCESS)
+    {
+        packed.resize (size_t (max (cinfo.packed_size, uint64_t (1))));
+
+        if (deep)
+        {
+            samples.resize (
+                size_t (max (cinfo.sample_count_table_size, uint64_t (1))));
+
+            rv = exr_read_deep_chunk (
+                f, src.part, &cinfo, &packed[0], &samples[0]);
+        }
+        else
+        {
+            rv = exr_read_chunk (f, src.part, &cinfo, &packed[0]);
+        }
+    }
+
+    if (rv != EXR_ERR_SUCCESS)
+        THROW (
+            IEX_NAMESPACE::InputExc,
+            "Cannot read chunk " << out.chunk << " of part " << src.part
+                                 << " of image file \"" << src.fileName
+                                 << "\". " << in.reader->error (rv));
+
+    switch (store)
+    {
+        case EXR_STORAGE_SCANLINE:
+            rv = exr_write_scanline_chunk (
+                of, p, c.y, &packed[0], cinfo.packed_size);
+            break;
+        case EXR_STORAGE_TILED:
+            rv = exr_write_tile_chunk (
+                of, p, c.tx, c.ty, c.lx, c.ly, &packed[0], cinfo.packed_size);
+            break;
+        case EXR_STORAGE_DEEP_SCANLINE:
+            rv = exr_write_deep_scanline_chunk (
+                of,
+                p,
+                c.y,
+                &packed[0],
+                cinfo.packed_size,
+                cinfo.unpacked_size,
+                &samples[0],
+                cinfo.sample_count_table_size);
+            break;
+        default:
+            rv = exr_write_deep_tile_chunk (
+                of,
+                p,
+                c.tx,
+                c.ty,
+                c.lx,
+                c.ly,
+                &packed[0],
+                cinfo.packed_size,
+                cinfo.unpacked_size,
+                &samples[0],
+                cinfo.sample_count_table_size);
+            break;
+    }
+
+    if (rv != EXR_ERR_SUCCESS)
+        THROW (
+            IEX_NAMESPACE::IoExc,
+            "Cannot write chunk " << out.chunk << " of part " << p
+                                  << " of image file \""
+                                  << out.desc->fileName << "\". "
+                                  << out.writer->error (rv));
+}
+
+} // namespace
+
+void
+copyRawParts (const vector<RawCopyOutput>& outputs, bool overrideShared)
+{
+    tLastMessage.clear ();
+
+    //
+    // Output files are created while the input files are read, so an
+    // output must not be one of the inputs, and two outputs must not
+    // be the same file.  Check this before any file is created.
+    //
+
+    for (size_t i = 0; i < outputs.size (); ++i)
+    {
+        const RawCopyOutput& o = outputs[i];
+
+        if (o.parts.empty ())
+            THROW (
+                IEX_NAMESPACE::ArgExc,
+                "No parts to copy to image file \"" << o.fileName << "\".");
+
+        for (const RawCopyOutput& o2: outputs)
+        {
+            for (const RawPartSource& src: o2.parts)
+            {
+                if (sameFile (src.fileName, o.fileName))
+                    THROW (
+                        IEX_NAMESPACE::ArgExc,
+                        "Cannot copy parts of image file \""
+                            << src.fileName << "\" to the same file.");
+            }
+        }
+
+        for (size_t j = 0; j < i; ++j)
+        {
+            if (sameFile (outputs[j].fileName, o.fileName))
+                THROW (
+                    IEX_NAMESPACE::ArgExc,
+                    "Image files \"" << outputs[j].fileName << "\" and \""
+                                     << o.fileName
+                                     << "\" are the same output file.");
+        }
+    }
+
+    //
+    // open every input file once
+    //
+
+    map<string, unique_ptr<Input>> inputs;
+
+    for (const RawCopyOutput& o: outputs)
+    {
+        for (const RawPartSource& src: o.parts)
+        {
+            unique_ptr<Input>& in = inputs[src.fileName];
+
+            if (in) continue;
+
+            in.reset (new Input);
+            in->index = inputs.size () - 1;
+            in->reader.reset (new BlockReader (src.fileName));
+
+            exr_context_initializer_t cinit = EXR_DEFAULT_CONTEXT_INITIALIZER;
+
+            cinit.user_data        = in->reader.get ();
+            cinit.read_fn          = &BlockReader::readFn;
+            cinit.size_fn          = &BlockReader::sizeFn;
+            cinit.error_handler_fn = &errorHandler;
+
+            exr_result_t rv =
+                exr_start_read (&in->core.ctxt, src.fileName.c_str (), &cinit);
+
+            if (rv != EXR_ERR_SUCCESS)
+                THROW (
+                    IEX_NAMESPACE::InputExc,
+                    "Cannot read image file \""
+                        << src.fileName << "\". " << in->reader->error (rv));
+        }
+    }
+
+    //
+    // write the headers of the output files
+    //
+
+    vector<unique_ptr<Output>> outs;
+
+    for (const RawCopyOutput& o: outputs)
+    {
+        outs.emplace_back (new Output);
+
+        Output& out = *outs.back ();
+
+        out.desc  = &o;
+        out.part  = 0;
+        out.chunk = 0;
+        out.writer.reset (new BlockWriter (o.fileName));
+
+        for (const RawPartSource& src: o.parts)
+            out.inputs.push_back (inputs[src.fileName].get ());
+
+        exr_context_initializer_t cinit = EXR_DEFAULT_CONTEXT_INITIALIZER;
+
+        cinit.user_data        = out.writer.get ();
+        cinit.write_fn         = &BlockWriter::writeFn;
+        cinit.error_handler_fn = &errorHandler;
+
+        exr_result_t rv = exr_start_write (
+            &out.core.ctxt,
+            o.fileName.c_str (),
+            EXR_WRITE_FILE_DIRECTLY,
+            &cinit);
+
+        if (rv != EXR_ERR_SUCCESS)
+            THROW (
+                IEX_NAMESPACE::IoExc,
+                "Cannot write image file \""
+                    << o.fileName << "\". " << out.writer->error (rv));
+
+        writeHeader (out, overrideShared);
+    }
+
+    //
+    // Copy the chunks.  Each output file is written part by part, in
+    // the order of the chunk offset tables, but the outputs are
+    // interleaved such that the next chunk read from an input file is
+    // always the one with the lowest position in the file.
+    //
+
+    typedef pair<pair<size_t, uint64_t>, size_t> Next; // input, offset, output
+
+    priority_queue<Next, vector<Next>, greater<Next>> queue;
+
+    auto schedule = [&] (size_t o) {
+        Output& out = *outs[o];
+        size_t  in  = out.inputs[out.part]->index;
+
+        queue.push (Next (make_pair (in, nextChunkOffset (out)), o));
+    };
+
+    for (size_t o = 0; o < outs.size (); ++o)
+        if (startPart (*outs[o])) schedule (o);
+
+    vector<char> packed;
+    vector<char> samples;
+
+    while (!queue.empty ())
+    {
+        size_t o = queue.top ().second;
+        queue.pop ();
+
+        Output& out = *outs[o];
+
+        copyChunk (out, packed, samples);
+
+        if (++out.chunk == out.chunks.size ())
+        {
+            ++out.part;
+            if (!startPart (out)) continue;
+        }
+
+        schedule (o);
+    }
+
+    //
+    // finish the output files
+    //
+
+    for (unique_ptr<Output>& out: outs)
+    {
+        exr_result_t rv = exr_finish (&out->core.ctxt);
+
+        if (rv != EXR_ERR_SUCCESS)
+            THROW (
+                IEX_NAMESPACE::IoExc,
+                "Cannot write image file \""
+                    << out->desc->fileName << "\". "
+                    << out->writer->error (rv));
+
+        if (!out->writer->flush ())
+            IEX_NAMESPACE::throwErrnoExc (
+                "Cannot write image file \"" + out->desc->fileName +
+                "\". %T.");
+    }
+}
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_SOURCE_EXIT
@@ -0,0 +1,85 @@
+//
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) Contributors to the OpenEXR Project.
+//
+
+#ifndef INCLUDED_IMF_RAW_PART_COPY_H
+#define INCLUDED_IMF_RAW_PART_COPY_H
+
+//----------------------------------------------------------------------------
+//
+//      struct RawPartSource,
+//      struct RawCopyOutput,
+//      function copyRawParts()
+//
+//      Copy parts of OpenEXR files into new single-part or multi-part
+//      files, without decompressing and recompressing the pixels.
+//
+//----------------------------------------------------------------------------
+
+#include "ImfNamespace.h"
+#include "ImfUtilExport.h"
+
+#include <string>
+#include <vector>
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_HEADER_ENTER
+
+//
+// A part of an input file that is copied to an output file.  If name
+// or view are not empty, they replace the part's name and view in the
+// output file.
+//
+
+struct IMFUTIL_EXPORT_TYPE RawPartSource
+{
+    std::string fileName;
+    int         part = 0;
+    std::string name;
+    std::string view;
+};
+
+//
+// An output file, and the parts it is made of, in order.
+//
+
+struct IMFUTIL_EXPORT_TYPE RawCopyOutput
+{
+    std::string                fileName;
+    std::vector<RawPartSource> parts;
+};
+
+//
+// Write the output files.  The headers of the output parts are copied
+// from the input parts, and the chunks of pixel data are copied byte
+// for byte, so the compression and the channels of every part stay
+// the same.  Multi-part output files must have unique part names.
+//
+// Every input file is opened only once, and the chunks it contributes
+// to the output files are read in the order in which they are stored
+// in the file, as far as the output files permit; this keeps reads
+// sequential when, for example, all parts of a file whose parts are
+// interleaved are split into separate files.  Reads and writes are
+// done in large blocks.
+//
+// The displayWindow, pixelAspectRatio, timecode and chromaticities
+// attributes must be the same in all parts of an output file, like
+// with MultiPartOutputFile.  If overrideSharedAttributes is true, the
+// values of the first part are used for the other parts; otherwise
+// conflicting values cause an ArgExc to be thrown.
+//
+// An output file must not be one of the input files, and no two
+// outputs may be the same file, also under different names such as
+// "x.exr" and "./x.exr"; otherwise an ArgExc is thrown before any
+// file is written.
+//
+// Errors are reported by throwing an exception.
+//
+
+IMFUTIL_EXPORT void copyRawParts (
+    const std::vector<RawCopyOutput>& outputs,
+    bool                              overrideSharedAttributes = false);
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_HEADER_EXIT
+
+#endif
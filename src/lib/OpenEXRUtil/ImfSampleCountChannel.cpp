@@ -13,6 +13,7 @@
 #include "ImfDeepImageLevel.h"
 #include "ImfImage.h"
 #include <Iex.h>
+#include <vector>
 
 using namespace IMATH_NAMESPACE;
 using namespace IEX_NAMESPACE;
@@ -22,6 +23,8 @@ OPENEXR_IMF_INTERNAL_NAMESPACE_SOURCE_ENTER
 namespace
 {
 
+const int ROWS_PER_BLOCK = 16;
+
 unsigned int
 roundListSizeUp (unsigned int n)
 {
@@ -62,6 +65,13 @@ SampleCountChannel::SampleCountChannel (DeepImageLevel& level)
     , _totalNumSamples (0)
     , _totalSamplesOccupied (0)
     , _sampleBufferSize (0)
+    , _rowsPerBlock (ROWS_PER_BLOCK)
+    , _numBlocks (0)
+    , _blockSamplesOccupied (0)
+    , _blockBufferSizes (0)
+    , _editNumSamples (0)
+    , _editFirstRow (-1)
+    , _editLastRow (-1)
 {
     resize ();
 }
@@ -71,6 +81,9 @@ SampleCountChannel::~SampleCountChannel ()
     delete[] _numSamples;
     delete[] _sampleListSizes;
     delete[] _sampleListPositions;
+    delete[] _blockSamplesOccupied;
+    delete[] _blockBufferSizes;
+    delete[] _editNumSamples;
 }
 
 PixelType
@@ -142,22 +155,26 @@ SampleCountChannel::set (int x, int y, unsigned int newNumSamples)
         return;
     }
 
-    int newSampleListSize = roundListSizeUp (newNumSamples);
+    int          b                 = blockForPixel (i);
+    unsigned int newSampleListSize = roundListSizeUp (newNumSamples);
 
-    if (_totalSamplesOccupied + newSampleListSize <= _sampleBufferSize)
+    if (_blockSamplesOccupied[b] + newSampleListSize <= _blockBufferSizes[b])
     {
         //
         // The number of samples in the pixel no longer fits into the
         // space that has been allocated for the sample list, but there
-        // is space available at the end of the sample buffer.  Allocate
-        // space for a new list at the end of the sample buffer, and move
-        // the sample list from its old location to its new, larger place.
+        // is space available at the end of the block's sample buffer.
+        // Allocate space for a new list at the end of the buffer, and
+        // move the sample list from its old location to its new, larger
+        // place.
         //
 
         deepLevel ().moveSampleList (
-            i, _numSamples[i], newNumSamples, _totalSamplesOccupied);
+            i, _numSamples[i], newNumSamples, _blockSamplesOccupied[b]);
 
-        _sampleListPositions[i] = _totalSamplesOccupied;
+        _sampleListPositions[i] = _blockSamplesOccupied[b];
+        _sampleListSizes[i]     = newSampleListSize;
+        _blockSamplesOccupied[b] += newSampleListSize;
         _totalSamplesOccupied += newSampleListSize;
         _totalNumSamples += newNumSamples - _numSamples[i];
         _numSamples[i] = newNumSamples;
@@ -167,53 +184,25 @@ SampleCountChannel::set (int x, int y, unsigned int newNumSamples)
     //
     // The new number of samples no longer fits into the space that has
     // been allocated for the sample list, and there is not enough room
-    // at the end of the sample buffer for a new, larger sample list.
-    // Allocate an entirely new sample buffer, and move all existing
-    // sample lists into it.
+    // at the end of the block's sample buffer for a new, larger sample
+    // list.  Allocate a new sample buffer for the block, and move the
+    // block's sample lists into it.  The other blocks are not affected.
     //
 
-    unsigned int* oldNumSamples          = 0;
-    size_t*       oldSampleListPositions = 0;
-
     try
     {
-        _totalNumSamples += newNumSamples - _numSamples[i];
-
-        oldNumSamples = _numSamples;
-        _numSamples   = new unsigned int[numPixels ()];
-
-        resetBasePointer ();
+        size_t firstPixel = blockFirstPixel (b);
 
-        oldSampleListPositions = _sampleListPositions;
-        _sampleListPositions   = new size_t[numPixels ()];
+        vector<unsigned int> oldNumSamples (
+            _numSamples + firstPixel, _numSamples + blockFirstPixel (b + 1));
 
-        _totalSamplesOccupied = 0;
-
-        for (size_t j = 0; j < numPixels (); ++j)
-        {
-            if (j == i)
-                _numSamples[j] = newNumSamples;
-            else
-                _numSamples[j] = oldNumSamples[j];
-
-            _sampleListPositions[j] = _totalSamplesOccupied;
-            _sampleListSizes[j]     = roundListSizeUp (_numSamples[j]);
-            _totalSamplesOccupied += _sampleListSizes[j];
-        }
-
-        _sampleBufferSize = roundBufferSizeUp (_totalSamplesOccupied);
-
-        deepLevel ().moveSamplesToNewBuffer (
-            oldNumSamples, _numSamples, _sampleListPositions);
+        _totalNumSamples += newNumSamples - _numSamples[i];
+        _numSamples[i] = newNumSamples;
 
-        delete[] oldNumSamples;
-        delete[] oldSampleListPositions;
+        repackBlock (b, oldNumSamples.data ());
     }
     catch (...)
     {
-        delete[] oldNumSamples;
-        delete[] oldSampleListPositions;
-
         level ().image ().resize (Box2i (V2i (0, 0), V2i (-1, -1)));
         throw;
     }
@@ -223,7 +212,7 @@ void
 SampleCountChannel::set (int r, unsigned int newNumSamples[])
 {
     int x = level ().dataWindow ().min.x;
-    int y = r + level ().dataWindow ().min.x;
+    int y = r + level ().dataWindow ().min.y;
 
     for (int i = 0; i < pixelsPerRow (); ++i, ++x)
         set (x, y, newNumSamples[i]);
@@ -241,9 +230,15 @@ SampleCountChannel::clear ()
             _sampleListPositions[i] = 0;
         }
 
+        for (int b = 0; b < _numBlocks; ++b)
+        {
+            _blockSamplesOccupied[b] = 0;
+            _blockBufferSizes[b]     = roundBufferSizeUp (0);
+        }
+
         _totalNumSamples      = 0;
         _totalSamplesOccupied = 0;
-        _sampleBufferSize     = roundBufferSizeUp (_totalSamplesOccupied);
+        _sampleBufferSize     = 0;
 
         deepLevel ().initializeSampleLists ();
     }
@@ -260,28 +255,116 @@ SampleCountChannel::beginEdit ()
     return _numSamples;
 }
 
+unsigned int*
+SampleCountChannel::beginEdit (int r1, int r2)
+{
+    if (r1 < 0 || r2 >= pixelsPerColumn () || r1 > r2)
+    {
+        THROW (
+            ArgExc,
+            "Cannot edit sample counts of rows "
+                << r1 << " to " << r2
+                << ".  The level has " << pixelsPerColumn () << " rows.");
+    }
+
+    //
+    // Remember the current sample counts of all blocks that contain
+    // rows r1 to r2; endEdit() needs them to move the samples in
+    // those blocks.
+    //
+
+    size_t firstPixel = blockFirstPixel (r1 / _rowsPerBlock);
+    size_t endPixel   = blockFirstPixel (r2 / _rowsPerBlock + 1);
+
+    delete[] _editNumSamples;
+    _editNumSamples = 0;
+    _editNumSamples = new unsigned int[endPixel - firstPixel];
+
+    for (size_t i = firstPixel; i < endPixel; ++i)
+        _editNumSamples[i - firstPixel] = _numSamples[i];
+
+    _editFirstRow = r1;
+    _editLastRow  = r2;
+
+    return _numSamples + size_t (r1) * pixelsPerRow ();
+}
+
 void
 SampleCountChannel::endEdit ()
 {
     try
     {
+        if (_editFirstRow >= 0)
+        {
+            //
+            // Only rows _editFirstRow to _editLastRow have been edited.
+            // Move the samples of those blocks where the sample counts
+            // have changed.
+            //
+
+            int    b1         = _editFirstRow / _rowsPerBlock;
+            int    b2         = _editLastRow / _rowsPerBlock;
+            size_t firstPixel = blockFirstPixel (b1);
+
+            for (int b = b1; b <= b2; ++b)
+            {
+                const unsigned int* oldNumSamples =
+                    _editNumSamples + (blockFirstPixel (b) - firstPixel);
+
+                bool changed = false;
+
+                for (size_t i = blockFirstPixel (b), j = 0;
+                     i < blockFirstPixel (b + 1);
+                     ++i, ++j)
+                {
+                    if (_numSamples[i] != oldNumSamples[j])
+                    {
+                        _totalNumSamples -= oldNumSamples[j];
+                        _totalNumSamples += _numSamples[i];
+                        changed = true;
+                    }
+                }
+
+                if (changed) repackBlock (b, oldNumSamples);
+            }
+
+            delete[] _editNumSamples;
+            _editNumSamples = 0;
+            _editFirstRow   = -1;
+            _editLastRow    = -1;
+            return;
+        }
+
+        //
+        // All sample counts may have changed.  Lay out the sample lists
+        // of each block without gaps; this is the common case when an
+        // image is read from a file, and it lets the reader store the
+        // samples of consecutive pixels with a single copy.
+        //
+
         _totalNumSamples      = 0;
         _totalSamplesOccupied = 0;
+        _sampleBufferSize     = 0;
 
-        for (size_t i = 0; i < numPixels (); ++i)
+        for (int b = 0; b < _numBlocks; ++b)
         {
-            _sampleListSizes[i]     = roundListSizeUp (_numSamples[i]);
-            _sampleListPositions[i] = _totalSamplesOccupied;
-            _totalNumSamples += _numSamples[i];
-            _totalSamplesOccupied += _sampleListSizes[i];
+            _blockSamplesOccupied[b] = 0;
+            _blockBufferSizes[b]     = 0;
+            layoutBlock (b, true);
         }
 
-        _sampleBufferSize = roundBufferSizeUp (_totalSamplesOccupied);
+        for (size_t i = 0; i < numPixels (); ++i)
+            _totalNumSamples += _numSamples[i];
 
         deepLevel ().initializeSampleLists ();
     }
     catch (...)
     {
+        delete[] _editNumSamples;
+        _editNumSamples = 0;
+        _editFirstRow   = -1;
+        _editLastRow    = -1;
+
         level ().image ().resize (Box2i (V2i (0, 0), V2i (-1, -1)));
         throw;
     }
@@ -295,15 +378,30 @@ SampleCountChannel::resize ()
     delete[] _numSamples;
     delete[] _sampleListSizes;
     delete[] _sampleListPositions;
-
-    _numSamples          = 0; // set to 0 to prevent double
-    _sampleListSizes     = 0; // deletion in case of an exception
-    _sampleListPositions = 0;
+    delete[] _blockSamplesOccupied;
+    delete[] _blockBufferSizes;
+    delete[] _editNumSamples;
+
+    _numSamples           = 0; // set to 0 to prevent double
+    _sampleListSizes      = 0; // deletion in case of an exception
+    _sampleListPositions  = 0;
+    _blockSamplesOccupied = 0;
+    _blockBufferSizes     = 0;
+    _editNumSamples       = 0;
+    _editFirstRow         = -1;
+    _editLastRow          = -1;
+    _numBlocks            = 0;
 
     _numSamples          = new unsigned int[numPixels ()];
     _sampleListSizes     = new unsigned int[numPixels ()];
     _sampleListPositions = new size_t[numPixels ()];
 
+    int numBlocks = (pixelsPerColumn () + _rowsPerBlock - 1) / _rowsPerBlock;
+
+    _blockSamplesOccupied = new size_t[numBlocks];
+    _blockBufferSizes     = new size_t[numBlocks];
+    _numBlocks            = numBlocks;
+
     resetBasePointer ();
 
     for (size_t i = 0; i < numPixels (); ++i)
@@ -313,10 +411,15 @@ SampleCountChannel::resize ()
         _sampleListPositions[i] = 0;
     }
 
+    for (int b = 0; b < _numBlocks; ++b)
+    {
+        _blockSamplesOccupied[b] = 0;
+        _blockBufferSizes[b]     = roundBufferSizeUp (0);
+    }
+
     _totalNumSamples      = 0;
     _totalSamplesOccupied = 0;
-
-    _sampleBufferSize = roundBufferSizeUp (_totalSamplesOccupied);
+    _sampleBufferSize     = 0;
 }
 
 void
@@ -326,4 +429,46 @@ SampleCountChannel::resetBasePointer ()
             level ().dataWindow ().min.x;
 }
 
+void
+SampleCountChannel::layoutBlock (int b, bool packed)
+{
+    //
+    // Compute the positions of the sample lists of the pixels in block b
+    // from their current sample counts.  If packed is true, each sample
+    // list gets exactly as much space as it needs; otherwise the sizes
+    // are rounded up to leave room for new samples.
+    //
+
+    size_t occupied = 0;
+
+    for (size_t i = blockFirstPixel (b); i < blockFirstPixel (b + 1); ++i)
+    {
+        _sampleListSizes[i] =
+            packed ? _numSamples[i] : roundListSizeUp (_numSamples[i]);
+        _sampleListPositions[i] = occupied;
+        occupied += _sampleListSizes[i];
+    }
+
+    _totalSamplesOccupied -= _blockSamplesOccupied[b];
+    _totalSamplesOccupied += occupied;
+    _sampleBufferSize -= _blockBufferSizes[b];
+    _sampleBufferSize += roundBufferSizeUp (occupied);
+
+    _blockSamplesOccupied[b] = occupied;
+    _blockBufferSizes[b]     = roundBufferSizeUp (occupied);
+}
+
+void
+SampleCountChannel::repackBlock (int b, const unsigned int* oldNumSamples)
+{
+    //
+    // Allocate a new sample buffer for block b, and move the block's
+    // sample lists into it.  oldNumSamples contains the number of
+    // samples in each sample list of the block in the old buffer.
+    //
+
+    layoutBlock (b, false);
+    deepLevel ().moveSamplesToNewBuffer (b, oldNumSamples);
+}
+
 OPENEXR_IMF_INTERNAL_NAMESPACE_SOURCE_EXIT
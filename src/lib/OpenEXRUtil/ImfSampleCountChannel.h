@@ -116,9 +116,13 @@ public:
     // Access is bounds-checked; attempting to set the number of samples of
     // a pixel outside the data window throws an Iex::ArgExc exception.
     //
-    // Memory allocation for the sample lists is not particularly clever;
-    // repeatedly increasing and decreasing the number of samples in the
-    // pixels of a level is likely to result in serious memory fragmentation.
+    // The samples of a level are stored in blocks of rowsPerBlock()
+    // consecutive rows; each block has its own sample buffer.  When a
+    // sample list outgrows the space available in its block, only that
+    // block's samples are moved to a new, larger buffer.  Memory
+    // allocation within a block is not particularly clever; repeatedly
+    // increasing and decreasing the number of samples in the pixels of
+    // a block is likely to result in memory fragmentation.
     //
     // Setting the number of samples for one or more pixels may cause the
     // program to run out of memory.  If this happens, the image is resized
@@ -156,6 +160,19 @@ public:
     //                  channels of the layer, according to the current
     //                  sample counts, and sets the samples to zero.
     //
+    //  beginEdit(r1,r2)
+    //                  makes only the sample counts in rows r1 to r2 of
+    //                  the level editable, and returns a pointer to the
+    //                  first count of row r1.  The samples in the deep
+    //                  channels remain valid.
+    //
+    //  endEdit()       after beginEdit(r1,r2) moves the samples of those
+    //                  blocks whose sample counts have changed to new
+    //                  buffers, as set() does for a single pixel: new
+    //                  samples are set to zero, and sample lists that
+    //                  became shorter are truncated.  All other blocks are
+    //                  left untouched.
+    //
     // Application code must take make sure that each call to beginEdit()
     // is followed by a corresponding endEdit() call, even if an
     // exception occurs while the sample counts are accessed.  In order to
@@ -172,19 +189,23 @@ public:
     IMFUTIL_EXPORT
     unsigned int* beginEdit ();
     IMFUTIL_EXPORT
+    unsigned int* beginEdit (int r1, int r2);
+    IMFUTIL_EXPORT
     void endEdit ();
 
     class Edit
     {
     public:
         //
-        // Constructor calls level->beginEdit(),
+        // Constructor calls level->beginEdit() or level->beginEdit(r1,r2),
         // destructor calls level->endEdit().
         //
 
         IMFUTIL_EXPORT
         Edit (SampleCountChannel& level);
         IMFUTIL_EXPORT
+        Edit (SampleCountChannel& level, int r1, int r2);
+        IMFUTIL_EXPORT
         ~Edit ();
 
         Edit (const Edit& other)            = delete;
@@ -193,7 +214,9 @@ public:
         Edit& operator= (Edit&& other)      = delete;
 
         //
-        // Access to the writable sample count array.
+        // Access to the writable sample count array.  For an edit
+        // of rows r1 to r2, the array begins with the first count
+        // of row r1.
         //
 
         IMFUTIL_EXPORT
@@ -207,6 +230,12 @@ public:
     //
     // Functions that support the implementation of deep image channels.
     //
+    // The sample list of pixel i is located at sampleListPositions()[i]
+    // within the buffer of block blockForPixel(i).  Block b holds pixels
+    // blockFirstPixel(b) to blockFirstPixel(b+1)-1, and its buffer has
+    // room for blockBufferSize(b) samples.  sampleBufferSize() is the
+    // sum of the sizes of all block buffers.
+    //
 
     IMFUTIL_EXPORT
     const unsigned int* numSamples () const;
@@ -217,6 +246,17 @@ public:
     IMFUTIL_EXPORT
     size_t sampleBufferSize () const;
 
+    IMFUTIL_EXPORT
+    int rowsPerBlock () const;
+    IMFUTIL_EXPORT
+    int numBlocks () const;
+    IMFUTIL_EXPORT
+    int blockForPixel (size_t i) const;
+    IMFUTIL_EXPORT
+    size_t blockFirstPixel (int b) const;
+    IMFUTIL_EXPORT
+    size_t blockBufferSize (int b) const;
+
 private:
     friend class DeepImageLevel;
 
@@ -232,6 +272,10 @@ private:
 
     void resetBasePointer ();
 
+    void layoutBlock (int b, bool packed);
+
+    void repackBlock (int b, const unsigned int* oldNumSamples);
+
     unsigned int* _numSamples; // Array of per-pixel sample counts
 
     unsigned int* _base; // Base pointer for faster access
@@ -252,7 +296,25 @@ private:
                                   // either been allocated for sample
                                   // lists or lost to fragmentation
 
-    size_t _sampleBufferSize; // Size of the sample list buffer.
+    size_t _sampleBufferSize; // Sum of the sizes of all block
+                              // buffers
+
+    int _rowsPerBlock; // Number of rows in each block
+
+    int _numBlocks; // Number of blocks in the level
+
+    size_t* _blockSamplesOccupied; // Per-block equivalent of
+                                   // _totalSamplesOccupied
+
+    size_t* _blockBufferSizes; // Array of per-block sample
+                               // buffer sizes
+
+    unsigned int* _editNumSamples; // Sample counts of the blocks
+                                   // affected by beginEdit(r1,r2),
+                                   // as they were before the edit
+
+    int _editFirstRow; // Rows made editable by beginEdit(r1,r2),
+    int _editLastRow;  // or -1 if no such edit is in progress
 };
 
 //-----------------------------------------------------------------------------
@@ -265,6 +327,13 @@ inline SampleCountChannel::Edit::Edit (SampleCountChannel& channel)
     // empty
 }
 
+inline SampleCountChannel::Edit::Edit (
+    SampleCountChannel& channel, int r1, int r2)
+    : _channel (channel), _sampleCounts (channel.beginEdit (r1, r2))
+{
+    // empty
+}
+
 inline SampleCountChannel::Edit::~Edit ()
 {
     _channel.endEdit ();
@@ -300,6 +369,37 @@ SampleCountChannel::sampleBufferSize () const
     return _sampleBufferSize;
 }
 
+inline int
+SampleCountChannel::rowsPerBlock () const
+{
+    return _rowsPerBlock;
+}
+
+inline int
+SampleCountChannel::numBlocks () const
+{
+    return _numBlocks;
+}
+
+inline int
+SampleCountChannel::blockForPixel (size_t i) const
+{
+    return int (i / (size_t (_rowsPerBlock) * pixelsPerRow ()));
+}
+
+inline size_t
+SampleCountChannel::blockFirstPixel (int b) const
+{
+    size_t i = size_t (b) * _rowsPerBlock * pixelsPerRow ();
+    return i < numPixels () ? i : numPixels ();
+}
+
+inline size_t
+SampleCountChannel::blockBufferSize (int b) const
+{
+    return _blockBufferSizes[b];
+}
+
 inline const unsigned int&
 SampleCountChannel::operator() (int x, int y) const
 {
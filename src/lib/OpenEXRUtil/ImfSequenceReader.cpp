@@ -0,0 +1,575 @@
+//
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) Contributors to the OpenEXR Project.
+//
+
+//----------------------------------------------------------------------------
+//
+//      class SequenceReader
+//
+//----------------------------------------------------------------------------
+
+#include "ImfSequenceReader.h"
+
+#include <Iex.h>
+#include <IlmThreadPool.h>
+#include <ImfInputPart.h>
+#include <ImfMultiPartInputFile.h>
+#include <ImfReadPlan.h>
+
+#include <algorithm>
+#include <cctype>
+#include <climits>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <vector>
+
+using namespace IMATH_NAMESPACE;
+using namespace IEX_NAMESPACE;
+using namespace std;
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_SOURCE_ENTER
+
+namespace
+{
+
+//
+// a block of memory holding one frame's pixels, and the read plan for
+// reading into it; blocks are recycled as the window moves so the plan
+// (and the decoders it keeps) carry over from frame to frame
+//
+
+struct Buffer
+{
+    unique_ptr<char[]>   pixels;
+    FrameBuffer          frameBuffer;
+    unique_ptr<ReadPlan> plan;
+};
+
+enum EntryState
+{
+    ENTRY_QUEUED,
+    ENTRY_READY,
+    ENTRY_FAILED,
+    ENTRY_CANCELLED
+};
+
+struct Entry
+{
+    explicit Entry (int f) : frame (f) {}
+
+    int                                     frame;
+    EntryState                              state = ENTRY_QUEUED;
+    string                                  error;
+    shared_ptr<Buffer>                      buffer;
+    shared_ptr<const SequenceReader::Frame> result;
+
+    // declared last so it is destroyed first, waiting for the load
+    // task before the rest of the entry goes away
+    ILMTHREAD_NAMESPACE::TaskGroup group;
+};
+
+void
+sliceExtent (
+    const Slice& s, const Box2i& dw, int64_t& minOffset, int64_t& maxOffset)
+{
+    int64_t size = (s.type == HALF) ? 2 : 4;
+
+    int64_t x0 = s.xTileCoords ? 0 : dw.min.x;
+    int64_t x1 = s.xTileCoords ? dw.max.x - dw.min.x : dw.max.x;
+    int64_t y0 = s.yTileCoords ? 0 : dw.min.y;
+    int64_t y1 = s.yTileCoords ? dw.max.y - dw.min.y : dw.max.y;
+
+    int64_t base = (int64_t) reinterpret_cast<intptr_t> (s.base);
+
+    for (int64_t x: {x0, x1})
+    {
+        for (int64_t y: {y0, y1})
+        {
+            int64_t off = base + (x / s.xSampling) * int64_t (s.xStride) +
+                          (y / s.ySampling) * int64_t (s.yStride);
+            minOffset = std::min (minOffset, off);
+            maxOffset = std::max (maxOffset, off + size);
+        }
+    }
+}
+
+} // namespace
+
+struct SequenceReader::Data
+{
+    string      pattern;
+    int         first;
+    int         last;
+    Options     options;
+    FrameBuffer layout;
+    Header      header;
+    size_t      frameBytes = 0;
+    int         maxFrames  = 1;
+
+    // serializes frame () / prefetch (), so an entry being waited on
+    // can not be evicted by another caller
+    mutex requestMutex;
+
+    mutable mutex               mx;
+    condition_variable          cv;
+    map<int, unique_ptr<Entry>> entries;
+    vector<shared_ptr<Buffer>>  spare;
+
+    int playhead  = INT_MIN;
+    int direction = 1;
+
+    shared_ptr<Buffer> takeBuffer ();
+    void               recycle (vector<unique_ptr<Entry>>& evicted);
+    void               updateWindow (int n, vector<unique_ptr<Entry>>& evicted);
+    void               load (Entry& e);
+
+    static bool threaded ()
+    {
+        return ILMTHREAD_NAMESPACE::ThreadPool::globalThreadPool ()
+                   .numThreads () > 0;
+    }
+
+    class LoadTask : public ILMTHREAD_NAMESPACE::Task
+    {
+    public:
+        LoadTask (Data* d, Entry* e) : Task (&e->group), _data (d), _entry (e)
+        {}
+
+        void execute () override { _data->load (*_entry); }
+
+    private:
+        Data*  _data;
+        Entry* _entry;
+    };
+};
+
+shared_ptr<Buffer>
+SequenceReader::Data::takeBuffer ()
+{
+    if (!spare.empty ())
+    {
+        shared_ptr<Buffer> b = std::move (spare.back ());
+        spare.pop_back ();
+        return b;
+    }
+
+    shared_ptr<Buffer> b = make_shared<Buffer> ();
+    b->pixels.reset (new char[frameBytes]);
+
+    for (FrameBuffer::ConstIterator i = layout.begin (); i != layout.end ();
+         ++i)
+    {
+        Slice s = i.slice ();
+        s.base  = b->pixels.get () + reinterpret_cast<intptr_t> (s.base);
+        b->frameBuffer.insert (i.name (), s);
+    }
+
+    b->plan.reset (new ReadPlan (header, b->frameBuffer));
+    return b;
+}
+
+void
+SequenceReader::Data::recycle (vector<unique_ptr<Entry>>& evicted)
+{
+    vector<shared_ptr<Buffer>> buffers;
+
+    for (auto& e: evicted)
+    {
+        // destroying the entry waits for its load task, which may
+        // still be writing into the buffer
+        shared_ptr<Buffer> b = e->buffer;
+        e.reset ();
+
+        // a frame still held by the caller keeps its buffer
+        if (b && b.use_count () == 1) buffers.push_back (std::move (b));
+    }
+    evicted.clear ();
+
+    lock_guard<mutex> lk (mx);
+    for (auto& b: buffers)
+    {
+        if (spare.size () < size_t (maxFrames)) spare.push_back (std::move (b));
+    }
+}
+
+void
+SequenceReader::Data::updateWindow (int n, vector<unique_ptr<Entry>>& evicted)
+{
+    if (playhead != INT_MIN && n != playhead) direction = (n > playhead) ? 1 : -1;
+    playhead = n;
+
+    //
+    // the frames wanted, in order of importance: the playhead, then
+    // the frames ahead of it, then the ones behind it
+    //
+
+    vector<int> wanted;
+    wanted.push_back (n);
+
+    for (int i = 1; i <= options.framesAhead; ++i)
+    {
+        int f = n + i * direction;
+        if (f < first || f > last) break;
+        wanted.push_back (f);
+    }
+
+    for (int i = 1; i <= options.framesBehind; ++i)
+    {
+        int f = n - i * direction;
+        if (f < first || f > last) break;
+        wanted.push_back (f);
+    }
+
+    // without worker threads nothing is read ahead; the frame asked
+    // for is read on demand by frame ()
+    bool threads = threaded ();
+    if (!threads) wanted.resize (1);
+
+    if (wanted.size () > size_t (maxFrames)) wanted.resize (maxFrames);
+
+    for (auto i = entries.begin (); i != entries.end ();)
+    {
+        // cancelled frames are queued again, and a frame which failed
+        // to read is retried when asked for directly
+        EntryState st = i->second->state;
+        bool       inside =
+            std::find (wanted.begin (), wanted.end (), i->first) !=
+            wanted.end ();
+        bool retry =
+            st == ENTRY_CANCELLED || (st == ENTRY_FAILED && i->first == n);
+
+        if (inside && !retry)
+        {
+            ++i;
+            continue;
+        }
+
+        i->second->group.cancel ();
+        evicted.push_back (std::move (i->second));
+        i = entries.erase (i);
+    }
+
+    for (size_t i = 0; i < wanted.size (); ++i)
+    {
+        int f = wanted[i];
+        if (entries.count (f)) continue;
+
+        unique_ptr<Entry> e (new Entry (f));
+        e->buffer = takeBuffer ();
+        e->group.setPriority (int (wanted.size () - i));
+
+        Entry* ep = e.get ();
+        entries[f] = std::move (e);
+
+        if (threads)
+            ILMTHREAD_NAMESPACE::ThreadPool::addGlobalTask (
+                new LoadTask (this, ep));
+    }
+}
+
+void
+SequenceReader::Data::load (Entry& e)
+{
+    shared_ptr<Frame> fr;
+    string            error;
+    EntryState        state = ENTRY_READY;
+
+    if (e.group.isCancelled ())
+        state = ENTRY_CANCELLED;
+    else
+    {
+        try
+        {
+            string fileName = frameFileName (pattern, e.frame);
+
+            //
+            // frames are decoded in parallel with each other, so each
+            // file is read single threaded rather than waiting on
+            // chunk tasks queued behind other frames
+            //
+
+            MultiPartInputFile in (fileName.c_str (), 1);
+            InputPart          part (in, options.partNumber);
+
+            fr               = make_shared<Frame> ();
+            fr->_number      = e.frame;
+            fr->_header      = part.header ();
+            fr->_buffer      = e.buffer;
+            fr->_frameBuffer = e.buffer->frameBuffer;
+
+            const Box2i& dw = header.dataWindow ();
+
+            part.setReadPlan (*e.buffer->plan);
+            part.readPixels (dw.min.y, dw.max.y);
+
+            if (e.group.isCancelled ())
+            {
+                state = ENTRY_CANCELLED;
+                fr.reset ();
+            }
+        }
+        catch (std::exception& ex)
+        {
+            state = ENTRY_FAILED;
+            error = ex.what ();
+            fr.reset ();
+        }
+    }
+
+    {
+        lock_guard<mutex> lk (mx);
+        e.state  = state;
+        e.error  = std::move (error);
+        e.result = std::move (fr);
+    }
+    cv.notify_all ();
+}
+
+////////////////////////////////////////
+
+SequenceReader::SequenceReader (
+    const string&      pattern,
+    int                firstFrame,
+    int                lastFrame,
+    const FrameBuffer& layout,
+    const Options&     options)
+    : _data (new Data)
+{
+    if (lastFrame < firstFrame)
+        THROW (
+            ArgExc,
+            "Invalid frame range " << firstFrame << " - " << lastFrame
+                                   << " for sequence \"" << pattern << "\".");
+
+    _data->pattern = pattern;
+    _data->first   = firstFrame;
+    _data->last    = lastFrame;
+    _data->options = options;
+    _data->layout  = layout;
+
+    {
+        string             fileName = frameFileName (pattern, firstFrame);
+        MultiPartInputFile in (fileName.c_str (), 1);
+        _data->header = in.header (options.partNumber);
+    }
+
+    int64_t      minOffset = INT64_MAX;
+    int64_t      maxOffset = 0;
+    const Box2i& dw        = _data->header.dataWindow ();
+
+    for (FrameBuffer::ConstIterator i = layout.begin (); i != layout.end ();
+         ++i)
+        sliceExtent (i.slice (), dw, minOffset, maxOffset);
+
+    if (layout.begin () == layout.end ())
+        THROW (ArgExc, "Sequence reader layout has no slices.");
+
+    if (minOffset < 0)
+        THROW (
+            ArgExc,
+            "Sequence reader layout addresses memory before the start "
+            "of the frame (offset "
+                << minOffset << ").");
+
+    _data->frameBytes = size_t (maxOffset);
+
+    int nframes = std::max (options.framesAhead, 0) +
+                  std::max (options.framesBehind, 0) + 1;
+    if (options.memoryBudget > 0)
+    {
+        size_t fit = options.memoryBudget / _data->frameBytes;
+        nframes    = int (std::min (size_t (nframes), std::max (fit, size_t (1))));
+    }
+    _data->maxFrames = nframes;
+}
+
+SequenceReader::~SequenceReader ()
+{
+    vector<unique_ptr<Entry>> evicted;
+
+    {
+        lock_guard<mutex> lk (_data->mx);
+        for (auto& e: _data->entries)
+        {
+            e.second->group.cancel ();
+            evicted.push_back (std::move (e.second));
+        }
+        _data->entries.clear ();
+    }
+
+    // destroying the entries waits for any load still running
+    evicted.clear ();
+}
+
+int
+SequenceReader::firstFrame () const
+{
+    return _data->first;
+}
+
+int
+SequenceReader::lastFrame () const
+{
+    return _data->last;
+}
+
+const Header&
+SequenceReader::header () const
+{
+    return _data->header;
+}
+
+size_t
+SequenceReader::frameBytes () const
+{
+    return _data->frameBytes;
+}
+
+int
+SequenceReader::windowSize () const
+{
+    return _data->maxFrames;
+}
+
+string
+SequenceReader::frameFileName (const string& pattern, int frame)
+{
+    char   buf[64];
+    size_t pos;
+
+    //
+    // printf-style "%d" or "%0Nd"
+    //
+
+    pos = pattern.find ('%');
+    while (pos != string::npos)
+    {
+        size_t end = pos + 1;
+        while (end < pattern.size () && isdigit (pattern[end]))
+            ++end;
+
+        if (end < pattern.size () && pattern[end] == 'd')
+        {
+            string spec = pattern.substr (pos, end - pos + 1);
+            snprintf (buf, sizeof (buf), spec.c_str (), frame);
+            return pattern.substr (0, pos) + buf + pattern.substr (end + 1);
+        }
+
+        pos = pattern.find ('%', pos + 1);
+    }
+
+    //
+    // a run of '#', one per digit
+    //
+
+    pos = pattern.find ('#');
+    if (pos != string::npos)
+    {
+        size_t end = pattern.find_first_not_of ('#', pos);
+        if (end == string::npos) end = pattern.size ();
+
+        snprintf (buf, sizeof (buf), "%0*d", int (end - pos), frame);
+        return pattern.substr (0, pos) + buf + pattern.substr (end);
+    }
+
+    THROW (
+        ArgExc,
+        "Sequence pattern \"" << pattern
+                              << "\" contains no frame number placeholder.");
+}
+
+shared_ptr<const SequenceReader::Frame>
+SequenceReader::frame (int n)
+{
+    if (n < _data->first || n > _data->last)
+        THROW (
+            ArgExc,
+            "Frame " << n << " is outside the sequence range " << _data->first
+                     << " - " << _data->last << ".");
+
+    lock_guard<mutex>         rlk (_data->requestMutex);
+    vector<unique_ptr<Entry>> evicted;
+    Entry*                    e;
+
+    {
+        unique_lock<mutex> lk (_data->mx);
+        _data->updateWindow (n, evicted);
+        e = _data->entries[n].get ();
+
+        if (e->state == ENTRY_QUEUED && !Data::threaded ())
+        {
+            lk.unlock ();
+            _data->load (*e);
+            lk.lock ();
+        }
+    }
+
+    _data->recycle (evicted);
+
+    unique_lock<mutex> lk (_data->mx);
+    _data->cv.wait (lk, [e] { return e->state != ENTRY_QUEUED; });
+
+    if (e->state != ENTRY_READY)
+    {
+        THROW (
+            InputExc,
+            "Unable to read frame " << n << " of sequence \"" << _data->pattern
+                                    << "\": " << e->error);
+    }
+
+    return e->result;
+}
+
+void
+SequenceReader::prefetch (int n)
+{
+    if (n < _data->first || n > _data->last)
+        THROW (
+            ArgExc,
+            "Frame " << n << " is outside the sequence range " << _data->first
+                     << " - " << _data->last << ".");
+
+    lock_guard<mutex>         rlk (_data->requestMutex);
+    vector<unique_ptr<Entry>> evicted;
+
+    {
+        lock_guard<mutex> lk (_data->mx);
+        _data->updateWindow (n, evicted);
+    }
+
+    _data->recycle (evicted);
+}
+
+bool
+SequenceReader::isReady (int n) const
+{
+    lock_guard<mutex> lk (_data->mx);
+    auto              i = _data->entries.find (n);
+    return i != _data->entries.end () && i->second->state == ENTRY_READY;
+}
+
+////////////////////////////////////////
+
+int
+SequenceReader::Frame::number () const
+{
+    return _number;
+}
+
+const Header&
+SequenceReader::Frame::header () const
+{
+    return _header;
+}
+
+const FrameBuffer&
+SequenceReader::Frame::frameBuffer () const
+{
+    return _frameBuffer;
+}
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_SOURCE_EXIT
@@ -0,0 +1,177 @@
+//
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) Contributors to the OpenEXR Project.
+//
+
+#ifndef INCLUDED_IMF_SEQUENCE_READER_H
+#define INCLUDED_IMF_SEQUENCE_READER_H
+
+//----------------------------------------------------------------------------
+//
+//      class SequenceReader
+//
+//      Reads the frames of an image sequence, opening and decoding the
+//      frames around the current one in the background on the global
+//      thread pool, such that a playback or review tool does not have
+//      to wait for file I/O when stepping to the next frame.
+//
+//      The reader keeps a sliding window of frames around the frame
+//      most recently asked for.  The window extends further in the
+//      direction the playhead is moving, follows the playhead when
+//      scrubbing backwards, and is limited by a memory budget.  Frames
+//      closer to the playhead are decoded first; frames that fall out
+//      of the window are cancelled or released.
+//
+//      All frames are read into memory laid out the same way, as
+//      described by a layout frame buffer (see below), and must have
+//      the same channels, data window and compression as the first
+//      frame of the sequence.
+//
+//----------------------------------------------------------------------------
+
+#include "ImfUtilExport.h"
+
+#include "ImfFrameBuffer.h"
+#include "ImfHeader.h"
+
+#include <memory>
+#include <string>
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_HEADER_ENTER
+
+class IMFUTIL_EXPORT_TYPE SequenceReader
+{
+public:
+    struct Options
+    {
+        int    framesAhead;  // frames kept ahead of the playhead
+        int    framesBehind; // frames kept behind the playhead
+        size_t memoryBudget; // bytes of pixel data, 0 for no limit
+        int    partNumber;   // part of each file to read
+
+        Options ()
+            : framesAhead (8), framesBehind (2), memoryBudget (0), partNumber (0)
+        {}
+    };
+
+    //------------------------------------------------------------------
+    // A decoded frame.  Frames are handed out as shared pointers; the
+    // pixel data stay valid for as long as the caller holds on to the
+    // frame, even after the reader has moved on.
+    //------------------------------------------------------------------
+
+    class IMFUTIL_EXPORT_TYPE Frame
+    {
+    public:
+        IMFUTIL_EXPORT int                number () const;
+        IMFUTIL_EXPORT const Header&      header () const;
+        IMFUTIL_EXPORT const FrameBuffer& frameBuffer () const;
+
+    private:
+        friend class SequenceReader;
+
+        int                     _number = 0;
+        Header                  _header;
+        std::shared_ptr<void>   _buffer;
+        FrameBuffer             _frameBuffer;
+    };
+
+    //------------------------------------------------------------------
+    // Constructor
+    //
+    // pattern is the file name of the frames, with the frame number
+    // given either printf-style ("shot.%04d.exr") or as a run of '#'
+    // characters, one per digit ("shot.####.exr").  The frames range
+    // from firstFrame to lastFrame inclusive.  The header of the first
+    // frame is read up front.
+    //
+    // layout describes where the pixels of a frame go.  The slices
+    // follow the usual FrameBuffer conventions, but their base
+    // pointers are byte offsets into a block of memory starting at
+    // address zero rather than actual addresses; for example
+    //
+    //     Slice::Make (FLOAT, (void*) 0, dataWindow, 16, 16 * width)
+    //
+    // places "R" at offset zero of each 16-byte pixel.  The reader
+    // allocates one such block per frame in the window.
+    //------------------------------------------------------------------
+
+    IMFUTIL_EXPORT
+    SequenceReader (
+        const std::string& pattern,
+        int                firstFrame,
+        int                lastFrame,
+        const FrameBuffer& layout,
+        const Options&     options = Options ());
+
+    //------------------------------------------------------------------
+    // Destructor -- cancels pending reads and waits for the ones in
+    // progress to return.
+    //------------------------------------------------------------------
+
+    IMFUTIL_EXPORT
+    ~SequenceReader ();
+
+    SequenceReader (const SequenceReader&)            = delete;
+    SequenceReader& operator= (const SequenceReader&) = delete;
+
+    IMFUTIL_EXPORT int firstFrame () const;
+    IMFUTIL_EXPORT int lastFrame () const;
+
+    //--------------------------------------------------
+    // Header of the first frame, and the number of
+    // bytes of memory used by each frame in the window
+    //--------------------------------------------------
+
+    IMFUTIL_EXPORT const Header& header () const;
+    IMFUTIL_EXPORT size_t        frameBytes () const;
+
+    //------------------------------------------------------------------
+    // Maximum number of frames held in the window, derived from the
+    // options and the memory budget (at least one).
+    //------------------------------------------------------------------
+
+    IMFUTIL_EXPORT int windowSize () const;
+
+    //------------------------------------------------------------------
+    // Returns the file name for a frame number.
+    //------------------------------------------------------------------
+
+    IMFUTIL_EXPORT
+    static std::string frameFileName (const std::string& pattern, int frame);
+
+    //------------------------------------------------------------------
+    // frame(n) moves the playhead to frame n, updates the window, and
+    // returns frame n, waiting for it to finish decoding if necessary.
+    // Throws an exception if the frame could not be read.
+    //
+    // prefetch(n) moves the playhead without waiting, so reading can
+    // start ahead of the first call to frame(), e.g. when playback is
+    // about to start.
+    //
+    // isReady(n) returns true if frame n has been decoded and frame(n)
+    // would return without waiting.
+    //
+    // The direction of the window is taken from the last two playhead
+    // positions; calling frame() with decreasing numbers scrubs
+    // backwards.  Frame numbers must be within [firstFrame(),
+    // lastFrame()].
+    //------------------------------------------------------------------
+
+    IMFUTIL_EXPORT
+    std::shared_ptr<const Frame> frame (int n);
+
+    IMFUTIL_EXPORT
+    void prefetch (int n);
+
+    IMFUTIL_EXPORT
+    bool isReady (int n) const;
+
+private:
+    struct IMFUTIL_HIDDEN Data;
+    std::unique_ptr<Data> _data;
+};
+
+OPENEXR_IMF_INTERNAL_NAMESPACE_HEADER_EXIT
+
+#endif
@@ -1633,6 +1633,114 @@ testHUF (const std::string& tempdir)
 
 ////////////////////////////////////////
 
+//
+// Readers take a chunk whose packed size equals its unpacked size to
+// be stored raw, so the zip encoder must fall back to the raw data
+// whenever deflate does not make a chunk smaller, including when the
+// sizes come out equal.  Each scan line here starts with a longer run
+// of zeroes than the one before, followed by random bytes, so the
+// compressed sizes of the lines sweep through the unpacked size.
+//
+
+static void
+testZipRawFallback (const std::string& tempdir, exr_compression_t comp)
+{
+    const int                 width = 64, height = width * 4;
+    std::string               filename = tempdir + "imf_test_zip_raw.exr";
+    exr_context_t             f;
+    int                       partidx;
+    exr_context_initializer_t cinit = EXR_DEFAULT_CONTEXT_INITIALIZER;
+    exr_chunk_info_t          cinfo;
+    int32_t                   scansperchunk;
+
+    std::vector<uint32_t> pix (width * height), back (width * height);
+    Rand48                rand (17);
+
+    for (int y = 0; y < height; ++y)
+    {
+        uint8_t* line = reinterpret_cast<uint8_t*> (&pix[y * width]);
+        for (int b = 0; b < width * 4; ++b)
+            line[b] = (b < y) ? 0 : (uint8_t) rand.nexti ();
+    }
+
+    EXRCORE_TEST_RVAL (exr_start_write (
+        &f, filename.c_str (), EXR_WRITE_FILE_DIRECTLY, &cinit));
+    EXRCORE_TEST_RVAL (
+        exr_add_part (f, "scan", EXR_STORAGE_SCANLINE, &partidx));
+    EXRCORE_TEST_RVAL (exr_initialize_required_attr_simple (
+        f, partidx, width, height, comp));
+    EXRCORE_TEST_RVAL (exr_add_channel (
+        f, partidx, "I", EXR_PIXEL_UINT, EXR_PERCEPTUALLY_LOGARITHMIC, 1, 1));
+    EXRCORE_TEST_RVAL (exr_write_header (f));
+    EXRCORE_TEST_RVAL (exr_get_scanlines_per_chunk (f, 0, &scansperchunk));
+
+    exr_encode_pipeline_t encoder;
+    for (int y = 0; y < height; y += scansperchunk)
+    {
+        EXRCORE_TEST_RVAL (exr_write_scanline_chunk_info (f, 0, y, &cinfo));
+        if (y == 0)
+        {
+            EXRCORE_TEST_RVAL (
+                exr_encoding_initialize (f, 0, &cinfo, &encoder));
+        }
+        else
+        {
+            EXRCORE_TEST_RVAL (exr_encoding_update (f, 0, &cinfo, &encoder));
+        }
+
+        encoder.channels[0].encode_from_ptr =
+            reinterpret_cast<const uint8_t*> (&pix[y * width]);
+        encoder.channels[0].user_pixel_stride = sizeof (uint32_t);
+        encoder.channels[0].user_line_stride  = width * sizeof (uint32_t);
+
+        if (y == 0)
+        {
+            EXRCORE_TEST_RVAL (
+                exr_encoding_choose_default_routines (f, 0, &encoder));
+        }
+        EXRCORE_TEST_RVAL (exr_encoding_run (f, 0, &encoder));
+    }
+    EXRCORE_TEST_RVAL (exr_encoding_destroy (f, &encoder));
+    EXRCORE_TEST_RVAL (exr_finish (&f));
+
+    EXRCORE_TEST_RVAL (exr_start_read (&f, filename.c_str (), &cinit));
+
+    exr_decode_pipeline_t decoder;
+    for (int y = 0; y < height; y += scansperchunk)
+    {
+        EXRCORE_TEST_RVAL (exr_read_scanline_chunk_info (f, 0, y, &cinfo));
+
+        if (y == 0)
+        {
+            EXRCORE_TEST_RVAL (
+                exr_decoding_initialize (f, 0, &cinfo, &decoder));
+        }
+        else
+        {
+            EXRCORE_TEST_RVAL (exr_decoding_update (f, 0, &cinfo, &decoder));
+        }
+
+        decoder.channels[0].decode_to_ptr =
+            reinterpret_cast<uint8_t*> (&back[y * width]);
+        decoder.channels[0].user_pixel_stride = sizeof (uint32_t);
+        decoder.channels[0].user_line_stride  = width * sizeof (uint32_t);
+
+        if (y == 0)
+        {
+            EXRCORE_TEST_RVAL (
+                exr_decoding_choose_default_routines (f, 0, &decoder));
+        }
+        EXRCORE_TEST_RVAL (exr_decoding_run (f, 0, &decoder));
+    }
+    EXRCORE_TEST_RVAL (exr_decoding_destroy (f, &decoder));
+    EXRCORE_TEST_RVAL (exr_finish (&f));
+    remove (filename.c_str ());
+
+    EXRCORE_TEST (pix == back);
+}
+
+////////////////////////////////////////
+
 void
 testNoCompression (const std::string& tempdir)
 {
@@ -1655,6 +1763,7 @@ void
 testZIPSCompression (const std::string& tempdir)
 {
     testComp (tempdir, EXR_COMPRESSION_ZIPS);
+    testZipRawFallback (tempdir, EXR_COMPRESSION_ZIPS);
 }
 
 void
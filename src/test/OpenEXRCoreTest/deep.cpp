@@ -16,6 +16,7 @@
 #include <ImfDeepTiledOutputFile.h>
 #include <ImfPartType.h>
 #include <random>
+#include <string.h>
 #include <vector>
 
 namespace IMF = OPENEXR_IMF_NAMESPACE;
@@ -367,6 +368,111 @@ generateRandomTileFile (
     std::cout << "   --> done" << std::endl;
 }
 
+//
+// decode one line through the deep unpackers, into a contiguous
+// buffer per channel and through per-pixel pointers, with half
+// channels widened to float
+//
+
+void
+checkDeepUnpack (exr_context_t f, int y)
+{
+    exr_chunk_info_t      cinfo;
+    exr_decode_pipeline_t decoder = EXR_DECODE_PIPELINE_INITIALIZER;
+    int                   line    = y - minY;
+    size_t                total   = 0;
+
+    for (int x = 0; x < width; ++x)
+        total += sampleCountScans[line][x];
+
+    EXRCORE_TEST_RVAL (exr_read_scanline_chunk_info (f, 0, y, &cinfo));
+    EXRCORE_TEST_RVAL (exr_decoding_initialize (f, 0, &cinfo, &decoder));
+
+    std::vector<std::vector<uint32_t>> out (decoder.channel_count);
+    std::vector<std::vector<void*>>    ptrs (decoder.channel_count);
+
+    auto check = [&] (int stride) {
+        for (int c = 0; c < decoder.channel_count; ++c)
+        {
+            const exr_coding_channel_info_t& ch = decoder.channels[c];
+            size_t                           s  = 0;
+
+            for (int x = 0; x < width; ++x)
+            {
+                uint32_t v = (line * width + x) % 2049;
+                for (unsigned int n = 0; n < sampleCountScans[line][x]; ++n)
+                {
+                    uint32_t got = out[c][s + n];
+                    if (ch.data_type == EXR_PIXEL_UINT)
+                        EXRCORE_TEST (got == v);
+                    else
+                    {
+                        float fv;
+                        memcpy (&fv, &got, sizeof (float));
+                        EXRCORE_TEST (fv == (float) v);
+                    }
+                }
+                s += sampleCountScans[line][x] + stride;
+            }
+        }
+    };
+
+    // contiguous, with individual counts
+    decoder.decode_flags |= EXR_DECODE_SAMPLE_COUNTS_AS_INDIVIDUAL;
+    for (int c = 0; c < decoder.channel_count; ++c)
+    {
+        exr_coding_channel_info_t& ch = decoder.channels[c];
+
+        out[c].assign (total + width, 0);
+        ch.user_data_type = (ch.data_type == EXR_PIXEL_HALF)
+                                ? EXR_PIXEL_FLOAT
+                                : (exr_pixel_type_t) ch.data_type;
+        ch.user_bytes_per_element = 4;
+        ch.decode_to_ptr          = (uint8_t*) out[c].data ();
+    }
+    EXRCORE_TEST_RVAL (exr_decoding_choose_default_routines (f, 0, &decoder));
+    EXRCORE_TEST_RVAL (exr_decoding_run (f, 0, &decoder));
+    for (int x = 0; x < width; ++x)
+        EXRCORE_TEST (
+            decoder.sample_count_table[x] ==
+            (int32_t) sampleCountScans[line][x]);
+    EXRCORE_TEST (decoder.sample_count_table[width] == (int32_t) total);
+    check (0);
+
+    // per-pixel pointers, packed back to back as by an arena, then
+    // with a gap of one sample between pixels, with cumulative counts
+    decoder.decode_flags |= EXR_DECODE_NON_IMAGE_DATA_AS_POINTERS;
+    for (int gap = 0; gap <= 1; ++gap)
+    {
+        for (int c = 0; c < decoder.channel_count; ++c)
+        {
+            exr_coding_channel_info_t& ch = decoder.channels[c];
+            size_t                     s  = 0;
+
+            out[c].assign (total + width, 0);
+            ptrs[c].resize (width);
+            for (int x = 0; x < width; ++x)
+            {
+                ptrs[c][x] = out[c].data () + s;
+                s += sampleCountScans[line][x] + gap;
+            }
+            ch.user_pixel_stride = sizeof (void*);
+            ch.user_line_stride  = sizeof (void*) * width;
+            ch.decode_to_ptr     = (uint8_t*) ptrs[c].data ();
+        }
+        if (gap)
+            decoder.decode_flags &= ~EXR_DECODE_SAMPLE_COUNTS_AS_INDIVIDUAL;
+        EXRCORE_TEST_RVAL (
+            exr_decoding_choose_default_routines (f, 0, &decoder));
+        EXRCORE_TEST_RVAL (exr_decoding_run (f, 0, &decoder));
+        check (gap);
+    }
+    EXRCORE_TEST (
+        decoder.sample_count_table[width - 1] == (int32_t) total);
+
+    exr_decoding_destroy (f, &decoder);
+}
+
 } // namespace
 
 void
@@ -473,8 +579,50 @@ testReadDeep (const std::string& tempdir)
             EXRCORE_TEST_RVAL (
                 exr_read_deep_chunk (f, 0, &cinfo, NULL, &sampdata[0]));
 
+            // sample counts alone, without the sample data
+            {
+                std::vector<int32_t> counts (cinfo.width * cinfo.height);
+                uint64_t             total = 0, expected = 0;
+
+                EXRCORE_TEST_RVAL (exr_read_deep_sample_counts (
+                    f, 0, &cinfo, counts.data (), &total));
+                for (int x = 0; x < width; ++x)
+                {
+                    unsigned int n = sampleCountScans[height / 4][x];
+                    EXRCORE_TEST (counts[x] == (int32_t) n);
+                    expected += n;
+                }
+                EXRCORE_TEST (total == expected);
+
+                total = 0;
+                EXRCORE_TEST_RVAL (
+                    exr_read_deep_sample_counts (f, 0, &cinfo, NULL, &total));
+                EXRCORE_TEST (total == expected);
+            }
+
+            checkDeepUnpack (f, minY + height / 3);
+
             exr_finish (&f);
 
+            for (int nt = 1; nt <= 8; nt += 7)
+            {
+                DeepScanLineInputFile file (fn.c_str (), nt);
+                uint64_t              expected = 0, part = 0;
+                for (int y = 0; y < height; ++y)
+                {
+                    for (int x = 0; x < width; ++x)
+                    {
+                        expected += sampleCountScans[y][x];
+                        if (y >= 10 && y <= 20) part += sampleCountScans[y][x];
+                    }
+                }
+                EXRCORE_TEST (
+                    file.totalSampleCount (minY, minY + height - 1) ==
+                    expected);
+                EXRCORE_TEST (
+                    file.totalSampleCount (minY + 20, minY + 10) == part);
+            }
+
             generateRandomTileFile (fn, chancounts[c], comps[cp]);
             EXRCORE_TEST_RVAL (exr_start_read (&f, fn.c_str (), &cinit));
 
@@ -485,8 +633,171 @@ testReadDeep (const std::string& tempdir)
             EXRCORE_TEST_RVAL (
                 exr_read_deep_chunk (f, 0, &cinfo, &packed[0], &sampdata[0]));
 
+            EXRCORE_TEST_RVAL (
+                exr_read_tile_chunk_info (f, 0, 0, 0, 0, 0, &cinfo));
+            {
+                std::vector<int32_t> counts (cinfo.width * cinfo.height);
+                uint64_t             total = 0, expected = 0;
+
+                EXRCORE_TEST_RVAL (exr_read_deep_sample_counts (
+                    f, 0, &cinfo, counts.data (), &total));
+                for (int y = 0; y < cinfo.height; ++y)
+                {
+                    for (int x = 0; x < cinfo.width; ++x)
+                    {
+                        unsigned int n = sampleCountTiles[0][0][y][x];
+                        EXRCORE_TEST (counts[y * cinfo.width + x] == (int32_t) n);
+                        expected += n;
+                    }
+                }
+                EXRCORE_TEST (total == expected);
+            }
+
             exr_finish (&f);
+
+            for (int nt = 1; nt <= 8; nt += 7)
+            {
+                DeepTiledInputFile file (fn.c_str (), nt);
+                for (int ly = 0; ly < file.numYLevels (); ++ly)
+                {
+                    for (int lx = 0; lx < file.numXLevels (); ++lx)
+                    {
+                        uint64_t expected = 0;
+                        for (int y = 0; y < file.levelHeight (ly); ++y)
+                            for (int x = 0; x < file.levelWidth (lx); ++x)
+                                expected += sampleCountTiles[ly][lx][y][x];
+
+                        EXRCORE_TEST (
+                            file.totalSampleCount (
+                                file.numXTiles (lx) - 1,
+                                0,
+                                file.numYTiles (ly) - 1,
+                                0,
+                                lx,
+                                ly) == expected);
+                    }
+                }
+            }
+        }
+    }
+    remove (fn.c_str ());
+}
+
+//
+// a cumulative sample count table that decreases must be rejected,
+// also when the differences of its entries wrap around to positive
+// counts and the line total comes out right, both for the part of a
+// line the vector code checks and for the rest
+//
+
+void
+testReadDeepBadCounts (const std::string& tempdir)
+{
+    std::string fn = tempdir;
+
+    exr_context_t             f;
+    exr_context_initializer_t cinit = EXR_DEFAULT_CONTEXT_INITIALIZER;
+    cinit.error_handler_fn          = &err_cb;
+
+    fn += "badcountsdeep.exr";
+
+    const int w = 7;
+
+    for (int start = 0; start <= 4; start += 4)
+    {
+        {
+            Box2i  dw (V2i (0, 0), V2i (w - 1, 0));
+            Header hdr (
+                dw,
+                dw,
+                1,
+                IMATH_NAMESPACE::V2f (0, 0),
+                1,
+                INCREASING_Y,
+                NO_COMPRESSION);
+            hdr.channels ().insert ("Z", Channel (IMF::UINT));
+            hdr.setType (DEEPSCANLINE);
+
+            unsigned int counts[w] = {0};
+            void*        ptrs[w]   = {nullptr};
+
+            DeepFrameBuffer fb;
+            fb.insertSampleCountSlice (
+                Slice (IMF::UINT, (char*) counts, sizeof (unsigned int), 0));
+            fb.insert (
+                "Z",
+                DeepSlice (
+                    IMF::UINT,
+                    (char*) ptrs,
+                    sizeof (void*),
+                    0,
+                    sizeof (unsigned int)));
+
+            remove (fn.c_str ());
+            DeepScanLineOutputFile out (fn.c_str (), hdr);
+            out.setFrameBuffer (fb);
+            out.writePixels (1);
+        }
+
+        // cumulative counts (..., 10, INT_MIN + 5, 0, ...); the
+        // differences 10, 2147483643, 2147483643 are all positive
+        exr_chunk_info_t cinfo;
+
+        EXRCORE_TEST_RVAL (exr_start_read (&f, fn.c_str (), &cinit));
+        EXRCORE_TEST_RVAL (exr_read_scanline_chunk_info (f, 0, 0, &cinfo));
+        EXRCORE_TEST (cinfo.sample_count_table_size == w * sizeof (int32_t));
+        exr_finish (&f);
+
+        {
+            const uint32_t bad[3] = {10, 0x80000005u, 0};
+            FILE*          fp     = fopen (fn.c_str (), "r+b");
+            EXRCORE_TEST (fp != NULL);
+            for (int i = 0; i < 3; ++i)
+            {
+                uint8_t le[4] = {
+                    (uint8_t) bad[i],
+                    (uint8_t) (bad[i] >> 8),
+                    (uint8_t) (bad[i] >> 16),
+                    (uint8_t) (bad[i] >> 24)};
+                EXRCORE_TEST (
+                    fseek (
+                        fp,
+                        (long) (cinfo.sample_count_data_offset +
+                                (start + i) * sizeof (int32_t)),
+                        SEEK_SET) == 0);
+                EXRCORE_TEST (fwrite (le, 1, 4, fp) == 4);
+            }
+            fclose (fp);
+        }
+
+        EXRCORE_TEST_RVAL (exr_start_read (&f, fn.c_str (), &cinit));
+        EXRCORE_TEST_RVAL (exr_read_scanline_chunk_info (f, 0, 0, &cinfo));
+
+        EXRCORE_TEST_RVAL_FAIL (
+            EXR_ERR_INVALID_SAMPLE_DATA,
+            exr_read_deep_sample_counts (f, 0, &cinfo, NULL, NULL));
+
+        for (int individual = 0; individual <= 1; ++individual)
+        {
+            exr_decode_pipeline_t decoder = EXR_DECODE_PIPELINE_INITIALIZER;
+            uint32_t              zout[64];
+
+            EXRCORE_TEST_RVAL (
+                exr_decoding_initialize (f, 0, &cinfo, &decoder));
+            if (individual)
+                decoder.decode_flags |= EXR_DECODE_SAMPLE_COUNTS_AS_INDIVIDUAL;
+            decoder.channels[0].user_bytes_per_element = 4;
+            decoder.channels[0].user_data_type         = EXR_PIXEL_UINT;
+            decoder.channels[0].decode_to_ptr          = (uint8_t*) zout;
+            EXRCORE_TEST_RVAL (
+                exr_decoding_choose_default_routines (f, 0, &decoder));
+            EXRCORE_TEST_RVAL_FAIL (
+                EXR_ERR_INVALID_SAMPLE_DATA,
+                exr_decoding_run (f, 0, &decoder));
+            exr_decoding_destroy (f, &decoder);
         }
+
+        exr_finish (&f);
     }
     remove (fn.c_str ());
 }
@@ -9,6 +9,7 @@
 void testOpenDeep (const std::string& tempdir);
 
 void testReadDeep (const std::string& tempdir);
+void testReadDeepBadCounts (const std::string& tempdir);
 void testWriteDeep (const std::string& tempdir);
 
 #endif // OPENEXR_CORE_TEST_READ_H
@@ -12,6 +12,7 @@
 #include <math.h>
 #include <string.h>
 
+#include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <memory>
@@ -1263,9 +1264,93 @@ testWriteAttrs (const std::string& tempdir)
     remove (outfn.c_str ());
 }
 
+static std::string
+readFileBytes (const std::string& fn)
+{
+    std::ifstream in (fn.c_str (), std::ios_base::binary);
+    return std::string (
+        std::istreambuf_iterator<char> (in), std::istreambuf_iterator<char> ());
+}
+
 void
 testUpdateMeta (const std::string& tempdir)
-{}
+{
+    exr_context_t             f;
+    std::string               fn    = ILM_IMF_TEST_IMAGEDIR;
+    std::string               outfn = tempdir + "v1.7.test.planar.update.exr";
+    exr_context_initializer_t cinit = EXR_DEFAULT_CONTEXT_INITIALIZER;
+    cinit.error_handler_fn          = &err_cb;
+
+    fn += "v1.7.test.planar.exr";
+
+    std::string orig = readFileBytes (fn);
+    {
+        std::ofstream out (outfn.c_str (), std::ios_base::binary);
+        out.write (orig.data (), orig.size ());
+    }
+
+    EXRCORE_TEST_RVAL_FAIL (
+        EXR_ERR_INVALID_ARGUMENT,
+        exr_start_inplace_header_update (NULL, outfn.c_str (), &cinit));
+    EXRCORE_TEST_RVAL_FAIL (
+        EXR_ERR_INVALID_ARGUMENT,
+        exr_start_inplace_header_update (&f, NULL, &cinit));
+
+    EXRCORE_TEST_RVAL (
+        exr_start_inplace_header_update (&f, outfn.c_str (), &cinit));
+
+    uint64_t hdrsize;
+    EXRCORE_TEST_RVAL (exr_get_chunk_table_offset (f, 0, &hdrsize));
+
+    // values of the same size can be changed...
+    EXRCORE_TEST_RVAL (exr_attr_set_int (f, 0, "a4", 42));
+    EXRCORE_TEST_RVAL (exr_attr_set_float (f, 0, "pixelAspectRatio", 2.f));
+    EXRCORE_TEST_RVAL (exr_attr_set_string (
+        f, 0, "a7", "extensive renovation by Nebuchadrezzar has left"));
+
+    // ...but attributes cannot be added or change size
+    EXRCORE_TEST_RVAL_FAIL (
+        EXR_ERR_NO_ATTR_BY_NAME, exr_attr_set_string (f, 0, "owner", "me"));
+    EXRCORE_TEST_RVAL_FAIL (
+        EXR_ERR_MODIFY_SIZE_CHANGE,
+        exr_attr_set_string (f, 0, "a7", "something shorter"));
+
+    EXRCORE_TEST_RVAL (exr_write_header (f));
+    EXRCORE_TEST_RVAL (exr_finish (&f));
+
+    // only the header has changed
+    std::string updated = readFileBytes (outfn);
+    EXRCORE_TEST (updated.size () == orig.size ());
+    EXRCORE_TEST (updated.compare (0, hdrsize, orig, 0, hdrsize) != 0);
+    EXRCORE_TEST (
+        updated.compare (hdrsize, std::string::npos, orig, hdrsize) == 0);
+
+    EXRCORE_TEST_RVAL (exr_start_read (&f, outfn.c_str (), &cinit));
+
+    int32_t     ival;
+    float       fval;
+    const char* sval;
+    int32_t     slen;
+    EXRCORE_TEST_RVAL (exr_attr_get_int (f, 0, "a4", &ival));
+    EXRCORE_TEST (ival == 42);
+    EXRCORE_TEST_RVAL (exr_get_pixel_aspect_ratio (f, 0, &fval));
+    EXRCORE_TEST (fval == 2.f);
+    EXRCORE_TEST_RVAL (exr_attr_get_string (f, 0, "a7", &slen, &sval));
+    EXRCORE_TEST (
+        0 == strcmp (
+                 sval, "extensive renovation by Nebuchadrezzar has left"));
+
+    uint32_t origflags, flags;
+    EXRCORE_TEST_RVAL (exr_get_file_version_and_flags (f, &flags));
+    EXRCORE_TEST_RVAL (exr_finish (&f));
+
+    EXRCORE_TEST_RVAL (exr_start_read (&f, fn.c_str (), &cinit));
+    EXRCORE_TEST_RVAL (exr_get_file_version_and_flags (f, &origflags));
+    EXRCORE_TEST (flags == origflags);
+    EXRCORE_TEST_RVAL (exr_finish (&f));
+
+    remove (outfn.c_str ());
+}
 
 void
 testWriteScans (const std::string& tempdir)
@@ -1357,6 +1442,36 @@ testWriteTiles (const std::string& tempdir)
     EXRCORE_TEST_RVAL (exr_finish (&testf));
 
     remove (outfn.c_str ());
+
+    // edge tiles of the lower levels are clipped to the level size,
+    // not to the data window
+    exr_chunk_info_t cinfo;
+
+    EXRCORE_TEST_RVAL (exr_start_write (
+        &outf, outfn.c_str (), EXR_WRITE_FILE_DIRECTLY, &cinit));
+    EXRCORE_TEST_RVAL (
+        exr_add_part (outf, "mip", EXR_STORAGE_TILED, &partidx));
+    EXRCORE_TEST_RVAL (exr_initialize_required_attr_simple (
+        outf, partidx, 20, 20, EXR_COMPRESSION_NONE));
+    EXRCORE_TEST_RVAL (exr_add_channel (
+        outf, partidx, "Y", EXR_PIXEL_HALF, EXR_PERCEPTUALLY_LOGARITHMIC, 1, 1));
+    EXRCORE_TEST_RVAL (exr_set_tile_descriptor (
+        outf, partidx, 8, 8, EXR_TILE_MIPMAP_LEVELS, EXR_TILE_ROUND_DOWN));
+    EXRCORE_TEST_RVAL (exr_write_header (outf));
+
+    EXRCORE_TEST_RVAL (exr_write_tile_chunk_info (outf, 0, 2, 2, 0, 0, &cinfo));
+    EXRCORE_TEST (cinfo.width == 4);
+    EXRCORE_TEST (cinfo.height == 4);
+    EXRCORE_TEST_RVAL (exr_write_tile_chunk_info (outf, 0, 1, 1, 1, 1, &cinfo));
+    EXRCORE_TEST (cinfo.width == 2);
+    EXRCORE_TEST (cinfo.height == 2);
+    EXRCORE_TEST (cinfo.unpacked_size == 2 * 2 * 2);
+    EXRCORE_TEST_RVAL (exr_write_tile_chunk_info (outf, 0, 0, 0, 2, 2, &cinfo));
+    EXRCORE_TEST (cinfo.width == 5);
+    EXRCORE_TEST (cinfo.height == 5);
+
+    exr_finish (&outf);
+    remove (outfn.c_str ());
 }
 
 void
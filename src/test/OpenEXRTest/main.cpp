@@ -15,6 +15,7 @@
 #include "testBadTypeAttributes.h"
 #include "testChannels.h"
 #include "testCompositeDeepScanLine.h"
+#include "testCompositeDeepTile.h"
 #include "testCompression.h"
 #include "testCompressionApi.h"
 #include "testConversion.h"
@@ -24,6 +25,7 @@
 #include "testCopyPixels.h"
 #include "testCpuId.h"
 #include "testCustomAttributes.h"
+#include "testDeepScanLineAutoAlloc.h"
 #include "testDeepScanLineBasic.h"
 #include "testDeepScanLineHuge.h"
 #include "testDeepScanLineMultipleRead.h"
@@ -51,6 +53,7 @@
 #include "testOptimizedInterleavePatterns.h"
 #include "testPartHelper.h"
 #include "testPreviewImage.h"
+#include "testReadPlan.h"
 #include "testRgba.h"
 #include "testRgbaThreading.h"
 #include "testRle.h"
@@ -58,6 +61,8 @@
 #include "testScanLineApi.h"
 #include "testSharedFrameBuffer.h"
 #include "testStandardAttributes.h"
+#include "testTailFollow.h"
+#include "testThreadPool.h"
 #include "testTiledCompression.h"
 #include "testTiledCopyPixels.h"
 #include "testTiledLineOrder.h"
@@ -183,6 +188,8 @@ main (int argc, char* argv[])
     TEST (testLargeDataWindowOffsets, "basic");
     TEST (testSharedFrameBuffer, "basic");
     TEST (testRgbaThreading, "basic");
+    TEST (testReadPlan, "basic");
+    TEST (testTailFollow, "basic");
     TEST (testChannels, "basic");
     TEST (testAttributes, "core");
     TEST (testCustomAttributes, "core");
@@ -211,9 +218,11 @@ main (int argc, char* argv[])
     TEST (testDeepScanLineBasic, "deep");
     TEST (testCopyDeepScanLine, "deep");
     TEST (testDeepScanLineMultipleRead, "deep");
+    TEST (testDeepScanLineAutoAlloc, "deep");
     TEST (testDeepTiledBasic, "deep");
     TEST (testCopyDeepTiled, "deep");
     TEST (testCompositeDeepScanLine, "deep");
+    TEST (testCompositeDeepTile, "deep");
     TEST (testMultiPartFileMixingBasic, "multi");
     TEST (testInputPart, "multi");
     TEST (testPartHelper, "multi");
@@ -229,6 +238,7 @@ main (int argc, char* argv[])
     TEST (testRle, "core");
     TEST (testIDManifest, "core");
     TEST (testCpuId, "core");
+    TEST (testThreadPool, "core");
     TEST (testHeader, "basic");
 
     // NB: If you add a test here, make sure to enumerate it in the
@@ -11,7 +11,9 @@
 #include "random.h"
 
 #include <Iex.h>
+#include <algorithm>
 #include <assert.h>
+#include <cmath>
 #include <iostream>
 #include <ostream>
 #include <sstream>
@@ -24,6 +26,7 @@
 #include <ImfChannelList.h>
 #include <ImfCompositeDeepScanLine.h>
 #include <ImfCompression.h>
+#include <ImfDeepCompositing.h>
 #include <ImfDeepFrameBuffer.h>
 #include <ImfDeepScanLineInputPart.h>
 #include <ImfDeepScanLineOutputPart.h>
@@ -638,6 +641,171 @@ test_parts (
     remove (fn.c_str ());
 }
 
+//
+// compositing with the built-in engine must give the same result as
+// compositing with a DeepCompositing object, which composites pixel by
+// pixel
+//
+
+void
+test_composite_span (bool zback, int num_channels, const std::string& tempDir)
+{
+    std::string fn = tempDir + "imf_test_composite_deep_scanline_span.exr";
+
+    const int number_of_parts = 3;
+    const int width           = 20;
+    const int height          = 15;
+    const int pixels          = width * height;
+
+    vector<string> names;
+    const char*    other[] = {"R", "G", "B", "S", "T", "U", "V"};
+    names.push_back ("Z");
+    if (zback) names.push_back ("ZBack");
+    names.push_back ("A");
+    for (int c = 3; c < num_channels; c++)
+        names.push_back (other[c - 3]);
+
+    vector<Header> headers (number_of_parts);
+    headers[0].dataWindow ().max.x = width - 1;
+    headers[0].dataWindow ().max.y = height - 1;
+    headers[0].displayWindow ()    = headers[0].dataWindow ();
+    headers[0].setType (DEEPSCANLINE);
+    headers[0].compression () = ZIPS_COMPRESSION;
+    for (size_t c = 0; c < names.size (); c++)
+        headers[0].channels ().insert (names[c], FLOAT);
+
+    for (int i = 0; i < number_of_parts; i++)
+    {
+        if (i > 0) headers[i] = headers[0];
+        ostringstream s;
+        s << "Part" << i;
+        headers[i].setName (s.str ());
+    }
+
+    {
+        MultiPartOutputFile f (fn.c_str (), &headers[0], headers.size ());
+
+        for (int i = 0; i < number_of_parts; i++)
+        {
+            vector<unsigned int> counts (pixels);
+            size_t               total = 0;
+
+            for (int p = 0; p < pixels; p++)
+            {
+                // mostly short runs, plus some long enough for the radix sort
+                counts[p] = (i == 0 && p % 37 == 0) ? 100 + random_int (400)
+                                                    : random_int (10);
+                total += counts[p];
+            }
+
+            vector<vector<float>>  samples (names.size ());
+            vector<vector<float*>> pointers (names.size ());
+
+            for (size_t c = 0; c < names.size (); c++)
+            {
+                samples[c].resize (total);
+                pointers[c].resize (pixels);
+            }
+
+            for (size_t s = 0; s < total; s++)
+            {
+                // coarse depths such that there are plenty of ties to break
+                float z = float (random_int (40)) * 0.25f - 1.0f;
+                if (z == 0.0f && random_int (2)) z = -0.0f;
+
+                size_t c        = 0;
+                samples[c++][s] = z;
+                if (zback) samples[c++][s] = z + float (random_int (4));
+                samples[c++][s] =
+                    random_int (50) == 0 ? 1.0f : random_float (0.2f);
+                for (; c < names.size (); c++)
+                    samples[c][s] = random_float (2.0f) - 0.5f;
+            }
+
+            for (size_t c = 0; c < names.size (); c++)
+            {
+                size_t s = 0;
+                for (int p = 0; p < pixels; p++)
+                {
+                    pointers[c][p] = samples[c].data () + s;
+                    s += counts[p];
+                }
+            }
+
+            DeepFrameBuffer fb;
+            fb.insertSampleCountSlice (Slice (
+                UINT,
+                (char*) &counts[0],
+                sizeof (unsigned int),
+                sizeof (unsigned int) * width));
+            for (size_t c = 0; c < names.size (); c++)
+            {
+                fb.insert (
+                    names[c],
+                    DeepSlice (
+                        FLOAT,
+                        (char*) &pointers[c][0],
+                        sizeof (float*),
+                        sizeof (float*) * width,
+                        sizeof (float)));
+            }
+
+            DeepScanLineOutputPart part (f, i);
+            part.setFrameBuffer (fb);
+            part.writePixels (height);
+        }
+    }
+
+    OPENEXR_IMF_NAMESPACE::DeepCompositing perPixelComp;
+    vector<vector<float>>                  results[2];
+
+    for (int r = 0; r < 2; r++)
+    {
+        MultiPartInputFile             input (fn.c_str ());
+        CompositeDeepScanLine          comp;
+        FrameBuffer                    fb;
+        vector<DeepScanLineInputPart*> parts (number_of_parts);
+
+        for (int i = 0; i < number_of_parts; i++)
+        {
+            parts[i] = new DeepScanLineInputPart (input, i);
+            comp.addSource (parts[i]);
+        }
+
+        if (r == 1) comp.setCompositing (&perPixelComp);
+
+        results[r].assign (names.size (), vector<float> (pixels));
+        for (size_t c = 0; c < names.size (); c++)
+        {
+            fb.insert (
+                names[c],
+                Slice (
+                    FLOAT,
+                    (char*) &results[r][c][0],
+                    sizeof (float),
+                    sizeof (float) * width));
+        }
+
+        comp.setFrameBuffer (fb);
+        comp.readPixels (0, height - 1);
+
+        for (int i = 0; i < number_of_parts; i++)
+            delete parts[i];
+    }
+
+    for (size_t c = 0; c < names.size (); c++)
+    {
+        for (int p = 0; p < pixels; p++)
+        {
+            float a = results[0][c][p];
+            float b = results[1][c][p];
+            assert (std::fabs (a - b) <= 1e-5f * std::max (1.0f, std::fabs (b)));
+        }
+    }
+
+    remove (fn.c_str ());
+}
+
 } // namespace
 
 void
@@ -652,6 +820,15 @@ testCompositeDeepScanLine (const std::string& tempDir)
 
     random_reseed (1);
 
+    cout << "Testing span compositing against per pixel compositing\n"
+         << endl;
+
+    for (int channels = 3; channels <= 10; channels++)
+    {
+        test_composite_span (false, channels, tempDir);
+        test_composite_span (true, channels, tempDir);
+    }
+
     for (int pass = 0; pass < 2; pass++)
     {
 
@@ -0,0 +1,480 @@
+//
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) Contributors to the OpenEXR Project.
+//
+
+#ifdef NDEBUG
+#    undef NDEBUG
+#endif
+
+#include "testCompositeDeepTile.h"
+#include "random.h"
+
+#include <Iex.h>
+#include <IlmThread.h>
+#include <ImfChannelList.h>
+#include <ImfCompositeDeepTile.h>
+#include <ImfDeepCompositing.h>
+#include <ImfDeepFrameBuffer.h>
+#include <ImfDeepTiledInputFile.h>
+#include <ImfDeepTiledInputPart.h>
+#include <ImfDeepTiledOutputFile.h>
+#include <ImfFrameBuffer.h>
+#include <ImfHeader.h>
+#include <ImfMultiPartInputFile.h>
+#include <ImfPartType.h>
+#include <ImfThreading.h>
+
+#include <assert.h>
+#include <cmath>
+#include <iostream>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+using namespace OPENEXR_IMF_NAMESPACE;
+using namespace std;
+using namespace IMATH_NAMESPACE;
+
+namespace
+{
+
+const int W = 71;
+const int H = 45;
+
+const char* channelNames[] = {"Z", "A", "R"};
+
+//
+// the deep samples of one level of one source
+//
+
+struct Level
+{
+    Box2i                 dw;
+    vector<unsigned int>  counts;
+    vector<size_t>        offsets;
+    vector<vector<float>> samples; // Z, A, R
+
+    size_t index (int x, int y) const
+    {
+        return size_t (y - dw.min.y) * size_t (dw.max.x - dw.min.x + 1) +
+               size_t (x - dw.min.x);
+    }
+};
+
+Level
+makeLevel (const Box2i& dw)
+{
+    Level l;
+    l.dw = dw;
+
+    size_t pixels = size_t (dw.max.x - dw.min.x + 1) *
+                    size_t (dw.max.y - dw.min.y + 1);
+    size_t total  = 0;
+
+    l.counts.resize (pixels);
+    l.offsets.resize (pixels);
+    for (size_t p = 0; p < pixels; p++)
+    {
+        l.counts[p]  = random_int (5);
+        l.offsets[p] = total;
+        total += l.counts[p];
+    }
+
+    //
+    // the samples of a pixel are stored front to back, as the
+    // compositor expects of a single source
+    //
+
+    l.samples.assign (3, vector<float> (total));
+    for (size_t p = 0; p < pixels; p++)
+    {
+        float z = 0.f;
+        for (size_t i = l.offsets[p]; i < l.offsets[p] + l.counts[p]; i++)
+        {
+            z += float (1 + random_int (8)) * 0.5f;
+            l.samples[0][i] = z;
+            l.samples[1][i] = random_float (1.0f);
+            l.samples[2][i] = random_float (4.0f);
+        }
+    }
+    return l;
+}
+
+//
+// writes a deep tiled file with one or all mipmap levels, returning
+// the samples written to each level
+//
+
+vector<Level>
+writeFile (const string& fileName, LevelMode mode, bool withAlpha = true)
+{
+    Header hdr (Box2i (V2i (0, 0), V2i (W - 1, H - 1)),
+                Box2i (V2i (-3, 2), V2i (W - 4, H + 1)));
+    hdr.compression () = RLE_COMPRESSION;
+    hdr.setType (DEEPTILE);
+    hdr.setTileDescription (TileDescription (16, 8, mode));
+    for (int c = 0; c < 3; c++)
+    {
+        if (c == 1 && !withAlpha) continue;
+        hdr.channels ().insert (channelNames[c], Channel (FLOAT));
+    }
+
+    DeepTiledOutputFile out (fileName.c_str (), hdr);
+    vector<Level>       levels;
+
+    for (int l = 0; l < out.numLevels (); l++)
+    {
+        levels.push_back (makeLevel (out.dataWindowForLevel (l)));
+
+        Level&    lev   = levels.back ();
+        ptrdiff_t width = lev.dw.max.x - lev.dw.min.x + 1;
+        ptrdiff_t org   = lev.dw.min.x + lev.dw.min.y * width;
+
+        vector<vector<float*>> pointers (3);
+        DeepFrameBuffer        fb;
+        fb.insertSampleCountSlice (Slice (
+            UINT,
+            (char*) (lev.counts.data () - org),
+            sizeof (unsigned int),
+            sizeof (unsigned int) * width));
+
+        for (int c = 0; c < 3; c++)
+        {
+            if (c == 1 && !withAlpha) continue;
+
+            pointers[c].resize (lev.counts.size ());
+            for (size_t p = 0; p < lev.counts.size (); p++)
+                pointers[c][p] = lev.samples[c].data () + lev.offsets[p];
+
+            fb.insert (
+                channelNames[c],
+                DeepSlice (
+                    FLOAT,
+                    (char*) (pointers[c].data () - org),
+                    sizeof (float*),
+                    sizeof (float*) * width,
+                    sizeof (float)));
+        }
+
+        out.setFrameBuffer (fb);
+        out.writeTiles (
+            0, out.numXTiles (l) - 1, 0, out.numYTiles (l) - 1, l);
+    }
+
+    return levels;
+}
+
+//
+// composites one pixel of the sources by hand
+//
+
+void
+reference (const vector<const Level*>& sources, int x, int y, float out[3])
+{
+    vector<vector<float>> samples (3);
+    int                   n       = 0;
+    int                   nonzero = 0;
+
+    for (const Level* l: sources)
+    {
+        size_t p = l->index (x, y);
+        for (unsigned int i = 0; i < l->counts[p]; i++)
+            for (int c = 0; c < 3; c++)
+                samples[c].push_back (l->samples[c][l->offsets[p] + i]);
+        n += l->counts[p];
+        if (l->counts[p] > 0) nonzero++;
+    }
+
+    float        zero    = 0.f;
+    const float* in[4]   = {&zero, &zero, &zero, &zero};
+    const char*  names[] = {"Z", "Z", "A", "R"};
+    float        result[4];
+
+    if (n > 0)
+    {
+        in[0] = in[1] = samples[0].data ();
+        in[2]         = samples[1].data ();
+        in[3]         = samples[2].data ();
+    }
+
+    DeepCompositing comp;
+    comp.composite_pixel (result, in, names, 4, n, nonzero);
+    out[0] = result[0];
+    out[1] = result[2];
+    out[2] = result[3];
+}
+
+bool
+close (float a, float b, float tol)
+{
+    return std::fabs (a - b) <= tol * std::max (1.0f, std::fabs (b));
+}
+
+//
+// flat output, one image per channel in the coordinates of a level;
+// A is half to check the conversion
+//
+
+struct Output
+{
+    Box2i         dw;
+    vector<float> z, r;
+    vector<half>  a;
+
+    explicit Output (const Box2i& box) : dw (box)
+    {
+        size_t n = size_t (dw.max.x - dw.min.x + 1) *
+                   size_t (dw.max.y - dw.min.y + 1);
+        z.assign (n, -1.f);
+        r.assign (n, -1.f);
+        a.assign (n, half (-1.f));
+    }
+
+    FrameBuffer frameBuffer ()
+    {
+        ptrdiff_t   width = dw.max.x - dw.min.x + 1;
+        ptrdiff_t   org   = dw.min.x + dw.min.y * width;
+        FrameBuffer fb;
+        fb.insert (
+            "Z",
+            Slice (
+                FLOAT,
+                (char*) (z.data () - org),
+                sizeof (float),
+                sizeof (float) * width));
+        fb.insert (
+            "A",
+            Slice (
+                HALF,
+                (char*) (a.data () - org),
+                sizeof (half),
+                sizeof (half) * width));
+        fb.insert (
+            "R",
+            Slice (
+                FLOAT,
+                (char*) (r.data () - org),
+                sizeof (float),
+                sizeof (float) * width));
+        return fb;
+    }
+
+    void check (
+        const vector<const Level*>& sources, const Box2i& box, bool written)
+        const
+    {
+        ptrdiff_t width = dw.max.x - dw.min.x + 1;
+
+        for (int y = box.min.y; y <= box.max.y; y++)
+        {
+            for (int x = box.min.x; x <= box.max.x; x++)
+            {
+                size_t p = size_t (y - dw.min.y) * width + (x - dw.min.x);
+                if (!written)
+                {
+                    assert (z[p] == -1.f && r[p] == -1.f && a[p] == -1.f);
+                    continue;
+                }
+
+                float expected[3];
+                reference (sources, x, y, expected);
+                assert (close (z[p], expected[0], 1e-5f));
+                assert (close (float (a[p]), expected[1], 1e-3f));
+                assert (close (r[p], expected[2], 1e-5f));
+            }
+        }
+    }
+};
+
+void
+testTiles (const string& tempDir)
+{
+    string fn1 = tempDir + "imf_test_composite_tile_1.exr";
+    string fn2 = tempDir + "imf_test_composite_tile_2.exr";
+
+    vector<Level> l1 = writeFile (fn1, MIPMAP_LEVELS);
+    vector<Level> l2 = writeFile (fn2, MIPMAP_LEVELS);
+
+    DeepTiledInputFile  in1 (fn1.c_str ());
+    MultiPartInputFile  mp (fn2.c_str ());
+    DeepTiledInputPart  in2 (mp, 0);
+    CompositeDeepTile   comp;
+
+    comp.addSource (&in1);
+    comp.addSource (&in2);
+    assert (comp.sources () == 2);
+    assert (comp.dataWindow () == in1.header ().dataWindow ());
+    assert (comp.numXTiles (0) == in1.numXTiles (0));
+
+    for (int l = 0; l < in1.numLevels (); l++)
+    {
+        vector<const Level*> sources = {&l1[l], &l2[l]};
+        Output               out (comp.dataWindowForLevel (l, l));
+
+        comp.setFrameBuffer (out.frameBuffer ());
+        comp.readTiles (0, comp.numXTiles (l) - 1, 0, comp.numYTiles (l) - 1, l);
+        out.check (sources, out.dw, true);
+    }
+
+    //
+    // a single tile only writes its own pixels
+    //
+
+    {
+        vector<const Level*> sources = {&l1[0], &l2[0]};
+        Output               out (comp.dataWindow ());
+
+        comp.setFrameBuffer (out.frameBuffer ());
+        comp.readTile (2, 3);
+
+        Box2i tile = in1.dataWindowForTile (2, 3, 0);
+        out.check (sources, tile, true);
+
+        Box2i before (out.dw.min, V2i (out.dw.max.x, tile.min.y - 1));
+        Box2i after (V2i (out.dw.min.x, tile.max.y + 1), out.dw.max);
+        out.check (sources, before, false);
+        out.check (sources, after, false);
+    }
+
+    bool caught = false;
+    try
+    {
+        comp.readTiles (0, comp.numXTiles (0), 0, 0);
+    }
+    catch (const IEX_NAMESPACE::ArgExc&)
+    {
+        caught = true;
+    }
+    assert (caught);
+
+    remove (fn1.c_str ());
+    remove (fn2.c_str ());
+}
+
+void
+testScanLines (const string& tempDir)
+{
+    string fn1 = tempDir + "imf_test_composite_tile_1.exr";
+    string fn2 = tempDir + "imf_test_composite_tile_2.exr";
+    string fn3 = tempDir + "imf_test_composite_tile_3.exr";
+
+    vector<Level> l1 = writeFile (fn1, ONE_LEVEL);
+    vector<Level> l2 = writeFile (fn2, ONE_LEVEL);
+    vector<Level> l3 = writeFile (fn3, ONE_LEVEL);
+
+    DeepTiledInputFile in1 (fn1.c_str ());
+    DeepTiledInputFile in2 (fn2.c_str ());
+    DeepTiledInputFile in3 (fn3.c_str ());
+    CompositeDeepTile  comp;
+
+    comp.addSource (&in1);
+    comp.addSource (&in2);
+    comp.addSource (&in3);
+
+    vector<const Level*> sources = {&l1[0], &l2[0], &l3[0]};
+    Output               out (comp.dataWindow ());
+    const Box2i&         dw = out.dw;
+
+    comp.setFrameBuffer (out.frameBuffer ());
+
+    // lines that start and end part way through a row of tiles
+    int y1 = dw.min.y + 5;
+    int y2 = dw.min.y + 29;
+    comp.readPixels (y1, y2);
+
+    out.check (sources, Box2i (V2i (dw.min.x, y1), V2i (dw.max.x, y2)), true);
+    out.check (
+        sources, Box2i (dw.min, V2i (dw.max.x, y1 - 1)), false);
+    out.check (
+        sources, Box2i (V2i (dw.min.x, y2 + 1), dw.max), false);
+
+    comp.readPixels (dw.max.y, dw.min.y);
+    out.check (sources, dw, true);
+
+    remove (fn1.c_str ());
+    remove (fn2.c_str ());
+    remove (fn3.c_str ());
+}
+
+void
+testMismatch (const string& tempDir)
+{
+    string fn1 = tempDir + "imf_test_composite_tile_1.exr";
+    string fn2 = tempDir + "imf_test_composite_tile_2.exr";
+
+    writeFile (fn1, ONE_LEVEL);
+    writeFile (fn2, MIPMAP_LEVELS);
+
+    DeepTiledInputFile in1 (fn1.c_str ());
+    DeepTiledInputFile in2 (fn2.c_str ());
+    CompositeDeepTile  comp;
+    comp.addSource (&in1);
+
+    bool caught = false;
+    try
+    {
+        comp.addSource (&in2);
+    }
+    catch (const IEX_NAMESPACE::ArgExc&)
+    {
+        caught = true;
+    }
+    assert (caught);
+    assert (comp.sources () == 1);
+
+    string fn3 = tempDir + "imf_test_composite_tile_3.exr";
+    writeFile (fn3, ONE_LEVEL, false);
+    DeepTiledInputFile noAlpha (fn3.c_str ());
+
+    caught = false;
+    try
+    {
+        comp.addSource (&noAlpha);
+    }
+    catch (const IEX_NAMESPACE::ArgExc&)
+    {
+        caught = true;
+    }
+    assert (caught);
+
+    remove (fn1.c_str ());
+    remove (fn2.c_str ());
+    remove (fn3.c_str ());
+}
+
+} // namespace
+
+void
+testCompositeDeepTile (const std::string& tempDir)
+{
+    try
+    {
+        cout << "Testing deep tiled compositing" << endl;
+
+        random_reseed (7);
+
+        int maxThreads = ILMTHREAD_NAMESPACE::supportsThreads () ? 3 : 0;
+
+        for (int n = 0; n <= maxThreads; n += 3)
+        {
+            if (ILMTHREAD_NAMESPACE::supportsThreads ())
+            {
+                setGlobalThreadCount (n);
+                cout << "number of threads: " << globalThreadCount () << endl;
+            }
+
+            testTiles (tempDir);
+            testScanLines (tempDir);
+        }
+
+        testMismatch (tempDir);
+
+        cout << "ok\n" << endl;
+    }
+    catch (const std::exception& e)
+    {
+        cerr << "ERROR -- caught exception: " << e.what () << endl;
+        assert (false);
+    }
+}
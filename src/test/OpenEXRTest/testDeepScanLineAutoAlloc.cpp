@@ -0,0 +1,378 @@
+//
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) Contributors to the OpenEXR Project.
+//
+
+#ifdef NDEBUG
+#    undef NDEBUG
+#endif
+
+#include "testDeepScanLineAutoAlloc.h"
+
+#include <Iex.h>
+#include <IlmThread.h>
+#include <ImfChannelList.h>
+#include <ImfDeepFrameBuffer.h>
+#include <ImfDeepSampleAllocator.h>
+#include <ImfDeepScanLineInputFile.h>
+#include <ImfDeepScanLineInputPart.h>
+#include <ImfDeepScanLineOutputFile.h>
+#include <ImfHeader.h>
+#include <ImfMultiPartInputFile.h>
+#include <ImfPartType.h>
+#include <ImfThreading.h>
+
+#include <algorithm>
+#include <assert.h>
+#include <atomic>
+#include <iostream>
+#include <mutex>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+using namespace OPENEXR_IMF_NAMESPACE;
+using namespace std;
+using namespace IMATH_NAMESPACE;
+
+namespace
+{
+
+const int W = 37;
+const int H = 53;
+
+//
+// sample s of pixel (x,y) of channel c
+//
+
+float
+sampleValue (int c, int x, int y, int s)
+{
+    return float ((x * 5 + y * 11 + s * 3 + c * 17) % 2048);
+}
+
+unsigned int
+sampleCount (int x, int y)
+{
+    return (x * 7 + y * 3) % 5;
+}
+
+void
+writeFile (const string& fileName, Compression comp)
+{
+    Header hdr (Box2i (V2i (0, 0), V2i (W - 1, H - 1)),
+                Box2i (V2i (2, -4), V2i (W + 1, H - 5)));
+    hdr.compression () = comp;
+    hdr.setType (DEEPSCANLINE);
+    hdr.channels ().insert ("Z", Channel (FLOAT));
+    hdr.channels ().insert ("A", Channel (HALF));
+    hdr.channels ().insert ("id", Channel (UINT));
+
+    const Box2i& dw = hdr.dataWindow ();
+
+    vector<unsigned int>     counts (W * H);
+    vector<vector<float>>    z (W * H);
+    vector<vector<half>>     a (W * H);
+    vector<vector<unsigned>> id (W * H);
+    vector<float*>           zp (W * H);
+    vector<half*>            ap (W * H);
+    vector<unsigned*>        idp (W * H);
+
+    for (int y = 0; y < H; ++y)
+    {
+        for (int x = 0; x < W; ++x)
+        {
+            int p     = y * W + x;
+            int ax    = x + dw.min.x;
+            int ay    = y + dw.min.y;
+            counts[p] = sampleCount (ax, ay);
+            for (unsigned int s = 0; s < counts[p]; ++s)
+            {
+                z[p].push_back (sampleValue (0, ax, ay, s));
+                a[p].push_back (half (sampleValue (1, ax, ay, s)));
+                id[p].push_back ((unsigned) sampleValue (2, ax, ay, s));
+            }
+            zp[p]  = z[p].data ();
+            ap[p]  = a[p].data ();
+            idp[p] = id[p].data ();
+        }
+    }
+
+    ptrdiff_t       org = dw.min.x + dw.min.y * W;
+    DeepFrameBuffer fb;
+    fb.insertSampleCountSlice (Slice (
+        UINT,
+        (char*) (counts.data () - org),
+        sizeof (unsigned int),
+        sizeof (unsigned int) * W));
+    fb.insert (
+        "Z",
+        DeepSlice (
+            FLOAT,
+            (char*) (zp.data () - org),
+            sizeof (float*),
+            sizeof (float*) * W,
+            sizeof (float)));
+    fb.insert (
+        "A",
+        DeepSlice (
+            HALF,
+            (char*) (ap.data () - org),
+            sizeof (half*),
+            sizeof (half*) * W,
+            sizeof (half)));
+    fb.insert (
+        "id",
+        DeepSlice (
+            UINT,
+            (char*) (idp.data () - org),
+            sizeof (unsigned*),
+            sizeof (unsigned*) * W,
+            sizeof (unsigned)));
+
+    DeepScanLineOutputFile out (fileName.c_str (), hdr);
+    out.setFrameBuffer (fb);
+    out.writePixels (H);
+}
+
+//
+// destination for a single-pass read: counts and per-pixel pointers
+// only, with "fill" not in the file
+//
+
+struct Pixels
+{
+    Box2i                dw;
+    vector<unsigned int> counts;
+    vector<float*>       z;
+    vector<half*>        a;
+    vector<unsigned*>    id;
+    vector<float*>       fill;
+
+    explicit Pixels (const Box2i& box)
+        : dw (box)
+        , counts (W * H, 999)
+        , z (W * H, nullptr)
+        , a (W * H, nullptr)
+        , id (W * H, nullptr)
+        , fill (W * H, nullptr)
+    {}
+
+    DeepFrameBuffer frameBuffer ()
+    {
+        ptrdiff_t       org = dw.min.x + dw.min.y * W;
+        DeepFrameBuffer fb;
+        fb.insertSampleCountSlice (Slice (
+            UINT,
+            (char*) (counts.data () - org),
+            sizeof (unsigned int),
+            sizeof (unsigned int) * W));
+        fb.insert (
+            "Z",
+            DeepSlice (
+                FLOAT,
+                (char*) (z.data () - org),
+                sizeof (float*),
+                sizeof (float*) * W,
+                sizeof (float)));
+        fb.insert (
+            "A",
+            DeepSlice (
+                HALF,
+                (char*) (a.data () - org),
+                sizeof (half*),
+                sizeof (half*) * W,
+                sizeof (half)));
+        fb.insert (
+            "id",
+            DeepSlice (
+                UINT,
+                (char*) (id.data () - org),
+                sizeof (unsigned*),
+                sizeof (unsigned*) * W,
+                sizeof (unsigned)));
+        fb.insert (
+            "fill",
+            DeepSlice (
+                FLOAT,
+                (char*) (fill.data () - org),
+                sizeof (float*),
+                sizeof (float*) * W,
+                sizeof (float),
+                1,
+                1,
+                0.25));
+        return fb;
+    }
+
+    void check (int y1, int y2) const
+    {
+        for (int y = dw.min.y; y <= dw.max.y; ++y)
+        {
+            for (int x = dw.min.x; x <= dw.max.x; ++x)
+            {
+                size_t p = size_t (y - dw.min.y) * W + (x - dw.min.x);
+
+                if (y < y1 || y > y2)
+                {
+                    assert (counts[p] == 999 && z[p] == nullptr);
+                    continue;
+                }
+
+                assert (counts[p] == sampleCount (x, y));
+                for (unsigned int s = 0; s < counts[p]; ++s)
+                {
+                    assert (z[p][s] == sampleValue (0, x, y, s));
+                    assert (a[p][s] == half (sampleValue (1, x, y, s)));
+                    assert (id[p][s] == (unsigned) sampleValue (2, x, y, s));
+                    assert (fill[p][s] == 0.25f);
+                }
+            }
+        }
+    }
+};
+
+class CountingAllocator : public DeepSampleAllocator
+{
+public:
+    std::atomic<int> calls{0};
+    DeepSampleArena  arena;
+    int              minY = H;
+    int              maxY = -H;
+    std::mutex       mx;
+
+    void* allocate (size_t bytes, int y1, int y2) override
+    {
+        assert (bytes > 0);
+        {
+            std::lock_guard<std::mutex> lk (mx);
+            minY = std::min (minY, y1);
+            maxY = std::max (maxY, y2);
+        }
+        ++calls;
+        return arena.allocate (bytes, y1, y2);
+    }
+};
+
+class FailingAllocator : public DeepSampleAllocator
+{
+public:
+    void* allocate (size_t, int, int) override
+    {
+        throw IEX_NAMESPACE::ArgExc ("out of sample memory");
+    }
+};
+
+void
+testFile (const string& tempDir, Compression comp)
+{
+    string fn = tempDir + "imf_test_deep_autoalloc.exr";
+    writeFile (fn, comp);
+
+    //
+    // the internal arena
+    //
+
+    {
+        DeepScanLineInputFile in (fn.c_str ());
+        const Box2i&          dw = in.header ().dataWindow ();
+
+        Pixels px (dw);
+        in.setFrameBuffer (px.frameBuffer ());
+        in.readPixelsAutoAlloc (dw.min.y, dw.max.y);
+        px.check (dw.min.y, dw.max.y);
+
+        // a range of lines, given in reverse
+        Pixels part (dw);
+        in.setFrameBuffer (part.frameBuffer ());
+        in.readPixelsAutoAlloc (dw.min.y + 20, dw.min.y + 3);
+        part.check (dw.min.y + 3, dw.min.y + 20);
+
+        // a single line, after a regular read
+        in.readPixelSampleCounts (dw.min.y + 7);
+        in.readPixelsAutoAlloc (dw.min.y + 7, dw.min.y + 7);
+        part.check (dw.min.y + 3, dw.min.y + 20);
+
+        in.releaseAutoAllocData ();
+    }
+
+    //
+    // a user allocator, through a part
+    //
+
+    {
+        MultiPartInputFile    mp (fn.c_str ());
+        DeepScanLineInputPart in (mp, 0);
+        const Box2i&          dw = in.header ().dataWindow ();
+        CountingAllocator     alloc;
+
+        Pixels px (dw);
+        in.setFrameBuffer (px.frameBuffer ());
+        in.readPixelsAutoAlloc (dw.min.y, dw.max.y, &alloc);
+        px.check (dw.min.y, dw.max.y);
+
+        int chunks = 0;
+        for (int y = dw.min.y; y <= dw.max.y;
+             y  = in.lastScanLineInChunk (y) + 1)
+            ++chunks;
+
+        // every chunk of this image has samples
+        assert (alloc.calls == chunks);
+        assert (alloc.minY == dw.min.y && alloc.maxY == dw.max.y);
+        assert (alloc.arena.bytesAllocated () > 0);
+
+        FailingAllocator failing;
+        bool             caught = false;
+        try
+        {
+            in.readPixelsAutoAlloc (dw.min.y, dw.max.y, &failing);
+        }
+        catch (const IEX_NAMESPACE::ArgExc& e)
+        {
+            caught = string (e.what ()).find ("out of sample memory") !=
+                     string::npos;
+        }
+        catch (const IEX_NAMESPACE::IoExc& e)
+        {
+            // rethrown from a worker thread
+            caught = string (e.what ()).find ("out of sample memory") !=
+                     string::npos;
+        }
+        assert (caught);
+    }
+
+    remove (fn.c_str ());
+}
+
+} // namespace
+
+void
+testDeepScanLineAutoAlloc (const std::string& tempDir)
+{
+    try
+    {
+        cout << "Testing single-pass deep scan line reads" << endl;
+
+        int maxThreads = ILMTHREAD_NAMESPACE::supportsThreads () ? 3 : 0;
+
+        for (int n = 0; n <= maxThreads; n += 3)
+        {
+            if (ILMTHREAD_NAMESPACE::supportsThreads ())
+            {
+                setGlobalThreadCount (n);
+                cout << "number of threads: " << globalThreadCount () << endl;
+            }
+
+            testFile (tempDir, NO_COMPRESSION);
+            testFile (tempDir, RLE_COMPRESSION);
+            testFile (tempDir, ZIPS_COMPRESSION);
+        }
+
+        cout << "ok\n" << endl;
+    }
+    catch (const std::exception& e)
+    {
+        cerr << "ERROR -- caught exception: " << e.what () << endl;
+        assert (false);
+    }
+}
@@ -271,6 +271,33 @@ readFile (
     int width  = dataWindow.max.x - dataWindow.min.x + 1;
     int height = dataWindow.max.y - dataWindow.min.y + 1;
 
+    //
+    // Read the sample counts without a frame buffer, for all lines
+    // and for the lines after the first third, given in reverse order.
+    //
+
+    for (int pass = 0; pass < 2; pass++)
+    {
+        int                  first = pass * (height / 3);
+        int                  lines = height - first;
+        vector<unsigned int> counts (size_t (width) * lines);
+        uint64_t             total = 0;
+
+        file.sampleCounts (
+            dataWindow.max.y, dataWindow.min.y + first, counts.data ());
+
+        for (int i = 0; i < lines; i++)
+            for (int j = 0; j < width; j++)
+            {
+                assert (counts[i * width + j] == sampleCount[first + i][j]);
+                total += sampleCount[first + i][j];
+            }
+
+        assert (
+            file.totalSampleCount (
+                dataWindow.min.y + first, dataWindow.max.y) == total);
+    }
+
     Array2D<unsigned int> localSampleCount;
     localSampleCount.resizeErase (height, width);
 
@@ -22,6 +22,7 @@
 #include <ImfDeepFrameBuffer.h>
 #include <ImfHeader.h>
 #include <ImfPartType.h>
+#include <openexr.h>
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -572,6 +573,47 @@ readFile (
                 // Testing bulk read (without relative coordinates).
                 //
 
+                //
+                // Read the sample counts without a frame buffer, for the
+                // whole level and for the tiles after the first row and
+                // column, given in reverse order.
+                //
+
+                for (int t = 0; t < 2; t++)
+                {
+                    int dx2 = file.numXTiles (lx) - 1;
+                    int dy2 = file.numYTiles (ly) - 1;
+                    int dx1 = (t < dx2) ? t : dx2;
+                    int dy1 = (t < dy2) ? t : dy2;
+
+                    Box2i b1 = file.dataWindowForTile (dx1, dy1, lx, ly);
+                    Box2i b2 = file.dataWindowForTile (dx2, dy2, lx, ly);
+                    int   w  = b2.max.x - b1.min.x + 1;
+
+                    vector<unsigned int> counts (
+                        size_t (w) * size_t (b2.max.y - b1.min.y + 1));
+                    uint64_t total = 0;
+
+                    file.sampleCounts (
+                        dx2, dx1, dy2, dy1, lx, ly, counts.data ());
+
+                    for (int y = b1.min.y; y <= b2.max.y; y++)
+                        for (int x = b1.min.x; x <= b2.max.x; x++)
+                        {
+                            unsigned int n =
+                                sampleCountWhole[ly][lx][y - dataWindowL.min.y]
+                                                [x - dataWindowL.min.x];
+                            assert (
+                                counts[(y - b1.min.y) * w + (x - b1.min.x)] ==
+                                n);
+                            total += n;
+                        }
+
+                    assert (
+                        file.totalSampleCount (dx1, dx2, dy1, dy2, lx, ly) ==
+                        total);
+                }
+
                 file.readPixelSampleCounts (
                     0,
                     file.numXTiles (lx) - 1,
@@ -899,6 +941,121 @@ readWriteTestWithAbsoluateCoordinates (
     }
 }
 
+//
+// Tiles on the right and bottom edges have smaller sample count tables
+// than a full tile.  The table stored for a tile must never be larger
+// than the tile's own raw table, and must read back unchanged.
+//
+
+void
+edgeTileSampleCountTest (const std::string& tempDir)
+{
+    cout << "Testing sample count tables of edge tiles" << endl << flush;
+
+    std::string fn = tempDir + "imf_test_deep_tiled_edge.exr";
+
+    const Compression compressions[] = {
+        NO_COMPRESSION, RLE_COMPRESSION, ZIPS_COMPRESSION};
+    const int         tileSize       = 8;
+    vector<float>     samples (16, 0.5f);
+
+    for (Compression compression: compressions)
+    {
+        for (int ex = 1; ex <= 4; ex++)
+        {
+            for (int ey = 1; ey <= 4; ey++)
+            {
+                int   w = tileSize + ex;
+                int   h = tileSize + ey;
+                Box2i dw (V2i (0, 0), V2i (w - 1, h - 1));
+
+                Header hdr (
+                    dw,
+                    dw,
+                    1,
+                    IMATH_NAMESPACE::V2f (0, 0),
+                    1,
+                    INCREASING_Y,
+                    compression);
+                hdr.channels ().insert ("Z", Channel (IMF::FLOAT));
+                hdr.setType (DEEPTILE);
+                hdr.setTileDescription (
+                    TileDescription (tileSize, tileSize, ONE_LEVEL));
+
+                Array2D<unsigned int> counts (h, w);
+                Array2D<float*>       data (h, w);
+                for (int y = 0; y < h; y++)
+                    for (int x = 0; x < w; x++)
+                    {
+                        counts[y][x] = random_int (16);
+                        data[y][x]   = samples.data ();
+                    }
+
+                {
+                    DeepTiledOutputFile file (fn.c_str (), hdr);
+                    DeepFrameBuffer     frameBuffer;
+
+                    frameBuffer.insertSampleCountSlice (Slice (
+                        IMF::UINT,
+                        (char*) &counts[0][0],
+                        sizeof (unsigned int),
+                        sizeof (unsigned int) * w));
+                    frameBuffer.insert (
+                        "Z",
+                        DeepSlice (
+                            IMF::FLOAT,
+                            (char*) &data[0][0],
+                            sizeof (float*),
+                            sizeof (float*) * w,
+                            sizeof (float)));
+
+                    file.setFrameBuffer (frameBuffer);
+                    file.writeTiles (
+                        0, file.numXTiles () - 1, 0, file.numYTiles () - 1);
+                }
+
+                DeepTiledInputFile   file (fn.c_str ());
+                vector<unsigned int> back (size_t (w) * h);
+
+                file.sampleCounts (
+                    0,
+                    file.numXTiles () - 1,
+                    0,
+                    file.numYTiles () - 1,
+                    0,
+                    back.data ());
+
+                for (int y = 0; y < h; y++)
+                    for (int x = 0; x < w; x++)
+                        assert (back[y * w + x] == counts[y][x]);
+
+                exr_context_t f;
+                assert (
+                    exr_start_read (&f, fn.c_str (), nullptr) ==
+                    EXR_ERR_SUCCESS);
+                for (int ty = 0; ty < file.numYTiles (); ty++)
+                    for (int tx = 0; tx < file.numXTiles (); tx++)
+                    {
+                        exr_chunk_info_t cinfo;
+                        assert (
+                            exr_read_tile_chunk_info (
+                                f, 0, tx, ty, 0, 0, &cinfo) ==
+                            EXR_ERR_SUCCESS);
+
+                        uint64_t raw = uint64_t (cinfo.width) * cinfo.height *
+                                       sizeof (int32_t);
+                        assert (cinfo.sample_count_table_size <= raw);
+                        if (compression == NO_COMPRESSION)
+                            assert (cinfo.sample_count_table_size == raw);
+                    }
+                exr_finish (&f);
+
+                remove (fn.c_str ());
+            }
+        }
+    }
+}
+
 } // namespace
 
 void
@@ -921,6 +1078,8 @@ testDeepTiledBasic (const std::string& tempDir)
         }
         ThreadPool::globalThreadPool ().setNumThreads (numThreads);
 
+        edgeTileSampleCountTest (tempDir);
+
         cout << "ok\n" << endl;
     }
     catch (const std::exception& e)
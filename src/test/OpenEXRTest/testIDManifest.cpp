@@ -7,6 +7,7 @@
 #include <stdlib.h>
 
 #include "random.h"
+#include <IlmThread.h>
 #include <ImfChannelList.h>
 #include <ImfFrameBuffer.h>
 #include <ImfHeader.h>
@@ -14,6 +15,7 @@
 #include <ImfInputFile.h>
 #include <ImfOutputFile.h>
 #include <ImfStandardAttributes.h>
+#include <ImfThreading.h>
 
 #include "tmpDir.h"
 #include <openexr_compression.h>
@@ -107,6 +109,122 @@ operator<< (std::ostream& out, const IDManifest& mfst)
     return out;
 }
 
+//
+// check that a FlatIDManifest has the same contents as an IDManifest
+//
+void
+compareFlatManifest (const FlatIDManifest& flat, const IDManifest& mfst)
+{
+    assert (flat.size () == mfst.size ());
+
+    for (size_t g = 0; g < mfst.size (); ++g)
+    {
+        const IDManifest::ChannelGroupManifest& m = mfst[g];
+        const FlatIDManifest::Group&            f = flat[g];
+
+        assert (f.getChannels () == m.getChannels ());
+        assert (f.getComponents () == m.getComponents ());
+        assert (f.getLifetime () == m.getLifetime ());
+        assert (f.getHashScheme () == m.getHashScheme ());
+        assert (f.getEncodingScheme () == m.getEncodingScheme ());
+        assert (f.size () == m.size ());
+
+        FlatIDManifest::Group::ConstIterator fi = f.begin ();
+        for (IDManifest::ChannelGroupManifest::ConstIterator mi = m.begin ();
+             mi != m.end ();
+             ++mi, ++fi)
+        {
+            assert (fi != f.end ());
+            assert (fi.id () == mi.id ());
+            assert (fi.text () == mi.text ());
+
+            FlatIDManifest::Group::ConstIterator found = f.find (mi.id ());
+            assert (found == fi);
+            for (size_t c = 0; c < mi.text ().size (); ++c)
+                assert (found.text (c) == mi.text ()[c]);
+
+            if (m.find (mi.id () + 1) == m.end ())
+                assert (f.find (mi.id () + 1) == f.end ());
+        }
+        assert (fi == f.end ());
+
+        for (const string& channel: m.getChannels ())
+            assert (flat.find (channel) == mfst.find (channel));
+    }
+
+    assert (flat.find ("no such channel") == flat.size ());
+}
+
+void
+checkFlatManifest (const IDManifest& mfst, const CompressedIDManifest& cmpd)
+{
+    vector<char> data;
+    mfst.serialize (data);
+
+    compareFlatManifest (FlatIDManifest (mfst), mfst);
+    compareFlatManifest (
+        FlatIDManifest (data.data (), data.data () + data.size ()), mfst);
+    compareFlatManifest (FlatIDManifest (cmpd), mfst);
+}
+
+//
+// check that a LazyIDManifest finds the same entries as an IDManifest
+//
+void
+compareLazyManifest (const LazyIDManifest& lazy, const IDManifest& mfst)
+{
+    assert (lazy.size () == mfst.size ());
+
+    for (size_t g = 0; g < mfst.size (); ++g)
+    {
+        const IDManifest::ChannelGroupManifest& m = mfst[g];
+        const LazyIDManifest::Group&            l = lazy[g];
+
+        assert (l.getChannels () == m.getChannels ());
+        assert (l.getComponents () == m.getComponents ());
+        assert (l.getLifetime () == m.getLifetime ());
+        assert (l.getHashScheme () == m.getHashScheme ());
+        assert (l.getEncodingScheme () == m.getEncodingScheme ());
+        assert (l.size () == m.size ());
+
+        vector<string> text;
+        for (IDManifest::ChannelGroupManifest::ConstIterator mi = m.begin ();
+             mi != m.end ();
+             ++mi)
+        {
+            assert (l.contains (mi.id ()));
+            assert (l.lookup (mi.id (), text));
+            assert (text == mi.text ());
+
+            if (m.find (mi.id () + 1) == m.end ())
+            {
+                assert (!l.contains (mi.id () + 1));
+                assert (!l.lookup (mi.id () + 1, text));
+                assert (text == mi.text ());
+            }
+        }
+
+        if (m.size () > 0 && m.begin ().id () > 0)
+            assert (!l.contains (m.begin ().id () - 1));
+
+        for (const string& channel: m.getChannels ())
+            assert (lazy.find (channel) == mfst.find (channel));
+    }
+
+    assert (lazy.find ("no such channel") == lazy.size ());
+}
+
+void
+checkLazyManifest (const IDManifest& mfst, const CompressedIDManifest& cmpd)
+{
+    vector<char> data;
+    mfst.serialize (data);
+
+    compareLazyManifest (
+        LazyIDManifest (data.data (), data.data () + data.size ()), mfst);
+    compareLazyManifest (LazyIDManifest (cmpd), mfst);
+}
+
 void
 doReadWriteManifest (const IDManifest& mfst, const string& fn, bool dump)
 {
@@ -156,6 +274,8 @@ doReadWriteManifest (const IDManifest& mfst, const string& fn, bool dump)
         cerr << "read manifest didn't match written manifest\n";
         assert (read == mfst);
     }
+    checkFlatManifest (mfst, cmpd);
+    checkLazyManifest (mfst, cmpd);
     remove (fn.c_str ());
 }
 
@@ -415,6 +535,133 @@ testLargeManifest (const string& tempDir)
     }
 }
 
+//
+// build flat manifests with several channel groups using
+// the thread pool
+//
+void
+testFlatManifest ()
+{
+    IDManifest mfst;
+
+    for (int g = 0; g < 6; ++g)
+    {
+        IDManifest::ChannelGroupManifest& m =
+            mfst.add ("id" + std::to_string (g));
+        m.setHashScheme (IDManifest::MURMURHASH3_32);
+        m.setComponent (g % 2 ? "material" : "object");
+
+        for (int e = 0; e < 5000 * (g + 1); ++e)
+            m.insert ("asset" + std::to_string (e % 977) + "/part" +
+                      std::to_string (e));
+    }
+
+    // a channel in two groups is found in the first one
+    mfst[4].getChannels ().insert ("id1");
+
+    CompressedIDManifest cmpd (mfst);
+
+    int oldThreadCount = globalThreadCount ();
+    int maxThreads = ILMTHREAD_NAMESPACE::supportsThreads () ? 4 : 0;
+
+    for (int n = 0; n <= maxThreads; n += 4)
+    {
+        setGlobalThreadCount (n);
+        checkFlatManifest (mfst, cmpd);
+    }
+
+    setGlobalThreadCount (oldThreadCount);
+
+    //
+    // the groups share their text: each distinct string is stored once
+    //
+    FlatIDManifest flat (mfst);
+    assert (flat.find ("id1") == 1);
+    assert (flat.numStrings () == 30000);
+    assert (&flat[5].find (flat[0].begin ().id ()).text (0) ==
+            &flat[0].begin ().text (0));
+}
+
+//
+// look up entries of a large manifest without decoding all of it
+//
+void
+testLazyManifest ()
+{
+    IDManifest mfst;
+
+    for (int g = 0; g < 3; ++g)
+    {
+        IDManifest::ChannelGroupManifest& m =
+            mfst.add ("id" + std::to_string (g));
+        m.setComponents ({"object", "material"});
+
+        // sparse ID numbers, so that most values between them are absent
+        for (int e = 0; e < 1000 * (g + 1) + 17; ++e)
+            m.insert (
+                uint64_t (e) * 7919 + g,
+                {"asset" + std::to_string (e % 311) + "/geo",
+                 "shader" + std::to_string (e)});
+    }
+
+    mfst.add ("empty");
+
+    CompressedIDManifest cmpd (mfst);
+    checkLazyManifest (mfst, cmpd);
+
+    LazyIDManifest lazy (cmpd);
+    assert (lazy.size () == 4);
+    assert (lazy[3].size () == 0);
+    assert (!lazy[3].contains (0));
+    assert (lazy.numStrings () == 311 + 3017);
+
+    vector<string> text;
+    assert (lazy[lazy.find ("id2")].lookup (2999 * 7919 + 2, text));
+    assert (text[0] == "asset200/geo" && text[1] == "shader2999");
+
+    // copies share the decoded manifest
+    LazyIDManifest copy = lazy;
+    lazy                = LazyIDManifest ();
+    assert (copy[1].lookup (64 * 7919 + 1, text));
+    assert (text[1] == "shader64");
+
+    //
+    // a truncated manifest is rejected when it is constructed
+    //
+    vector<char> data;
+    mfst.serialize (data);
+
+    bool caught = false;
+    try
+    {
+        LazyIDManifest bad (data.data (), data.data () + data.size () / 2);
+    }
+    catch (const IEX_NAMESPACE::InputExc&)
+    {
+        caught = true;
+    }
+    assert (caught);
+
+    //
+    // so is a string length larger than the manifest, before any memory
+    // is set aside for it: version 0, one string of 2^62 bytes
+    //
+    const char huge[] = {
+        0, 0, 0, 0, 1, 0, 0, 0, '\x80', '\x80', '\x80', '\x80',
+        '\x80', '\x80', '\x80', '\x80', '\x40', 'a'};
+
+    caught = false;
+    try
+    {
+        LazyIDManifest bad (huge, huge + sizeof (huge));
+    }
+    catch (const IEX_NAMESPACE::InputExc&)
+    {
+        caught = true;
+    }
+    assert (caught);
+}
+
 void
 testMerge ()
 {
@@ -573,6 +820,12 @@ testIDManifest (const std::string& tempDir)
     // stress test - will randomly generate 'edge cases'
     testLargeManifest (tempDir);
 
+    // read-optimized form of the manifest
+    testFlatManifest ();
+
+    // lazily decoded form of the manifest
+    testLazyManifest ();
+
     // test the API prevents creating invalid manifests
     testDoingBadThings ();
 }
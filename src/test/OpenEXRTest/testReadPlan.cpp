@@ -0,0 +1,319 @@
+//
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) Contributors to the OpenEXR Project.
+//
+
+#ifdef NDEBUG
+#    undef NDEBUG
+#endif
+
+#include "Iex.h"
+#include "IlmThread.h"
+#include "half.h"
+#include <ImfArray.h>
+#include <ImfChannelList.h>
+#include <ImfFrameBuffer.h>
+#include <ImfHeader.h>
+#include <ImfInputFile.h>
+#include <ImfOutputFile.h>
+#include <ImfReadPlan.h>
+#include <ImfThreading.h>
+#include <ImfTiledInputFile.h>
+#include <ImfTiledOutputFile.h>
+
+#include <algorithm>
+#include <assert.h>
+#include <iostream>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#include "testReadPlan.h"
+
+using namespace OPENEXR_IMF_NAMESPACE;
+using namespace std;
+using namespace IMATH_NAMESPACE;
+
+namespace
+{
+
+const int W = 119;
+const int H = 83;
+
+float
+pixelValue (int frame, int c, int x, int y)
+{
+    return float ((x * 3 + y * 5 + c * 7 + frame * 11) % 256);
+}
+
+Header
+makeHeader (Compression comp, bool tiled)
+{
+    Header hdr (W, H);
+    hdr.compression () = comp;
+    hdr.channels ().insert ("G", Channel (HALF));
+    hdr.channels ().insert ("R", Channel (HALF));
+    hdr.channels ().insert ("Z", Channel (FLOAT));
+    if (tiled) hdr.setTileDescription (TileDescription (32, 16, ONE_LEVEL));
+    return hdr;
+}
+
+void
+writeFrame (const string& fileName, int frame, const Header& hdr)
+{
+    Array2D<half>  g (H, W);
+    Array2D<half>  r (H, W);
+    Array2D<float> z (H, W);
+
+    for (int y = 0; y < H; ++y)
+    {
+        for (int x = 0; x < W; ++x)
+        {
+            g[y][x] = pixelValue (frame, 0, x, y);
+            r[y][x] = pixelValue (frame, 1, x, y);
+            z[y][x] = pixelValue (frame, 2, x, y);
+        }
+    }
+
+    FrameBuffer fb;
+    fb.insert (
+        "G", Slice (HALF, (char*) &g[0][0], sizeof (half), sizeof (half) * W));
+    fb.insert (
+        "R", Slice (HALF, (char*) &r[0][0], sizeof (half), sizeof (half) * W));
+    fb.insert (
+        "Z",
+        Slice (FLOAT, (char*) &z[0][0], sizeof (float), sizeof (float) * W));
+
+    if (hdr.hasTileDescription ())
+    {
+        TiledOutputFile out (fileName.c_str (), hdr);
+        out.setFrameBuffer (fb);
+        out.writeTiles (0, out.numXTiles () - 1, 0, out.numYTiles () - 1);
+    }
+    else
+    {
+        OutputFile out (fileName.c_str (), hdr);
+        out.setFrameBuffer (fb);
+        out.writePixels (H);
+    }
+}
+
+//
+// interleaved RGBA float output, with alpha not present in the
+// files and so filled from the slice's fill value
+//
+struct Pixels
+{
+    vector<float> rgba;
+
+    Pixels () : rgba (size_t (W) * size_t (H) * 4, -1.f) {}
+
+    FrameBuffer frameBuffer ()
+    {
+        FrameBuffer fb;
+        char*       base = (char*) rgba.data ();
+        size_t      xs   = 4 * sizeof (float);
+        size_t      ys   = xs * W;
+
+        fb.insert ("R", Slice (FLOAT, base, xs, ys));
+        fb.insert ("G", Slice (FLOAT, base + sizeof (float), xs, ys));
+        fb.insert ("Z", Slice (FLOAT, base + 2 * sizeof (float), xs, ys));
+        fb.insert (
+            "A", Slice (FLOAT, base + 3 * sizeof (float), xs, ys, 1, 1, 1.0));
+        return fb;
+    }
+
+    void clear () { std::fill (rgba.begin (), rgba.end (), -1.f); }
+
+    void check (int frame) const
+    {
+        for (int y = 0; y < H; ++y)
+        {
+            for (int x = 0; x < W; ++x)
+            {
+                const float* p = &rgba[(size_t (y) * W + x) * 4];
+                assert (p[0] == pixelValue (frame, 1, x, y));
+                assert (p[1] == pixelValue (frame, 0, x, y));
+                assert (p[2] == pixelValue (frame, 2, x, y));
+                assert (p[3] == 1.f);
+            }
+        }
+    }
+};
+
+void
+testScanLineSequence (const string& tempDir, int nframes)
+{
+    vector<string> names;
+    Header         hdr = makeHeader (ZIP_COMPRESSION, false);
+
+    for (int f = 0; f < nframes; ++f)
+    {
+        names.push_back (tempDir + "imf_test_readplan_" + to_string (f) + ".exr");
+        writeFrame (names.back (), f, hdr);
+    }
+
+    Pixels   px;
+    ReadPlan plan (hdr, px.frameBuffer ());
+    assert (plan.matches (hdr));
+
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        for (int f = 0; f < nframes; ++f)
+        {
+            px.clear ();
+            InputFile in (names[f].c_str ());
+            assert (plan.matches (in.header ()));
+            in.setReadPlan (plan);
+            in.readPixels (0, H - 1);
+            px.check (f);
+        }
+    }
+
+    //
+    // a single file can swap between a plan and a plain frame buffer
+    //
+
+    {
+        InputFile in (names[0].c_str ());
+        in.setReadPlan (plan);
+        in.readPixels (0, H / 2);
+
+        Pixels other;
+        in.setFrameBuffer (other.frameBuffer ());
+        in.readPixels (0, H - 1);
+        other.check (0);
+
+        px.clear ();
+        in.setReadPlan (plan);
+        in.readPixels (0, H - 1);
+        px.check (0);
+    }
+
+    plan.releaseDecoders ();
+
+    for (auto& n: names)
+        remove (n.c_str ());
+}
+
+void
+testTiledSequence (const string& tempDir, int nframes)
+{
+    vector<string> names;
+    Header         hdr = makeHeader (PIZ_COMPRESSION, true);
+
+    for (int f = 0; f < nframes; ++f)
+    {
+        names.push_back (
+            tempDir + "imf_test_readplan_tiled_" + to_string (f) + ".exr");
+        writeFrame (names.back (), f, hdr);
+    }
+
+    Pixels   px;
+    ReadPlan plan (hdr, px.frameBuffer ());
+
+    for (int f = 0; f < nframes; ++f)
+    {
+        px.clear ();
+        TiledInputFile in (names[f].c_str ());
+        in.setReadPlan (plan);
+        in.readTiles (0, in.numXTiles () - 1, 0, in.numYTiles () - 1);
+        px.check (f);
+    }
+
+    //
+    // InputFile on a tiled file reads through the plan's frame buffer
+    //
+
+    {
+        px.clear ();
+        InputFile in (names[1].c_str ());
+        in.setReadPlan (plan);
+        in.readPixels (0, H - 1);
+        px.check (1);
+    }
+
+    for (auto& n: names)
+        remove (n.c_str ());
+}
+
+void
+testMismatch (const string& tempDir)
+{
+    string fn = tempDir + "imf_test_readplan_mismatch.exr";
+    Header hdr = makeHeader (ZIP_COMPRESSION, false);
+
+    Pixels   px;
+    ReadPlan plan (hdr, px.frameBuffer ());
+
+    Header other = makeHeader (RLE_COMPRESSION, false);
+    assert (!plan.matches (other));
+    assert (!plan.matches (makeHeader (ZIP_COMPRESSION, true)));
+
+    writeFrame (fn, 0, other);
+
+    bool caught = false;
+    try
+    {
+        InputFile in (fn.c_str ());
+        in.setReadPlan (plan);
+    }
+    catch (const IEX_NAMESPACE::ArgExc&)
+    {
+        caught = true;
+    }
+    assert (caught);
+
+    //
+    // mismatched sampling is rejected when the plan is built
+    //
+
+    FrameBuffer fb = px.frameBuffer ();
+    fb["R"].xSampling = 2;
+    caught            = false;
+    try
+    {
+        ReadPlan bad (hdr, fb);
+    }
+    catch (const IEX_NAMESPACE::ArgExc&)
+    {
+        caught = true;
+    }
+    assert (caught);
+
+    remove (fn.c_str ());
+}
+
+} // namespace
+
+void
+testReadPlan (const std::string& tempDir)
+{
+    try
+    {
+        cout << "Testing read plans" << endl;
+
+        int maxThreads = ILMTHREAD_NAMESPACE::supportsThreads () ? 3 : 0;
+
+        for (int n = 0; n <= maxThreads; ++n)
+        {
+            if (ILMTHREAD_NAMESPACE::supportsThreads ())
+            {
+                setGlobalThreadCount (n);
+                cout << "number of threads: " << globalThreadCount () << endl;
+            }
+
+            testScanLineSequence (tempDir, 4);
+            testTiledSequence (tempDir, 3);
+        }
+
+        testMismatch (tempDir);
+
+        cout << "ok\n" << endl;
+    }
+    catch (const std::exception& e)
+    {
+        cerr << "ERROR -- caught exception: " << e.what () << endl;
+        assert (false);
+    }
+}
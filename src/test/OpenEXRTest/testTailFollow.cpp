@@ -0,0 +1,392 @@
+//
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) Contributors to the OpenEXR Project.
+//
+
+#ifdef NDEBUG
+#    undef NDEBUG
+#endif
+
+#include "Iex.h"
+#include "IlmThread.h"
+#include <ImfArray.h>
+#include <ImfChannelList.h>
+#include <ImfContextInit.h>
+#include <ImfFrameBuffer.h>
+#include <ImfHeader.h>
+#include <ImfOutputFile.h>
+#include <ImfScanLineInputFile.h>
+#include <ImfThreading.h>
+#include <ImfTiledInputFile.h>
+#include <ImfTiledOutputFile.h>
+
+#include <openexr.h>
+
+#include <algorithm>
+#include <assert.h>
+#include <fstream>
+#include <iostream>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#include "testTailFollow.h"
+
+using namespace OPENEXR_IMF_NAMESPACE;
+using namespace std;
+using namespace IMATH_NAMESPACE;
+
+namespace
+{
+
+const int W = 97;
+const int H = 75;
+
+float
+pixelValue (int x, int y)
+{
+    return float ((x * 7 + y * 13) % 1024);
+}
+
+void
+writeImage (
+    const string& fileName, bool tiled, Compression comp = ZIPS_COMPRESSION)
+{
+    Header hdr (W, H);
+    hdr.compression () = comp;
+    hdr.channels ().insert ("Y", Channel (FLOAT));
+    if (tiled) hdr.setTileDescription (TileDescription (16, 16, ONE_LEVEL));
+
+    Array2D<float> px (H, W);
+    for (int y = 0; y < H; ++y)
+        for (int x = 0; x < W; ++x)
+            px[y][x] = pixelValue (x, y);
+
+    FrameBuffer fb;
+    fb.insert (
+        "Y",
+        Slice (FLOAT, (char*) &px[0][0], sizeof (float), sizeof (float) * W));
+
+    if (tiled)
+    {
+        TiledOutputFile out (fileName.c_str (), hdr);
+        out.setFrameBuffer (fb);
+        out.writeTiles (0, out.numXTiles () - 1, 0, out.numYTiles () - 1);
+    }
+    else
+    {
+        OutputFile out (fileName.c_str (), hdr);
+        out.setFrameBuffer (fb);
+        out.writePixels (H);
+    }
+}
+
+//
+// Replays the writing of a finished file: stage k holds the header
+// and the first k chunks (in file order), with the offset table only
+// listing those, as a renderer updating the table after each chunk
+// would leave it.
+//
+
+struct Replay
+{
+    vector<char>     bytes;
+    uint64_t         tableOffset = 0;
+    vector<uint64_t> table;
+    vector<uint64_t> sorted;
+
+    explicit Replay (const string& fileName)
+    {
+        ifstream in (fileName.c_str (), ios::binary);
+        bytes.assign (
+            (istreambuf_iterator<char> (in)), istreambuf_iterator<char> ());
+
+        exr_context_t ctxt;
+        int32_t       nchunks = 0;
+        assert (exr_start_read (&ctxt, fileName.c_str (), NULL) == EXR_ERR_SUCCESS);
+        assert (exr_get_chunk_table_offset (ctxt, 0, &tableOffset) == EXR_ERR_SUCCESS);
+        assert (exr_get_chunk_count (ctxt, 0, &nchunks) == EXR_ERR_SUCCESS);
+        exr_finish (&ctxt);
+
+        for (int c = 0; c < nchunks; ++c)
+        {
+            uint64_t off = 0;
+            for (int b = 7; b >= 0; --b)
+                off = (off << 8) |
+                      uint8_t (bytes[tableOffset + 8 * size_t (c) + b]);
+            table.push_back (off);
+        }
+        sorted = table;
+        std::sort (sorted.begin (), sorted.end ());
+    }
+
+    int numChunks () const { return int (table.size ()); }
+
+    void writeStage (const string& fileName, int k) const
+    {
+        write (fileName, k < numChunks () ? sorted[k] : bytes.size (), k);
+    }
+
+    // stage k, followed by the first extra bytes of chunk k, which
+    // the offset table already lists
+    void writePartialStage (const string& fileName, int k, size_t extra) const
+    {
+        write (fileName, sorted[k] + extra, k + 1);
+    }
+
+    size_t chunkSize (int k) const
+    {
+        return (k + 1 < numChunks () ? sorted[k + 1] : bytes.size ()) -
+               sorted[k];
+    }
+
+    void write (const string& fileName, uint64_t end, int listed) const
+    {
+        vector<char> stage (bytes.begin (), bytes.begin () + end);
+
+        for (size_t c = 0; c < table.size (); ++c)
+        {
+            if (listed >= numChunks () || table[c] < sorted[listed]) continue;
+            for (int b = 0; b < 8; ++b)
+                stage[tableOffset + 8 * c + b] = 0;
+        }
+
+        // overwrite in place, the reader keeps the file open
+        FILE* f = fopen (fileName.c_str (), listed == 0 ? "wb" : "r+b");
+        assert (f);
+        assert (fwrite (stage.data (), 1, stage.size (), f) == stage.size ());
+        fclose (f);
+    }
+};
+
+void
+checkLines (const Array2D<float>& px, int y1, int y2, bool written)
+{
+    for (int y = y1; y <= y2; ++y)
+        for (int x = 0; x < W; ++x)
+            assert (px[y][x] == (written ? pixelValue (x, y) : -1.f));
+}
+
+void
+testScanLines (const string& tempDir)
+{
+    string full = tempDir + "imf_test_tail_full.exr";
+    string live = tempDir + "imf_test_tail_live.exr";
+
+    writeImage (full, false);
+    Replay replay (full);
+    replay.writeStage (live, 0);
+
+    Array2D<float> px (H, W);
+    for (int y = 0; y < H; ++y)
+        for (int x = 0; x < W; ++x)
+            px[y][x] = -1.f;
+
+    FrameBuffer fb;
+    fb.insert (
+        "Y",
+        Slice (FLOAT, (char*) &px[0][0], sizeof (float), sizeof (float) * W));
+
+    ScanLineInputFile in (
+        live.c_str (), ContextInitializer ().tailFollow (true));
+    in.setFrameBuffer (fb);
+
+    assert (!in.isComplete ());
+    assert (in.readAvailablePixels (0, H - 1) == 0);
+
+    int total = 0;
+    for (int k = 1; k <= replay.numChunks (); k += 10)
+    {
+        replay.writeStage (live, k);
+
+        total += in.readAvailablePixels (0, H - 1);
+        assert (total == k);
+
+        // ZIPS stores one scan line per chunk
+        checkLines (px, 0, k - 1, true);
+        checkLines (px, k, H - 1, false);
+    }
+
+    replay.writeStage (live, replay.numChunks ());
+    total += in.readAvailablePixels (H - 1, 0);
+    assert (total == H);
+    assert (in.isComplete ());
+    checkLines (px, 0, H - 1, true);
+
+    // nothing new to read
+    assert (in.readAvailablePixels (0, H - 1) == 0);
+
+    // a new frame buffer starts over
+    in.setFrameBuffer (fb);
+    assert (in.readAvailablePixels (10, 19) == 10);
+
+    remove (full.c_str ());
+    remove (live.c_str ());
+}
+
+void
+testTiles (const string& tempDir)
+{
+    string full = tempDir + "imf_test_tail_tiled_full.exr";
+    string live = tempDir + "imf_test_tail_tiled_live.exr";
+
+    writeImage (full, true);
+    Replay replay (full);
+    replay.writeStage (live, 0);
+
+    Array2D<float> px (H, W);
+    for (int y = 0; y < H; ++y)
+        for (int x = 0; x < W; ++x)
+            px[y][x] = -1.f;
+
+    FrameBuffer fb;
+    fb.insert (
+        "Y",
+        Slice (FLOAT, (char*) &px[0][0], sizeof (float), sizeof (float) * W));
+
+    TiledInputFile in (live.c_str (), ContextInitializer ().tailFollow (true));
+    in.setFrameBuffer (fb);
+
+    int nx = in.numXTiles ();
+    int ny = in.numYTiles ();
+    assert (replay.numChunks () == nx * ny);
+    assert (in.readAvailableTiles (0, nx - 1, 0, ny - 1) == 0);
+
+    int total = 0;
+    for (int k = 3; k <= replay.numChunks (); k += 7)
+    {
+        replay.writeStage (live, k);
+        total += in.readAvailableTiles (0, nx - 1, 0, ny - 1);
+        assert (total == k);
+    }
+
+    replay.writeStage (live, replay.numChunks ());
+    total += in.readAvailableTiles (0, nx - 1, 0, ny - 1);
+    assert (total == nx * ny);
+    assert (in.isComplete ());
+    checkLines (px, 0, H - 1, true);
+
+    assert (in.readAvailableTiles (0, nx - 1, 0, ny - 1) == 0);
+
+    bool caught = false;
+    try
+    {
+        in.readAvailableTiles (0, nx, 0, ny - 1);
+    }
+    catch (const IEX_NAMESPACE::ArgExc&)
+    {
+        caught = true;
+    }
+    assert (caught);
+
+    remove (full.c_str ());
+    remove (live.c_str ());
+}
+
+void
+testPartialChunks (const string& tempDir)
+{
+    string full = tempDir + "imf_test_tail_full.exr";
+    string live = tempDir + "imf_test_tail_live.exr";
+
+    Array2D<float> px (H, W);
+    for (int y = 0; y < H; ++y)
+        for (int x = 0; x < W; ++x)
+            px[y][x] = -1.f;
+
+    FrameBuffer fb;
+    fb.insert (
+        "Y",
+        Slice (FLOAT, (char*) &px[0][0], sizeof (float), sizeof (float) * W));
+
+    //
+    // A chunk which the offset table lists, but whose data has not
+    // been written in full, is not available yet.
+    //
+
+    {
+        writeImage (full, false);
+        Replay replay (full);
+        replay.writeStage (live, 0);
+
+        ScanLineInputFile in (
+            live.c_str (), ContextInitializer ().tailFollow (true));
+        in.setFrameBuffer (fb);
+
+        replay.writePartialStage (live, 0, 6);
+        assert (in.readAvailablePixels (0, H - 1) == 0);
+
+        replay.writePartialStage (live, 0, replay.chunkSize (0) - 1);
+        assert (in.readAvailablePixels (0, H - 1) == 0);
+        checkLines (px, 0, H - 1, false);
+
+        replay.writeStage (live, 1);
+        assert (in.readAvailablePixels (0, H - 1) == 1);
+        checkLines (px, 0, 0, true);
+        checkLines (px, 1, H - 1, false);
+    }
+
+    //
+    // A chunk which was only read in part is read again when the
+    // rest of its scan lines is asked for.
+    //
+
+    {
+        for (int y = 0; y < H; ++y)
+            for (int x = 0; x < W; ++x)
+                px[y][x] = -1.f;
+
+        // ZIP stores 16 scan lines per chunk
+        writeImage (live, false, ZIP_COMPRESSION);
+
+        ScanLineInputFile in (
+            live.c_str (), ContextInitializer ().tailFollow (true));
+        in.setFrameBuffer (fb);
+
+        assert (in.readAvailablePixels (0, 7) == 1);
+        checkLines (px, 0, 7, true);
+        checkLines (px, 8, H - 1, false);
+
+        assert (in.readAvailablePixels (0, 15) == 1);
+        checkLines (px, 0, 15, true);
+        checkLines (px, 16, H - 1, false);
+
+        assert (in.readAvailablePixels (0, 15) == 0);
+    }
+
+    remove (full.c_str ());
+    remove (live.c_str ());
+}
+
+} // namespace
+
+void
+testTailFollow (const std::string& tempDir)
+{
+    try
+    {
+        cout << "Testing reading files while they are written" << endl;
+
+        int maxThreads = ILMTHREAD_NAMESPACE::supportsThreads () ? 3 : 0;
+
+        for (int n = 0; n <= maxThreads; n += 3)
+        {
+            if (ILMTHREAD_NAMESPACE::supportsThreads ())
+            {
+                setGlobalThreadCount (n);
+                cout << "number of threads: " << globalThreadCount () << endl;
+            }
+
+            testScanLines (tempDir);
+            testTiles (tempDir);
+            testPartialChunks (tempDir);
+        }
+
+        cout << "ok\n" << endl;
+    }
+    catch (const std::exception& e)
+    {
+        cerr << "ERROR -- caught exception: " << e.what () << endl;
+        assert (false);
+    }
+}
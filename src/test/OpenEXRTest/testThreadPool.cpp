@@ -0,0 +1,289 @@
+//
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) Contributors to the OpenEXR Project.
+//
+
+#ifdef NDEBUG
+#    undef NDEBUG
+#endif
+
+#include "IlmThread.h"
+#include "IlmThreadPool.h"
+#include "IlmThreadSemaphore.h"
+
+#include <assert.h>
+#include <atomic>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "testThreadPool.h"
+
+using namespace ILMTHREAD_NAMESPACE;
+using namespace std;
+
+namespace
+{
+
+struct Record
+{
+    std::mutex  mx;
+    vector<int> order;
+
+    void push (int id)
+    {
+        std::lock_guard<std::mutex> lk (mx);
+        order.push_back (id);
+    }
+};
+
+//
+// blocks the (single) worker thread until released, so that the
+// tasks added after it all sit in the queue together
+//
+class GateTask : public Task
+{
+public:
+    GateTask (TaskGroup* g, Semaphore& started, Semaphore& release)
+        : Task (g), _started (started), _release (release)
+    {}
+
+    void execute () override
+    {
+        _started.post ();
+        _release.wait ();
+    }
+
+private:
+    Semaphore& _started;
+    Semaphore& _release;
+};
+
+class RecordTask : public Task
+{
+public:
+    RecordTask (TaskGroup* g, Record& r, int id) : Task (g), _rec (r), _id (id)
+    {}
+
+    void execute () override { _rec.push (_id); }
+
+private:
+    Record& _rec;
+    int     _id;
+};
+
+class NodeTask : public Task
+{
+public:
+    NodeTask (TaskGroup* g, Record& r) : Task (g), _rec (r) {}
+
+    void execute () override { _rec.push (ThreadPool::currentNumaNode ()); }
+
+private:
+    Record& _rec;
+};
+
+class NestedTask : public Task
+{
+public:
+    NestedTask (TaskGroup* g, std::atomic<int>& result)
+        : Task (g), _result (result)
+    {}
+
+    void execute () override
+    {
+        TaskGroup* cur = TaskGroup::current ();
+        TaskGroup  child (cur);
+
+        int r = 0;
+        if (cur == group ()) r |= 1;
+        if (child.priority () == group ()->priority ()) r |= 2;
+        group ()->cancel ();
+        if (child.isCancelled () && isCancelled ()) r |= 4;
+        _result = r;
+    }
+
+private:
+    std::atomic<int>& _result;
+};
+
+void
+testPriority ()
+{
+    cout << "Testing task group priorities" << endl;
+
+    ThreadPool pool (1);
+    Semaphore  started (0), release (0);
+    Record     rec;
+
+    {
+        TaskGroup gate, low, mid, high;
+        low.setPriority (-1);
+        high.setPriority (10);
+
+        pool.addTask (new GateTask (&gate, started, release));
+        started.wait ();
+
+        pool.addTask (new RecordTask (&low, rec, 0));
+        pool.addTask (new RecordTask (&mid, rec, 1));
+        pool.addTask (new RecordTask (&high, rec, 2));
+        pool.addTask (new RecordTask (&mid, rec, 1));
+        pool.addTask (new RecordTask (&low, rec, 0));
+
+        release.post ();
+    }
+
+    vector<int> expected = {2, 1, 1, 0, 0};
+    assert (rec.order == expected);
+}
+
+void
+testCancel ()
+{
+    cout << "Testing task group cancellation" << endl;
+
+    ThreadPool pool (1);
+    Semaphore  started (0), release (0);
+    Record     rec;
+
+    {
+        TaskGroup gate, keep, drop;
+        drop.setPriority (5);
+
+        pool.addTask (new GateTask (&gate, started, release));
+        started.wait ();
+
+        for (int i = 0; i < 8; ++i)
+            pool.addTask (new RecordTask (&drop, rec, 0));
+        pool.addTask (new RecordTask (&keep, rec, 1));
+
+        drop.cancel ();
+        assert (drop.isCancelled ());
+        assert (!keep.isCancelled ());
+
+        // tasks added after cancel are discarded immediately
+        pool.addTask (new RecordTask (&drop, rec, 0));
+
+        release.post ();
+    }
+
+    vector<int> expected = {1};
+    assert (rec.order == expected);
+
+    // inline execution with no worker threads honors cancel too
+    ThreadPool inlinePool (0);
+    {
+        TaskGroup g;
+        g.cancel ();
+        inlinePool.addTask (new RecordTask (&g, rec, 2));
+    }
+    assert (rec.order == expected);
+}
+
+void
+testNesting ()
+{
+    cout << "Testing nested task groups" << endl;
+
+    assert (TaskGroup::current () == nullptr);
+
+    ThreadPool       pool (2);
+    std::atomic<int> result (0);
+    {
+        TaskGroup g;
+        g.setPriority (3);
+        pool.addTask (new NestedTask (&g, result));
+    }
+    assert (result == 7);
+}
+
+void
+testAffinity ()
+{
+    cout << "Testing NUMA thread affinity" << endl;
+
+    int nodes = ThreadPool::numNumaNodes ();
+    cout << "  numa nodes: " << nodes << endl;
+    assert (nodes >= 1);
+
+    int node = ThreadPool::currentNumaNode ();
+    assert (node >= 0 && node < nodes);
+
+    ThreadPool pool (4);
+    assert (pool.threadAffinity () == ThreadPool::THREAD_AFFINITY_NONE);
+
+    pool.setThreadAffinity (ThreadPool::THREAD_AFFINITY_NUMA);
+    assert (pool.threadAffinity () == ThreadPool::THREAD_AFFINITY_NUMA);
+    assert (pool.numThreads () == 4);
+
+    Record rec;
+    {
+        TaskGroup g;
+        for (int i = 0; i < 64; ++i)
+            pool.addTask (new RecordTask (&g, rec, i));
+    }
+    assert (rec.order.size () == 64);
+
+    // the pinned workers report the node they were placed on
+    rec.order.clear ();
+    {
+        TaskGroup g;
+        for (int i = 0; i < 64; ++i)
+            pool.addTask (new NodeTask (&g, rec));
+    }
+    assert (rec.order.size () == 64);
+    for (int n: rec.order)
+        assert (n >= 0 && n < nodes);
+
+    // priorities are still honored across the node queues
+    Semaphore started (0), release (0);
+    pool.setNumThreads (1);
+    rec.order.clear ();
+    {
+        TaskGroup gate, low, high;
+        high.setPriority (1);
+
+        pool.addTask (new GateTask (&gate, started, release));
+        started.wait ();
+
+        pool.addTask (new RecordTask (&low, rec, 0));
+        pool.addTask (new RecordTask (&high, rec, 1));
+
+        release.post ();
+    }
+    vector<int> expected = {1, 0};
+    assert (rec.order == expected);
+
+    pool.setThreadAffinity (ThreadPool::THREAD_AFFINITY_NONE);
+    assert (pool.numThreads () == 1);
+}
+
+} // namespace
+
+void
+testThreadPool (const std::string&)
+{
+    try
+    {
+        cout << "Testing thread pool scheduling" << endl;
+
+        if (!supportsThreads ())
+        {
+            cout << "threading not supported, skipping" << endl;
+            return;
+        }
+
+        testPriority ();
+        testCancel ();
+        testNesting ();
+        testAffinity ();
+
+        cout << "ok\n" << endl;
+    }
+    catch (const std::exception& e)
+    {
+        cerr << "ERROR -- caught exception: " << e.what () << endl;
+        assert (false);
+    }
+}
@@ -13,6 +13,8 @@
 #include "testDeepImage.h"
 #include "testFlatImage.h"
 #include "testIO.h"
+#include "testRawPartCopy.h"
+#include "testSequenceReader.h"
 #include "tmpDir.h"
 #include <ImathRandom.h>
 
@@ -89,6 +91,8 @@ main (int argc, char* argv[])
     TEST (testFlatImage);
     TEST (testDeepImage);
     TEST (testIO);
+    TEST (testSequenceReader);
+    TEST (testRawPartCopy);
     // NB: If you add a test here, make sure to enumerate it in the
     // CMakeLists.txt so it runs as part of the test suite
 
@@ -8,13 +8,16 @@
 #endif
 
 #include <Iex.h>
+#include <IlmThread.h>
 #include <ImathRandom.h>
 #include <ImfDeepImage.h>
 #include <ImfDeepImageIO.h>
 #include <ImfHeader.h>
+#include <ImfThreading.h>
 
 #include <cassert>
 #include <cstdio>
+#include <vector>
 
 using namespace OPENEXR_IMF_NAMESPACE;
 using namespace IMATH_NAMESPACE;
@@ -450,6 +453,198 @@ testSetSampleCounts ()
     testSetSampleCounts (Box2i (V2i (50, 10), V2i (699, 199)));
 }
 
+void
+testEditSampleCountRows (const Box2i& dataWindow)
+{
+    cout << "change sample counts in a range of rows, data window = "
+            "("
+         << dataWindow.min.x << ", " << dataWindow.min.y
+         << ") - "
+            "("
+         << dataWindow.max.x << ", " << dataWindow.max.y << ")" << endl;
+
+    DeepImage img;
+    img.resize (dataWindow, ONE_LEVEL, ROUND_DOWN);
+    img.insertChannel ("F", FLOAT, 1, 1, false);
+    img.insertChannel ("H", HALF, 1, 1, false);
+
+    Rand48 random (1);
+    fillChannels (random, img);
+
+    DeepImageLevel&     level        = img.level ();
+    DeepFloatChannel&   fc           = level.typedChannel<float> ("F");
+    DeepHalfChannel&    hc           = level.typedChannel<half> ("H");
+    SampleCountChannel& sampleCounts = level.sampleCounts ();
+
+    int w  = sampleCounts.pixelsPerRow ();
+    int h  = sampleCounts.pixelsPerColumn ();
+    int rb = sampleCounts.rowsPerBlock ();
+    int r1 = rb + 3;
+    int r2 = 2 * rb + 1;
+
+    assert (h > 3 * rb);
+    assert (sampleCounts.numBlocks () == (h + rb - 1) / rb);
+
+    //
+    // Remember the current samples and sample list locations
+    //
+
+    vector<unsigned int>  oldCounts (sampleCounts.numPixels ());
+    vector<vector<float>> oldSamples (sampleCounts.numPixels ());
+    vector<const float*>  oldLists (sampleCounts.numPixels ());
+
+    for (int r = 0; r < h; ++r)
+    {
+        for (int i = 0; i < w; ++i)
+        {
+            int    x     = dataWindow.min.x + i;
+            int    y     = dataWindow.min.y + r;
+            size_t p     = size_t (r) * w + i;
+            oldCounts[p] = sampleCounts (x, y);
+            oldLists[p]  = fc (x, y);
+            oldSamples[p] = vector<float> (fc (x, y), fc (x, y) + oldCounts[p]);
+        }
+    }
+
+    {
+        SampleCountChannel::Edit edit (sampleCounts, r1, r2);
+
+        for (int r = r1; r <= r2; ++r)
+            for (int i = 0; i < w; ++i)
+                edit.sampleCounts ()[(r - r1) * w + i] = random.nexti () % 10;
+
+        //
+        // Samples outside the edited rows remain accessible
+        //
+
+        assert (fc (dataWindow.min.x, dataWindow.min.y) == oldLists[0]);
+    }
+
+    for (int r = 0; r < h; ++r)
+    {
+        for (int i = 0; i < w; ++i)
+        {
+            int          x = dataWindow.min.x + i;
+            int          y = dataWindow.min.y + r;
+            size_t       p = size_t (r) * w + i;
+            unsigned int n = sampleCounts (x, y);
+
+            if (r / rb < r1 / rb || r / rb > r2 / rb)
+            {
+                //
+                // Blocks outside the edited rows have not been moved
+                //
+
+                assert (n == oldCounts[p]);
+                assert (fc (x, y) == oldLists[p]);
+            }
+
+            if (r < r1 || r > r2) assert (n == oldCounts[p]);
+
+            for (unsigned int j = 0; j < n; ++j)
+            {
+                if (j < oldCounts[p])
+                    assert (fc (x, y)[j] == oldSamples[p][j]);
+                else
+                    assert (fc (x, y)[j] == 0 && hc (x, y)[j] == 0);
+            }
+        }
+    }
+
+    //
+    // Growing one sample list moves only the samples in its block
+    //
+
+    int x = dataWindow.min.x + w / 2;
+    int y = dataWindow.min.y + h - 1;
+
+    for (unsigned int n = sampleCounts (x, y) + 1; n < 200; n += 7)
+    {
+        sampleCounts.set (x, y, n);
+        assert (sampleCounts (x, y) == n && fc (x, y)[n - 1] == 0);
+    }
+
+    for (size_t p = 0; p < size_t (rb) * w; ++p)
+    {
+        int px = dataWindow.min.x + int (p % w);
+        int py = dataWindow.min.y + int (p / w);
+
+        assert (fc (px, py) == oldLists[p]);
+        assert (oldCounts[p] == 0 || fc (px, py)[0] == oldSamples[p][0]);
+    }
+
+    size_t total = 0;
+
+    for (size_t p = 0; p < sampleCounts.numPixels (); ++p)
+        total += sampleCounts.numSamples ()[p];
+
+    assert (total <= sampleCounts.sampleBufferSize ());
+
+    bool caught = false;
+
+    try
+    {
+        sampleCounts.beginEdit (h - 1, h);
+    }
+    catch (const ArgExc&)
+    {
+        caught = true;
+    }
+
+    assert (caught);
+}
+
+void
+testEditSampleCountRows ()
+{
+    testEditSampleCountRows (Box2i (V2i (0, 0), V2i (99, 79)));
+    testEditSampleCountRows (Box2i (V2i (-10, -50), V2i (49, 37)));
+}
+
+void
+testThreadedLoad (const string& fileName)
+{
+    if (!ILMTHREAD_NAMESPACE::supportsThreads ()) return;
+
+    int oldThreadCount = globalThreadCount ();
+    setGlobalThreadCount (4);
+
+    cout << "scan lines, " << globalThreadCount () << " threads" << endl;
+
+    DeepImage img1;
+    img1.resize (Box2i (V2i (-3, 5), V2i (211, 301)));
+    img1.insertChannel ("H", HALF, 1, 1, false);
+    img1.insertChannel ("F", FLOAT, 1, 1, false);
+    img1.insertChannel ("UI", UINT, 1, 1, false);
+
+    Rand48 random (2);
+    fillChannels (random, img1);
+
+    saveDeepScanLineImage (fileName, img1);
+
+    DeepImage img2;
+    loadDeepImage (fileName, img2);
+    verifyImagesAreEqual (img1, img2);
+
+    cout << "ripmap tiles, " << globalThreadCount () << " threads" << endl;
+
+    DeepImage img3;
+    img3.resize (img1.dataWindow (), RIPMAP_LEVELS, ROUND_UP);
+    img3.insertChannel ("H", HALF, 1, 1, false);
+    img3.insertChannel ("F", FLOAT, 1, 1, false);
+
+    fillChannels (random, img3);
+
+    saveDeepTiledImage (fileName, img3);
+
+    DeepImage img4;
+    loadDeepImage (fileName, img4);
+    verifyImagesAreEqual (img3, img4);
+
+    remove (fileName.c_str ());
+    setGlobalThreadCount (oldThreadCount);
+}
+
 void
 testShiftPixels ()
 {
@@ -683,6 +878,8 @@ testDeepImage (const string& tempDir)
         testScanLineImages (tempDir + "deepScanLines.exr");
         testTiledImages (tempDir + "deepTiles.exr");
         testSetSampleCounts ();
+        testEditSampleCountRows ();
+        testThreadedLoad (tempDir + "deepThreaded.exr");
         testShiftPixels ();
         testCropping (tempDir + "deepCropped.exr");
         testRenameChannel ();
@@ -8,13 +8,18 @@
 #endif
 
 #include <Iex.h>
+#include <IlmThread.h>
+#include <ImathFun.h>
 #include <ImathRandom.h>
 #include <ImfFlatImage.h>
 #include <ImfFlatImageIO.h>
 #include <ImfHeader.h>
+#include <ImfThreading.h>
 
 #include <cassert>
+#include <cmath>
 #include <cstdio>
+#include <vector>
 
 using namespace OPENEXR_IMF_NAMESPACE;
 using namespace IMATH_NAMESPACE;
@@ -352,6 +357,281 @@ testTiledImages (const string& fileName)
     testTiledImage (Box2i (V2i (50, 10), V2i (699, 199)), fileName);
 }
 
+void
+testThreadedTiledImages (const string& fileName)
+{
+    if (!ILMTHREAD_NAMESPACE::supportsThreads ()) return;
+
+    int oldThreadCount = globalThreadCount ();
+    setGlobalThreadCount (4);
+
+    cout << "tiles, " << globalThreadCount () << " threads" << endl;
+
+    Box2i dataWindow (V2i (-10, -50), V2i (499, 599));
+
+    testTiledImage (dataWindow, fileName, MIPMAP_LEVELS, ROUND_UP);
+    testTiledImage (dataWindow, fileName, RIPMAP_LEVELS, ROUND_DOWN);
+
+    setGlobalThreadCount (oldThreadCount);
+}
+
+//
+// A straightforward implementation of the filter used by
+// FlatImage::generateLevels(), to check the results against
+//
+
+typedef vector<vector<double>> Pixels; // pixels[y][x]
+
+template <class T>
+Pixels
+levelPixels (const FlatImageLevel& level, const string& name)
+{
+    const TypedFlatImageChannel<T>& c  = level.typedChannel<T> (name);
+    const Box2i&                    dw = level.dataWindow ();
+
+    int    w = dw.max.x - dw.min.x + 1;
+    int    h = dw.max.y - dw.min.y + 1;
+    Pixels p (h, vector<double> (w));
+
+    for (int y = dw.min.y; y <= dw.max.y; ++y)
+        for (int x = dw.min.x; x <= dw.max.x; ++x)
+            p[y - dw.min.y][x - dw.min.x] = double (c.at (x, y));
+
+    return p;
+}
+
+Pixels
+transpose (const Pixels& p)
+{
+    Pixels t (p[0].size (), vector<double> (p.size ()));
+
+    for (size_t y = 0; y < p.size (); ++y)
+        for (size_t x = 0; x < p[y].size (); ++x)
+            t[x][y] = p[y][x];
+
+    return t;
+}
+
+double
+pixel (const vector<double>& row, int x, LevelWrapMode wrap)
+{
+    int w = int (row.size ());
+
+    if (x >= 0 && x < w) return row[x];
+
+    switch (wrap)
+    {
+        case WRAP_BLACK: return 0;
+        case WRAP_CLAMP: return row[clamp (x, 0, w - 1)];
+        case WRAP_PERIODIC: return row[modp (x, w)];
+        case WRAP_MIRROR:
+            return (divp (x, w) & 1) ? row[w - 1 - modp (x, w)]
+                                     : row[modp (x, w)];
+        default: assert (false); return 0;
+    }
+}
+
+double
+sample (const vector<double>& row, double x, LevelWrapMode wrap)
+{
+    int    xs = int (std::floor (x));
+    double s  = xs + 1 - x;
+
+    return s * pixel (row, xs, wrap) + (1 - s) * pixel (row, xs + 1, wrap);
+}
+
+Pixels
+shrinkX (const Pixels& p, int w1, LevelWrapMode wrap, bool filter, bool odd)
+{
+    int    w0     = int (p[0].size ());
+    double f      = (w1 > 1) ? double (w0 - 2) / (w1 - 1) : 1;
+    int    offset = odd ? ((w0 - 1) - 2 * (w1 - 1)) : 0;
+
+    Pixels q (p.size (), vector<double> (w1));
+
+    for (size_t y = 0; y < p.size (); ++y)
+    {
+        for (int x = 0; x < w1; ++x)
+        {
+            if (filter)
+            {
+                q[y][x] = 0.125 * sample (p[y], x * f - 1, wrap) +
+                          0.375 * sample (p[y], x * f, wrap) +
+                          0.375 * sample (p[y], x * f + 1, wrap) +
+                          0.125 * sample (p[y], x * f + 2, wrap);
+            }
+            else
+            {
+                q[y][x] = p[y][2 * x + offset];
+            }
+        }
+    }
+
+    return q;
+}
+
+Pixels
+shrinkY (const Pixels& p, int h1, LevelWrapMode wrap, bool filter, bool odd)
+{
+    return transpose (shrinkX (transpose (p), h1, wrap, filter, odd));
+}
+
+template <class T>
+void
+verifyGeneratedLevel (
+    const FlatImage&   img,
+    const string&      name,
+    const LevelFilter& filter,
+    int                lx,
+    int                ly,
+    double             tolerance)
+{
+    bool f = filter.doNotFilter.find (name) == filter.doNotFilter.end ();
+
+    Pixels expected;
+
+    if (img.levelMode () == MIPMAP_LEVELS)
+    {
+        Pixels p = levelPixels<T> (img.level (lx - 1), name);
+        p = shrinkX (p, img.levelWidth (lx), filter.wrapX, f, lx & 1);
+        expected = shrinkY (p, img.levelHeight (lx), filter.wrapY, f, lx & 1);
+    }
+    else if (lx > 0)
+    {
+        Pixels p = levelPixels<T> (img.level (lx - 1, ly), name);
+        expected =
+            shrinkX (p, img.levelWidth (lx), filter.wrapX, f, (lx - 1) & 1);
+    }
+    else
+    {
+        Pixels p = levelPixels<T> (img.level (0, ly - 1), name);
+        expected =
+            shrinkY (p, img.levelHeight (ly), filter.wrapY, f, (ly - 1) & 1);
+    }
+
+    Pixels actual = levelPixels<T> (img.level (lx, ly), name);
+
+    assert (actual.size () == expected.size ());
+
+    for (size_t y = 0; y < actual.size (); ++y)
+    {
+        assert (actual[y].size () == expected[y].size ());
+
+        for (size_t x = 0; x < actual[y].size (); ++x)
+        {
+            double e = expected[y][x];
+            assert (
+                std::abs (actual[y][x] - e) <=
+                tolerance * std::max (1.0, std::abs (e)));
+        }
+    }
+}
+
+void
+testGenerateLevels (
+    const Box2i&      dataWindow,
+    LevelMode         levelMode,
+    LevelRoundingMode levelRoundingMode,
+    LevelWrapMode     wrapX,
+    LevelWrapMode     wrapY)
+{
+    cout << "generating levels, data window = "
+            "("
+         << dataWindow.min.x << ", " << dataWindow.min.y
+         << ") - "
+            "("
+         << dataWindow.max.x << ", " << dataWindow.max.y
+         << "), "
+            "level mode = "
+         << levelMode << ", rounding mode = " << levelRoundingMode
+         << ", wrap modes = " << wrapX << ", " << wrapY << endl;
+
+    FlatImage img (dataWindow, levelMode, levelRoundingMode);
+    img.insertChannel ("H", HALF);
+    img.insertChannel ("F", FLOAT);
+    img.insertChannel ("I", UINT);
+
+    Rand48 random (0);
+    fillChannels (random, img.level ());
+
+    LevelFilter filter (wrapX, wrapY);
+    filter.doNotFilter.insert ("I");
+
+    img.generateLevels (filter);
+
+    for (int ly = 0; ly < img.numYLevels (); ++ly)
+    {
+        for (int lx = 0; lx < img.numXLevels (); ++lx)
+        {
+            if (lx == 0 && ly == 0) continue;
+            if (levelMode == MIPMAP_LEVELS && lx != ly) continue;
+
+            verifyGeneratedLevel<half> (img, "H", filter, lx, ly, 2e-3);
+            verifyGeneratedLevel<float> (img, "F", filter, lx, ly, 1e-5);
+            verifyGeneratedLevel<unsigned int> (img, "I", filter, lx, ly, 0);
+        }
+    }
+}
+
+void
+testGenerateLevels ()
+{
+    Box2i dw1 (V2i (0, 0), V2i (63, 63));
+    Box2i dw2 (V2i (-3, 5), V2i (77, 40));
+    Box2i dw3 (V2i (7, -2), V2i (7, 30));
+
+    testGenerateLevels (dw1, MIPMAP_LEVELS, ROUND_DOWN, WRAP_CLAMP, WRAP_CLAMP);
+    testGenerateLevels (dw2, MIPMAP_LEVELS, ROUND_UP, WRAP_BLACK, WRAP_MIRROR);
+    testGenerateLevels (
+        dw2, RIPMAP_LEVELS, ROUND_DOWN, WRAP_PERIODIC, WRAP_BLACK);
+    testGenerateLevels (dw3, RIPMAP_LEVELS, ROUND_UP, WRAP_MIRROR, WRAP_CLAMP);
+
+    cout << "generating levels of a single-level image" << endl;
+
+    {
+        FlatImage img (dw1, ONE_LEVEL);
+        img.insertChannel ("F", FLOAT);
+        img.generateLevels ();
+        assert (img.numXLevels () == 1 && img.numYLevels () == 1);
+    }
+
+    if (!ILMTHREAD_NAMESPACE::supportsThreads ()) return;
+
+    cout << "generating levels with and without threads" << endl;
+
+    Box2i dw4 (V2i (-20, 10), V2i (499, 311));
+
+    FlatImage img1 (dw4, RIPMAP_LEVELS, ROUND_UP);
+    img1.insertChannel ("H", HALF);
+    img1.insertChannel ("F", FLOAT);
+
+    FlatImage img2 (dw4, RIPMAP_LEVELS, ROUND_UP);
+    img2.insertChannel ("H", HALF);
+    img2.insertChannel ("F", FLOAT);
+
+    {
+        Rand48 random (1);
+        fillChannels (random, img1.level ());
+    }
+
+    {
+        Rand48 random (1);
+        fillChannels (random, img2.level ());
+    }
+
+    int oldThreadCount = globalThreadCount ();
+
+    setGlobalThreadCount (0);
+    img1.generateLevels (LevelFilter (WRAP_PERIODIC, WRAP_MIRROR));
+
+    setGlobalThreadCount (4);
+    img2.generateLevels (LevelFilter (WRAP_PERIODIC, WRAP_MIRROR));
+
+    setGlobalThreadCount (oldThreadCount);
+
+    verifyImagesAreEqual (img1, img2);
+}
+
 void
 testShiftPixels ()
 {
@@ -582,6 +862,8 @@ testFlatImage (const string& tempDir)
 
         testScanLineImages (tempDir + "scanLines.exr");
         testTiledImages (tempDir + "tiles.exr");
+        testThreadedTiledImages (tempDir + "tiles.exr");
+        testGenerateLevels ();
         testShiftPixels ();
         testCropping (tempDir + "cropped.exr");
         testRenameChannel ();
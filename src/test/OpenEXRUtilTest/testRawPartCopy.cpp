@@ -0,0 +1,404 @@
+//
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) Contributors to the OpenEXR Project.
+//
+
+#ifdef NDEBUG
+#    undef NDEBUG
+#endif
+
+#include <Iex.h>
+#include <ImfDeepImageIO.h>
+#include <ImfFlatImageIO.h>
+#include <ImfHeader.h>
+#include <ImfMultiPartInputFile.h>
+#include <ImfPartType.h>
+#include <ImfRawPartCopy.h>
+#include <ImfStandardAttributes.h>
+
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include "testRawPartCopy.h"
+
+using namespace OPENEXR_IMF_NAMESPACE;
+using namespace IMATH_NAMESPACE;
+using namespace IEX_NAMESPACE;
+using namespace std;
+
+namespace
+{
+
+const Box2i gDataWindow (V2i (-3, 2), V2i (60, 44));
+
+void
+writeFlatImage (const string& fileName, bool tiled)
+{
+    FlatImage img (gDataWindow, tiled ? MIPMAP_LEVELS : ONE_LEVEL);
+    img.insertChannel ("R", HALF);
+    img.insertChannel ("Z", FLOAT);
+
+    for (int l = 0; l < img.numLevels (); ++l)
+    {
+        FlatImageLevel&   level = img.level (l);
+        FlatHalfChannel&  r     = level.typedChannel<half> ("R");
+        FlatFloatChannel& z     = level.typedChannel<float> ("Z");
+        const Box2i&      dw    = level.dataWindow ();
+
+        for (int y = dw.min.y; y <= dw.max.y; ++y)
+        {
+            for (int x = dw.min.x; x <= dw.max.x; ++x)
+            {
+                r.at (x, y) = (x + 2 * y + l) % 64;
+                z.at (x, y) = x * 0.5f - y + l;
+            }
+        }
+    }
+
+    Header hdr;
+    hdr.compression () = ZIP_COMPRESSION;
+    addComments (hdr, fileName);
+
+    if (tiled) hdr.setTileDescription (TileDescription (16, 16, MIPMAP_LEVELS));
+
+    saveFlatImage (fileName, hdr, img, USE_IMAGE_DATA_WINDOW);
+}
+
+void
+writeDeepImage (const string& fileName)
+{
+    DeepImage img (gDataWindow, ONE_LEVEL);
+    img.insertChannel ("Z", FLOAT);
+
+    DeepImageLevel& level = img.level ();
+    const Box2i&    dw    = level.dataWindow ();
+
+    {
+        SampleCountChannel::Edit edit (level.sampleCounts ());
+
+        for (size_t i = 0; i < level.sampleCounts ().numPixels (); ++i)
+            edit.sampleCounts ()[i] = i % 3;
+    }
+
+    DeepFloatChannel& z = level.typedChannel<float> ("Z");
+
+    for (int y = dw.min.y; y <= dw.max.y; ++y)
+        for (int x = dw.min.x; x <= dw.max.x; ++x)
+            for (unsigned int s = 0; s < level.sampleCounts () (x, y); ++s)
+                z (x, y)[s] = x + y + s * 0.25f;
+
+    Header hdr;
+    hdr.compression () = ZIPS_COMPRESSION;
+
+    saveDeepImage (fileName, hdr, img, USE_IMAGE_DATA_WINDOW);
+}
+
+void
+compareFlatImages (const string& fileName1, const string& fileName2)
+{
+    Header    hdr1, hdr2;
+    FlatImage img1, img2;
+
+    loadFlatImage (fileName1, hdr1, img1);
+    loadFlatImage (fileName2, hdr2, img2);
+
+    assert (hdr1.compression () == hdr2.compression ());
+    assert (hdr1.hasTileDescription () == hdr2.hasTileDescription ());
+    assert (comments (hdr1) == comments (hdr2));
+    assert (img1.numLevels () == img2.numLevels ());
+
+    for (int l = 0; l < img1.numLevels (); ++l)
+    {
+        const FlatImageLevel& level1 = img1.level (l);
+        const FlatImageLevel& level2 = img2.level (l);
+        const Box2i&          dw     = level1.dataWindow ();
+
+        assert (dw == level2.dataWindow ());
+
+        for (int y = dw.min.y; y <= dw.max.y; ++y)
+        {
+            for (int x = dw.min.x; x <= dw.max.x; ++x)
+            {
+                assert (
+                    level1.typedChannel<half> ("R").at (x, y).bits () ==
+                    level2.typedChannel<half> ("R").at (x, y).bits ());
+
+                assert (
+                    level1.typedChannel<float> ("Z").at (x, y) ==
+                    level2.typedChannel<float> ("Z").at (x, y));
+            }
+        }
+    }
+}
+
+void
+compareDeepImages (const string& fileName1, const string& fileName2)
+{
+    Header    hdr1, hdr2;
+    DeepImage img1, img2;
+
+    loadDeepImage (fileName1, hdr1, img1);
+    loadDeepImage (fileName2, hdr2, img2);
+
+    const DeepImageLevel& level1 = img1.level ();
+    const DeepImageLevel& level2 = img2.level ();
+    const Box2i&          dw     = level1.dataWindow ();
+
+    assert (dw == level2.dataWindow ());
+
+    for (int y = dw.min.y; y <= dw.max.y; ++y)
+    {
+        for (int x = dw.min.x; x <= dw.max.x; ++x)
+        {
+            unsigned int n = level1.sampleCounts () (x, y);
+            assert (n == level2.sampleCounts () (x, y));
+
+            const float* z1 = level1.typedChannel<float> ("Z") (x, y);
+            const float* z2 = level2.typedChannel<float> ("Z") (x, y);
+
+            assert (memcmp (z1, z2, n * sizeof (float)) == 0);
+        }
+    }
+}
+
+bool
+fileExists (const string& fileName)
+{
+    return ifstream (fileName.c_str ()).good ();
+}
+
+void
+testCombineAndSeparate (const string& tempDir)
+{
+    cout << "combining and separating parts" << endl;
+
+    string flat  = tempDir + "rawFlat.exr";
+    string tiled = tempDir + "rawTiled.exr";
+    string deep  = tempDir + "rawDeep.exr";
+    string multi = tempDir + "rawMulti.exr";
+
+    writeFlatImage (flat, false);
+    writeFlatImage (tiled, true);
+    writeDeepImage (deep);
+
+    //
+    // combine the three files into one, renaming one part
+    // and assigning a view to another
+    //
+
+    RawCopyOutput combined;
+    combined.fileName = multi;
+    combined.parts.resize (3);
+    combined.parts[0].fileName = flat;
+    combined.parts[0].name     = "flat";
+    combined.parts[0].view     = "left";
+    combined.parts[1].fileName = deep;
+    combined.parts[1].name     = "deep";
+    combined.parts[2].fileName = tiled;
+    combined.parts[2].name     = "tiled";
+
+    copyRawParts (vector<RawCopyOutput> (1, combined));
+
+    {
+        MultiPartInputFile in (multi.c_str ());
+
+        assert (in.parts () == 3);
+        assert (in.header (0).name () == "flat");
+        assert (in.header (0).view () == "left");
+        assert (in.header (1).name () == "deep");
+        assert (in.header (1).type () == DEEPSCANLINE);
+        assert (in.header (2).name () == "tiled");
+        assert (in.header (2).type () == TILEDIMAGE);
+    }
+
+    //
+    // split the parts into single-part files again, in one call
+    //
+
+    vector<RawCopyOutput> separated (3);
+
+    for (int i = 0; i < 3; ++i)
+    {
+        separated[i].fileName = tempDir + "rawPart" + char ('0' + i) + ".exr";
+        separated[i].parts.resize (1);
+        separated[i].parts[0].fileName = multi;
+        separated[i].parts[0].part     = i;
+    }
+
+    copyRawParts (separated);
+
+    compareFlatImages (flat, separated[0].fileName);
+    compareDeepImages (deep, separated[1].fileName);
+    compareFlatImages (tiled, separated[2].fileName);
+
+    for (int i = 0; i < 3; ++i)
+        remove (separated[i].fileName.c_str ());
+
+    remove (flat.c_str ());
+    remove (tiled.c_str ());
+    remove (deep.c_str ());
+    remove (multi.c_str ());
+}
+
+void
+testSharedAttributes (const string& tempDir)
+{
+    cout << "conflicting shared attributes" << endl;
+
+    string file1 = tempDir + "rawShared1.exr";
+    string file2 = tempDir + "rawShared2.exr";
+    string multi = tempDir + "rawShared.exr";
+
+    writeFlatImage (file1, false);
+
+    {
+        FlatImage img (Box2i (V2i (0, 0), V2i (7, 7)));
+        img.insertChannel ("R", HALF);
+
+        saveFlatImage (file2, img);
+    }
+
+    RawCopyOutput out;
+    out.fileName = multi;
+    out.parts.resize (2);
+    out.parts[0].fileName = file1;
+    out.parts[0].name     = "a";
+    out.parts[1].fileName = file2;
+    out.parts[1].name     = "b";
+
+    //
+    // The display windows differ; without overriding them,
+    // no output file is created.
+    //
+
+    try
+    {
+        copyRawParts (vector<RawCopyOutput> (1, out));
+        assert (false);
+    }
+    catch (const ArgExc&)
+    {
+        assert (!fileExists (multi));
+    }
+
+    copyRawParts (vector<RawCopyOutput> (1, out), true);
+
+    {
+        MultiPartInputFile in (multi.c_str ());
+
+        assert (in.parts () == 2);
+        assert (
+            in.header (1).displayWindow () == in.header (0).displayWindow ());
+        assert (in.header (1).dataWindow () == Box2i (V2i (0, 0), V2i (7, 7)));
+    }
+
+    //
+    // an output file cannot replace one of the input files
+    //
+
+    out.fileName = file2;
+
+    try
+    {
+        copyRawParts (vector<RawCopyOutput> (1, out), true);
+        assert (false);
+    }
+    catch (const ArgExc&)
+    {}
+
+    remove (file1.c_str ());
+    remove (file2.c_str ());
+    remove (multi.c_str ());
+}
+
+long
+fileSize (const string& fileName)
+{
+    ifstream is (fileName.c_str (), ios_base::binary | ios_base::ate);
+    return long (is.tellg ());
+}
+
+void
+testSameFiles (const string& tempDir)
+{
+    cout << "outputs that are inputs or other outputs" << endl;
+
+    string in  = tempDir + "rawSameIn.exr";
+    string out = tempDir + "rawSameOut.exr";
+
+    writeFlatImage (in, false);
+
+    long size = fileSize (in);
+
+    //
+    // an output that names an input under another name
+    //
+
+    RawCopyOutput o;
+    o.fileName = tempDir + "./rawSameIn.exr";
+    o.parts.resize (1);
+    o.parts[0].fileName = in;
+
+    try
+    {
+        copyRawParts (vector<RawCopyOutput> (1, o));
+        assert (false);
+    }
+    catch (const ArgExc&)
+    {
+        assert (fileSize (in) == size);
+    }
+
+    //
+    // two outputs that are the same file, under the same name
+    // or under different names; no output file is created
+    //
+
+    const char* names[] = {"rawSameOut.exr", "./rawSameOut.exr"};
+
+    for (const char* name: names)
+    {
+        vector<RawCopyOutput> outs (2, o);
+        outs[0].fileName = out;
+        outs[1].fileName = tempDir + name;
+
+        try
+        {
+            copyRawParts (outs);
+            assert (false);
+        }
+        catch (const ArgExc&)
+        {
+            assert (!fileExists (out));
+        }
+    }
+
+    compareFlatImages (in, in);
+
+    remove (in.c_str ());
+}
+
+} // namespace
+
+void
+testRawPartCopy (const string& tempDir)
+{
+    try
+    {
+        cout << "Testing raw copies of image parts" << endl;
+
+        testCombineAndSeparate (tempDir);
+        testSharedAttributes (tempDir);
+        testSameFiles (tempDir);
+
+        cout << "ok\n" << endl;
+    }
+    catch (const std::exception& e)
+    {
+        cerr << "ERROR -- caught exception: " << e.what () << endl;
+        assert (false);
+    }
+}
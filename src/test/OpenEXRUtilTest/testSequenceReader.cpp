@@ -0,0 +1,286 @@
+//
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) Contributors to the OpenEXR Project.
+//
+
+#ifdef NDEBUG
+#    undef NDEBUG
+#endif
+
+#include <Iex.h>
+#include <IlmThread.h>
+#include <ImfChannelList.h>
+#include <ImfFrameBuffer.h>
+#include <ImfHeader.h>
+#include <ImfOutputFile.h>
+#include <ImfSequenceReader.h>
+#include <ImfThreading.h>
+
+#include <cassert>
+#include <cstdio>
+#include <iostream>
+#include <vector>
+
+#include "testSequenceReader.h"
+
+using namespace OPENEXR_IMF_NAMESPACE;
+using namespace IMATH_NAMESPACE;
+using namespace IEX_NAMESPACE;
+using namespace std;
+
+namespace
+{
+
+const int W      = 64;
+const int H      = 37;
+const int FIRST  = 1001;
+const int NFRAME = 12;
+
+float
+pixelValue (int frame, int c, int x, int y)
+{
+    return float ((x + 3 * y + 5 * c + 7 * frame) % 512);
+}
+
+void
+writeSequence (const string& pattern)
+{
+    vector<half> r (W * H), g (W * H);
+
+    for (int f = FIRST; f < FIRST + NFRAME; ++f)
+    {
+        for (int y = 0; y < H; ++y)
+        {
+            for (int x = 0; x < W; ++x)
+            {
+                r[y * W + x] = pixelValue (f, 0, x, y);
+                g[y * W + x] = pixelValue (f, 1, x, y);
+            }
+        }
+
+        Header hdr (W, H);
+        hdr.compression () = ZIP_COMPRESSION;
+        hdr.channels ().insert ("R", Channel (HALF));
+        hdr.channels ().insert ("G", Channel (HALF));
+
+        FrameBuffer fb;
+        fb.insert ("R", Slice (HALF, (char*) r.data (), 2, 2 * W));
+        fb.insert ("G", Slice (HALF, (char*) g.data (), 2, 2 * W));
+
+        string     name = SequenceReader::frameFileName (pattern, f);
+        OutputFile out (name.c_str (), hdr);
+        out.setFrameBuffer (fb);
+        out.writePixels (H);
+    }
+}
+
+//
+// RGB floats, interleaved; B is not in the files and gets filled
+//
+
+FrameBuffer
+makeLayout ()
+{
+    Box2i       dw (V2i (0, 0), V2i (W - 1, H - 1));
+    FrameBuffer layout;
+
+    for (int c = 0; c < 3; ++c)
+    {
+        layout.insert (
+            c == 0 ? "R" : (c == 1 ? "G" : "B"),
+            Slice::Make (
+                FLOAT,
+                reinterpret_cast<void*> (uintptr_t (c * sizeof (float))),
+                dw,
+                3 * sizeof (float),
+                3 * sizeof (float) * W,
+                1,
+                1,
+                0.5));
+    }
+    return layout;
+}
+
+void
+checkFrame (const SequenceReader::Frame& fr, int f)
+{
+    assert (fr.number () == f);
+
+    const float* px = reinterpret_cast<const float*> (
+        fr.frameBuffer ().findSlice ("R")->base);
+
+    for (int y = 0; y < H; ++y)
+    {
+        for (int x = 0; x < W; ++x)
+        {
+            const float* p = px + 3 * (y * W + x);
+            assert (p[0] == pixelValue (f, 0, x, y));
+            assert (p[1] == pixelValue (f, 1, x, y));
+            assert (p[2] == 0.5f);
+        }
+    }
+}
+
+void
+testFileNames ()
+{
+    assert (SequenceReader::frameFileName ("a.%04d.exr", 12) == "a.0012.exr");
+    assert (SequenceReader::frameFileName ("a.%d.exr", 12) == "a.12.exr");
+    assert (SequenceReader::frameFileName ("a.####.exr", 7) == "a.0007.exr");
+    assert (SequenceReader::frameFileName ("a_#.exr", 1234) == "a_1234.exr");
+
+    bool caught = false;
+    try
+    {
+        SequenceReader::frameFileName ("a.exr", 1);
+    }
+    catch (const ArgExc&)
+    {
+        caught = true;
+    }
+    assert (caught);
+}
+
+void
+testPlayback (const string& pattern)
+{
+    SequenceReader::Options opts;
+    opts.framesAhead  = 4;
+    opts.framesBehind = 1;
+
+    SequenceReader seq (pattern, FIRST, FIRST + NFRAME - 1, makeLayout (), opts);
+
+    assert (seq.frameBytes () == size_t (W) * H * 3 * sizeof (float));
+    assert (seq.windowSize () == 6);
+    assert (seq.header ().channels ().findChannel ("G"));
+
+    //
+    // forward playback, holding on to a frame across the window moving
+    //
+
+    seq.prefetch (FIRST);
+    shared_ptr<const SequenceReader::Frame> held = seq.frame (FIRST);
+
+    for (int f = FIRST; f < FIRST + NFRAME; ++f)
+        checkFrame (*seq.frame (f), f);
+
+    checkFrame (*held, FIRST);
+
+    //
+    // scrub backwards, then jump around
+    //
+
+    for (int f = FIRST + NFRAME - 1; f >= FIRST; --f)
+        checkFrame (*seq.frame (f), f);
+
+    for (int f: {FIRST + 5, FIRST + 2, FIRST + 9, FIRST + 9, FIRST})
+        checkFrame (*seq.frame (f), f);
+
+    bool caught = false;
+    try
+    {
+        seq.frame (FIRST + NFRAME);
+    }
+    catch (const ArgExc&)
+    {
+        caught = true;
+    }
+    assert (caught);
+}
+
+void
+testBudgetAndErrors (const string& pattern)
+{
+    SequenceReader::Options opts;
+    opts.memoryBudget = 2 * size_t (W) * H * 3 * sizeof (float) + 100;
+
+    SequenceReader seq (pattern, FIRST, FIRST + NFRAME, makeLayout (), opts);
+    assert (seq.windowSize () == 2);
+
+    for (int f = FIRST; f < FIRST + NFRAME; f += 3)
+        checkFrame (*seq.frame (f), f);
+
+    //
+    // the last frame in the range does not exist
+    //
+
+    bool caught = false;
+    try
+    {
+        seq.frame (FIRST + NFRAME);
+    }
+    catch (const InputExc&)
+    {
+        caught = true;
+    }
+    assert (caught);
+
+    // and the reader is still usable afterwards
+    checkFrame (*seq.frame (FIRST + 1), FIRST + 1);
+
+    //
+    // a frame with a different layout is reported
+    //
+
+    {
+        string name = SequenceReader::frameFileName (pattern, FIRST + NFRAME);
+        Header hdr (W, H);
+        hdr.channels ().insert ("R", Channel (FLOAT));
+        vector<float> r (W * H, 0.f);
+        FrameBuffer   fb;
+        fb.insert ("R", Slice (FLOAT, (char*) r.data (), 4, 4 * W));
+        OutputFile out (name.c_str (), hdr);
+        out.setFrameBuffer (fb);
+        out.writePixels (H);
+    }
+
+    caught = false;
+    try
+    {
+        seq.frame (FIRST + NFRAME);
+    }
+    catch (const InputExc&)
+    {
+        caught = true;
+    }
+    assert (caught);
+
+    remove (SequenceReader::frameFileName (pattern, FIRST + NFRAME).c_str ());
+}
+
+} // namespace
+
+void
+testSequenceReader (const string& tempDir)
+{
+    try
+    {
+        cout << "Testing SequenceReader" << endl;
+
+        testFileNames ();
+
+        string pattern = tempDir + "imf_test_sequence.####.exr";
+        writeSequence (pattern);
+
+        int maxThreads = ILMTHREAD_NAMESPACE::supportsThreads () ? 4 : 0;
+
+        for (int n = 0; n <= maxThreads; n += 2)
+        {
+            setGlobalThreadCount (n);
+            cout << "number of threads: " << globalThreadCount () << endl;
+
+            testPlayback (pattern);
+            testBudgetAndErrors (pattern);
+        }
+
+        for (int f = FIRST; f < FIRST + NFRAME; ++f)
+            remove (SequenceReader::frameFileName (pattern, f).c_str ());
+
+        cout << "ok\n" << endl;
+    }
+    catch (const std::exception& e)
+    {
+        cerr << "ERROR -- caught exception: " << e.what () << endl;
+        assert (false);
+    }
+}
@@ -3,7 +3,7 @@
 # SPDX-License-Identifier: BSD-3-Clause
 # Copyright (c) Contributors to the OpenEXR Project.
 
-import sys, os, tempfile, atexit
+import sys, os, tempfile, atexit, shutil
 from subprocess import PIPE, run
 
 print(f"testing exr2aces: {sys.argv}")
@@ -42,6 +42,11 @@ result = run ([exr2aces, "foo.exr", "bar.exr"], stdout=PIPE, stderr=PIPE, univer
 print(" ".join(result.args))
 assert(result.returncode != 0), "\n"+result.stderr
 
+# missing thread count
+result = run ([exr2aces, "-j"], stdout=PIPE, stderr=PIPE, universal_newlines=True)
+print(" ".join(result.args))
+assert(result.returncode != 0), "\n"+result.stderr
+
 def find_line(keyword, lines):
     for line in lines:
         if line.startswith(keyword):
@@ -51,8 +56,12 @@ def find_line(keyword, lines):
 fd, outimage = tempfile.mkstemp(".exr")
 os.close(fd)
 
+outdir = tempfile.mkdtemp()
+
 def cleanup():
     print(f"deleting {outimage}")
+    os.unlink(outimage)
+    shutil.rmtree(outdir)
 atexit.register(cleanup)
 
 image = f"{image_dir}/TestImages/GrayRampsHorizontal.exr"
@@ -67,13 +76,32 @@ assert(result.returncode == 0), "\n"+result.stderr
 # confirm the output has the proper chromaticities
 assert("chromaticities: chromaticities r[0.7347, 0.2653] g[0, 1] b[0.0001, -0.077] w[0.32168, 0.33767]" in result.stdout), "\n"+result.stdout
 
-print("success")
-
-
-
-
-
-
-
+# batch mode: convert the image in parallel with a file that cannot
+# be read; the good one is converted, and the failure is reported
+result = run ([exr2aces, "-j", "2", "-d", outdir, image, "missing.exr"], stdout=PIPE, stderr=PIPE, universal_newlines=True)
+print(" ".join(result.args))
+assert(result.returncode != 0), "\n"+result.stderr
+assert("missing.exr" in result.stderr), "\n"+result.stderr
+
+batchimage = os.path.join(outdir, os.path.basename(image))
+with open(outimage, "rb") as f, open(batchimage, "rb") as g:
+    assert(f.read() == g.read()), "batch output differs"
+
+# an output that names the input under another name is rejected,
+# and the input is left intact
+aliasimage = os.path.join(outdir, "alias.exr")
+shutil.copyfile(image, aliasimage)
+size = os.path.getsize(aliasimage)
+result = run ([exr2aces, aliasimage, os.path.join(outdir, ".", "alias.exr")], stdout=PIPE, stderr=PIPE, universal_newlines=True)
+print(" ".join(result.args))
+assert(result.returncode != 0), "\n"+result.stderr
+assert(os.path.getsize(aliasimage) == size), "input was modified"
 
+# batch mode rejects inputs that would be saved under the same name
+result = run ([exr2aces, "-d", outdir, image, aliasimage, os.path.join(outdir, "..", os.path.basename(outdir), "alias.exr")], stdout=PIPE, stderr=PIPE, universal_newlines=True)
+print(" ".join(result.args))
+assert(result.returncode != 0), "\n"+result.stderr
+assert("would both be saved" in result.stderr), "\n"+result.stderr
+assert(os.path.getsize(aliasimage) == size), "input was modified"
 
+print("success")
@@ -3,7 +3,7 @@
 # SPDX-License-Identifier: BSD-3-Clause
 # Copyright (c) Contributors to the OpenEXR Project.
 
-import sys, os
+import sys, os, tempfile, atexit, shutil, struct, zlib
 from subprocess import PIPE, run
 
 print(f"testing exrcheck: {' '.join(sys.argv)}")
@@ -35,6 +35,126 @@ for exr_file in sys.argv[3:]:
     print(" ".join(result.args))
     assert(result.returncode == 0), "\n"+result.stderr
 
+    result = run ([exrcheck, "-p", exr_path], stdout=PIPE, stderr=PIPE, universal_newlines=True)
+    print(" ".join(result.args))
+    assert(result.returncode == 0), "\n"+result.stderr
+
+    result = run ([exrcheck, "-q", exr_path], stdout=PIPE, stderr=PIPE, universal_newlines=True)
+    print(" ".join(result.args))
+    assert(result.returncode == 0), "\n"+result.stderr
+
+# check all files concurrently; the results are reported in order
+
+exr_paths = [f"{image_dir}/{exr_file}" for exr_file in sys.argv[3:]]
+
+result = run ([exrcheck, "-p", "-j", "4"] + exr_paths, stdout=PIPE, stderr=PIPE, universal_newlines=True)
+print(" ".join(result.args))
+assert(result.returncode == 0), "\n"+result.stderr
+assert(result.stdout.splitlines() == [f" file {p} OK" for p in exr_paths]), "\n"+result.stdout
+
+# corrupted files: the failing chunk and its offset are reported, and
+# the result does not depend on the number of threads
+
+def attribute(name, type, value):
+    return name.encode() + b"\0" + type.encode() + b"\0" + struct.pack("<i", len(value)) + value
+
+def zip_compress(raw):
+    # ZIP(S) preprocessing: split the even and odd bytes, then delta encode
+    tmp = raw[0::2] + raw[1::2]
+    out = bytearray(tmp)
+    for i in range(len(tmp) - 1, 0, -1):
+        out[i] = (tmp[i] - tmp[i - 1] + 128 + 256) & 255
+    return zlib.compress(bytes(out))
+
+def make_exr(width, height):
+    # a single part scan line file with one HALF channel and ZIPS
+    # compression, i.e. one scan line per chunk; returns the file,
+    # the position of the chunk offset table and the chunk offsets
+    box = struct.pack("<iiii", 0, 0, width - 1, height - 1)
+    header = struct.pack("<ii", 20000630, 2)
+    header += attribute("channels", "chlist", b"Y\0" + struct.pack("<iB3xii", 1, 0, 1, 1) + b"\0")
+    header += attribute("compression", "compression", bytes([2]))
+    header += attribute("dataWindow", "box2i", box)
+    header += attribute("displayWindow", "box2i", box)
+    header += attribute("lineOrder", "lineOrder", bytes([0]))
+    header += attribute("pixelAspectRatio", "float", struct.pack("<f", 1))
+    header += attribute("screenWindowCenter", "v2f", struct.pack("<ff", 0, 0))
+    header += attribute("screenWindowWidth", "float", struct.pack("<f", 1))
+    header += b"\0"
+
+    chunks = []
+    for y in range(height):
+        raw = b"".join(struct.pack("<H", 0x3c00 + (x + y) % 512) for x in range(width))
+        data = zip_compress(raw)
+        chunks.append(struct.pack("<ii", y, len(data)) + data)
+
+    offsets = []
+    pos = len(header) + 8 * height
+    for c in chunks:
+        offsets.append(pos)
+        pos += len(c)
+
+    table = b"".join(struct.pack("<Q", o) for o in offsets)
+    return bytearray(header + table + b"".join(chunks)), len(header), offsets
+
+tmpdir = tempfile.mkdtemp()
+atexit.register(shutil.rmtree, tmpdir)
+
+good, table, offsets = make_exr(64, 16)
+
+def write_exr(name, data):
+    path = os.path.join(tmpdir, name)
+    with open(path, "wb") as f:
+        f.write(data)
+    return path
+
+def check(options, path, expect_ok):
+    result = run ([exrcheck] + options + [path], stdout=PIPE, stderr=PIPE, universal_newlines=True)
+    print(" ".join(result.args))
+    if expect_ok:
+        assert(result.returncode == 0), "\n"+result.stdout+result.stderr
+        assert(result.stdout.splitlines() == [f" file {path} OK"]), "\n"+result.stdout
+    else:
+        assert(result.returncode != 0), "\n"+result.stdout
+    return result.stdout
+
+def check_bad(options, path, chunk, offset):
+    outputs = [check(options + ["-j", j], path, False) for j in ["1", "4"]]
+    assert(outputs[0] == outputs[1]), "\n"+outputs[0]+outputs[1]
+    lines = outputs[0].splitlines()
+    assert(lines[0] == f" file {path} bad"), "\n"+outputs[0]
+    assert(lines[1].startswith(f"    part 0, chunk {chunk} at offset {offset}: ")), "\n"+outputs[0]
+
+good_path = write_exr("good.exr", good)
+check(["-p"], good_path, True)
+check(["-q"], good_path, True)
+
+# garbage in the compressed data of chunk 5: found when decoding, but
+# not by the structure check
+
+bad_data = bytearray(good)
+bad_data[offsets[5] + 8 : offsets[5] + 14] = b"\xff" * 6
+bad_data_path = write_exr("bad_data.exr", bad_data)
+check_bad(["-p"], bad_data_path, 5, offsets[5])
+check(["-q"], bad_data_path, True)
+
+# the leader of chunk 3 names the wrong scan line
+
+bad_leader = bytearray(good)
+bad_leader[offsets[3] : offsets[3] + 4] = struct.pack("<i", 1000)
+bad_leader_path = write_exr("bad_leader.exr", bad_leader)
+check_bad(["-p"], bad_leader_path, 3, offsets[3])
+check_bad(["-q"], bad_leader_path, 3, offsets[3])
+
+# the offset table entry of chunk 7 points past the end of the file
+
+bad_offset = len(good) + 1000
+bad_table = bytearray(good)
+bad_table[table + 8 * 7 : table + 8 * 8] = struct.pack("<Q", bad_offset)
+bad_table_path = write_exr("bad_table.exr", bad_table)
+check_bad(["-p"], bad_table_path, 7, bad_offset)
+check_bad(["-q"], bad_table_path, 7, bad_offset)
+
 
 print("success.")
 
@@ -180,6 +180,23 @@ file_size = os.path.getsize(outimage)
 assert(file_size != default_file_size), "\n{} is the wrong size".format(outimage)
 os.unlink(outimage)
 
+# -j (threads)
+result = run ([exrenvmap, "-j", latlong_image, outimage], stdout=PIPE, stderr=PIPE, universal_newlines=True)
+print(" ".join(result.args))
+assert(result.returncode != 0), "\n"+result.stderr
+assert(not os.path.isfile(outimage)), "\n{} still exists".format(outimage)
+
+# the result does not depend on the number of threads
+outputs = []
+for threads in ["0", "4"]:
+    result = run ([exrenvmap, "-j", threads, "-b", latlong_image, outimage], stdout=PIPE, stderr=PIPE, universal_newlines=True)
+    print(" ".join(result.args))
+    assert(result.returncode == 0), "\n"+result.stderr
+    with open(outimage, "rb") as f:
+        outputs.append(f.read())
+    os.unlink(outimage)
+assert(outputs[0] == outputs[1]), "\noutput depends on the thread count"
+
 # -t 
 result = run ([exrenvmap, "-t", latlong_image, outimage], stdout=PIPE, stderr=PIPE, universal_newlines=True)
 print(" ".join(result.args))
@@ -3,7 +3,7 @@
 # SPDX-License-Identifier: BSD-3-Clause
 # Copyright (c) Contributors to the OpenEXR Project.
 
-import sys, os
+import sys, os, json
 from subprocess import PIPE, run
 
 print(f"testing exrinfo: {' '.join(sys.argv)}")
@@ -60,5 +60,33 @@ except AssertionError:
     print(result.stdout)
     raise
 
+# --json: one object per file and line, in the order of the files,
+# also when the files are read in parallel
+result = run ([exrinfo, "--json", "-c", "-j", "3", image, image, "nonexistent.exr", image],
+              stdout=PIPE, stderr=PIPE, universal_newlines=True)
+print(" ".join(result.args))
+assert(result.returncode == 1), "\n"+result.stderr
+lines = result.stdout.splitlines()
+try:
+    assert (len(lines) == 4)
+    objs = [json.loads(l) for l in lines]
+    assert ('error' in objs[2])
+    for o in [objs[0], objs[1], objs[3]]:
+        part = o['parts'][0]
+        assert (part['attributes']['compression'] == 'pxr24')
+        assert (part['attributes']['dataWindow']['max'] == [799, 799])
+        assert (part['chunksPresent'] == part['chunkCount'])
+except AssertionError:
+    print(result.stdout)
+    raise
+
+# --files-from: a name longer than a list line can hold is an error
+names = f"{image}\n{'x' * 5000}\n{image}\n"
+result = run ([exrinfo, "--files-from", "-"], input=names,
+              stdout=PIPE, stderr=PIPE, universal_newlines=True)
+print(" ".join(result.args))
+assert(result.returncode == 1), "\n"+result.stdout
+assert("longer than 4095 bytes" in result.stderr), "\n"+result.stderr
+
 print("success")
 
@@ -3,7 +3,7 @@
 # SPDX-License-Identifier: BSD-3-Clause
 # Copyright (c) Contributors to the OpenEXR Project.
 
-import sys, os, tempfile, atexit
+import sys, os, tempfile, atexit, shutil
 from subprocess import PIPE, run
 
 print(f"testing exrmakepreview: {' '.join(sys.argv)}")
@@ -66,6 +66,57 @@ assert(result.returncode == 0), "\n"+result.stderr
 output = result.stdout.split('\n')
 assert("preview 50 x 50" in find_line("  preview", output)), "\n"+result.stdout
 
+# -d = batch mode
+outdir = tempfile.mkdtemp()
+batch_image = f"{outdir}/{os.path.basename(image)}"
+
+def cleanup_batch():
+    if os.path.isfile(batch_image):
+        os.unlink(batch_image)
+    os.rmdir(outdir)
+atexit.register(cleanup_batch)
+
+result = run ([exrmakepreview, "-w", "50", "-j", "2", "-d", outdir, image, "nonexistent.exr"], stdout=PIPE, stderr=PIPE, universal_newlines=True)
+print(" ".join(result.args))
+assert(result.returncode != 0), "\n"+result.stderr
+assert("nonexistent.exr" in result.stderr), "\n"+result.stderr
+
+result = run ([exrinfo, "-v", batch_image], stdout=PIPE, stderr=PIPE, universal_newlines=True)
+print(" ".join(result.args))
+assert(result.returncode == 0), "\n"+result.stderr
+output = result.stdout.split('\n')
+assert("preview 50 x 50" in find_line("  preview", output)), "\n"+result.stdout
+
+# an output that names the input under another name is rejected,
+# and the input is left intact; in batch mode, that happens when
+# -d names the input's own directory
+aliasdir = tempfile.mkdtemp()
+atexit.register(shutil.rmtree, aliasdir)
+aliasimage = os.path.join(aliasdir, "alias.exr")
+shutil.copyfile(image, aliasimage)
+size = os.path.getsize(aliasimage)
+
+result = run ([exrmakepreview, aliasimage, os.path.join(aliasdir, ".", "alias.exr")], stdout=PIPE, stderr=PIPE, universal_newlines=True)
+print(" ".join(result.args))
+assert(result.returncode != 0), "\n"+result.stderr
+assert(os.path.getsize(aliasimage) == size), "input was modified"
+
+result = run ([os.path.abspath(exrmakepreview), "-d", ".", "alias.exr"], cwd=aliasdir, stdout=PIPE, stderr=PIPE, universal_newlines=True)
+print(" ".join(result.args))
+assert(result.returncode != 0), "\n"+result.stderr
+assert(os.path.getsize(aliasimage) == size), "input was modified"
+
+# batch mode rejects inputs that would be saved under the same name
+os.mkdir(os.path.join(aliasdir, "x"))
+os.mkdir(os.path.join(aliasdir, "y"))
+shutil.copyfile(image, os.path.join(aliasdir, "x", "a.exr"))
+shutil.copyfile(image, os.path.join(aliasdir, "y", "a.exr"))
+result = run ([exrmakepreview, "-d", outdir, os.path.join(aliasdir, "x", "a.exr"), os.path.join(aliasdir, "y", "a.exr")], stdout=PIPE, stderr=PIPE, universal_newlines=True)
+print(" ".join(result.args))
+assert(result.returncode != 0), "\n"+result.stderr
+assert("would both be saved" in result.stderr), "\n"+result.stderr
+assert(not os.path.exists(os.path.join(outdir, "a.exr"))), "output was written"
+
 print("success")
 
 
@@ -3,7 +3,7 @@
 # SPDX-License-Identifier: BSD-3-Clause
 # Copyright (c) Contributors to the OpenEXR Project.
 
-import sys, os, tempfile, atexit
+import sys, os, tempfile, atexit, struct
 from subprocess import PIPE, run
 
 print(f"testing exrmaketiled: {' '.join(sys.argv)}")
@@ -22,11 +22,41 @@ assert(os.path.isfile(image)), "\nMissing " + image
 
 fd, outimage = tempfile.mkstemp(".exr")
 os.close(fd)
+fd, outimage2 = tempfile.mkstemp(".exr")
+os.close(fd)
 
 def cleanup():
     print(f"deleting {outimage}")
+    print(f"deleting {outimage2}")
+    os.unlink(outimage2)
 atexit.register(cleanup)
 
+def read_tiles(name):
+    # the compressed tiles of a single-part tiled file, by tile
+    # and level coordinates, in whatever order they were written
+    with open(name, "rb") as f:
+        data = f.read()
+    pos = 8
+    while data[pos] != 0:
+        type_start = data.index(b"\0", pos) + 1
+        size_start = data.index(b"\0", type_start) + 1
+        size, = struct.unpack_from("<i", data, size_start)
+        pos = size_start + 4 + size
+    pos += 1
+    table_end = len(data)
+    offsets = []
+    while pos < table_end:
+        offset, = struct.unpack_from("<Q", data, pos)
+        offsets.append(offset)
+        table_end = min(table_end, offset)
+        pos += 8
+    tiles = {}
+    for offset in offsets:
+        coords = struct.unpack_from("<4i", data, offset)
+        size, = struct.unpack_from("<i", data, offset + 16)
+        tiles[coords] = data[offset + 20 : offset + 20 + size]
+    return tiles
+
 # no args = usage message
 result = run ([exrmaketiled], stdout=PIPE, stderr=PIPE, universal_newlines=True)
 print(" ".join(result.args))
@@ -61,4 +91,30 @@ print(" ".join(result.args))
 assert(result.returncode == 0), "\n"+result.stderr
 assert('tiled image has levels: x 1 y 1' in result.stdout), "\n"+result.stdout
 
+# -s = streaming mode
+result = run ([exrmaketiled, "-s", "-r", "-e", "black", "mirror", image, outimage], stdout=PIPE, stderr=PIPE, universal_newlines=True)
+print(" ".join(result.args))
+assert(result.returncode == 0), "\n"+result.stderr
+
+result = run ([exrinfo, "-v", outimage], stdout=PIPE, stderr=PIPE, universal_newlines=True)
+print(" ".join(result.args))
+assert(result.returncode == 0), "\n"+result.stderr
+assert('ripmap' in result.stdout.lower()), "\n"+result.stdout
+
+# streaming changes the order of the tiles in the file, not the tiles
+for levels in [["-m", "-e", "mirror", "black"], ["-r", "-u"]]:
+    for stream, name in [([], outimage), (["-s"], outimage2)]:
+        command = [exrmaketiled] + stream + levels + ["-t", "48", "24", image, name]
+        result = run (command, stdout=PIPE, stderr=PIPE, universal_newlines=True)
+        print(" ".join(result.args))
+        assert(result.returncode == 0), "\n"+result.stderr
+    tiles = read_tiles (outimage)
+    assert(len(tiles) > 1)
+    assert(tiles == read_tiles (outimage2)), "\nstreamed tiles differ"
+
+# periodic vertical extrapolation cannot be streamed
+result = run ([exrmaketiled, "-s", "-m", "-e", "clamp", "periodic", image, outimage], stdout=PIPE, stderr=PIPE, universal_newlines=True)
+print(" ".join(result.args))
+assert(result.returncode != 0), "\n"+result.stderr
+
 print("success")
@@ -48,7 +48,7 @@ assert(version in result.stdout), "\n"+result.stdout
 
 # test missing arguments, using just the -option but no value
 
-for a in ["-p","-l","-16","-z"]:
+for a in ["-p","-l","-16","-z","-j","--passes"]:
     result = run ([exrmetrics, a], stdout=PIPE, stderr=PIPE, universal_newlines=True)
     print(" ".join(result.args))
     print(result.stderr)
@@ -71,4 +71,27 @@ data = json.loads(result.stdout)
 for x in ['write time','output file size','input file size']:
   assert(x in data),"\n Missing field "+x
 
+# several compression methods and thread counts = array of results
+command = [exrmetrics, "-z", "zip,rle", "-j", "0,2", "--passes", "2", image, outimage]
+result = run (command, stdout=PIPE, stderr=PIPE, universal_newlines=True)
+print(" ".join(result.args))
+assert(result.returncode == 0), "\n"+result.stderr
+
+data = json.loads(result.stdout)
+assert(len(data) == 4), "\n"+result.stdout
+for d in data:
+  for x in ['decompress time','compress time p95','scaling efficiency','threads']:
+    assert(x in d),"\n Missing field "+x
+  assert(d['passes'] == 2), "\n"+result.stdout
+
+# --csv = header row and one row per result
+command = [exrmetrics, "--csv", "-z", "zip", "-l", "1,9", image, outimage]
+result = run (command, stdout=PIPE, stderr=PIPE, universal_newlines=True)
+print(" ".join(result.args))
+assert(result.returncode == 0), "\n"+result.stderr
+
+rows = result.stdout.splitlines()
+assert(len(rows) == 3), "\n"+result.stdout
+assert('total time' in rows[0].split(',')), "\n"+result.stdout
+
 print("success")
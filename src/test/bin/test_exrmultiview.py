@@ -39,14 +39,30 @@ assert(version in result.stdout), "\n"+result.stdout
 left_image = f"{image_dir}/TestImages/GammaChart.exr"
 right_image = f"{image_dir}/TestImages/GrayRampsHorizontal.exr"
 
-fd, outimage = tempfile.mkstemp(".exr")
-os.close(fd)
+def make_temp():
+    fd, name = tempfile.mkstemp(".exr")
+    os.close(fd)
+    return name
+
+outimage = make_temp()
+outimage2 = make_temp()
+rleimage = make_temp()
 
 def cleanup():
-    print(f"deleting {outimage}")
-    os.unlink(outimage)
+    for name in [outimage, outimage2, rleimage]:
+        print(f"deleting {name}")
+        os.unlink(name)
 atexit.register(cleanup)
 
+def run_ok(command):
+    result = run (command, stdout=PIPE, stderr=PIPE, universal_newlines=True)
+    print(" ".join(result.args))
+    assert(result.returncode == 0), "\n"+result.stderr
+
+def same_contents(name1, name2):
+    with open(name1, "rb") as f1, open(name2, "rb") as f2:
+        return f1.read() == f2.read()
+
 command = [exrmultiview, "left", left_image, "right", right_image, outimage]
 result = run (command, stdout=PIPE, stderr=PIPE, universal_newlines=True)
 print(" ".join(result.args))
@@ -64,5 +80,51 @@ except AssertionError:
     print(result.stdout)
     raise
 
-print("success")
+# -m: one part per view, copied without recompression
+command = [exrmultiview, "-m", "-j", "2", "left", left_image, "right", right_image, outimage]
+result = run (command, stdout=PIPE, stderr=PIPE, universal_newlines=True)
+print(" ".join(result.args))
+assert(result.returncode == 0), "\n"+result.stderr
+
+result = run ([exrinfo, "-v", outimage], stdout=PIPE, stderr=PIPE, universal_newlines=True)
+print(" ".join(result.args))
+assert(result.returncode == 0), "\n"+result.stderr
+try:
+    assert(' part 1: left' in result.stdout)
+    assert(' part 2: right' in result.stdout)
+    assert('view: string \'left\'' in result.stdout)
+    assert('view: string \'right\'' in result.stdout)
+except AssertionError:
+    print(result.stdout)
+    raise
 
+# -m -z: a view whose compression matches is copied as it is, the
+# others are recompressed; either way the output is the same
+run_ok ([exrmultiview, "-m", "-z", "rle",
+         "a", right_image, "b", right_image, rleimage])
+run_ok ([exrmultiview, "-m", "-z", "rle",
+         "left", left_image, "right", rleimage, outimage])
+run_ok ([exrmultiview, "-m", "-z", "rle",
+         "left", left_image, "right", right_image, outimage2])
+assert(same_contents (outimage, outimage2))
+
+# reading the views concurrently, band by band, gives the same output
+# as reading them one at a time
+run_ok ([exrmultiview, "-j", "0",
+         "left", left_image, "right", right_image, outimage])
+run_ok ([exrmultiview, "-j", "2",
+         "left", left_image, "right", right_image, outimage2])
+assert(same_contents (outimage, outimage2))
+
+# the output file must not be one of the input files
+for flags in [[], ["-m"]]:
+    size = os.path.getsize (outimage)
+    command = [exrmultiview] + flags + ["left", left_image,
+                                        "right", outimage, outimage]
+    result = run (command, stdout=PIPE, stderr=PIPE, universal_newlines=True)
+    print(" ".join(result.args))
+    assert(result.returncode != 0), "\n"+result.stderr
+    assert("cannot also be the output file" in result.stderr), "\n"+result.stderr
+    assert(os.path.getsize (outimage) == size)
+
+print("success")
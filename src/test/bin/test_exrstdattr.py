@@ -164,5 +164,43 @@ result = run ([exrinfo, "-v", outimage2], stdout=PIPE, stderr=PIPE, universal_ne
 print(" ".join(result.args))
 assert("comments" not in result.stdout)
 
+# test editing in place, first with a new value of the same size,
+# which overwrites the header, then with a longer value, which
+# rewrites the file
+
+size = os.path.getsize(outimage2)
+for owner, same_size in [("gunther", True), ("florian the third", False)]:
+    result = run ([exrstdattr, "-owner", owner, outimage2], stdout=PIPE, stderr=PIPE, universal_newlines=True)
+    print(" ".join(result.args))
+    assert(result.returncode == 0), "\n"+result.stderr
+    assert((os.path.getsize(outimage2) == size) == same_size)
+
+    result = run ([exrinfo, "-v", outimage2], stdout=PIPE, stderr=PIPE, universal_newlines=True)
+    print(" ".join(result.args))
+    assert(result.returncode == 0), "\n"+result.stderr
+    assert(f"owner: string '{owner}'" in result.stdout), "\n"+result.stdout
+
+# an output file that names the input under another name is edited
+# in place as well, and an existing <file>.tmp is left alone
+
+tmpimage = outimage2 + ".tmp"
+with open(tmpimage, "w") as f:
+    f.write("keep")
+atexit.register(os.remove, tmpimage)
+
+aliasimage = os.path.join(os.path.dirname(outimage2), ".", os.path.basename(outimage2))
+owner = "florian the fourth, of a longer name"
+result = run ([exrstdattr, "-owner", owner, aliasimage, outimage2], stdout=PIPE, stderr=PIPE, universal_newlines=True)
+print(" ".join(result.args))
+assert(result.returncode == 0), "\n"+result.stderr
+
+result = run ([exrinfo, "-v", outimage2], stdout=PIPE, stderr=PIPE, universal_newlines=True)
+print(" ".join(result.args))
+assert(result.returncode == 0), "\n"+result.stderr
+assert(f"owner: string '{owner}'" in result.stdout), "\n"+result.stdout
+
+with open(tmpimage) as f:
+    assert(f.read() == "keep"), "existing temporary file was modified"
+assert(not os.path.exists(tmpimage + "1")), "temporary file left behind"
 
 print("success")